@@ -28,6 +28,8 @@
 //----------------------------------------------------------------------------
 
 #include "tsAsyncReport.h"
+#include "tsGuard.h"
+#include "tsTime.h"
 TSDUCK_SOURCE;
 
 
@@ -35,16 +37,45 @@ TSDUCK_SOURCE;
 // Default constructor
 //----------------------------------------------------------------------------
 
+namespace {
+    // Size of the ring buffer: next power of 2, at least 2.
+    size_t RingSize(size_t count)
+    {
+        size_t size = 2;
+        while (size < count) {
+            size <<= 1;
+        }
+        return size;
+    }
+}
+
 ts::AsyncReport::AsyncReport(int max_severity, const AsyncReportArgs& args) :
     Report(max_severity),
     Thread(ThreadAttributes().setPriority(ThreadAttributes::GetMinimumPriority())),
-    _log_queue(args.log_msg_count),
+    _ring(RingSize(args.log_msg_count)),
+    _ring_mask(_ring.size() - 1),
+    _enqueue_pos(0),
+    _dequeue_pos(0),
+    _dropped(0),
+    _reported_dropped(0),
+    _log_waiting(false),
+    _app_waiting(0),
+    _terminate(false),
+    _mutex(),
+    _msg_available(),
+    _record_available(),
     _default_handler(*this),
     _handler(&_default_handler),
     _time_stamp(args.timed_log),
     _synchronous(args.sync_log),
+    _drop_oldest(args.drop_oldest_log),
     _terminated(false)
 {
+    // Initially, all records are free.
+    for (size_t i = 0; i < _ring.size(); ++i) {
+        _ring[i].sequence = i;
+    }
+
     // Start the logging thread
     start();
 }
@@ -67,9 +98,12 @@ ts::AsyncReport::~AsyncReport()
 void ts::AsyncReport::terminate()
 {
     if (!_terminated) {
-        // Insert an "end of report" message in the queue.
-        // This message will tell the logging thread to terminate.
-        _log_queue.forceEnqueue(new LogMessage(true, 0, UString()));
+        // Tell the logging thread to terminate after logging all pending messages.
+        {
+            Guard lock(_mutex);
+            _terminate = true;
+            _msg_available.signal();
+        }
 
         // Wait for termination of the logging thread
         waitForTermination();
@@ -93,10 +127,101 @@ void ts::AsyncReport::writeLog(int severity, const UString &msg)
     ::OutputDebugStringA(msgNewLine.toUTF8().c_str());
 #endif
 
-    if (!_terminated) {
-        // Enqueue the message immediately (timeout = 0), drop message on overflow.
-        // On the contrary, in synchronous mode, wait infinitely until the message is queued.
-        _log_queue.enqueue(new LogMessage(false, severity, msg), _synchronous ? Infinite : 0);
+    if (!_terminated && !_terminate) {
+        enqueue(severity, msg);
+    }
+}
+
+
+//----------------------------------------------------------------------------
+// Enqueue a message in the ring buffer, called by application threads.
+//----------------------------------------------------------------------------
+
+bool ts::AsyncReport::enqueue(int severity, const UString& msg)
+{
+    size_t pos = _enqueue_pos.load(std::memory_order_relaxed);
+
+    for (;;) {
+        LogRecord& rec(_ring[pos & _ring_mask]);
+        const size_t seq = rec.sequence.load(std::memory_order_acquire);
+
+        if (seq == pos) {
+            // The record is free, try to reserve it. On failure, pos is updated with
+            // the current position (another thread has reserved it) and we retry.
+            if (_enqueue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                // Reuse the preallocated string, no memory allocation when large enough.
+                rec.severity = severity;
+                rec.message.assign(msg);
+                // Publish the message to the logging thread.
+                rec.sequence.store(pos + 1);
+                // Wake up the logging thread if it waits for messages.
+                if (_log_waiting.load()) {
+                    Guard lock(_mutex);
+                    _msg_available.signal();
+                }
+                return true;
+            }
+        }
+        else if (seq + _ring_mask + 1 == pos + 1) {
+            // The record still contains the message from the previous round, the ring is full.
+            if (_synchronous) {
+                // Wait for the logging thread to free a record. Recheck after declaring
+                // ourselves as waiting since the logging thread may have freed it meanwhile.
+                Guard lock(_mutex);
+                _app_waiting++;
+                if (rec.sequence.load() == seq) {
+                    _record_available.wait(_mutex, Infinite);
+                }
+                _app_waiting--;
+            }
+            else if (_drop_oldest) {
+                // Make room for the new message and retry.
+                dropOldest(pos);
+            }
+            else {
+                // Drop the new message.
+                _dropped++;
+                return false;
+            }
+            pos = _enqueue_pos.load(std::memory_order_relaxed);
+        }
+        else {
+            // Another thread has reserved this record meanwhile, retry at current position.
+            pos = _enqueue_pos.load(std::memory_order_relaxed);
+        }
+    }
+}
+
+
+//----------------------------------------------------------------------------
+// Drop the oldest message in the ring buffer, called by application threads.
+//----------------------------------------------------------------------------
+
+void ts::AsyncReport::dropOldest(size_t enqueue_pos)
+{
+    // The oldest message is in the record we want to write.
+    size_t pos = enqueue_pos - _ring.size();
+    LogRecord& rec(_ring[pos & _ring_mask]);
+
+    // Claim the oldest message the same way as the logging thread does.
+    // If the logging thread or another application thread claimed it first, there is no need to drop it.
+    if (rec.sequence.load(std::memory_order_acquire) == pos + 1 && _dequeue_pos.compare_exchange_strong(pos, pos + 1, std::memory_order_relaxed)) {
+        rec.sequence.store(pos + _ring_mask + 1);
+        _dropped++;
+    }
+}
+
+
+//----------------------------------------------------------------------------
+// Report the number of dropped messages, in the logging thread.
+//----------------------------------------------------------------------------
+
+void ts::AsyncReport::reportDropped()
+{
+    const size_t dropped = _dropped.load();
+    if (dropped != _reported_dropped) {
+        _handler->handleMessage(Severity::Warning, UString::Format(u"%'d log messages dropped, queue is full", {dropped - _reported_dropped}));
+        _reported_dropped = dropped;
     }
 }
 
@@ -107,19 +232,54 @@ void ts::AsyncReport::writeLog(int severity, const UString &msg)
 
 void ts::AsyncReport::main()
 {
-    LogMessagePtr msg;
+    UString message;
+
+    for (;;) {
+        size_t pos = _dequeue_pos.load(std::memory_order_relaxed);
+        LogRecord& rec(_ring[pos & _ring_mask]);
+
+        if (rec.sequence.load(std::memory_order_acquire) == pos + 1) {
+            // A message is available. Claim it. This can fail only when an application
+            // thread dropped it meanwhile (drop oldest mode).
+            if (_dequeue_pos.compare_exchange_strong(pos, pos + 1, std::memory_order_relaxed)) {
+                // Exchange the strings to keep the preallocated buffers, then free the record.
+                const int severity = rec.severity;
+                message.swap(rec.message);
+                rec.sequence.store(pos + _ring_mask + 1);
 
-    while (_log_queue.dequeue(msg) && !msg->terminate) {
+                // Wake up an application thread if one is waiting for a free record.
+                if (_app_waiting.load() > 0) {
+                    Guard lock(_mutex);
+                    _record_available.signal();
+                }
 
-        // Invoke the report handler
-        _handler->handleMessage(msg->severity, msg->message);
+                // Invoke the report handler
+                reportDropped();
+                _handler->handleMessage(severity, message);
 
-        // Abort application on fatal error
-        if (msg->severity == Severity::Fatal) {
-            ::exit(EXIT_FAILURE);
+                // Abort application on fatal error
+                if (severity == Severity::Fatal) {
+                    ::exit(EXIT_FAILURE);
+                }
+            }
+        }
+        else if (_terminate) {
+            // No more message and termination requested.
+            break;
+        }
+        else {
+            // No message, wait for one. Recheck after declaring ourselves as waiting
+            // since an application thread may have published one meanwhile.
+            Guard lock(_mutex);
+            _log_waiting = true;
+            if (rec.sequence.load() != pos + 1 && !_terminate) {
+                _msg_available.wait(_mutex, Infinite);
+            }
+            _log_waiting = false;
         }
     }
 
+    reportDropped();
     if (_max_severity >= Severity::Debug) {
         _handler->handleMessage(Severity::Debug, u"Report logging thread terminated");
     }
@@ -36,9 +36,9 @@
 #include "tsReport.h"
 #include "tsReportHandler.h"
 #include "tsAsyncReportArgs.h"
-#include "tsMessageQueue.h"
-#include "tsNullMutex.h"
 #include "tsThread.h"
+#include "tsMutex.h"
+#include "tsCondition.h"
 
 namespace ts {
     //!
@@ -50,11 +50,16 @@ namespace ts {
     //! to the caller without waiting. The messages are logged later in one single
     //! low-priority thread.
     //!
-    //! In case of a huge amount of errors, there is no avalanche effect. If a caller
-    //! cannot immediately enqueue a message or if the internal queue of messages is
-    //! full, the message is dropped. In other words, reporting messages is guaranteed
-    //! to never block, slow down or crash the application. Messages are dropped when
-    //! necessary to avoid that kind of problem.
+    //! In case of a huge amount of errors, there is no avalanche effect. If the internal
+    //! queue of messages is full, a message is dropped, either the new one or the oldest
+    //! one in the queue, depending on the configuration. In other words, reporting messages
+    //! is guaranteed to never block, slow down or crash the application. Messages are
+    //! dropped when necessary to avoid that kind of problem. The number of dropped messages
+    //! is periodically reported.
+    //!
+    //! The internal queue is a lock-free ring buffer of preallocated log records.
+    //! Application threads never wait for each other when logging messages, except
+    //! in synchronous mode when the queue is full.
     //!
     //! Messages are displayed on the standard error device by default.
     //!
@@ -108,6 +113,31 @@ namespace ts {
         //!
         bool getSynchronous() const { return _synchronous; }
 
+        //!
+        //! Select which message is dropped when the queue is full (not in synchronous mode).
+        //! @param [in] on If true, drop the oldest message in the queue. If false, drop the new message.
+        //!
+        void setDropOldest(bool on) { _drop_oldest = on; }
+
+        //!
+        //! Check which message is dropped when the queue is full.
+        //! @return True if the oldest message is dropped, false if the new message is dropped.
+        //!
+        bool getDropOldest() const { return _drop_oldest; }
+
+        //!
+        //! Get the total number of messages which were dropped because the queue was full.
+        //! @return The total number of dropped messages.
+        //!
+        size_t droppedMessages() const { return _dropped.load(); }
+
+        //!
+        //! Get the maximum number of buffered messages.
+        //! @return The size of the internal queue of messages. This is the value from
+        //! AsyncReportArgs, rounded up to the next power of 2.
+        //!
+        size_t maxMessages() const { return _ring.size(); }
+
         //!
         //! Synchronously terminate the report thread.
         //! Automatically performed in destructor.
@@ -122,17 +152,29 @@ namespace ts {
         // This hook is invoked in the context of the logging thread.
         virtual void main() override;
 
-        // The application threads send that type of message to the logging thread
-        struct LogMessage
+        // A preallocated log record in the ring buffer. The application threads
+        // and the logging thread synchronize on the sequence number of the record.
+        // With pos being a monotonic position in the ring:
+        // - sequence == pos : the record is free for an application thread.
+        // - sequence == pos + 1 : the record contains a message for the logging thread.
+        struct LogRecord
         {
-            LogMessage(bool t, int s, const UString& m) : terminate(t), severity(s), message(m) {}
+            LogRecord() : sequence(0), severity(0), message() {}
 
-            bool    terminate;  // ask the logging thread to terminate
-            int     severity;
-            UString message;
+            std::atomic<size_t> sequence;
+            int                 severity;
+            UString             message;
         };
-        typedef SafePtr <LogMessage, NullMutex> LogMessagePtr;
-        typedef MessageQueue <LogMessage, NullMutex> LogMessageQueue;
+        typedef std::vector<LogRecord> LogRing;
+
+        // Enqueue a message in the ring buffer. Return false if dropped.
+        bool enqueue(int severity, const UString& msg);
+
+        // Drop the oldest message in the ring buffer, when the ring is full at enqueue_pos.
+        void dropOldest(size_t enqueue_pos);
+
+        // Report the number of dropped messages since last time, in the logging thread.
+        void reportDropped();
 
         // Default report handler:
         class DefaultHandler : public ReportHandler
@@ -146,11 +188,23 @@ namespace ts {
         };
 
         // Private members:
-        LogMessageQueue         _log_queue;
+        LogRing                 _ring;              // Ring buffer, the size is a power of 2.
+        const size_t            _ring_mask;         // Mask for positions in the ring.
+        std::atomic<size_t>     _enqueue_pos;       // Next position to write.
+        std::atomic<size_t>     _dequeue_pos;       // Next position to read.
+        std::atomic<size_t>     _dropped;           // Total number of dropped messages.
+        size_t                  _reported_dropped;  // Number of dropped messages which were already reported.
+        std::atomic<bool>       _log_waiting;       // The logging thread waits for messages.
+        std::atomic<int>        _app_waiting;       // Number of application threads waiting for free records.
+        std::atomic<bool>       _terminate;         // Request to terminate the logging thread.
+        Mutex                   _mutex;             // Protect the conditions only, not the ring.
+        Condition               _msg_available;     // Signaled when a message is available.
+        Condition               _record_available;  // Signaled when a record becomes free.
         DefaultHandler          _default_handler;
         ReportHandler* volatile _handler;
         volatile bool           _time_stamp;
         volatile bool           _synchronous;
+        volatile bool           _drop_oldest;
         volatile bool           _terminated;
     };
 }
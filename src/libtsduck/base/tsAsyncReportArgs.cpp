@@ -43,6 +43,7 @@ const size_t ts::AsyncReportArgs::MAX_LOG_MESSAGES;
 ts::AsyncReportArgs::AsyncReportArgs() :
     sync_log(false),
     timed_log(false),
+    drop_oldest_log(false),
     log_msg_count(MAX_LOG_MESSAGES)
 {
 }
@@ -64,6 +65,13 @@ void ts::AsyncReportArgs::defineArgs(Args& args) const
               u"this value if you think that too many messages are dropped. The default "
               u"is " + UString::Decimal(MAX_LOG_MESSAGES) + u" messages.");
 
+    args.option(u"log-drop-oldest", 0);
+    args.help(u"log-drop-oldest",
+              u"When too many messages are logged and the buffer of log messages is full, "
+              u"drop the oldest buffered message instead of the new one. By default, the "
+              u"new messages are dropped. In all cases, the number of dropped messages is "
+              u"reported. This option is ignored with --synchronous-log.");
+
     args.option(u"synchronous-log", 's');
     args.help(u"synchronous-log",
               u"Each logged message is guaranteed to be displayed, synchronously, without "
@@ -88,5 +96,6 @@ bool ts::AsyncReportArgs::loadArgs(DuckContext& duck, Args& args)
     log_msg_count = args.intValue<size_t>(u"log-message-count", MAX_LOG_MESSAGES);
     sync_log = args.present(u"synchronous-log");
     timed_log = args.present(u"timed-log");
+    drop_oldest_log = args.present(u"log-drop-oldest");
     return true;
 }
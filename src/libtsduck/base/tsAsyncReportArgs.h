@@ -44,9 +44,10 @@ namespace ts {
     {
     public:
         // Public fields
-        bool   sync_log;       //!< Synchronous log.
-        bool   timed_log;      //!< Add time stamps in log messages.
-        size_t log_msg_count;  //!< Maximum buffered log messages.
+        bool   sync_log;         //!< Synchronous log.
+        bool   timed_log;        //!< Add time stamps in log messages.
+        bool   drop_oldest_log;  //!< Drop the oldest buffered message instead of the new one when the queue is full.
+        size_t log_msg_count;    //!< Maximum buffered log messages.
 
         //!
         //! Default maximum number of messages in the queue.
@@ -0,0 +1,373 @@
+//----------------------------------------------------------------------------
+//
+// TSDuck - The MPEG Transport Stream Toolkit
+// Copyright (c) 2005-2020, Thierry Lelegard
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+// THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------
+
+#include "tsFileBatch.h"
+#include "tsArgs.h"
+#include "tsGuard.h"
+#include "tsSysUtils.h"
+#include "tsTextFormatter.h"
+#include "tsjsonArray.h"
+#include "tsjsonNumber.h"
+#include "tsjsonString.h"
+#include <thread>
+TSDUCK_SOURCE;
+
+
+//----------------------------------------------------------------------------
+// Constructors and destructors.
+//----------------------------------------------------------------------------
+
+ts::FileBatch::FileBatch(const UString& report_suffix) :
+    jobs(0),
+    outputDirectory(),
+    reportSuffix(report_suffix),
+    summaryFile(),
+    files(),
+    _batch_options(false),
+    _mutex(),
+    _handler(nullptr),
+    _output(nullptr),
+    _report(nullptr),
+    _next_file(0),
+    _success_count(0),
+    _failure_count(0),
+    _report_files(),
+    _summaries()
+{
+}
+
+ts::FileBatch::~FileBatch()
+{
+}
+
+
+//----------------------------------------------------------------------------
+// Define command line options in an Args.
+//----------------------------------------------------------------------------
+
+void ts::FileBatch::defineArgs(Args& args) const
+{
+    args.option(u"file-list", 0, Args::STRING, 0, Args::UNLIMITED_COUNT);
+    args.help(u"file-list", u"filename",
+              u"Read the list of input files from the specified text file, one file name per line. "
+              u"Empty lines and lines starting with '#' are ignored. "
+              u"Several --file-list options may be specified. "
+              u"Using this option implies the batch mode.");
+
+    args.option(u"jobs", 'j', Args::POSITIVE);
+    args.help(u"jobs",
+              u"Batch mode: specify the maximum number of files which are processed concurrently. "
+              u"All files are processed in the same process, using one worker thread per job. "
+              u"The default is the number of processors. "
+              u"The batch mode is automatically used when more than one input file is specified.");
+
+    args.option(u"output-directory", 0, Args::STRING);
+    args.help(u"output-directory", u"path",
+              u"Batch mode: write the report of each input file in a separate file in the specified directory. "
+              u"The name of each report file is the base name of the input file without suffix, "
+              u"followed by \"" + reportSuffix + u"\". "
+              u"By default, the report of each file is written on the standard output when the processing "
+              u"of this file is complete, preceded by a header line containing the file name.");
+
+    args.option(u"summary", 0, Args::STRING);
+    args.help(u"summary", u"filename",
+              u"Batch mode: write an aggregated summary of all input files in the specified file, in JSON format. "
+              u"If the file name is \"-\", the summary is written on the standard output.");
+}
+
+
+//----------------------------------------------------------------------------
+// Load arguments from command line.
+//----------------------------------------------------------------------------
+
+bool ts::FileBatch::loadArgs(DuckContext& duck, Args& args)
+{
+    jobs = args.intValue<size_t>(u"jobs", 0);
+    outputDirectory = args.value(u"output-directory");
+    summaryFile = args.value(u"summary");
+    _batch_options = args.present(u"file-list") || args.present(u"jobs") || args.present(u"output-directory") || args.present(u"summary");
+
+    // Load all file lists.
+    bool success = true;
+    for (size_t i = 0; i < args.count(u"file-list"); ++i) {
+        const UString listName(args.value(u"file-list", u"", i));
+        UStringList lines;
+        if (!UString::Load(lines, listName)) {
+            args.error(u"error reading file list %s", {listName});
+            success = false;
+            continue;
+        }
+        for (auto it = lines.begin(); it != lines.end(); ++it) {
+            it->trim();
+            if (!it->empty() && !it->startWith(u"#")) {
+                files.push_back(*it);
+            }
+        }
+    }
+    return success;
+}
+
+
+//----------------------------------------------------------------------------
+// Add files to the batch.
+//----------------------------------------------------------------------------
+
+bool ts::FileBatch::addFiles(const UStringVector& names, Report& report)
+{
+    bool success = true;
+    for (auto it = names.begin(); it != names.end(); ++it) {
+        if (it->find_first_of(u"*?") == NPOS) {
+            // Not a wildcard, keep the name as is, errors are reported when the file is opened.
+            files.push_back(*it);
+        }
+        else if (!ExpandWildcardAndAppend(files, *it)) {
+            report.error(u"error expanding %s", {*it});
+            success = false;
+        }
+    }
+    return success;
+}
+
+
+//----------------------------------------------------------------------------
+// Build report file names in output directory.
+//----------------------------------------------------------------------------
+
+bool ts::FileBatch::buildReportFileNames(Report& report)
+{
+    _report_files.clear();
+    if (outputDirectory.empty()) {
+        return true;
+    }
+
+    if (!IsDirectory(outputDirectory)) {
+        const ErrorCode err = CreateDirectory(outputDirectory, true);
+        if (err != SYS_SUCCESS) {
+            report.error(u"error creating directory %s: %s", {outputDirectory, ErrorCodeMessage(err)});
+            return false;
+        }
+    }
+
+    // Two input files with the same base name in distinct directories get distinct reports.
+    std::set<UString> used;
+    _report_files.reserve(files.size());
+    for (auto it = files.begin(); it != files.end(); ++it) {
+        const UString base(outputDirectory + PathSeparator + PathPrefix(BaseName(*it)));
+        UString name(base + reportSuffix);
+        for (size_t count = 2; used.find(name) != used.end(); ++count) {
+            name = base + UString::Format(u"-%d", {count}) + reportSuffix;
+        }
+        used.insert(name);
+        _report_files.push_back(name);
+    }
+    return true;
+}
+
+
+//----------------------------------------------------------------------------
+// Process all files of the batch.
+//----------------------------------------------------------------------------
+
+bool ts::FileBatch::run(FileBatchHandlerInterface& handler, std::ostream& output, Report& report)
+{
+    _next_file = 0;
+    _success_count = 0;
+    _failure_count = 0;
+    _summaries.clear();
+
+    if (!buildReportFileNames(report)) {
+        return false;
+    }
+
+    _handler = &handler;
+    _output = &output;
+    _report = &report;
+    _summaries.resize(files.size());
+
+    // Never use more workers than files.
+    size_t count = jobs > 0 ? jobs : size_t(std::thread::hardware_concurrency());
+    count = std::max<size_t>(1, std::min(count, files.size()));
+    report.debug(u"processing %d files using %d workers", {files.size(), count});
+
+    // Start all workers and wait for their completion.
+    std::vector<WorkerPtr> workers;
+    workers.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+        workers.push_back(new Worker(*this));
+        if (!workers.back()->start()) {
+            report.error(u"cannot start batch worker thread");
+            workers.pop_back();
+            break;
+        }
+    }
+    if (workers.empty()) {
+        // No worker could be started, process all files in the current thread.
+        for (size_t i = 0; i < files.size(); ++i) {
+            processFile(i);
+        }
+    }
+    for (auto it = workers.begin(); it != workers.end(); ++it) {
+        (*it)->waitForTermination();
+    }
+
+    _handler = nullptr;
+    _output = nullptr;
+    _report = nullptr;
+
+    const bool success = writeSummary(report);
+    _summaries.clear();
+    return success && _failure_count == 0;
+}
+
+
+//----------------------------------------------------------------------------
+// Process one file, in the context of a worker thread.
+//----------------------------------------------------------------------------
+
+void ts::FileBatch::processFile(size_t index)
+{
+    const UString& fileName(files[index]);
+    FileReport report(*this, fileName + u": ");
+    json::Object* summary = new json::Object;
+    _summaries[index] = summary;
+    summary->add(u"file", json::ValuePtr(new json::String(fileName)));
+
+    bool success = false;
+    if (_report_files.empty()) {
+        // Buffer the report of the file until completion.
+        std::ostringstream text;
+        success = _handler->handleBatchFile(*this, fileName, text, *summary, report);
+        Guard lock(_mutex);
+        *_output << "==== " << fileName << std::endl << text.str() << std::endl;
+        _output->flush();
+    }
+    else {
+        // Write the report of the file in its own file.
+        const UString& reportName(_report_files[index]);
+        std::ofstream text(reportName.toUTF8().c_str());
+        if (!text) {
+            report.error(u"cannot create %s", {reportName});
+        }
+        else {
+            success = _handler->handleBatchFile(*this, fileName, text, *summary, report);
+            text.close();
+            summary->add(u"report", json::ValuePtr(new json::String(reportName)));
+        }
+    }
+
+    summary->add(u"status", json::ValuePtr(new json::String(success ? u"success" : u"error")));
+
+    Guard lock(_mutex);
+    if (success) {
+        _success_count++;
+    }
+    else {
+        _failure_count++;
+    }
+}
+
+
+//----------------------------------------------------------------------------
+// Write the aggregated summary.
+//----------------------------------------------------------------------------
+
+bool ts::FileBatch::writeSummary(Report& report)
+{
+    if (summaryFile.empty()) {
+        return true;
+    }
+
+    json::Object root;
+    json::Array* list = new json::Array;
+    root.add(u"files", json::ValuePtr(new json::Number(int64_t(files.size()))));
+    root.add(u"success", json::ValuePtr(new json::Number(int64_t(_success_count))));
+    root.add(u"failure", json::ValuePtr(new json::Number(int64_t(_failure_count))));
+    root.add(u"results", json::ValuePtr(list));
+    for (auto it = _summaries.begin(); it != _summaries.end(); ++it) {
+        if (!it->isNull()) {
+            list->set(*it);
+        }
+    }
+
+    TextFormatter out(report);
+    if (summaryFile == u"-") {
+        out.setStream(std::cout);
+    }
+    else if (!out.setFile(summaryFile)) {
+        return false;
+    }
+    root.print(out);
+    out << std::endl;
+    out.close();
+    return true;
+}
+
+
+//----------------------------------------------------------------------------
+// Worker thread.
+//----------------------------------------------------------------------------
+
+ts::FileBatch::Worker::Worker(FileBatch& batch) :
+    Thread(),
+    _batch(batch)
+{
+}
+
+void ts::FileBatch::Worker::main()
+{
+    for (;;) {
+        size_t index = 0;
+        {
+            Guard lock(_batch._mutex);
+            if (_batch._next_file >= _batch.files.size()) {
+                break;
+            }
+            index = _batch._next_file++;
+        }
+        _batch.processFile(index);
+    }
+}
+
+
+//----------------------------------------------------------------------------
+// Report for one file, serialized on the batch report.
+//----------------------------------------------------------------------------
+
+ts::FileBatch::FileReport::FileReport(FileBatch& batch, const UString& prefix) :
+    Report(batch._report->maxSeverity()),
+    _batch(batch),
+    _prefix(prefix)
+{
+}
+
+void ts::FileBatch::FileReport::writeLog(int severity, const UString& msg)
+{
+    Guard lock(_batch._mutex);
+    _batch._report->log(severity, _prefix + msg);
+}
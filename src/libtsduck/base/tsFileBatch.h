@@ -0,0 +1,171 @@
+//----------------------------------------------------------------------------
+//
+// TSDuck - The MPEG Transport Stream Toolkit
+// Copyright (c) 2005-2020, Thierry Lelegard
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+// THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------
+//!
+//!  @file
+//!  Concurrent processing of a batch of files on a pool of worker threads.
+//!
+//----------------------------------------------------------------------------
+
+#pragma once
+#include "tsArgsSupplierInterface.h"
+#include "tsFileBatchHandlerInterface.h"
+#include "tsThread.h"
+#include "tsMutex.h"
+#include "tsSafePtr.h"
+#include "tsjsonObject.h"
+
+namespace ts {
+    //!
+    //! Concurrent processing of a batch of files on a pool of worker threads.
+    //! @ingroup thread
+    //!
+    //! This class is used by file analysis tools which can process a large number
+    //! of files in one command. All files are processed in the same process, using
+    //! the same loaded configuration (names, PSI/SI repository, etc.) and a bounded
+    //! number of worker threads. Each worker processes one file at a time.
+    //!
+    //! The report of each file is either written in a specific file in an output
+    //! directory or buffered during the processing of the file and written on the
+    //! output of the batch when the file is completed. In both cases, the memory
+    //! usage is bounded by the number of workers, not by the number of files.
+    //!
+    //! An aggregated JSON summary of all files can be optionally produced.
+    //!
+    class TSDUCKDLL FileBatch : public ArgsSupplierInterface
+    {
+        TS_NOCOPY(FileBatch);
+    public:
+        // Public fields, loaded by loadArgs().
+        size_t        jobs;             //!< Number of worker threads, zero means the number of processors.
+        UString       outputDirectory;  //!< Directory for one report per file, empty means common output.
+        UString       reportSuffix;     //!< Suffix of report files in the output directory.
+        UString       summaryFile;      //!< Name of the aggregated JSON summary file, empty if none.
+        UStringVector files;            //!< List of files to process.
+
+        //!
+        //! Constructor.
+        //! @param [in] report_suffix Suffix of report files in the output directory.
+        //!
+        FileBatch(const UString& report_suffix = u".txt");
+
+        //!
+        //! Destructor.
+        //!
+        virtual ~FileBatch();
+
+        //!
+        //! Add files to the batch.
+        //! @param [in] names File names, possibly containing wildcards.
+        //! @param [in,out] report Where to report errors.
+        //! @return True on success, false on error.
+        //!
+        bool addFiles(const UStringVector& names, Report& report);
+
+        //!
+        //! Check if the batch mode is requested.
+        //! @return True if more than one file is specified or if any batch option is specified.
+        //! When false, the application can use its traditional single-file processing.
+        //!
+        bool batchMode() const { return _batch_options || files.size() > 1; }
+
+        //!
+        //! Process all files of the batch.
+        //! The method returns when all files are processed.
+        //! @param [in,out] handler The object which processes each file.
+        //! @param [in,out] output The output stream of the batch, when no output directory is specified.
+        //! @param [in,out] report Where to report errors. This object is used from several threads
+        //! but all accesses are serialized by the batch.
+        //! @return True when all files were successfully processed, false otherwise.
+        //!
+        bool run(FileBatchHandlerInterface& handler, std::ostream& output, Report& report);
+
+        //!
+        //! Get the number of files which were successfully processed by the last run().
+        //! @return The number of successfully processed files.
+        //!
+        size_t successCount() const { return _success_count; }
+
+        //!
+        //! Get the number of files which failed in the last run().
+        //! @return The number of failed files.
+        //!
+        size_t failureCount() const { return _failure_count; }
+
+        // Implementation of ArgsSupplierInterface.
+        virtual void defineArgs(Args& args) const override;
+        virtual bool loadArgs(DuckContext& duck, Args& args) override;
+
+    private:
+        // A worker thread, pulls file indexes from the batch until all files are processed.
+        class Worker : public Thread
+        {
+            TS_NOBUILD_NOCOPY(Worker);
+        public:
+            Worker(FileBatch& batch);
+        private:
+            FileBatch& _batch;
+            virtual void main() override;
+        };
+
+        // A report which prefixes messages with the file name and serializes them on the batch report.
+        class FileReport : public Report
+        {
+            TS_NOBUILD_NOCOPY(FileReport);
+        public:
+            FileReport(FileBatch& batch, const UString& prefix);
+        protected:
+            virtual void writeLog(int severity, const UString& msg) override;
+        private:
+            FileBatch& _batch;
+            UString    _prefix;
+        };
+
+        typedef SafePtr<Worker, NullMutex> WorkerPtr;
+
+        bool                        _batch_options;  // Some batch-specific options were specified.
+        Mutex                       _mutex;          // Protect the batch state, the output and the report.
+        FileBatchHandlerInterface*  _handler;        // Current handler during run().
+        std::ostream*               _output;         // Common output during run().
+        Report*                     _report;         // Common report during run().
+        size_t                      _next_file;      // Index of next file to process.
+        size_t                      _success_count;  // Number of successful files.
+        size_t                      _failure_count;  // Number of failed files.
+        UStringVector               _report_files;   // Report file names in output directory, same index as files.
+        std::vector<json::ValuePtr> _summaries;      // Summary of each file, same index as files.
+
+        // Process one file, in the context of a worker thread.
+        void processFile(size_t index);
+
+        // Build report file names in output directory.
+        bool buildReportFileNames(Report& report);
+
+        // Write the aggregated summary.
+        bool writeSummary(Report& report);
+    };
+}
@@ -0,0 +1,77 @@
+//----------------------------------------------------------------------------
+//
+// TSDuck - The MPEG Transport Stream Toolkit
+// Copyright (c) 2005-2020, Thierry Lelegard
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+// THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------
+//!
+//!  @file
+//!  Abstract interface to process one file of a ts::FileBatch.
+//!
+//----------------------------------------------------------------------------
+
+#pragma once
+#include "tsUString.h"
+#include "tsReport.h"
+#include "tsjsonObject.h"
+
+namespace ts {
+
+    class FileBatch;
+
+    //!
+    //! Abstract interface to process one file of a ts::FileBatch.
+    //! @ingroup thread
+    //!
+    //! The method handleBatchFile() is invoked in the context of a worker thread
+    //! of the batch. Several files are processed concurrently. The implementation
+    //! shall therefore use its own working objects (a ts::DuckContext, an analyzer,
+    //! etc.) for each file and shall never modify shared data without synchronization.
+    //!
+    class TSDUCKDLL FileBatchHandlerInterface
+    {
+    public:
+        //!
+        //! This hook is invoked to process one file of the batch.
+        //! @param [in,out] batch The batch which invokes this handler.
+        //! @param [in] fileName Name of the file to process.
+        //! @param [in,out] output The text stream where the report of this file shall be written.
+        //! This is either a specific file for this input file or a buffer which is later
+        //! copied on the output of the batch.
+        //! @param [in,out] summary A JSON object where the handler can add a few
+        //! characteristic values of the file. The aggregated summary of the batch
+        //! contains one such object per file.
+        //! @param [in,out] report Where to report errors. All messages are prefixed
+        //! with the file name.
+        //! @return True on success, false on error.
+        //!
+        virtual bool handleBatchFile(FileBatch& batch, const UString& fileName, std::ostream& output, json::Object& summary, Report& report) = 0;
+
+        //!
+        //! Virtual destructor.
+        //!
+        virtual ~FileBatchHandlerInterface();
+    };
+}
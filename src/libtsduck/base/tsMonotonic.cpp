@@ -171,6 +171,29 @@ void ts::Monotonic::wait()
 }
 
 
+//----------------------------------------------------------------------------
+// Wait until the time of the monotonic clock with a sub-millisecond precision.
+//----------------------------------------------------------------------------
+
+void ts::Monotonic::preciseWait(const NanoSecond& spin) const
+{
+    // Sleep until shortly before the due time, using an absolute deadline.
+    Monotonic now(true);
+    Monotonic sleep_until(*this);
+    if (spin > 0) {
+        sleep_until -= spin;
+    }
+    if (sleep_until > now) {
+        sleep_until.wait();
+    }
+
+    // Actively poll the clock for the final part.
+    while (spin > 0 && now < *this) {
+        now.getSystemTime();
+    }
+}
+
+
 //----------------------------------------------------------------------------
 // This static method requests a minimum resolution, in nano-seconds, for the
 // timers. Return the guaranteed value (can be equal to or greater than the
@@ -177,6 +177,16 @@ namespace ts {
         //!
         void wait();
 
+        //!
+        //! Wait until the time of the monotonic clock with a sub-millisecond precision.
+        //! The system timers are used to sleep until shortly before the due time, using an
+        //! absolute deadline. Then, the clock is actively polled until the due time.
+        //! This is much more precise than wait() but uses some CPU during the final part of the wait.
+        //! @param [in] spin Duration in nanoseconds of the final active polling. When zero or
+        //! negative, this is the same as wait().
+        //!
+        void preciseWait(const NanoSecond& spin) const;
+
         //!
         //! This static method requests a minimum resolution, in nano-seconds, for the timers.
         //! @param [in] precision Requested minimum resolution in nano-seconds.
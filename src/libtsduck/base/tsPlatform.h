@@ -882,6 +882,7 @@ TS_MSC_NOWARNING(5204)
 #include <map>
 #include <set>
 #include <bitset>
+#include <atomic>
 #include <algorithm>
 #include <iterator>
 #include <limits>
@@ -36,6 +36,13 @@
 #include "tsUString.h"
 #include "tsByteBlock.h"
 #include "tsSysUtils.h"
+#if defined(TS_X86_64) || (defined(TS_I386) && defined(__SSE2__))
+#define TS_UTF_SSE2 1
+#include <emmintrin.h>
+#elif defined(TS_ARM64)
+#define TS_UTF_NEON 1
+#include <arm_neon.h>
+#endif
 TSDUCK_SOURCE;
 
 // The UTF-8 Byte Order Mark
@@ -89,6 +96,99 @@ const ::WCHAR* ts::UString::wc_str() const
 #endif
 
 
+//----------------------------------------------------------------------------
+// Fast paths for runs of ASCII characters in UTF-8 / UTF-16 conversions.
+// Text in TSDuck (XML, JSON, tables names, etc.) is mostly ASCII. These
+// routines convert blocks of characters at once as long as all characters
+// in a block are ASCII. They stop at the first block which contains a
+// non-ASCII character or when there is not enough room for a complete
+// block in the input or output buffer. The remaining characters are then
+// processed one by one by the general routines. SSE2 is used on x86 and
+// NEON on 64-bit Arm (both are always present on these architectures).
+// Otherwise, a portable 64-bit word implementation is used.
+//----------------------------------------------------------------------------
+
+namespace {
+
+    // Number of characters which are processed at once.
+#if defined(TS_UTF_SSE2) || defined(TS_UTF_NEON)
+    constexpr size_t ASCII_BLOCK = 16;
+#else
+    constexpr size_t ASCII_BLOCK = 8;
+#endif
+
+    // Convert a run of ASCII characters from UTF-16 to UTF-8.
+    void ASCIIToUTF8(const ts::UChar*& inStart, const ts::UChar* inEnd, char*& outStart, char* outEnd)
+    {
+        while (inEnd - inStart >= ptrdiff_t(ASCII_BLOCK) && outEnd - outStart >= ptrdiff_t(ASCII_BLOCK)) {
+#if defined(TS_UTF_SSE2)
+            const __m128i w1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(inStart));
+            const __m128i w2 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(inStart + 8));
+            // All characters are ASCII if no bit is set in 0xFF80 in any 16-bit value.
+            const __m128i high = _mm_and_si128(_mm_or_si128(w1, w2), _mm_set1_epi16(int16_t(0xFF80)));
+            if (_mm_movemask_epi8(_mm_cmpeq_epi8(high, _mm_setzero_si128())) != 0xFFFF) {
+                break;
+            }
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(outStart), _mm_packus_epi16(w1, w2));
+#elif defined(TS_UTF_NEON)
+            const uint16x8_t w1 = vld1q_u16(reinterpret_cast<const uint16_t*>(inStart));
+            const uint16x8_t w2 = vld1q_u16(reinterpret_cast<const uint16_t*>(inStart + 8));
+            if (vmaxvq_u16(vorrq_u16(w1, w2)) >= 0x80) {
+                break;
+            }
+            vst1q_u8(reinterpret_cast<uint8_t*>(outStart), vcombine_u8(vmovn_u16(w1), vmovn_u16(w2)));
+#else
+            uint64_t w[2];
+            ::memcpy(w, inStart, sizeof(w));
+            if (((w[0] | w[1]) & TS_UCONST64(0xFF80FF80FF80FF80)) != 0) {
+                break;
+            }
+            for (size_t i = 0; i < ASCII_BLOCK; ++i) {
+                outStart[i] = char(inStart[i]);
+            }
+#endif
+            inStart += ASCII_BLOCK;
+            outStart += ASCII_BLOCK;
+        }
+    }
+
+    // Convert a run of ASCII characters from UTF-8 to UTF-16.
+    void ASCIIToUTF16(const char*& inStart, const char* inEnd, ts::UChar*& outStart, ts::UChar* outEnd)
+    {
+        while (inEnd - inStart >= ptrdiff_t(ASCII_BLOCK) && outEnd - outStart >= ptrdiff_t(ASCII_BLOCK)) {
+#if defined(TS_UTF_SSE2)
+            const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(inStart));
+            // The sign bit of each byte is set for non-ASCII characters.
+            if (_mm_movemask_epi8(b) != 0) {
+                break;
+            }
+            const __m128i zero = _mm_setzero_si128();
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(outStart), _mm_unpacklo_epi8(b, zero));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(outStart + 8), _mm_unpackhi_epi8(b, zero));
+#elif defined(TS_UTF_NEON)
+            const uint8x16_t b = vld1q_u8(reinterpret_cast<const uint8_t*>(inStart));
+            if (vmaxvq_u8(b) >= 0x80) {
+                break;
+            }
+            vst1q_u16(reinterpret_cast<uint16_t*>(outStart), vmovl_u8(vget_low_u8(b)));
+            vst1q_u16(reinterpret_cast<uint16_t*>(outStart + 8), vmovl_u8(vget_high_u8(b)));
+#else
+            uint64_t w;
+            ::memcpy(&w, inStart, sizeof(w));
+            if ((w & TS_UCONST64(0x8080808080808080)) != 0) {
+                break;
+            }
+            for (size_t i = 0; i < ASCII_BLOCK; ++i) {
+                outStart[i] = ts::UChar(inStart[i]);
+            }
+#endif
+            inStart += ASCII_BLOCK;
+            outStart += ASCII_BLOCK;
+        }
+    }
+}
+
+
 //----------------------------------------------------------------------------
 // General routine to convert from UTF-16 to UTF-8.
 //----------------------------------------------------------------------------
@@ -148,6 +248,8 @@ void ts::UString::ConvertUTF16ToUTF8(const UChar*& inStart, const UChar* inEnd,
             if (code < 0x0080) {
                 // ASCII compatible value, one byte encoding.
                 *outStart++ = char(code);
+                // Quickly skip a run of ASCII characters, if any.
+                ASCIIToUTF8(inStart, inEnd, outStart, outEnd);
             }
             else if (code < 0x800 && outStart + 1 < outEnd) {
                 // 2 bytes encoding.
@@ -221,6 +323,8 @@ void ts::UString::ConvertUTF8ToUTF16(const char*& inStart, const char* inEnd, UC
         if (code < 0x80) {
             // 0xxx xxxx, ASCII compatible value, one byte encoding.
             *outStart++ = uint16_t(code);
+            // Quickly skip a run of ASCII characters, if any.
+            ASCIIToUTF16(inStart, inEnd, outStart, outEnd);
         }
         else if ((code & 0xE0) == 0xC0) {
             // 110x xxx, 2 byte encoding.
@@ -330,26 +434,41 @@ ts::UString& ts::UString::assignFromUTF8(const char* utf8)
 
 ts::UString& ts::UString::assignFromUTF8(const char* utf8, size_type count)
 {
-    if (utf8 == nullptr) {
-        clear();
-    }
-    else {
+    clear();
+    return appendFromUTF8(utf8, count);
+}
+
+
+//----------------------------------------------------------------------------
+// Append an UTF-8 string to this object.
+//----------------------------------------------------------------------------
+
+ts::UString& ts::UString::appendFromUTF8(const char* utf8)
+{
+    return appendFromUTF8(utf8, utf8 == nullptr ? 0 : ::strlen(utf8));
+}
+
+ts::UString& ts::UString::appendFromUTF8(const char* utf8, size_type count)
+{
+    if (utf8 != nullptr && count > 0) {
         // Resize the string over the maximum size.
         // The number of UTF-16 codes is always less than the number of UTF-8 bytes.
-        resize(count);
+        const size_type previous = size();
+        resize(previous + count);
 
         // Convert from UTF-8 directly into this object.
         const char* inStart = utf8;
-        UChar* outStart = const_cast<UChar*>(data());
-        ConvertUTF8ToUTF16(inStart, inStart + count, outStart, outStart + size());
+        UChar* const outBase = const_cast<UChar*>(data());
+        UChar* outStart = outBase + previous;
+        ConvertUTF8ToUTF16(inStart, inStart + count, outStart, outBase + size());
 
         assert(inStart >= utf8);
         assert(inStart == utf8 + count);
-        assert(outStart >= data());
-        assert(outStart <= data() + size());
+        assert(outStart >= outBase + previous);
+        assert(outStart <= outBase + size());
 
         // Truncate to the exact number of characters.
-        resize(outStart - data());
+        resize(outStart - outBase);
     }
     return *this;
 }
@@ -361,14 +480,24 @@ ts::UString& ts::UString::assignFromUTF8(const char* utf8, size_type count)
 
 void ts::UString::toUTF8(std::string& utf8) const
 {
-    // The maximum number of UTF-8 bytes is 3 times the number of UTF-16 codes.
-    utf8.resize(3 * size());
+    utf8.clear();
+    appendUTF8(utf8);
+}
+
+void ts::UString::appendUTF8(std::string& utf8) const
+{
+    if (!empty()) {
+        // The maximum number of UTF-8 bytes is 3 times the number of UTF-16 codes.
+        const size_t previous = utf8.size();
+        utf8.resize(previous + 3 * size());
 
-    const UChar* inStart = data();
-    char* outStart = const_cast<char*>(utf8.data());
-    ConvertUTF16ToUTF8(inStart, inStart + size(), outStart, outStart + utf8.size());
+        const UChar* inStart = data();
+        char* const outBase = const_cast<char*>(utf8.data());
+        char* outStart = outBase + previous;
+        ConvertUTF16ToUTF8(inStart, inStart + size(), outStart, outBase + utf8.size());
 
-    utf8.resize(outStart - utf8.data());
+        utf8.resize(outStart - outBase);
+    }
 }
 
 std::string ts::UString::toUTF8() const
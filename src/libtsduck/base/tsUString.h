@@ -413,6 +413,34 @@ namespace ts {
         //!
         UString& assignFromUTF8(const char* utf8, size_type count);
 
+        //!
+        //! Append an UTF-8 string to this object.
+        //! The conversion is performed directly into this object, without temporary string.
+        //! @param [in] utf8 A string in UTF-8 representation.
+        //! @return A reference to this object.
+        //!
+        UString& appendFromUTF8(const std::string& utf8)
+        {
+            return appendFromUTF8(utf8.data(), utf8.size());
+        }
+
+        //!
+        //! Append an UTF-8 string to this object.
+        //! The conversion is performed directly into this object, without temporary string.
+        //! @param [in] utf8 Address of a nul-terminated string in UTF-8 representation.
+        //! @return A reference to this object.
+        //!
+        UString& appendFromUTF8(const char* utf8);
+
+        //!
+        //! Append an UTF-8 string to this object.
+        //! The conversion is performed directly into this object, without temporary string.
+        //! @param [in] utf8 Address of a string in UTF-8 representation. Can be null.
+        //! @param [in] count Size in bytes of the UTF-8 string (not necessarily a number of characters).
+        //! @return A reference to this object.
+        //!
+        UString& appendFromUTF8(const char* utf8, size_type count);
+
         //!
         //! Convert this UTF-16 string into UTF-8.
         //! @return The equivalent UTF-8 string.
@@ -425,6 +453,13 @@ namespace ts {
         //!
         void toUTF8(std::string& utf8) const;
 
+        //!
+        //! Append the UTF-8 representation of this UTF-16 string to a @c std::string.
+        //! The conversion is performed directly into @a utf8, without temporary string.
+        //! @param [in,out] utf8 The string to which the UTF-8 representation is appended.
+        //!
+        void appendUTF8(std::string& utf8) const;
+
         //!
         //! General routine to convert from UTF-16 to UTF-8.
         //! Stop when the input buffer is empty or the output buffer is full, whichever comes first.
@@ -2045,10 +2080,10 @@ namespace ts {
         bool operator!=(const std::string& other) const { return !operator==(other); }
         bool operator!=(const char* other) const { return !operator==(other); }
 
-        UString& append(const std::string& str) { return append(FromUTF8(str)); }
-        UString& append(const std::string& str, size_type pos, size_type count = NPOS) { return append(FromUTF8(str.substr(pos, count))); }
-        UString& append(const char* s, size_type count) { return append(FromUTF8(s, count)); }
-        UString& append(const char* s) { return append(FromUTF8(s)); }
+        UString& append(const std::string& str) { return appendFromUTF8(str); }
+        UString& append(const std::string& str, size_type pos, size_type count = NPOS) { return appendFromUTF8(str.substr(pos, count)); }
+        UString& append(const char* s, size_type count) { return appendFromUTF8(s, count); }
+        UString& append(const char* s) { return appendFromUTF8(s); }
 
         UString& operator+=(const std::string& s) { return append(s); }
         UString& operator+=(const char* s) { return append(s); }
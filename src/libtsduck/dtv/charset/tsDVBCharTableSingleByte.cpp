@@ -102,6 +102,21 @@ bool ts::DVBCharTableSingleByte::decode(UString& str, const uint8_t* dvb, size_t
     bool reverseNext = false;  // after decoding next character, it shall be swapped with previous one.
     bool hasDiacritical = false;
 
+    // Fast path: the leading ASCII characters (often the complete string) are
+    // identical in all single-byte tables, copy them without further check.
+    if (dvb != nullptr) {
+        size_t ascii = 0;
+        while (ascii < dvbSize && dvb[ascii] >= 0x20 && dvb[ascii] <= 0x7E) {
+            ascii++;
+        }
+        str.resize(ascii);
+        for (size_t i = 0; i < ascii; ++i) {
+            str[i] = UChar(dvb[i]);
+        }
+        dvb += ascii;
+        dvbSize -= ascii;
+    }
+
     for (; dvb != nullptr && dvbSize > 0; --dvbSize) {
         // Get next byte
         const uint8_t b = *dvb++;
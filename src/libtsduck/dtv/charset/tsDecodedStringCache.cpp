@@ -0,0 +1,154 @@
+//----------------------------------------------------------------------------
+//
+// TSDuck - The MPEG Transport Stream Toolkit
+// Copyright (c) 2005-2020, Thierry Lelegard
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+// THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------
+
+#include "tsDecodedStringCache.h"
+TSDUCK_SOURCE;
+
+
+//----------------------------------------------------------------------------
+// Constructor.
+//----------------------------------------------------------------------------
+
+ts::DecodedStringCache::DecodedStringCache(size_t maxEntries) :
+    _maxEntries(maxEntries),
+    _entries(),
+    _index(),
+    _hits(0),
+    _misses(0)
+{
+}
+
+
+//----------------------------------------------------------------------------
+// Cache management.
+//----------------------------------------------------------------------------
+
+void ts::DecodedStringCache::setMaxEntries(size_t maxEntries)
+{
+    _maxEntries = maxEntries;
+
+    // Drop least recently used entries.
+    while (_entries.size() > _maxEntries) {
+        _index.erase(_entries.back().hash);
+        _entries.pop_back();
+    }
+}
+
+void ts::DecodedStringCache::clear()
+{
+    _entries.clear();
+    _index.clear();
+    resetStatistics();
+}
+
+void ts::DecodedStringCache::resetStatistics()
+{
+    _hits = _misses = 0;
+}
+
+
+//----------------------------------------------------------------------------
+// Compute the hash of a charset and binary string (64-bit FNV-1a).
+//----------------------------------------------------------------------------
+
+uint64_t ts::DecodedStringCache::Hash(const Charset* charset, const uint8_t* data, size_t size)
+{
+    uint64_t hash = TS_UCONST64(0xCBF29CE484222325) ^ uint64_t(reinterpret_cast<uintptr_t>(charset));
+    for (size_t i = 0; i < size; ++i) {
+        hash = (hash ^ data[i]) * TS_UCONST64(0x00000100000001B3);
+    }
+    return hash;
+}
+
+
+//----------------------------------------------------------------------------
+// Decode a string from the specified byte buffer, using the cache.
+//----------------------------------------------------------------------------
+
+bool ts::DecodedStringCache::decode(const Charset* charset, UString& str, const uint8_t* data, size_t size)
+{
+    // Without cache or without string, decode directly.
+    if (_maxEntries == 0 || data == nullptr || size == 0) {
+        return charset->decode(str, data, size);
+    }
+
+    // Look for the string in the cache.
+    const uint64_t hash = Hash(charset, data, size);
+    const auto it = _index.find(hash);
+    if (it != _index.end()) {
+        const EntryList::iterator entry(it->second);
+        if (entry->charset == charset && entry->data.size() == size && ::memcmp(entry->data.data(), data, size) == 0) {
+            // Found, move it at head of the LRU list.
+            _hits++;
+            _entries.splice(_entries.begin(), _entries, entry);
+            str = entry->str;
+            return entry->status;
+        }
+        // Hash collision with a different string, drop the previous one.
+        _entries.erase(entry);
+        _index.erase(it);
+    }
+
+    // Not found, decode the string and insert it in the cache.
+    _misses++;
+    const bool status = charset->decode(str, data, size);
+    _entries.push_front(Entry({hash, charset, ByteBlock(data, size), str, status}));
+    _index[hash] = _entries.begin();
+
+    // Drop the least recently used entry when the cache is full.
+    if (_entries.size() > _maxEntries) {
+        _index.erase(_entries.back().hash);
+        _entries.pop_back();
+    }
+    return status;
+}
+
+
+//----------------------------------------------------------------------------
+// Decode a string (preceded by its one-byte length), using the cache.
+//----------------------------------------------------------------------------
+
+bool ts::DecodedStringCache::decodeWithByteLength(const Charset* charset, UString& str, const uint8_t*& data, size_t& size)
+{
+    // Same processing as Charset::decodeWithByteLength(), we need one byte for the length.
+    if (size == 0 || data == nullptr) {
+        return false;
+    }
+
+    // Get the length of the encoded string.
+    const size_t len = std::min<size_t>(data[0], size - 1);
+
+    // Update the buffer and size to point after the encoded string.
+    const uint8_t* const start = data + 1;
+    data += 1 + len;
+    size -= 1 + len;
+
+    // Decode and return the string.
+    return decode(charset, str, start, len);
+}
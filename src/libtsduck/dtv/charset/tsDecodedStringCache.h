@@ -0,0 +1,148 @@
+//----------------------------------------------------------------------------
+//
+// TSDuck - The MPEG Transport Stream Toolkit
+// Copyright (c) 2005-2020, Thierry Lelegard
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+// THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------
+//!
+//!  @file
+//!  Bounded cache of decoded signalization strings.
+//!
+//----------------------------------------------------------------------------
+
+#pragma once
+#include "tsCharset.h"
+#include "tsByteBlock.h"
+
+namespace ts {
+    //!
+    //! Bounded cache of decoded signalization strings.
+    //! @ingroup mpeg
+    //!
+    //! Tables such as EIT, SDT or NIT repeat the same event and service names
+    //! over and over. This class keeps the most recently decoded strings, indexed
+    //! by character set and binary representation, so that they are decoded only
+    //! once. When the cache is full, the least recently used string is dropped.
+    //!
+    //! A cache with a maximum size of zero is disabled: all strings are decoded
+    //! directly using the character set.
+    //!
+    //! This class is not thread-safe.
+    //!
+    class TSDUCKDLL DecodedStringCache
+    {
+        TS_NOCOPY(DecodedStringCache);
+    public:
+        //!
+        //! Constructor.
+        //! @param [in] maxEntries Maximum number of strings in the cache. Zero means disabled.
+        //!
+        explicit DecodedStringCache(size_t maxEntries = 0);
+
+        //!
+        //! Set the maximum number of strings in the cache.
+        //! @param [in] maxEntries Maximum number of strings in the cache. Zero means disabled.
+        //! The least recently used strings are dropped if the cache is currently larger.
+        //!
+        void setMaxEntries(size_t maxEntries);
+
+        //!
+        //! Get the maximum number of strings in the cache.
+        //! @return The maximum number of strings in the cache. Zero means disabled.
+        //!
+        size_t maxEntries() const { return _maxEntries; }
+
+        //!
+        //! Get the current number of strings in the cache.
+        //! @return The current number of strings in the cache.
+        //!
+        size_t size() const { return _entries.size(); }
+
+        //!
+        //! Get the number of successful lookups in the cache since the last reset.
+        //! @return The number of cache hits.
+        //!
+        uint64_t hits() const { return _hits; }
+
+        //!
+        //! Get the number of failed lookups in the cache since the last reset.
+        //! @return The number of cache misses.
+        //!
+        uint64_t misses() const { return _misses; }
+
+        //!
+        //! Remove all strings from the cache and reset statistics.
+        //!
+        void clear();
+
+        //!
+        //! Reset hit/miss statistics.
+        //!
+        void resetStatistics();
+
+        //!
+        //! Decode a string from the specified byte buffer, using the cache when possible.
+        //! @param [in] charset The character set to use.
+        //! @param [out] str Returned decoded string.
+        //! @param [in] data Address of an encoded string.
+        //! @param [in] size Size in bytes of the encoded string.
+        //! @return True on success, false on error (truncated, unsupported format, etc.)
+        //! @see Charset::decode()
+        //!
+        bool decode(const Charset* charset, UString& str, const uint8_t* data, size_t size);
+
+        //!
+        //! Decode a string (preceded by its one-byte length) from the specified byte buffer, using the cache when possible.
+        //! @param [in] charset The character set to use.
+        //! @param [out] str Returned decoded string.
+        //! @param [in,out] data Address of an encoded string. The address is updated to point after the decoded value.
+        //! @param [in,out] size Size of the buffer. Updated to remaining size.
+        //! @return True on success, false on error (truncated, unsupported format, etc.)
+        //! @see Charset::decodeWithByteLength()
+        //!
+        bool decodeWithByteLength(const Charset* charset, UString& str, const uint8_t*& data, size_t& size);
+
+    private:
+        // One decoded string in the cache.
+        struct Entry
+        {
+            uint64_t       hash;     // Hash of charset and binary string, index in _index.
+            const Charset* charset;  // Character set which was used to decode.
+            ByteBlock      data;     // Binary representation.
+            UString        str;      // Decoded string.
+            bool           status;   // Decoding status.
+        };
+        typedef std::list<Entry> EntryList;
+
+        size_t    _maxEntries;  // Maximum number of entries, zero means disabled.
+        EntryList _entries;     // Cached strings, most recently used first.
+        std::map<uint64_t, EntryList::iterator> _index;  // Index of entries by hash.
+        uint64_t  _hits;        // Number of cache hits.
+        uint64_t  _misses;      // Number of cache misses.
+
+        // Compute the hash of a charset and binary string.
+        static uint64_t Hash(const Charset* charset, const uint8_t* data, size_t size);
+    };
+}
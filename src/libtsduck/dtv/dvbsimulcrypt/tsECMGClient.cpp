@@ -59,6 +59,7 @@ ts::ECMGClient::ECMGClient(size_t extra_handler_stack_size) :
     _mutex(),
     _work_to_do(),
     _async_requests(),
+    _streams(),
     _response_queue(RESPONSE_QUEUE_SIZE)
 {
 }
@@ -133,6 +134,7 @@ bool ts::ECMGClient::connect(const ECMGClientArgs& args,
         }
         _abort = abort;
         _logger = logger;
+        _streams.clear();
     }
 
     // Perform TCP connection to ECMG server
@@ -172,39 +174,82 @@ bool ts::ECMGClient::connect(const ECMGClientArgs& args,
     assert(csp != nullptr);
     channel_status = _channel_status = *csp;
 
+    // Setup the first ECM stream.
+    if (!setupStream(args.ecm_stream_id, args.ecm_id, args.cp_duration, _stream_status)) {
+        return abortConnection();
+    }
+    stream_status = _stream_status;
+
+    // ECM stream now established
+    {
+        Guard lock(_mutex);
+        _state = CONNECTED;
+    }
+
+    return true;
+}
+
+
+//----------------------------------------------------------------------------
+// Send a stream_setup and wait for the stream_status.
+//----------------------------------------------------------------------------
+
+bool ts::ECMGClient::setupStream(uint16_t stream_id, uint16_t ecm_id, MilliSecond cp_duration, ecmgscs::StreamStatus& stream_status)
+{
     // Send a stream_setup message to ECMG
     ecmgscs::StreamSetup stream_setup;
-    stream_setup.channel_id = args.ecm_channel_id;
-    stream_setup.stream_id = args.ecm_stream_id;
-    stream_setup.ECM_id = args.ecm_id;
-    stream_setup.nominal_CP_duration = uint16_t(args.cp_duration / 100); // unit is 1/10 second
+    stream_setup.channel_id = _channel_status.channel_id;
+    stream_setup.stream_id = stream_id;
+    stream_setup.ECM_id = ecm_id;
+    stream_setup.nominal_CP_duration = uint16_t(cp_duration / 100); // unit is 1/10 second
     if (!_connection.send(stream_setup, _logger)) {
-        return abortConnection();
+        return false;
     }
 
     // Wait for a stream_status from the ECMG
+    tlv::MessagePtr msg;
     if (!_response_queue.dequeue(msg, RESPONSE_TIMEOUT)) {
-        return abortConnection(u"ECMG stream_setup response timeout");
+        _logger.report().error(u"ECMG stream_setup response timeout");
+        return false;
     }
     if (msg->tag() != ecmgscs::Tags::stream_status) {
-        return abortConnection(u"unexpected response from ECMG (expected stream_status):\n" + msg->dump(4));
+        _logger.report().error(u"unexpected response from ECMG (expected stream_status):\n" + msg->dump(4));
+        return false;
     }
     ecmgscs::StreamStatus* const ssp = dynamic_cast<ecmgscs::StreamStatus*>(msg.pointer());
     assert(ssp != nullptr);
-    stream_status = _stream_status = *ssp;
+    stream_status = *ssp;
 
-    // ECM stream now established
+    // Register the new stream, the receiver thread uses it to reply to stream_test.
+    Guard lock(_mutex);
+    _streams[stream_id] = *ssp;
+    return true;
+}
+
+
+//----------------------------------------------------------------------------
+// Open an additional ECM stream in the channel of the current connection.
+//----------------------------------------------------------------------------
+
+bool ts::ECMGClient::addStream(uint16_t stream_id, uint16_t ecm_id, MilliSecond cp_duration, ecmgscs::StreamStatus& stream_status)
+{
     {
         Guard lock(_mutex);
-        _state = CONNECTED;
+        if (_state != CONNECTED) {
+            _logger.report().error(u"ECMG client not connected");
+            return false;
+        }
+        if (_streams.find(stream_id) != _streams.end()) {
+            _logger.report().error(u"ECM stream id %d already open", {stream_id});
+            return false;
+        }
     }
-
-    return true;
+    return setupStream(stream_id, ecm_id, cp_duration, stream_status);
 }
 
 
 //----------------------------------------------------------------------------
-// Disconnect from remote ECMG. Close stream and channel.
+// Disconnect from remote ECMG. Close all streams and channel.
 //----------------------------------------------------------------------------
 
 bool ts::ECMGClient::disconnect()
@@ -222,16 +267,25 @@ bool ts::ECMGClient::disconnect()
     // Disconnection sequence
     bool ok = previous_state == CONNECTED;
     if (ok) {
-        // Politely send a stream_close_request
-        ecmgscs::StreamCloseRequest req;
-        req.channel_id = _stream_status.channel_id;
-        req.stream_id = _stream_status.stream_id;
-        tlv::MessagePtr resp;
-        // Politely send a stream_close_request
-        // and wait for a stream_close_response
-        ok = _connection.send(req, _logger) &&
-            _response_queue.dequeue(resp, RESPONSE_TIMEOUT) &&
-            resp->tag() == ecmgscs::Tags::stream_close_response;
+        // Get a copy of the list of open streams.
+        StreamMap streams;
+        {
+            Guard lock(_mutex);
+            streams = _streams;
+            _streams.clear();
+        }
+        for (StreamMap::const_iterator it = streams.begin(); ok && it != streams.end(); ++it) {
+            // Politely send a stream_close_request
+            ecmgscs::StreamCloseRequest req;
+            req.channel_id = it->second.channel_id;
+            req.stream_id = it->second.stream_id;
+            tlv::MessagePtr resp;
+            // Politely send a stream_close_request
+            // and wait for a stream_close_response
+            ok = _connection.send(req, _logger) &&
+                _response_queue.dequeue(resp, RESPONSE_TIMEOUT) &&
+                resp->tag() == ecmgscs::Tags::stream_close_response;
+        }
         // If we get a polite reply, send a channel_close
         if (ok) {
             ecmgscs::ChannelClose cc;
@@ -258,6 +312,7 @@ bool ts::ECMGClient::disconnect()
 //----------------------------------------------------------------------------
 
 void ts::ECMGClient::buildCWProvision(ecmgscs::CWProvision& msg,
+                                      uint16_t stream_id,
                                       uint16_t cp_number,
                                       const ByteBlock& current_cw,
                                       const ByteBlock& next_cw,
@@ -265,7 +320,7 @@ void ts::ECMGClient::buildCWProvision(ecmgscs::CWProvision& msg,
                                       uint16_t cp_duration)
 {
     msg.channel_id = _stream_status.channel_id;
-    msg.stream_id = _stream_status.stream_id;
+    msg.stream_id = stream_id;
     msg.CP_number = cp_number;
     msg.has_CW_encryption = false;
     msg.has_CP_duration = cp_duration != 0;
@@ -287,7 +342,8 @@ void ts::ECMGClient::buildCWProvision(ecmgscs::CWProvision& msg,
 // Synchronously generate an ECM.
 //----------------------------------------------------------------------------
 
-bool ts::ECMGClient::generateECM(uint16_t cp_number,
+bool ts::ECMGClient::generateECM(uint16_t stream_id,
+                                 uint16_t cp_number,
                                  const ByteBlock& current_cw,
                                  const ByteBlock& next_cw,
                                  const ByteBlock& ac,
@@ -296,7 +352,7 @@ bool ts::ECMGClient::generateECM(uint16_t cp_number,
 {
     // Build a CW_provision message
     ecmgscs::CWProvision msg;
-    buildCWProvision(msg, cp_number, current_cw, next_cw, ac, cp_duration);
+    buildCWProvision(msg, stream_id, cp_number, current_cw, next_cw, ac, cp_duration);
 
     // Send the CW_provision message
     if (!_connection.send(msg, _logger)) {
@@ -315,7 +371,7 @@ bool ts::ECMGClient::generateECM(uint16_t cp_number,
     if (resp->tag() == ecmgscs::Tags::ECM_response) {
         ecmgscs::ECMResponse* const ep = dynamic_cast <ecmgscs::ECMResponse*>(resp.pointer());
         assert(ep != nullptr);
-        if (ep->CP_number == cp_number) {
+        if (ep->stream_id == stream_id && ep->CP_number == cp_number) {
             // This is our ECM
             ecm_response = *ep;
             return true;
@@ -335,7 +391,8 @@ bool ts::ECMGClient::generateECM(uint16_t cp_number,
 // Asynchronously generate an ECM.
 //----------------------------------------------------------------------------
 
-bool ts::ECMGClient::submitECM(uint16_t cp_number,
+bool ts::ECMGClient::submitECM(uint16_t stream_id,
+                               uint16_t cp_number,
                                const ByteBlock& current_cw,
                                const ByteBlock& next_cw,
                                const ByteBlock& ac,
@@ -344,12 +401,13 @@ bool ts::ECMGClient::submitECM(uint16_t cp_number,
 {
     // Build a CW_provision message
     ecmgscs::CWProvision msg;
-    buildCWProvision(msg, cp_number, current_cw, next_cw, ac, cp_duration);
+    buildCWProvision(msg, stream_id, cp_number, current_cw, next_cw, ac, cp_duration);
 
     // Register an asynchronous request
+    const uint32_t key = RequestKey(stream_id, cp_number);
     {
         Guard lock(_mutex);
-        _async_requests.insert(std::make_pair(cp_number, ecm_handler));
+        _async_requests.insert(std::make_pair(key, ecm_handler));
     }
 
     // Send the CW_provision message
@@ -358,7 +416,7 @@ bool ts::ECMGClient::submitECM(uint16_t cp_number,
     // Clear asynchronous request on error
     if (!ok) {
         Guard lock(_mutex);
-        _async_requests.erase(cp_number);
+        _async_requests.erase(key);
     }
 
     return ok;
@@ -405,8 +463,17 @@ void ts::ECMGClient::main()
                     break;
                 }
                 case ecmgscs::Tags::stream_test: {
-                    // Automatic reply to stream_test
-                    ok = _connection.send(_stream_status, _logger);
+                    // Automatic reply to stream_test, using the status of the tested stream
+                    const ecmgscs::StreamTest* const test = dynamic_cast<const ecmgscs::StreamTest*>(msg.pointer());
+                    ecmgscs::StreamStatus status(_stream_status);
+                    if (test != nullptr) {
+                        Guard lock(_mutex);
+                        const StreamMap::const_iterator it = _streams.find(test->stream_id);
+                        if (it != _streams.end()) {
+                            status = it->second;
+                        }
+                    }
+                    ok = _connection.send(status, _logger);
                     break;
                 }
                 case ecmgscs::Tags::ECM_response: {
@@ -416,10 +483,10 @@ void ts::ECMGClient::main()
                     ECMGClientHandlerInterface* handler = nullptr;
                     {
                         Guard lock(_mutex);
-                        AsyncRequests::iterator it = _async_requests.find(resp->CP_number);
+                        AsyncRequests::iterator it = _async_requests.find(RequestKey(resp->stream_id, resp->CP_number));
                         if (it != _async_requests.end()) {
                             handler = it->second;
-                            _async_requests.erase(resp->CP_number);
+                            _async_requests.erase(it);
                         }
                     }
                     if (handler == nullptr) {
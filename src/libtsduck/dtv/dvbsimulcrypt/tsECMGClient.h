@@ -51,6 +51,12 @@ namespace ts {
     //! Restriction: The target ECMG shall support only current or current/next control
     //! words in ECM, meaning CW_per_msg = 1 or 2 and lead_CW = 0 or 1.
     //!
+    //! Several ECM streams can be multiplexed in the channel of one connection, one
+    //! per scrambled service for instance. The first stream is opened by connect(),
+    //! additional streams are opened using addStream(). Asynchronous ECM requests are
+    //! pipelined: several CW_provision messages, for the same or different streams,
+    //! can be outstanding at the same time.
+    //!
     //! @see DVB standard ETSI TS 103.197 V1.4.1 for ECMG <=> SCS protocol.
     //! @ingroup mpeg
     //!
@@ -89,8 +95,19 @@ namespace ts {
                      const tlv::Logger& logger);
 
         //!
-        //! Synchronously generate an ECM.
+        //! Open an additional ECM stream in the channel of the current connection.
+        //! @param [in] stream_id ECM_stream_id of the new stream.
+        //! @param [in] ecm_id ECM_id of the new stream.
+        //! @param [in] cp_duration Nominal crypto-period duration in milliseconds.
+        //! @param [out] stream_status Response to stream_setup.
+        //! @return True on success, false on error.
+        //!
+        bool addStream(uint16_t stream_id, uint16_t ecm_id, MilliSecond cp_duration, ecmgscs::StreamStatus& stream_status);
+
+        //!
+        //! Synchronously generate an ECM in a given stream.
         //!
+        //! @param [in] stream_id ECM_stream_id, as specified in connect() or addStream().
         //! @param [in] cp_number Current crypto-period number.
         //! @param [in] current_cw Control word for current crypto-period.
         //! @param [in] next_cw Control word for next crypto-period.
@@ -100,7 +117,8 @@ namespace ts {
         //! @param [out] response Returned ECM.
         //! @return True on success, false on error.
         //!
-        bool generateECM(uint16_t cp_number,
+        bool generateECM(uint16_t stream_id,
+                         uint16_t cp_number,
                          const ByteBlock& current_cw,
                          const ByteBlock& next_cw,
                          const ByteBlock& ac,
@@ -108,10 +126,34 @@ namespace ts {
                          ecmgscs::ECMResponse& response);
 
         //!
-        //! Asynchronously generate an ECM.
+        //! Synchronously generate an ECM in the first stream.
+        //!
+        //! @param [in] cp_number Current crypto-period number.
+        //! @param [in] current_cw Control word for current crypto-period.
+        //! @param [in] next_cw Control word for next crypto-period.
+        //! If empty, the ECMG must work with CW_per_msg = 1.
+        //! @param [in] ac Access criteria, can be empty.
+        //! @param [in] cp_duration Crypto-period in 100 ms units, unspecified if zero.
+        //! @param [out] response Returned ECM.
+        //! @return True on success, false on error.
+        //!
+        bool generateECM(uint16_t cp_number,
+                         const ByteBlock& current_cw,
+                         const ByteBlock& next_cw,
+                         const ByteBlock& ac,
+                         uint16_t cp_duration,
+                         ecmgscs::ECMResponse& response)
+        {
+            return generateECM(_stream_status.stream_id, cp_number, current_cw, next_cw, ac, cp_duration, response);
+        }
+
+        //!
+        //! Asynchronously generate an ECM in a given stream.
         //! Submit the ECM request and return immediately.
         //! The notification of the ECM generation or error is performed through the specified handler.
+        //! Several requests can be outstanding at the same time.
         //!
+        //! @param [in] stream_id ECM_stream_id, as specified in connect() or addStream().
         //! @param [in] cp_number Current crypto-period number.
         //! @param [in] current_cw Control word for current crypto-period.
         //! @param [in] next_cw Control word for next crypto-period.
@@ -121,16 +163,41 @@ namespace ts {
         //! @param [in] handler Object which will be notified of the returned ECM.
         //! @return True on success, false on error.
         //!
-        bool submitECM(uint16_t cp_number,
+        bool submitECM(uint16_t stream_id,
+                       uint16_t cp_number,
                        const ByteBlock& current_cw,
                        const ByteBlock& next_cw,
                        const ByteBlock& ac,
                        uint16_t cp_duration,
                        ECMGClientHandlerInterface* handler);
 
+        //!
+        //! Asynchronously generate an ECM in the first stream.
+        //! Submit the ECM request and return immediately.
+        //! The notification of the ECM generation or error is performed through the specified handler.
+        //!
+        //! @param [in] cp_number Current crypto-period number.
+        //! @param [in] current_cw Control word for current crypto-period.
+        //! @param [in] next_cw Control word for next crypto-period.
+        //! If empty, the ECMG must work with CW_per_msg = 1.
+        //! @param [in] ac Access criteria, can be empty.
+        //! @param [in] cp_duration Crypto-period in 100 ms units, unspecified if zero.
+        //! @param [in] handler Object which will be notified of the returned ECM.
+        //! @return True on success, false on error.
+        //!
+        bool submitECM(uint16_t cp_number,
+                       const ByteBlock& current_cw,
+                       const ByteBlock& next_cw,
+                       const ByteBlock& ac,
+                       uint16_t cp_duration,
+                       ECMGClientHandlerInterface* handler)
+        {
+            return submitECM(_stream_status.stream_id, cp_number, current_cw, next_cw, ac, cp_duration, handler);
+        }
+
         //!
         //! Disconnect from remote ECMG.
-        //! Close stream and channel.
+        //! Close all streams and channel.
         //! @return True on success, false on error.
         //!
         bool disconnect();
@@ -161,8 +228,14 @@ namespace ts {
         // Timeout for responses from ECMG (except ECM generation)
         static const MilliSecond RESPONSE_TIMEOUT = 5000;
 
-        // List of asynchronous ECM requests: key=cp_number, value=handler
-        typedef std::map <uint16_t, ECMGClientHandlerInterface*> AsyncRequests;
+        // List of asynchronous ECM requests: key=stream_id/cp_number, value=handler
+        typedef std::map <uint32_t, ECMGClientHandlerInterface*> AsyncRequests;
+
+        // Open ECM streams: key=stream_id, value=response to stream_setup.
+        typedef std::map <uint16_t, ecmgscs::StreamStatus> StreamMap;
+
+        // Key in AsyncRequests.
+        static uint32_t RequestKey(uint16_t stream_id, uint16_t cp_number) { return (uint32_t(stream_id) << 16) | cp_number; }
 
         // Private members
         State                   _state;
@@ -170,20 +243,25 @@ namespace ts {
         tlv::Logger             _logger;
         tlv::Connection <Mutex> _connection;     // connection with ECMG server
         ecmgscs::ChannelStatus  _channel_status; // initial response to channel_setup
-        ecmgscs::StreamStatus   _stream_status;  // initial response to stream_setup
+        ecmgscs::StreamStatus   _stream_status;  // initial response to stream_setup (first stream)
         Mutex                   _mutex;          // exclusive access to protected fields
         Condition               _work_to_do;     // notify receiver thread to do some work
         AsyncRequests           _async_requests;
+        StreamMap               _streams;        // all open streams, including the first one
         MessageQueue <tlv::Message, NullMutex> _response_queue;
 
         // Build a CW_provision message.
         void buildCWProvision(ecmgscs::CWProvision& msg,
+                              uint16_t stream_id,
                               uint16_t cp_number,
                               const ByteBlock& current_cw,
                               const ByteBlock& next_cw,
                               const ByteBlock& ac,
                               uint16_t cp_duration);
 
+        // Send a stream_setup and wait for the stream_status.
+        bool setupStream(uint16_t stream_id, uint16_t ecm_id, MilliSecond cp_duration, ecmgscs::StreamStatus& stream_status);
+
         // Receiver thread main code
         virtual void main() override;
 
@@ -33,6 +33,7 @@
 
 #define TS_AVCPARSER_CPP 1
 #include "tsAVCParser.h"
+#include "tsStartCodeScanner.h"
 TSDUCK_SOURCE;
 
 
@@ -45,9 +46,11 @@ ts::AVCParser::AVCParser(const void* data, size_t size_in_bytes) :
     _end(_base + size_in_bytes),
     _total_size(size_in_bytes),
     _byte(_base),
-    _bit(0)
+    _bit(0),
+    _next_epb(nullptr)
 {
     ts_avcparser_assert_consistent();
+    locateEmulationPrevention();
 }
 
 
@@ -64,6 +67,7 @@ void ts::AVCParser::reset(const void* data, size_t size_in_bytes)
     _bit = 0;
 
     ts_avcparser_assert_consistent();
+    locateEmulationPrevention();
 }
 
 
@@ -77,6 +81,7 @@ void ts::AVCParser::reset(size_t byte_offset, size_t bit_offset)
     _bit = _byte == _end ? 0 : bit_offset % 8;
 
     ts_avcparser_assert_consistent();
+    locateEmulationPrevention();
 }
 
 
@@ -112,6 +117,7 @@ bool ts::AVCParser::rbspTrailingBits()
     ts_avcparser_assert_consistent();
 
     const uint8_t* saved_byte = _byte;
+    const uint8_t* saved_epb = _next_epb;
     size_t saved_bit = _bit;
     uint8_t bit = 0;
 
@@ -122,6 +128,7 @@ bool ts::AVCParser::rbspTrailingBits()
     if (!valid) {
         _byte = saved_byte;
         _bit = saved_bit;
+        _next_epb = saved_epb;
     }
     return valid;
 }
@@ -145,14 +152,26 @@ void ts::AVCParser::nextByte()
     // Process start code emulation prevention: sequences 00 00 03
     // are used when 00 00 00 or 00 00 01 would be present. In that
     // case, the 00 00 is part of the raw byte sequence payload (rbsp)
-    // but the 03 shall be discarded.
-    if (_byte < _end && *_byte == 0x03 && _byte > _base+1 && _byte[-1] == 0x00 && _byte[-2] == 0x00) {
+    // but the 03 shall be discarded. The next 03 to skip is located
+    // in advance so that the data are scanned only once.
+    if (_byte == _next_epb) {
         // Skip 03 after 00 00
         ++_byte;
+        locateEmulationPrevention();
     }
 }
 
 
+//----------------------------------------------------------------------------
+// Locate the next emulation prevention byte after the current byte.
+//----------------------------------------------------------------------------
+
+void ts::AVCParser::locateEmulationPrevention()
+{
+    _next_epb = _byte < _end ? StartCodeScanner::NextEmulationPrevention(_base, _byte + 1, _end) : nullptr;
+}
+
+
 //----------------------------------------------------------------------------
 // Advance pointer by one bit and return the bit value
 //----------------------------------------------------------------------------
@@ -191,6 +191,7 @@ namespace ts {
         size_t         _total_size;   // Size in bytes of the memory area.
         const uint8_t* _byte;         // Current byte pointer inside memory area.
         size_t         _bit;          // Current bit offset into *_byte
+        const uint8_t* _next_epb;     // Next emulation prevention byte after _byte, null if none.
 
         //! @cond nodoxygen
         // A macro asserting the consistent state of this object.
@@ -207,6 +208,9 @@ namespace ts {
         // Advance pointer to next byte boundary.
         void nextByte();
 
+        // Locate the next emulation prevention byte after the current byte.
+        void locateEmulationPrevention();
+
         // Advance pointer by one bit and return the bit value
         uint8_t nextBit();
 
@@ -40,11 +40,13 @@ bool ts::AVCParser::nextBits(INT& val, size_t n)
     ts_avcparser_assert_consistent();
 
     const uint8_t* saved_byte = _byte;
+    const uint8_t* saved_epb = _next_epb;
     size_t saved_bit = _bit;
 
     bool result = readBits(val, n);
     _byte = saved_byte;
     _bit = saved_bit;
+    _next_epb = saved_epb;
 
     return result;
 }
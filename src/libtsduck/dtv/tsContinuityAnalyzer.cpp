@@ -48,7 +48,8 @@ ts::ContinuityAnalyzer::ContinuityAnalyzer(const PIDSet& pid_filter, Report* rep
     _fix_count(0),
     _error_count(0),
     _pid_filter(pid_filter),
-    _pid_states()
+    _pid_states(),
+    _headers()
 {
 }
 
@@ -193,10 +194,9 @@ ts::UString ts::ContinuityAnalyzer::linePrefix(PID pid) const
 // Detect / fix error on packet.
 //----------------------------------------------------------------------------
 
-bool ts::ContinuityAnalyzer::feedPacketInternal(TSPacket* pkt, bool update)
+bool ts::ContinuityAnalyzer::feedPacketInternal(TSPacket* pkt, bool update, PID pid, uint8_t cc, bool has_payload)
 {
     assert(pkt != nullptr);
-    const PID pid = pkt->getPID();
     bool result = true;
 
     // The null PID is never eligible for CC processing.
@@ -208,8 +208,6 @@ bool ts::ContinuityAnalyzer::feedPacketInternal(TSPacket* pkt, bool update)
 
         // Remember initial characteristics of the input packet.
         const uint8_t last_cc_in = new_pid ? INVALID_CC : state.last_pkt_in.getCC();
-        const uint8_t cc = pkt->getCC();
-        const bool has_payload = pkt->hasPayload();
         const bool has_discontinuity = pkt->getDiscontinuityIndicator();
         const bool duplicated = !new_pid && !has_discontinuity && pkt->isDuplicate(state.last_pkt_in);
 
@@ -286,3 +284,34 @@ bool ts::ContinuityAnalyzer::feedPacketInternal(TSPacket* pkt, bool update)
     _total_packets++;
     return result;
 }
+
+
+//----------------------------------------------------------------------------
+// Detect / fix errors on contiguous packets.
+//----------------------------------------------------------------------------
+
+bool ts::ContinuityAnalyzer::feedPacketsInternal(TSPacket* packets, size_t count, std::vector<bool>* status, bool update)
+{
+    // Extract all headers first. Packets from filtered-out PID's are then never accessed.
+    TSPacket::ExtractHeaders(packets, count, _headers);
+    if (status != nullptr) {
+        status->assign(count, true);
+    }
+
+    bool result = true;
+    for (size_t i = 0; i < count; ++i) {
+        const PID pid = _headers.pid[i];
+        if (pid != PID_NULL && _pid_filter.test(pid)) {
+            if (!feedPacketInternal(packets + i, update, pid, _headers.cc[i], _headers.hasPayload(i))) {
+                result = false;
+                if (status != nullptr) {
+                    (*status)[i] = false;
+                }
+            }
+        }
+        else {
+            _total_packets++;
+        }
+    }
+    return result;
+}
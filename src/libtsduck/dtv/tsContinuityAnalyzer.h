@@ -94,6 +94,36 @@ namespace ts {
         //!
         bool feedPacket(TSPacket& pkt) { return feedPacketInternal(&pkt, true); }
 
+        //!
+        //! Process contiguous constant TS packets.
+        //! This is equivalent to calling feedPacket() on each packet but the packet headers are
+        //! extracted in one bulk pass and the packets from non-processed PID's are not accessed.
+        //! @param [in] packets Address of the first TS packet.
+        //! @param [in] count Number of TS packets.
+        //! @param [out] status If not null, receive the result of feedPacket() for each packet.
+        //! @return True if no packet has a discontinuity error. False if at least one has an error.
+        //!
+        bool feedPackets(const TSPacket* packets, size_t count, std::vector<bool>* status = nullptr)
+        {
+            return feedPacketsInternal(const_cast<TSPacket*>(packets), count, status, false);
+        }
+
+        //!
+        //! Process or modify contiguous TS packets.
+        //! This is equivalent to calling feedPacket() on each packet but the packet headers are
+        //! extracted in one bulk pass and the packets from non-processed PID's are not accessed.
+        //! @param [in,out] packets Address of the first TS packet.
+        //! The packets can be modified only when error fixing or generator mode is activated.
+        //! @param [in] count Number of TS packets.
+        //! @param [out] status If not null, receive the result of feedPacket() for each packet.
+        //! @return True if all packets had no discontinuity error and are unmodified.
+        //! False if at least one packet had an error or was modified.
+        //!
+        bool feedPackets(TSPacket* packets, size_t count, std::vector<bool>* status = nullptr)
+        {
+            return feedPacketsInternal(packets, count, status, true);
+        }
+
         //!
         //! Get the total number of TS packets.
         //! @return The total number of TS packets.
@@ -269,10 +299,20 @@ namespace ts {
         PacketCounter _error_count;       // Number of discontinuity errors.
         PIDSet        _pid_filter;        // Current set of filtered PID's.
         PIDStateMap   _pid_states;        // State of all PID's.
+        TSPacketHeaders _headers;         // Extracted headers in feedPackets().
 
         // Internal version of feedPacket.
         // The packet is modified only is update is true.
-        bool feedPacketInternal(TSPacket* pkt, bool update);
+        bool feedPacketInternal(TSPacket* pkt, bool update)
+        {
+            return feedPacketInternal(pkt, update, pkt->getPID(), pkt->getCC(), pkt->hasPayload());
+        }
+
+        // Same with already extracted header fields.
+        bool feedPacketInternal(TSPacket* pkt, bool update, PID pid, uint8_t cc, bool has_payload);
+
+        // Internal version of feedPackets.
+        bool feedPacketsInternal(TSPacket* packets, size_t count, std::vector<bool>* status, bool update);
 
         // Build the first part of an error message.
         UString linePrefix(PID pid) const;
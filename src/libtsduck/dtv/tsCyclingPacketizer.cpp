@@ -50,7 +50,9 @@ ts::CyclingPacketizer::CyclingPacketizer(const DuckContext& duck, PID pid, Stuff
     _sched_packets(0),
     _current_cycle(1),
     _remain_in_cycle(0),
-    _cycle_end(UNDEFINED)
+    _cycle_end(UNDEFINED),
+    _use_templates(true),
+    _last_provided()
 {
 }
 
@@ -63,7 +65,8 @@ ts::CyclingPacketizer::SectionDesc::SectionDesc(const SectionPtr& sec, MilliSeco
     repetition(rep),
     last_packet(0),
     due_packet(0),
-    last_cycle(0)
+    last_cycle(0),
+    packets()
 {
 }
 
@@ -219,21 +222,42 @@ void ts::CyclingPacketizer::removeSections(SectionDescList& list, TID tid, uint1
 {
     SectionDescList::iterator it(list.begin());
     while (it != list.end()) {
-        const SectionDescPtr& sp(*it);
-        const Section& sect(*sp->section);
+        const Section& sect(*(*it)->section);
         if (sect.tableId() == tid && (!use_tid_ext || sect.tableIdExtension() == tid_ext)) {
             // Section match, remove it
-            assert(_section_count > 0);
-            _section_count--;
-            if (sp->last_cycle != _current_cycle) {
-                assert(_remain_in_cycle > 0);
-                _remain_in_cycle--;
-            }
-            if (scheduled) {
-                assert(_sched_packets >= sect.packetCount());
-                _sched_packets -= sect.packetCount();
-            }
-            it = list.erase(it);
+            it = removeSection(list, it, scheduled);
+        }
+        else {
+            ++it;
+        }
+    }
+}
+
+
+//----------------------------------------------------------------------------
+// Remove a set of sections, identified by their addresses.
+//----------------------------------------------------------------------------
+
+void ts::CyclingPacketizer::removeSections(const SectionPtrVector& sections)
+{
+    std::set<const Section*> addresses;
+    for (auto it = sections.begin(); it != sections.end(); ++it) {
+        if (!it->isNull()) {
+            addresses.insert(it->pointer());
+        }
+    }
+    if (!addresses.empty()) {
+        removeSections(_sched_sections, addresses, true);
+        removeSections(_other_sections, addresses, false);
+    }
+}
+
+void ts::CyclingPacketizer::removeSections(SectionDescList& list, const std::set<const Section*>& addresses, bool scheduled)
+{
+    SectionDescList::iterator it(list.begin());
+    while (it != list.end()) {
+        if (addresses.find((*it)->section.pointer()) != addresses.end()) {
+            it = removeSection(list, it, scheduled);
         }
         else {
             ++it;
@@ -242,6 +266,27 @@ void ts::CyclingPacketizer::removeSections(SectionDescList& list, TID tid, uint1
 }
 
 
+//----------------------------------------------------------------------------
+// Remove a section descriptor from the specified list, update counters.
+//----------------------------------------------------------------------------
+
+ts::CyclingPacketizer::SectionDescList::iterator ts::CyclingPacketizer::removeSection(SectionDescList& list, SectionDescList::iterator it, bool scheduled)
+{
+    const SectionDescPtr& sp(*it);
+    assert(_section_count > 0);
+    _section_count--;
+    if (sp->last_cycle != _current_cycle) {
+        assert(_remain_in_cycle > 0);
+        _remain_in_cycle--;
+    }
+    if (scheduled) {
+        assert(_sched_packets >= sp->section->packetCount());
+        _sched_packets -= sp->section->packetCount();
+    }
+    return list.erase(it);
+}
+
+
 //----------------------------------------------------------------------------
 // Remove all sections in the packetized.
 //----------------------------------------------------------------------------
@@ -253,6 +298,7 @@ void ts::CyclingPacketizer::removeAll()
     _sched_packets = 0;
     _sched_sections.clear();
     _other_sections.clear();
+    _last_provided.clear();
 }
 
 
@@ -375,6 +421,9 @@ void ts::CyclingPacketizer::provideSection(SectionCounter counter, SectionPtr& s
         _other_sections.push_back(sp);
     }
 
+    // Remember the provided section descriptor for sectionTemplate().
+    _last_provided = sp;
+
     if (sp.isNull()) {
         // No section to provide
         sect.clear();
@@ -413,6 +462,27 @@ bool ts::CyclingPacketizer::doStuffing()
 }
 
 
+//----------------------------------------------------------------------------
+// Get the precomputed packets of the section which was just provided.
+//----------------------------------------------------------------------------
+
+ts::Packetizer::PacketTemplatePtr ts::CyclingPacketizer::sectionTemplate(const SectionPtr& sect)
+{
+    // Packets can be reused only when the section is not packed with the next one.
+    if (!_use_templates || _last_provided.isNull() || _last_provided->section.pointer() != sect.pointer() || !doStuffing()) {
+        return PacketTemplatePtr();
+    }
+
+    // Build the packets the first time the section is packetized alone or when the PID has changed.
+    PacketTemplatePtr& packets(_last_provided->packets);
+    if (packets.isNull() || packets->empty() || packets->front().getPID() != getPID()) {
+        packets = new TSPacketVector;
+        BuildSectionPackets(*packets, getPID(), *sect);
+    }
+    return packets;
+}
+
+
 //----------------------------------------------------------------------------
 // Return true when the last generated packet was the last packet in the cycle.
 //----------------------------------------------------------------------------
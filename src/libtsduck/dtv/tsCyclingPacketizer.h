@@ -186,12 +186,36 @@ namespace ts {
         //!
         void removeSections(TID tid, uint16_t tid_ext);
 
+        //!
+        //! Remove a set of sections from the packetizer.
+        //! The sections are identified by their address, not by their content.
+        //! If a section is currently being packetized, its packetization continues.
+        //! @param [in] sections The sections to remove. Sections which are not in the packetizer are ignored.
+        //!
+        void removeSections(const SectionPtrVector& sections);
+
         //!
         //! Remove all sections in the packetizer.
         //! If a section is currently being packetized, the rest of the section will be packetized.
         //!
         void removeAll();
 
+        //!
+        //! Enable or disable the precomputed packet templates.
+        //! When enabled (the default), the TS packets of each section which is packetized alone
+        //! (with stuffing after it) are built once and reused in all subsequent cycles, only
+        //! the continuity counters are updated. The packets are rebuilt when the section or the
+        //! PID is changed. This is mostly useful with large tables which are cycled at high rates.
+        //! @param [in] on True to use packet templates, false to rebuild packets each time.
+        //!
+        void usePacketTemplates(bool on) { _use_templates = on; }
+
+        //!
+        //! Check if precomputed packet templates are used.
+        //! @return True if packet templates are used.
+        //!
+        bool packetTemplatesUsed() const { return _use_templates; }
+
         //!
         //! Get the number of stored sections to packetize.
         //! @return The number of stored sections to packetize.
@@ -224,6 +248,7 @@ namespace ts {
             PacketCounter  last_packet; // Packet index of last time the section was sent
             PacketCounter  due_packet;  // Packet index of next time
             SectionCounter last_cycle;  // Cycle index of last time the section was sent
+            PacketTemplatePtr packets;  // Precomputed packets when the section is packetized alone
 
             // Constructor
             SectionDesc(const SectionPtr& sec, MilliSecond rep);
@@ -251,6 +276,8 @@ namespace ts {
         SectionCounter  _current_cycle;   // Cycle number (start at 1, always increasing)
         size_t          _remain_in_cycle; // Number of unsent sections in this cycle
         SectionCounter  _cycle_end;       // At end of cycle, contains the index of last section
+        bool            _use_templates;   // Use precomputed packets for sections which are packetized alone
+        SectionDescPtr  _last_provided;   // Last provided section
 
         static const SectionCounter UNDEFINED = ~SectionCounter(0);
 
@@ -260,10 +287,19 @@ namespace ts {
         // Remove all sections with the specified tid/tid_ext in the specified list.
         void removeSections(SectionDescList&, TID, uint16_t tid_ext, bool use_tid_ext, bool scheduled);
 
+        // Remove all sections from a set of section addresses in the specified list.
+        void removeSections(SectionDescList&, const std::set<const Section*>&, bool scheduled);
+
+        // Remove a section descriptor from the specified list, update counters.
+        SectionDescList::iterator removeSection(SectionDescList&, SectionDescList::iterator, bool scheduled);
+
         // Inherited from SectionProviderInterface
         virtual void provideSection(SectionCounter, SectionPtr&) override;
         virtual bool doStuffing() override;
 
+        // Inherited from Packetizer
+        virtual PacketTemplatePtr sectionTemplate(const SectionPtr&) override;
+
         // Hide this method, we do not want the section provider to be replaced
         void setSectionProvider(SectionProviderInterface*);
     };
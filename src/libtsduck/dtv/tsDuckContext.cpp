@@ -48,6 +48,7 @@ ts::DuckContext::DuckContext(Report* report, std::ostream* output) :
     _outFile(),
     _charsetIn(&DVBCharTableSingleByte::DVB_ISO_6937),  // default DVB charset
     _charsetOut(&DVBCharTableSingleByte::DVB_ISO_6937),
+    _decodeCache(),
     _casId(CASID_NULL),
     _defaultPDS(0),
     _cmdStandards(Standards::NONE),
@@ -78,6 +79,8 @@ void ts::DuckContext::reset()
 
     _out = _initial_out;
     _charsetIn = _charsetOut = &DVBCharTableSingleByte::DVB_ISO_6937;
+    _decodeCache.setMaxEntries(0);
+    _decodeCache.clear();
     _casId = CASID_NULL;
     _defaultPDS = 0;
     _cmdStandards = _accStandards = Standards::NONE;
@@ -110,6 +113,25 @@ void ts::DuckContext::setDefaultCharsetOut(const Charset* charset)
 }
 
 
+//----------------------------------------------------------------------------
+// Convert signalization strings into UTF-16 using the default input charset.
+//----------------------------------------------------------------------------
+
+ts::UString ts::DuckContext::decoded(const uint8_t* data, size_t size) const
+{
+    UString str;
+    decode(str, data, size);
+    return str;
+}
+
+ts::UString ts::DuckContext::decodedWithByteLength(const uint8_t*& data, size_t& size) const
+{
+    UString str;
+    decodeWithByteLength(str, data, size);
+    return str;
+}
+
+
 //----------------------------------------------------------------------------
 // Update the list of standards which are present in the context.
 //----------------------------------------------------------------------------
@@ -368,6 +390,13 @@ void ts::DuckContext::defineOptions(Args& args, int cmdOptionsMask)
                   u"strings, which is not the case with some operators. Using this option, "
                   u"all DVB strings without explicit table code are assumed to use ISO-8859-15 "
                   u"instead of the standard ISO-6937 encoding.");
+
+        args.option(u"string-cache", 0, Args::UNSIGNED);
+        args.help(u"string-cache", u"count",
+                  u"Keep the specified number of recently decoded strings from tables and descriptors "
+                  u"in a cache. Tables such as EIT, SDT or NIT repeat the same event and service names "
+                  u"over and over. With this option, these names are decoded only once. "
+                  u"By default, there is no cache.");
     }
 
     // Options relating to default standards.
@@ -479,6 +508,9 @@ bool ts::DuckContext::loadArgs(Args& args)
                 }
             }
         }
+        if (args.present(u"string-cache")) {
+            _decodeCache.setMaxEntries(args.intValue<size_t>(u"string-cache"));
+        }
     }
 
     // Options relating to default UHF/VHF region.
@@ -539,6 +571,7 @@ ts::DuckContext::SavedArgs::SavedArgs() :
     _cmdStandards(Standards::NONE),
     _charsetInName(),
     _charsetOutName(),
+    _decodeCacheSize(0),
     _casId(CASID_NULL),
     _defaultPDS(0),
     _hfDefaultRegion()
@@ -551,6 +584,7 @@ void ts::DuckContext::saveArgs(SavedArgs& args) const
     args._cmdStandards = _cmdStandards;
     args._charsetInName = _charsetIn->name();
     args._charsetOutName = _charsetOut->name();
+    args._decodeCacheSize = _decodeCache.maxEntries();
     args._casId = _casId;
     args._defaultPDS = _defaultPDS;
     args._hfDefaultRegion = _hfDefaultRegion;
@@ -571,6 +605,7 @@ void ts::DuckContext::restoreArgs(const SavedArgs& args)
         if (out != nullptr) {
             _charsetOut = out;
         }
+        _decodeCache.setMaxEntries(args._decodeCacheSize);
     }
     if (_definedCmdOptions & CMD_CAS) {
         _casId = args._casId;
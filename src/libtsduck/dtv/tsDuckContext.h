@@ -36,6 +36,7 @@
 #include "tsUString.h"
 #include "tsByteBlock.h"
 #include "tsCharset.h"
+#include "tsDecodedStringCache.h"
 #include "tsStandards.h"
 #include "tsMPEG.h"
 
@@ -57,6 +58,7 @@ namespace ts {
     //! - Report for log and error messages.
     //! - Text output stream.
     //! - Default character sets (input and output).
+    //! - Optional cache of decoded strings.
     //! - Default CAS id.
     //! - Default Private Data Specifier (PDS) for DVB private descriptors.
     //! - Accumulated standards from the signalization (MPEG, DVB, ATSC, etc.)
@@ -166,6 +168,7 @@ namespace ts {
 
         //!
         //! Convert a signalization string into UTF-16 using the default input character set.
+        //! The cache of decoded strings is used when enabled.
         //! @param [out] str Returned decoded string.
         //! @param [in] data Address of an encoded string.
         //! @param [in] size Size in bytes of the encoded string.
@@ -174,23 +177,22 @@ namespace ts {
         //!
         bool decode(UString& str, const uint8_t* data, size_t size) const
         {
-            return _charsetIn->decode(str, data, size);
+            return _decodeCache.decode(_charsetIn, str, data, size);
         }
 
         //!
         //! Convert a signalization string into UTF-16 using the default input character set.
+        //! The cache of decoded strings is used when enabled.
         //! @param [in] data Address of a string in in binary representation (DVB or similar).
         //! @param [in] size Size in bytes of the string.
         //! @return The equivalent UTF-16 string. Stop on untranslatable character, if any.
         //! @see ETSI EN 300 468, Annex A.
         //!
-        UString decoded(const uint8_t* data, size_t size) const
-        {
-            return _charsetIn->decoded(data, size);
-        }
+        UString decoded(const uint8_t* data, size_t size) const;
 
         //!
         //! Convert a signalization string (preceded by its one-byte length) into UTF-16 using the default input character set.
+        //! The cache of decoded strings is used when enabled.
         //! @param [out] str Returned decoded string.
         //! @param [in,out] data Address of an encoded string. The address is updated to point after the decoded value.
         //! @param [in,out] size Size of the buffer. Updated to remaining size.
@@ -199,11 +201,12 @@ namespace ts {
         //!
         bool decodeWithByteLength(UString& str, const uint8_t*& data, size_t& size) const
         {
-            return _charsetIn->decodeWithByteLength(str, data, size);
+            return _decodeCache.decodeWithByteLength(_charsetIn, str, data, size);
         }
 
         //!
         //! Convert a signalization string (preceded by its one-byte length) into UTF-16 using the default input character set.
+        //! The cache of decoded strings is used when enabled.
         //! @param [in,out] data Address of a buffer containing a string to read.
         //! The first byte in the buffer is the length in bytes of the string.
         //! Upon return, @a buffer is updated to point after the end of the string.
@@ -213,10 +216,22 @@ namespace ts {
         //! @return The equivalent UTF-16 string. Stop on untranslatable character, if any.
         //! @see ETSI EN 300 468, Annex A.
         //!
-        UString decodedWithByteLength(const uint8_t*& data, size_t& size) const
-        {
-            return _charsetIn->decodedWithByteLength(data, size);
-        }
+        UString decodedWithByteLength(const uint8_t*& data, size_t& size) const;
+
+        //!
+        //! Set the maximum number of entries in the cache of decoded strings.
+        //! Tables such as EIT, SDT or NIT repeat the same strings over and over.
+        //! When the cache is enabled, the most recently decoded strings are kept
+        //! and reused instead of being decoded again.
+        //! @param [in] maxEntries Maximum number of cached strings. Zero disables the cache (the default).
+        //!
+        void setDecodeCacheSize(size_t maxEntries) { _decodeCache.setMaxEntries(maxEntries); }
+
+        //!
+        //! Get the cache of decoded strings, typically to get statistics.
+        //! @return A constant reference to the cache of decoded strings.
+        //!
+        const DecodedStringCache& decodeCache() const { return _decodeCache; }
 
         //!
         //! Encode an UTF-16 string into a signalization string using the preferred output character set.
@@ -371,7 +386,7 @@ namespace ts {
 
         //!
         //! Define character set command line options in an Args.
-        //! Defined options: @c -\-default-charset, @c -\-europe.
+        //! Defined options: @c -\-default-charset, @c -\-europe, @c -\-string-cache.
         //! The context keeps track of defined options so that loadOptions() can parse the appropriate options.
         //! @param [in,out] args Command line arguments to update.
         //!
@@ -431,6 +446,7 @@ namespace ts {
             Standards _cmdStandards;      // Forced standards from the command line.
             UString   _charsetInName;     // Character set to interpret strings without prefix code.
             UString   _charsetOutName;    // Preferred character set to generate strings.
+            size_t    _decodeCacheSize;   // Maximum number of entries in the cache of decoded strings.
             uint16_t  _casId;             // Preferred CAS id.
             PDS       _defaultPDS;        // Default PDS value if undefined.
             UString   _hfDefaultRegion;   // Default region for UHF/VHF band.
@@ -455,6 +471,7 @@ namespace ts {
         std::ofstream  _outFile;           // Open stream when redirected to a file by name.
         const Charset* _charsetIn;         // DVB character set to interpret strings without prefix code.
         const Charset* _charsetOut;        // Preferred DVB character set to generate strings.
+        mutable DecodedStringCache _decodeCache;  // Cache of decoded strings, updated by const decoding methods.
         uint16_t       _casId;             // Preferred CAS id.
         PDS            _defaultPDS;        // Default PDS value if undefined.
         Standards      _cmdStandards;      // Forced standards from the command line.
@@ -0,0 +1,700 @@
+//----------------------------------------------------------------------------
+//
+// TSDuck - The MPEG Transport Stream Toolkit
+// Copyright (c) 2005-2020, Thierry Lelegard
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+// THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------
+
+#include "tsEITGenerator.h"
+#include "tsDuckContext.h"
+#include "tsBCD.h"
+#include "tsMJD.h"
+TSDUCK_SOURCE;
+
+// Size of the fixed part of an EIT payload, before the event loop.
+#define EIT_PAYLOAD_FIXED_SIZE 6
+// Size of the fixed part of an event, before the descriptor loop.
+#define EIT_EVENT_FIXED_SIZE 12
+// Maximum size of the event loop in an EIT section.
+#define EIT_MAX_EVENTS_SIZE (MAX_PRIVATE_LONG_SECTION_PAYLOAD_SIZE - EIT_PAYLOAD_FIXED_SIZE)
+
+
+//----------------------------------------------------------------------------
+// Constructors and destructors.
+//----------------------------------------------------------------------------
+
+ts::EITGenerator::RepetitionProfile::RepetitionProfile() :
+    pf_actual(2000),
+    pf_other(10000),
+    schedule_prime(10000),
+    schedule_later(30000),
+    prime_days(1)
+{
+}
+
+ts::EITGenerator::Event::Event() :
+    event_id(0),
+    start(),
+    end(),
+    data()
+{
+}
+
+ts::EITGenerator::SubTable::SubTable() :
+    version(0),
+    sections()
+{
+}
+
+ts::EITGenerator::Service::Service() :
+    actual(true),
+    events(),
+    event_ids(),
+    segments(),
+    dirty_segments(),
+    schedule(),
+    dirty_tids(),
+    last_table_id(TID_NULL),
+    pf(),
+    present(),
+    following(),
+    pf_next_change(Time::Epoch),
+    rebuild_all(false)
+{
+}
+
+ts::EITGenerator::EITGenerator(DuckContext& duck, PID pid) :
+    _duck(duck),
+    _packetizer(duck, pid, CyclingPacketizer::ALWAYS),
+    _profile(),
+    _now(Time::Epoch),
+    _now_set(false),
+    _midnight(Time::Epoch),
+    _services(),
+    _dirty_services(),
+    _next_pf_change(Time::Epoch),
+    _serialized_segments(0),
+    _dropped_events(0)
+{
+}
+
+ts::EITGenerator::~EITGenerator()
+{
+}
+
+
+//----------------------------------------------------------------------------
+// Set the current time and the bitrate.
+//----------------------------------------------------------------------------
+
+void ts::EITGenerator::setCurrentTime(const Time& utc)
+{
+    _now = utc;
+    _now_set = true;
+}
+
+void ts::EITGenerator::setBitRate(BitRate bitrate)
+{
+    _packetizer.setBitRate(bitrate);
+}
+
+
+//----------------------------------------------------------------------------
+// Extract the service and events from an EIT section.
+//----------------------------------------------------------------------------
+
+bool ts::EITGenerator::GetEvents(const Section& section, ServiceIdTriplet& service, bool& actual, std::vector<EventPtr>& events)
+{
+    if (!section.isValid() || !EIT::IsEIT(section.tableId()) || section.payloadSize() < EIT_PAYLOAD_FIXED_SIZE) {
+        return false;
+    }
+
+    const uint8_t* data = section.payload();
+    size_t size = section.payloadSize();
+
+    service = ServiceIdTriplet(section.tableIdExtension(), GetUInt16(data), GetUInt16(data + 2));
+    actual = EIT::IsActual(section.tableId());
+    data += EIT_PAYLOAD_FIXED_SIZE;
+    size -= EIT_PAYLOAD_FIXED_SIZE;
+
+    while (size >= EIT_EVENT_FIXED_SIZE) {
+        const size_t event_size = std::min<size_t>(size, EIT_EVENT_FIXED_SIZE + (GetUInt16(data + 10) & 0x0FFF));
+        EventPtr ev(new Event);
+        ev->event_id = GetUInt16(data);
+        DecodeMJD(data + 2, 5, ev->start);
+        ev->end = ev->start + MilliSecPerSec * (DecodeBCD(data[7]) * 3600 + DecodeBCD(data[8]) * 60 + DecodeBCD(data[9]));
+        ev->data.copy(data, event_size);
+        events.push_back(ev);
+        data += event_size;
+        size -= event_size;
+    }
+    return true;
+}
+
+
+//----------------------------------------------------------------------------
+// Get or create a service.
+//----------------------------------------------------------------------------
+
+ts::EITGenerator::Service& ts::EITGenerator::getService(const ServiceIdTriplet& service, bool actual)
+{
+    ServicePtr& srv(_services[service]);
+    if (srv.isNull()) {
+        srv = new Service;
+        srv->actual = actual;
+    }
+    else if (srv->actual != actual) {
+        // Switching between actual and other: all table ids change.
+        srv->actual = actual;
+        srv->rebuild_all = true;
+        srv->pf_next_change = Time::Epoch;
+        _dirty_services.insert(service);
+    }
+    return *srv;
+}
+
+
+//----------------------------------------------------------------------------
+// Load events.
+//----------------------------------------------------------------------------
+
+bool ts::EITGenerator::loadEvents(const Section& section)
+{
+    ServiceIdTriplet service;
+    bool actual = true;
+    std::vector<EventPtr> events;
+
+    if (!GetEvents(section, service, actual, events)) {
+        return false;
+    }
+
+    Service& srv(getService(service, actual));
+    for (auto it = events.begin(); it != events.end(); ++it) {
+        storeEvent(service, srv, *it);
+    }
+    return true;
+}
+
+void ts::EITGenerator::loadEvents(const SectionPtrVector& sections)
+{
+    for (auto it = sections.begin(); it != sections.end(); ++it) {
+        if (!it->isNull()) {
+            loadEvents(**it);
+        }
+    }
+}
+
+void ts::EITGenerator::loadEvents(const BinaryTable& table)
+{
+    for (size_t i = 0; i < table.sectionCount(); ++i) {
+        if (!table.sectionAt(i).isNull()) {
+            loadEvents(*table.sectionAt(i));
+        }
+    }
+}
+
+
+//----------------------------------------------------------------------------
+// Replace the complete content of the event store.
+//----------------------------------------------------------------------------
+
+void ts::EITGenerator::replaceEvents(const SectionPtrVector& sections)
+{
+    // Load all new events and remember which events are present.
+    std::map<ServiceIdTriplet, std::set<uint16_t>> loaded;
+    for (auto it = sections.begin(); it != sections.end(); ++it) {
+        ServiceIdTriplet service;
+        bool actual = true;
+        std::vector<EventPtr> events;
+        if (!it->isNull() && GetEvents(**it, service, actual, events)) {
+            Service& srv(getService(service, actual));
+            std::set<uint16_t>& ids(loaded[service]);
+            for (auto ev = events.begin(); ev != events.end(); ++ev) {
+                storeEvent(service, srv, *ev);
+                ids.insert((*ev)->event_id);
+            }
+        }
+    }
+
+    // Remove the services and events which were not loaded.
+    for (auto srv = _services.begin(); srv != _services.end(); ) {
+        const auto ids(loaded.find(srv->first));
+        if (ids == loaded.end()) {
+            const ServiceIdTriplet service(srv->first);
+            ++srv;
+            removeService(service);
+        }
+        else {
+            for (auto ev = srv->second->events.begin(); ev != srv->second->events.end(); ) {
+                if (ids->second.find(ev->second->event_id) == ids->second.end()) {
+                    eraseEvent(srv->first, *srv->second, ev++);
+                }
+                else {
+                    ++ev;
+                }
+            }
+            ++srv;
+        }
+    }
+}
+
+
+//----------------------------------------------------------------------------
+// Add, replace or erase an event in a service.
+//----------------------------------------------------------------------------
+
+void ts::EITGenerator::storeEvent(const ServiceIdTriplet& service, Service& srv, const EventPtr& event)
+{
+    // Check if an event with the same id already exists.
+    const auto id(srv.event_ids.find(event->event_id));
+    if (id != srv.event_ids.end()) {
+        const auto old(srv.events.find(id->second));
+        if (old != srv.events.end()) {
+            if (old->second->start == event->start && old->second->data == event->data) {
+                // Same event, nothing to do.
+                return;
+            }
+            eraseEvent(service, srv, old);
+        }
+    }
+
+    // Replace any other event with the same start time.
+    const auto same(srv.events.find(event->start));
+    if (same != srv.events.end()) {
+        eraseEvent(service, srv, same);
+    }
+
+    srv.events[event->start] = event;
+    srv.event_ids[event->event_id] = event->start;
+    markEvent(service, srv, *event);
+}
+
+void ts::EITGenerator::eraseEvent(const ServiceIdTriplet& service, Service& srv, std::map<Time, EventPtr>::iterator it)
+{
+    markEvent(service, srv, *it->second);
+    srv.event_ids.erase(it->second->event_id);
+    srv.events.erase(it);
+}
+
+void ts::EITGenerator::markEvent(const ServiceIdTriplet& service, Service& srv, const Event& event)
+{
+    srv.dirty_segments.insert(AbsoluteSegment(event.start));
+    // Force a reevaluation of the EIT p/f of the service.
+    srv.pf_next_change = Time::Epoch;
+    _dirty_services.insert(service);
+}
+
+
+//----------------------------------------------------------------------------
+// Remove events or services.
+//----------------------------------------------------------------------------
+
+size_t ts::EITGenerator::removeEvents(const ServiceIdTriplet& service, const Time& start, const Time& end)
+{
+    const ServiceIdTriplet key(service.service_id, service.transport_stream_id, service.original_network_id);
+    const auto srv(_services.find(key));
+    size_t count = 0;
+    if (srv != _services.end()) {
+        auto it = srv->second->events.lower_bound(start);
+        while (it != srv->second->events.end() && it->first < end) {
+            eraseEvent(key, *srv->second, it++);
+            count++;
+        }
+    }
+    return count;
+}
+
+void ts::EITGenerator::removeService(const ServiceIdTriplet& service)
+{
+    const ServiceIdTriplet key(service.service_id, service.transport_stream_id, service.original_network_id);
+    const auto srv(_services.find(key));
+    if (srv != _services.end()) {
+        _packetizer.removeSections(srv->second->pf.sections);
+        for (auto it = srv->second->schedule.begin(); it != srv->second->schedule.end(); ++it) {
+            _packetizer.removeSections(it->second.sections);
+        }
+        _services.erase(srv);
+        _dirty_services.erase(key);
+    }
+}
+
+void ts::EITGenerator::reset()
+{
+    _packetizer.removeAll();
+    _services.clear();
+    _dirty_services.clear();
+    _next_pf_change = Time::Epoch;
+}
+
+
+//----------------------------------------------------------------------------
+// Get the number of events in the store.
+//----------------------------------------------------------------------------
+
+size_t ts::EITGenerator::eventCount() const
+{
+    size_t count = 0;
+    for (auto it = _services.begin(); it != _services.end(); ++it) {
+        count += it->second->events.size();
+    }
+    return count;
+}
+
+
+//----------------------------------------------------------------------------
+// Update the reference midnight from the current time.
+//----------------------------------------------------------------------------
+
+bool ts::EITGenerator::updateMidnight()
+{
+    const Time midnight(_now.thisDay());
+    if (midnight == _midnight) {
+        return false;
+    }
+    else {
+        _midnight = midnight;
+        return true;
+    }
+}
+
+
+//----------------------------------------------------------------------------
+// Apply all pending updates to the generated sections.
+//----------------------------------------------------------------------------
+
+void ts::EITGenerator::regenerate()
+{
+    if (!_now_set) {
+        _now = Time::CurrentUTC();
+    }
+    const bool new_day = updateMidnight();
+
+    if (new_day || _now >= _next_pf_change) {
+        // Check all services, at least for their EIT p/f.
+        _next_pf_change = Time::Apocalypse;
+        for (auto it = _services.begin(); it != _services.end(); ++it) {
+            regenerateService(it->first, *it->second, new_day);
+            _next_pf_change = std::min(_next_pf_change, it->second->pf_next_change);
+        }
+    }
+    else {
+        // Only check modified services.
+        for (auto it = _dirty_services.begin(); it != _dirty_services.end(); ++it) {
+            const auto srv(_services.find(*it));
+            if (srv != _services.end()) {
+                regenerateService(srv->first, *srv->second, false);
+                _next_pf_change = std::min(_next_pf_change, srv->second->pf_next_change);
+            }
+        }
+    }
+    _dirty_services.clear();
+}
+
+
+//----------------------------------------------------------------------------
+// Regenerate one service.
+//----------------------------------------------------------------------------
+
+void ts::EITGenerator::regenerateService(const ServiceIdTriplet& service, Service& srv, bool new_day)
+{
+    const size_t first_segment = AbsoluteSegment(_midnight);
+    const size_t end_segment = first_segment + EIT::SEGMENTS_COUNT;
+    const TID base_tid = srv.actual ? TID_EIT_S_ACT_MIN : TID_EIT_S_OTH_MIN;
+
+    if (new_day) {
+        // Purge the events which ended before the new midnight and their segments.
+        while (!srv.events.empty() && srv.events.begin()->second->end <= _midnight) {
+            srv.event_ids.erase(srv.events.begin()->second->event_id);
+            srv.events.erase(srv.events.begin());
+        }
+        srv.segments.erase(srv.segments.begin(), srv.segments.lower_bound(first_segment));
+        // All segments are shifted, all sub-tables must be rebuilt.
+        srv.rebuild_all = true;
+    }
+
+    // Serialize the modified segments.
+    for (auto seg = srv.dirty_segments.begin(); seg != srv.dirty_segments.end(); ++seg) {
+        if (*seg >= first_segment) {
+            serializeSegment(srv, *seg);
+            if (*seg < end_segment) {
+                srv.dirty_tids.insert(EIT::SegmentToTableId(srv.actual, *seg - first_segment));
+            }
+        }
+    }
+    srv.dirty_segments.clear();
+
+    // Find the last segment with events in the schedule period.
+    auto last = srv.segments.lower_bound(end_segment);
+    const bool has_schedule = last != srv.segments.begin() && (--last)->first >= first_segment;
+    const TID last_tid = has_schedule ? EIT::SegmentToTableId(srv.actual, last->first - first_segment) : TID(TID_NULL);
+
+    // When the last table id changes, the last_table_id field must be updated in all sub-tables.
+    if (srv.rebuild_all || last_tid != srv.last_table_id) {
+        if (srv.rebuild_all) {
+            // Table ids may have switched between actual and other, remove all previous sections.
+            for (auto it = srv.schedule.begin(); it != srv.schedule.end(); ++it) {
+                _packetizer.removeSections(it->second.sections);
+                it->second.sections.clear();
+            }
+        }
+        srv.dirty_tids.clear();
+        if (has_schedule) {
+            for (TID tid = base_tid; tid <= last_tid; ++tid) {
+                srv.dirty_tids.insert(tid);
+            }
+        }
+        srv.last_table_id = last_tid;
+    }
+
+    // Remove sub-tables after the last one.
+    for (auto it = srv.schedule.begin(); it != srv.schedule.end(); ) {
+        if (!has_schedule || it->first < base_tid || it->first > last_tid) {
+            _packetizer.removeSections(it->second.sections);
+            it = srv.schedule.erase(it);
+        }
+        else {
+            ++it;
+        }
+    }
+
+    // Rebuild the modified sub-tables.
+    for (auto it = srv.dirty_tids.begin(); it != srv.dirty_tids.end(); ++it) {
+        if (has_schedule && *it >= base_tid && *it <= last_tid) {
+            rebuildSchedule(service, srv, *it);
+        }
+    }
+    srv.dirty_tids.clear();
+
+    // Reevaluate the EIT p/f when necessary.
+    if (srv.rebuild_all || _now >= srv.pf_next_change) {
+        EventPtr present;
+        EventPtr following;
+        auto next = srv.events.upper_bound(_now);
+        if (next != srv.events.begin()) {
+            auto prev = next;
+            if ((--prev)->second->end > _now) {
+                present = prev->second;
+            }
+        }
+        if (next != srv.events.end()) {
+            following = next->second;
+        }
+
+        // Next time the p/f may change: end of present event or start of following event.
+        srv.pf_next_change = Time::Apocalypse;
+        if (!present.isNull()) {
+            srv.pf_next_change = present->end;
+        }
+        if (!following.isNull()) {
+            srv.pf_next_change = std::min(srv.pf_next_change, following->start);
+        }
+
+        // Rebuild the sections only when the events have changed.
+        if (srv.rebuild_all || srv.pf.sections.empty() || present.pointer() != srv.present.pointer() || following.pointer() != srv.following.pointer()) {
+            srv.present = present;
+            srv.following = following;
+            rebuildPresentFollowing(service, srv);
+        }
+    }
+
+    srv.rebuild_all = false;
+}
+
+
+//----------------------------------------------------------------------------
+// Serialize the event loops of one segment.
+//----------------------------------------------------------------------------
+
+void ts::EITGenerator::serializeSegment(Service& srv, size_t segment)
+{
+    const Time start(Time::Epoch + MilliSecond(segment) * EIT::SEGMENT_DURATION);
+    const Time end(start + EIT::SEGMENT_DURATION);
+    std::vector<ByteBlock> loops;
+    size_t dropped = 0;
+
+    for (auto it = srv.events.lower_bound(start); it != srv.events.end() && it->first < end; ++it) {
+        const ByteBlock& data(it->second->data);
+        if (loops.empty() || loops.back().size() + data.size() > EIT_MAX_EVENTS_SIZE) {
+            if (loops.size() >= EIT::SECTIONS_PER_SEGMENT) {
+                // Too many events in that segment, drop this event.
+                dropped++;
+                continue;
+            }
+            loops.push_back(ByteBlock());
+        }
+        loops.back().append(data);
+    }
+
+    if (dropped > 0) {
+        _dropped_events += dropped;
+        _duck.report().warning(u"EIT schedule segment starting at %s: %d events dropped, more than %d sections", {start.format(Time::DATETIME), dropped, size_t(EIT::SECTIONS_PER_SEGMENT)});
+    }
+
+    if (loops.empty()) {
+        srv.segments.erase(segment);
+    }
+    else {
+        srv.segments[segment].swap(loops);
+    }
+    _serialized_segments++;
+}
+
+
+//----------------------------------------------------------------------------
+// Rebuild all sections of one EIT schedule sub-table.
+//----------------------------------------------------------------------------
+
+void ts::EITGenerator::rebuildSchedule(const ServiceIdTriplet& service, Service& srv, TID tid)
+{
+    const size_t first_segment = AbsoluteSegment(_midnight);
+    const TID base_tid = srv.actual ? TID_EIT_S_ACT_MIN : TID_EIT_S_OTH_MIN;
+    const size_t first_rel = size_t(tid - base_tid) * EIT::SEGMENTS_PER_TABLE;
+    const size_t last_abs = (--srv.segments.lower_bound(first_segment + EIT::SEGMENTS_COUNT))->first;
+    const size_t last_rel = std::min(first_rel + EIT::SEGMENTS_PER_TABLE, last_abs - first_segment + 1) - 1;
+    const ByteBlock empty;
+
+    SubTable& sub(srv.schedule[tid]);
+    sub.version = (sub.version + 1) & 0x1F;
+
+    // The last section of the sub-table is in the last segment.
+    const auto last_seg(srv.segments.find(first_segment + last_rel));
+    const size_t last_count = last_seg == srv.segments.end() ? 1 : last_seg->second.size();
+    const uint8_t last_section_number = uint8_t(EIT::SegmentToSection(last_rel) + last_count - 1);
+
+    SectionPtrVector sections;
+    std::vector<MilliSecond> rates;
+    for (size_t rel = first_rel; rel <= last_rel; ++rel) {
+        const MilliSecond rate = rel < _profile.prime_days * 8 ? _profile.schedule_prime : _profile.schedule_later;
+        const auto seg(srv.segments.find(first_segment + rel));
+        const size_t count = seg == srv.segments.end() ? 1 : seg->second.size();
+        const uint8_t first_section = EIT::SegmentToSection(rel);
+        for (size_t i = 0; i < count; ++i) {
+            sections.push_back(BuildSection(tid, service, sub.version, uint8_t(first_section + i), last_section_number,
+                                            uint8_t(first_section + count - 1), srv.last_table_id,
+                                            seg == srv.segments.end() ? empty : seg->second[i]));
+            rates.push_back(rate);
+        }
+    }
+    replaceSections(sub, sections, rates);
+}
+
+
+//----------------------------------------------------------------------------
+// Rebuild the EIT p/f sub-table of a service.
+//----------------------------------------------------------------------------
+
+void ts::EITGenerator::rebuildPresentFollowing(const ServiceIdTriplet& service, Service& srv)
+{
+    SectionPtrVector sections;
+    std::vector<MilliSecond> rates;
+
+    // Without event in the service, there is no EIT p/f.
+    if (!srv.events.empty()) {
+        const TID tid = srv.actual ? TID_EIT_PF_ACT : TID_EIT_PF_OTH;
+        const MilliSecond rate = srv.actual ? _profile.pf_actual : _profile.pf_other;
+        const ByteBlock empty;
+        srv.pf.version = (srv.pf.version + 1) & 0x1F;
+        sections.push_back(BuildSection(tid, service, srv.pf.version, 0, 1, 1, tid, srv.present.isNull() ? empty : srv.present->data));
+        sections.push_back(BuildSection(tid, service, srv.pf.version, 1, 1, 1, tid, srv.following.isNull() ? empty : srv.following->data));
+        rates.push_back(rate);
+        rates.push_back(rate);
+    }
+    replaceSections(srv.pf, sections, rates);
+}
+
+
+//----------------------------------------------------------------------------
+// Replace the sections of a sub-table in the packetizer.
+//----------------------------------------------------------------------------
+
+void ts::EITGenerator::replaceSections(SubTable& sub, const SectionPtrVector& sections, const std::vector<MilliSecond>& rates)
+{
+    _packetizer.removeSections(sub.sections);
+    for (size_t i = 0; i < sections.size(); ++i) {
+        _packetizer.addSection(sections[i], rates[i]);
+    }
+    sub.sections = sections;
+}
+
+
+//----------------------------------------------------------------------------
+// Build one EIT section.
+//----------------------------------------------------------------------------
+
+ts::SectionPtr ts::EITGenerator::BuildSection(TID tid, const ServiceIdTriplet& service, uint8_t version, uint8_t section_number,
+                                              uint8_t last_section_number, uint8_t segment_last_section_number, TID last_table_id,
+                                              const ByteBlock& events)
+{
+    ByteBlockPtr section_data(new ByteBlock(LONG_SECTION_HEADER_SIZE + EIT_PAYLOAD_FIXED_SIZE + events.size() + SECTION_CRC32_SIZE));
+    CheckNonNull(section_data.pointer());
+    uint8_t* data = section_data->data();
+
+    // Section header.
+    PutUInt8(data, tid);
+    PutUInt16(data + 1, 0xF000 | uint16_t(section_data->size() - 3));
+    PutUInt16(data + 3, service.service_id);
+    PutUInt8(data + 5, 0xC1 | uint8_t((version & 0x1F) << 1));
+    PutUInt8(data + 6, section_number);
+    PutUInt8(data + 7, last_section_number);
+
+    // EIT section payload.
+    PutUInt16(data + 8, service.transport_stream_id);
+    PutUInt16(data + 10, service.original_network_id);
+    PutUInt8(data + 12, segment_last_section_number);
+    PutUInt8(data + 13, last_table_id);
+    if (!events.empty()) {
+        ::memcpy(data + 14, events.data(), events.size());  // Flawfinder: ignore: memcpy()
+    }
+
+    return new Section(section_data, PID_NULL, CRC32::COMPUTE);
+}
+
+
+//----------------------------------------------------------------------------
+// Build the next TS packet of the EIT PID.
+//----------------------------------------------------------------------------
+
+bool ts::EITGenerator::getNextPacket(TSPacket& packet)
+{
+    regenerate();
+    return _packetizer.getNextPacket(packet);
+}
+
+
+//----------------------------------------------------------------------------
+// Get all generated sections.
+//----------------------------------------------------------------------------
+
+void ts::EITGenerator::getSections(SectionPtrVector& sections)
+{
+    regenerate();
+    sections.clear();
+    for (auto srv = _services.begin(); srv != _services.end(); ++srv) {
+        sections.insert(sections.end(), srv->second->pf.sections.begin(), srv->second->pf.sections.end());
+        for (auto sub = srv->second->schedule.begin(); sub != srv->second->schedule.end(); ++sub) {
+            sections.insert(sections.end(), sub->second.sections.begin(), sub->second.sections.end());
+        }
+    }
+}
@@ -0,0 +1,327 @@
+//----------------------------------------------------------------------------
+//
+// TSDuck - The MPEG Transport Stream Toolkit
+// Copyright (c) 2005-2020, Thierry Lelegard
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+// THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------
+//!
+//!  @file
+//!  Incremental generator of EIT p/f and EIT schedule.
+//!
+//----------------------------------------------------------------------------
+
+#pragma once
+#include "tsCyclingPacketizer.h"
+#include "tsServiceIdTriplet.h"
+#include "tsEIT.h"
+#include "tsTime.h"
+#include "tsReport.h"
+
+namespace ts {
+    //!
+    //! Incremental generator of EIT p/f and EIT schedule.
+    //! @ingroup mpeg
+    //!
+    //! The generator keeps a store of events which is indexed by service and start time.
+    //! From this store, EIT p/f and EIT schedule sections are generated according to
+    //! ETSI TS 101 211: one EIT p/f sub-table per service with one present and one following
+    //! section, EIT schedule organized in 3-hour segments starting from the last midnight.
+    //!
+    //! Unlike EIT::ReorganizeSections() which rebuilds all sections from scratch, the generator
+    //! only serializes the segments which are touched by an update. Since the version number
+    //! applies to a complete sub-table, the other sections of a modified sub-table are rebuilt
+    //! from their cached event loops with the new version. The sections of the unmodified
+    //! sub-tables are not touched at all and continue to be cycled by the packetizer.
+    //!
+    //! The EIT p/f are automatically updated when the current time moves from one event to
+    //! the next one. The EIT schedule are shifted when the current time crosses midnight.
+    //!
+    //! The generated sections are cycled in an internal CyclingPacketizer. When a bitrate is
+    //! set, the repetition rates of RepetitionProfile are applied.
+    //!
+    class TSDUCKDLL EITGenerator
+    {
+        TS_NOBUILD_NOCOPY(EITGenerator);
+    public:
+        //!
+        //! Repetition rates of EIT sections.
+        //! The default values are the minimum repetition rates for satellite and cable
+        //! from ETSI TS 101 211, section 4.4.
+        //!
+        struct TSDUCKDLL RepetitionProfile
+        {
+            MilliSecond pf_actual;       //!< Repetition rate of EIT p/f actual.
+            MilliSecond pf_other;        //!< Repetition rate of EIT p/f other.
+            MilliSecond schedule_prime;  //!< Repetition rate of EIT schedule for the first @a prime_days.
+            MilliSecond schedule_later;  //!< Repetition rate of EIT schedule after the first @a prime_days.
+            size_t      prime_days;      //!< Number of days in the "prime" period of EIT schedule.
+            //!
+            //! Default constructor.
+            //!
+            RepetitionProfile();
+        };
+
+        //!
+        //! Constructor.
+        //! @param [in,out] duck TSDuck execution context. The reference is kept inside this object.
+        //! @param [in] pid The PID on which the EIT's are generated.
+        //!
+        explicit EITGenerator(DuckContext& duck, PID pid = PID_EIT);
+
+        //!
+        //! Destructor.
+        //!
+        virtual ~EITGenerator();
+
+        //!
+        //! Set the current time in the stream.
+        //! This time is used to select the present and following events and the reference
+        //! midnight of the EIT schedule. Events which ended before the last midnight are purged.
+        //! When the current time is never set, the system time is used.
+        //! @param [in] utc Current UTC time (or JST time in Japan).
+        //!
+        void setCurrentTime(const Time& utc);
+
+        //!
+        //! Get the current time in the stream.
+        //! @return The current time in the stream.
+        //!
+        Time currentTime() const { return _now; }
+
+        //!
+        //! Set the bitrate of the generated PID.
+        //! @param [in] bitrate The bitrate of the EIT PID. When zero, the repetition rates are ignored
+        //! and all sections are cycled in sequence.
+        //!
+        void setBitRate(BitRate bitrate);
+
+        //!
+        //! Set the repetition rates of the generated sections.
+        //! Only the sections which are generated after this call use the new profile.
+        //! @param [in] profile The new repetition profile.
+        //!
+        void setRepetitionProfile(const RepetitionProfile& profile) { _profile = profile; }
+
+        //!
+        //! Load or update the events from an EIT section.
+        //! An event with the same event id as an existing event in the same service replaces it.
+        //! When the new event is identical to the existing one, nothing is regenerated.
+        //! @param [in] section An EIT section, p/f or schedule, actual or other.
+        //! @return True on success, false if this is not a valid EIT section.
+        //!
+        bool loadEvents(const Section& section);
+
+        //!
+        //! Load or update the events from a list of EIT sections.
+        //! Non-EIT sections are ignored.
+        //! @param [in] sections A list of sections.
+        //!
+        void loadEvents(const SectionPtrVector& sections);
+
+        //!
+        //! Load or update the events from an EIT.
+        //! @param [in] table A binary EIT.
+        //!
+        void loadEvents(const BinaryTable& table);
+
+        //!
+        //! Replace the complete content of the event store with the events from a list of EIT sections.
+        //! The events which are not in the list are removed. The events which are unchanged are not
+        //! regenerated. This is typically used when a complete EPG is periodically reloaded.
+        //! @param [in] sections A list of sections. Non-EIT sections are ignored.
+        //!
+        void replaceEvents(const SectionPtrVector& sections);
+
+        //!
+        //! Remove the events of a service which start in a given time range.
+        //! @param [in] service The service, the version field is ignored.
+        //! @param [in] start Start of time range (inclusive).
+        //! @param [in] end End of time range (exclusive).
+        //! @return The number of removed events.
+        //!
+        size_t removeEvents(const ServiceIdTriplet& service, const Time& start = Time::Epoch, const Time& end = Time::Apocalypse);
+
+        //!
+        //! Remove a service and all its events.
+        //! @param [in] service The service, the version field is ignored.
+        //!
+        void removeService(const ServiceIdTriplet& service);
+
+        //!
+        //! Remove all events, all services and all generated sections.
+        //!
+        void reset();
+
+        //!
+        //! Apply all pending updates to the generated sections.
+        //! This method is automatically invoked by getNextPacket(). It can be explicitly
+        //! invoked to control the moment when the sections are regenerated.
+        //!
+        void regenerate();
+
+        //!
+        //! Build the next TS packet of the EIT PID.
+        //! @param [out] packet The next TS packet.
+        //! @return True if a real packet is returned, false if a null packet was returned.
+        //!
+        bool getNextPacket(TSPacket& packet);
+
+        //!
+        //! Get all generated sections, after applying the pending updates.
+        //! @param [out] sections The generated sections, sorted by service, table id and section number.
+        //!
+        void getSections(SectionPtrVector& sections);
+
+        //!
+        //! Get the number of events in the store.
+        //! @return The number of events in the store.
+        //!
+        size_t eventCount() const;
+
+        //!
+        //! Get the number of EIT schedule segments which were serialized since the creation of the object.
+        //! This is mostly useful to check that updates are incremental.
+        //! @return The number of serialized segments.
+        //!
+        size_t serializedSegmentCount() const { return _serialized_segments; }
+
+        //!
+        //! Get the number of events which were dropped since the creation of the object.
+        //! An EIT schedule segment is limited to EIT::SECTIONS_PER_SEGMENT sections. The events
+        //! which do not fit in the sections of their segment are not generated. They remain in
+        //! the store and are counted each time their segment is serialized.
+        //! @return The number of dropped events.
+        //!
+        size_t droppedEventCount() const { return _dropped_events; }
+
+        //!
+        //! Set the PID on which the EIT's are generated.
+        //! @param [in] pid The new PID.
+        //!
+        void setPID(PID pid) { _packetizer.setPID(pid); }
+
+        //!
+        //! Get the internal packetizer.
+        //! @return A constant reference to the internal packetizer.
+        //!
+        const CyclingPacketizer& packetizer() const { return _packetizer; }
+
+    private:
+        // Description of an event in the store.
+        struct Event
+        {
+            uint16_t  event_id;  // Event id.
+            Time      start;     // Start time.
+            Time      end;       // End time.
+            ByteBlock data;      // Binary event data, from event_id to end of descriptor loop.
+            Event();
+        };
+        typedef SafePtr<Event> EventPtr;
+
+        // Description of an EIT sub-table (p/f or one schedule table id) in a service.
+        struct SubTable
+        {
+            uint8_t          version;   // Last version of the sub-table.
+            SectionPtrVector sections;  // Current sections in the packetizer.
+            SubTable();
+        };
+
+        // Description of a service.
+        class Service
+        {
+            TS_NOCOPY(Service);
+        public:
+            Service();
+            bool                                    actual;         // Generate EIT actual (or other).
+            std::map<Time, EventPtr>                events;         // Events, indexed by start time.
+            std::map<uint16_t, Time>                event_ids;      // Event id to start time.
+            std::map<size_t, std::vector<ByteBlock>> segments;      // Cached event loops per section, indexed by absolute segment.
+            std::set<size_t>                        dirty_segments; // Absolute segments to serialize again.
+            std::map<TID, SubTable>                 schedule;       // EIT schedule sub-tables, indexed by table id.
+            std::set<TID>                           dirty_tids;     // Schedule table ids to rebuild.
+            TID                                     last_table_id;  // Current last_table_id in EIT schedule.
+            SubTable                                pf;             // EIT p/f sub-table.
+            EventPtr                                present;        // Current present event.
+            EventPtr                                following;      // Current following event.
+            Time                                    pf_next_change; // Next time the p/f must be reevaluated.
+            bool                                    rebuild_all;    // All sub-tables must be rebuilt.
+        };
+        typedef SafePtr<Service> ServicePtr;
+        typedef std::map<ServiceIdTriplet, ServicePtr> ServiceMap;
+
+        DuckContext&      _duck;
+        CyclingPacketizer _packetizer;
+        RepetitionProfile _profile;
+        Time              _now;                  // Current time in the stream.
+        bool              _now_set;              // Current time was explicitly set.
+        Time              _midnight;             // Reference midnight of EIT schedule.
+        ServiceMap        _services;             // All services, the version field of the key is always zero.
+        std::set<ServiceIdTriplet> _dirty_services; // Services with pending updates.
+        Time              _next_pf_change;       // Next time an EIT p/f must be reevaluated in any service.
+        size_t            _serialized_segments;  // Number of serialized EIT schedule segments.
+        size_t            _dropped_events;       // Number of events which did not fit in their segment.
+
+        // Extract the service and events from an EIT section. Return false if not a valid EIT section.
+        static bool GetEvents(const Section& section, ServiceIdTriplet& service, bool& actual, std::vector<EventPtr>& events);
+
+        // Get or create a service.
+        Service& getService(const ServiceIdTriplet& service, bool actual);
+
+        // Absolute segment number of a time.
+        static size_t AbsoluteSegment(const Time& t) { return size_t((t - Time::Epoch) / EIT::SEGMENT_DURATION); }
+
+        // Add or replace an event in a service, mark modified parts as dirty.
+        void storeEvent(const ServiceIdTriplet& service, Service& srv, const EventPtr& event);
+
+        // Remove an event from a service, mark modified parts as dirty.
+        void eraseEvent(const ServiceIdTriplet& service, Service& srv, std::map<Time, EventPtr>::iterator it);
+
+        // Mark the segment of an event as modified.
+        void markEvent(const ServiceIdTriplet& service, Service& srv, const Event& event);
+
+        // Update the reference midnight from the current time. Return true when changed.
+        bool updateMidnight();
+
+        // Regenerate one service.
+        void regenerateService(const ServiceIdTriplet& service, Service& srv, bool new_day);
+
+        // Serialize the event loops of one segment.
+        void serializeSegment(Service& srv, size_t segment);
+
+        // Rebuild all sections of one EIT schedule sub-table.
+        void rebuildSchedule(const ServiceIdTriplet& service, Service& srv, TID tid);
+
+        // Rebuild the EIT p/f sub-table of a service.
+        void rebuildPresentFollowing(const ServiceIdTriplet& service, Service& srv);
+
+        // Replace the sections of a sub-table in the packetizer.
+        void replaceSections(SubTable& sub, const SectionPtrVector& sections, const std::vector<MilliSecond>& rates);
+
+        // Build one EIT section.
+        static SectionPtr BuildSection(TID tid, const ServiceIdTriplet& service, uint8_t version, uint8_t section_number,
+                                       uint8_t last_section_number, uint8_t segment_last_section_number, TID last_table_id,
+                                       const ByteBlock& events);
+    };
+}
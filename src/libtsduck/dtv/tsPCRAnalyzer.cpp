@@ -36,6 +36,11 @@
 #include "tsUString.h"
 TSDUCK_SOURCE;
 
+#if defined(TS_NEED_STATIC_CONST_DEFINITIONS)
+constexpr size_t ts::PCRAnalyzer::WINDOW_PCR_COUNT;
+constexpr size_t ts::PCRAnalyzer::FOOLPROOF_PCR_LIMIT;
+#endif
+
 
 //----------------------------------------------------------------------------
 // Constructor
@@ -59,7 +64,10 @@ ts::PCRAnalyzer::PCRAnalyzer(size_t min_pid, size_t min_pcr) :
     _pcr_pids(0),
     _discontinuities(0),
     _pid(),
-    _packet_pcr_index_map()
+    _pcr_pid_list(),
+    _last_pcrs(),
+    _last_pcrs_first(0),
+    _last_pcrs_count(0)
 {
     TS_ZERO(_pid);
 }
@@ -86,11 +94,115 @@ ts::PCRAnalyzer::PIDAnalysis::PIDAnalysis() :
     last_pcr_packet(0),
     ts_bitrate_188(0),
     ts_bitrate_204(0),
-    ts_bitrate_cnt(0)
+    ts_bitrate_cnt(0),
+    pcr_unwrapped(0),
+    window()
 {
 }
 
 
+//----------------------------------------------------------------------------
+// Sliding window of PCR's with incremental least-squares regression.
+//----------------------------------------------------------------------------
+
+ts::PCRAnalyzer::PCRWindow::PCRWindow() :
+    _samples(),
+    _first(0),
+    _count(0),
+    _adds(0),
+    _pcr0(0),
+    _packet0(0),
+    _sx(0.0),
+    _sy(0.0),
+    _sxx(0.0),
+    _sxy(0.0)
+{
+}
+
+void ts::PCRAnalyzer::PCRWindow::clear()
+{
+    _first = _count = _adds = 0;
+    _pcr0 = _packet0 = 0;
+    _sx = _sy = _sxx = _sxy = 0.0;
+}
+
+void ts::PCRAnalyzer::PCRWindow::add(uint64_t pcr, uint64_t packet)
+{
+    // The buffer is allocated on first use, only on PID's with PCR's.
+    if (_samples.empty()) {
+        _samples.resize(WINDOW_PCR_COUNT);
+    }
+
+    // Remove the oldest sample from the sums when the window is full.
+    if (_count >= _samples.size()) {
+        const double x = double(_samples[_first].pcr - _pcr0);
+        const double y = double(_samples[_first].packet - _packet0);
+        _sx -= x;
+        _sy -= y;
+        _sxx -= x * x;
+        _sxy -= x * y;
+        _first = (_first + 1) % _samples.size();
+        _count--;
+    }
+
+    // The first sample is the initial anchor.
+    if (_count == 0) {
+        _pcr0 = pcr;
+        _packet0 = packet;
+    }
+
+    // Add the new sample.
+    Sample& smp(_samples[(_first + _count++) % _samples.size()]);
+    smp.pcr = pcr;
+    smp.packet = packet;
+    const double x = double(pcr - _pcr0);
+    const double y = double(packet - _packet0);
+    _sx += x;
+    _sy += y;
+    _sxx += x * x;
+    _sxy += x * y;
+
+    // Once all samples have been replaced, move the anchor. This keeps the relative
+    // values small and drops the rounding errors of the incremental updates.
+    // The cost of the recomputation is amortized over the window size.
+    if (++_adds >= _samples.size()) {
+        rebase();
+    }
+}
+
+void ts::PCRAnalyzer::PCRWindow::rebase()
+{
+    _adds = 0;
+    _sx = _sy = _sxx = _sxy = 0.0;
+    if (_count > 0) {
+        _pcr0 = _samples[_first].pcr;
+        _packet0 = _samples[_first].packet;
+        for (size_t i = 0; i < _count; ++i) {
+            const Sample& smp(_samples[(_first + i) % _samples.size()]);
+            const double x = double(smp.pcr - _pcr0);
+            const double y = double(smp.packet - _packet0);
+            _sx += x;
+            _sy += y;
+            _sxx += x * x;
+            _sxy += x * y;
+        }
+    }
+}
+
+bool ts::PCRAnalyzer::PCRWindow::slope(double& packets_per_pcr) const
+{
+    const double n = double(_count);
+    const double denominator = n * _sxx - _sx * _sx;
+    if (_count < 2 || denominator <= 0.0) {
+        return false;
+    }
+    else {
+        packets_per_pcr = (n * _sxy - _sx * _sy) / denominator;
+        return true;
+    }
+}
+
+
 //----------------------------------------------------------------------------
 // PCRAnalyzez::Status constructors
 //----------------------------------------------------------------------------
@@ -104,7 +216,9 @@ ts::PCRAnalyzer::Status::Status() :
     pcr_pids(0),
     discontinuities(0),
     instantaneous_bitrate_188(0),
-    instantaneous_bitrate_204(0)
+    instantaneous_bitrate_204(0),
+    windowed_bitrate_188(0),
+    windowed_bitrate_204(0)
 {
 }
 
@@ -120,8 +234,8 @@ ts::PCRAnalyzer::Status::Status(const PCRAnalyzer& an) : Status()
 
 ts::UString ts::PCRAnalyzer::Status::toString() const
 {
-    return UString::Format(u"valid: %s, bitrate: %'d b/s, packets: %'d, PCRs: %'d, PIDs with PCR: %'d, discont: %'d, instantaneous bitrate: %'d b/s",
-                           {bitrate_valid, bitrate_188, packet_count, pcr_count, pcr_pids, discontinuities, instantaneous_bitrate_188});
+    return UString::Format(u"valid: %s, bitrate: %'d b/s, packets: %'d, PCRs: %'d, PIDs with PCR: %'d, discont: %'d, instantaneous bitrate: %'d b/s, windowed bitrate: %'d b/s",
+                           {bitrate_valid, bitrate_188, packet_count, pcr_count, pcr_pids, discontinuities, instantaneous_bitrate_188, windowed_bitrate_188});
 }
 
 
@@ -160,7 +274,8 @@ void ts::PCRAnalyzer::reset()
         }
     }
 
-    _packet_pcr_index_map.clear();
+    _pcr_pid_list.clear();
+    _last_pcrs_first = _last_pcrs_count = 0;
 }
 
 
@@ -200,7 +315,7 @@ void ts::PCRAnalyzer::processDiscontinuity()
             _pid[i]->last_pcr_value = INVALID_PCR;
         }
     }
-    _packet_pcr_index_map.clear();
+    _last_pcrs_first = _last_pcrs_count = 0;
 }
 
 
@@ -229,6 +344,26 @@ ts::BitRate ts::PCRAnalyzer::instantaneousBitrate204() const
     return BitRate(_inst_ts_bitrate_204);
 }
 
+ts::BitRate ts::PCRAnalyzer::windowedBitrate188() const
+{
+    // Average of the regression slopes of all PID's with PCR's.
+    double sum = 0.0;
+    size_t count = 0;
+    for (auto it = _pcr_pid_list.begin(); it != _pcr_pid_list.end(); ++it) {
+        double slope = 0.0;
+        if (_pid[*it] != nullptr && _pid[*it]->window.slope(slope)) {
+            sum += slope;
+            count++;
+        }
+    }
+    return count == 0 ? 0 : BitRate((sum * double(SYSTEM_CLOCK_FREQ * PKT_SIZE * 8)) / double(count));
+}
+
+ts::BitRate ts::PCRAnalyzer::windowedBitrate204() const
+{
+    return ToBitrate204(windowedBitrate188());
+}
+
 
 //----------------------------------------------------------------------------
 // Return the evaluated PID bitrate in bits/second
@@ -273,6 +408,8 @@ void ts::PCRAnalyzer::getStatus(Status& stat) const
     stat.discontinuities = _discontinuities;
     stat.instantaneous_bitrate_188 = instantaneousBitrate188();
     stat.instantaneous_bitrate_204 = instantaneousBitrate204();
+    stat.windowed_bitrate_188 = windowedBitrate188();
+    stat.windowed_bitrate_204 = windowedBitrate204();
 }
 
 
@@ -361,18 +498,22 @@ bool ts::PCRAnalyzer::feedPacket(const TSPacket& pkt)
             uint64_t ts_bitrate_204 = diff_values == 0 ? 0 :
                 ((_ts_pkt_cnt - ps->last_pcr_packet) * SYSTEM_CLOCK_FREQ * PKT_RS_SIZE * 8) / diff_values;
 
-            // Clear out values older than 1 second from _packet_pcr_index_map.
-            // Note that this is a map that covers PCR/DTS packets across all PIDs
+            // Add the PCR/DTS in the sliding window of the PID.
+            ps->pcr_unwrapped += diff_values;
+            ps->window.add(ps->pcr_unwrapped, _ts_pkt_cnt);
+
+            // Clear out values older than 1 second from _last_pcrs.
+            // Note that this is a list of PCR/DTS packets across all PIDs
             // as long as the clocks used to generate the PCR/DTS values for different
             // programs is the same clock, there should be no issue, but if the PCR/DTS values
             // across the two programs are wildly different, then the following approach won't work.
-            while (!_packet_pcr_index_map.empty()) {
-                const uint64_t earliestPCR_DTS = _packet_pcr_index_map.begin()->first;
+            while (_last_pcrs_count > 0) {
                 diff_values = _use_dts ?
-                    DiffPTS(earliestPCR_DTS, pcr_dts) * SYSTEM_CLOCK_SUBFACTOR :
-                    DiffPCR(earliestPCR_DTS, pcr_dts);
+                    DiffPTS(_last_pcrs[_last_pcrs_first].pcr, pcr_dts) * SYSTEM_CLOCK_SUBFACTOR :
+                    DiffPCR(_last_pcrs[_last_pcrs_first].pcr, pcr_dts);
                 if (diff_values > SYSTEM_CLOCK_FREQ) {
-                    _packet_pcr_index_map.erase(_packet_pcr_index_map.begin());
+                    _last_pcrs_first = (_last_pcrs_first + 1) % _last_pcrs.size();
+                    _last_pcrs_count--;
                 }
                 else {
                     break;
@@ -386,6 +527,7 @@ bool ts::PCRAnalyzer::feedPacket(const TSPacket& pkt)
             if (ps->ts_bitrate_cnt == 1) {
                 // First PCR result on this PID
                 _pcr_pids++;
+                _pcr_pid_list.push_back(pid);
             }
 
             // Transport stream statistics:
@@ -395,14 +537,15 @@ bool ts::PCRAnalyzer::feedPacket(const TSPacket& pkt)
 
             // Transport stream instantaneous statistics.
             // For instantaneous bit rates, these are the actual bit rates, and it doesn't use the "count" approach.
-            if (!_packet_pcr_index_map.empty()) {
+            if (_last_pcrs_count > 0) {
+                const PCRPacket& oldest(_last_pcrs[_last_pcrs_first]);
                 diff_values = _use_dts ?
-                    DiffPTS(_packet_pcr_index_map.begin()->first, pcr_dts) * SYSTEM_CLOCK_SUBFACTOR :
-                    DiffPCR(_packet_pcr_index_map.begin()->first, pcr_dts);
+                    DiffPTS(oldest.pcr, pcr_dts) * SYSTEM_CLOCK_SUBFACTOR :
+                    DiffPCR(oldest.pcr, pcr_dts);
                 _inst_ts_bitrate_188 = diff_values == 0 ? 0 :
-                    ((_ts_pkt_cnt - _packet_pcr_index_map.begin()->second) * SYSTEM_CLOCK_FREQ * PKT_SIZE * 8) / diff_values;
+                    ((_ts_pkt_cnt - oldest.packet) * SYSTEM_CLOCK_FREQ * PKT_SIZE * 8) / diff_values;
                 _inst_ts_bitrate_204 = diff_values == 0 ? 0 :
-                    ((_ts_pkt_cnt - _packet_pcr_index_map.begin()->second) * SYSTEM_CLOCK_FREQ * PKT_RS_SIZE * 8) / diff_values;
+                    ((_ts_pkt_cnt - oldest.packet) * SYSTEM_CLOCK_FREQ * PKT_RS_SIZE * 8) / diff_values;
             }
 
             // Check if we got enough values for this PID
@@ -414,17 +557,31 @@ bool ts::PCRAnalyzer::feedPacket(const TSPacket& pkt)
 
         // Save PCR/DTS for next calculation, ignore duplicated values.
         if (ps->last_pcr_value != pcr_dts) {
+
+            // After a discontinuity or on the first PCR/DTS, restart the sliding window of the PID.
+            if (ps->last_pcr_value == INVALID_PCR) {
+                ps->pcr_unwrapped = 0;
+                ps->window.clear();
+                ps->window.add(0, _ts_pkt_cnt);
+            }
+
             ps->last_pcr_value = pcr_dts;
             ps->last_pcr_packet = _ts_pkt_cnt;
 
-            // Also add PCR (or DTS)/packet index combo to map for use in instantaneous bit rate calculations.
-            _packet_pcr_index_map[pcr_dts] = _ts_pkt_cnt;
-
+            // Also add PCR (or DTS)/packet index combo to the list for use in instantaneous bit rate calculations.
             // Make sure that some crazy TS does not accumulate thousands of PCR values in the same second range.
-            while (_packet_pcr_index_map.size() > FOOLPROOF_MAP_LIMIT) {
-                // Erase older entries.
-                _packet_pcr_index_map.erase(_packet_pcr_index_map.begin());
+            // The circular buffer is allocated on first use and never grows.
+            if (_last_pcrs.empty()) {
+                _last_pcrs.resize(FOOLPROOF_PCR_LIMIT);
+            }
+            if (_last_pcrs_count >= _last_pcrs.size()) {
+                // Erase oldest entry.
+                _last_pcrs_first = (_last_pcrs_first + 1) % _last_pcrs.size();
+                _last_pcrs_count--;
             }
+            PCRPacket& last(_last_pcrs[(_last_pcrs_first + _last_pcrs_count++) % _last_pcrs.size()]);
+            last.pcr = pcr_dts;
+            last.packet = _ts_pkt_cnt;
         }
     }
 
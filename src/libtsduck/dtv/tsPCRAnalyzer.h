@@ -153,6 +153,34 @@ namespace ts {
         //!
         BitRate instantaneousBitrate204() const;
 
+        //!
+        //! Get the evaluated TS bitrate in bits/second based on 188-byte packets, using a sliding window.
+        //! On each PID with PCR's, the bitrate is evaluated by a least-squares linear regression of the
+        //! packet index over the PCR value for the last WINDOW_PCR_COUNT PCR's. The result is the average
+        //! of all PID's. Unlike bitrate188(), which is averaged since the last reset, this value follows
+        //! the bitrate changes. Unlike instantaneousBitrate188(), it smoothes the PCR jitter.
+        //! @return The evaluated TS bitrate in bits/second based on 188-byte packets.
+        //!
+        BitRate windowedBitrate188() const;
+
+        //!
+        //! Get the evaluated TS bitrate in bits/second based on 204-byte packets, using a sliding window.
+        //! @return The evaluated TS bitrate in bits/second based on 204-byte packets.
+        //! @see windowedBitrate188()
+        //!
+        BitRate windowedBitrate204() const;
+
+        //!
+        //! Number of PCR's per PID in the sliding window of windowedBitrate188().
+        //!
+        static constexpr size_t WINDOW_PCR_COUNT = 128;
+
+        //!
+        //! Get the number of analyzed PCR's (or DTS's) since the last reset.
+        //! @return The number of analyzed PCR's.
+        //!
+        PacketCounter pcrCount() const { return _ts_bitrate_cnt; }
+
         //!
         //! Get the number of TS packets on a PID.
         //! @param [in] pid The PID to evaluate.
@@ -175,6 +203,8 @@ namespace ts {
             size_t        discontinuities; //!< The number of discontinuities.
             BitRate       instantaneous_bitrate_188;  //!< The evaluated TS bitrate in bits/second based on 188-byte packets for the last second.
             BitRate       instantaneous_bitrate_204;  //!< The evaluated TS bitrate in bits/second based on 204-byte packets for the last second.
+            BitRate       windowed_bitrate_188;       //!< The evaluated TS bitrate in bits/second based on 188-byte packets on a sliding window.
+            BitRate       windowed_bitrate_204;       //!< The evaluated TS bitrate in bits/second based on 204-byte packets on a sliding window.
 
             //!
             //! Default constructor.
@@ -201,6 +231,36 @@ namespace ts {
         // Process a discontinuity in the transport stream
         void processDiscontinuity();
 
+        // Sliding window of (PCR, packet index) samples with an incremental least-squares
+        // regression of the packet index over the PCR. The sums are computed relatively to
+        // an anchor sample which is periodically moved to keep the values small.
+        class PCRWindow
+        {
+        public:
+            // Constructor.
+            PCRWindow();
+            // Clear the window.
+            void clear();
+            // Add a sample, PCR values must be monotonic (unwrapped).
+            void add(uint64_t pcr, uint64_t packet);
+            // Number of packets per PCR unit. Return false if not enough samples.
+            bool slope(double& packets_per_pcr) const;
+        private:
+            struct Sample {
+                uint64_t pcr;
+                uint64_t packet;
+            };
+            std::vector<Sample> _samples;   // Circular buffer of samples.
+            size_t   _first;                // Index of oldest sample.
+            size_t   _count;                // Number of samples.
+            size_t   _adds;                 // Number of samples since last anchor move.
+            uint64_t _pcr0;                 // Anchor PCR.
+            uint64_t _packet0;              // Anchor packet index.
+            double   _sx, _sy, _sxx, _sxy;  // Sums of relative values.
+            // Move the anchor to the oldest sample and recompute the sums.
+            void rebase();
+        };
+
         // Analysis of one PID
         struct PIDAnalysis
         {
@@ -214,6 +274,15 @@ namespace ts {
             uint64_t ts_bitrate_188;   // Sum of all computed TS bitrates (188-byte)
             uint64_t ts_bitrate_204;   // Sum of all computed TS bitrates (204-byte)
             uint64_t ts_bitrate_cnt;   // Count of computed TS bitrates
+            uint64_t pcr_unwrapped;    // Last PCR/DTS value, monotonic in PCR units since start of window
+            PCRWindow window;          // Sliding window of PCR/DTS for least-squares regression
+        };
+
+        // A PCR/DTS value in the stream and the index of the packet containing it.
+        struct PCRPacket
+        {
+            uint64_t pcr;
+            uint64_t packet;
         };
 
         // Private members:
@@ -232,7 +301,10 @@ namespace ts {
         size_t   _pcr_pids;            // Number of PIDs with PCRs
         size_t   _discontinuities;     // Number of discontinuities
         PIDAnalysis* _pid[PID_MAX];    // Per-PID stats
-        std::map<uint64_t, uint64_t> _packet_pcr_index_map; // Map of PCR/DTS to packet index across entire TS
-        static constexpr size_t FOOLPROOF_MAP_LIMIT = 1000; // Max number of entries in the PCR map
+        std::vector<PID> _pcr_pid_list;      // List of PID's with PCR's (same size as _pcr_pids)
+        std::vector<PCRPacket> _last_pcrs;   // Circular buffer of last PCR/DTS across entire TS, in arrival order
+        size_t   _last_pcrs_first;     // Index of oldest entry in _last_pcrs
+        size_t   _last_pcrs_count;     // Number of entries in _last_pcrs
+        static constexpr size_t FOOLPROOF_PCR_LIMIT = 1000; // Max number of PCR's in last second
     };
 }
@@ -31,25 +31,12 @@
 #include "tsBinaryTable.h"
 #include "tsTSPacket.h"
 #include "tsMemory.h"
+#include "tsStartCodeScanner.h"
 #include "tsPAT.h"
 #include "tsPMT.h"
 TSDUCK_SOURCE;
 
 
-//----------------------------------------------------------------------------
-// Delimiters
-//----------------------------------------------------------------------------
-
-namespace {
-
-    // Start code prefix for ISO 11172-2 (MPEG-1 video) and ISO 13818-2 (MPEG-2 video)
-    const uint8_t StartCodePrefix[] = {0x00, 0x00, 0x01};
-
-    // End of AVC NALunit delimiter
-    const uint8_t Zero3[] = {0x00, 0x00, 0x00};
-}
-
-
 //----------------------------------------------------------------------------
 // Constructor
 //----------------------------------------------------------------------------
@@ -85,6 +72,8 @@ ts::PESDemux::PIDContext::PIDContext() :
     sync(false),
     first_pkt(0),
     last_pkt(0),
+    payload(true),
+    dropped(0),
     ts(new ByteBlock()),
     audio(),
     video(),
@@ -95,6 +84,25 @@ ts::PESDemux::PIDContext::PIDContext() :
 }
 
 
+//----------------------------------------------------------------------------
+// Check if the TS payload buffer contains at least a complete PES header.
+//----------------------------------------------------------------------------
+
+bool ts::PESDemux::PIDContext::completeHeader() const
+{
+    const size_t size = ts->size();
+    if (size < 6) {
+        return false;
+    }
+    else if (!IsLongHeaderSID((*ts)[3])) {
+        return true;
+    }
+    else {
+        return size >= 9 && size >= 9 + size_t((*ts)[8]);
+    }
+}
+
+
 //----------------------------------------------------------------------------
 // Reset the analysis context (partially built PES packets).
 //----------------------------------------------------------------------------
@@ -237,10 +245,14 @@ void ts::PESDemux::processPacket(const TSPacket& pkt)
         // If the beginning of a PUSI payload is 00 00 01, this is a PES packet
         // (it is not possible to have 00 00 01 in a PUSI packet containing sections).
         if (pl_size >= 3 && pl[0] == 0 && pl[1] == 0 && pl[2] == 1) {
-            // We are at the beginning of a PES packet. Create context if non existent.
+            // We are at the beginning of a PES packet. Check if the payload will be needed.
+            const bool payload = _pes_handler == nullptr || _pes_handler->needPESPayload(*this, pid);
+            // Create context if non existent.
             PIDContext& pc(_pids[pid]);
             pc.continuity = pkt.getCC();
             pc.sync = true;
+            pc.payload = payload;
+            pc.dropped = 0;
             pc.ts->copy(pl, pl_size);
             pc.first_pkt = _packet_count;
             pc.last_pkt = _packet_count;
@@ -272,7 +284,38 @@ void ts::PESDemux::processPacket(const TSPacket& pkt)
     }
     pc.continuity = pkt.getCC();
 
-    // Append the TS payload in PID context.
+    // When the payload is not needed, do not store it once the PES header is complete.
+    if (!pc.payload && pc.completeHeader()) {
+        pc.dropped += pl_size;
+        pc.last_pkt = _packet_count;
+    }
+    else {
+        appendPayload(pc, pl, pl_size);
+    }
+
+    // Check if the complete PES packet is now present (without waiting for the next PUSI).
+    if (pc.ts->size() >= 6 && pc.sync) {
+        // There is enought to get the PES packet length.
+        const size_t len = GetUInt16(pc.ts->data() + 4);
+        // If the size is zero, the PES packet is "unbounded", meaning it ends at the next PUSI.
+        // But if the PES packet size is specified, check if we have the complete PES packet.
+        if (len != 0 && pc.ts->size() + pc.dropped >= 4 + len) {
+            // We have the complete PES packet.
+            processPESPacket(pid, pc);
+            // Reset PES buffer.
+            pc.ts->clear();
+            pc.dropped = 0;
+        }
+    }
+}
+
+
+//----------------------------------------------------------------------------
+// Append a TS payload in a PID context.
+//----------------------------------------------------------------------------
+
+void ts::PESDemux::appendPayload(PIDContext& pc, const uint8_t* pl, size_t pl_size)
+{
     size_t capacity = pc.ts->capacity();
     if (pc.ts->size() + pl_size > capacity) {
         // Internal reallocation needed in ts buffer.
@@ -294,20 +337,6 @@ void ts::PESDemux::processPacket(const TSPacket& pkt)
 
     // Last TS packet containing actual data for this PES packet
     pc.last_pkt = _packet_count;
-
-    // Check if the complete PES packet is now present (without waiting for the next PUSI).
-    if (pc.ts->size() >= 6 && pc.sync) {
-        // There is enought to get the PES packet length.
-        const size_t len = GetUInt16(pc.ts->data() + 4);
-        // If the size is zero, the PES packet is "unbounded", meaning it ends at the next PUSI.
-        // But if the PES packet size is specified, check if we have the complete PES packet.
-        if (len != 0 && pc.ts->size() >= 4 + len) {
-            // We have the complete PES packet.
-            processPESPacket(pid, pc);
-            // Reset PES buffer.
-            pc.ts->clear();
-        }
-    }
 }
 
 
@@ -396,59 +425,43 @@ void ts::PESDemux::processPESPacket(PID pid, PIDContext& pc)
         const uint8_t* const pdata = pp.payload();
         const size_t psize = pp.payloadSize();
 
+        // When the payload was not collected, only the PES header is analyzed.
+        if (!pc.payload) {
+            // Nothing more to analyze.
+        }
+
         // Process MPEG-1 (ISO 11172-2) and MPEG-2 (ISO 13818-2) video start codes
-        if (pp.isMPEG2Video()) {
-            // Locate all start codes and invoke handler.
+        else if (pp.isMPEG2Video()) {
+            // Locate all start codes in one pass and invoke handler.
             // The beginning of the payload is already a start code prefix.
-            for (size_t offset = 0; offset < psize; ) {
-                // Look for next start code
-                const void* pnext = LocatePattern(pdata + offset + 1, psize - offset - 1, StartCodePrefix, sizeof(StartCodePrefix));
-                size_t next = pnext == nullptr ? psize : reinterpret_cast<const uint8_t*>(pnext) - pdata;
+            StartCodeScanner scanner;
+            StartCodeScanner::UnitVector units;
+            scanner.scan(pdata, psize);
+            scanner.getVideoUnits(units);
+            for (auto unit = units.begin(); unit != units.end(); ++unit) {
                 // Invoke handler
                 if (_pes_handler != nullptr) {
-                    _pes_handler->handleVideoStartCode(*this, pp, pdata[offset + 3], offset, next - offset);
+                    _pes_handler->handleVideoStartCode(*this, pp, pdata[unit->offset + 3], unit->offset, unit->size);
                 }
                 // Accumulate info from video units to extract video attributes.
                 // If new attributes were found, invoke handler.
-                if (pc.video.moreBinaryData(pdata + offset, next - offset) && _pes_handler != nullptr) {
+                if (pc.video.moreBinaryData(pdata + unit->offset, unit->size) && _pes_handler != nullptr) {
                     _pes_handler->handleNewVideoAttributes(*this, pp, pc.video);
                 }
-                // Move to next start code
-                offset = next;
             }
         }
 
         // Process AVC (ISO 14496-10, ITU H.264) access units (aka "NALunits")
         else if (pp.isAVC()) {
-            for (size_t offset = 0; offset < psize; ) {
-                // Locate next access unit: starts with 00 00 01 (this start code is not part of the NALunit)
-                const uint8_t* p1 = reinterpret_cast<const uint8_t*>(
-                            LocatePattern(pdata + offset, psize - offset, StartCodePrefix, sizeof(StartCodePrefix)));
-                if (p1 == nullptr) {
-                    break;
-                }
-                offset = p1 - pdata + sizeof(StartCodePrefix);
-
-                // Locate end of access unit: ends with 00 00 00, 00 00 01 or end of data.
-                const uint8_t* p2 = reinterpret_cast<const uint8_t*>(
-                            LocatePattern(pdata + offset, psize - offset, StartCodePrefix, sizeof(StartCodePrefix)));
-                const uint8_t* p3 = reinterpret_cast<const uint8_t*>(
-                            LocatePattern(pdata + offset, psize - offset, Zero3, sizeof(Zero3)));
-                size_t nalunit_size = 0;
-                if (p2 == nullptr && p3 == nullptr) {
-                    // No 00 00 01, no 00 00 00, the NALunit extends up to the end of data.
-                    nalunit_size = psize - offset;
-                }
-                else if (p2 == nullptr || (p3 != nullptr && p3 < p2)) {
-                    // NALunit ends at 00 00 00.
-                    assert(p3 != nullptr);
-                    nalunit_size = p3 - pdata - offset;
-                }
-                else {
-                    // NALunit ends at 00 00 01.
-                    assert(p2 != nullptr);
-                    nalunit_size = p2 - pdata - offset;
-                }
+            // Locate all NALunits in one pass: each one starts after 00 00 01 (this start code
+            // is not part of the NALunit) and ends with 00 00 00, 00 00 01 or end of data.
+            StartCodeScanner scanner;
+            StartCodeScanner::UnitVector units;
+            scanner.scan(pdata, psize);
+            scanner.getNALUnits(units);
+            for (auto unit = units.begin(); unit != units.end(); ++unit) {
+                const size_t offset = unit->offset;
+                const size_t nalunit_size = unit->size;
 
                 // Compute NALunit type.
                 const uint8_t nalunit_type = nalunit_size == 0 ? 0 : (pdata[offset] & 0x1F);
@@ -497,9 +510,6 @@ void ts::PESDemux::processPESPacket(PID pid, PIDContext& pc)
                 if (pc.avc.moreBinaryData(pdata + offset, nalunit_size) && _pes_handler != nullptr) {
                     _pes_handler->handleNewAVCAttributes(*this, pp, pc.avc);
                 }
-
-                // Move to next start code
-                offset += nalunit_size;
             }
         }
 
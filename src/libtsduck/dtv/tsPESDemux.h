@@ -145,6 +145,8 @@ namespace ts {
             bool            sync;        // We are synchronous in this PID
             PacketCounter   first_pkt;   // Index of first TS packet for current PES packet
             PacketCounter   last_pkt;    // Index of last TS packet for current PES packet
+            bool            payload;     // The payload of the current PES packet is needed
+            size_t          dropped;     // Size of TS payload which was not stored (when payload not needed)
             ByteBlockPtr    ts;          // TS payload buffer
             AudioAttributes audio;       // Current audio attributes
             VideoAttributes video;       // Current video attributes (MPEG-1, MPEG-2)
@@ -156,7 +158,10 @@ namespace ts {
             PIDContext();
 
             // Called when packet synchronization is lost on the pid
-            void syncLost() {sync = false; ts->clear();}
+            void syncLost() {sync = false; dropped = 0; ts->clear();}
+
+            // Check if the TS payload buffer contains at least a complete PES header.
+            bool completeHeader() const;
         };
 
         // Map of PID contexts, indexed by PID.
@@ -170,6 +175,9 @@ namespace ts {
         // Feed the demux with a TS packet (PID already filtered).
         void processPacket(const TSPacket&);
 
+        // Append a TS payload in a PID context.
+        void appendPayload(PIDContext&, const uint8_t*, size_t);
+
         // Process a complete PES packet
         void processPESPacket(PID, PIDContext&);
 
@@ -32,6 +32,11 @@ TSDUCK_SOURCE;
 
 // Default implementation.
 
+bool ts::PESHandlerInterface::needPESPayload(PESDemux& demux, PID pid)
+{
+    return true;
+}
+
 void ts::PESHandlerInterface::handlePESPacket(PESDemux& demux, const PESPacket& packet)
 {
 }
@@ -45,12 +45,28 @@ namespace ts {
 
     //!
     //! Abstract interface to be notified of PES packets using a PESDemux.
-    //! All hooks are optional, ie. they have an empty default implementation.
+    //! All hooks are optional, ie. they have an empty default implementation
+    //! (except needPESPayload() which returns true by default).
     //! @ingroup mpeg
     //!
     class TSDUCKDLL PESHandlerInterface
     {
     public:
+        //!
+        //! This hook is invoked when a new PES packet starts, to check if its payload is needed.
+        //! When the payload is not needed, the PES demux does not reassemble the PES packet.
+        //! Only the complete PES header is collected. The PES packet which is passed to
+        //! handlePESPacket() then contains the complete PES header but only the part of the
+        //! payload which was in the first TS packets. Its size and payload size are limited
+        //! accordingly. The other hooks (start codes, access units, audio and video attributes)
+        //! are not invoked for that PES packet.
+        //! @param [in,out] demux A reference to the PES demux.
+        //! @param [in] pid The PID of the new PES packet.
+        //! @return True if the payload of the PES packet is needed (the default).
+        //! False if only the PES header is needed.
+        //!
+        virtual bool needPESPayload(PESDemux& demux, PID pid);
+
         //!
         //! This hook is invoked when a complete PES packet is available.
         //! @param [in,out] demux A reference to the PES demux.
@@ -0,0 +1,189 @@
+//----------------------------------------------------------------------------
+//
+// TSDuck - The MPEG Transport Stream Toolkit
+// Copyright (c) 2005-2020, Thierry Lelegard
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+// THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------
+
+#include "tsPIDRoutingTable.h"
+TSDUCK_SOURCE;
+
+#if defined(TS_NEED_STATIC_CONST_DEFINITIONS)
+constexpr uint8_t ts::PIDRoutingTable::DROP;
+constexpr uint8_t ts::PIDRoutingTable::REMAP;
+constexpr uint8_t ts::PIDRoutingTable::CC_REWRITE;
+constexpr uint8_t ts::PIDRoutingTable::PCR_RESTAMP;
+#endif
+
+
+//----------------------------------------------------------------------------
+// Constructor.
+//----------------------------------------------------------------------------
+
+ts::PIDRoutingTable::PIDRoutingTable() :
+    _flags(),
+    _remap(),
+    _cc(),
+    _pcr(PID_MAX)
+{
+    reset();
+}
+
+
+//----------------------------------------------------------------------------
+// Reset the table and its states.
+//----------------------------------------------------------------------------
+
+void ts::PIDRoutingTable::reset()
+{
+    ::memset(_flags, 0, sizeof(_flags));
+    for (PID pid = 0; pid < PID_MAX; ++pid) {
+        _remap[pid] = pid;
+    }
+    resetState();
+}
+
+void ts::PIDRoutingTable::resetState()
+{
+    ::memset(_cc, INVALID_CC, sizeof(_cc));
+    _pcr.assign(PID_MAX, PCRState());
+}
+
+
+//----------------------------------------------------------------------------
+// Modify the routing flags.
+//----------------------------------------------------------------------------
+
+void ts::PIDRoutingTable::setFlags(PID pid, uint8_t flags, bool on)
+{
+    setFlags(pid, pid, flags, on);
+}
+
+void ts::PIDRoutingTable::setFlags(PID first, PID last, uint8_t flags, bool on)
+{
+    for (PID pid = first; pid <= last && pid < PID_MAX; ++pid) {
+        if (on) {
+            _flags[pid] |= flags;
+        }
+        else {
+            _flags[pid] &= ~flags;
+        }
+    }
+}
+
+void ts::PIDRoutingTable::setRemap(PID from, PID to)
+{
+    if (from < PID_MAX && to < PID_MAX) {
+        _remap[from] = to;
+        _flags[from] |= REMAP;
+    }
+}
+
+void ts::PIDRoutingTable::setRemapAll(PID to)
+{
+    for (PID pid = 0; pid < PID_MAX; ++pid) {
+        setRemap(pid, to);
+    }
+}
+
+
+//----------------------------------------------------------------------------
+// Apply drop, remap and continuity counter flags on a window of packets.
+//----------------------------------------------------------------------------
+
+size_t ts::PIDRoutingTable::apply(TSPacket* packets, size_t count)
+{
+    size_t kept = count;
+    for (size_t i = 0; i < count; ++i) {
+        const PID pid = packets[i].getPID();
+        const uint8_t flags = _flags[pid];
+        if (flags == 0) {
+            // Most common case, passed without modification.
+            continue;
+        }
+        if ((flags & DROP) != 0) {
+            packets[i] = NullPacket;
+            kept--;
+            continue;
+        }
+        PID out_pid = pid;
+        if ((flags & REMAP) != 0) {
+            out_pid = _remap[pid];
+            packets[i].setPID(out_pid);
+        }
+        if ((flags & CC_REWRITE) != 0 && out_pid != PID_NULL) {
+            // Same as ContinuityAnalyzer in generator mode: the first packet on the output
+            // PID keeps its continuity counter, then build a smooth sequence.
+            uint8_t& cc(_cc[out_pid]);
+            if (cc == INVALID_CC) {
+                cc = packets[i].getCC();
+            }
+            else {
+                if (packets[i].hasPayload()) {
+                    cc = (cc + 1) & CC_MASK;
+                }
+                packets[i].clearDiscontinuityIndicator();
+                packets[i].setCC(cc);
+            }
+        }
+    }
+    return kept;
+}
+
+
+//----------------------------------------------------------------------------
+// Restamp the PCR of a packet according to its position in the main stream.
+//----------------------------------------------------------------------------
+
+bool ts::PIDRoutingTable::restampPCR(TSPacket& pkt, PacketCounter position, BitRate bitrate)
+{
+    const PID pid = pkt.getPID();
+    if ((_flags[pid] & PCR_RESTAMP) == 0 || !pkt.hasPCR()) {
+        return false;
+    }
+
+    // PCR's are system clock values. They must be synchronized with the transport
+    // stream rate. So, the difference between two PCR's shall be the transmission
+    // time in PCR units. We can compute precise PCR values when the bitrate is fixed.
+    // With a variable bitrate, the computed values are inaccurate.
+    PCRState& state(_pcr[pid]);
+    if (!state.valid) {
+        // First time we see a PCR in this PID, keep the initial value unchanged.
+        state.valid = true;
+        state.last_pcr = pkt.getPCR();
+        state.pcr_pkt = position;
+        return false;
+    }
+    else if (bitrate == 0 || position <= state.pcr_pkt) {
+        return false;
+    }
+    else {
+        // Compute the transmission time since last PCR in PCR units.
+        state.last_pcr += ((position - state.pcr_pkt) * 8 * PKT_SIZE * SYSTEM_CLOCK_FREQ) / uint64_t(bitrate);
+        state.pcr_pkt = position;
+        pkt.setPCR(state.last_pcr);
+        return true;
+    }
+}
@@ -0,0 +1,167 @@
+//----------------------------------------------------------------------------
+//
+// TSDuck - The MPEG Transport Stream Toolkit
+// Copyright (c) 2005-2020, Thierry Lelegard
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+// THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------
+//!
+//!  @file
+//!  Precompiled per-PID routing and rewrite table for packet insertion.
+//!
+//----------------------------------------------------------------------------
+
+#pragma once
+#include "tsTSPacket.h"
+
+namespace ts {
+    //!
+    //! Precompiled per-PID routing and rewrite table for packet insertion.
+    //! @ingroup mpeg
+    //!
+    //! This class is used by plugins which insert packets from a secondary stream
+    //! into a main stream (merge, mux). All per-PID decisions are compiled once in
+    //! dense arrays which are indexed by PID: drop or pass, remap, PCR restamping,
+    //! continuity counter regeneration. The table is then applied on windows of
+    //! packets with one array lookup per packet. Packets on PID's without flags
+    //! are left untouched.
+    //!
+    //! The routing decisions (drop, remap, continuity counters) are applied by apply()
+    //! and the PCR restamping, which depends on the final position of the packet in
+    //! the main stream, is applied by restampPCR(). The two operations use distinct
+    //! states and can be invoked from two distinct threads, as long as the flags are
+    //! not modified while the table is in use.
+    //!
+    class TSDUCKDLL PIDRoutingTable
+    {
+    public:
+        static constexpr uint8_t DROP        = 0x01;  //!< Flag: drop the packets of this PID, replace them with null packets.
+        static constexpr uint8_t REMAP       = 0x02;  //!< Flag: remap the PID of the packets.
+        static constexpr uint8_t CC_REWRITE  = 0x04;  //!< Flag: regenerate continuous continuity counters on the output PID (except null PID).
+        static constexpr uint8_t PCR_RESTAMP = 0x08;  //!< Flag: restamp PCR's according to the position in the main stream.
+
+        //!
+        //! Constructor.
+        //! All PID's are initially passed without modification.
+        //!
+        PIDRoutingTable();
+
+        //!
+        //! Reset the table: all PID's are passed without modification.
+        //!
+        void reset();
+
+        //!
+        //! Reset the dynamic states (continuity counters, PCR's), keep the routing flags.
+        //!
+        void resetState();
+
+        //!
+        //! Get the routing flags of a PID.
+        //! @param [in] pid The PID to check.
+        //! @return The routing flags of @a pid, a combination of DROP, REMAP, etc.
+        //!
+        uint8_t flags(PID pid) const { return pid < PID_MAX ? _flags[pid] : 0; }
+
+        //!
+        //! Set or clear routing flags on a PID.
+        //! @param [in] pid The PID to modify.
+        //! @param [in] flags The flags to set or clear, a combination of DROP, REMAP, etc.
+        //! @param [in] on When true, set the flags. When false, clear them.
+        //!
+        void setFlags(PID pid, uint8_t flags, bool on = true);
+
+        //!
+        //! Set or clear routing flags on a range of PID's.
+        //! @param [in] first The first PID to modify.
+        //! @param [in] last The last PID to modify.
+        //! @param [in] flags The flags to set or clear, a combination of DROP, REMAP, etc.
+        //! @param [in] on When true, set the flags. When false, clear them.
+        //!
+        void setFlags(PID first, PID last, uint8_t flags, bool on = true);
+
+        //!
+        //! Check if the packets of a PID are dropped.
+        //! @param [in] pid The PID to check.
+        //! @return True if the packets of @a pid are dropped.
+        //!
+        bool isDropped(PID pid) const { return (flags(pid) & DROP) != 0; }
+
+        //!
+        //! Remap a PID. Also set the REMAP flag on the PID.
+        //! @param [in] from The input PID.
+        //! @param [in] to The output PID.
+        //!
+        void setRemap(PID from, PID to);
+
+        //!
+        //! Remap all PID's, including the null PID, into one single PID.
+        //! @param [in] to The output PID.
+        //!
+        void setRemapAll(PID to);
+
+        //!
+        //! Get the output PID of an input PID.
+        //! @param [in] pid The input PID.
+        //! @return The output PID of @a pid.
+        //!
+        PID outputPID(PID pid) const { return pid < PID_MAX && (_flags[pid] & REMAP) != 0 ? _remap[pid] : pid; }
+
+        //!
+        //! Apply drop, remap and continuity counter flags on a window of packets.
+        //! The packets are processed in order.
+        //! @param [in,out] packets Address of packets to process. Dropped packets are replaced with null packets.
+        //! @param [in] count Number of packets.
+        //! @return Number of packets which were not dropped.
+        //!
+        size_t apply(TSPacket* packets, size_t count);
+
+        //!
+        //! Restamp the PCR of a packet according to its position in the main stream.
+        //! Nothing is done if the packet has no PCR or the PCR_RESTAMP flag is not set on its PID.
+        //! The first PCR in a PID is left unchanged. Subsequent PCR's are computed from the
+        //! first one, the number of packets in the main stream and the main bitrate.
+        //! @param [in,out] pkt The packet to restamp, after apply().
+        //! @param [in] position Index of the packet in the main stream.
+        //! @param [in] bitrate Bitrate of the main stream. When zero, the PCR is not modified.
+        //! @return True if the PCR was modified.
+        //!
+        bool restampPCR(TSPacket& pkt, PacketCounter position, BitRate bitrate);
+
+    private:
+        // Description of PCR restamping in one PID.
+        struct PCRState
+        {
+            PCRState() : valid(false), last_pcr(0), pcr_pkt(0) {}
+            bool          valid;     // A first PCR was found in this PID.
+            uint64_t      last_pcr;  // Last PCR value in this PID, after adjustment in main stream.
+            PacketCounter pcr_pkt;   // Index of the packet with the last PCR in the main stream.
+        };
+
+        uint8_t               _flags[PID_MAX];  // Routing flags, indexed by input PID.
+        PID                   _remap[PID_MAX];  // Output PID, indexed by input PID.
+        uint8_t               _cc[PID_MAX];     // Last continuity counter, indexed by output PID.
+        std::vector<PCRState> _pcr;             // PCR restamping state, indexed by output PID.
+    };
+}
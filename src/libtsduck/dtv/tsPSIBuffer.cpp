@@ -213,7 +213,7 @@ bool ts::PSIBuffer::getString(ts::UString& str, size_t size)
     }
 
     // Decode characters.
-    if (_duck.charsetIn()->decode(str, currentReadAddress(), size)) {
+    if (_duck.decode(str, currentReadAddress(), size)) {
         // Include the deserialized bytes in the read part.
         readSeek(currentReadByteOffset() + size);
         return true;
@@ -243,7 +243,7 @@ bool ts::PSIBuffer::getStringWithByteLength(ts::UString& str)
     const size_t prev_size = remainingReadBytes();
     size_t size = prev_size;
 
-    if (!readError() && _duck.charsetIn()->decodeWithByteLength(str, data, size)) {
+    if (!readError() && _duck.decodeWithByteLength(str, data, size)) {
         // Include the deserialized bytes in the read part.
         readSeek(currentReadByteOffset() + prev_size - size);
         return true;
@@ -0,0 +1,274 @@
+//----------------------------------------------------------------------------
+//
+// TSDuck - The MPEG Transport Stream Toolkit
+// Copyright (c) 2005-2020, Thierry Lelegard
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+// THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------
+
+#include "tsPacketPacer.h"
+#include "tsNullReport.h"
+TSDUCK_SOURCE;
+
+#if defined(TS_NEED_STATIC_CONST_DEFINITIONS)
+constexpr ts::NanoSecond ts::PacketPacer::DEFAULT_SPIN_NS;
+constexpr ts::NanoSecond ts::PacketPacer::DEFAULT_MAX_LATE_NS;
+#endif
+
+// Re-anchor the interpolation after this number of packets to avoid arithmetic overflow.
+#define MAX_INTERPOLATION 1000000
+
+
+//----------------------------------------------------------------------------
+// Constructor
+//----------------------------------------------------------------------------
+
+ts::PacketPacer::PacketPacer(Report* report, int log_level) :
+    _report(report == nullptr ? NullReport::Instance() : report),
+    _log_level(log_level),
+    _spin(DEFAULT_SPIN_NS),
+    _max_late(DEFAULT_MAX_LATE_NS),
+    _max_observed_late(0),
+    _fixed_bitrate(0),
+    _user_pid(PID_NULL),
+    _pid(PID_NULL),
+    _started(false),
+    _packets(0),
+    _rate(0),
+    _anchor_time(),
+    _anchor_packet(0),
+    _last_due(),
+    _last_packet(0),
+    _pcr_started(false),
+    _pcr_first(0),
+    _pcr_last(0),
+    _pcr_offset(0),
+    _pcr_last_units(0),
+    _pcr_last_packet(0),
+    _pcr_bitrate(0),
+    _pcr_clock_first(),
+    _now()
+{
+}
+
+
+//----------------------------------------------------------------------------
+// Set a new report.
+//----------------------------------------------------------------------------
+
+void ts::PacketPacer::setReport(Report* report, int log_level)
+{
+    _report = report == nullptr ? NullReport::Instance() : report;
+    _log_level = log_level;
+}
+
+
+//----------------------------------------------------------------------------
+// Set the PCR reference PID.
+//----------------------------------------------------------------------------
+
+void ts::PacketPacer::setReferencePID(PID pid)
+{
+    _user_pid = pid;
+    if (pid != _pid) {
+        reset();
+        _pid = pid;
+    }
+}
+
+
+//----------------------------------------------------------------------------
+// Re-initialize the schedule.
+//----------------------------------------------------------------------------
+
+void ts::PacketPacer::reset()
+{
+    _pid = _user_pid;
+    _started = false;
+    _packets = 0;
+    _rate = 0;
+    _anchor_packet = 0;
+    _last_packet = 0;
+    _pcr_started = false;
+    _pcr_bitrate = 0;
+    _max_observed_late = 0;
+}
+
+
+//----------------------------------------------------------------------------
+// Compute the departure time of a packet, relatively to the anchor.
+//----------------------------------------------------------------------------
+
+ts::Monotonic ts::PacketPacer::interpolate(PacketCounter index) const
+{
+    Monotonic due(_anchor_time);
+    if (_rate > 0 && index > _anchor_packet) {
+        due += NanoSecond(((index - _anchor_packet) * PKT_SIZE_BITS * NanoSecPerSec) / _rate);
+    }
+    return due;
+}
+
+
+//----------------------------------------------------------------------------
+// Compute the departure time of the next group of packets.
+//----------------------------------------------------------------------------
+
+ts::Monotonic ts::PacketPacer::departure(const TSPacket* pkt, size_t count, BitRate bitrate)
+{
+    // Start the schedule at the first packet.
+    if (!_started) {
+        _started = true;
+        _anchor_time.getSystemTime();
+        _anchor_packet = _last_packet = _packets;
+        _last_due = _anchor_time;
+    }
+
+    // Bitrate to interpolate departure times: fixed bitrate, PCR-based bitrate or current TS bitrate.
+    const BitRate rate = _fixed_bitrate > 0 ? _fixed_bitrate : (_pcr_bitrate > 0 ? _pcr_bitrate : bitrate);
+    if (rate != _rate) {
+        // New bitrate, restart interpolation from the last departure.
+        _report->debug(u"pacing at %'d b/s", {rate});
+        _anchor_time = _last_due;
+        _anchor_packet = _last_packet;
+        _rate = rate;
+    }
+    else if (_packets - _anchor_packet > MAX_INTERPOLATION) {
+        _anchor_time = interpolate(_packets);
+        _anchor_packet = _packets;
+    }
+
+    Monotonic due(interpolate(_packets));
+
+    // Look for a PCR in the reference PID to resynchronize the schedule.
+    for (size_t i = 0; _fixed_bitrate == 0 && pkt != nullptr && i < count; ++i) {
+        if (pkt[i].hasPCR()) {
+            const PID pid = pkt[i].getPID();
+            if (_pid == PID_NULL) {
+                _pid = pid;
+                _report->log(_log_level, u"using PID 0x%X (%d) for PCR reference", {pid, pid});
+            }
+            if (pid == _pid) {
+                const PacketCounter index = _packets + i;
+                const Monotonic pcr_due(processPCR(pkt[i].getPCR(), index, interpolate(index)));
+                // Go back from the PCR packet to the first packet in the group.
+                due = pcr_due;
+                if (_pcr_bitrate > 0) {
+                    due -= NanoSecond((i * PKT_SIZE_BITS * NanoSecPerSec) / _pcr_bitrate);
+                    _rate = _pcr_bitrate;
+                }
+                // Subsequent packets are interpolated from this PCR.
+                _anchor_time = pcr_due;
+                _anchor_packet = index;
+                break;
+            }
+        }
+    }
+
+    // Departure times never go backward.
+    if (due < _last_due) {
+        due = _last_due;
+    }
+    _last_due = due;
+    _last_packet = _packets;
+    _packets += count;
+    return due;
+}
+
+
+//----------------------------------------------------------------------------
+// Process a PCR from the reference PID.
+//----------------------------------------------------------------------------
+
+ts::Monotonic ts::PacketPacer::processPCR(uint64_t pcr, PacketCounter index, const Monotonic& interpolated)
+{
+    // Same checks as in PCRRegulator: two PCR's must be less than 2 seconds apart.
+    constexpr uint64_t max_pcr_diff = 2 * SYSTEM_CLOCK_FREQ; // 2 seconds in PCR units
+    const bool valid_pcr_seq = _pcr_started &&
+        ((pcr < _pcr_last && pcr + PCR_SCALE < _pcr_last + max_pcr_diff) ||
+         (pcr > _pcr_last && pcr < _pcr_last + max_pcr_diff));
+
+    if (_pcr_started && !valid_pcr_seq) {
+        _report->warning(u"out of sequence PCR, maybe source was cycling, restarting pacing");
+        _pcr_started = false;
+    }
+
+    Monotonic due(interpolated);
+
+    if (!_pcr_started) {
+        // The first PCR departs at its interpolated time, subsequent PCR's are relative to it.
+        _pcr_started = true;
+        _pcr_first = pcr;
+        _pcr_offset = 0;
+        _pcr_last_units = 0;
+        _pcr_clock_first = interpolated;
+    }
+    else {
+        // Accumulate all PCR wrap-down sequences, see PCRRegulator.
+        if (pcr < _pcr_last) {
+            _pcr_offset += PCR_SCALE;
+        }
+        const uint64_t pcru = _pcr_offset + pcr - _pcr_first;
+
+        // Bitrate between the two last PCR's, used to interpolate until the next one.
+        if (pcru > _pcr_last_units && index > _pcr_last_packet) {
+            _pcr_bitrate = BitRate(((index - _pcr_last_packet) * PKT_SIZE_BITS * SYSTEM_CLOCK_FREQ) / (pcru - _pcr_last_units));
+        }
+        _pcr_last_units = pcru;
+
+        // Due time of this PCR. Coded to avoid arithmetic overflow, see PCRRegulator.
+        due = _pcr_clock_first;
+        due += NanoSecond((NanoSecPerMicroSec * pcru) / (SYSTEM_CLOCK_FREQ / MicroSecPerSec));
+    }
+
+    _pcr_last = pcr;
+    _pcr_last_packet = index;
+    return due;
+}
+
+
+//----------------------------------------------------------------------------
+// Wait until a departure time.
+//----------------------------------------------------------------------------
+
+void ts::PacketPacer::wait(const Monotonic& due)
+{
+    _now.getSystemTime();
+    NanoSecond late = _now - due;
+
+    if (late > _max_late) {
+        // Input starvation or overload. Do not try to catch up with a large burst, restart the schedule from now.
+        _report->log(_log_level, u"pacing is %'d ms late, rescheduling", {late / NanoSecPerMilliSec});
+        _anchor_time += late;
+        _last_due += late;
+        _pcr_clock_first += late;
+    }
+    else {
+        if (late < 0) {
+            due.preciseWait(_spin);
+            _now.getSystemTime();
+            late = _now - due;
+        }
+        _max_observed_late = std::max(_max_observed_late, late);
+    }
+}
@@ -0,0 +1,191 @@
+//----------------------------------------------------------------------------
+//
+// TSDuck - The MPEG Transport Stream Toolkit
+// Copyright (c) 2005-2020, Thierry Lelegard
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+// THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------
+//!
+//!  @file
+//!  Compute and wait for precise departure times of TS packets.
+//!
+//----------------------------------------------------------------------------
+
+#pragma once
+#include "tsMPEG.h"
+#include "tsReport.h"
+#include "tsTSPacket.h"
+#include "tsMonotonic.h"
+
+namespace ts {
+    //!
+    //! Compute and wait for precise departure times of TS packets.
+    //! @ingroup mpeg
+    //!
+    //! Unlike BitRateRegulator and PCRRegulator which wait at the precision of the operating
+    //! system timers and consequently release packets in bursts, a packet pacer computes the
+    //! departure time of each group of packets (typically one datagram) and waits for it with
+    //! a sub-millisecond precision using Monotonic::preciseWait().
+    //!
+    //! The departure times are computed either from a fixed bitrate or from the PCR's of a
+    //! reference PID. Between two PCR's, the departure times are interpolated using the bitrate
+    //! between the two previous PCR's. Before the first PCR's, the current bitrate of the TS is used.
+    //! The computation is always based on the start of the schedule, not on the previous departure,
+    //! so that rounding errors never accumulate.
+    //!
+    //! @see BitRateRegulator
+    //! @see PCRRegulator
+    //!
+    class TSDUCKDLL PacketPacer
+    {
+        TS_NOCOPY(PacketPacer);
+    public:
+        //!
+        //! Constructor.
+        //! @param [in,out] report Where to report errors.
+        //! @param [in] log_level Severity level for information messages.
+        //!
+        PacketPacer(Report* report = nullptr, int log_level = Severity::Verbose);
+
+        //!
+        //! Set a new report.
+        //! @param [in,out] report Where to report errors.
+        //! @param [in] log_level Severity level for information messages.
+        //!
+        void setReport(Report* report = nullptr, int log_level = Severity::Verbose);
+
+        //!
+        //! Default duration of the final active polling of the clock, in nano-seconds.
+        //!
+        static constexpr NanoSecond DEFAULT_SPIN_NS = 200 * NanoSecPerMicroSec;
+
+        //!
+        //! Default maximum lateness before rescheduling, in nano-seconds.
+        //!
+        static constexpr NanoSecond DEFAULT_MAX_LATE_NS = 100 * NanoSecPerMilliSec;
+
+        //!
+        //! Set the duration of the final active polling of the clock.
+        //! @param [in] spin Duration in nano-seconds. When zero, the operating system timers only are used.
+        //! @see Monotonic::preciseWait()
+        //!
+        void setSpinTime(NanoSecond spin = DEFAULT_SPIN_NS) { _spin = spin; }
+
+        //!
+        //! Set the maximum lateness before rescheduling.
+        //! When packets are late by more than this value (input starvation, CPU overload), the pacer
+        //! does not try to catch up with a large burst. Instead, the schedule restarts from the current time.
+        //! @param [in] late Maximum lateness in nano-seconds.
+        //!
+        void setMaxLateness(NanoSecond late = DEFAULT_MAX_LATE_NS) { _max_late = late; }
+
+        //!
+        //! Set a fixed bitrate for pacing, ignore PCR's and current bitrate.
+        //! @param [in] bitrate Fixed bitrate to use. When zero, use PCR's.
+        //!
+        void setFixedBitRate(BitRate bitrate) { _fixed_bitrate = bitrate; }
+
+        //!
+        //! Set the PCR reference PID.
+        //! @param [in] pid Reference PID. If PID_NULL, use the first PID containing PCR's.
+        //!
+        void setReferencePID(PID pid);
+
+        //!
+        //! Get the current PCR reference PID.
+        //! @return Current reference PID or PID_NULL if none was set or found.
+        //!
+        PID getReferencePID() const { return _pid; }
+
+        //!
+        //! Re-initialize the schedule.
+        //!
+        void reset();
+
+        //!
+        //! Compute the departure time of the next group of packets, without waiting.
+        //! All packets must be passed in order, once.
+        //! @param [in] pkt Address of the first packet in the group. When null, PCR's are
+        //! ignored and the departure time is computed from the bitrate only.
+        //! @param [in] count Number of packets in the group.
+        //! @param [in] bitrate Current bitrate of the TS, used when no fixed bitrate
+        //! is set and PCR's are not yet available.
+        //! @return The departure time of the first packet in the group.
+        //!
+        Monotonic departure(const TSPacket* pkt, size_t count, BitRate bitrate = 0);
+
+        //!
+        //! Wait until a departure time which was previously returned by departure().
+        //! @param [in] due Departure time.
+        //!
+        void wait(const Monotonic& due);
+
+        //!
+        //! Compute the departure time of the next group of packets and wait for it.
+        //! @param [in] pkt Address of the first packet in the group.
+        //! @param [in] count Number of packets in the group.
+        //! @param [in] bitrate Current bitrate of the TS, used when no fixed bitrate
+        //! is set and PCR's are not yet available.
+        //!
+        void pace(const TSPacket* pkt, size_t count, BitRate bitrate = 0) { wait(departure(pkt, count, bitrate)); }
+
+        //!
+        //! Get the maximum observed lateness since the last reset.
+        //! @return The maximum delay in nano-seconds between a departure time and the end of its wait.
+        //!
+        NanoSecond maxLateness() const { return _max_observed_late; }
+
+    private:
+        Report*       _report;
+        int           _log_level;
+        NanoSecond    _spin;            // Final active polling of the clock.
+        NanoSecond    _max_late;        // Reschedule when later than this.
+        NanoSecond    _max_observed_late;
+        BitRate       _fixed_bitrate;   // User-specified bitrate.
+        PID           _user_pid;        // User-specified reference PID.
+        PID           _pid;             // Current reference PID.
+        bool          _started;         // Schedule started.
+        PacketCounter _packets;         // Index of next packet.
+        BitRate       _rate;            // Current bitrate to interpolate departure times.
+        Monotonic     _anchor_time;     // Departure time of packet _anchor_packet.
+        PacketCounter _anchor_packet;   // Index of anchor packet.
+        Monotonic     _last_due;        // Last returned departure time.
+        PacketCounter _last_packet;     // Index of packet at _last_due.
+        bool          _pcr_started;     // First PCR found.
+        uint64_t      _pcr_first;       // First PCR value.
+        uint64_t      _pcr_last;        // Last PCR value.
+        uint64_t      _pcr_offset;      // Offset to add to PCR value, accumulate all PCR wrap-down sequences.
+        uint64_t      _pcr_last_units;  // Last PCR, in PCR units since first PCR.
+        PacketCounter _pcr_last_packet; // Index of packet with last PCR.
+        BitRate       _pcr_bitrate;     // Bitrate between the two last PCR's.
+        Monotonic     _pcr_clock_first; // Departure time of packet with first PCR.
+        Monotonic     _now;             // Preallocated clock.
+
+        // Compute the departure time of a packet, relatively to the anchor.
+        Monotonic interpolate(PacketCounter index) const;
+
+        // Process a PCR from the reference PID at packet index. Return the departure time of this packet.
+        Monotonic processPCR(uint64_t pcr, PacketCounter index, const Monotonic& interpolated);
+    };
+}
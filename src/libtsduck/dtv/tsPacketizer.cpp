@@ -49,7 +49,9 @@ ts::Packetizer::Packetizer(const DuckContext& duck, PID pid, SectionProviderInte
     _next_byte(0),
     _packet_count(0),
     _section_out_count(0),
-    _section_in_count(0)
+    _section_in_count(0),
+    _template(),
+    _template_next(0)
 {
 }
 
@@ -68,6 +70,50 @@ void ts::Packetizer::reset()
 {
     _section.clear();
     _next_byte = 0;
+    _template.clear();
+    _template_next = 0;
+}
+
+
+//----------------------------------------------------------------------------
+// Get the precomputed packets of a section. Default: none.
+//----------------------------------------------------------------------------
+
+ts::Packetizer::PacketTemplatePtr ts::Packetizer::sectionTemplate(const SectionPtr&)
+{
+    return PacketTemplatePtr();
+}
+
+
+//----------------------------------------------------------------------------
+// Build the TS packets of a section which is packetized alone.
+//----------------------------------------------------------------------------
+
+void ts::Packetizer::BuildSectionPackets(TSPacketVector& packets, PID pid, const Section& section)
+{
+    const uint8_t* data = section.content();
+    size_t remain = section.size();
+
+    packets.resize((remain + PKT_SIZE - 4) / (PKT_SIZE - 4));
+    for (size_t i = 0; i < packets.size(); ++i) {
+        TSPacket& pkt(packets[i]);
+        uint8_t* payload = pkt.b + 4;
+        size_t size = PKT_SIZE - 4;
+        pkt.b[0] = SYNC_BYTE;
+        PutUInt16(pkt.b + 1, uint16_t((i == 0 ? 0x4000 : 0x0000) | (pid & 0x1FFF)));
+        pkt.b[3] = 0x10; // no adaptation field, has payload, CC zero
+        if (i == 0) {
+            *payload++ = 0x00; // pointer field, section starts immediately
+            size--;
+        }
+        const size_t length = std::min(remain, size);
+        ::memcpy(payload, data, length);  // Flawfinder: ignore: memcpy()
+        if (length < size) {
+            ::memset(payload + length, 0xFF, size - length);
+        }
+        data += length;
+        remain -= length;
+    }
 }
 
 
@@ -84,6 +130,9 @@ bool ts::Packetizer::getNextPacket(TSPacket& pkt)
     if (_section.isNull() && _provider != nullptr) {
         _provider->provideSection(_section_in_count++, _section);
         _next_byte = 0;
+        // When the section is packetized alone, use precomputed packets if available.
+        _template = _section.isNull() ? PacketTemplatePtr() : sectionTemplate(_section);
+        _template_next = 0;
     }
 
     // If there is still no current section, return a null packet
@@ -92,6 +141,31 @@ bool ts::Packetizer::getNextPacket(TSPacket& pkt)
         return false;
     }
 
+    // Emit the next precomputed packet of the section, only the continuity counter is patched.
+    // The PID is also patched if it was changed in the middle of the section.
+    if (!_template.isNull()) {
+        assert(_template_next < _template->size());
+        pkt = (*_template)[_template_next++];
+        pkt.setCC(_continuity);
+        if (pkt.getPID() != _pid) {
+            pkt.setPID(_pid);
+        }
+        _continuity = (_continuity + 1) & 0x0F;
+        if (_template_next < _template->size()) {
+            // Bytes of the section in previous packets: the first one has a pointer field.
+            _next_byte = _template_next * (PKT_SIZE - 4) - 1;
+        }
+        else {
+            // End of section.
+            _section_out_count++;
+            _section.clear();
+            _next_byte = 0;
+            _template.clear();
+            _template_next = 0;
+        }
+        return true;
+    }
+
     // Various values to build the MPEG header.
     uint16_t pusi = 0x0000;         // payload_unit_start_indicator (set: 0x4000)
     uint8_t pointer_field = 0x00;   // pointer_field (used only if pusi is set)
@@ -35,11 +35,11 @@
 #pragma once
 #include "tsMPEG.h"
 #include "tsSectionProviderInterface.h"
+#include "tsTSPacket.h"
 #include "tsReport.h"
 
 namespace ts {
 
-    class TSPacket;
     class DuckContext;
 
     //!
@@ -171,6 +171,37 @@ namespace ts {
         // Protected directly accessible to subclasses.
         const DuckContext& _duck;  //!< The TSDuck execution context is accessible to all subclasses.
 
+        //!
+        //! Safe pointer to a list of precomputed TS packets for one section (not thread-safe).
+        //!
+        typedef SafePtr<TSPacketVector, NullMutex> PacketTemplatePtr;
+
+        //!
+        //! Get the precomputed packets of a section which is packetized alone.
+        //!
+        //! This hook is invoked when a new section has just been provided at a packet boundary.
+        //! When stuffing is required after this section, its TS packets do not depend on the
+        //! previous and next sections. A subclass may keep these packets from one cycle to another
+        //! and return them here. Only the continuity counters are updated when the packets are emitted.
+        //! A subclass shall return a null pointer when the section is packed with the next one.
+        //!
+        //! The default implementation returns a null pointer, meaning that the packets are rebuilt.
+        //! @param [in] section The section which has just been provided.
+        //! @return A safe pointer to the packets of the section or a null pointer.
+        //! @see BuildSectionPackets()
+        //!
+        virtual PacketTemplatePtr sectionTemplate(const SectionPtr& section);
+
+        //!
+        //! Build the TS packets of a section which is packetized alone.
+        //! The first packet starts with the section and the last packet is padded with stuffing.
+        //! All continuity counters are zero.
+        //! @param [out] packets Returned list of TS packets.
+        //! @param [in] pid PID of the packets.
+        //! @param [in] section The section to packetize.
+        //!
+        static void BuildSectionPackets(TSPacketVector& packets, PID pid, const Section& section);
+
     private:
         SectionProviderInterface* _provider;
         Report&        _report;            // Report object for debug.
@@ -182,6 +213,8 @@ namespace ts {
         PacketCounter  _packet_count;      // Number of generated packets
         SectionCounter _section_out_count; // Number of output (packetized) sections
         SectionCounter _section_in_count;  // Number of input (provided) sections
+        PacketTemplatePtr _template;       // Precomputed packets of current section (if any)
+        size_t         _template_next;     // Index of next packet to emit in _template
     };
 }
 
@@ -358,6 +358,31 @@ bool ts::SectionFile::loadBinary(std::istream& strm, Report& report)
     return strm.eof();
 }
 
+bool ts::SectionFile::loadBinary(const UString& file_name, const SectionFileIndex& index, const SectionFileIndex::Filter& filter, Report& report)
+{
+    clear();
+
+    // Open the input file.
+    std::ifstream strm(file_name.toUTF8().c_str(), std::ios::in | std::ios::binary);
+    if (!strm.is_open()) {
+        report.error(u"cannot open %s", {file_name});
+        return false;
+    }
+
+    // Read the selected sections only.
+    ReportWithPrefix report_internal(report, file_name + u": ");
+    SectionFileIndex::EntryVector entries;
+    index.select(filter, entries);
+    for (auto it = entries.begin(); it != entries.end(); ++it) {
+        const SectionPtr sp(SectionFileIndex::ReadSection(strm, *it, _crc_op, report_internal));
+        if (sp.isNull()) {
+            return false;
+        }
+        add(sp);
+    }
+    return true;
+}
+
 
 //----------------------------------------------------------------------------
 // Save a binary section file.
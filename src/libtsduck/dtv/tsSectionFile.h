@@ -38,6 +38,7 @@
 #include "tsMPEG.h"
 #include "tsSection.h"
 #include "tsBinaryTable.h"
+#include "tsSectionFileIndex.h"
 #include "tsUString.h"
 #include "tsDVBCharTable.h"
 #include "tsxmlTweaks.h"
@@ -237,6 +238,20 @@ namespace ts {
         //!
         bool loadBinary(const UString& file_name, Report& report = CERR);
 
+        //!
+        //! Load selected sections from a binary section file, using an index.
+        //! Only the sections which match the filter are read from the file.
+        //! This is much faster than loading the complete file when only a few
+        //! tables or a short time range are needed in a huge capture.
+        //! @param [in] file_name Binary file name.
+        //! @param [in] index Index of the binary file.
+        //! @param [in] filter Criteria to select the sections to load.
+        //! @param [in,out] report Where to report errors.
+        //! @return True on success, false on error.
+        //! @see SectionFileIndex
+        //!
+        bool loadBinary(const UString& file_name, const SectionFileIndex& index, const SectionFileIndex::Filter& filter, Report& report = CERR);
+
         //!
         //! Save a binary section file.
         //! @param [in,out] strm A standard stream in output mode (binary mode).
@@ -0,0 +1,380 @@
+//----------------------------------------------------------------------------
+//
+// TSDuck - The MPEG Transport Stream Toolkit
+// Copyright (c) 2005-2020, Thierry Lelegard
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+// THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------
+
+#include "tsSectionFileIndex.h"
+#include "tsReportWithPrefix.h"
+#include "tsMemory.h"
+TSDUCK_SOURCE;
+
+#if defined(TS_NEED_STATIC_CONST_DEFINITIONS)
+constexpr size_t ts::SectionFileIndex::HEADER_SIZE;
+constexpr size_t ts::SectionFileIndex::RECORD_SIZE;
+#endif
+
+namespace {
+    // Magic string and format version at start of index file.
+    const char INDEX_MAGIC[8] = {'T', 'S', 'S', 'E', 'C', 'I', 'D', 'X'};
+    const uint32_t INDEX_VERSION = 1;
+
+    // Number of records which are read at a time.
+    const size_t RECORDS_PER_READ = 4096;
+
+    // Flag in PID field of a record for long sections.
+    const uint16_t LONG_SECTION_FLAG = 0x8000;
+}
+
+
+//----------------------------------------------------------------------------
+// Constructors.
+//----------------------------------------------------------------------------
+
+ts::SectionFileIndex::Entry::Entry() :
+    offset(0),
+    size(0),
+    pid(PID_NULL),
+    tid(TID_NULL),
+    tid_ext(0),
+    version(0),
+    section_number(0),
+    long_section(false),
+    packet(0),
+    timestamp(Time::Epoch)
+{
+}
+
+ts::SectionFileIndex::Entry::Entry(const Section& section, uint64_t off, const Time& time) :
+    offset(off),
+    size(section.size()),
+    pid(section.sourcePID()),
+    tid(section.tableId()),
+    tid_ext(section.isLongSection() ? section.tableIdExtension() : 0),
+    version(section.isLongSection() ? section.version() : 0),
+    section_number(section.isLongSection() ? section.sectionNumber() : 0),
+    long_section(section.isLongSection()),
+    packet(section.getFirstTSPacketIndex()),
+    timestamp(time)
+{
+}
+
+ts::SectionFileIndex::Filter::Filter() :
+    pids(),
+    tids(),
+    tid_exts(),
+    start(Time::Epoch),
+    end(Time::Apocalypse)
+{
+}
+
+ts::SectionFileIndex::SectionFileIndex() :
+    _entries(),
+    _sorted(true)
+{
+}
+
+
+//----------------------------------------------------------------------------
+// Check if an index entry matches the filter.
+//----------------------------------------------------------------------------
+
+bool ts::SectionFileIndex::Filter::match(const Entry& entry) const
+{
+    return (pids.none() || pids.test(entry.pid)) &&
+        (tids.empty() || tids.count(entry.tid) != 0) &&
+        (tid_exts.empty() || (entry.long_section && tid_exts.count(entry.tid_ext) != 0)) &&
+        entry.timestamp >= start &&
+        entry.timestamp < end;
+}
+
+bool ts::SectionFileIndex::Filter::needsCollectionInfo() const
+{
+    return pids.any() || start != Time::Epoch || end != Time::Apocalypse;
+}
+
+
+//----------------------------------------------------------------------------
+// Modify the content of the index.
+//----------------------------------------------------------------------------
+
+void ts::SectionFileIndex::clear()
+{
+    _entries.clear();
+    _sorted = true;
+}
+
+void ts::SectionFileIndex::add(const Entry& entry)
+{
+    if (!_entries.empty() && entry.timestamp < _entries.back().timestamp) {
+        _sorted = false;
+    }
+    _entries.push_back(entry);
+}
+
+
+//----------------------------------------------------------------------------
+// Select the entries matching a filter.
+//----------------------------------------------------------------------------
+
+void ts::SectionFileIndex::select(const Filter& filter, EntryVector& entries) const
+{
+    entries.clear();
+
+    // Locate the time range when possible.
+    auto begin = _entries.begin();
+    auto end = _entries.end();
+    if (_sorted) {
+        const auto before = [](const Entry& e, const Time& t) { return e.timestamp < t; };
+        begin = std::lower_bound(_entries.begin(), _entries.end(), filter.start, before);
+        end = std::lower_bound(begin, _entries.end(), filter.end, before);
+    }
+
+    for (auto it = begin; it != end; ++it) {
+        if (filter.match(*it)) {
+            entries.push_back(*it);
+        }
+    }
+}
+
+
+//----------------------------------------------------------------------------
+// Load an index file.
+//----------------------------------------------------------------------------
+
+bool ts::SectionFileIndex::load(const UString& file_name, Report& report)
+{
+    std::ifstream strm(file_name.toUTF8().c_str(), std::ios::in | std::ios::binary);
+    if (!strm.is_open()) {
+        clear();
+        report.error(u"cannot open %s", {file_name});
+        return false;
+    }
+    ReportWithPrefix report_internal(report, file_name + u": ");
+    return load(strm, report_internal);
+}
+
+bool ts::SectionFileIndex::load(std::istream& strm, Report& report)
+{
+    clear();
+
+    // Read and check the header.
+    uint8_t header[HEADER_SIZE];
+    strm.read(reinterpret_cast<char*>(header), sizeof(header));
+    if (size_t(strm.gcount()) != sizeof(header) || ::memcmp(header, INDEX_MAGIC, sizeof(INDEX_MAGIC)) != 0) {
+        report.error(u"invalid section file index");
+        return false;
+    }
+    if (GetUInt32(header + 8) != INDEX_VERSION || GetUInt32(header + 12) != RECORD_SIZE) {
+        report.error(u"unsupported section file index format version %d, record size %d", {GetUInt32(header + 8), GetUInt32(header + 12)});
+        return false;
+    }
+
+    // Read records by chunks.
+    ByteBlock buffer(RECORDS_PER_READ * RECORD_SIZE);
+    for (;;) {
+        strm.read(reinterpret_cast<char*>(buffer.data()), std::streamsize(buffer.size()));
+        const size_t insize = size_t(strm.gcount());
+        const size_t count = insize / RECORD_SIZE;
+        for (size_t i = 0; i < count; ++i) {
+            const uint8_t* data = buffer.data() + i * RECORD_SIZE;
+            Entry entry;
+            entry.offset = GetUInt64(data);
+            entry.timestamp = Time::Epoch + MilliSecond(GetInt64(data + 8));
+            entry.packet = GetUInt48(data + 16);
+            entry.size = GetUInt16(data + 22);
+            entry.pid = GetUInt16(data + 24) & 0x1FFF;
+            entry.long_section = (GetUInt16(data + 24) & LONG_SECTION_FLAG) != 0;
+            entry.tid_ext = GetUInt16(data + 26);
+            entry.tid = data[28];
+            entry.version = data[29];
+            entry.section_number = data[30];
+            add(entry);
+        }
+        if (insize % RECORD_SIZE != 0) {
+            report.warning(u"truncated record at end of section file index, ignored");
+        }
+        if (insize < buffer.size()) {
+            break;
+        }
+    }
+    return strm.eof();
+}
+
+
+//----------------------------------------------------------------------------
+// Save the index.
+//----------------------------------------------------------------------------
+
+bool ts::SectionFileIndex::save(const UString& file_name, Report& report) const
+{
+    std::ofstream strm(file_name.toUTF8().c_str(), std::ios::out | std::ios::binary);
+    if (!strm.is_open()) {
+        report.error(u"error creating %s", {file_name});
+        return false;
+    }
+    ReportWithPrefix report_internal(report, file_name + u": ");
+    return save(strm, report_internal);
+}
+
+bool ts::SectionFileIndex::save(std::ostream& strm, Report& report) const
+{
+    bool ok = WriteHeader(strm);
+    for (auto it = _entries.begin(); ok && it != _entries.end(); ++it) {
+        ok = WriteEntry(strm, *it);
+    }
+    if (!ok) {
+        report.error(u"error writing section file index");
+    }
+    return ok;
+}
+
+bool ts::SectionFileIndex::WriteHeader(std::ostream& strm)
+{
+    uint8_t header[HEADER_SIZE];
+    ::memcpy(header, INDEX_MAGIC, sizeof(INDEX_MAGIC));  // Flawfinder: ignore: memcpy()
+    PutUInt32(header + 8, INDEX_VERSION);
+    PutUInt32(header + 12, uint32_t(RECORD_SIZE));
+    strm.write(reinterpret_cast<const char*>(header), sizeof(header));
+    return strm.good();
+}
+
+bool ts::SectionFileIndex::WriteEntry(std::ostream& strm, const Entry& entry)
+{
+    uint8_t data[RECORD_SIZE];
+    PutUInt64(data, entry.offset);
+    PutInt64(data + 8, entry.timestamp - Time::Epoch);
+    PutUInt48(data + 16, entry.packet);
+    PutUInt16(data + 22, uint16_t(entry.size));
+    PutUInt16(data + 24, uint16_t((entry.pid & 0x1FFF) | (entry.long_section ? LONG_SECTION_FLAG : 0)));
+    PutUInt16(data + 26, entry.tid_ext);
+    data[28] = entry.tid;
+    data[29] = entry.version;
+    data[30] = entry.section_number;
+    data[31] = 0xFF;
+    strm.write(reinterpret_cast<const char*>(data), sizeof(data));
+    return strm.good();
+}
+
+
+//----------------------------------------------------------------------------
+// Build the index of an existing binary section file.
+//----------------------------------------------------------------------------
+
+bool ts::SectionFileIndex::build(const UString& file_name, Report& report)
+{
+    std::ifstream strm(file_name.toUTF8().c_str(), std::ios::in | std::ios::binary);
+    if (!strm.is_open()) {
+        clear();
+        report.error(u"cannot open %s", {file_name});
+        return false;
+    }
+    ReportWithPrefix report_internal(report, file_name + u": ");
+    return build(strm, report_internal);
+}
+
+bool ts::SectionFileIndex::build(std::istream& strm, Report& report)
+{
+    clear();
+
+    uint8_t header[LONG_SECTION_HEADER_SIZE];
+    uint64_t offset = 0;
+
+    for (;;) {
+        // Read the short header.
+        strm.read(reinterpret_cast<char*>(header), SHORT_SECTION_HEADER_SIZE);
+        const size_t insize = size_t(strm.gcount());
+        if (insize == 0 && strm.eof()) {
+            return true;
+        }
+        else if (insize != SHORT_SECTION_HEADER_SIZE) {
+            report.error(u"truncated section%s", {UString::AfterBytes(std::streampos(offset))});
+            return false;
+        }
+
+        Entry entry;
+        entry.offset = offset;
+        entry.tid = header[0];
+        entry.long_section = (header[1] & 0x80) != 0;
+        entry.size = SHORT_SECTION_HEADER_SIZE + (GetUInt16(header + 1) & 0x0FFF);
+        size_t skip = entry.size - SHORT_SECTION_HEADER_SIZE;
+
+        // Read the rest of the long header.
+        if (entry.long_section) {
+            const size_t more = LONG_SECTION_HEADER_SIZE - SHORT_SECTION_HEADER_SIZE;
+            if (skip < more + SECTION_CRC32_SIZE) {
+                report.error(u"invalid section%s", {UString::AfterBytes(std::streampos(offset))});
+                return false;
+            }
+            strm.read(reinterpret_cast<char*>(header + SHORT_SECTION_HEADER_SIZE), std::streamsize(more));
+            if (size_t(strm.gcount()) != more) {
+                report.error(u"truncated section%s", {UString::AfterBytes(std::streampos(offset))});
+                return false;
+            }
+            entry.tid_ext = GetUInt16(header + 3);
+            entry.version = (header[5] >> 1) & 0x1F;
+            entry.section_number = header[6];
+            skip -= more;
+        }
+
+        // Skip the rest of the section.
+        strm.seekg(std::streamoff(skip), std::ios::cur);
+        if (!strm) {
+            report.error(u"truncated section%s", {UString::AfterBytes(std::streampos(offset))});
+            return false;
+        }
+        add(entry);
+        offset += entry.size;
+    }
+}
+
+
+//----------------------------------------------------------------------------
+// Read one section from a binary section file.
+//----------------------------------------------------------------------------
+
+ts::SectionPtr ts::SectionFileIndex::ReadSection(std::istream& strm, const Entry& entry, CRC32::Validation crc_op, Report& report)
+{
+    ByteBlockPtr data(new ByteBlock(entry.size));
+    CheckNonNull(data.pointer());
+
+    strm.clear();
+    strm.seekg(std::streamoff(entry.offset), std::ios::beg);
+    strm.read(reinterpret_cast<char*>(data->data()), std::streamsize(entry.size));
+    if (size_t(strm.gcount()) != entry.size) {
+        report.error(u"truncated section%s", {UString::AfterBytes(std::streampos(entry.offset))});
+        return SectionPtr();
+    }
+
+    SectionPtr section(new Section(data, entry.pid, crc_op));
+    CheckNonNull(section.pointer());
+    if (!section->isValid() || section->tableId() != entry.tid) {
+        report.error(u"invalid section%s, inconsistent index", {UString::AfterBytes(std::streampos(entry.offset))});
+        return SectionPtr();
+    }
+    section->setFirstTSPacketIndex(entry.packet);
+    return section;
+}
@@ -0,0 +1,268 @@
+//----------------------------------------------------------------------------
+//
+// TSDuck - The MPEG Transport Stream Toolkit
+// Copyright (c) 2005-2020, Thierry Lelegard
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+// THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------
+//!
+//!  @file
+//!  Index of a binary section file.
+//!
+//----------------------------------------------------------------------------
+
+#pragma once
+#include "tsSection.h"
+#include "tsTime.h"
+#include "tsCerrReport.h"
+
+namespace ts {
+    //!
+    //! Index of a binary section file.
+    //! @ingroup mpeg
+    //!
+    //! A binary section file is a plain concatenation of sections (see SectionFile).
+    //! Finding a given section requires reading the complete file. For huge files,
+    //! such as long captures of all sections of a stream, an index can be stored in
+    //! a separate file. Each entry of the index describes one section: position and
+    //! size in the binary file, PID, table id, table id extension, version, section
+    //! number, index of the first TS packet in the stream and time of collection.
+    //! Using the index, a subset of the sections can be read without loading the
+    //! complete binary file.
+    //!
+    //! The index file starts with a 16-byte header: the 8-byte string "TSSECIDX",
+    //! a 32-bit format version and a 32-bit record size. It is followed by one fixed-size
+    //! record per section, in the order of the sections in the binary file. All integers
+    //! are big endian. Because the records have a fixed size, the index file can be written
+    //! incrementally during a capture (see the option @c -\-binary-index in TablesLogger).
+    //!
+    //! An index can also be rebuilt from an existing binary section file by scanning the
+    //! section headers only. In that case, the PID, the packet index and the timestamp
+    //! are unknown.
+    //!
+    class TSDUCKDLL SectionFileIndex
+    {
+    public:
+        //!
+        //! Description of one section in the binary file.
+        //!
+        struct TSDUCKDLL Entry
+        {
+            uint64_t      offset;          //!< Offset of the section in the binary file.
+            size_t        size;            //!< Size in bytes of the section.
+            PID           pid;             //!< PID from which the section was collected, PID_NULL if unknown.
+            TID           tid;             //!< Table id.
+            uint16_t      tid_ext;         //!< Table id extension (long sections only).
+            uint8_t       version;         //!< Version (long sections only).
+            uint8_t       section_number;  //!< Section number (long sections only).
+            bool          long_section;    //!< True for a long section.
+            PacketCounter packet;          //!< Index of the first TS packet of the section in the stream.
+            Time          timestamp;       //!< UTC time of collection of the section, Time::Epoch if unknown.
+
+            //!
+            //! Default constructor.
+            //!
+            Entry();
+
+            //!
+            //! Constructor from a section.
+            //! @param [in] section The section to describe.
+            //! @param [in] offset Offset of the section in the binary file.
+            //! @param [in] timestamp UTC time of collection of the section.
+            //!
+            Entry(const Section& section, uint64_t offset, const Time& timestamp = Time::Epoch);
+        };
+
+        //!
+        //! Vector of index entries.
+        //!
+        typedef std::vector<Entry> EntryVector;
+
+        //!
+        //! Criteria to select sections in an index.
+        //! All criteria must match. An empty set matches all values.
+        //!
+        struct TSDUCKDLL Filter
+        {
+            PIDSet             pids;      //!< PID values to select. No PID set means all PID's.
+            std::set<uint8_t>  tids;      //!< Table id values to select.
+            std::set<uint16_t> tid_exts;  //!< Table id extension values to select (long sections only).
+            Time               start;     //!< Select sections which were collected at or after this time.
+            Time               end;       //!< Select sections which were collected before this time.
+
+            //!
+            //! Default constructor, select all sections.
+            //!
+            Filter();
+
+            //!
+            //! Check if an index entry matches the filter.
+            //! @param [in] entry The entry to check.
+            //! @return True if @a entry matches all criteria.
+            //!
+            bool match(const Entry& entry) const;
+
+            //!
+            //! Check if the filter uses criteria which are known only in an index from a capture.
+            //! The PID and the time of collection are unknown in an index which was built by
+            //! scanning a binary section file. Such an index never matches these criteria.
+            //! @return True if the filter selects PID's or a time range.
+            //!
+            bool needsCollectionInfo() const;
+        };
+
+        //!
+        //! Size in bytes of the header of an index file.
+        //!
+        static constexpr size_t HEADER_SIZE = 16;
+
+        //!
+        //! Size in bytes of each record in an index file.
+        //!
+        static constexpr size_t RECORD_SIZE = 32;
+
+        //!
+        //! Default constructor.
+        //!
+        SectionFileIndex();
+
+        //!
+        //! Clear the content of the index.
+        //!
+        void clear();
+
+        //!
+        //! Get the number of entries in the index.
+        //! @return The number of entries in the index.
+        //!
+        size_t size() const { return _entries.size(); }
+
+        //!
+        //! Get all entries in the index.
+        //! @return A constant reference to the entries, in the order of the binary file.
+        //!
+        const EntryVector& entries() const { return _entries; }
+
+        //!
+        //! Add an entry at the end of the index.
+        //! @param [in] entry The entry to add.
+        //!
+        void add(const Entry& entry);
+
+        //!
+        //! Select the entries matching a filter.
+        //! When the entries are in chronological order, which is the case when the index was
+        //! written during a capture, the time range is located using a binary search.
+        //! @param [in] filter Selection criteria.
+        //! @param [out] entries The selected entries, in the order of the binary file.
+        //!
+        void select(const Filter& filter, EntryVector& entries) const;
+
+        //!
+        //! Load an index file.
+        //! A truncated record at the end of the file, for instance after an interrupted capture, is ignored.
+        //! @param [in] file_name Index file name.
+        //! @param [in,out] report Where to report errors.
+        //! @return True on success, false on error.
+        //!
+        bool load(const UString& file_name, Report& report = CERR);
+
+        //!
+        //! Load an index file.
+        //! @param [in,out] strm Input stream, must be open in binary mode.
+        //! @param [in,out] report Where to report errors.
+        //! @return True on success, false on error.
+        //!
+        bool load(std::istream& strm, Report& report = CERR);
+
+        //!
+        //! Save the index in a file.
+        //! @param [in] file_name Index file name.
+        //! @param [in,out] report Where to report errors.
+        //! @return True on success, false on error.
+        //!
+        bool save(const UString& file_name, Report& report = CERR) const;
+
+        //!
+        //! Save the index in a stream.
+        //! @param [in,out] strm Output stream, must be open in binary mode.
+        //! @param [in,out] report Where to report errors.
+        //! @return True on success, false on error.
+        //!
+        bool save(std::ostream& strm, Report& report = CERR) const;
+
+        //!
+        //! Build the index of an existing binary section file.
+        //! Only the section headers are read, the rest of each section is skipped.
+        //! @param [in] file_name Binary section file name.
+        //! @param [in,out] report Where to report errors.
+        //! @return True on success, false on error.
+        //!
+        bool build(const UString& file_name, Report& report = CERR);
+
+        //!
+        //! Build the index of an existing binary section file.
+        //! @param [in,out] strm Input stream, must be open in binary mode and seekable.
+        //! @param [in,out] report Where to report errors.
+        //! @return True on success, false on error.
+        //!
+        bool build(std::istream& strm, Report& report = CERR);
+
+        //!
+        //! Read one section from a binary section file.
+        //! @param [in,out] strm Binary section file, must be open in binary mode and seekable.
+        //! @param [in] entry Index entry of the section to read.
+        //! @param [in] crc_op How to process the CRC32.
+        //! @param [in,out] report Where to report errors.
+        //! @return A safe pointer to the section or a null pointer on error.
+        //!
+        static SectionPtr ReadSection(std::istream& strm, const Entry& entry, CRC32::Validation crc_op = CRC32::IGNORE, Report& report = CERR);
+
+        //!
+        //! Write the header of an index file.
+        //! @param [in,out] strm Output stream, must be open in binary mode.
+        //! @return True on success, false on error.
+        //!
+        static bool WriteHeader(std::ostream& strm);
+
+        //!
+        //! Write one record in an index file.
+        //! @param [in,out] strm Output stream, must be open in binary mode.
+        //! @param [in] entry The entry to write.
+        //! @return True on success, false on error.
+        //!
+        static bool WriteEntry(std::ostream& strm, const Entry& entry);
+
+        //!
+        //! Get the default name of the index file of a binary section file.
+        //! @param [in] file_name Binary section file name.
+        //! @return The default index file name (the binary file name with an additional ".idx").
+        //!
+        static UString DefaultFileName(const UString& file_name) { return file_name + u".idx"; }
+
+    private:
+        EntryVector _entries;  // All entries, in the order of the binary file.
+        bool        _sorted;   // Entries are in chronological order.
+    };
+}
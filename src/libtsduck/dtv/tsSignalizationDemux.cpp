@@ -40,6 +40,7 @@ ts::SignalizationDemux::SignalizationDemux(DuckContext& duck, SignalizationHandl
     _duck(duck),
     _demux(duck, this, this),
     _handler(handler),
+    _bin_handler(nullptr),
     _tids(),
     _service_ids(),
     _last_pat(),
@@ -371,6 +372,9 @@ void ts::SignalizationDemux::handleTable(SectionDemux&, const BinaryTable& table
             }
 
             // Notify the PAT to the application.
+            if (_bin_handler != nullptr && hasTableId(TID_PAT)) {
+                _bin_handler->handleTable(_demux, table);
+            }
             if (_handler != nullptr && hasTableId(TID_PAT)) {
                 _last_pat_handled = true;
                 _handler->handlePAT(pat, pid);
@@ -380,109 +384,133 @@ void ts::SignalizationDemux::handleTable(SectionDemux&, const BinaryTable& table
 
     // Other tables have no special treatment. They are directly passed to the application.
     // PMT may be selectively filtered by service id (table id extention).
-    else if (_handler != nullptr && (hasTableId(tid) || (tid == TID_PMT && hasServiceId(table.tableIdExtension())))) {
-        switch (tid) {
-            case TID_CAT: {
-                const CAT cat(_duck, table);
-                if (cat.isValid() && pid == PID_CAT) {
-                    _handler->handleCAT(cat, pid);
-                }
-                break;
+    else if (hasTableId(tid) || (tid == TID_PMT && hasServiceId(table.tableIdExtension()))) {
+        if (_bin_handler != nullptr) {
+            _bin_handler->handleTable(_demux, table);
+        }
+        if (_handler != nullptr) {
+            DispatchTable(_duck, *_handler, table, nitPID());
+        }
+    }
+}
+
+
+//----------------------------------------------------------------------------
+// Deserialize a binary table and invoke the corresponding signalization handler.
+//----------------------------------------------------------------------------
+
+void ts::SignalizationDemux::DispatchTable(DuckContext& duck, SignalizationHandlerInterface& handler, const BinaryTable& table, PID nit_pid)
+{
+    const PID pid = table.sourcePID();
+
+    switch (table.tableId()) {
+        case TID_PAT: {
+            const PAT pat(duck, table);
+            if (pat.isValid() && pid == PID_PAT) {
+                handler.handlePAT(pat, pid);
             }
-            case TID_PMT: {
-                const PMT pmt(_duck, table);
-                if (pmt.isValid()) {
-                    _handler->handlePMT(pmt, pid);
-                }
-                break;
+            break;
+        }
+        case TID_CAT: {
+            const CAT cat(duck, table);
+            if (cat.isValid() && pid == PID_CAT) {
+                handler.handleCAT(cat, pid);
             }
-            case TID_TSDT: {
-                const TSDT tsdt(_duck, table);
-                if (tsdt.isValid() && pid == PID_TSDT) {
-                    _handler->handleTSDT(tsdt, pid);
-                }
-                break;
+            break;
+        }
+        case TID_PMT: {
+            const PMT pmt(duck, table);
+            if (pmt.isValid()) {
+                handler.handlePMT(pmt, pid);
             }
-            case TID_NIT_ACT:
-            case TID_NIT_OTH:  {
-                const NIT nit(_duck, table);
-                if (nit.isValid() && pid == nitPID()) {
-                    _handler->handleNIT(nit, pid);
-                }
-                break;
+            break;
+        }
+        case TID_TSDT: {
+            const TSDT tsdt(duck, table);
+            if (tsdt.isValid() && pid == PID_TSDT) {
+                handler.handleTSDT(tsdt, pid);
             }
-            case TID_SDT_ACT:
-            case TID_SDT_OTH:  {
-                const SDT sdt(_duck, table);
-                if (sdt.isValid() && pid == PID_SDT) {
-                    _handler->handleSDT(sdt, pid);
-                }
-                break;
+            break;
+        }
+        case TID_NIT_ACT:
+        case TID_NIT_OTH:  {
+            const NIT nit(duck, table);
+            if (nit.isValid() && pid == nit_pid) {
+                handler.handleNIT(nit, pid);
             }
-            case TID_BAT: {
-                const BAT bat(_duck, table);
-                if (bat.isValid() && pid == PID_BAT) {
-                    _handler->handleBAT(bat, pid);
-                }
-                break;
+            break;
+        }
+        case TID_SDT_ACT:
+        case TID_SDT_OTH:  {
+            const SDT sdt(duck, table);
+            if (sdt.isValid() && pid == PID_SDT) {
+                handler.handleSDT(sdt, pid);
             }
-            case TID_RST: {
-                const RST rst(_duck, table);
-                if (rst.isValid() && pid == PID_RST) {
-                    _handler->handleRST(rst, pid);
-                }
-                break;
+            break;
+        }
+        case TID_BAT: {
+            const BAT bat(duck, table);
+            if (bat.isValid() && pid == PID_BAT) {
+                handler.handleBAT(bat, pid);
             }
-            case TID_TDT: {
-                const TDT tdt(_duck, table);
-                if (tdt.isValid() && pid == PID_TDT) {
-                    _handler->handleTDT(tdt, pid);
-                }
-                break;
+            break;
+        }
+        case TID_RST: {
+            const RST rst(duck, table);
+            if (rst.isValid() && pid == PID_RST) {
+                handler.handleRST(rst, pid);
             }
-            case TID_TOT: {
-                const TOT tot(_duck, table);
-                if (tot.isValid() && pid == PID_TOT) {
-                    _handler->handleTOT(tot, pid);
-                }
-                break;
+            break;
+        }
+        case TID_TDT: {
+            const TDT tdt(duck, table);
+            if (tdt.isValid() && pid == PID_TDT) {
+                handler.handleTDT(tdt, pid);
             }
-            case TID_MGT: {
-                const MGT mgt(_duck, table);
-                if (mgt.isValid() && pid == PID_PSIP) {
-                    _handler->handleMGT(mgt, pid);
-                }
-                break;
+            break;
+        }
+        case TID_TOT: {
+            const TOT tot(duck, table);
+            if (tot.isValid() && pid == PID_TOT) {
+                handler.handleTOT(tot, pid);
             }
-            case TID_CVCT: {
-                const CVCT vct(_duck, table);
-                if (vct.isValid() && pid == PID_PSIP) {
-                    // Call specific and generic form of VCT handler.
-                    _handler->handleCVCT(vct, pid);
-                    _handler->handleVCT(vct, pid);
-                }
-                break;
+            break;
+        }
+        case TID_MGT: {
+            const MGT mgt(duck, table);
+            if (mgt.isValid() && pid == PID_PSIP) {
+                handler.handleMGT(mgt, pid);
             }
-            case TID_TVCT: {
-                const TVCT vct(_duck, table);
-                if (vct.isValid() && pid == PID_PSIP) {
-                    // Call specific and generic form of VCT handler.
-                    _handler->handleTVCT(vct, pid);
-                    _handler->handleVCT(vct, pid);
-                }
-                break;
+            break;
+        }
+        case TID_CVCT: {
+            const CVCT vct(duck, table);
+            if (vct.isValid() && pid == PID_PSIP) {
+                // Call specific and generic form of VCT handler.
+                handler.handleCVCT(vct, pid);
+                handler.handleVCT(vct, pid);
             }
-            case TID_RRT: {
-                const RRT rrt(_duck, table);
-                if (rrt.isValid() && pid == PID_PSIP) {
-                    _handler->handleRRT(rrt, pid);
-                }
-                break;
+            break;
+        }
+        case TID_TVCT: {
+            const TVCT vct(duck, table);
+            if (vct.isValid() && pid == PID_PSIP) {
+                // Call specific and generic form of VCT handler.
+                handler.handleTVCT(vct, pid);
+                handler.handleVCT(vct, pid);
             }
-            default: {
-                // Unsupported table id or processed elsewhere (PAT, STT).
-                break;
+            break;
+        }
+        case TID_RRT: {
+            const RRT rrt(duck, table);
+            if (rrt.isValid() && pid == PID_PSIP) {
+                handler.handleRRT(rrt, pid);
             }
+            break;
+        }
+        default: {
+            // Unsupported table id or processed elsewhere (STT).
+            break;
         }
     }
 }
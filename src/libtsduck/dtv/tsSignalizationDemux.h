@@ -73,6 +73,25 @@ namespace ts {
         //!
         void setTableHandler(SignalizationHandlerInterface* handler) { _handler = handler; }
 
+        //!
+        //! Set an additional handler which receives the filtered tables in binary form.
+        //! The binary handler is invoked with exactly the same tables as the signalization
+        //! handler, before their deserialization. This is typically used to share the
+        //! demuxed tables with other contexts, see DispatchTable().
+        //! @param [in] handler The new binary table handler. Can be null.
+        //!
+        void setBinaryTableHandler(TableHandlerInterface* handler) { _bin_handler = handler; }
+
+        //!
+        //! Deserialize a binary table and invoke the corresponding method of a signalization handler.
+        //! Invalid tables, unsupported tables and tables on unexpected PID's are silently ignored.
+        //! @param [in,out] duck TSDuck execution context which is used to deserialize the table.
+        //! @param [in,out] handler The object to invoke.
+        //! @param [in] table The binary table to dispatch.
+        //! @param [in] nit_pid The expected PID of the NIT.
+        //!
+        static void DispatchTable(DuckContext& duck, SignalizationHandlerInterface& handler, const BinaryTable& table, PID nit_pid = PID_NIT);
+
         //!
         //! Reset the demux, remove all signalization filters.
         //!
@@ -141,6 +160,7 @@ namespace ts {
         DuckContext&                   _duck;
         SectionDemux                   _demux;
         SignalizationHandlerInterface* _handler;
+        TableHandlerInterface*         _bin_handler;      // Optional handler for binary tables.
         std::set<TID>                  _tids;             // Set of filtered table id's.
         std::set<uint16_t>             _service_ids;      // Set of filtered service id's.
         PAT                            _last_pat;         // Last received PAT.
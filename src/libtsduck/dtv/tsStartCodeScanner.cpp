@@ -0,0 +1,192 @@
+//----------------------------------------------------------------------------
+//
+// TSDuck - The MPEG Transport Stream Toolkit
+// Copyright (c) 2005-2020, Thierry Lelegard
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+// THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------
+
+#include "tsStartCodeScanner.h"
+#if defined(TS_X86_64) || (defined(TS_I386) && defined(__SSE2__))
+#define TS_SCANNER_SSE2 1
+#include <emmintrin.h>
+#elif defined(TS_ARM64)
+#define TS_SCANNER_NEON 1
+#include <arm_neon.h>
+#endif
+TSDUCK_SOURCE;
+
+
+//----------------------------------------------------------------------------
+// Constructor.
+//----------------------------------------------------------------------------
+
+ts::StartCodeScanner::StartCodeScanner() :
+    _data(nullptr),
+    _size(0),
+    _delimiters(),
+    _epb()
+{
+}
+
+
+//----------------------------------------------------------------------------
+// Scan a memory area.
+//----------------------------------------------------------------------------
+
+void ts::StartCodeScanner::scan(const void* data, size_t size)
+{
+    _data = reinterpret_cast<const uint8_t*>(data);
+    _size = _data == nullptr ? 0 : size;
+    _delimiters.clear();
+    _epb.clear();
+
+    // We look for all offsets p where data[p] == 0, data[p+1] == 0, data[p+2] <= 3.
+    size_t p = 0;
+
+#if defined(TS_SCANNER_SSE2)
+
+    // Check 16 offsets at a time, using 3 overlapping loads.
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i three = _mm_set1_epi8(3);
+    for (; p + 18 <= _size; p += 16) {
+        const __m128i b0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(_data + p));
+        const __m128i b1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(_data + p + 1));
+        const __m128i b2 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(_data + p + 2));
+        const __m128i zeros = _mm_and_si128(_mm_cmpeq_epi8(b0, zero), _mm_cmpeq_epi8(b1, zero));
+        const __m128i small = _mm_cmpeq_epi8(_mm_min_epu8(b2, three), b2);
+        int mask = _mm_movemask_epi8(_mm_and_si128(zeros, small));
+        for (size_t i = p; mask != 0; ++i, mask >>= 1) {
+            if ((mask & 1) != 0) {
+                found(i);
+            }
+        }
+    }
+
+#elif defined(TS_SCANNER_NEON)
+
+    // Check 16 offsets at a time, using 3 overlapping loads.
+    const uint8x16_t zero = vdupq_n_u8(0);
+    const uint8x16_t three = vdupq_n_u8(3);
+    for (; p + 18 <= _size; p += 16) {
+        const uint8x16_t b0 = vld1q_u8(_data + p);
+        const uint8x16_t b1 = vld1q_u8(_data + p + 1);
+        const uint8x16_t b2 = vld1q_u8(_data + p + 2);
+        const uint8x16_t match = vandq_u8(vandq_u8(vceqq_u8(b0, zero), vceqq_u8(b1, zero)), vcleq_u8(b2, three));
+        if (vmaxvq_u8(match) != 0) {
+            // At least one match, rare enough to check them one by one.
+            for (size_t i = p; i < p + 16; ++i) {
+                if (_data[i] == 0x00 && _data[i+1] == 0x00 && _data[i+2] <= 0x03) {
+                    found(i);
+                }
+            }
+        }
+    }
+
+#endif
+
+    // Remaining bytes, or all bytes without SIMD support.
+    // Using the third byte first, we can skip up to 3 bytes at a time.
+    while (p + 2 < _size) {
+        if (_data[p+2] > 0x03) {
+            p += 3;
+        }
+        else if (_data[p+1] != 0x00) {
+            p += 2;
+        }
+        else if (_data[p] != 0x00) {
+            p += 1;
+        }
+        else {
+            found(p++);
+        }
+    }
+}
+
+
+//----------------------------------------------------------------------------
+// Get the AVC or HEVC NAL units in the last scanned area.
+//----------------------------------------------------------------------------
+
+void ts::StartCodeScanner::getNALUnits(UnitVector& units) const
+{
+    units.clear();
+    for (size_t i = 0; i < _delimiters.size(); ++i) {
+        // A NAL unit starts after each 00 00 01 and ends at the next delimiter.
+        if (_data[_delimiters[i] + 2] == 0x01) {
+            const size_t start = _delimiters[i] + 3;
+            const size_t end = i + 1 < _delimiters.size() ? _delimiters[i + 1] : _size;
+            units.push_back(Unit(start, end - start));
+        }
+    }
+}
+
+
+//----------------------------------------------------------------------------
+// Get the MPEG-1 or MPEG-2 video units in the last scanned area.
+//----------------------------------------------------------------------------
+
+void ts::StartCodeScanner::getVideoUnits(UnitVector& units) const
+{
+    units.clear();
+    if (_size > 0) {
+        // The area is supposed to start with a start code, even if it does not.
+        size_t start = 0;
+        for (size_t i = 0; i < _delimiters.size(); ++i) {
+            const size_t next = _delimiters[i];
+            if (next > start && _data[next + 2] == 0x01) {
+                units.push_back(Unit(start, next - start));
+                start = next;
+            }
+        }
+        units.push_back(Unit(start, _size - start));
+    }
+}
+
+
+//----------------------------------------------------------------------------
+// Find the next emulation prevention byte in a memory area.
+//----------------------------------------------------------------------------
+
+const uint8_t* ts::StartCodeScanner::NextEmulationPrevention(const uint8_t* base, const uint8_t* from, const uint8_t* end)
+{
+    // Start of the searched 00 00 03 sequence.
+    const uint8_t* p = from - base >= 2 ? from - 2 : base;
+
+    while (p + 2 < end) {
+        if (p[2] == 0x00) {
+            p += 1;
+        }
+        else if (p[2] != 0x03) {
+            p += 3;
+        }
+        else if (p[0] == 0x00 && p[1] == 0x00) {
+            return p + 2;
+        }
+        else {
+            p += 3;
+        }
+    }
+    return nullptr;
+}
@@ -0,0 +1,148 @@
+//----------------------------------------------------------------------------
+//
+// TSDuck - The MPEG Transport Stream Toolkit
+// Copyright (c) 2005-2020, Thierry Lelegard
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+// THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------
+//!
+//!  @file
+//!  Single-pass scanner of start codes in video elementary streams.
+//!
+//----------------------------------------------------------------------------
+
+#pragma once
+#include "tsPlatform.h"
+
+namespace ts {
+    //!
+    //! Single-pass scanner of start codes in video elementary streams.
+    //! @ingroup mpeg
+    //!
+    //! MPEG-1/2 video, AVC (H.264) and HEVC (H.265) payloads are split in units
+    //! which start with the prefix 00 00 01. In AVC and HEVC, a NAL unit ends
+    //! at the next 00 00 01 or 00 00 00 sequence. Inside NAL units, the sequence
+    //! 00 00 03 introduces an "emulation prevention" byte (the 03) which is not
+    //! part of the raw byte sequence payload.
+    //!
+    //! All these sequences are "00 00 xx" with xx less than or equal to 3. This
+    //! class locates all of them in one pass over the data, using SIMD instructions
+    //! when available. The units are then built from the collected positions without
+    //! rescanning the data.
+    //!
+    class TSDUCKDLL StartCodeScanner
+    {
+        TS_NOCOPY(StartCodeScanner);
+    public:
+        //!
+        //! Location of a unit in a scanned memory area.
+        //!
+        class TSDUCKDLL Unit
+        {
+        public:
+            size_t offset;  //!< Offset of the unit in the scanned area.
+            size_t size;    //!< Size in bytes of the unit.
+
+            //!
+            //! Constructor.
+            //! @param [in] off Offset of the unit in the scanned area.
+            //! @param [in] sz Size in bytes of the unit.
+            //!
+            Unit(size_t off = 0, size_t sz = 0) : offset(off), size(sz) {}
+        };
+
+        //!
+        //! Vector of unit locations.
+        //!
+        typedef std::vector<Unit> UnitVector;
+
+        //!
+        //! Default constructor.
+        //!
+        StartCodeScanner();
+
+        //!
+        //! Scan a memory area.
+        //! The memory area must remain valid while the results are used.
+        //! @param [in] data Address of the memory area.
+        //! @param [in] size Size in bytes of the memory area.
+        //!
+        void scan(const void* data, size_t size);
+
+        //!
+        //! Get the offsets of all 00 00 00 and 00 00 01 sequences in the last scanned area.
+        //! @return A constant reference to the vector of offsets, in increasing order.
+        //!
+        const std::vector<size_t>& delimiters() const { return _delimiters; }
+
+        //!
+        //! Get the offsets of all emulation prevention bytes in the last scanned area.
+        //! @return A constant reference to the vector of offsets of the 03 bytes after 00 00, in increasing order.
+        //!
+        const std::vector<size_t>& emulationPreventionBytes() const { return _epb; }
+
+        //!
+        //! Get the AVC or HEVC NAL units in the last scanned area.
+        //! Each NAL unit starts after a 00 00 01 prefix (the prefix is not part of the NAL unit)
+        //! and ends before the next 00 00 00 or 00 00 01 sequence or at the end of the area.
+        //! @param [out] units Returned locations of the NAL units.
+        //!
+        void getNALUnits(UnitVector& units) const;
+
+        //!
+        //! Get the MPEG-1 or MPEG-2 video units in the last scanned area.
+        //! The area is supposed to start with a start code prefix. Each unit starts with a
+        //! 00 00 01 prefix (the prefix is part of the unit) and ends before the next one.
+        //! @param [out] units Returned locations of the video units.
+        //!
+        void getVideoUnits(UnitVector& units) const;
+
+        //!
+        //! Find the next emulation prevention byte in a memory area.
+        //! @param [in] base Address of the complete memory area. Preceding 00 00 bytes are never searched before @a base.
+        //! @param [in] from Address where to start the search.
+        //! @param [in] end End of the memory area.
+        //! @return Address of the first 03 byte at or after @a from which follows 00 00, or a null pointer if there is none.
+        //!
+        static const uint8_t* NextEmulationPrevention(const uint8_t* base, const uint8_t* from, const uint8_t* end);
+
+    private:
+        const uint8_t*      _data;        // Last scanned area.
+        size_t              _size;        // Size of last scanned area.
+        std::vector<size_t> _delimiters;  // Offsets of 00 00 00 and 00 00 01.
+        std::vector<size_t> _epb;         // Offsets of 03 in 00 00 03.
+
+        // Record a 00 00 xx sequence at the given offset.
+        void found(size_t offset)
+        {
+            const uint8_t code = _data[offset + 2];
+            if (code <= 0x01) {
+                _delimiters.push_back(offset);
+            }
+            else if (code == 0x03) {
+                _epb.push_back(offset + 2);
+            }
+        }
+    };
+}
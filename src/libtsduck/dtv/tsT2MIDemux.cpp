@@ -317,17 +317,16 @@ void ts::T2MIDemux::demuxTS(PID pid, PIDContext& pc, const T2MIPacket& pkt)
         }
     }
 
-    // Now process each complete TS packet.
-    while (plpp->ts_next + PKT_SIZE <= plpp->ts.size()) {
-
-        // Build the TS packet.
-        TSPacket tsPkt;
-        ::memcpy(tsPkt.b, &plpp->ts[plpp->ts_next], PKT_SIZE);
-        plpp->ts_next += PKT_SIZE;
+    // Now process all complete TS packets in one batch. TSPacket is a plain array of
+    // bytes, the contiguous packets are directly passed from the TS buffer.
+    const size_t count = (plpp->ts.size() - plpp->ts_next) / PKT_SIZE;
+    if (count > 0) {
+        const TSPacket* packets = reinterpret_cast<const TSPacket*>(&plpp->ts[plpp->ts_next]);
+        plpp->ts_next += count * PKT_SIZE;
 
         // Notify the application. Note that we are already in a protected section.
         if (_handler != nullptr) {
-            _handler->handleTSPacket(*this, pkt, tsPkt);
+            _handler->handleTSPackets(*this, pkt, packets, count);
         }
     }
 
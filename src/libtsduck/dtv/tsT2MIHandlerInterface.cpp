@@ -33,3 +33,10 @@ TSDUCK_SOURCE;
 ts::T2MIHandlerInterface::~T2MIHandlerInterface()
 {
 }
+
+void ts::T2MIHandlerInterface::handleTSPackets(T2MIDemux& demux, const T2MIPacket& t2mi, const TSPacket* packets, size_t count)
+{
+    for (size_t i = 0; i < count; ++i) {
+        handleTSPacket(demux, t2mi, packets[i]);
+    }
+}
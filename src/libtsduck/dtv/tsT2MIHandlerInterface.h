@@ -77,6 +77,20 @@ namespace ts {
         //!
         virtual void handleTSPacket(T2MIDemux& demux, const T2MIPacket& t2mi, const TSPacket& ts) = 0;
 
+        //!
+        //! This hook is invoked when TS packets are extracted from a T2-MI packet.
+        //! All TS packets which are extracted from the same T2-MI packet are passed in one call.
+        //! They all belong to the same PLP. This is the preferred hook for applications which
+        //! route complete PLP's to separate outputs. The packets are passed from the internal
+        //! buffer of the demux and the application shall not keep the address after returning.
+        //! The default implementation invokes handleTSPacket() for each packet.
+        //! @param [in,out] demux A reference to the T2-MI demux.
+        //! @param [in] t2mi The T2-MI packet from which the packets were extracted.
+        //! @param [in] packets Address of the first extracted TS packet.
+        //! @param [in] count Number of extracted TS packets.
+        //!
+        virtual void handleTSPackets(T2MIDemux& demux, const T2MIPacket& t2mi, const TSPacket* packets, size_t count);
+
         //!
         //! Virtual destructor.
         //!
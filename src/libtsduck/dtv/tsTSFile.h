@@ -140,6 +140,12 @@ namespace ts {
         //!
         bool isOpen() const { return _is_open; }
 
+        //!
+        //! Check if the open file is a regular file (ie. not a pipe or special device).
+        //! @return True if the open file is a regular file.
+        //!
+        bool isRegularFile() const { return _is_open && _regular; }
+
         //!
         //! Get the file name.
         //! @return The file name.
@@ -212,7 +212,7 @@ size_t ts::TSFileInputBuffered::read(TSPacket* user_buffer, size_t max_packets,
     // The following loop is executed from 0 to 2 times only.
     while (_current_offset < _total_count && max_packets > 0) {
         const size_t current_index = (_first_index + _current_offset) % buffer_size;
-        const size_t count = std::min(max_packets, buffer_size - current_index);
+        const size_t count = std::min(max_packets, std::min(_total_count - _current_offset, buffer_size - current_index));
         assert(count > 0);
         TSPacket::Copy(user_buffer, &_buffer[current_index], count);
         if (user_metadata != nullptr) {
@@ -0,0 +1,290 @@
+//----------------------------------------------------------------------------
+//
+// TSDuck - The MPEG Transport Stream Toolkit
+// Copyright (c) 2005-2020, Thierry Lelegard
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+// THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------
+
+#include "tsTSFileSeekIndex.h"
+#include "tsSysUtils.h"
+#include "tsTime.h"
+TSDUCK_SOURCE;
+
+#if defined(TS_NEED_STATIC_CONST_DEFINITIONS)
+constexpr ts::PacketCounter ts::TSFileSeekIndex::DEFAULT_INTERVAL;
+#endif
+
+// Number of packets per read operation when scanning the file.
+#define SCAN_PACKETS 128
+
+// First line of an index file, followed by the file characteristics.
+#define INDEX_MAGIC u"tsidx"
+#define INDEX_VERSION 1
+
+
+//----------------------------------------------------------------------------
+// Constructor.
+//----------------------------------------------------------------------------
+
+ts::TSFileSeekIndex::TSFileSeekIndex(PacketCounter interval) :
+    _interval(std::max<PacketCounter>(1, interval)),
+    _file_size(0),
+    _file_date(0),
+    _packet_size(0),
+    _pcr_pid(PID_NULL),
+    _entries()
+{
+}
+
+void ts::TSFileSeekIndex::clear()
+{
+    _file_size = 0;
+    _file_date = 0;
+    _packet_size = 0;
+    _pcr_pid = PID_NULL;
+    _entries.clear();
+}
+
+
+//----------------------------------------------------------------------------
+// Make sure the format of the file is known, get the file characteristics.
+//----------------------------------------------------------------------------
+
+bool ts::TSFileSeekIndex::GetFileProperties(TSFile& file, int64_t& size, MilliSecond& date, size_t& packet_size, Report& report)
+{
+    // With auto-detection, the format is known after reading the first packet.
+    if (file.packetFormat() == TSPacketFormat::AUTODETECT) {
+        TSPacket pkt;
+        if (!file.rewind(report) || file.readPackets(&pkt, nullptr, 1, report) == 0) {
+            report.error(u"cannot read %s", {file.getDisplayFileName()});
+            return false;
+        }
+    }
+
+    size = GetFileSize(file.getFileName());
+    date = GetFileModificationTimeUTC(file.getFileName()) - Time::Epoch;
+    packet_size = file.packetHeaderSize() + PKT_SIZE;
+    if (size < 0) {
+        report.error(u"cannot get size of %s", {file.getDisplayFileName()});
+        return false;
+    }
+    return true;
+}
+
+
+//----------------------------------------------------------------------------
+// Read packets until a PCR on the reference PID is found.
+//----------------------------------------------------------------------------
+
+bool ts::TSFileSeekIndex::NextPCR(TSFile& file, PacketCounter& packet, PacketCounter max_packets, PID& pid, uint64_t& pcr, Report& report)
+{
+    TSPacket pkts[SCAN_PACKETS];
+    while (max_packets > 0) {
+        const size_t count = file.readPackets(pkts, nullptr, size_t(std::min<PacketCounter>(SCAN_PACKETS, max_packets)), report);
+        if (count == 0) {
+            return false;
+        }
+        for (size_t i = 0; i < count; ++i) {
+            if (pkts[i].hasPCR() && (pid == PID_NULL || pkts[i].getPID() == pid)) {
+                pid = pkts[i].getPID();
+                pcr = pkts[i].getPCR();
+                packet += i;
+                return true;
+            }
+        }
+        packet += count;
+        max_packets -= count;
+    }
+    return false;
+}
+
+
+//----------------------------------------------------------------------------
+// Build the index of a transport stream file.
+//----------------------------------------------------------------------------
+
+bool ts::TSFileSeekIndex::build(TSFile& file, Report& report)
+{
+    clear();
+    if (!GetFileProperties(file, _file_size, _file_date, _packet_size, report)) {
+        return false;
+    }
+
+    // Look for the first PCR in each interval. Since each interval is fully scanned
+    // when it contains no PCR, the first entry is the first PCR in the file.
+    const PacketCounter total = PacketCounter(_file_size) / _packet_size;
+    for (PacketCounter start = 0; start < total; start += _interval) {
+        PacketCounter packet = start;
+        uint64_t pcr = 0;
+        if (!file.seek(start, report)) {
+            clear();
+            return false;
+        }
+        if (NextPCR(file, packet, _interval, _pcr_pid, pcr, report)) {
+            const uint64_t time = _entries.empty() ? 0 : _entries.back().time + (pcr + PCR_SCALE - _entries.back().pcr) % PCR_SCALE;
+            _entries.push_back(Entry(packet, pcr, time));
+        }
+    }
+
+    if (_entries.empty()) {
+        report.error(u"no PCR found in %s", {file.getDisplayFileName()});
+        return false;
+    }
+    report.debug(u"indexed %s, %d entries, PCR PID 0x%X (%d)", {file.getDisplayFileName(), _entries.size(), _pcr_pid, _pcr_pid});
+    return true;
+}
+
+
+//----------------------------------------------------------------------------
+// Find the first packet at or after a given time.
+//----------------------------------------------------------------------------
+
+bool ts::TSFileSeekIndex::findPacket(TSFile& file, uint64_t time, PacketCounter& packet, Report& report) const
+{
+    if (_entries.empty()) {
+        report.error(u"no seek index for %s", {file.getDisplayFileName()});
+        return false;
+    }
+
+    // Binary search of the first entry at or after the requested time.
+    auto it = std::lower_bound(_entries.begin(), _entries.end(), time, [](const Entry& e, uint64_t t) { return e.time < t; });
+    if (it == _entries.begin() || (it != _entries.end() && it->time == time)) {
+        // The first PCR in the file or an exact match in the index.
+        packet = it->packet;
+        return true;
+    }
+
+    // The first matching PCR is after the previous entry, at or before the current one.
+    // Scan all packets from the previous entry.
+    const Entry& prev(*--it);
+    if (!file.seek(prev.packet + 1, report)) {
+        return false;
+    }
+    TSPacket pkts[SCAN_PACKETS];
+    PacketCounter index = prev.packet + 1;
+    uint64_t last_pcr = prev.pcr;
+    uint64_t last_time = prev.time;
+    size_t count = 0;
+    while ((count = file.readPackets(pkts, nullptr, SCAN_PACKETS, report)) > 0) {
+        for (size_t i = 0; i < count; ++i) {
+            if (pkts[i].hasPCR() && pkts[i].getPID() == _pcr_pid) {
+                const uint64_t pcr = pkts[i].getPCR();
+                last_time += (pcr + PCR_SCALE - last_pcr) % PCR_SCALE;
+                last_pcr = pcr;
+                if (last_time >= time) {
+                    packet = index + i;
+                    return true;
+                }
+            }
+        }
+        index += count;
+    }
+
+    report.error(u"time %'d ms is after the last PCR in %s", {time / (SYSTEM_CLOCK_FREQ / MilliSecPerSec), file.getDisplayFileName()});
+    return false;
+}
+
+
+//----------------------------------------------------------------------------
+// Save the index in a text file.
+//----------------------------------------------------------------------------
+
+bool ts::TSFileSeekIndex::save(const UString& fileName, Report& report) const
+{
+    std::ofstream strm(fileName.toUTF8().c_str(), std::ios::out);
+    if (!strm) {
+        report.error(u"cannot create %s", {fileName});
+        return false;
+    }
+
+    strm << UString::Format(u"%s %d %d %d %d %d %d", {INDEX_MAGIC, INDEX_VERSION, _file_size, _file_date, _packet_size, _pcr_pid, _interval}) << std::endl;
+    for (auto it = _entries.begin(); it != _entries.end(); ++it) {
+        strm << it->packet << " " << it->pcr << " " << it->time << std::endl;
+    }
+    strm.close();
+
+    if (!strm) {
+        report.error(u"error writing %s", {fileName});
+        return false;
+    }
+    report.debug(u"saved seek index in %s", {fileName});
+    return true;
+}
+
+
+//----------------------------------------------------------------------------
+// Load the index from a text file.
+//----------------------------------------------------------------------------
+
+bool ts::TSFileSeekIndex::load(const UString& fileName, TSFile& file, Report& report)
+{
+    clear();
+
+    UStringList lines;
+    if (!UString::Load(lines, fileName)) {
+        report.error(u"error reading %s", {fileName});
+        return false;
+    }
+
+    // Check that the index was built on the same content.
+    int64_t size = 0;
+    MilliSecond date = 0;
+    size_t packet_size = 0;
+    int version = 0;
+    if (!GetFileProperties(file, size, date, packet_size, report)) {
+        return false;
+    }
+    if (lines.empty() ||
+        !lines.front().scan(INDEX_MAGIC u" %d %d %d %d %d %d", {&version, &_file_size, &_file_date, &_packet_size, &_pcr_pid, &_interval}) ||
+        version != INDEX_VERSION)
+    {
+        report.error(u"invalid seek index file %s", {fileName});
+        clear();
+        return false;
+    }
+    if (size != _file_size || date != _file_date || packet_size != _packet_size) {
+        report.verbose(u"seek index %s is obsolete, %s was modified", {fileName, file.getDisplayFileName()});
+        clear();
+        return false;
+    }
+
+    // Load all entries.
+    lines.pop_front();
+    for (auto it = lines.begin(); it != lines.end(); ++it) {
+        Entry e;
+        if (!it->scan(u"%d %d %d", {&e.packet, &e.pcr, &e.time}) || (!_entries.empty() && (e.packet <= _entries.back().packet || e.time < _entries.back().time))) {
+            report.error(u"invalid seek index file %s", {fileName});
+            clear();
+            return false;
+        }
+        _entries.push_back(e);
+    }
+    if (_entries.empty()) {
+        report.error(u"empty seek index file %s", {fileName});
+        return false;
+    }
+    report.debug(u"loaded seek index from %s, %d entries", {fileName, _entries.size()});
+    return true;
+}
@@ -0,0 +1,184 @@
+//----------------------------------------------------------------------------
+//
+// TSDuck - The MPEG Transport Stream Toolkit
+// Copyright (c) 2005-2020, Thierry Lelegard
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+// THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------
+//!
+//!  @file
+//!  Sparse index of PCR values in a transport stream file, for fast seek by time.
+//!
+//----------------------------------------------------------------------------
+
+#pragma once
+#include "tsTSFile.h"
+#include "tsMPEG.h"
+
+namespace ts {
+    //!
+    //! Sparse index of PCR values in a transport stream file, for fast seek by time.
+    //! @ingroup mpeg
+    //!
+    //! The index contains one entry every N packets (the "interval"). Each entry is the
+    //! first packet carrying a PCR in its interval. All PCR's are taken from the same
+    //! reference PID, the PID of the first PCR in the file. Time values are expressed
+    //! in PCR units, relative to the first PCR in the file. PCR wrap-around is handled,
+    //! making the time monotonic, so that files of any duration can be indexed.
+    //!
+    //! Building the index reads only a few packets in each interval. Seeking at a given
+    //! time uses a binary search in the index and then a sequential scan of at most one
+    //! interval. The result is exact: this is the first packet of the reference PID
+    //! which carries a PCR at or after the requested time, exactly as a full sequential
+    //! read of the file would find.
+    //!
+    //! The index can be saved in a small text file next to the transport stream file
+    //! and reloaded later. A saved index is rejected when the size or the modification
+    //! time of the transport stream file changed.
+    //!
+    class TSDUCKDLL TSFileSeekIndex
+    {
+        TS_NOCOPY(TSFileSeekIndex);
+    public:
+        //!
+        //! Default number of packets between two index entries.
+        //!
+        static constexpr PacketCounter DEFAULT_INTERVAL = 10000;
+
+        //!
+        //! One entry in the index.
+        //!
+        struct TSDUCKDLL Entry
+        {
+            PacketCounter packet;  //!< Index of the packet carrying the PCR in the file.
+            uint64_t      pcr;     //!< PCR value in the packet.
+            uint64_t      time;    //!< Time from the first PCR in the file, in PCR units, without wrap-around.
+
+            //!
+            //! Constructor.
+            //! @param [in] p Packet index.
+            //! @param [in] c PCR value.
+            //! @param [in] t Time from the first PCR.
+            //!
+            Entry(PacketCounter p = 0, uint64_t c = 0, uint64_t t = 0) : packet(p), pcr(c), time(t) {}
+        };
+
+        //!
+        //! Constructor.
+        //! @param [in] interval Number of packets between two index entries.
+        //!
+        explicit TSFileSeekIndex(PacketCounter interval = DEFAULT_INTERVAL);
+
+        //!
+        //! Clear the content of the index.
+        //!
+        void clear();
+
+        //!
+        //! Check if the index is valid.
+        //! @return True if the index contains at least one entry.
+        //!
+        bool isValid() const { return !_entries.empty(); }
+
+        //!
+        //! Get the number of entries in the index.
+        //! @return The number of entries in the index.
+        //!
+        size_t size() const { return _entries.size(); }
+
+        //!
+        //! Get an entry of the index.
+        //! @param [in] index Index of the entry, must be lower than size().
+        //! @return A constant reference to the entry.
+        //!
+        const Entry& entry(size_t index) const { return _entries[index]; }
+
+        //!
+        //! Get the reference PID of the PCR's in the index.
+        //! @return The reference PID or PID_NULL if the index is not valid.
+        //!
+        PID pcrPID() const { return _pcr_pid; }
+
+        //!
+        //! Build the index of a transport stream file.
+        //! @param [in,out] file A transport stream file, open for read. The file must be seekable.
+        //! On return, the current position in the file is undefined.
+        //! @param [in,out] report Where to report errors.
+        //! @return True on success, false on error or if the file contains no PCR.
+        //!
+        bool build(TSFile& file, Report& report);
+
+        //!
+        //! Find the first packet at or after a given time in a transport stream file.
+        //! @param [in,out] file The transport stream file which was used to build or load the index.
+        //! On return, the current position in the file is undefined.
+        //! @param [in] time Time from the first PCR in the file, in PCR units.
+        //! @param [out] packet Index of the first packet of the reference PID which carries
+        //! a PCR at or after @a time.
+        //! @param [in,out] report Where to report errors.
+        //! @return True on success, false on error or if @a time is after the last PCR in the file.
+        //!
+        bool findPacket(TSFile& file, uint64_t time, PacketCounter& packet, Report& report) const;
+
+        //!
+        //! Save the index in a text file.
+        //! @param [in] fileName Name of the index file.
+        //! @param [in,out] report Where to report errors.
+        //! @return True on success, false on error.
+        //!
+        bool save(const UString& fileName, Report& report) const;
+
+        //!
+        //! Load the index from a text file.
+        //! @param [in] fileName Name of the index file.
+        //! @param [in,out] file The transport stream file which is described by the index file.
+        //! The index is rejected if it was built on a different version of this file.
+        //! @param [in,out] report Where to report errors.
+        //! @return True on success, false on error or if the index does not match @a file.
+        //!
+        bool load(const UString& fileName, TSFile& file, Report& report);
+
+        //!
+        //! Get the default name of the index file for a transport stream file.
+        //! @param [in] file_name Name of the transport stream file.
+        //! @return The default name of the corresponding index file.
+        //!
+        static UString DefaultFileName(const UString& file_name) { return file_name + u".tsidx"; }
+
+    private:
+        PacketCounter      _interval;     // Number of packets between two index entries.
+        int64_t            _file_size;    // Size in bytes of the indexed file.
+        MilliSecond        _file_date;    // Modification time of the indexed file, in milliseconds since the Epoch.
+        size_t             _packet_size;  // Size in bytes of packets in the file, including headers.
+        PID                _pcr_pid;      // Reference PCR PID.
+        std::vector<Entry> _entries;      // Index entries, sorted by packet index and time.
+
+        // Make sure the format of the file is known, get the file characteristics.
+        static bool GetFileProperties(TSFile& file, int64_t& size, MilliSecond& date, size_t& packet_size, Report& report);
+
+        // Read at most max_packets packets, starting at packet, until a PCR on the reference PID is found.
+        // When pid is PID_NULL, any PID is accepted and pid is updated. Return false if no PCR is found.
+        static bool NextPCR(TSFile& file, PacketCounter& packet, PacketCounter max_packets, PID& pid, uint64_t& pcr, Report& report);
+    };
+}
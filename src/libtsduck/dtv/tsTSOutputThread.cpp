@@ -0,0 +1,240 @@
+//----------------------------------------------------------------------------
+//
+// TSDuck - The MPEG Transport Stream Toolkit
+// Copyright (c) 2005-2020, Thierry Lelegard
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+// THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------
+
+#include "tsTSOutputThread.h"
+#include "tsNullReport.h"
+TSDUCK_SOURCE;
+
+#if defined(TS_NEED_STATIC_CONST_DEFINITIONS)
+constexpr size_t ts::TSOutputThread::DEFAULT_QUEUE_SIZE;
+constexpr size_t ts::TSOutputThread::DEFAULT_UDP_PACKETS;
+#endif
+
+// Maximum number of packets which are dequeued at a time by the output thread.
+#define OUTPUT_CHUNK_PACKETS 128
+
+
+//----------------------------------------------------------------------------
+// Constructors and destructors.
+//----------------------------------------------------------------------------
+
+ts::TSOutputThread::TSOutputThread(size_t queue_size) :
+    Thread(ThreadAttributes().setPriority(ThreadAttributes::GetHighPriority())),
+    _type(NO_OUTPUT),
+    _report(nullptr),
+    _queue(queue_size),
+    _file(),
+    _sock(),
+    _pipe(),
+    _burst(DEFAULT_UDP_PACKETS),
+    _failed(false),
+    _packets(0),
+    _overflow(0)
+{
+}
+
+ts::TSOutputThread::~TSOutputThread()
+{
+    close(NULLREP);
+}
+
+
+//----------------------------------------------------------------------------
+// Open the various types of output.
+//----------------------------------------------------------------------------
+
+bool ts::TSOutputThread::openFile(const UString& filename, TSFile::OpenFlags flags, Report& report)
+{
+    if (_type != NO_OUTPUT) {
+        report.error(u"output already open");
+        return false;
+    }
+    return _file.open(filename, flags, report) && startThread(FILE_OUTPUT, report);
+}
+
+bool ts::TSOutputThread::openUDP(const SocketAddress& destination, const UString& local_address, int ttl, size_t burst, Report& report)
+{
+    if (_type != NO_OUTPUT) {
+        report.error(u"output already open");
+        return false;
+    }
+    if (!_sock.open(report)) {
+        return false;
+    }
+    if (!_sock.setDefaultDestination(destination, report) ||
+        (!local_address.empty() && !_sock.setOutgoingMulticast(local_address, report)) ||
+        (ttl > 0 && !_sock.setTTL(ttl, report)))
+    {
+        _sock.close(report);
+        return false;
+    }
+    _burst = std::max<size_t>(1, burst);
+    return startThread(UDP_OUTPUT, report);
+}
+
+bool ts::TSOutputThread::openFork(const UString& command, bool nowait, Report& report)
+{
+    if (_type != NO_OUTPUT) {
+        report.error(u"output already open");
+        return false;
+    }
+    return _pipe.open(command,
+                      nowait ? ForkPipe::ASYNCHRONOUS : ForkPipe::SYNCHRONOUS,
+                      0,
+                      report,
+                      ForkPipe::KEEP_BOTH,
+                      ForkPipe::STDIN_PIPE,
+                      TSPacketFormat::TS) &&
+        startThread(FORK_OUTPUT, report);
+}
+
+
+//----------------------------------------------------------------------------
+// Reset the queue and start the output thread after opening the output.
+//----------------------------------------------------------------------------
+
+bool ts::TSOutputThread::startThread(OutputType type, Report& report)
+{
+    _type = type;
+    _report = &report;
+    _queue.reset();
+    _failed = false;
+    _packets = 0;
+    _overflow = 0;
+
+    if (!start()) {
+        report.error(u"cannot start output thread");
+        close(report);
+        return false;
+    }
+    return true;
+}
+
+
+//----------------------------------------------------------------------------
+// Enqueue packets for output.
+//----------------------------------------------------------------------------
+
+bool ts::TSOutputThread::write(const TSPacket* packets, size_t count)
+{
+    if (_type == NO_OUTPUT || _failed) {
+        return false;
+    }
+    const size_t done = _queue.putPackets(packets, count);
+    _packets += done;
+    _overflow += count - done;
+    return true;
+}
+
+
+//----------------------------------------------------------------------------
+// Flush the queue, wait for the output thread and close the output.
+//----------------------------------------------------------------------------
+
+bool ts::TSOutputThread::close(Report& report)
+{
+    if (_type == NO_OUTPUT) {
+        return true;
+    }
+
+    // Let the output thread drain the queue and terminate.
+    _queue.setEOF();
+    waitForTermination();
+
+    bool ok = !_failed;
+    switch (_type) {
+        case FILE_OUTPUT:
+            ok = _file.close(report) && ok;
+            break;
+        case UDP_OUTPUT:
+            ok = _sock.close(report) && ok;
+            break;
+        case FORK_OUTPUT:
+            ok = _pipe.close(report) && ok;
+            break;
+        case NO_OUTPUT:
+        default:
+            break;
+    }
+
+    _type = NO_OUTPUT;
+    _report = nullptr;
+    return ok;
+}
+
+
+//----------------------------------------------------------------------------
+// Send packets to the output. Invoked in the context of the output thread.
+//----------------------------------------------------------------------------
+
+bool ts::TSOutputThread::writeOutput(const TSPacket* packets, size_t count)
+{
+    switch (_type) {
+        case FILE_OUTPUT:
+            return _file.writePackets(packets, nullptr, count, *_report);
+        case FORK_OUTPUT:
+            return _pipe.writePackets(packets, nullptr, count, *_report);
+        case UDP_OUTPUT:
+            // Send datagrams of at most _burst packets.
+            while (count > 0) {
+                const size_t size = std::min(count, _burst);
+                if (!_sock.send(packets, size * PKT_SIZE, *_report)) {
+                    return false;
+                }
+                packets += size;
+                count -= size;
+            }
+            return true;
+        case NO_OUTPUT:
+        default:
+            return false;
+    }
+}
+
+
+//----------------------------------------------------------------------------
+// Output thread main code.
+//----------------------------------------------------------------------------
+
+void ts::TSOutputThread::main()
+{
+    TSPacketVector buffer(OUTPUT_CHUNK_PACKETS);
+    size_t count = 0;
+    BitRate bitrate = 0;
+
+    // Loop until end of input, the queue returns false when EOF is set and the queue is empty.
+    while (_queue.waitPackets(buffer.data(), buffer.size(), count, bitrate)) {
+        if (!writeOutput(buffer.data(), count)) {
+            // Output error, tell the writer side that nothing can be enqueued anymore.
+            _failed = true;
+            _queue.stop();
+            break;
+        }
+    }
+}
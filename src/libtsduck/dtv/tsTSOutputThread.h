@@ -0,0 +1,173 @@
+//----------------------------------------------------------------------------
+//
+// TSDuck - The MPEG Transport Stream Toolkit
+// Copyright (c) 2005-2020, Thierry Lelegard
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+// THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------
+//!
+//!  @file
+//!  Transport stream output with its own packet queue and thread.
+//!
+//----------------------------------------------------------------------------
+
+#pragma once
+#include "tsThread.h"
+#include "tsTSPacketQueue.h"
+#include "tsTSFile.h"
+#include "tsTSForkPipe.h"
+#include "tsUDPSocket.h"
+
+namespace ts {
+    //!
+    //! Transport stream output with its own packet queue and thread.
+    //! @ingroup mpeg
+    //!
+    //! The packets are sent to a file, a UDP destination or a forked process.
+    //! The application writes packets using write() which never blocks. The packets
+    //! are enqueued in a bounded queue and the actual output operations are performed
+    //! in a dedicated thread. When the output is slower than the application, the queue
+    //! fills up and the excess packets are dropped and counted as overflow. This way,
+    //! an application which feeds several instances of this class is never stalled
+    //! by one slow output.
+    //!
+    class TSDUCKDLL TSOutputThread: private Thread
+    {
+        TS_NOCOPY(TSOutputThread);
+    public:
+        //!
+        //! Default size in packets of the output queue.
+        //!
+        static constexpr size_t DEFAULT_QUEUE_SIZE = 1000;
+
+        //!
+        //! Default number of TS packets per UDP datagram.
+        //!
+        static constexpr size_t DEFAULT_UDP_PACKETS = 7;
+
+        //!
+        //! Constructor.
+        //! @param [in] queue_size Size in packets of the output queue.
+        //!
+        TSOutputThread(size_t queue_size = DEFAULT_QUEUE_SIZE);
+
+        //!
+        //! Destructor.
+        //! The output is closed if necessary.
+        //!
+        virtual ~TSOutputThread() override;
+
+        //!
+        //! Open the output to a TS file and start the output thread.
+        //! @param [in] filename File name. If empty, use standard output.
+        //! @param [in] flags Bit mask of open flags (same as TSFile).
+        //! @param [in,out] report Where to report errors, including errors from the output thread.
+        //! The report must remain valid until close() and must be thread-safe.
+        //! @return True on success, false on error.
+        //!
+        bool openFile(const UString& filename, TSFile::OpenFlags flags, Report& report);
+
+        //!
+        //! Open the output to a UDP destination and start the output thread.
+        //! @param [in] destination Destination socket address, "address:port".
+        //! @param [in] local_address Optional outgoing local address for multicast. Ignored if empty.
+        //! @param [in] ttl Time-to-live socket option. Ignored if zero or negative.
+        //! @param [in] burst Number of TS packets per UDP datagram.
+        //! @param [in,out] report Where to report errors, including errors from the output thread.
+        //! The report must remain valid until close() and must be thread-safe.
+        //! @return True on success, false on error.
+        //!
+        bool openUDP(const SocketAddress& destination, const UString& local_address, int ttl, size_t burst, Report& report);
+
+        //!
+        //! Open the output to a forked process and start the output thread.
+        //! The packets are sent on the standard input of the process.
+        //! @param [in] command The command to execute.
+        //! @param [in] nowait If true, do not wait for the process termination in close().
+        //! @param [in,out] report Where to report errors, including errors from the output thread.
+        //! The report must remain valid until close() and must be thread-safe.
+        //! @return True on success, false on error.
+        //!
+        bool openFork(const UString& command, bool nowait, Report& report);
+
+        //!
+        //! Check if the output is open.
+        //! @return True if the output is open.
+        //!
+        bool isOpen() const { return _type != NO_OUTPUT; }
+
+        //!
+        //! Enqueue packets for output. Never blocks.
+        //! When the output queue is full, the packets which do not fit are dropped.
+        //! @param [in] packets Address of packets to write.
+        //! @param [in] count Number of packets to write.
+        //! @return False if the output is not open or the output thread has failed.
+        //! Dropped packets are not considered as an error.
+        //!
+        bool write(const TSPacket* packets, size_t count);
+
+        //!
+        //! Flush the queue, wait for the output thread and close the output.
+        //! @param [in,out] report Where to report errors.
+        //! @return True on success, false if an output error occurred during the session.
+        //!
+        bool close(Report& report);
+
+        //!
+        //! Get the number of packets which were enqueued for output.
+        //! @return The number of packets which were enqueued for output.
+        //!
+        PacketCounter packetCount() const { return _packets; }
+
+        //!
+        //! Get the number of packets which were dropped because the output queue was full.
+        //! @return The number of dropped packets.
+        //!
+        PacketCounter overflowCount() const { return _overflow; }
+
+    private:
+        // Type of output.
+        enum OutputType {NO_OUTPUT, FILE_OUTPUT, UDP_OUTPUT, FORK_OUTPUT};
+
+        OutputType     _type;      // Current type of output.
+        Report*        _report;    // Where to report output errors, from the output thread.
+        TSPacketQueue  _queue;     // Bounded queue of packets to output.
+        TSFile         _file;      // Output file.
+        UDPSocket      _sock;      // Output UDP socket.
+        TSForkPipe     _pipe;      // Output pipe to forked process.
+        size_t         _burst;     // Number of TS packets per UDP datagram.
+        volatile bool  _failed;    // Output error in output thread.
+        PacketCounter  _packets;   // Number of enqueued packets.
+        PacketCounter  _overflow;  // Number of dropped packets.
+
+        // Reset the queue and start the output thread after opening the output.
+        bool startThread(OutputType type, Report& report);
+
+        // Send packets to the output. Invoked in the context of the output thread.
+        bool writeOutput(const TSPacket* packets, size_t count);
+
+        // Inherited from Thread
+        virtual void main() override;
+    };
+}
@@ -31,8 +31,25 @@
 #include "tsPCR.h"
 #include "tsNames.h"
 #include "tsByteBlock.h"
+#if defined(TS_X86_64) || (defined(TS_I386) && defined(__SSE2__))
+#define TS_HEADERS_SSE2 1
+#include <emmintrin.h>
+#elif defined(TS_ARM64)
+#define TS_HEADERS_NEON 1
+#include <arm_neon.h>
+#endif
 TSDUCK_SOURCE;
 
+#if defined(TS_NEED_STATIC_CONST_DEFINITIONS)
+constexpr uint8_t ts::TSPacketHeaders::TEI;
+constexpr uint8_t ts::TSPacketHeaders::PUSI;
+constexpr uint8_t ts::TSPacketHeaders::PRIORITY;
+constexpr uint8_t ts::TSPacketHeaders::INVALID_SYNC;
+constexpr uint8_t ts::TSPacketHeaders::SCRAMBLING;
+constexpr uint8_t ts::TSPacketHeaders::HAS_AF;
+constexpr uint8_t ts::TSPacketHeaders::HAS_PAYLOAD;
+#endif
+
 
 //----------------------------------------------------------------------------
 // This constant is a null (or stuffing) packet.
@@ -900,6 +917,242 @@ bool ts::TSPacket::isDuplicate(const TSPacket& other) const
 }
 
 
+//----------------------------------------------------------------------------
+// Extract the header fields of contiguous TS packets.
+//----------------------------------------------------------------------------
+
+void ts::TSPacket::ExtractHeaders(const TSPacket* packets, size_t count, TSPacketHeaders& headers)
+{
+    headers.pid.resize(count);
+    headers.cc.resize(count);
+    headers.flags.resize(count);
+
+    PID* const pid = headers.pid.data();
+    uint8_t* const cc = headers.cc.data();
+    uint8_t* const flags = headers.flags.data();
+    size_t i = 0;
+
+    // In the vectorized versions, the 4-byte header of each packet is loaded as a little-endian
+    // 32-bit value in one lane: b[0] in bits 0-7, b[1] in bits 8-15, etc. Eight packets are
+    // processed at a time: PID's are narrowed to 16 bits, CC and flags to 8 bits.
+
+#if defined(TS_HEADERS_SSE2)
+
+    const __m128i mask_pid = _mm_set1_epi32(0x1F00);
+    const __m128i mask_byte = _mm_set1_epi32(0xFF);
+    const __m128i mask_cc = _mm_set1_epi32(0x0F);
+    const __m128i mask_b1 = _mm_set1_epi32(0xE0);
+    const __m128i sync = _mm_set1_epi32(SYNC_BYTE);
+    const __m128i invalid = _mm_set1_epi32(TSPacketHeaders::INVALID_SYNC);
+
+    for (; i + 8 <= count; i += 8) {
+        const __m128i h0 = _mm_set_epi32(int32_t(GetUInt32LE(packets[i+3].b)), int32_t(GetUInt32LE(packets[i+2].b)),
+                                         int32_t(GetUInt32LE(packets[i+1].b)), int32_t(GetUInt32LE(packets[i].b)));
+        const __m128i h1 = _mm_set_epi32(int32_t(GetUInt32LE(packets[i+7].b)), int32_t(GetUInt32LE(packets[i+6].b)),
+                                         int32_t(GetUInt32LE(packets[i+5].b)), int32_t(GetUInt32LE(packets[i+4].b)));
+
+        // PID: low 5 bits of b[1] are already in bits 8-12, add b[2].
+        const __m128i p0 = _mm_or_si128(_mm_and_si128(h0, mask_pid), _mm_and_si128(_mm_srli_epi32(h0, 16), mask_byte));
+        const __m128i p1 = _mm_or_si128(_mm_and_si128(h1, mask_pid), _mm_and_si128(_mm_srli_epi32(h1, 16), mask_byte));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(pid + i), _mm_packs_epi32(p0, p1));
+
+        // CC: low 4 bits of b[3].
+        const __m128i c = _mm_packs_epi32(_mm_and_si128(_mm_srli_epi32(h0, 24), mask_cc), _mm_and_si128(_mm_srli_epi32(h1, 24), mask_cc));
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(cc + i), _mm_packus_epi16(c, c));
+
+        // Flags: high 3 bits of b[1], high 4 bits of b[3], invalid sync byte.
+        __m128i f0 = _mm_or_si128(_mm_and_si128(_mm_srli_epi32(h0, 8), mask_b1), _mm_srli_epi32(h0, 28));
+        __m128i f1 = _mm_or_si128(_mm_and_si128(_mm_srli_epi32(h1, 8), mask_b1), _mm_srli_epi32(h1, 28));
+        f0 = _mm_or_si128(f0, _mm_andnot_si128(_mm_cmpeq_epi32(_mm_and_si128(h0, mask_byte), sync), invalid));
+        f1 = _mm_or_si128(f1, _mm_andnot_si128(_mm_cmpeq_epi32(_mm_and_si128(h1, mask_byte), sync), invalid));
+        const __m128i f = _mm_packs_epi32(f0, f1);
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(flags + i), _mm_packus_epi16(f, f));
+    }
+
+#elif defined(TS_HEADERS_NEON)
+
+    const uint32x4_t mask_pid = vdupq_n_u32(0x1F00);
+    const uint32x4_t mask_byte = vdupq_n_u32(0xFF);
+    const uint32x4_t mask_cc = vdupq_n_u32(0x0F);
+    const uint32x4_t mask_b1 = vdupq_n_u32(0xE0);
+    const uint32x4_t sync = vdupq_n_u32(SYNC_BYTE);
+    const uint32x4_t invalid = vdupq_n_u32(TSPacketHeaders::INVALID_SYNC);
+    uint32_t words[8];
+
+    for (; i + 8 <= count; i += 8) {
+        for (size_t j = 0; j < 8; ++j) {
+            words[j] = GetUInt32LE(packets[i+j].b);
+        }
+        const uint32x4_t h0 = vld1q_u32(words);
+        const uint32x4_t h1 = vld1q_u32(words + 4);
+
+        // PID: low 5 bits of b[1] are already in bits 8-12, add b[2].
+        const uint32x4_t p0 = vorrq_u32(vandq_u32(h0, mask_pid), vandq_u32(vshrq_n_u32(h0, 16), mask_byte));
+        const uint32x4_t p1 = vorrq_u32(vandq_u32(h1, mask_pid), vandq_u32(vshrq_n_u32(h1, 16), mask_byte));
+        vst1q_u16(pid + i, vcombine_u16(vmovn_u32(p0), vmovn_u32(p1)));
+
+        // CC: low 4 bits of b[3].
+        const uint32x4_t c0 = vandq_u32(vshrq_n_u32(h0, 24), mask_cc);
+        const uint32x4_t c1 = vandq_u32(vshrq_n_u32(h1, 24), mask_cc);
+        vst1_u8(cc + i, vmovn_u16(vcombine_u16(vmovn_u32(c0), vmovn_u32(c1))));
+
+        // Flags: high 3 bits of b[1], high 4 bits of b[3], invalid sync byte.
+        uint32x4_t f0 = vorrq_u32(vandq_u32(vshrq_n_u32(h0, 8), mask_b1), vshrq_n_u32(h0, 28));
+        uint32x4_t f1 = vorrq_u32(vandq_u32(vshrq_n_u32(h1, 8), mask_b1), vshrq_n_u32(h1, 28));
+        f0 = vorrq_u32(f0, vbicq_u32(invalid, vceqq_u32(vandq_u32(h0, mask_byte), sync)));
+        f1 = vorrq_u32(f1, vbicq_u32(invalid, vceqq_u32(vandq_u32(h1, mask_byte), sync)));
+        vst1_u8(flags + i, vmovn_u16(vcombine_u16(vmovn_u32(f0), vmovn_u32(f1))));
+    }
+
+#endif
+
+    // Remaining packets, or all packets without SIMD support.
+    for (; i < count; ++i) {
+        const uint8_t* const b = packets[i].b;
+        pid[i] = GetUInt16(b + 1) & 0x1FFF;
+        cc[i] = b[3] & 0x0F;
+        flags[i] = uint8_t((b[1] & 0xE0) | (b[3] >> 4) | (b[0] != SYNC_BYTE ? TSPacketHeaders::INVALID_SYNC : 0));
+    }
+}
+
+
+//----------------------------------------------------------------------------
+// Classify contiguous TS packets as null, stuffing or adaptation-field-only.
+//----------------------------------------------------------------------------
+
+namespace {
+    // Check if a payload is entirely made of 0xFF bytes.
+    inline bool IsStuffingPayload(const uint8_t* data, size_t size)
+    {
+        size_t i = 0;
+
+#if defined(TS_HEADERS_SSE2)
+
+        if (size >= 16) {
+            // Most payloads are not stuffing, the first block is checked alone to exit early.
+            const __m128i ff = _mm_set1_epi8(-1);
+            __m128i acc = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data));
+            if (_mm_movemask_epi8(_mm_cmpeq_epi8(acc, ff)) != 0xFFFF) {
+                return false;
+            }
+            // Then AND all blocks together, the last one may overlap the previous one.
+            for (i = 16; i + 16 <= size; i += 16) {
+                acc = _mm_and_si128(acc, _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i)));
+            }
+            acc = _mm_and_si128(acc, _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + size - 16)));
+            return _mm_movemask_epi8(_mm_cmpeq_epi8(acc, ff)) == 0xFFFF;
+        }
+
+#elif defined(TS_HEADERS_NEON)
+
+        if (size >= 16) {
+            // Most payloads are not stuffing, the first block is checked alone to exit early.
+            uint8x16_t acc = vld1q_u8(data);
+            if (vminvq_u8(acc) != 0xFF) {
+                return false;
+            }
+            // Then AND all blocks together, the last one may overlap the previous one.
+            for (i = 16; i + 16 <= size; i += 16) {
+                acc = vandq_u8(acc, vld1q_u8(data + i));
+            }
+            acc = vandq_u8(acc, vld1q_u8(data + size - 16));
+            return vminvq_u8(acc) == 0xFF;
+        }
+
+#endif
+
+        // Short payloads, or all payloads without SIMD support.
+        for (; i + 8 <= size; i += 8) {
+            if (ts::GetUInt64(data + i) != TS_UCONST64(0xFFFFFFFFFFFFFFFF)) {
+                return false;
+            }
+        }
+        for (; i < size; ++i) {
+            if (data[i] != 0xFF) {
+                return false;
+            }
+        }
+        return true;
+    }
+}
+
+void ts::TSPacket::Classify(const TSPacket* packets, size_t count, TSPacketClasses& classes)
+{
+    const size_t words = (count + 63) / 64;
+    classes.count = count;
+    classes.null_pid.resize(words);
+    classes.stuffing.resize(words);
+    classes.af_only.resize(words);
+
+    // Build each 64-bit word of the bitmaps in registers.
+    for (size_t w = 0; w < words; ++w) {
+        const TSPacket* const first = packets + 64 * w;
+        const size_t n = std::min<size_t>(64, count - 64 * w);
+        uint64_t null_pid = 0;
+        uint64_t stuffing = 0;
+        uint64_t af_only = 0;
+        for (size_t i = 0; i < n; ++i) {
+            const uint8_t* const b = first[i].b;
+            const uint64_t bit = TS_UCONST64(1) << i;
+            if ((GetUInt16(b + 1) & 0x1FFF) == PID_NULL) {
+                null_pid |= bit;
+            }
+            // Payload start, depending on adaptation_field_control.
+            size_t start = PKT_SIZE;
+            switch (b[3] & 0x30) {
+                case 0x10: start = 4; break;
+                case 0x20: af_only |= bit; break;
+                case 0x30: start = 5 + size_t(b[4]); break;
+                default: break;
+            }
+            if (start < PKT_SIZE && IsStuffingPayload(b + start, PKT_SIZE - start)) {
+                stuffing |= bit;
+            }
+        }
+        classes.null_pid[w] = null_pid;
+        classes.stuffing[w] = stuffing;
+        classes.af_only[w] = af_only;
+    }
+}
+
+
+//----------------------------------------------------------------------------
+// Count bits in classification bitmaps.
+//----------------------------------------------------------------------------
+
+size_t ts::TSPacketClasses::Count(const std::vector<uint64_t>& bitmap)
+{
+    size_t total = 0;
+    for (auto it = bitmap.begin(); it != bitmap.end(); ++it) {
+        // Clear the lowest set bit until none remains.
+        for (uint64_t w = *it; w != 0; w &= w - 1) {
+            total++;
+        }
+    }
+    return total;
+}
+
+size_t ts::TSPacketClasses::countTail(const std::vector<uint64_t>& bitmap) const
+{
+    size_t tail = 0;
+    for (size_t i = count; i > 0; --i) {
+        const size_t w = (i - 1) / 64;
+        if ((i % 64) == 0 && bitmap[w] == ~TS_UCONST64(0)) {
+            // Complete word set, skip it at once.
+            tail += 64;
+            i -= 63;
+        }
+        else if (Test(bitmap, i - 1)) {
+            tail++;
+        }
+        else {
+            break;
+        }
+    }
+    return tail;
+}
+
+
 //----------------------------------------------------------------------------
 // Locate contiguous TS packets into a buffer.
 //----------------------------------------------------------------------------
@@ -42,6 +42,8 @@
 namespace ts {
 
     class ByteBlock;
+    class TSPacketHeaders;
+    class TSPacketClasses;
 
     //!
     //! Basic definition of an MPEG-2 transport packet.
@@ -874,6 +876,34 @@ namespace ts {
         //!
         static bool Locate(const uint8_t* buffer, size_t buffer_size, size_t& start_index, size_t& packet_count);
 
+        //!
+        //! Extract the header fields of contiguous TS packets.
+        //!
+        //! Tools which scan large amounts of packets typically use only a few header fields.
+        //! This method decodes the PID, continuity counter and flags of a complete window of
+        //! packets in one pass, into compact arrays. When available, SIMD instructions are
+        //! used to decode several packets at a time. Subsequent loops over the headers only
+        //! access the compact arrays instead of one cache line per packet.
+        //!
+        //! @param [in] packets Address of the first contiguous TS packet to read.
+        //! @param [in] count Number of TS packets to read.
+        //! @param [out] headers Decoded header fields. The arrays are resized to @a count elements.
+        //!
+        static void ExtractHeaders(const TSPacket* packets, size_t count, TSPacketHeaders& headers);
+
+        //!
+        //! Classify contiguous TS packets as null, stuffing or adaptation-field-only packets.
+        //!
+        //! The result is a set of bitmaps, one bit per packet. When available, SIMD instructions
+        //! are used to check the payloads. Tools which look for null packets or stuffing in large
+        //! files can then skip or count complete runs of packets using the bitmaps only.
+        //!
+        //! @param [in] packets Address of the first contiguous TS packet to read.
+        //! @param [in] count Number of TS packets to read.
+        //! @param [out] classes Packet classification bitmaps for @a count packets.
+        //!
+        static void Classify(const TSPacket* packets, size_t count, TSPacketClasses& classes);
+
         //!
         //! Sanity check routine.
         //! Ensure that the TSPacket structure can
@@ -904,6 +934,151 @@ namespace ts {
         void deleteFieldFromAF(size_t offset, size_t size, uint32_t flag);
     };
 
+    //!
+    //! Header fields of contiguous TS packets, as a structure of arrays.
+    //! @ingroup mpeg
+    //! @see TSPacket::ExtractHeaders()
+    //!
+    class TSDUCKDLL TSPacketHeaders
+    {
+    public:
+        static constexpr uint8_t TEI          = 0x80;  //!< Flag: transport_error_indicator.
+        static constexpr uint8_t PUSI         = 0x40;  //!< Flag: payload_unit_start_indicator.
+        static constexpr uint8_t PRIORITY     = 0x20;  //!< Flag: transport_priority.
+        static constexpr uint8_t INVALID_SYNC = 0x10;  //!< Flag: the sync byte is not 0x47.
+        static constexpr uint8_t SCRAMBLING   = 0x0C;  //!< Mask of transport_scrambling_control in flags.
+        static constexpr uint8_t HAS_AF       = 0x02;  //!< Flag: the packet has an adaptation field.
+        static constexpr uint8_t HAS_PAYLOAD  = 0x01;  //!< Flag: the packet has a payload.
+
+        std::vector<PID>     pid;    //!< PID of each packet.
+        std::vector<uint8_t> cc;     //!< Continuity counter of each packet.
+        std::vector<uint8_t> flags;  //!< Flags of each packet, a combination of TEI, PUSI, etc.
+
+        //!
+        //! Default constructor.
+        //!
+        TSPacketHeaders() : pid(), cc(), flags() {}
+
+        //!
+        //! Get the number of packet headers.
+        //! @return The number of packet headers.
+        //!
+        size_t size() const { return pid.size(); }
+
+        //!
+        //! Check if a packet has a valid sync byte.
+        //! @param [in] i Packet index in the window.
+        //! @return True if the sync byte is valid.
+        //!
+        bool hasValidSync(size_t i) const { return (flags[i] & INVALID_SYNC) == 0; }
+
+        //!
+        //! Get the transport_error_indicator of a packet.
+        //! @param [in] i Packet index in the window.
+        //! @return The TEI value.
+        //!
+        bool getTEI(size_t i) const { return (flags[i] & TEI) != 0; }
+
+        //!
+        //! Get the payload_unit_start_indicator of a packet.
+        //! @param [in] i Packet index in the window.
+        //! @return The PUSI value.
+        //!
+        bool getPUSI(size_t i) const { return (flags[i] & PUSI) != 0; }
+
+        //!
+        //! Get the transport_priority of a packet.
+        //! @param [in] i Packet index in the window.
+        //! @return The transport_priority value.
+        //!
+        bool getPriority(size_t i) const { return (flags[i] & PRIORITY) != 0; }
+
+        //!
+        //! Get the transport_scrambling_control of a packet.
+        //! @param [in] i Packet index in the window.
+        //! @return The transport_scrambling_control value.
+        //!
+        uint8_t getScrambling(size_t i) const { return (flags[i] & SCRAMBLING) >> 2; }
+
+        //!
+        //! Check if a packet has an adaptation field.
+        //! @param [in] i Packet index in the window.
+        //! @return True if the packet has an adaptation field.
+        //!
+        bool hasAF(size_t i) const { return (flags[i] & HAS_AF) != 0; }
+
+        //!
+        //! Check if a packet has a payload.
+        //! @param [in] i Packet index in the window.
+        //! @return True if the packet has a payload.
+        //!
+        bool hasPayload(size_t i) const { return (flags[i] & HAS_PAYLOAD) != 0; }
+    };
+
+    //!
+    //! Classification of contiguous TS packets, as bitmaps.
+    //! In each bitmap, the bit for packet @a i is bit @a i % 64 in word @a i / 64.
+    //! @ingroup mpeg
+    //! @see TSPacket::Classify()
+    //!
+    class TSDUCKDLL TSPacketClasses
+    {
+    public:
+        size_t                count;     //!< Number of classified packets.
+        std::vector<uint64_t> null_pid;  //!< Bitmap of packets in the null PID.
+        std::vector<uint64_t> stuffing;  //!< Bitmap of packets with a payload which is entirely made of 0xFF bytes.
+        std::vector<uint64_t> af_only;   //!< Bitmap of packets with an adaptation field and no payload.
+
+        //!
+        //! Default constructor.
+        //!
+        TSPacketClasses() : count(0), null_pid(), stuffing(), af_only() {}
+
+        //!
+        //! Get the number of classified packets.
+        //! @return The number of classified packets.
+        //!
+        size_t size() const { return count; }
+
+        //!
+        //! Check if a packet is in the null PID.
+        //! @param [in] i Packet index in the window.
+        //! @return True if the packet is in the null PID.
+        //!
+        bool isNull(size_t i) const { return Test(null_pid, i); }
+
+        //!
+        //! Check if the payload of a packet is entirely made of 0xFF bytes.
+        //! @param [in] i Packet index in the window.
+        //! @return True if the packet has a payload which is entirely made of 0xFF bytes.
+        //!
+        bool isStuffing(size_t i) const { return Test(stuffing, i); }
+
+        //!
+        //! Check if a packet has an adaptation field and no payload.
+        //! @param [in] i Packet index in the window.
+        //! @return True if the packet has an adaptation field and no payload.
+        //!
+        bool isAFOnly(size_t i) const { return Test(af_only, i); }
+
+        //!
+        //! Count the number of packets in a bitmap.
+        //! @param [in] bitmap One of the bitmaps of this object.
+        //! @return The number of set bits in @a bitmap.
+        //!
+        static size_t Count(const std::vector<uint64_t>& bitmap);
+
+        //!
+        //! Count the number of consecutive packets at the end of the window which are set in a bitmap.
+        //! @param [in] bitmap One of the bitmaps of this object.
+        //! @return The number of consecutive set bits, starting from the last packet and going backward.
+        //!
+        size_t countTail(const std::vector<uint64_t>& bitmap) const;
+
+    private:
+        static bool Test(const std::vector<uint64_t>& bitmap, size_t i) { return (bitmap[i / 64] & (TS_UCONST64(1) << (i % 64))) != 0; }
+    };
+
     //!
     //! This constant is a null (or stuffing) packet.
     //!
@@ -0,0 +1,224 @@
+//----------------------------------------------------------------------------
+//
+// TSDuck - The MPEG Transport Stream Toolkit
+// Copyright (c) 2005-2020, Thierry Lelegard
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+// THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------
+
+#include "tsTSPacketDeduplicator.h"
+TSDUCK_SOURCE;
+
+#if defined(TS_NEED_STATIC_CONST_DEFINITIONS)
+constexpr size_t ts::TSPacketDeduplicator::DEFAULT_WINDOW;
+constexpr size_t ts::TSPacketDeduplicator::MAX_INPUTS;
+#endif
+
+
+//----------------------------------------------------------------------------
+// Constructor and reset.
+//----------------------------------------------------------------------------
+
+ts::TSPacketDeduplicator::TSPacketDeduplicator(size_t window, size_t inputs) :
+    _ring(),
+    _first(0),
+    _count(0),
+    _table(),
+    _mask(0),
+    _active(0),
+    _stats()
+{
+    reset(window, inputs);
+}
+
+void ts::TSPacketDeduplicator::reset(size_t window, size_t inputs)
+{
+    window = std::max<size_t>(window, 1);
+    inputs = std::max<size_t>(1, std::min(inputs, MAX_INPUTS));
+
+    // The lookup table is a power of 2, at least twice the size of the window.
+    size_t table_size = 2;
+    while (table_size < 2 * window) {
+        table_size *= 2;
+    }
+
+    _ring.clear();
+    _ring.resize(window);
+    _table.assign(table_size, NPOS);
+    _mask = table_size - 1;
+    _first = 0;
+    _count = 0;
+    _active = 0;
+    _stats.clear();
+    _stats.resize(inputs);
+}
+
+
+//----------------------------------------------------------------------------
+// Compute the 64-bit fingerprint of a TS packet.
+//----------------------------------------------------------------------------
+
+uint64_t ts::TSPacketDeduplicator::Fingerprint(const TSPacket& pkt)
+{
+    // Work on 64-bit words, the last one is padded with zeroes.
+    uint64_t words[(PKT_SIZE + 7) / 8];
+    words[sizeof(words) / 8 - 1] = 0;
+    ::memcpy(words, pkt.b, PKT_SIZE);
+
+    // Same rule as TSPacket::isDuplicate(): the PCR (bytes 6 to 11) can be
+    // different in duplicate packets with payload.
+    if (pkt.hasPayload() && pkt.hasPCR()) {
+        ::memset(reinterpret_cast<uint8_t*>(words) + 6, 0, 6);
+    }
+
+    // Multiply-rotate mixing on each word, in two independent lanes to shorten
+    // the dependency chain, then combine the lanes with a final avalanche.
+    uint64_t h1 = TS_UCONST64(0x9E3779B97F4A7C15);
+    uint64_t h2 = TS_UCONST64(0xC2B2AE3D27D4EB4F);
+    for (size_t i = 0; i < sizeof(words) / 8; i += 2) {
+        h1 ^= words[i] * TS_UCONST64(0x87C37B91114253D5);
+        h2 ^= words[i + 1] * TS_UCONST64(0x87C37B91114253D5);
+        h1 = ((h1 << 31) | (h1 >> 33)) * TS_UCONST64(0x4CF5AD432745937F);
+        h2 = ((h2 << 29) | (h2 >> 35)) * TS_UCONST64(0x4CF5AD432745937F);
+    }
+    uint64_t h = h1 ^ ((h2 << 32) | (h2 >> 32));
+    h ^= h >> 33;
+    h *= TS_UCONST64(0xFF51AFD7ED558CCD);
+    h ^= h >> 33;
+    h *= TS_UCONST64(0xC4CEB9FE1A85EC53);
+    h ^= h >> 33;
+    return h;
+}
+
+
+//----------------------------------------------------------------------------
+// Submit a packet from one input.
+//----------------------------------------------------------------------------
+
+bool ts::TSPacketDeduplicator::feedPacket(const TSPacket& pkt, size_t input)
+{
+    assert(input < _stats.size());
+    InputStatistics& stats(_stats[input]);
+    const uint64_t bit = uint64_t(1) << input;
+
+    stats.packets++;
+    _active |= bit;
+
+    // Null packets are never duplicates.
+    const PID pid = pkt.getPID();
+    if (pid == PID_NULL) {
+        stats.unique++;
+        return true;
+    }
+
+    const uint64_t hash = Fingerprint(pkt);
+    const uint16_t pidcc = uint16_t(pid << 4) | pkt.getCC();
+
+    // Look for the same packet in the window.
+    size_t slot = slotOf(hash);
+    while (_table[slot] != NPOS) {
+        Entry& entry(_ring[_table[slot]]);
+        if (entry.hash == hash && entry.pidcc == pidcc) {
+            entry.inputs |= bit;
+            stats.duplicates++;
+            return false;
+        }
+        slot = (slot + 1) & _mask;
+    }
+
+    // First occurrence, make room in the window if necessary.
+    // Evicting an entry may move other entries in the table, search a free slot again.
+    if (_count == _ring.size()) {
+        evictOldest();
+        slot = slotOf(hash);
+        while (_table[slot] != NPOS) {
+            slot = (slot + 1) & _mask;
+        }
+    }
+
+    const size_t index = (_first + _count) % _ring.size();
+    Entry& entry(_ring[index]);
+    entry.hash = hash;
+    entry.pidcc = pidcc;
+    entry.inputs = bit;
+    _table[slot] = index;
+    _count++;
+    stats.unique++;
+    return true;
+}
+
+
+//----------------------------------------------------------------------------
+// Remove the oldest entry from the window and the lookup table.
+//----------------------------------------------------------------------------
+
+void ts::TSPacketDeduplicator::evictOldest()
+{
+    assert(_count > 0);
+    const Entry& entry(_ring[_first]);
+
+    // All active inputs which did not deliver this packet have lost it.
+    const uint64_t missing = _active & ~entry.inputs;
+    if (missing != 0) {
+        for (size_t i = 0; i < _stats.size(); ++i) {
+            if ((missing & (uint64_t(1) << i)) != 0) {
+                _stats[i].lost++;
+            }
+        }
+    }
+
+    // Locate the entry in the lookup table.
+    size_t slot = slotOf(entry.hash);
+    while (_table[slot] != _first) {
+        assert(_table[slot] != NPOS);
+        slot = (slot + 1) & _mask;
+    }
+
+    // Backward shift deletion: move back subsequent entries of the probe sequence
+    // which can fill the hole, so that lookups never need tombstones.
+    for (size_t next = (slot + 1) & _mask; _table[next] != NPOS; next = (next + 1) & _mask) {
+        const size_t home = slotOf(_ring[_table[next]].hash);
+        if (((next - home) & _mask) >= ((next - slot) & _mask)) {
+            _table[slot] = _table[next];
+            slot = next;
+        }
+    }
+    _table[slot] = NPOS;
+
+    _first = (_first + 1) % _ring.size();
+    _count--;
+}
+
+
+//----------------------------------------------------------------------------
+// Forget all fingerprints in the window.
+//----------------------------------------------------------------------------
+
+void ts::TSPacketDeduplicator::flush()
+{
+    while (_count > 0) {
+        evictOldest();
+    }
+    _first = 0;
+}
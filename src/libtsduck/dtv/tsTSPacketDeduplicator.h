@@ -0,0 +1,186 @@
+//----------------------------------------------------------------------------
+//
+// TSDuck - The MPEG Transport Stream Toolkit
+// Copyright (c) 2005-2020, Thierry Lelegard
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+// THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------
+//!
+//!  @file
+//!  Windowed detection of duplicate TS packets across one or more input streams.
+//!
+//----------------------------------------------------------------------------
+
+#pragma once
+#include "tsTSPacket.h"
+
+namespace ts {
+    //!
+    //! Windowed detection of duplicate TS packets across one or more input streams.
+    //! @ingroup mpeg
+    //!
+    //! TSPacket::isDuplicate() only compares a packet with the previous packet in the
+    //! same PID. This class detects duplicate packets within a sliding window of the
+    //! most recent distinct packets, possibly coming from several redundant inputs.
+    //! This is typically used to merge redundant feeds (SMPTE 2022-7 style) where the
+    //! same packet may arrive on each input, at slightly different times.
+    //!
+    //! Packets are not stored. Each packet is identified by a 64-bit fingerprint of
+    //! its content and by its PID and continuity counter. Like isDuplicate(), the PCR
+    //! of a packet with payload is ignored in the fingerprint. Null packets are never
+    //! considered as duplicates.
+    //!
+    //! Memory usage is bounded: the window is a circular buffer of fingerprints and
+    //! the lookup table is a fixed-size open-addressing hash table. When the window
+    //! is full, the oldest fingerprint is forgotten.
+    //!
+    //! When a fingerprint leaves the window, each input which has already delivered
+    //! at least one packet but never delivered this one is considered as having lost
+    //! the packet. This gives per-input loss statistics on redundant inputs.
+    //!
+    class TSDUCKDLL TSPacketDeduplicator
+    {
+        TS_NOCOPY(TSPacketDeduplicator);
+    public:
+        //!
+        //! Default size of the window in packets.
+        //!
+        static constexpr size_t DEFAULT_WINDOW = 1000;
+
+        //!
+        //! Maximum number of inputs.
+        //!
+        static constexpr size_t MAX_INPUTS = 64;
+
+        //!
+        //! Statistics of one input.
+        //!
+        struct TSDUCKDLL InputStatistics
+        {
+            PacketCounter packets;     //!< Total number of packets from this input.
+            PacketCounter unique;      //!< Number of packets which were first seen on this input, including null packets.
+            PacketCounter duplicates;  //!< Number of duplicate packets from this input.
+            PacketCounter lost;        //!< Number of packets which were seen on other inputs but never on this one.
+
+            //!
+            //! Constructor.
+            //!
+            InputStatistics() : packets(0), unique(0), duplicates(0), lost(0) {}
+        };
+
+        //!
+        //! Constructor.
+        //! @param [in] window Size of the window in packets. This is the number of most recent
+        //! distinct packets which are remembered. The minimum value is 1.
+        //! @param [in] inputs Number of inputs, from 1 to MAX_INPUTS.
+        //!
+        explicit TSPacketDeduplicator(size_t window = DEFAULT_WINDOW, size_t inputs = 1);
+
+        //!
+        //! Reset the deduplicator with new parameters.
+        //! All fingerprints and statistics are cleared.
+        //! @param [in] window Size of the window in packets. The minimum value is 1.
+        //! @param [in] inputs Number of inputs, from 1 to MAX_INPUTS.
+        //!
+        void reset(size_t window, size_t inputs);
+
+        //!
+        //! Submit a packet from one input.
+        //! @param [in] pkt The packet to check.
+        //! @param [in] input Index of the input, from 0 to inputCount() - 1.
+        //! @return True if this is the first occurrence of the packet in the window
+        //! (the packet shall be kept), false if this is a duplicate (the packet can be dropped).
+        //!
+        bool feedPacket(const TSPacket& pkt, size_t input = 0);
+
+        //!
+        //! Forget all fingerprints in the window.
+        //! The lost packets of each input are accounted in the statistics as if all
+        //! fingerprints left the window. The statistics are not reset.
+        //!
+        void flush();
+
+        //!
+        //! Get the size of the window.
+        //! @return The size of the window in packets.
+        //!
+        size_t window() const { return _ring.size(); }
+
+        //!
+        //! Get the number of inputs.
+        //! @return The number of inputs.
+        //!
+        size_t inputCount() const { return _stats.size(); }
+
+        //!
+        //! Get the number of fingerprints which are currently in the window.
+        //! @return The number of fingerprints in the window.
+        //!
+        size_t size() const { return _count; }
+
+        //!
+        //! Get the statistics of one input.
+        //! @param [in] input Index of the input, from 0 to inputCount() - 1.
+        //! @return A constant reference to the statistics of the input.
+        //!
+        const InputStatistics& statistics(size_t input) const { return _stats[input]; }
+
+        //!
+        //! Compute the 64-bit fingerprint of a TS packet.
+        //! The PCR of a packet with payload is ignored, as in TSPacket::isDuplicate().
+        //! The fingerprint is not portable, it shall be used only in the same process.
+        //! @param [in] pkt The packet to hash.
+        //! @return The 64-bit fingerprint of the packet.
+        //!
+        static uint64_t Fingerprint(const TSPacket& pkt);
+
+    private:
+        // One fingerprint in the window.
+        struct Entry
+        {
+            uint64_t hash;    // Fingerprint of the packet content.
+            uint64_t inputs;  // Bit mask of inputs which delivered the packet.
+            uint16_t pidcc;   // PID (12 upper bits) and CC (4 lower bits).
+            Entry() : hash(0), inputs(0), pidcc(0) {}
+        };
+
+        // The window is a circular buffer of entries, in order of first arrival.
+        // The lookup table contains indexes in the window or NPOS for free slots.
+        // It uses linear probing and is at least twice as large as the window,
+        // so that probe sequences remain short.
+        std::vector<Entry>           _ring;     // Circular buffer of fingerprints.
+        size_t                       _first;    // Index of oldest entry in _ring.
+        size_t                       _count;    // Number of valid entries in _ring.
+        std::vector<size_t>          _table;    // Lookup table, size is a power of 2.
+        size_t                       _mask;     // Mask of table indexes (table size - 1).
+        uint64_t                     _active;   // Bit mask of inputs which delivered at least one packet.
+        std::vector<InputStatistics> _stats;    // Per-input statistics.
+
+        // Get the first table slot for a fingerprint.
+        size_t slotOf(uint64_t hash) const { return size_t(hash ^ (hash >> 32)) & _mask; }
+
+        // Remove the oldest entry from the window and the lookup table.
+        void evictOldest();
+    };
+}
@@ -167,6 +167,47 @@ void ts::TSPacketQueue::releaseWriteBuffer(size_t count)
 }
 
 
+//----------------------------------------------------------------------------
+// Called by the writer thread to enqueue packets without waiting.
+//----------------------------------------------------------------------------
+
+size_t ts::TSPacketQueue::putPackets(const TSPacket* buffer, size_t count)
+{
+    GuardCondition lock(_mutex, _enqueued);
+
+    // Nothing can be enqueued after a stop condition from the reader thread.
+    if (_stopped || buffer == nullptr) {
+        return 0;
+    }
+
+    // Enqueue as many packets as possible, in at most two contiguous chunks.
+    count = std::min(count, _buffer.size() - _inCount);
+    size_t remain = count;
+    while (remain > 0) {
+        const size_t chunk = std::min(remain, _buffer.size() - _writeIndex);
+        TSPacket::Copy(&_buffer[_writeIndex], buffer, chunk);
+
+        // When the writer thread did not specify a bitrate, analyze PCR's.
+        if (_bitrate == 0) {
+            for (size_t i = 0; i < chunk; ++i) {
+                _pcr.feedPacket(buffer[i]);
+            }
+        }
+
+        buffer += chunk;
+        remain -= chunk;
+        _inCount += chunk;
+        _writeIndex = (_writeIndex + chunk) % _buffer.size();
+    }
+
+    // Signal that packets have been enqueued
+    if (count > 0) {
+        lock.signal();
+    }
+    return count;
+}
+
+
 //----------------------------------------------------------------------------
 // Called by the writer thread to report the input bitrate.
 //----------------------------------------------------------------------------
@@ -308,4 +349,7 @@ void ts::TSPacketQueue::stop()
     // Signal the condition that a packet was freed. This is not really freeing
     // a packet but it means that the writer thread should wake up.
     lock.signal();
+
+    // Also wake up a reader thread which is waiting for packets in waitPackets().
+    _enqueued.signal();
 }
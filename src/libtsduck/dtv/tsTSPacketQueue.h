@@ -111,6 +111,17 @@ namespace ts {
         //!
         void releaseWriteBuffer(size_t count);
 
+        //!
+        //! Called by the writer thread to enqueue packets without waiting.
+        //! The writer thread is never suspended. Packets which do not fit in the
+        //! free space of the buffer are not enqueued.
+        //! @param [in] buffer Address of packets to enqueue.
+        //! @param [in] count Number of packets in @a buffer.
+        //! @return Number of packets which were actually enqueued, from the beginning of @a buffer.
+        //! Zero when the reader thread has signalled a stop condition.
+        //!
+        size_t putPackets(const TSPacket* buffer, size_t count);
+
         //!
         //! Called by the writer thread to report the input bitrate.
         //! @param [in] bitrate Input bitrate. If zero, the input bitrate is unknown
@@ -158,6 +169,8 @@ namespace ts {
 
         //!
         //! Called by the reader thread to tell the writer thread to stop immediately.
+        //! Can also be called from any other thread to abort a reader thread which
+        //! is waiting in waitPackets().
         //!
         void stop();
 
@@ -29,6 +29,7 @@
 
 #include "tsTablesLogger.h"
 #include "tsTablesLoggerFilterRepository.h"
+#include "tsSectionFileIndex.h"
 #include "tsBinaryTable.h"
 #include "tsPAT.h"
 #include "tstlv.h"
@@ -65,6 +66,7 @@ ts::TablesLogger::TablesLogger(TablesDisplay& display) :
     _flush(false),
     _rewrite_xml(false),
     _rewrite_binary(false),
+    _binary_index(false),
     _udp_local(),
     _udp_ttl(0),
     _udp_raw(false),
@@ -96,6 +98,8 @@ ts::TablesLogger::TablesLogger(TablesDisplay& display) :
     _xmlDoc(_report),
     _xmlOpen(false),
     _binfile(),
+    _idxfile(),
+    _bin_offset(0),
     _sock(false, _report),
     _shortSections(),
     _allSections(),
@@ -144,6 +148,16 @@ void ts::TablesLogger::defineArgs(Args& args) const
               u"mode is incompatible with --xml-output since valid XML structures may "
               u"contain complete tables only.");
 
+    args.option(u"binary-index");
+    args.help(u"binary-index",
+              u"With --binary-output, also create an index of the binary file. The index file "
+              u"has the same name as the binary file with an additional '.idx' suffix. It "
+              u"contains the position, PID, table id, table id extension, version, section "
+              u"number, packet index and time of collection of each section. It is used by "
+              u"'tstabdump' to extract selected sections or a time range from a huge binary "
+              u"file without reading all of it. Incompatible with --multiple-files and "
+              u"--rewrite-binary.");
+
     args.option(u"binary-output", 'b', Args::STRING);
     args.help(u"binary-output", u"filename",
               u"Save sections in the specified binary output file. "
@@ -310,6 +324,7 @@ bool ts::TablesLogger::loadArgs(DuckContext& duck, Args& args)
 
     _multi_files = args.present(u"multiple-files");
     _rewrite_binary = args.present(u"rewrite-binary");
+    _binary_index = args.present(u"binary-index");
     _rewrite_xml = args.present(u"rewrite-xml");
     _flush = args.present(u"flush");
     _udp_local = args.value(u"local-udp");
@@ -334,6 +349,10 @@ bool ts::TablesLogger::loadArgs(DuckContext& duck, Args& args)
         args.error(u"options --rewrite-binary and --multiple-files are incompatible");
         return false;
     }
+    if (_binary_index && (!_use_binary || _rewrite_binary || _multi_files)) {
+        args.error(u"option --binary-index requires --binary-output and is incompatible with --rewrite-binary and --multiple-files");
+        return false;
+    }
 
     // Load options from all section filters.
     _initial_pids.reset();
@@ -372,6 +391,9 @@ bool ts::TablesLogger::open()
     if (_binfile.is_open()) {
         _binfile.close();
     }
+    if (_idxfile.is_open()) {
+        _idxfile.close();
+    }
     if (_sock.isOpen()) {
         _sock.close(_report);
     }
@@ -453,6 +475,9 @@ void ts::TablesLogger::close()
         if (_binfile.is_open()) {
             _binfile.close();
         }
+        if (_idxfile.is_open()) {
+            _idxfile.close();
+        }
         if (_sock.isOpen()) {
             _sock.close(_report);
         }
@@ -820,15 +845,26 @@ bool ts::TablesLogger::createBinaryFile(const ts::UString& name)
 {
     _report.verbose(u"creating %s", {name});
     _binfile.open(name.toUTF8().c_str(), std::ios::out | std::ios::binary);
+    _bin_offset = 0;
 
-    if (_binfile) {
-        return true;
-    }
-    else {
+    if (!_binfile) {
         _report.error(u"error creating %s", {name});
         _abort = true;
         return false;
     }
+
+    // Create the index file if required.
+    if (_binary_index) {
+        const UString idxname(SectionFileIndex::DefaultFileName(name));
+        _report.verbose(u"creating %s", {idxname});
+        _idxfile.open(idxname.toUTF8().c_str(), std::ios::out | std::ios::binary);
+        if (!_idxfile || !SectionFileIndex::WriteHeader(_idxfile)) {
+            _report.error(u"error creating %s", {idxname});
+            _abort = true;
+            return false;
+        }
+    }
+    return true;
 }
 
 
@@ -857,6 +893,17 @@ void ts::TablesLogger::saveBinarySection(const Section& sect)
     if (!sect.write(_binfile, _report)) {
         _abort = true;
     }
+    else if (_binary_index) {
+        // Add the section in the index.
+        if (!SectionFileIndex::WriteEntry(_idxfile, SectionFileIndex::Entry(sect, _bin_offset, Time::CurrentUTC()))) {
+            _report.error(u"error writing binary index file");
+            _abort = true;
+        }
+        else if (_flush) {
+            _idxfile.flush();
+        }
+    }
+    _bin_offset += sect.size();
 
     // Close individual files
     if (_multi_files) {
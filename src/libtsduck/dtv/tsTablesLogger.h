@@ -156,6 +156,7 @@ namespace ts {
         bool                     _flush;             // Flush output file.
         bool                     _rewrite_xml;       // Rewrite a new XML file for each table.
         bool                     _rewrite_binary;    // Rewrite a new binary file for each table.
+        bool                     _binary_index;      // Create an index of the binary output file.
         UString                  _udp_local;         // Name of outgoing local address (empty if unspecified).
         int                      _udp_ttl;           // Time-to-live socket option.
         bool                     _udp_raw;           // UDP messages contain raw sections, not structured messages.
@@ -189,6 +190,8 @@ namespace ts {
         xml::Document            _xmlDoc;            // XML root document.
         bool                     _xmlOpen;           // The XML root element is open.
         std::ofstream            _binfile;           // Binary output file.
+        std::ofstream            _idxfile;           // Index of binary output file.
+        uint64_t                 _bin_offset;        // Current offset in binary output file.
         UDPSocket                _sock;              // Output socket.
         std::map<PID,SectionPtr> _shortSections;     // Tracking duplicate short sections by PID.
         std::map<PID,SectionPtr> _allSections;       // Tracking duplicate sections by PID (with --all-sections).
@@ -30,6 +30,8 @@
 #include "tsTimeShiftBuffer.h"
 #include "tsNullReport.h"
 #include "tsSysUtils.h"
+#include "tsGuard.h"
+#include "tsGuardCondition.h"
 TSDUCK_SOURCE;
 
 #if defined(TS_NEED_STATIC_CONST_DEFINITIONS)
@@ -53,13 +55,19 @@ ts::TimeShiftBuffer::TimeShiftBuffer(size_t count) :
     _file(),
     _next_read(0),
     _next_write(0),
-    _wcache_next(0),
-    _rcache_end(0),
-    _rcache_next(0),
     _wcache(),
-    _rcache(),
     _wmdata(),
-    _rmdata()
+    _wblocks(),
+    _rblocks(),
+    _wcur(0),
+    _rcur(0),
+    _io_thread(this),
+    _io_mutex(),
+    _io_todo(),
+    _io_done(),
+    _io_queue(),
+    _io_terminate(false),
+    _io_report()
 {
 }
 
@@ -68,6 +76,27 @@ ts::TimeShiftBuffer::~TimeShiftBuffer()
     close(NULLREP);
 }
 
+ts::TimeShiftBuffer::Block::Block() :
+    packets(),
+    mdata(),
+    index(0),
+    count(0),
+    next(0),
+    write(false),
+    pending(false),
+    success(true)
+{
+}
+
+void ts::TimeShiftBuffer::Block::resize(size_t size)
+{
+    packets.resize(size);
+    mdata.resize(size);
+    index = count = next = 0;
+    write = pending = false;
+    success = true;
+}
+
 
 //----------------------------------------------------------------------------
 // Set various characteristics, must be called before open.
@@ -122,8 +151,6 @@ bool ts::TimeShiftBuffer::open(Report& report)
         // The buffer is entirely memory-resident in _wcache.
         _wcache.resize(_total_packets);
         _wmdata.resize(_total_packets);
-        _rcache.clear();
-        _rmdata.clear();
     }
     else {
         // The buffer is backed up on disk.
@@ -145,18 +172,34 @@ bool ts::TimeShiftBuffer::open(Report& report)
             return false;
         }
 
-        // The read and write buffers use half of memory quota each.
-        // Since the size of the file is larger than the sum of the two,
-        // the read and write caches never overlap when the buffer is full.
-        _wcache.resize(_mem_packets / 2);
-        _wmdata.resize(_mem_packets / 2);
-        _rcache.resize(_mem_packets / 2);
-        _rmdata.resize(_mem_packets / 2);
+        // The memory quota is split into two write blocks and two read blocks.
+        // Since the size of the file is larger than the sum of the four blocks,
+        // the read and write areas never overlap when the buffer is full.
+        const size_t block_size = std::max<size_t>(1, _mem_packets / 4);
+        for (size_t i = 0; i < 2; ++i) {
+            _wblocks[i].resize(block_size);
+            _rblocks[i].resize(block_size);
+        }
+        _wcur = _rcur = 0;
+
+        // Start the I/O thread.
+        _io_queue.clear();
+        _io_terminate = false;
+        _io_report.resetMessages();
+        if (!_io_thread.start()) {
+            // Without I/O thread, no I/O request would ever complete.
+            report.error(u"cannot start the I/O thread of the time-shift buffer");
+            for (size_t i = 0; i < 2; ++i) {
+                _wblocks[i].resize(0);
+                _rblocks[i].resize(0);
+            }
+            _file.close(report);
+            return false;
+        }
     }
 
     _cur_packets = 0;
     _next_read = _next_write = 0;
-    _wcache_next = _rcache_end = _rcache_next = 0;
     _is_open = true;
     return true;
 }
@@ -172,12 +215,19 @@ bool ts::TimeShiftBuffer::close(Report& report)
         return false;
     }
 
+    // Stop the I/O thread before closing the file.
+    if (_file.isOpen()) {
+        stopIO();
+    }
+
     _is_open = false;
     _cur_packets = 0;
     _wcache.clear();
     _wmdata.clear();
-    _rcache.clear();
-    _rmdata.clear();
+    for (size_t i = 0; i < 2; ++i) {
+        _wblocks[i].resize(0);
+        _rblocks[i].resize(0);
+    }
     return !_file.isOpen() || _file.close(report);
 }
 
@@ -220,51 +270,35 @@ bool ts::TimeShiftBuffer::shift(TSPacket& packet, TSPacketMetadata& mdata, Repor
     }
     else {
         // The buffer uses a backup file.
-        if (!was_full) {
-            // While the buffer is not full, simply write the packet in the file.
-            if (!_file.writePackets(&packet, &mdata, 1, report)) {
-                return false;
-            }
-            _cur_packets++;
-        }
-        else {
-            // The buffer is full, now read and write in caches.
-            // First, make sure the read cache is filled.
-            if (_rcache_next >= _rcache_end) {
-                // Read cache is empty, load it.
-                const size_t count = std::min(_rcache.size(), _total_packets - _next_read);
-                _rcache_next = 0;
-                _rcache_end = readFile(_next_read, &_rcache[0], &_rmdata[0], count, report);
-                if (_rcache_end == 0) {
-                    report.error(u"error reading time-shift file");
-                    return false;
-                }
-            }
-            // Return oldest packet from memory cache.
-            ret_packet = _rcache[_rcache_next];
-            ret_mdata = _rmdata[_rcache_next++];
-            _next_read = (_next_read + 1) % _total_packets;
-            // Flush the write cache if necessary.
-            if (_wcache_next >= _wcache.size()) {
-                // Flush the entire write cache on disk.
-                // Split in two operations if exceeds the end of file.
-                // Write index in file of the start of the write cache:
-                const size_t file_index = _next_write >= _wcache.size() ? _next_write - _wcache.size() : _total_packets + _next_write - _wcache.size();
-                assert(file_index < _total_packets);
-                const size_t count = std::min(_wcache.size(), _total_packets - file_index);
-                if (!writeFile(file_index, &_wcache[0], &_wmdata[0], count, report)) {
-                    return false;
+        if (was_full) {
+            // The buffer is full, return the oldest packet from the current read block.
+            Block* rb = &_rblocks[_rcur];
+            if (rb->next >= rb->count) {
+                // Current read block is exhausted, switch to the other one, normally already prefetched.
+                _rcur ^= 1;
+                rb = &_rblocks[_rcur];
+                if (!rb->pending && rb->next >= rb->count) {
+                    // Nothing was prefetched, this is the first read after the buffer became full.
+                    startRead(*rb, _next_read);
                 }
-                // Write second part at begining of file if required.
-                if (count < _wcache.size() && !writeFile(0, &_wcache[count], &_wmdata[count], _wcache.size() - count, report)) {
+                if (!waitIO(*rb, report)) {
                     return false;
                 }
-                // Write cache is now empty.
-                _wcache_next = 0;
+                assert(rb->index == _next_read);
+                // Prefetch the next block in the other read block.
+                startRead(_rblocks[_rcur ^ 1], (rb->index + rb->count) % _total_packets);
             }
-            // Write the next packet in the write cache.
-            _wcache[_wcache_next] = packet;
-            _wmdata[_wcache_next++] = mdata;
+            ret_packet = rb->packets[rb->next];
+            ret_mdata = rb->mdata[rb->next++];
+            _next_read = (_next_read + 1) % _total_packets;
+        }
+        else {
+            // Buffer not full, increase the packet count.
+            _cur_packets++;
+        }
+        // Write the packet in the current write block.
+        if (!writePacket(packet, mdata, report)) {
+            return false;
         }
         _next_write = (_next_write + 1) % _total_packets;
     }
@@ -283,6 +317,145 @@ bool ts::TimeShiftBuffer::shift(TSPacket& packet, TSPacketMetadata& mdata, Repor
 }
 
 
+//----------------------------------------------------------------------------
+// Add a packet in the current write block, flush it when necessary.
+//----------------------------------------------------------------------------
+
+bool ts::TimeShiftBuffer::writePacket(const TSPacket& packet, const TSPacketMetadata& mdata, Report& report)
+{
+    Block& wb = _wblocks[_wcur];
+    assert(!wb.pending);
+    assert(wb.count < wb.packets.size());
+
+    if (wb.count == 0) {
+        wb.index = _next_write;
+    }
+    wb.packets[wb.count] = packet;
+    wb.mdata[wb.count++] = mdata;
+
+    // Flush the block when full or at end of file. This way, all blocks
+    // are written at positions in the file which are multiple of the block size.
+    if (wb.count >= wb.packets.size() || wb.index + wb.count >= _total_packets) {
+        startIO(wb, true);
+        // Switch to the other write block, wait for the completion of its previous flush.
+        _wcur ^= 1;
+        Block& next = _wblocks[_wcur];
+        if (!waitIO(next, report)) {
+            return false;
+        }
+        next.count = 0;
+    }
+    return true;
+}
+
+
+//----------------------------------------------------------------------------
+// Queue a read request for a block in the backup file.
+//----------------------------------------------------------------------------
+
+void ts::TimeShiftBuffer::startRead(Block& block, size_t index)
+{
+    assert(index < _total_packets);
+    block.index = index;
+    block.count = std::min(block.packets.size(), _total_packets - index);
+    block.next = 0;
+    startIO(block, false);
+}
+
+
+//----------------------------------------------------------------------------
+// Queue an I/O request on a block.
+//----------------------------------------------------------------------------
+
+void ts::TimeShiftBuffer::startIO(Block& block, bool write)
+{
+    GuardCondition lock(_io_mutex, _io_todo);
+    assert(!block.pending);
+    block.write = write;
+    block.pending = true;
+    _io_queue.push_back(&block);
+    lock.signal();
+}
+
+
+//----------------------------------------------------------------------------
+// Wait for the completion of an I/O request on a block.
+//----------------------------------------------------------------------------
+
+bool ts::TimeShiftBuffer::waitIO(Block& block, Report& report)
+{
+    GuardCondition lock(_io_mutex, _io_done);
+    while (block.pending) {
+        lock.waitCondition();
+    }
+    if (!block.success) {
+        // Report the error messages from the I/O thread.
+        const UString messages(_io_report.getMessages());
+        _io_report.resetMessages();
+        report.error(messages.empty() ? u"error accessing time-shift file" : messages);
+    }
+    return block.success;
+}
+
+
+//----------------------------------------------------------------------------
+// Stop the I/O thread.
+//----------------------------------------------------------------------------
+
+void ts::TimeShiftBuffer::stopIO()
+{
+    {
+        GuardCondition lock(_io_mutex, _io_todo);
+        _io_terminate = true;
+        lock.signal();
+    }
+    _io_thread.waitForTermination();
+}
+
+
+//----------------------------------------------------------------------------
+// Background I/O thread.
+//----------------------------------------------------------------------------
+
+void ts::TimeShiftBuffer::IOThread::main()
+{
+    for (;;) {
+        // Wait for the next I/O request.
+        Block* block = nullptr;
+        {
+            GuardCondition lock(_parent->_io_mutex, _parent->_io_todo);
+            while (_parent->_io_queue.empty() && !_parent->_io_terminate) {
+                lock.waitCondition();
+            }
+            if (_parent->_io_terminate) {
+                // Pending requests are useless since the temporary file is about to be deleted.
+                break;
+            }
+            block = _parent->_io_queue.front();
+            _parent->_io_queue.pop_front();
+        }
+
+        // Perform the I/O without holding the mutex. The block is not accessed
+        // by the application thread while the request is pending.
+        bool success = false;
+        if (block->write) {
+            success = _parent->writeFile(block->index, &block->packets[0], &block->mdata[0], block->count, _parent->_io_report);
+        }
+        else {
+            success = _parent->readFile(block->index, &block->packets[0], &block->mdata[0], block->count, _parent->_io_report) == block->count;
+        }
+
+        // Notify the completion.
+        {
+            GuardCondition lock(_parent->_io_mutex, _parent->_io_done);
+            block->success = success;
+            block->pending = false;
+            lock.signal();
+        }
+    }
+}
+
+
 //----------------------------------------------------------------------------
 // Seek in the backup file.
 //----------------------------------------------------------------------------
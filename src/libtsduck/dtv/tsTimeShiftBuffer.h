@@ -36,7 +36,10 @@
 #include "tsUString.h"
 #include "tsTSFile.h"
 #include "tsTSPacketMetadata.h"
-#include "tsReport.h"
+#include "tsReportBuffer.h"
+#include "tsThread.h"
+#include "tsMutex.h"
+#include "tsCondition.h"
 
 namespace ts {
 
@@ -45,6 +48,14 @@ namespace ts {
     //!
     //! A TS packet buffer for time shift.
     //! The buffer is partly implemented in virtual memory and partly on disk.
+    //!
+    //! When the buffer is backed up on disk, the memory cache is split into four
+    //! blocks, two for writing and two for reading. The backup file is read and
+    //! written by complete blocks, at block-aligned positions in the file. All disk
+    //! I/O are performed by an internal thread: a write block is flushed on disk
+    //! while packets are accumulated in the other one and the next read block is
+    //! prefetched while packets are returned from the current one.
+    //!
     //! @ingroup mpeg
     //!
     class TSDUCKDLL TimeShiftBuffer
@@ -176,21 +187,73 @@ namespace ts {
         bool shift(TSPacket& packet, TSPacketMetadata& metadata, Report& report);
 
     private:
+        // A block of packets in memory, for I/O on the backup file.
+        class Block
+        {
+            TS_NOCOPY(Block);
+        public:
+            Block();
+            TSPacketVector         packets;  // Packet buffer.
+            TSPacketMetadataVector mdata;    // Packet metadata.
+            size_t                 index;    // Index in the time-shift buffer (the file) of first packet.
+            size_t                 count;    // Number of valid packets in the block.
+            size_t                 next;     // Index in block of next packet to return (read blocks only).
+            bool                   write;    // The pending I/O operation is a write (otherwise a read).
+            bool                   pending;  // An I/O operation is pending or in progress on this block.
+            bool                   success;  // Status of the last I/O operation.
+
+            // Allocate or free the memory.
+            void resize(size_t size);
+        };
+
+        // The background thread which performs all I/O on the backup file.
+        class IOThread : public Thread
+        {
+            TS_NOBUILD_NOCOPY(IOThread);
+        public:
+            // Constructor.
+            IOThread(TimeShiftBuffer* parent) : _parent(parent) {}
+        private:
+            // Thread entry point.
+            virtual void main() override;
+            // Link to parent time-shift buffer.
+            TimeShiftBuffer* _parent;
+        };
+
         bool    _is_open;                // Buffer is open.
         size_t  _cur_packets;            // Current number of packets in the buffer.
         size_t  _total_packets;          // Total capacity of the buffer.
         size_t  _mem_packets;            // Max packets in memory.
         UString _directory;              // Where to store the backup file.
-        TSFile  _file;                   // Backup file on disk.
+        TSFile  _file;                   // Backup file on disk, used by the I/O thread only when open.
         size_t  _next_read;              // Index in buffer of next packet to read.
         size_t  _next_write;             // Index in buffer of next packet to write.
-        size_t  _wcache_next;            // Next index to write in _wcache (up to end of _wcache).
-        size_t  _rcache_end;             // End index in _rcache (after last loaded packet).
-        size_t  _rcache_next;            // Next index to read in _rcache.
-        TSPacketVector         _wcache;  // Write cache (or complete buffer if in memory).
-        TSPacketVector         _rcache;  // Read cache.
+        TSPacketVector         _wcache;  // Complete buffer when memory resident.
         TSPacketMetadataVector _wmdata;  // Packet metadata for _wcache.
-        TSPacketMetadataVector _rmdata;  // Packet metadata for _rcache.
+        Block   _wblocks[2];             // Write blocks when using a backup file.
+        Block   _rblocks[2];             // Read blocks when using a backup file.
+        size_t  _wcur;                   // Index of current write block (0 or 1).
+        size_t  _rcur;                   // Index of current read block (0 or 1).
+        IOThread             _io_thread; // Background I/O thread.
+        Mutex                _io_mutex;  // Protect the following fields and the "pending" state of blocks.
+        Condition            _io_todo;   // Signaled when an I/O request is queued.
+        Condition            _io_done;   // Signaled when an I/O request is completed.
+        std::deque<Block*>   _io_queue;  // Queue of I/O requests.
+        bool                 _io_terminate; // Request to terminate the I/O thread.
+        ReportBuffer<Mutex>  _io_report; // Error messages from the I/O thread.
+
+        // Queue an I/O request on a block, wait for its completion.
+        void startIO(Block& block, bool write);
+        bool waitIO(Block& block, Report& report);
+
+        // Queue a read request for a block in the backup file.
+        void startRead(Block& block, size_t index);
+
+        // Add a packet in the current write block, flush it when necessary.
+        bool writePacket(const TSPacket& packet, const TSPacketMetadata& mdata, Report& report);
+
+        // Stop the I/O thread.
+        void stopIO();
 
         // Seek, read, write in the backup file.
         bool seekFile(size_t index, Report& report);
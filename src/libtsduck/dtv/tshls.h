@@ -53,7 +53,7 @@ namespace ts {
         //! Tags to be used in the .M3U8 playlists.
         //! @ingroup hls
         //! @see RFC 8216, chapter 4.
-        //! @see draft-pantos-hls-rfc8216bis-03
+        //! @see draft-pantos-hls-rfc8216bis-07 (low-latency extensions)
         //!
         enum Tag {
             //
@@ -82,6 +82,15 @@ namespace ts {
             ENDLIST,                 //!< \#EXT-X-ENDLIST
             PLAYLIST_TYPE,           //!< \#EXT-X-PLAYLIST-TYPE:type (EVENT or VOD).
             I_FRAMES_ONLY,           //!< \#EXT-X-I-FRAMES-ONLY
+            PART_INF,                //!< \#EXT-X-PART-INF:attribute-list - low-latency HLS.
+            SERVER_CONTROL,          //!< \#EXT-X-SERVER-CONTROL:attribute-list - low-latency HLS.
+            //
+            // 4.4.5 Media Metadata Tags (low-latency HLS), media playlists only.
+            //
+            PART,                    //!< \#EXT-X-PART:attribute-list - partial segment.
+            PRELOAD_HINT,            //!< \#EXT-X-PRELOAD-HINT:attribute-list - next partial segment.
+            RENDITION_REPORT,        //!< \#EXT-X-RENDITION-REPORT:attribute-list
+            SKIP,                    //!< \#EXT-X-SKIP:attribute-list
             //
             // 4.3.4 Master Playlist Tags
             //
@@ -34,6 +34,7 @@
 
 #pragma once
 #include "tshls.h"
+#include "tshlsMediaPart.h"
 #include "tsMPEG.h"
 
 namespace ts {
@@ -51,11 +52,12 @@ namespace ts {
             MediaSegment();
 
             // Public fields.
-            UString     uri;       //!< Relative URI of segment.
-            UString     title;     //!< Optional segment title.
-            MilliSecond duration;  //!< Segment duration in milliseconds.
-            BitRate     bitrate;   //!< Indicative bitrate.
-            bool        gap;       //!< Media is a "gap", should not be loaded by clients.
+            UString       uri;       //!< Relative URI of segment.
+            UString       title;     //!< Optional segment title.
+            MilliSecond   duration;  //!< Segment duration in milliseconds.
+            BitRate       bitrate;   //!< Indicative bitrate.
+            bool          gap;       //!< Media is a "gap", should not be loaded by clients.
+            MediaPartList parts;     //!< Partial segments of this segment (low-latency HLS only).
         };
     }
 }
@@ -53,6 +53,9 @@ ts::hls::PlayList::PlayList() :
     _utcDownload(),
     _utcTermination(),
     _segments(),
+    _partTargetDuration(0),
+    _pendingParts(),
+    _preloadHint(),
     _playlists(),
     _loadedContent(),
     _autoSaveDir()
@@ -80,6 +83,9 @@ void ts::hls::PlayList::clear()
     _utcDownload = Time::Epoch;
     _utcTermination = Time::Epoch;
     _segments.clear();
+    _partTargetDuration = 0;
+    _pendingParts.clear();
+    _preloadHint.clear();
     _playlists.clear();
     _loadedContent.clear();
     // Preserve _autoSaveDir
@@ -229,10 +235,18 @@ bool ts::hls::PlayList::addSegment(const ts::hls::MediaSegment& seg, ts::Report&
     else if (setType(MEDIA_PLAYLIST, report)) {
         // Add the segment.
         _segments.push_back(seg);
-        // Build a relative URI.
-        if (!_isURL && !_original.empty()) {
-            // The playlist's URI is a file name, update the segment's URI.
-            _segments.back().uri = RelativeFilePath(seg.uri, _fileBase, FileSystemCaseSensitivity, true);
+        MediaSegment& last(_segments.back());
+        // Build relative URI's.
+        last.uri = relativeURI(seg.uri);
+        if (last.parts.empty()) {
+            // The pending partial segments were the beginning of this segment.
+            last.parts.swap(_pendingParts);
+        }
+        else {
+            for (auto it = last.parts.begin(); it != last.parts.end(); ++it) {
+                it->uri = relativeURI(it->uri);
+            }
+            _pendingParts.clear();
         }
         return true;
     }
@@ -242,6 +256,53 @@ bool ts::hls::PlayList::addSegment(const ts::hls::MediaSegment& seg, ts::Report&
 }
 
 
+//----------------------------------------------------------------------------
+// Build a relative URI from the playlist's path.
+//----------------------------------------------------------------------------
+
+ts::UString ts::hls::PlayList::relativeURI(const UString& uri) const
+{
+    if (!_isURL && !_original.empty()) {
+        // The playlist's URI is a file name, build a relative URI.
+        return RelativeFilePath(uri, _fileBase, FileSystemCaseSensitivity, true);
+    }
+    else {
+        return uri;
+    }
+}
+
+
+//----------------------------------------------------------------------------
+// Low-latency HLS: partial segments and preload hint.
+//----------------------------------------------------------------------------
+
+bool ts::hls::PlayList::setPartTargetDuration(MilliSecond duration, Report& report)
+{
+    return setMember(MEDIA_PLAYLIST, &PlayList::_partTargetDuration, duration, report);
+}
+
+bool ts::hls::PlayList::addPart(const MediaPart& part, Report& report)
+{
+    if (part.uri.empty()) {
+        report.error(u"empty partial segment URI");
+        return false;
+    }
+    else if (setType(MEDIA_PLAYLIST, report)) {
+        _pendingParts.push_back(part);
+        _pendingParts.back().uri = relativeURI(part.uri);
+        return true;
+    }
+    else {
+        return false;
+    }
+}
+
+bool ts::hls::PlayList::setPreloadHint(const UString& uri, Report& report)
+{
+    return setMember(MEDIA_PLAYLIST, &PlayList::_preloadHint, uri.empty() ? uri : relativeURI(uri), report);
+}
+
+
 bool ts::hls::PlayList::addPlayList(const ts::hls::MediaPlayList& pl, ts::Report& report)
 {
     if (pl.uri.empty()) {
@@ -490,6 +551,11 @@ bool ts::hls::PlayList::reload(bool strict, const WebRequestArgs args, ts::Repor
     assert(plNew._valid);
     report.debug(u"playlist media sequence: old: %d/%s, new: %d/%d", {_mediaSequence, _segments.size(), plNew._mediaSequence, plNew._segments.size()});
 
+    // Partial segments of the segment in progress are always updated (low-latency HLS).
+    _partTargetDuration = plNew._partTargetDuration;
+    _pendingParts.swap(plNew._pendingParts);
+    _preloadHint = plNew._preloadHint;
+
     // If no new segment is present, nothing to do.
     if (plNew._mediaSequence + plNew._segments.size() <= _mediaSequence + _segments.size()) {
         report.debug(u"no new segment in playlist");
@@ -693,6 +759,40 @@ bool ts::hls::PlayList::parse(bool strict, Report& report)
                     plNext.closedCaptions = attr.value(u"CLOSED-CAPTIONS");
                     break;
                 }
+                case PART_INF: {
+                    // #EXT-X-PART-INF:PART-TARGET=<s>
+                    const TagAttributes attr(tagParams);
+                    attr.getMilliValue(_partTargetDuration, u"PART-TARGET");
+                    break;
+                }
+                case PART: {
+                    // #EXT-X-PART:<attribute-list>
+                    // Partial segments are attached to the next media segment.
+                    const TagAttributes attr(tagParams);
+                    MediaPart part;
+                    part.uri = attr.value(u"URI");
+                    attr.getMilliValue(part.duration, u"DURATION");
+                    part.independent = attr.value(u"INDEPENDENT") == u"YES";
+                    part.gap = attr.value(u"GAP") == u"YES";
+                    if (part.uri.empty()) {
+                        if (strict) {
+                            report.error(u"missing URI in %s", {line});
+                            _valid = false;
+                        }
+                    }
+                    else {
+                        segNext.parts.push_back(part);
+                    }
+                    break;
+                }
+                case PRELOAD_HINT: {
+                    // #EXT-X-PRELOAD-HINT:TYPE=PART,URI=<uri>
+                    const TagAttributes attr(tagParams);
+                    if (attr.value(u"TYPE") == u"PART") {
+                        _preloadHint = attr.value(u"URI");
+                    }
+                    break;
+                }
                 case MEDIA:
                 case BYTERANGE:
                 case DISCONTINUITY:
@@ -708,6 +808,9 @@ bool ts::hls::PlayList::parse(bool strict, Report& report)
                 case INDEPENDENT_SEGMENTS:
                 case START:
                 case DEFINE:
+                case SERVER_CONTROL:
+                case RENDITION_REPORT:
+                case SKIP:
                     // Currently ignored tags.
                     break;
                 default:
@@ -718,6 +821,9 @@ bool ts::hls::PlayList::parse(bool strict, Report& report)
         }
     }
 
+    // Partial segments after the last complete segment belong to the segment in progress.
+    _pendingParts.swap(segNext.parts);
+
     return _valid;
 }
 
@@ -1003,10 +1109,32 @@ ts::UString ts::hls::PlayList::textContent(ts::Report &report) const
             if (!_playlistType.empty()) {
                 text.append(UString::Format(u"#%s:%s\n", {TagNames.name(PLAYLIST_TYPE), _playlistType}));
             }
+            if (_partTargetDuration > 0) {
+                // Low-latency HLS: the part hold back shall be at least three part target durations.
+                const MilliSecond holdBack = 3 * _partTargetDuration;
+                text.append(UString::Format(u"#%s:PART-TARGET=%d.%03d\n", {TagNames.name(PART_INF), _partTargetDuration / MilliSecPerSec, _partTargetDuration % MilliSecPerSec}));
+                text.append(UString::Format(u"#%s:PART-HOLD-BACK=%d.%03d\n", {TagNames.name(SERVER_CONTROL), holdBack / MilliSecPerSec, holdBack % MilliSecPerSec}));
+            }
+
+            // Partial segments are listed only for segments within the last three target durations.
+            MilliSecond remaining = 0;
+            for (auto it = _segments.begin(); it != _segments.end(); ++it) {
+                remaining += it->duration;
+            }
+            for (auto it = _pendingParts.begin(); it != _pendingParts.end(); ++it) {
+                remaining += it->duration;
+            }
+            const MilliSecond partsWindow = 3 * _targetDuration * MilliSecPerSec;
 
             // Loop on all media segments.
             for (auto it = _segments.begin(); it != _segments.end(); ++it) {
+                remaining -= it->duration;
                 if (!it->uri.empty()) {
+                    if (remaining < partsWindow) {
+                        for (auto itp = it->parts.begin(); itp != it->parts.end(); ++itp) {
+                            AppendPart(text, *itp);
+                        }
+                    }
                     text.append(UString::Format(u"#%s:%d.%03d,%s\n", {TagNames.name(EXTINF), it->duration / MilliSecPerSec, it->duration % MilliSecPerSec, it->title}));
                     if (it->bitrate > 1024) {
                         text.append(UString::Format(u"#%s:%d\n", {TagNames.name(BITRATE), it->bitrate / 1024}));
@@ -1018,6 +1146,14 @@ ts::UString ts::hls::PlayList::textContent(ts::Report &report) const
                 }
             }
 
+            // Partial segments of the segment in progress and hint for the next one.
+            for (auto it = _pendingParts.begin(); it != _pendingParts.end(); ++it) {
+                AppendPart(text, *it);
+            }
+            if (!_preloadHint.empty() && !_endList) {
+                text.append(UString::Format(u"#%s:TYPE=PART,URI=\"%s\"\n", {TagNames.name(PRELOAD_HINT), _preloadHint}));
+            }
+
             // Mark end of list when necessary.
             if (_endList) {
                 text.append(UString::Format(u"#%s\n", {TagNames.name(ENDLIST)}));
@@ -1033,3 +1169,22 @@ ts::UString ts::hls::PlayList::textContent(ts::Report &report) const
 
     return text;
 }
+
+
+//----------------------------------------------------------------------------
+// Add the description of a partial segment in the text content of a playlist.
+//----------------------------------------------------------------------------
+
+void ts::hls::PlayList::AppendPart(UString& text, const MediaPart& part)
+{
+    if (!part.uri.empty()) {
+        text.append(UString::Format(u"#%s:DURATION=%d.%03d,URI=\"%s\"", {TagNames.name(PART), part.duration / MilliSecPerSec, part.duration % MilliSecPerSec, part.uri}));
+        if (part.independent) {
+            text.append(u",INDEPENDENT=YES");
+        }
+        if (part.gap) {
+            text.append(u",GAP=YES");
+        }
+        text.append(u'\n');
+    }
+}
@@ -285,11 +285,69 @@ namespace ts {
             //! Add a segment in a media playlist.
             //! @param [in] seg The new media segment to append. If the playlist's URI is a file
             //! name, the URI of the segment is transformed into a relative URI from the playlist's path.
+            //! If @a seg has no partial segment, the pending partial segments, if any, are attached to it.
             //! @param [in,out] report Where to report errors.
             //! @return True on success, false on error.
             //!
             bool addSegment(const MediaSegment& seg, Report& report = CERR);
 
+            //!
+            //! Get the partial segment target duration (low-latency HLS, in media playlist).
+            //! @return The partial segment target duration in milliseconds. Zero means that
+            //! the playlist does not use partial segments.
+            //!
+            MilliSecond partTargetDuration() const { return _partTargetDuration; }
+
+            //!
+            //! Set the partial segment target duration in a media playlist.
+            //! Setting a non-zero value turns the media playlist into a low-latency HLS playlist.
+            //! @param [in] duration The partial segment target duration in milliseconds.
+            //! @param [in,out] report Where to report errors.
+            //! @return True on success, false on error.
+            //!
+            bool setPartTargetDuration(MilliSecond duration, Report& report = CERR);
+
+            //!
+            //! Get the number of partial segments of the media segment in progress (low-latency HLS).
+            //! These partial segments are listed after the last complete media segment.
+            //! @return The number of pending partial segments.
+            //!
+            size_t pendingPartCount() const { return _pendingParts.size(); }
+
+            //!
+            //! Get the list of partial segments of the media segment in progress (low-latency HLS).
+            //! @return A constant reference to the list of pending partial segments.
+            //!
+            const MediaPartList& pendingParts() const { return _pendingParts; }
+
+            //!
+            //! Add a partial segment in a media playlist (low-latency HLS).
+            //! The partial segment belongs to the media segment in progress. When the segment
+            //! is complete and added using addSegment(), all pending partial segments are
+            //! attached to it.
+            //! @param [in] part The new partial segment to append. If the playlist's URI is a file
+            //! name, the URI of the partial segment is transformed into a relative URI from the playlist's path.
+            //! @param [in,out] report Where to report errors.
+            //! @return True on success, false on error.
+            //!
+            bool addPart(const MediaPart& part, Report& report = CERR);
+
+            //!
+            //! Get the URI of the next partial segment, as announced by \#EXT-X-PRELOAD-HINT.
+            //! @return The URI of the next partial segment or an empty string if there is none.
+            //!
+            UString preloadHint() const { return _preloadHint; }
+
+            //!
+            //! Set the URI of the next partial segment in a media playlist (low-latency HLS).
+            //! @param [in] uri URI of the next partial segment (\#EXT-X-PRELOAD-HINT).
+            //! An empty string removes the hint. If the playlist's URI is a file name, the URI
+            //! is transformed into a relative URI from the playlist's path.
+            //! @param [in,out] report Where to report errors.
+            //! @return True on success, false on error.
+            //!
+            bool setPreloadHint(const UString& uri, Report& report = CERR);
+
             //!
             //! Get the download UTC time of the playlist.
             //! @return The download UTC time of the playlist.
@@ -390,6 +448,9 @@ namespace ts {
             Time               _utcDownload;     // UTC time of download.
             Time               _utcTermination;  // UTC time of termination (download + all segment durations).
             MediaSegmentQueue  _segments;        // List of media segments (media playlist).
+            MilliSecond        _partTargetDuration; // Partial segment target duration (low-latency media playlist).
+            MediaPartList      _pendingParts;    // Partial segments of the segment in progress (low-latency media playlist).
+            UString            _preloadHint;     // URI of next partial segment (low-latency media playlist).
             MediaPlayListQueue _playlists;       // List of media playlists (master playlist).
             UStringList        _loadedContent;   // Loaded text content (can be different from current content).
             UString            _autoSaveDir;     // If not empty, automatically save loaded playlist to this directory.
@@ -412,6 +473,12 @@ namespace ts {
             // Perform automatic save of the loaded playlist.
             bool autoSave(Report& report);
 
+            // Build a relative URI from the playlist's path when the playlist is a file.
+            UString relativeURI(const UString& uri) const;
+
+            // Add the description of a partial segment in the text content of a playlist.
+            static void AppendPart(UString& text, const MediaPart& part);
+
             // Set a member with a given playlist type.
             template <typename T>
             bool setMember(PlayListType requiredType, T PlayList::* member, const T& value, Report& report)
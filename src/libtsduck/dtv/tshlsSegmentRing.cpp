@@ -0,0 +1,360 @@
+//----------------------------------------------------------------------------
+//
+// TSDuck - The MPEG Transport Stream Toolkit
+// Copyright (c) 2005-2020, Thierry Lelegard
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+// THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------
+
+#include "tshlsSegmentRing.h"
+#include "tsGuard.h"
+#include "tsSysUtils.h"
+TSDUCK_SOURCE;
+
+#if defined(TS_NEED_STATIC_CONST_DEFINITIONS)
+const size_t ts::hls::SegmentRing::DEFAULT_MAX_SEGMENTS;
+#endif
+
+
+//----------------------------------------------------------------------------
+// Constructors and destructor.
+//----------------------------------------------------------------------------
+
+ts::hls::SegmentRing::SegmentRing(Report& report, size_t maxSegments) :
+    Thread(),
+    _report(report),
+    _maxSegments(std::max<size_t>(1, maxSegments)),
+    _opened(false),
+    _writeError(false),
+    _mutex(),
+    _workToDo(),
+    _workDone(),
+    _operations(),
+    _unflushed(0),
+    _segments()
+{
+}
+
+ts::hls::SegmentRing::Operation::Operation(OpType t, const UString& n, const UString& p) :
+    type(t),
+    name(n),
+    part(p),
+    packets()
+{
+}
+
+ts::hls::SegmentRing::Segment::Segment(const UString& n) :
+    name(n),
+    parts(),
+    complete(false)
+{
+}
+
+ts::hls::SegmentRing::~SegmentRing()
+{
+    close();
+}
+
+
+//----------------------------------------------------------------------------
+// Set the maximum number of media segments in the ring.
+//----------------------------------------------------------------------------
+
+void ts::hls::SegmentRing::setMaxSegments(size_t maxSegments)
+{
+    Guard lock(_mutex);
+    _maxSegments = std::max<size_t>(1, maxSegments);
+}
+
+
+//----------------------------------------------------------------------------
+// Start and stop the writer thread.
+//----------------------------------------------------------------------------
+
+bool ts::hls::SegmentRing::open()
+{
+    if (_opened) {
+        _report.error(u"HLS segment ring already open");
+        return false;
+    }
+
+    // Reset the state of the ring.
+    {
+        Guard lock(_mutex);
+        _operations.clear();
+        _segments.clear();
+        _unflushed = 0;
+    }
+    _writeError = false;
+    _opened = Thread::start();
+    return _opened;
+}
+
+bool ts::hls::SegmentRing::close()
+{
+    if (_opened) {
+        // Ask the writer thread to terminate after all pending operations.
+        {
+            Guard lock(_mutex);
+            enqueue(Operation(OP_TERMINATE));
+        }
+        waitForTermination();
+        _opened = false;
+    }
+    return !_writeError;
+}
+
+
+//----------------------------------------------------------------------------
+// Enqueue an operation, must be called with mutex held.
+//----------------------------------------------------------------------------
+
+void ts::hls::SegmentRing::enqueue(const Operation& op)
+{
+    _operations.push_back(op);
+    _workToDo.signal();
+}
+
+
+//----------------------------------------------------------------------------
+// Add a partial segment in a media segment.
+//----------------------------------------------------------------------------
+
+bool ts::hls::SegmentRing::addPart(const UString& segmentName, const UString& partName, TSPacketVector& packets)
+{
+    if (!_opened) {
+        return false;
+    }
+
+    // Move the packets into a shared buffer, without copy.
+    PacketsPtr pkts(new TSPacketVector);
+    pkts->swap(packets);
+
+    Guard lock(_mutex);
+
+    // Start a new segment in the ring when necessary.
+    if (_segments.empty() || _segments.back().complete || _segments.back().name != segmentName) {
+        _segments.push_back(Segment(segmentName));
+    }
+    _segments.back().parts.push_back(pkts);
+
+    // The packets are shared between the ring and the pending operation.
+    Operation op(OP_PART, segmentName, partName);
+    op.packets = pkts;
+    enqueue(op);
+    return true;
+}
+
+
+//----------------------------------------------------------------------------
+// Declare the current media segment as complete.
+//----------------------------------------------------------------------------
+
+bool ts::hls::SegmentRing::closeSegment()
+{
+    if (!_opened) {
+        return false;
+    }
+
+    Guard lock(_mutex);
+    if (_segments.empty() || _segments.back().complete) {
+        // No segment in progress.
+        return true;
+    }
+
+    // Bound the memory: wait until enough segments are flushed on disk.
+    if (_unflushed >= _maxSegments) {
+        _report.warning(u"HLS segments are written to disk too slowly, %d segments pending", {_unflushed});
+        while (_unflushed >= _maxSegments && !_writeError) {
+            _workDone.wait(_mutex, Infinite);
+        }
+    }
+
+    _segments.back().complete = true;
+    _unflushed++;
+    enqueue(Operation(OP_CLOSE_SEGMENT, _segments.back().name));
+
+    // Drop the oldest segments from memory. If they are not yet flushed, the
+    // pending operations still hold a reference to the packets.
+    while (_segments.size() > _maxSegments) {
+        _segments.pop_front();
+    }
+    return true;
+}
+
+
+//----------------------------------------------------------------------------
+// Asynchronously save a text file or delete a file.
+//----------------------------------------------------------------------------
+
+bool ts::hls::SegmentRing::saveText(const UString& fileName, const UString& text)
+{
+    if (!_opened) {
+        return false;
+    }
+    Guard lock(_mutex);
+    enqueue(Operation(OP_TEXT, fileName, text));
+    return true;
+}
+
+bool ts::hls::SegmentRing::deleteFile(const UString& fileName)
+{
+    if (!_opened) {
+        return false;
+    }
+    Guard lock(_mutex);
+    enqueue(Operation(OP_DELETE, fileName));
+    return true;
+}
+
+
+//----------------------------------------------------------------------------
+// Access the content of the ring.
+//----------------------------------------------------------------------------
+
+bool ts::hls::SegmentRing::getSegment(const UString& segmentName, TSPacketVector& packets) const
+{
+    packets.clear();
+    Guard lock(_mutex);
+    for (auto seg = _segments.begin(); seg != _segments.end(); ++seg) {
+        if (seg->name == segmentName) {
+            for (auto it = seg->parts.begin(); it != seg->parts.end(); ++it) {
+                packets.insert(packets.end(), (*it)->begin(), (*it)->end());
+            }
+            return true;
+        }
+    }
+    return false;
+}
+
+size_t ts::hls::SegmentRing::segmentCount() const
+{
+    Guard lock(_mutex);
+    return _segments.size();
+}
+
+size_t ts::hls::SegmentRing::pendingOperations() const
+{
+    Guard lock(_mutex);
+    return _operations.size();
+}
+
+
+//----------------------------------------------------------------------------
+// Writer thread.
+//----------------------------------------------------------------------------
+
+void ts::hls::SegmentRing::main()
+{
+    _report.debug(u"HLS segment writer thread started");
+
+    TSFile segFile;
+    bool terminate = false;
+
+    while (!terminate) {
+
+        // Wait for the next operation. Keep it in the queue until completion.
+        Operation op;
+        {
+            Guard lock(_mutex);
+            while (_operations.empty()) {
+                _workToDo.wait(_mutex, Infinite);
+            }
+            op = _operations.front();
+        }
+
+        // Execute the operation without holding the mutex.
+        bool ok = true;
+        switch (op.type) {
+            case OP_PART: {
+                // Append the packets to the media segment file.
+                if (segFile.isOpen() && segFile.getFileName() != op.name) {
+                    ok = segFile.close(_report);
+                }
+                if (!segFile.isOpen()) {
+                    ok = segFile.open(op.name, TSFile::WRITE | TSFile::SHARED, _report) && ok;
+                }
+                ok = segFile.isOpen() && segFile.writePackets(op.packets->data(), nullptr, op.packets->size(), _report) && ok;
+                // Write the partial segment file.
+                if (!op.part.empty()) {
+                    TSFile partFile;
+                    ok = partFile.open(op.part, TSFile::WRITE | TSFile::SHARED, _report) &&
+                         partFile.writePackets(op.packets->data(), nullptr, op.packets->size(), _report) &&
+                         partFile.close(_report) &&
+                         ok;
+                }
+                break;
+            }
+            case OP_CLOSE_SEGMENT: {
+                if (segFile.isOpen() && segFile.getFileName() == op.name) {
+                    ok = segFile.close(_report);
+                }
+                break;
+            }
+            case OP_TEXT: {
+                if (!op.part.save(op.name, false, true)) {
+                    _report.error(u"error saving file %s", {op.name});
+                    ok = false;
+                }
+                break;
+            }
+            case OP_DELETE: {
+                _report.verbose(u"deleting obsolete file %s", {op.name});
+                if (DeleteFile(op.name) != SYS_SUCCESS) {
+                    _report.verbose(u"error deleting obsolete file %s", {op.name});
+                }
+                break;
+            }
+            case OP_TERMINATE: {
+                terminate = true;
+                break;
+            }
+            default: {
+                assert(false);
+                break;
+            }
+        }
+
+        // Remove the completed operation and notify waiting callers.
+        {
+            Guard lock(_mutex);
+            _operations.pop_front();
+            if (op.type == OP_CLOSE_SEGMENT) {
+                assert(_unflushed > 0);
+                _unflushed--;
+            }
+            if (!ok) {
+                _writeError = true;
+            }
+            _workDone.signal();
+        }
+    }
+
+    // Normally, the segment file is already closed.
+    if (segFile.isOpen()) {
+        segFile.close(_report);
+    }
+
+    _report.debug(u"HLS segment writer thread terminated");
+}
@@ -0,0 +1,213 @@
+//----------------------------------------------------------------------------
+//
+// TSDuck - The MPEG Transport Stream Toolkit
+// Copyright (c) 2005-2020, Thierry Lelegard
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+// THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------
+//!
+//!  @file
+//!  In-memory ring of HLS media segments with asynchronous write to disk.
+//!
+//----------------------------------------------------------------------------
+
+#pragma once
+#include "tshls.h"
+#include "tsTSPacket.h"
+#include "tsTSFile.h"
+#include "tsThread.h"
+#include "tsMutex.h"
+#include "tsCondition.h"
+#include "tsSafePtr.h"
+#include "tsReport.h"
+
+namespace ts {
+    namespace hls {
+        //!
+        //! In-memory ring of HLS media segments with asynchronous write to disk.
+        //! @ingroup hls
+        //!
+        //! This class is used by the HLS output plugin in low-latency mode. Media segments
+        //! are built in memory, one partial segment at a time. Each partial segment is
+        //! written in its own file and appended to the file of the parent media segment.
+        //! All file operations (segments, partial segments, playlists, deletion of obsolete
+        //! files) are executed in order by an internal writer thread. The caller thread,
+        //! typically the tsp output thread, never waits for a file system operation.
+        //!
+        //! The last completed segments are kept in memory. The number of segments which can
+        //! wait to be flushed on disk is bounded by the size of the ring. If the disk is so
+        //! slow that the ring is full of unflushed segments, the caller waits before closing
+        //! the next segment.
+        //!
+        class TSDUCKDLL SegmentRing : private Thread
+        {
+            TS_NOBUILD_NOCOPY(SegmentRing);
+        public:
+            //!
+            //! Default number of media segments in the ring.
+            //!
+            static const size_t DEFAULT_MAX_SEGMENTS = 4;
+
+            //!
+            //! Constructor.
+            //! @param [in,out] report Where to report errors, from the writer thread.
+            //! @param [in] maxSegments Maximum number of media segments in the ring.
+            //!
+            SegmentRing(Report& report, size_t maxSegments = DEFAULT_MAX_SEGMENTS);
+
+            //!
+            //! Destructor.
+            //! All pending operations are completed first.
+            //!
+            virtual ~SegmentRing() override;
+
+            //!
+            //! Set the maximum number of media segments in the ring.
+            //! @param [in] maxSegments Maximum number of media segments in the ring (minimum 1).
+            //!
+            void setMaxSegments(size_t maxSegments);
+
+            //!
+            //! Get the maximum number of media segments in the ring.
+            //! @return The maximum number of media segments in the ring.
+            //!
+            size_t maxSegments() const { return _maxSegments; }
+
+            //!
+            //! Start the writer thread.
+            //! @return True on success, false on error.
+            //!
+            bool open();
+
+            //!
+            //! Complete all pending file operations and stop the writer thread.
+            //! @return True on success, false if some file operation failed since open().
+            //!
+            bool close();
+
+            //!
+            //! Check if the writer thread is started.
+            //! @return True if the writer thread is started.
+            //!
+            bool isOpen() const { return _opened; }
+
+            //!
+            //! Add a partial segment in a media segment.
+            //! @param [in] segmentName File name of the media segment. If this is not the name of
+            //! the current segment in the ring, a new segment is started.
+            //! @param [in] partName File name of the partial segment. If empty, the packets are only
+            //! appended to the media segment.
+            //! @param [in,out] packets TS packets of the partial segment. The content of the vector
+            //! is moved into the ring and @a packets is empty on return.
+            //! @return True on success, false on error (ring not open).
+            //!
+            bool addPart(const UString& segmentName, const UString& partName, TSPacketVector& packets);
+
+            //!
+            //! Declare the current media segment as complete.
+            //! If there are already too many segments waiting to be flushed on disk,
+            //! wait until the oldest one is written.
+            //! @return True on success, false on error (ring not open).
+            //!
+            bool closeSegment();
+
+            //!
+            //! Asynchronously save a text file, typically a playlist.
+            //! @param [in] fileName Name of the text file.
+            //! @param [in] text Content of the text file.
+            //! @return True on success, false on error (ring not open).
+            //!
+            bool saveText(const UString& fileName, const UString& text);
+
+            //!
+            //! Asynchronously delete a file, typically an obsolete segment.
+            //! @param [in] fileName Name of the file to delete.
+            //! @return True on success, false on error (ring not open).
+            //!
+            bool deleteFile(const UString& fileName);
+
+            //!
+            //! Get a copy of the content of a media segment from the memory ring.
+            //! @param [in] segmentName File name of the media segment.
+            //! @param [out] packets TS packets of the segment (possibly incomplete if this is the current segment).
+            //! @return True if the segment is still in the memory ring, false otherwise.
+            //!
+            bool getSegment(const UString& segmentName, TSPacketVector& packets) const;
+
+            //!
+            //! Get the number of media segments currently in the memory ring.
+            //! @return The number of media segments currently in the memory ring.
+            //!
+            size_t segmentCount() const;
+
+            //!
+            //! Get the number of file operations which are not yet completed.
+            //! @return The number of pending file operations.
+            //!
+            size_t pendingOperations() const;
+
+        private:
+            // Shared packet buffers between the caller and the writer thread.
+            typedef SafePtr<TSPacketVector, Mutex> PacketsPtr;
+            typedef std::list<PacketsPtr> PacketsPtrList;
+
+            // Asynchronous file operations, executed in order by the writer thread.
+            enum OpType {OP_PART, OP_CLOSE_SEGMENT, OP_TEXT, OP_DELETE, OP_TERMINATE};
+            struct Operation
+            {
+                Operation(OpType t = OP_TERMINATE, const UString& n = UString(), const UString& p = UString());
+                OpType     type;     // Operation type.
+                UString    name;     // File name, segment name for OP_PART.
+                UString    part;     // Partial segment file name for OP_PART, file content for OP_TEXT.
+                PacketsPtr packets;  // Packets to write for OP_PART.
+            };
+
+            // Description of a media segment in the memory ring.
+            struct Segment
+            {
+                Segment(const UString& n = UString());
+                UString        name;      // Segment file name.
+                PacketsPtrList parts;     // Content of the segment, one buffer per partial segment.
+                bool           complete;  // Segment is complete.
+            };
+
+            Report&              _report;         // Where to report errors.
+            size_t               _maxSegments;    // Maximum number of segments in the ring.
+            bool                 _opened;         // The writer thread is started.
+            volatile bool        _writeError;     // A file operation failed.
+            mutable Mutex        _mutex;          // Protect all fields below.
+            Condition            _workToDo;       // Signaled when an operation is queued.
+            Condition            _workDone;       // Signaled when an operation is completed.
+            std::list<Operation> _operations;     // Pending operations.
+            size_t               _unflushed;      // Number of completed segments which are not yet closed on disk.
+            std::list<Segment>   _segments;       // Memory ring of segments, the last one is possibly in progress.
+
+            // Enqueue an operation, must be called with mutex held.
+            void enqueue(const Operation& op);
+
+            // Implementation of Thread.
+            virtual void main() override;
+        };
+    }
+}
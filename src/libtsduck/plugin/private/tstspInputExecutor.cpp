@@ -28,6 +28,7 @@
 //----------------------------------------------------------------------------
 
 #include "tstspInputExecutor.h"
+#include "tsSharedSignalization.h"
 #include "tsTime.h"
 TSDUCK_SOURCE;
 
@@ -92,6 +93,11 @@ bool ts::tsp::InputExecutor::initAllBuffers(PacketBuffer* buffer, PacketMetadata
 
     debug(u"initial buffer load: %'d packets, %'d bytes", {pkt_read, pkt_read * PKT_SIZE});
 
+    // Feed the optional shared signalization before the packets are visible to the plugins.
+    if (_tsp_signalization != nullptr) {
+        _tsp_signalization->feedPackets(_buffer->base(), pkt_read);
+    }
+
     // Try to evaluate the initial input bitrate.
     const BitRate init_bitrate = getBitrate();
     if (init_bitrate == 0) {
@@ -468,6 +474,11 @@ void ts::tsp::InputExecutor::main()
             }
         }
 
+        // Feed the optional shared signalization before the packets are visible to the plugins.
+        if (_tsp_signalization != nullptr && pkt_read > 0) {
+            _tsp_signalization->feedPackets(_buffer->base() + pkt_first, pkt_read);
+        }
+
         // Pass received packets to next processor
         passPackets(pkt_read, _tsp_bitrate, input_end, false);
 
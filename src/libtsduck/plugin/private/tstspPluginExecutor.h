@@ -101,6 +101,12 @@ namespace ts {
             //!
             void setRealTimeForAll(bool on) { _use_realtime = on; }
 
+            //!
+            //! Set the signalization demux which is shared by all plugins.
+            //! @param [in] signalization Address of the shared signalization demux or null if there is none.
+            //!
+            void setSharedSignalization(SharedSignalization* signalization) { _tsp_signalization = signalization; }
+
             //!
             //! This method sets the current packet processor in an abort state.
             //!
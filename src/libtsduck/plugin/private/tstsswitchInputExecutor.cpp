@@ -33,6 +33,10 @@
 #include "tsGuardCondition.h"
 TSDUCK_SOURCE;
 
+#if defined(TS_NEED_STATIC_CONST_DEFINITIONS)
+constexpr uint64_t ts::tsswitch::InputExecutor::OUT_IN_USE;
+#endif
+
 
 //----------------------------------------------------------------------------
 // Constructor and destructor.
@@ -50,15 +54,16 @@ ts::tsswitch::InputExecutor::InputExecutor(const InputSwitcherArgs& opt,
     _pluginIndex(index),
     _buffer(opt.bufferedPackets),
     _metadata(opt.bufferedPackets),
-    _mutex(),
-    _todo(),
+    _readPosition(0),
+    _writePosition(0),
+    _switchPoint(0),
     _isCurrent(false),
-    _outputInUse(false),
-    _startRequest(false),
+    _inputWaiting(false),
     _stopRequest(false),
     _terminated(false),
-    _outFirst(0),
-    _outCount(0),
+    _mutex(),
+    _todo(),
+    _startRequest(false),
     _start_time(true) // initialized with current system time
 {
     // Make sure that the input plugins display their index.
@@ -123,8 +128,23 @@ bool ts::tsswitch::InputExecutor::abortInput()
 
 void ts::tsswitch::InputExecutor::setCurrent(bool isCurrent)
 {
-    Guard lock(_mutex);
+    // With --fast-switch --aligned-switch, skip late packets before the last buffered PCR.
+    // This is called under the protection of the core mutex, like getOutputArea().
+    // So, the output plugin cannot get a new area from this input in the meantime.
+    if (isCurrent && !_isCurrent && _opt.fastSwitch && _opt.alignedSwitch) {
+        const uint64_t point = _switchPoint;
+        const uint64_t read = _readPosition;
+        if (point > (read & ~OUT_IN_USE) && point < _writePosition && dropUntil(point)) {
+            debug(u"aligned switch, dropped %'d buffered packets", {point - read});
+        }
+    }
     _isCurrent = isCurrent;
+
+    // When no longer current, the input thread may wait for the output to free a full buffer.
+    // Wake it up so that it can start dropping packets in --fast-switch mode.
+    if (!isCurrent) {
+        wakeUpInput();
+    }
 }
 
 
@@ -140,6 +160,43 @@ void ts::tsswitch::InputExecutor::terminateInput()
 }
 
 
+//----------------------------------------------------------------------------
+// Drop packets in the buffer up to a given position.
+//----------------------------------------------------------------------------
+
+bool ts::tsswitch::InputExecutor::dropUntil(uint64_t position)
+{
+    uint64_t read = _readPosition;
+    do {
+        if ((read & OUT_IN_USE) != 0) {
+            // The output plugin currently uses the buffer, cannot drop anything.
+            return false;
+        }
+        if (read >= position) {
+            // Already consumed or dropped by someone else.
+            return true;
+        }
+    } while (!_readPosition.compare_exchange_weak(read, position));
+    wakeUpInput();
+    return true;
+}
+
+
+//----------------------------------------------------------------------------
+// Wake up the input thread if it waits for the output plugin.
+//----------------------------------------------------------------------------
+
+void ts::tsswitch::InputExecutor::wakeUpInput()
+{
+    // The input thread sets _inputWaiting before checking the buffer state
+    // under the mutex, a signal cannot be lost.
+    if (_inputWaiting) {
+        GuardCondition lock(_mutex, _todo);
+        lock.signal();
+    }
+}
+
+
 //----------------------------------------------------------------------------
 // Get some packets to output.
 // Indirectly called from the output plugin when it needs some packets.
@@ -147,12 +204,23 @@ void ts::tsswitch::InputExecutor::terminateInput()
 
 void ts::tsswitch::InputExecutor::getOutputArea(ts::TSPacket*& first, TSPacketMetadata*& data, size_t& count)
 {
-    GuardCondition lock(_mutex, _todo);
-    first = &_buffer[_outFirst];
-    data = &_metadata[_outFirst];
-    count = std::min(_outCount, _buffer.size() - _outFirst);
-    _outputInUse = count > 0;
-    lock.signal();
+    // Reserve the output area: set the "in use" flag in the read position.
+    // This can fail only when another thread concurrently drops packets.
+    uint64_t read = _readPosition & ~OUT_IN_USE;
+    while (!_readPosition.compare_exchange_weak(read, read | OUT_IN_USE)) {
+        read &= ~OUT_IN_USE;
+    }
+
+    const size_t index = size_t(read % _buffer.size());
+    first = &_buffer[index];
+    data = &_metadata[index];
+    count = std::min(outCount(read), _buffer.size() - index);
+
+    // Release the reservation if there is nothing to output.
+    if (count == 0) {
+        _readPosition = read;
+        wakeUpInput();
+    }
 }
 
 
@@ -163,12 +231,12 @@ void ts::tsswitch::InputExecutor::getOutputArea(ts::TSPacket*& first, TSPacketMe
 
 void ts::tsswitch::InputExecutor::freeOutput(size_t count)
 {
-    GuardCondition lock(_mutex, _todo);
-    assert(count <= _outCount);
-    _outFirst = (_outFirst + count) % _buffer.size();
-    _outCount -= count;
-    _outputInUse = false;
-    lock.signal();
+    // While the "in use" flag is set, no other thread modifies the read position.
+    const uint64_t read = _readPosition;
+    assert((read & OUT_IN_USE) != 0);
+    assert(count <= outCount(read));
+    _readPosition = (read & ~OUT_IN_USE) + count;
+    wakeUpInput();
 }
 
 
@@ -187,9 +255,7 @@ void ts::tsswitch::InputExecutor::main()
         debug(u"waiting for input session");
         {
             GuardCondition lock(_mutex, _todo);
-            // Reset input buffer.
-            _outFirst = 0;
-            _outCount = 0;
+            // The input buffer is empty here, either initially or after the end of the previous session.
             // Wait for start or terminate.
             while (!_startRequest && !_terminated) {
                 lock.waitCondition();
@@ -219,40 +285,41 @@ void ts::tsswitch::InputExecutor::main()
         // Loop on incoming packets.
         for (;;) {
 
-            // Input area (first packet index and packet count).
-            size_t inFirst = 0;
-            size_t inCount = 0;
-
-            // Initial sequence under mutex protection.
-            {
-                // Wait for free buffer or stop.
-                GuardCondition lock(_mutex, _todo);
-                while (_outCount >= _buffer.size() && !_stopRequest && !_terminated) {
-                    if (_isCurrent || !_opt.fastSwitch) {
-                        // This is the current input, we must not lose packet.
-                        // Wait for the output thread to free some packets.
+            // Wait for free buffer or stop. In the nominal case, there is some free space
+            // in the buffer and no lock is required.
+            uint64_t read = _readPosition;
+            while (outCount(read) >= _buffer.size() && !_stopRequest && !_terminated) {
+                if (!_isCurrent && _opt.fastSwitch && (read & OUT_IN_USE) == 0) {
+                    // Not the current input plugin in --fast-switch mode.
+                    // Drop older packets, free at most --max-input-packets.
+                    const size_t index = size_t(read % _buffer.size());
+                    const size_t freeCount = std::min(_opt.maxInputPackets, _buffer.size() - index);
+                    _readPosition.compare_exchange_strong(read, read + freeCount);
+                }
+                else {
+                    // This is the current input, we must not lose packet.
+                    // Wait for the output thread to free some packets.
+                    GuardCondition lock(_mutex, _todo);
+                    _inputWaiting = true;
+                    if (outCount(_readPosition) >= _buffer.size() && !_stopRequest && !_terminated) {
                         lock.waitCondition();
                     }
-                    else {
-                        // Not the current input plugin in --fast-switch mode.
-                        // Drop older packets, free at most --max-input-packets.
-                        assert(_outFirst < _buffer.size());
-                        const size_t freeCount = std::min(_opt.maxInputPackets, _buffer.size() - _outFirst);
-                        assert(freeCount <= _outCount);
-                        _outFirst = (_outFirst + freeCount) % _buffer.size();
-                        _outCount -= freeCount;
-                    }
-                }
-                // Exit input when termination is requested.
-                if (_stopRequest || _terminated) {
-                    break;
+                    _inputWaiting = false;
                 }
-                // There is some free buffer, compute first index and size of receive area.
-                // The receive area is limited by end of buffer and max input size.
-                inFirst = (_outFirst + _outCount) % _buffer.size();
-                inCount = std::min(_opt.maxInputPackets, std::min(_buffer.size() - _outCount, _buffer.size() - inFirst));
+                read = _readPosition;
+            }
+
+            // Exit input when termination is requested.
+            if (_stopRequest || _terminated) {
+                break;
             }
 
+            // There is some free buffer, compute first index and size of receive area.
+            // The receive area is limited by end of buffer and max input size.
+            const uint64_t write = _writePosition;
+            const size_t inFirst = size_t(write % _buffer.size());
+            size_t inCount = std::min(_opt.maxInputPackets, std::min(_buffer.size() - outCount(read), _buffer.size() - inFirst));
+
             assert(inFirst < _buffer.size());
             assert(inFirst + inCount <= _buffer.size());
 
@@ -278,26 +345,41 @@ void ts::tsswitch::InputExecutor::main()
                 }
             }
 
-            // Signal the presence of received packets.
-            {
-                Guard lock(_mutex);
-                _outCount += inCount;
+            // Record the last packet with a PCR as a possible switch point.
+            if (_opt.alignedSwitch) {
+                for (size_t n = inCount; n > 0; --n) {
+                    if (_buffer[inFirst + n - 1].hasPCR()) {
+                        _switchPoint = write + n - 1;
+                        break;
+                    }
+                }
             }
+
+            // Publish the received packets. Packet contents are visible to the output thread
+            // before the write position is updated (sequentially consistent atomic).
+            _writePosition = write + inCount;
             _core.inputReceived(_pluginIndex);
         }
 
         // At end of session, make sure that the output buffer is not in use by the output plugin.
-        {
-            // Wait for the output plugin to release the buffer.
-            // In case of normal end of input (no stop, no terminate), wait for all output to be gone.
+        // Wait for the output plugin to release the buffer.
+        // In case of normal end of input (no stop, no terminate), wait for all output to be gone.
+        for (;;) {
+            const uint64_t read = _readPosition;
+            if ((read & OUT_IN_USE) == 0 && (outCount(read) == 0 || _stopRequest || _terminated)) {
+                // Reset the output part of the buffer, unless the output plugin reserved it in the meantime.
+                if (dropUntil(_writePosition)) {
+                    break;
+                }
+                continue;
+            }
             GuardCondition lock(_mutex, _todo);
-            while (_outputInUse || (_outCount > 0 && !_stopRequest && !_terminated)) {
+            _inputWaiting = true;
+            if (_readPosition == read && ((read & OUT_IN_USE) != 0 || (!_stopRequest && !_terminated))) {
                 debug(u"input terminated, waiting for output plugin to release the buffer");
                 lock.waitCondition();
             }
-            // And reset the output part of the buffer.
-            _outFirst = 0;
-            _outCount = 0;
+            _inputWaiting = false;
         }
 
         // End of input session.
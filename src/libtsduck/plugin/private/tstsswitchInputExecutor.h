@@ -119,21 +119,42 @@ namespace ts {
             virtual size_t pluginIndex() const override;
 
         private:
+            // The packet buffer is a single-producer / single-consumer ring. The input thread is the
+            // producer and the output thread is the consumer. Positions in the ring are absolute packet
+            // counters which are never reset, the index in _buffer is the position modulo the buffer size.
+            // The read position also contains the flag OUT_IN_USE when the output plugin currently uses
+            // an area of the buffer. While this flag is set, only the output thread can move the read
+            // position. Other threads (dropping packets in --fast-switch mode) use compare-and-swap on
+            // a read position without flag. This way, there is no lock between input and output threads
+            // in the nominal case, the mutex is used only to sleep on empty/full buffer conditions.
+            static constexpr uint64_t OUT_IN_USE = TS_UCONST64(0x8000000000000000);
+
             InputPlugin*             _input;         // Plugin API.
             const size_t             _pluginIndex;   // Index of this input plugin.
             TSPacketVector           _buffer;        // Packet buffer.
             TSPacketMetadataVector   _metadata;      // Packet metadata.
-            Mutex                    _mutex;         // Mutex to protect all subsequent fields.
+            std::atomic<uint64_t>    _readPosition;  // Position of first packet to output, with OUT_IN_USE flag.
+            std::atomic<uint64_t>    _writePosition; // Position of next packet to receive.
+            std::atomic<uint64_t>    _switchPoint;   // Position of last received packet with a PCR.
+            std::atomic<bool>        _isCurrent;     // This plugin is the current input one.
+            std::atomic<bool>        _inputWaiting;  // The input thread is waiting on _todo for the output.
+            std::atomic<bool>        _stopRequest;   // Stop input requested.
+            std::atomic<bool>        _terminated;    // Terminate thread.
+            Mutex                    _mutex;         // Mutex to protect _startRequest and waiting on _todo.
             Condition                _todo;          // Condition to signal something to do.
-            bool                     _isCurrent;     // This plugin is the current input one.
-            bool                     _outputInUse;   // The output part of the buffer is currently in use by the output plugin.
             bool                     _startRequest;  // Start input requested.
-            bool                     _stopRequest;   // Stop input requested.
-            bool                     _terminated;    // Terminate thread.
-            size_t                   _outFirst;      // Index of first packet to output in _buffer.
-            size_t                   _outCount;      // Number of packets to output, not always contiguous, may wrap up.
             Monotonic                _start_time;    // Creation time in a monotonic clock.
 
+            // Number of packets in the buffer, from a read position.
+            size_t outCount(uint64_t readPosition) const { return size_t(_writePosition - (readPosition & ~OUT_IN_USE)); }
+
+            // Drop packets in the buffer up to a given position, when the output does not use it.
+            // Return false if the output plugin currently uses the buffer.
+            bool dropUntil(uint64_t position);
+
+            // Wake up the input thread if it waits for the output plugin.
+            void wakeUpInput();
+
             // Implementation of Thread.
             virtual void main() override;
         };
@@ -43,7 +43,8 @@ ts::tsswitch::OutputExecutor::OutputExecutor(const InputSwitcherArgs& opt,
 
     PluginExecutor(opt, handlers, PluginType::OUTPUT, opt.output, ThreadAttributes(), core, log),
     _output(dynamic_cast<OutputPlugin*>(plugin())),
-    _terminate(false)
+    _terminate(false),
+    _dedup(opt.dedupWindow, opt.inputs.size())
 {
 }
 
@@ -78,16 +79,13 @@ void ts::tsswitch::OutputExecutor::main()
         if (!_terminate && count > 0) {
 
             // Output the packets.
-            const bool success = _output->send(first, metadata, count);
+            const bool success = send(pluginIndex, first, metadata, count);
 
             // Signal to the input plugin that the buffer can be reused..
             _core.outputSent(pluginIndex, count);
 
             // Abort the whole process in case of output error.
-            if (success) {
-                addPluginPackets(count);
-            }
-            else {
+            if (!success) {
                 debug(u"stopping output plugin");
                 _core.stop(false);
                 _terminate = true;
@@ -97,5 +95,47 @@ void ts::tsswitch::OutputExecutor::main()
 
     // Stop the plugin.
     _output->stop();
+
+    // Report duplicate packets removal.
+    if (_opt.dedupWindow > 0) {
+        for (size_t i = 0; i < _dedup.inputCount(); ++i) {
+            const TSPacketDeduplicator::InputStatistics& stats(_dedup.statistics(i));
+            info(u"input %d: %'d packets, %'d duplicates removed", {i, stats.packets, stats.duplicates});
+        }
+    }
     debug(u"output thread terminated");
 }
+
+
+//----------------------------------------------------------------------------
+// Output packets from one input plugin, removing duplicate packets if required.
+//----------------------------------------------------------------------------
+
+bool ts::tsswitch::OutputExecutor::send(size_t pluginIndex, const TSPacket* first, const TSPacketMetadata* metadata, size_t count)
+{
+    // Without deduplication, send all packets at once.
+    if (_opt.dedupWindow == 0) {
+        const bool success = _output->send(first, metadata, count);
+        if (success) {
+            addPluginPackets(count);
+        }
+        return success;
+    }
+
+    // Send contiguous sequences of new packets, skipping duplicates.
+    // The input buffer is shared with the input plugin, it is not modified.
+    bool success = true;
+    size_t start = 0;
+    for (size_t i = 0; success && i <= count; ++i) {
+        if (i == count || !_dedup.feedPacket(first[i], pluginIndex)) {
+            if (i > start) {
+                success = _output->send(first + start, metadata + start, i - start);
+                if (success) {
+                    addPluginPackets(i - start);
+                }
+            }
+            start = i + 1;
+        }
+    }
+    return success;
+}
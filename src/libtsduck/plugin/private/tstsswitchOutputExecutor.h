@@ -36,6 +36,7 @@
 #include "tstsswitchPluginExecutor.h"
 #include "tsInputSwitcherArgs.h"
 #include "tsOutputPlugin.h"
+#include "tsTSPacketDeduplicator.h"
 
 namespace ts {
     namespace tsswitch {
@@ -69,11 +70,15 @@ namespace ts {
             virtual size_t pluginIndex() const override;
 
         private:
-            OutputPlugin* _output;     // Plugin API.
-            volatile bool _terminate;  // Termination request.
+            OutputPlugin*        _output;     // Plugin API.
+            volatile bool        _terminate;  // Termination request.
+            TSPacketDeduplicator _dedup;      // Duplicate packets removal, one input per input plugin.
 
             // Implementation of Thread.
             virtual void main() override;
+
+            // Output packets from one input plugin, removing duplicate packets if required.
+            bool send(size_t pluginIndex, const TSPacket* first, const TSPacketMetadata* metadata, size_t count);
         };
     }
 }
@@ -29,12 +29,20 @@
 
 #include "tsAbstractDescrambler.h"
 #include "tsGuardCondition.h"
+#include "tsGuard.h"
 #include "tsNames.h"
 TSDUCK_SOURCE;
 
 // Stack usage required by this module in the ECM deciphering thread.
 #define ECM_THREAD_STACK_OVERHEAD (16  * 1024)
 
+// Default number of ECM's in the cache.
+#define DEFAULT_ECM_CACHE_SIZE 16
+
+#if defined(TS_NEED_STATIC_CONST_DEFINITIONS)
+constexpr uint32_t ts::AbstractDescrambler::EVENT_ECM_STATISTICS;
+#endif
+
 
 //----------------------------------------------------------------------------
 // Constructor
@@ -47,6 +55,8 @@ ts::AbstractDescrambler::AbstractDescrambler(TSP* tsp_, const UString& descripti
     _abort(false),
     _synchronous(false),
     _swap_cw(false),
+    _ecm_thread_count(1),
+    _ecm_cache_size(DEFAULT_ECM_CACHE_SIZE),
     _scrambling(*tsp),
     _pids(),
     _service(duck, this),
@@ -56,8 +66,10 @@ ts::AbstractDescrambler::AbstractDescrambler(TSP* tsp_, const UString& descripti
     _scrambled_streams(),
     _mutex(),
     _ecm_to_do(),
-    _ecm_thread(this),
-    _stop_thread(false)
+    _ecm_threads(),
+    _stop_thread(false),
+    _ecm_seq(0),
+    _ecm_cache()
 {
     // We need to define character sets to specify service names.
     duck.defineArgsForCharset(*this);
@@ -76,6 +88,21 @@ ts::AbstractDescrambler::AbstractDescrambler(TSP* tsp_, const UString& descripti
          u"If the argument is omitted, --pid options shall be specified to list explicit "
          u"PID's to descramble and fixed control words shall be specified as well.");
 
+    option(u"ecm-cache", 0, UNSIGNED);
+    help(u"ecm-cache", u"count",
+         u"Number of recently deciphered ECM's which are kept with their control words. "
+         u"When the same ECM is received again, on the same or another ECM PID, its control "
+         u"words are reused without deciphering it again. "
+         u"The default is " + UString::Decimal(DEFAULT_ECM_CACHE_SIZE) + u". Use zero to disable the cache.");
+
+    option(u"ecm-threads", 0, INTEGER, 0, 1, 1, 64);
+    help(u"ecm-threads", u"count",
+         u"Number of threads which decipher ECM's in asynchronous mode. The default is 1. "
+         u"ECM's from different ECM streams are deciphered in parallel when more than one thread "
+         u"is used. Use this only when the CAS-specific processing supports it (several smartcards, "
+         u"software CAS, etc.) In all cases, the most urgent ECM's are deciphered first, "
+         u"ie. the ones from ECM streams which do not have the control word for the next parity yet.");
+
     option(u"pid", 'p', PIDVAL, 0, UNLIMITED_COUNT);
     help(u"pid", u"pid1[-pid2]",
          u"Descramble packets with this PID value or range of PID values. "
@@ -106,6 +133,8 @@ bool ts::AbstractDescrambler::getOptions()
     _service.set(value(u""));
     _synchronous = present(u"synchronous") || !tsp->realtime();
     _swap_cw = present(u"swap-cw");
+    _ecm_thread_count = intValue<size_t>(u"ecm-threads", 1);
+    _ecm_cache_size = intValue<size_t>(u"ecm-cache", DEFAULT_ECM_CACHE_SIZE);
     getIntValues(_pids, u"pid");
     if (!duck.loadArgs(*this) || !_scrambling.loadArgs(duck, *this)) {
         return false;
@@ -146,20 +175,71 @@ ts::AbstractDescrambler::CWData::CWData(uint8_t mode) :
 // Constructor of ECMStream inner class.
 //----------------------------------------------------------------------------
 
-ts::AbstractDescrambler::ECMStream::ECMStream(AbstractDescrambler* parent) :
-    last_tid(TID_NULL),
+ts::AbstractDescrambler::ECMStream::ECMStream(AbstractDescrambler* parent, PID pid) :
+    ecm_pid(pid),
+    last_ecm(),
     scrambling(parent->_scrambling),
+    parity(0),
     cw_valid(false),
     new_cw_even(false),
     new_cw_odd(false),
+    next_cw_ready(false),
     new_ecm(false),
+    busy(false),
+    ecm_seq(0),
+    cw_seq(0),
+    ecm_time(),
     ecm(),
     cw_even(),
-    cw_odd()
+    cw_odd(),
+    ecm_count(0),
+    ecm_ok(0),
+    ecm_errors(0),
+    cache_hits(0),
+    total_latency(0),
+    max_latency(0)
+{
+}
+
+
+//----------------------------------------------------------------------------
+// Constructor of ECMStreamStatistics class.
+//----------------------------------------------------------------------------
+
+ts::AbstractDescrambler::ECMStreamStatistics::ECMStreamStatistics() :
+    ecm_count(0),
+    ecm_ok(0),
+    ecm_errors(0),
+    cache_hits(0),
+    average_latency(0),
+    max_latency(0)
 {
 }
 
 
+//----------------------------------------------------------------------------
+// Get the current statistics on the ECM processing.
+//----------------------------------------------------------------------------
+
+void ts::AbstractDescrambler::getECMStatistics(ECMStatistics& stats)
+{
+    stats.streams.clear();
+
+    // The ECM threads update the statistics under mutex protection.
+    Guard lock(_mutex);
+    for (ECMStreamMap::const_iterator it = _ecm_streams.begin(); it != _ecm_streams.end(); ++it) {
+        const ECMStream& es(*it->second);
+        ECMStreamStatistics& st(stats.streams[es.ecm_pid]);
+        st.ecm_count = es.ecm_count;
+        st.ecm_ok = es.ecm_ok;
+        st.ecm_errors = es.ecm_errors;
+        st.cache_hits = es.cache_hits;
+        st.average_latency = es.ecm_ok == 0 ? 0 : es.total_latency / NanoSecond(es.ecm_ok);
+        st.max_latency = es.max_latency;
+    }
+}
+
+
 //----------------------------------------------------------------------------
 // Get the ECM stream for a PID, create it if non existent
 //----------------------------------------------------------------------------
@@ -171,8 +251,15 @@ ts::AbstractDescrambler::ECMStreamPtr ts::AbstractDescrambler::getOrCreateECMStr
         return ecm_it->second;
     }
     else {
-        ECMStreamPtr p(new ECMStream(this));
+        // The map of ECM streams is scanned by the ECM threads, modify it under mutex protection.
+        ECMStreamPtr p(new ECMStream(this, ecm_pid));
+        if (!_synchronous) {
+            _mutex.acquire();
+        }
         _ecm_streams.insert(std::make_pair(ecm_pid, p));
+        if (!_synchronous) {
+            _mutex.release();
+        }
         return p;
     }
 }
@@ -188,6 +275,8 @@ bool ts::AbstractDescrambler::start()
     _abort = false;
     _ecm_streams.clear();
     _scrambled_streams.clear();
+    _ecm_cache.clear();
+    _ecm_seq = 0;
     _demux.reset();
 
     // Initialize the scrambling engine.
@@ -195,14 +284,19 @@ bool ts::AbstractDescrambler::start()
         return false;
     }
 
-    // In asynchronous mode, create a thread for ECM processing
+    // In asynchronous mode, create the threads for ECM processing
     if (_need_ecm && !_synchronous) {
         _stop_thread = false;
-        ThreadAttributes attr;
-        _ecm_thread.getAttributes(attr);
-        attr.setStackSize(ECM_THREAD_STACK_OVERHEAD + _stack_usage);
-        _ecm_thread.setAttributes(attr);
-        _ecm_thread.start();
+        _ecm_threads.clear();
+        for (size_t i = 0; i < _ecm_thread_count; ++i) {
+            ECMThreadPtr thread(new ECMThread(this));
+            ThreadAttributes attr;
+            thread->getAttributes(attr);
+            attr.setStackSize(ECM_THREAD_STACK_OVERHEAD + _stack_usage);
+            thread->setAttributes(attr);
+            thread->start();
+            _ecm_threads.push_back(thread);
+        }
     }
 
     return true;
@@ -215,15 +309,33 @@ bool ts::AbstractDescrambler::start()
 
 bool ts::AbstractDescrambler::stop()
 {
-    // In asynchronous mode, notify the ECM processing thread to terminate
-    // and wait for its actual termination.
+    // In asynchronous mode, notify the ECM processing threads to terminate
+    // and wait for their actual termination.
     if (_need_ecm && !_synchronous) {
         {
             GuardCondition lock(_mutex, _ecm_to_do);
             _stop_thread = true;
             lock.signal();
         }
-        _ecm_thread.waitForTermination();
+        for (size_t i = 0; i < _ecm_threads.size(); ++i) {
+            _ecm_threads[i]->waitForTermination();
+        }
+        _ecm_threads.clear();
+    }
+
+    // Report ECM processing statistics per ECM stream.
+    if (_need_ecm) {
+        ECMStatistics stats;
+        getECMStatistics(stats);
+        for (std::map<PID, ECMStreamStatistics>::const_iterator it = stats.streams.begin(); it != stats.streams.end(); ++it) {
+            const ECMStreamStatistics& st(it->second);
+            if (st.ecm_count > 0) {
+                tsp->verbose(u"ECM PID %d (0x%X): %'d ECM's, %'d deciphered, %'d errors, %'d from cache, latency: average %'d ms, max %'d ms",
+                             {it->first, it->first, st.ecm_count, st.ecm_ok, st.ecm_errors, st.cache_hits,
+                              st.average_latency / NanoSecPerMilliSec, st.max_latency / NanoSecPerMilliSec});
+            }
+        }
+        tsp->signalPluginEvent(EVENT_ECM_STATISTICS, &stats);
     }
 
     _scrambling.stop();
@@ -347,13 +459,14 @@ void ts::AbstractDescrambler::handleSection(SectionDemux& demux, const Section&
     }
     ECMStreamPtr& estream(ecm_it->second);
 
-    // If same TID as previous CMT on this PID, give up, this is the same ECM.
-    if (sect.tableId() == estream->last_tid) {
+    // If same content as previous ECM on this PID, give up, this is the same ECM.
+    // The table id is not sufficient: some CAS do not alternate 0x80 and 0x81.
+    if (sect.size() == estream->last_ecm.size() && ::memcmp(sect.content(), estream->last_ecm.data(), sect.size()) == 0) {
         return;
     }
 
     // This is a new ECM on this PID.
-    estream->last_tid = sect.tableId();
+    estream->last_ecm.copy(sect.content(), sect.size());
 
     // Check if the ECM can be deciphered (ask subclass)
     if (!checkECM(sect)) {
@@ -367,9 +480,33 @@ void ts::AbstractDescrambler::handleSection(SectionDemux& demux, const Section&
         _mutex.acquire();
     }
 
+    const uint64_t seq = ++_ecm_seq;
+    estream->ecm_count++;
+
+    // Look for the same ECM in the cache of recently deciphered ECM's.
+    ECMCache::iterator cached(_ecm_cache.end());
+    if (_ecm_cache_size > 0) {
+        cached = _ecm_cache.find(ByteBlock(sect.content(), sect.size()));
+    }
+
+    if (cached != _ecm_cache.end()) {
+        // Already deciphered, reuse the control words. A previous ECM of this stream is now obsolete.
+        tsp->debug(u"ECM found in cache");
+        cached->second.last_use = seq;
+        estream->cache_hits++;
+        estream->new_ecm = false;
+        storeCW(*estream, seq, cached->second.cw_even, cached->second.cw_odd);
+        if (!_synchronous) {
+            _mutex.release();
+        }
+        return;
+    }
+
     // Copy the ECM into the PID context.
     estream->ecm.copy(sect);
     estream->new_ecm = true;
+    estream->ecm_seq = seq;
+    estream->ecm_time.getSystemTime();
 
     // Decipher the ECM.
     if (_synchronous) {
@@ -377,13 +514,38 @@ void ts::AbstractDescrambler::handleSection(SectionDemux& demux, const Section&
         processECM(*estream);
     }
     else {
-        // Asynchronous mode: signal the ECM to the ECM processing thread.
+        // Asynchronous mode: signal the ECM to the ECM processing threads.
         _ecm_to_do.signal();
         _mutex.release();
     }
 }
 
 
+//----------------------------------------------------------------------------
+// Select the ECM stream with the most urgent ECM to decipher.
+//----------------------------------------------------------------------------
+
+ts::AbstractDescrambler::ECMStream* ts::AbstractDescrambler::nextECMStream()
+{
+    // The number of ECM streams is always small, a linear scan is sufficient.
+    ECMStream* best = nullptr;
+    bool best_urgent = false;
+
+    for (ECMStreamMap::iterator it = _ecm_streams.begin(); it != _ecm_streams.end(); ++it) {
+        ECMStream* es = it->second.pointer();
+        if (es->new_ecm && !es->busy) {
+            // Urgent when the scrambled packets may soon need a control word which is not yet available.
+            const bool urgent = !es->cw_valid || !es->next_cw_ready;
+            if (best == nullptr || (urgent && !best_urgent) || (urgent == best_urgent && es->ecm_seq < best->ecm_seq)) {
+                best = es;
+                best_urgent = urgent;
+            }
+        }
+    }
+    return best;
+}
+
+
 //----------------------------------------------------------------------------
 // Process one ECM (the one in ECMStream::ecm).
 // In asynchronous mode, this method must be invoked with the mutex held.
@@ -394,7 +556,10 @@ void ts::AbstractDescrambler::processECM(ECMStream& estream)
 {
     // Copy the ECM out of the protected area into local data
     Section ecm(estream.ecm, ShareMode::COPY);
+    const uint64_t seq = estream.ecm_seq;
+    const Monotonic received(estream.ecm_time);
     estream.new_ecm = false;
+    estream.busy = true;
 
     // Local data for deciphered CW's from ECM.
     CWData cw_even(estream.scrambling.scramblingType());
@@ -422,28 +587,81 @@ void ts::AbstractDescrambler::processECM(ECMStream& estream)
         tsp->debug(u"odd CW:  %s", {UString::Dump(cw_odd.cw, UString::SINGLE_LINE)});
     }
 
+    // Time to decipher the ECM, including the wait in the queue.
+    const NanoSecond latency = Monotonic(true) - received;
+
     // In asynchronous mode, relock the mutex.
     if (!_synchronous) {
         _mutex.acquire();
     }
 
+    estream.busy = false;
+
+    if (!ok) {
+        estream.ecm_errors++;
+        return;
+    }
+
+    estream.ecm_ok++;
+    estream.total_latency += latency;
+    estream.max_latency = std::max(estream.max_latency, latency);
+
+    // Keep the ECM in the cache, drop the least recently used one when the cache is full.
+    if (_ecm_cache_size > 0) {
+        while (_ecm_cache.size() >= _ecm_cache_size) {
+            ECMCache::iterator oldest(_ecm_cache.begin());
+            for (ECMCache::iterator it = _ecm_cache.begin(); it != _ecm_cache.end(); ++it) {
+                if (it->second.last_use < oldest->second.last_use) {
+                    oldest = it;
+                }
+            }
+            _ecm_cache.erase(oldest);
+        }
+        CachedECM& entry(_ecm_cache[ByteBlock(ecm.content(), ecm.size())]);
+        entry.cw_even = cw_even;
+        entry.cw_odd = cw_odd;
+        entry.last_use = seq;
+    }
+
+    storeCW(estream, seq, cw_even, cw_odd);
+}
+
+
+//----------------------------------------------------------------------------
+// Store the control words from an ECM in its ECM stream.
+//----------------------------------------------------------------------------
+
+void ts::AbstractDescrambler::storeCW(ECMStream& estream, uint64_t seq, const CWData& cw_even, const CWData& cw_odd)
+{
+    // With several ECM threads or with the cache, the control words from an older
+    // ECM may come after the ones from a more recent ECM. Ignore them.
+    if (estream.cw_valid && seq < estream.cw_seq) {
+        return;
+    }
+    estream.cw_seq = seq;
+
     // Copy the control words in the protected area.
     // Normally, only one CW is modified for each new ECM.
     // Compare extracted CW with previous ones to avoid signaling a new
     // CW when it is actually unchanged.
-    if (ok) {
-        if (!estream.cw_valid || estream.cw_even.cw != cw_even.cw) {
-            // Previous even CW was either invalid or different from new one
-            estream.new_cw_even = true;
-            estream.cw_even = cw_even;
-        }
-        if (!estream.cw_valid || estream.cw_odd.cw != cw_odd.cw) {
-            // Previous odd CW was either invalid or different from new one
-            estream.new_cw_odd = true;
-            estream.cw_odd = cw_odd;
-        }
-        estream.cw_valid = ok;
+    bool new_even = false;
+    bool new_odd = false;
+    if (!estream.cw_valid || estream.cw_even.cw != cw_even.cw) {
+        // Previous even CW was either invalid or different from new one
+        estream.new_cw_even = new_even = true;
+        estream.cw_even = cw_even;
+    }
+    if (!estream.cw_valid || estream.cw_odd.cw != cw_odd.cw) {
+        // Previous odd CW was either invalid or different from new one
+        estream.new_cw_odd = new_odd = true;
+        estream.cw_odd = cw_odd;
     }
+
+    // Check if we got the CW for the next parity, ie. the one which is not currently used.
+    if ((estream.parity == SC_EVEN_KEY && new_odd) || (estream.parity == SC_ODD_KEY && new_even) || estream.parity == 0) {
+        estream.next_cw_ready = true;
+    }
+    estream.cw_valid = true;
 }
 
 
@@ -463,45 +681,27 @@ void ts::AbstractDescrambler::ECMThread::main()
 
     for (;;) {
 
-        // Look for an ECM to decipher. Loop as long as ECM's are
-        // found (or a terminate request is encountered). We loop
-        // again if at least an ECM was found since the mutex was
-        // released during the ECM processing and a new ECM may
-        // have been added at the beginning of the list.
-
-        bool got_ecm = false;
-        bool terminate = false;
-
-        do {
-            got_ecm = false;
-            terminate = _parent->_stop_thread;
-
-            // Decipher ECM's on all ECM PID's.
-            for (ECMStreamMap::iterator it = _parent->_ecm_streams.begin(); !terminate && it != _parent->_ecm_streams.end(); ++it) {
-                ECMStreamPtr& estream(it->second);
-                if (estream->new_ecm) {
-                    // Found an ECM, decipher it. Note that the mutex is
-                    // released while deciphering the ECM.
-                    got_ecm = true;
-                    _parent->processECM(*estream);
-
-                    // Look for termination request while deciphering
-                    terminate = _parent->_stop_thread;
-                }
-            }
-        } while (!terminate && got_ecm);
-
-        // Check if a terminate request is found
-        if (terminate) {
+        // Check if a terminate request is found. Signal the condition again
+        // to make sure that all other ECM threads get the termination request.
+        if (_parent->_stop_thread) {
+            lock.signal();
             break;
         }
 
-        // We have accomplished a full scan of all ECM PID's and found no ECM.
-        // The mutex was consequently not released during the loop and we are
-        // now sure that there is nothing to do. The mutex is implicitely
-        // released and we wait for the condition 'ecm_to_do' and, once we
-        // get it, implicitely relock the mutex.
-        lock.waitCondition();
+        // Get the most urgent ECM to decipher. Note that the mutex is
+        // released while deciphering the ECM.
+        ECMStream* estream = _parent->nextECMStream();
+        if (estream != nullptr) {
+            _parent->processECM(*estream);
+        }
+        else {
+            // We have accomplished a full scan of all ECM PID's and found no ECM.
+            // The mutex was not released during the scan and we are now sure
+            // that there is nothing to do. The mutex is implicitely released
+            // and we wait for the condition 'ecm_to_do' and, once we get it,
+            // implicitely relock the mutex.
+            lock.waitCondition();
+        }
     }
 
     _parent->tsp->debug(u"ECM processing thread terminated");
@@ -567,6 +767,20 @@ ts::ProcessorPlugin::Status ts::AbstractDescrambler::processPacket(TSPacket& pkt
         return TSP_OK;
     }
 
+    // On parity change, the control word for the next parity is no longer available.
+    // The next ECM's of this stream become urgent. Flag next_cw_ready is
+    // "write-protected, read-volatile", only a short mutex section is needed.
+    if (scv != pecm->parity) {
+        if (!_synchronous) {
+            _mutex.acquire();
+        }
+        pecm->parity = scv;
+        pecm->next_cw_ready = false;
+        if (!_synchronous) {
+            _mutex.release();
+        }
+    }
+
     // We found a valid CW, check if new CW were deciphered and store them in the descrambler.
     // Flags new_cw_even/odd are "write-protected, read-volatile", no mutex needed.
     if ((scv == SC_EVEN_KEY && pecm->new_cw_even) || (scv == SC_ODD_KEY && pecm->new_cw_odd)) {
@@ -41,7 +41,9 @@
 #include "tsCondition.h"
 #include "tsMutex.h"
 #include "tsThread.h"
+#include "tsMonotonic.h"
 #include "tsMemory.h"
+#include "tsObject.h"
 
 namespace ts {
 
@@ -63,6 +65,53 @@ namespace ts {
         virtual bool stop() override;
         virtual Status processPacket(TSPacket&, TSPacketMetadata&) override;
 
+        //!
+        //! Statistics on the ECM processing of one ECM stream.
+        //!
+        class TSDUCKDLL ECMStreamStatistics
+        {
+        public:
+            PacketCounter ecm_count;        //!< Number of new ECM's.
+            PacketCounter ecm_ok;           //!< Number of successfully deciphered ECM's.
+            PacketCounter ecm_errors;       //!< Number of ECM deciphering errors.
+            PacketCounter cache_hits;       //!< Number of ECM's which were found in the cache.
+            NanoSecond    average_latency;  //!< Average time between ECM reception and CW availability.
+            NanoSecond    max_latency;      //!< Maximum time between ECM reception and CW availability.
+
+            //!
+            //! Constructor.
+            //!
+            ECMStreamStatistics();
+        };
+
+        //!
+        //! Statistics on the ECM processing of all ECM streams, indexed by ECM PID.
+        //! An instance of this class is passed as plugin data with the event EVENT_ECM_STATISTICS.
+        //!
+        class TSDUCKDLL ECMStatistics : public Object
+        {
+        public:
+            std::map<PID, ECMStreamStatistics> streams;  //!< Statistics per ECM stream, indexed by ECM PID.
+
+            //!
+            //! Constructor.
+            //!
+            ECMStatistics() : streams() {}
+        };
+
+        //!
+        //! Plugin event code which is signalled when the descrambler stops.
+        //! The plugin data is an ECMStatistics instance.
+        //!
+        static constexpr uint32_t EVENT_ECM_STATISTICS = 0x45434D53;  // "ECMS"
+
+        //!
+        //! Get the current statistics on the ECM processing.
+        //! This method is thread-safe and can be invoked at any time.
+        //! @param [out] stats Returned statistics.
+        //!
+        void getECMStatistics(ECMStatistics& stats);
+
     protected:
         //!
         //! Default stack usage allocated to CAS-specific processing of an ECM.
@@ -153,6 +202,9 @@ namespace ts {
         //! an ECM, including submitting it to a smartcard. This method shall return
         //! either an odd CW, even CW or both. Missing CW's shall be empty.
         //!
+        //! With -\-ecm-threads greater than 1, this method may be concurrently invoked
+        //! from several threads for ECM's from distinct ECM streams.
+        //!
         //! @param [in] ecm CMT section (typically an ECM).
         //! @param [in,out] cw_even Returned even CW. Empty if the ECM contains no even CW.
         //! On input, the scrambling field is set to the current descrambling mode.
@@ -213,32 +265,60 @@ namespace ts {
             TS_NOBUILD_NOCOPY(ECMStream);
         public:
             // Constructor
-            ECMStream(AbstractDescrambler* parent);
+            ECMStream(AbstractDescrambler* parent, PID pid);
 
-            TID           last_tid;     // Last table id (0x80 or 0x81)
+            const PID     ecm_pid;      // PID of this ECM stream
+            ByteBlock     last_ecm;     // Content of last received ECM
             TSScrambling  scrambling;   // Descrambling using CW from the ECM's of this stream.
+            uint8_t       parity;       // Scrambling control value of last scrambled packet using this stream.
             // -- start of write-protected, read-volatile area --
             volatile bool cw_valid;     // CW's are valid
             volatile bool new_cw_even;  // New CW available (even)
             volatile bool new_cw_odd;   // New CW available (odd)
+            volatile bool next_cw_ready; // CW for next parity received since last parity change
             // -- start of protected area --
             bool          new_ecm;      // New ECM available
+            bool          busy;         // An ECM of this stream is being deciphered
+            uint64_t      ecm_seq;      // Sequence number of last received ECM
+            uint64_t      cw_seq;       // Sequence number of the ECM which produced the current CW's
+            Monotonic     ecm_time;     // Reception time of last received ECM
             Section       ecm;          // Last received ECM
             CWData        cw_even;      // Last valid CW (even)
             CWData        cw_odd;       // Last valid CW (odd)
+            // Statistics on ECM processing:
+            PacketCounter ecm_count;    // Number of new ECM's
+            PacketCounter ecm_ok;       // Number of successfully deciphered ECM's
+            PacketCounter ecm_errors;   // Number of ECM deciphering errors
+            PacketCounter cache_hits;   // Number of ECM's found in the cache
+            NanoSecond    total_latency; // Accumulated time between ECM reception and CW availability
+            NanoSecond    max_latency;  // Maximum time between ECM reception and CW availability
             // -- end of protected area --
         };
 
         typedef SafePtr<ECMStream, NullMutex> ECMStreamPtr;
         typedef std::map<PID, ECMStreamPtr> ECMStreamMap;
 
-        // ECM deciphering thread
+        // A recently deciphered ECM, with its control words, indexed by ECM content.
+        class CachedECM
+        {
+        public:
+            // Constructor
+            CachedECM() : cw_even(), cw_odd(), last_use(0) {}
+
+            CWData   cw_even;   // Even CW from the ECM
+            CWData   cw_odd;    // Odd CW from the ECM
+            uint64_t last_use;  // ECM sequence number of last use
+        };
+
+        typedef std::map<ByteBlock, CachedECM> ECMCache;
+
+        // ECM deciphering thread. All threads share the same queue of ECM streams.
         class ECMThread : public Thread
         {
             TS_NOBUILD_NOCOPY(ECMThread);
         public:
             // Constructor.
-            ECMThread(AbstractDescrambler* parent) : _parent(parent) {}
+            ECMThread(AbstractDescrambler* parent) : Thread(), _parent(parent) {}
 
         private:
             // Thread entry point.
@@ -248,14 +328,26 @@ namespace ts {
             AbstractDescrambler* _parent;
         };
 
+        typedef SafePtr<ECMThread, NullMutex> ECMThreadPtr;
+        typedef std::vector<ECMThreadPtr> ECMThreadVector;
+
         // Get the ECM stream for a PID, create it if non existent
         ECMStreamPtr getOrCreateECMStream(PID);
 
+        // Select the ECM stream with the most urgent ECM to decipher, null if there is none.
+        // ECM streams without the control word of the next parity come first, then the oldest ECM.
+        // In asynchronous mode, this method must be invoked with the mutex held.
+        ECMStream* nextECMStream();
+
         // Process one ECM (the one in ECMStream::ecm).
         // In asynchronous mode, this method must be invoked with the mutex held. The method
         // releases the mutex while deciphering the ECM and relocks it before exiting.
         void processECM(ECMStream&);
 
+        // Store the control words from an ECM in its ECM stream.
+        // In asynchronous mode, this method must be invoked with the mutex held.
+        void storeCW(ECMStream&, uint64_t seq, const CWData& cw_even, const CWData& cw_odd);
+
         // Analyze a list of descriptors from the PMT, looking for ECM PID's
         void analyzeDescriptors(const DescriptorList& dlist, std::set<PID>& ecm_pids, uint8_t& scrambling);
 
@@ -265,6 +357,8 @@ namespace ts {
         bool               _abort;             // Error, abort asap.
         bool               _synchronous;       // Synchronous ECM deciphering.
         bool               _swap_cw;           // Swap even/odd CW from ECM.
+        size_t             _ecm_thread_count;  // Number of ECM deciphering threads.
+        size_t             _ecm_cache_size;    // Max number of ECM's in the cache.
         TSScrambling       _scrambling;        // Default descrambling (used with fixed control words).
         PIDSet             _pids;              // Explicit PID's to descramble.
         ServiceDiscovery   _service;           // Service to descramble (by name, id or none).
@@ -273,10 +367,12 @@ namespace ts {
         ECMStreamMap       _ecm_streams;       // ECM streams, indexed by PID.
         ScrambledStreamMap _scrambled_streams; // Scrambled streams, indexed by PID.
         Mutex              _mutex;             // Exclusive access to protected areas
-        Condition          _ecm_to_do;         // Notify thread to process ECM.
-        ECMThread          _ecm_thread;        // Thread which deciphers ECM's.
+        Condition          _ecm_to_do;         // Notify threads to process ECM.
+        ECMThreadVector    _ecm_threads;       // Threads which decipher ECM's.
         // -- start of protected area --
-        bool               _stop_thread;       // Terminate ECM processing thread
+        bool               _stop_thread;       // Terminate ECM processing threads
+        uint64_t           _ecm_seq;           // Sequence number of received ECM's
+        ECMCache           _ecm_cache;         // Recently deciphered ECM's
         // -- end of protected area --
     };
 }
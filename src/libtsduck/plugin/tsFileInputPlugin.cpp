@@ -29,6 +29,8 @@
 
 #include "tsFileInputPlugin.h"
 #include "tsPluginRepository.h"
+#include "tsTSFileSeekIndex.h"
+#include "tsNullReport.h"
 TSDUCK_SOURCE;
 
 TS_REGISTER_INPUT_PLUGIN(u"file", ts::FileInputPlugin);
@@ -52,6 +54,8 @@ ts::FileInputPlugin::FileInputPlugin(TSP* tsp_) :
     _current_file(0),
     _repeat_count(1),
     _start_offset(0),
+    _start_time(0),
+    _seek_index(false),
     _base_label(0),
     _file_format(TSPacketFormat::AUTODETECT),
     _filenames(),
@@ -110,6 +114,24 @@ ts::FileInputPlugin::FileInputPlugin(TSP* tsp_) :
          u"Start reading each file at the specified TS packet (default: 0). "
          u"This option is allowed only if all input files are regular files.");
 
+    option(u"seek-index");
+    help(u"seek-index",
+         u"With --start-time, use an index file to locate the start time. "
+         u"The index file is named after the input file, with an additional \".tsidx\" suffix. "
+         u"If the index file does not exist or if the input file was modified since, "
+         u"the index file is (re)created. "
+         u"By default, the index is built in memory each time the file is opened.");
+
+    option(u"start-time", 0, POSITIVE);
+    help(u"start-time", u"milliseconds",
+         u"Start reading each file at the specified time, relative to the first PCR in the file. "
+         u"Reading starts at the first packet which carries a PCR at or after this time, "
+         u"on the PID of the first PCR in the file. "
+         u"The position is located using a sparse index of the PCR's in the file, "
+         u"without reading all previous packets. "
+         u"This option is allowed only if all input files are regular files. "
+         u"It is incompatible with --byte-offset and --packet-offset.");
+
     option(u"repeat", 'r', POSITIVE);
     help(u"repeat",
          u"Repeat the playout of each file the specified number of times (default: only once). "
@@ -127,6 +149,8 @@ bool ts::FileInputPlugin::getOptions()
     getValues(_filenames);
     _repeat_count = present(u"infinite") ? 0 : intValue<size_t>(u"repeat", 1);
     _start_offset = intValue<uint64_t>(u"byte-offset", intValue<uint64_t>(u"packet-offset", 0) * PKT_SIZE);
+    _start_time = intValue<MilliSecond>(u"start-time", 0);
+    _seek_index = present(u"seek-index");
     _interleave = present(u"interleave");
     _interleave_chunk = intValue<size_t>(u"interleave", 1);
     _first_terminate = present(u"first-terminate");
@@ -150,6 +174,10 @@ bool ts::FileInputPlugin::getOptions()
         tsp->error(u"specifying --infinite is meaningless with more than one file");
         return false;
     }
+    if (_start_time > 0 && (present(u"byte-offset") || present(u"packet-offset"))) {
+        tsp->error(u"--start-time is incompatible with --byte-offset and --packet-offset");
+        return false;
+    }
 
     return true;
 }
@@ -171,8 +199,53 @@ bool ts::FileInputPlugin::openFile(size_t name_index, size_t file_index)
         tsp->verbose(u"reading file %s", {name.empty() ? u"'stdin'" : name});
     }
 
+    // Locate the start time in the file.
+    uint64_t start_offset = _start_offset;
+    if (_start_time > 0 && !getStartTimeOffset(name, start_offset)) {
+        return false;
+    }
+
     // Actually open the file.
-    return _files[file_index].openRead(name, _repeat_count, _start_offset, *tsp, _file_format);
+    return _files[file_index].openRead(name, _repeat_count, start_offset, *tsp, _file_format);
+}
+
+
+//----------------------------------------------------------------------------
+// Compute the byte offset of --start-time in a file.
+//----------------------------------------------------------------------------
+
+bool ts::FileInputPlugin::getStartTimeOffset(const UString& name, uint64_t& offset)
+{
+    if (name.empty()) {
+        tsp->error(u"--start-time cannot be used on standard input");
+        return false;
+    }
+
+    TSFile file;
+    if (!file.open(name, TSFile::READ, *tsp, _file_format)) {
+        return false;
+    }
+
+    // Load the index file when it is up to date, build the index otherwise.
+    TSFileSeekIndex index;
+    const UString index_name(TSFileSeekIndex::DefaultFileName(name));
+    bool ok = _seek_index && FileExists(index_name) && index.load(index_name, file, *tsp);
+    if (!ok) {
+        ok = index.build(file, *tsp);
+        // Failing to save the index is not fatal, for instance in a read-only directory.
+        if (ok && _seek_index && !index.save(index_name, NULLREP)) {
+            tsp->warning(u"cannot write seek index %s, using the index in memory", {index_name});
+        }
+    }
+
+    PacketCounter packet = 0;
+    ok = ok && index.findPacket(file, uint64_t(_start_time) * (SYSTEM_CLOCK_FREQ / MilliSecPerSec), packet, *tsp);
+    if (ok) {
+        offset = packet * (file.packetHeaderSize() + PKT_SIZE);
+        tsp->verbose(u"%s: starting at packet %'d for time %'d ms", {file.getDisplayFileName(), packet, _start_time});
+    }
+    file.close(*tsp);
+    return ok;
 }
 
 
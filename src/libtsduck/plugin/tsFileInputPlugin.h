@@ -73,6 +73,8 @@ namespace ts {
         size_t         _current_file;       // Current file index in _files. Depends on _interleave.
         size_t         _repeat_count;
         uint64_t       _start_offset;
+        MilliSecond    _start_time;         // Start reading at this time from the first PCR.
+        bool           _seek_index;         // Use or create a seek index file next to each input file.
         size_t         _base_label;
         TSPacketFormat _file_format;
         UStringVector  _filenames;
@@ -82,6 +84,9 @@ namespace ts {
         // Open one input file.
         bool openFile(size_t name_index, size_t file_index);
 
+        // Compute the byte offset of --start-time in a file.
+        bool getStartTimeOffset(const UString& name, uint64_t& offset);
+
         // Close all files which are currently open.
         bool closeAllFiles();
     };
@@ -64,6 +64,8 @@ ts::IPOutputPlugin::IPOutputPlugin(TSP* tsp_) :
     _rtp_fixed_ssrc(false),
     _rtp_user_ssrc(0),
     _rtp_ssrc(0),
+    _paced(false),
+    _spin_time(PacketPacer::DEFAULT_SPIN_NS),
     _pcr_user_pid(PID_NULL),
     _pcr_pid(PID_NULL),
     _last_pcr(INVALID_PCR),
@@ -73,7 +75,8 @@ ts::IPOutputPlugin::IPOutputPlugin(TSP* tsp_) :
     _pkt_count(0),
     _sock(false, *tsp_),
     _out_count(0),
-    _out_buffer()
+    _out_buffer(),
+    _pacer(tsp_, Severity::Verbose)
 {
     option(u"", 0, STRING, 1, 1);
     help(u"",
@@ -115,6 +118,21 @@ ts::IPOutputPlugin::IPOutputPlugin(TSP* tsp_) :
          u"destination address. Remember that the default Multicast TTL is 1 "
          u"on most systems.");
 
+    option(u"paced");
+    help(u"paced",
+         u"Pace the output datagrams. The departure time of each datagram is computed from the PCR's "
+         u"of the reference PID (see --pcr-pid) or from the TS bitrate when there is no PCR. "
+         u"The plugin sleeps until shortly before each departure time using absolute deadlines "
+         u"and then actively polls the clock. This avoids sending micro-bursts of datagrams, "
+         u"at the expense of some CPU load. This option also regulates the output flow "
+         u"and the regulate plugin is not necessary.");
+
+    option(u"spin-time", 0, UINT32);
+    help(u"spin-time",
+         u"With --paced, specify the duration in microseconds of the final active polling of the "
+         u"clock before each departure. When zero, only the system timers are used, with their "
+         u"limited precision. The default is " + UString::Decimal(PacketPacer::DEFAULT_SPIN_NS / NanoSecPerMicroSec) + u" microseconds.");
+
     option(u"rtp", 'r');
     help(u"rtp",
          u"Use the Real-time Transport Protocol (RTP) in output UDP datagrams. "
@@ -127,7 +145,8 @@ ts::IPOutputPlugin::IPOutputPlugin(TSP* tsp_) :
 
     option(u"pcr-pid", 0, PIDVAL);
     help(u"pcr-pid",
-        u"With --rtp, specify the PID containing the PCR's which are used as reference for RTP timestamps. "
+        u"With --rtp or --paced, specify the PID containing the PCR's which are used as reference "
+        u"for RTP timestamps and departure times. "
         u"By default, use the first PID containing PCR's.");
 
     option(u"start-sequence-number", 0, UINT16);
@@ -173,6 +192,8 @@ bool ts::IPOutputPlugin::getOptions()
     _rtp_fixed_ssrc = present(u"ssrc-identifier");
     _rtp_user_ssrc = intValue<uint32_t>(u"ssrc-identifier");
     _pcr_user_pid = intValue<PID>(u"pcr-pid", PID_NULL);
+    _paced = present(u"paced");
+    _spin_time = intValue<NanoSecond>(u"spin-time", PacketPacer::DEFAULT_SPIN_NS / NanoSecPerMicroSec) * NanoSecPerMicroSec;
     return true;
 }
 
@@ -234,6 +255,13 @@ bool ts::IPOutputPlugin::start()
     _rtp_pcr_offset = 0;
     _pkt_count = 0;
 
+    // Initialize pacing.
+    if (_paced) {
+        _pacer.setReferencePID(_pcr_user_pid);
+        _pacer.setSpinTime(_spin_time);
+        _pacer.reset();
+    }
+
     return true;
 }
 
@@ -311,6 +339,11 @@ bool ts::IPOutputPlugin::sendDatagram(const TSPacket* pkt, size_t packet_count)
 {
     bool status = true;
 
+    // Wait for the departure time of this datagram.
+    if (_paced) {
+        _pacer.pace(pkt, packet_count, tsp->bitrate());
+    }
+
     if (_use_rtp) {
         // RTP datagram are relatively trivial to build, except the time stamp.
         // We cannot use the wall clock time because the plugin is likely to burst its output.
@@ -35,6 +35,7 @@
 #pragma once
 #include "tsOutputPlugin.h"
 #include "tsUDPSocket.h"
+#include "tsPacketPacer.h"
 
 namespace ts {
     //!
@@ -79,6 +80,8 @@ namespace ts {
         bool           _rtp_fixed_ssrc;     // RTP SSRC id has a fixed value
         uint32_t       _rtp_user_ssrc;      // RTP user-specified SSRC id
         uint32_t       _rtp_ssrc;           // RTP current SSRC id (constant during a session)
+        bool           _paced;              // Pace output datagrams
+        NanoSecond     _spin_time;          // Final active polling before each paced datagram
         PID            _pcr_user_pid;       // User-specified PCR PID.
         PID            _pcr_pid;            // Current PCR PID.
         uint64_t       _last_pcr;           // Last PCR value in PCR PID
@@ -89,6 +92,7 @@ namespace ts {
         UDPSocket      _sock;               // Outgoing socket
         size_t         _out_count;          // Number of packets in _out_buffer
         TSPacketVector _out_buffer;         // Buffered packets for output with --enforce-burst
+        PacketPacer    _pacer;              // Departure times of datagrams with --paced
 
         // Send contiguous packets in one single datagram.
         bool sendDatagram(const TSPacket* pkt, size_t packet_count);
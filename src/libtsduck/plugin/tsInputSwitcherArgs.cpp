@@ -29,6 +29,7 @@
 
 #include "tsInputSwitcherArgs.h"
 #include "tsArgsWithPlugins.h"
+#include "tsTSPacketDeduplicator.h"
 TSDUCK_SOURCE;
 
 #if defined(TS_NEED_STATIC_CONST_DEFINITIONS)
@@ -50,6 +51,7 @@ ts::InputSwitcherArgs::InputSwitcherArgs() :
     appName(),
     fastSwitch(false),
     delayedSwitch(false),
+    alignedSwitch(false),
     terminate(false),
     monitor(false),
     reusePort(false),
@@ -60,6 +62,7 @@ ts::InputSwitcherArgs::InputSwitcherArgs() :
     maxInputPackets(0),
     maxOutputPackets(0),
     sockBuffer(0),
+    dedupWindow(0),
     remoteServer(),
     allowedRemote(),
     receiveTimeout(0),
@@ -72,6 +75,7 @@ ts::InputSwitcherArgs::InputSwitcherArgs(const InputSwitcherArgs& other) :
     appName(other.appName),
     fastSwitch(other.fastSwitch),
     delayedSwitch(other.delayedSwitch),
+    alignedSwitch(other.alignedSwitch),
     terminate(other.terminate),
     monitor(other.monitor),
     reusePort(other.reusePort),
@@ -82,6 +86,7 @@ ts::InputSwitcherArgs::InputSwitcherArgs(const InputSwitcherArgs& other) :
     maxInputPackets(std::max(other.maxInputPackets, MIN_INPUT_PACKETS)),
     maxOutputPackets(std::max(other.maxOutputPackets, MIN_OUTPUT_PACKETS)),
     sockBuffer(other.sockBuffer),
+    dedupWindow(other.dedupWindow),
     remoteServer(other.remoteServer),
     allowedRemote(other.allowedRemote),
     receiveTimeout(other.receiveTimeout),
@@ -112,6 +117,14 @@ void ts::InputSwitcherArgs::defineArgs(Args& args) const
               u"Specify an IP address or host name which is allowed to send remote commands. "
               u"Several --allow options are allowed. By default, all remote commands are accepted.");
 
+    args.option(u"aligned-switch");
+    args.help(u"aligned-switch",
+              u"With --fast-switch, when switching to another input plugin, the output restarts "
+              u"on the most recent packet containing a PCR in the buffer of the new input plugin. "
+              u"Older packets in this buffer are dropped. Since the buffers of inactive plugins "
+              u"are continuously filled with late packets, this reduces the latency after a switch "
+              u"and the output restarts on a clock reference. Ignored without --fast-switch.");
+
     args.option(u"buffer-packets", 'b', Args::POSITIVE);
     args.help(u"buffer-packets",
               u"Specify the size in TS packets of each input plugin buffer. "
@@ -123,6 +136,17 @@ void ts::InputSwitcherArgs::defineArgs(Args& args) const
               u"By default, all input plugins are executed in sequence only once (--cycle 1). "
               u"The options --cycle, --infinite and --terminate are mutually exclusive.");
 
+    args.option(u"deduplicate", 0, Args::POSITIVE, 0, 1, 0, 0, true);
+    args.help(u"deduplicate", u"[window]",
+              u"Remove duplicate packets from the output. This is typically used when the input "
+              u"plugins receive redundant copies of the same transport stream. After a switch, the "
+              u"new input plugin may resend packets which were already output from the previous one. "
+              u"These packets are removed. Each packet is identified by its PID, continuity counter "
+              u"and a fingerprint of its content. The optional value is the number of most recent "
+              u"distinct packets to remember. The default is " +
+              UString::Decimal(TSPacketDeduplicator::DEFAULT_WINDOW) + u" packets. "
+              u"The number of removed packets per input plugin is reported at the end of processing.");
+
     args.option(u"delayed-switch", 'd');
     args.help(u"delayed-switch",
               u"Perform delayed input switching. When switching from one input plugin to another one, "
@@ -213,6 +237,7 @@ bool ts::InputSwitcherArgs::loadArgs(DuckContext& duck, Args& args)
     appName = args.appName();
     fastSwitch = args.present(u"fast-switch");
     delayedSwitch = args.present(u"delayed-switch");
+    alignedSwitch = args.present(u"aligned-switch");
     terminate = args.present(u"terminate");
     cycleCount = args.intValue<size_t>(u"cycle", args.present(u"infinite") ? 0 : 1);
     monitor = args.present(u"monitor");
@@ -222,6 +247,7 @@ bool ts::InputSwitcherArgs::loadArgs(DuckContext& duck, Args& args)
     const UString remoteName(args.value(u"remote"));
     reusePort = !args.present(u"no-reuse-port");
     sockBuffer = args.intValue<size_t>(u"udp-buffer-size");
+    dedupWindow = args.present(u"deduplicate") ? args.intValue<size_t>(u"deduplicate", TSPacketDeduplicator::DEFAULT_WINDOW) : 0;
     firstInput = args.intValue<size_t>(u"first-input", 0);
     primaryInput = args.intValue<size_t>(u"primary-input", NPOS);
     receiveTimeout = args.intValue<MilliSecond>(u"receive-timeout", primaryInput >= inputs.size() ? 0 : DEFAULT_RECEIVE_TIMEOUT);
@@ -274,5 +300,9 @@ bool ts::InputSwitcherArgs::loadArgs(DuckContext& duck, Args& args)
         args.error(u"invalid input index for --primary-input %d", {primaryInput});
     }
 
+    if (dedupWindow > 0 && inputs.size() > TSPacketDeduplicator::MAX_INPUTS) {
+        args.error(u"--deduplicate cannot be used with more than %d input plugins", {TSPacketDeduplicator::MAX_INPUTS});
+    }
+
     return args.valid();
 }
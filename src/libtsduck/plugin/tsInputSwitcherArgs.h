@@ -48,6 +48,7 @@ namespace ts {
         UString             appName;           //!< Application name, for help messages.
         bool                fastSwitch;        //!< Fast switch between input plugins.
         bool                delayedSwitch;     //!< Delayed switch between input plugins.
+        bool                alignedSwitch;     //!< With fast switch, resume new input at its last buffered PCR.
         bool                terminate;         //!< Terminate when one input plugin completes.
         bool                monitor;           //!< Run a resource monitoring thread.
         bool                reusePort;         //!< Reuse-port socket option.
@@ -58,6 +59,7 @@ namespace ts {
         size_t              maxInputPackets;   //!< Maximum input packets to read at a time.
         size_t              maxOutputPackets;  //!< Maximum input packets to send at a time.
         size_t              sockBuffer;        //!< Socket buffer size.
+        size_t              dedupWindow;       //!< Window in packets for duplicate packets removal after a switch (0=none).
         SocketAddress       remoteServer;      //!< UDP server addres for remote control.
         IPAddressSet        allowedRemote;     //!< Set of allowed remotes.
         MilliSecond         receiveTimeout;    //!< Receive timeout before switch (0=none).
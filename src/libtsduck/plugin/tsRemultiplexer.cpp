@@ -0,0 +1,593 @@
+//----------------------------------------------------------------------------
+//
+// TSDuck - The MPEG Transport Stream Toolkit
+// Copyright (c) 2005-2020, Thierry Lelegard
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+// THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------
+
+#include "tsRemultiplexer.h"
+#include "tsPluginThread.h"
+#include "tsInputPlugin.h"
+#include "tsTSPacketQueue.h"
+#include "tsTSPacketMetadata.h"
+TSDUCK_SOURCE;
+
+#define WINDOW_PACKETS        128                     // Number of packets which are read at a time from an input queue.
+#define MAX_PCR_DISCONTINUITY (SYSTEM_CLOCK_FREQ)      // Maximum PCR gap before resynchronizing an input (1 second).
+#define LATE_WARNING          (2 * SYSTEM_CLOCK_FREQ) // Warn once when an input is late by more than 2 seconds.
+
+
+//----------------------------------------------------------------------------
+// Execution thread of an input plugin.
+//----------------------------------------------------------------------------
+
+class ts::Remultiplexer::InputThread: public PluginThread
+{
+    TS_NOBUILD_NOCOPY(InputThread);
+public:
+    // Constructor and destructor.
+    InputThread(const RemultiplexerArgs& args, size_t index, Report& report);
+    virtual ~InputThread() override;
+
+    // Packet queue which is filled by the input plugin.
+    TSPacketQueue& queue() { return _queue; }
+
+    // Abort the input operation currently in progress in the plugin.
+    bool abortInput() { return _input != nullptr && _input->abortInput(); }
+
+    // Implementation of TSP. We do not use "joint termination" here.
+    virtual size_t pluginIndex() const override;
+    virtual size_t pluginCount() const override;
+    virtual void signalPluginEvent(uint32_t event_code, Object* plugin_data = nullptr) const override;
+    virtual void useJointTermination(bool) override;
+    virtual void jointTerminate() override;
+    virtual bool useJointTermination() const override;
+    virtual bool thisJointTerminated() const override;
+
+private:
+    InputPlugin*           _input;     // Plugin API.
+    const size_t           _index;     // Index of this input.
+    const size_t           _count;     // Number of inputs.
+    TSPacketQueue          _queue;     // Queue of input packets.
+    TSPacketMetadataVector _metadata;  // Metadata of input packets (ignored).
+
+    // Implementation of Thread.
+    virtual void main() override;
+};
+
+
+//----------------------------------------------------------------------------
+// Context of an input stream.
+//----------------------------------------------------------------------------
+
+class ts::Remultiplexer::Input
+{
+    TS_NOBUILD_NOCOPY(Input);
+public:
+    // Constructor.
+    Input(const RemultiplexerArgs& args, size_t index, Report& report);
+
+    InputThread     thread;        // Execution thread of the input plugin.
+    TSPacketVector  window;        // Packets which were read from the queue.
+    size_t          win_next;      // Index of next packet to process in window.
+    size_t          win_count;     // Number of packets in window.
+    bool            eof;           // End of input stream.
+    bool            pending;       // The next packet to send is in packet.
+    TSPacket        packet;        // Next packet to send.
+    bool            has_deadline;  // The deadline of packet is known, send it asap otherwise.
+    uint64_t        deadline;      // Deadline of packet in output time line.
+    bool            synced;        // The clock of the input stream is known.
+    bool            late_warned;   // A warning was already reported for late packets.
+    PID             pcr_pid;       // Reference PCR PID of the input stream.
+    uint64_t        last_raw;      // Last PCR value, as found in the packet.
+    uint64_t        base;          // Value to add to PCR's to get a continuous input time.
+    int64_t         offset;        // Value to add to input time to get output time.
+    uint64_t        last_time;     // Input time of last PCR.
+    PacketCounter   last_index;    // Packet index of last PCR.
+    uint64_t        pcr_delta;     // Input time between last two PCR's.
+    PacketCounter   pkt_delta;     // Number of packets between last two PCR's.
+    PIDSet          conflicts;     // PID's which conflict with another input stream.
+    InputStatistics stats;         // Statistics of the input stream.
+};
+
+
+//----------------------------------------------------------------------------
+// Input thread constructor and destructor.
+//----------------------------------------------------------------------------
+
+ts::Remultiplexer::InputThread::InputThread(const RemultiplexerArgs& args, size_t index, Report& report) :
+    // Input threads have a high priority to be always ready to load incoming packets in the buffer.
+    PluginThread(&report, args.appName, PluginType::INPUT, args.inputs[index], ThreadAttributes().setPriority(ThreadAttributes::GetHighPriority())),
+    _input(dynamic_cast<InputPlugin*>(PluginThread::plugin())),
+    _index(index),
+    _count(args.inputs.size()),
+    _queue(args.inputQueueSize),
+    _metadata(args.inputQueueSize)
+{
+    // Make sure that the input plugins display their index.
+    setLogName(UString::Format(u"%s[%d]", {pluginName(), _index}));
+}
+
+ts::Remultiplexer::InputThread::~InputThread()
+{
+    waitForTermination();
+}
+
+
+//----------------------------------------------------------------------------
+// Implementation of TSP for input threads.
+//----------------------------------------------------------------------------
+
+size_t ts::Remultiplexer::InputThread::pluginIndex() const
+{
+    return _index;
+}
+
+size_t ts::Remultiplexer::InputThread::pluginCount() const
+{
+    return _count;
+}
+
+void ts::Remultiplexer::InputThread::signalPluginEvent(uint32_t event_code, Object* plugin_data) const
+{
+}
+
+void ts::Remultiplexer::InputThread::useJointTermination(bool)
+{
+}
+
+void ts::Remultiplexer::InputThread::jointTerminate()
+{
+}
+
+bool ts::Remultiplexer::InputThread::useJointTermination() const
+{
+    return false;
+}
+
+bool ts::Remultiplexer::InputThread::thisJointTerminated() const
+{
+    return false;
+}
+
+
+//----------------------------------------------------------------------------
+// Input thread main code.
+//----------------------------------------------------------------------------
+
+void ts::Remultiplexer::InputThread::main()
+{
+    debug(u"input thread started");
+
+    if (_input != nullptr && _input->start()) {
+        // Receive packets directly in the queue until end of input or stop request.
+        TSPacket* buffer = nullptr;
+        size_t count = 0;
+        while (_queue.lockWriteBuffer(buffer, count) && count > 0) {
+            count = std::min(count, _metadata.size());
+            for (size_t n = 0; n < count; ++n) {
+                _metadata[n].reset();
+            }
+            count = _input->receive(buffer, _metadata.data(), count);
+            _queue.releaseWriteBuffer(count);
+            if (count == 0) {
+                debug(u"received end of input from plugin");
+                break;
+            }
+            addPluginPackets(count);
+        }
+        _input->stop();
+    }
+
+    // Always report the end of input, even when the plugin failed to start.
+    _queue.setEOF();
+    debug(u"input thread terminated");
+}
+
+
+//----------------------------------------------------------------------------
+// Input stream context constructors.
+//----------------------------------------------------------------------------
+
+ts::Remultiplexer::Input::Input(const RemultiplexerArgs& args, size_t index, Report& report) :
+    thread(args, index, report),
+    window(WINDOW_PACKETS),
+    win_next(0),
+    win_count(0),
+    eof(false),
+    pending(false),
+    packet(),
+    has_deadline(false),
+    deadline(0),
+    synced(false),
+    late_warned(false),
+    pcr_pid(PID_NULL),
+    last_raw(0),
+    base(0),
+    offset(0),
+    last_time(0),
+    last_index(0),
+    pcr_delta(0),
+    pkt_delta(0),
+    conflicts(),
+    stats()
+{
+}
+
+ts::Remultiplexer::InputStatistics::InputStatistics() :
+    received(0),
+    sent(0),
+    dropped(0),
+    late(0),
+    max_late(0)
+{
+}
+
+
+//----------------------------------------------------------------------------
+// Remultiplexer constructor and destructor.
+//----------------------------------------------------------------------------
+
+ts::Remultiplexer::Remultiplexer(DuckContext& duck, Report& report) :
+    _duck(duck),
+    _report(report),
+    _args(),
+    _inputs(),
+    _mergers(),
+    _owner(),
+    _out_time(0),
+    _out_rem(0),
+    _slot_time(0),
+    _slot_rem(0),
+    _max_lead(0),
+    _out_packets(0),
+    _null_packets(0),
+    _aborted(false)
+{
+}
+
+ts::Remultiplexer::~Remultiplexer()
+{
+    stop();
+}
+
+
+//----------------------------------------------------------------------------
+// Start the remultiplexer.
+//----------------------------------------------------------------------------
+
+bool ts::Remultiplexer::start(const RemultiplexerArgs& args)
+{
+    if (isStarted()) {
+        _report.error(u"remultiplexer already started");
+        return false;
+    }
+    if (args.inputs.empty() || args.inputs.size() >= 0xFFFF) {
+        _report.error(u"invalid number of input plugins: %d", {args.inputs.size()});
+        return false;
+    }
+    if (args.bitrate == 0) {
+        _report.error(u"output bitrate is required");
+        return false;
+    }
+
+    // Reset the output time line. The duration of one packet is kept as a
+    // quotient and a remainder to avoid any drift, whatever the bitrate.
+    _args = args;
+    TS_ZERO(_owner);
+    _out_time = _out_rem = 0;
+    _slot_time = (PKT_SIZE_BITS * uint64_t(SYSTEM_CLOCK_FREQ)) / _args.bitrate;
+    _slot_rem = (PKT_SIZE_BITS * uint64_t(SYSTEM_CLOCK_FREQ)) % _args.bitrate;
+    _max_lead = uint64_t(std::max<MilliSecond>(0, _args.maxLead)) * (SYSTEM_CLOCK_FREQ / MilliSecPerSec);
+    _out_packets = _null_packets = 0;
+    _aborted = false;
+
+    // Load all input plugins and analyze their options.
+    bool success = true;
+    for (size_t i = 0; success && i < _args.inputs.size(); ++i) {
+        _inputs.push_back(new Input(_args, i, _report));
+        success = _inputs.back()->thread.plugin() != nullptr && _inputs.back()->thread.plugin()->getOptions();
+    }
+
+    // One PSI merger per secondary input. The main input stream goes through all PSI mergers
+    // and each secondary input stream is merged by its own PSI merger. The EIT's cannot be
+    // mixed this way, the EIT's of secondary inputs are dropped.
+    if (success && _args.mergePSI) {
+        const PSIMerger::Options options = PSIMerger::Options(PSIMerger::MERGE_PAT | PSIMerger::MERGE_CAT | PSIMerger::MERGE_NIT | PSIMerger::MERGE_SDT |
+                                                              PSIMerger::MERGE_BAT | PSIMerger::KEEP_MAIN_TDT | PSIMerger::NULL_MERGED | PSIMerger::NULL_UNMERGED);
+        for (size_t i = 1; i < _inputs.size(); ++i) {
+            _mergers.push_back(new PSIMerger(_duck, options, _report));
+        }
+    }
+
+    // Start all input threads.
+    for (size_t i = 0; success && i < _inputs.size(); ++i) {
+        success = _inputs[i]->thread.start();
+    }
+
+    if (!success) {
+        stop();
+    }
+    return success;
+}
+
+
+//----------------------------------------------------------------------------
+// Stop the remultiplexer.
+//----------------------------------------------------------------------------
+
+void ts::Remultiplexer::stop()
+{
+    // First, ask all input threads to stop, then wait for them.
+    for (size_t i = 0; i < _inputs.size(); ++i) {
+        _inputs[i]->thread.queue().stop();
+        _inputs[i]->thread.abortInput();
+    }
+    for (size_t i = 0; i < _inputs.size(); ++i) {
+        _inputs[i]->thread.waitForTermination();
+    }
+    _inputs.clear();
+    _mergers.clear();
+}
+
+
+//----------------------------------------------------------------------------
+// Abort the remultiplexer from any thread.
+//----------------------------------------------------------------------------
+
+void ts::Remultiplexer::abort()
+{
+    // The input queues are stopped to wake up getPackets() if it is waiting for packets.
+    _aborted = true;
+    for (size_t i = 0; i < _inputs.size(); ++i) {
+        _inputs[i]->thread.queue().stop();
+        _inputs[i]->thread.abortInput();
+    }
+}
+
+
+//----------------------------------------------------------------------------
+// Get the statistics of an input stream.
+//----------------------------------------------------------------------------
+
+const ts::Remultiplexer::InputStatistics& ts::Remultiplexer::inputStatistics(size_t index) const
+{
+    static const InputStatistics empty;
+    return index < _inputs.size() ? _inputs[index]->stats : empty;
+}
+
+
+//----------------------------------------------------------------------------
+// Get the next output packets.
+//----------------------------------------------------------------------------
+
+size_t ts::Remultiplexer::getPackets(TSPacket* buffer, size_t max_packets)
+{
+    size_t count = 0;
+
+    while (count < max_packets && !_aborted) {
+
+        // Select the pending input packet with the earliest deadline. Packets without
+        // known deadline are due now. Packets which are due after the maximum lead
+        // are not eligible in this output slot.
+        const uint64_t limit = _out_time + _max_lead;
+        size_t best = NPOS;
+        uint64_t best_deadline = 0;
+        bool active = false;
+        for (size_t i = 0; i < _inputs.size(); ++i) {
+            Input& in(*_inputs[i]);
+            if (in.pending || loadNextPacket(i)) {
+                active = true;
+                const uint64_t dl = in.has_deadline ? in.deadline : _out_time;
+                if (dl <= limit && (best == NPOS || dl < best_deadline)) {
+                    best = i;
+                    best_deadline = dl;
+                }
+            }
+        }
+        if (!active) {
+            // End of all input streams.
+            break;
+        }
+
+        TSPacket& pkt(buffer[count++]);
+        if (best == NPOS) {
+            // Nothing to send in this slot.
+            pkt = NullPacket;
+            _null_packets++;
+        }
+        else {
+            Input& in(*_inputs[best]);
+            pkt = in.packet;
+            in.pending = false;
+            in.stats.sent++;
+            if (in.has_deadline) {
+                // Accumulate lateness statistics.
+                if (_out_time > in.deadline) {
+                    const uint64_t late = _out_time - in.deadline;
+                    in.stats.late++;
+                    in.stats.max_late = std::max(in.stats.max_late, late);
+                    if (late > LATE_WARNING && !in.late_warned) {
+                        in.late_warned = true;
+                        _report.warning(u"input %d is late by more than %d seconds, output bitrate may be too low", {best, LATE_WARNING / SYSTEM_CLOCK_FREQ});
+                    }
+                }
+                // Restamp PCR according to the actual output time.
+                if (pkt.hasPCR()) {
+                    const int64_t shift = int64_t(_out_time) - int64_t(in.deadline);
+                    pkt.setPCR(uint64_t(int64_t(pkt.getPCR() + PCR_SCALE) + shift) % PCR_SCALE);
+                }
+            }
+        }
+
+        // Advance the output time by one packet.
+        _out_packets++;
+        _out_time += _slot_time;
+        _out_rem += _slot_rem;
+        if (_out_rem >= _args.bitrate) {
+            _out_rem -= _args.bitrate;
+            _out_time++;
+        }
+    }
+    return count;
+}
+
+
+//----------------------------------------------------------------------------
+// Load the next packet to schedule from an input stream.
+//----------------------------------------------------------------------------
+
+bool ts::Remultiplexer::loadNextPacket(size_t index)
+{
+    Input& in(*_inputs[index]);
+
+    while (!in.pending) {
+
+        // Refill the window from the input queue. When the window is empty, we wait for the
+        // input plugin. Thus, the output does not depend on the relative speed of the inputs.
+        if (in.win_next >= in.win_count) {
+            BitRate bitrate = 0;
+            in.win_next = in.win_count = 0;
+            if (in.eof || !in.thread.queue().waitPackets(in.window.data(), in.window.size(), in.win_count, bitrate)) {
+                in.eof = true;
+                in.win_count = 0;
+                return false;
+            }
+        }
+
+        TSPacket& pkt(in.window[in.win_next++]);
+        in.stats.received++;
+
+        // The clock is updated with all packets, including the dropped ones.
+        computeDeadline(in, pkt);
+
+        // Null packets are dropped, they will be regenerated in the output when necessary.
+        if (pkt.getPID() == PID_NULL) {
+            continue;
+        }
+
+        // Merge PSI/SI. Packets which become null packets are dropped.
+        if (!_mergers.empty()) {
+            if (index == 0) {
+                for (size_t i = 0; i < _mergers.size(); ++i) {
+                    _mergers[i]->feedMainPacket(pkt);
+                }
+            }
+            else {
+                _mergers[index - 1]->feedMergedPacket(pkt);
+            }
+        }
+        const PID pid = pkt.getPID();
+        if (pid == PID_NULL) {
+            in.stats.dropped++;
+            continue;
+        }
+
+        // Check PID conflicts. The first input stream to use a PID owns it.
+        const uint16_t owner = uint16_t(index + 1);
+        if (_owner[pid] == 0) {
+            _owner[pid] = owner;
+        }
+        else if (_owner[pid] != owner) {
+            if (!in.conflicts.test(pid)) {
+                in.conflicts.set(pid);
+                _report.warning(u"PID 0x%X (%d) from input %d already used in input %d, dropped", {pid, pid, index, _owner[pid] - 1});
+            }
+            in.stats.dropped++;
+            continue;
+        }
+
+        in.packet = pkt;
+        in.pending = true;
+    }
+    return true;
+}
+
+
+//----------------------------------------------------------------------------
+// Update the clock of an input stream and compute the deadline of a packet.
+//----------------------------------------------------------------------------
+
+void ts::Remultiplexer::computeDeadline(Input& in, const TSPacket& pkt)
+{
+    const PacketCounter index = in.stats.received - 1;
+    const PID pid = pkt.getPID();
+    uint64_t time = 0;
+
+    if (pkt.hasPCR() && (in.pcr_pid == PID_NULL || in.pcr_pid == pid)) {
+        // A PCR from the reference PID of this input stream.
+        const uint64_t raw = pkt.getPCR();
+        if (!in.synced) {
+            // First PCR: schedule it at the current output time.
+            in.synced = true;
+            in.pcr_pid = pid;
+            in.base = 0;
+            in.offset = int64_t(_out_time) - int64_t(raw);
+            time = raw;
+        }
+        else {
+            if (WrapUpPCR(in.last_raw, raw)) {
+                in.base += PCR_SCALE;
+            }
+            time = raw + in.base;
+            const uint64_t expected = in.pkt_delta == 0 ? in.last_time : in.last_time + ((index - in.last_index) * in.pcr_delta) / in.pkt_delta;
+            if (time + MAX_PCR_DISCONTINUITY < expected || time > expected + MAX_PCR_DISCONTINUITY) {
+                // PCR discontinuity, keep the input time continuous and restart the rate evaluation.
+                in.base += expected - time;
+                time = expected;
+                in.pcr_delta = in.pkt_delta = 0;
+            }
+            else if (index > in.last_index && time > in.last_time) {
+                in.pcr_delta = time - in.last_time;
+                in.pkt_delta = index - in.last_index;
+            }
+        }
+        in.last_raw = raw;
+        in.last_time = time;
+        in.last_index = index;
+    }
+    else if (in.synced && in.pkt_delta > 0) {
+        // Interpolate the input time from the last PCR.
+        time = in.last_time + ((index - in.last_index) * in.pcr_delta) / in.pkt_delta;
+    }
+    else {
+        // Input rate not yet known, send as soon as possible.
+        in.has_deadline = false;
+        return;
+    }
+
+    // The packet shall be received before its decoding time. In a compliant stream, this is
+    // always true. Otherwise, move the deadline to the DTS (same clock as PCR, modulo wrap up).
+    if (pkt.getPUSI() && pkt.hasDTS()) {
+        const uint64_t raw = (in.last_raw + time - in.last_time) % PCR_SCALE;
+        const uint64_t late = (raw + PCR_SCALE - (pkt.getDTS() * SYSTEM_CLOCK_SUBFACTOR) % PCR_SCALE) % PCR_SCALE;
+        if (late > 0 && late < MAX_PCR_DISCONTINUITY && late <= time) {
+            time -= late;
+        }
+    }
+
+    in.has_deadline = true;
+    in.deadline = uint64_t(int64_t(time) + in.offset);
+}
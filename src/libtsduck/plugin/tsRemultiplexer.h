@@ -0,0 +1,180 @@
+//----------------------------------------------------------------------------
+//
+// TSDuck - The MPEG Transport Stream Toolkit
+// Copyright (c) 2005-2020, Thierry Lelegard
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+// THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------
+//!
+//!  @file
+//!  Multi-input remultiplexer with bitrate-aware scheduling.
+//!
+//----------------------------------------------------------------------------
+
+#pragma once
+#include "tsRemultiplexerArgs.h"
+#include "tsPSIMerger.h"
+#include "tsTSPacket.h"
+#include "tsSafePtr.h"
+
+namespace ts {
+    //!
+    //! Multi-input remultiplexer with bitrate-aware scheduling.
+    //! @ingroup plugin
+    //!
+    //! Several transport streams are read in parallel from input plugins, one thread
+    //! per input plugin. They are multiplexed into one constant bitrate output stream.
+    //!
+    //! Each input packet receives a deadline in the output time line. The deadline is
+    //! computed from the PCR's of the input stream and, for PES packets with a DTS, it
+    //! is never later than the decoding time. The output is produced one packet slot
+    //! at a time. In each slot, the pending input packet with the earliest deadline
+    //! is sent, provided that this deadline is no more than the "maximum lead" after
+    //! the current output time. Otherwise, a null packet is inserted. This prevents
+    //! the overflow of the receiver buffers when an input stream is ahead of the other
+    //! ones. The PCR's are restamped according to the actual output position of the
+    //! packets.
+    //!
+    //! The PSI/SI of all input streams are merged (same as the "merge" plugin, once
+    //! per secondary input). When the same PID is used in several input streams, the
+    //! packets from the first input stream to use it are kept and the others are dropped.
+    //! The null packets from the input streams are always dropped.
+    //!
+    class TSDUCKDLL Remultiplexer
+    {
+        TS_NOBUILD_NOCOPY(Remultiplexer);
+    public:
+        //!
+        //! Constructor.
+        //! @param [in,out] duck TSDuck execution context. The reference is kept inside the remultiplexer.
+        //! @param [in,out] report Where to report errors. This object will be used concurrently by all
+        //! input plugin threads and must be thread-safe.
+        //!
+        Remultiplexer(DuckContext& duck, Report& report);
+
+        //!
+        //! Destructor.
+        //!
+        ~Remultiplexer();
+
+        //!
+        //! Start the remultiplexer.
+        //! All input plugins are loaded and started.
+        //! @param [in] args Remultiplexer options.
+        //! @return True on success, false on error.
+        //!
+        bool start(const RemultiplexerArgs& args);
+
+        //!
+        //! Stop the remultiplexer.
+        //! All input plugins are aborted and stopped.
+        //!
+        void stop();
+
+        //!
+        //! Abort the remultiplexer.
+        //! This method can be called from any thread, while another thread is waiting
+        //! in getPackets(). The input plugins are aborted and getPackets() returns zero
+        //! as soon as possible. The method stop() must still be called.
+        //!
+        void abort();
+
+        //!
+        //! Check if the remultiplexer is started.
+        //! @return True if the remultiplexer is started.
+        //!
+        bool isStarted() const { return !_inputs.empty(); }
+
+        //!
+        //! Get the next output packets.
+        //! The output is a constant bitrate stream at the requested output bitrate.
+        //! When packets from some input stream are not yet available, the method
+        //! waits for them.
+        //! @param [out] buffer Address of the output packet buffer.
+        //! @param [in] max_packets Maximum number of packets to return in @a buffer.
+        //! @return The number of returned packets. Zero after the end of all input streams.
+        //!
+        size_t getPackets(TSPacket* buffer, size_t max_packets);
+
+        //!
+        //! Get the number of output packets so far.
+        //! @return The number of output packets, including inserted null packets.
+        //!
+        PacketCounter outputPackets() const { return _out_packets; }
+
+        //!
+        //! Get the number of inserted null packets so far.
+        //! @return The number of inserted null packets.
+        //!
+        PacketCounter nullPackets() const { return _null_packets; }
+
+        //!
+        //! Statistics of one input stream.
+        //!
+        class TSDUCKDLL InputStatistics
+        {
+        public:
+            InputStatistics();           //!< Constructor.
+            PacketCounter received;      //!< Number of received packets, including null packets.
+            PacketCounter sent;          //!< Number of packets which were sent in the output stream.
+            PacketCounter dropped;       //!< Number of dropped packets (PID conflicts, merged PSI/SI).
+            PacketCounter late;          //!< Number of packets which were sent after their deadline.
+            uint64_t      max_late;      //!< Maximum lateness of a packet, in PCR units.
+        };
+
+        //!
+        //! Get the statistics of an input stream.
+        //! @param [in] index Index of the input stream, in the order of the input plugins.
+        //! @return A constant reference to the statistics of the input stream.
+        //!
+        const InputStatistics& inputStatistics(size_t index) const;
+
+    private:
+        class InputThread;
+        class Input;
+        typedef SafePtr<Input, NullMutex> InputPtr;
+        typedef SafePtr<PSIMerger, NullMutex> PSIMergerPtr;
+
+        DuckContext&              _duck;
+        Report&                   _report;
+        RemultiplexerArgs         _args;
+        std::vector<InputPtr>     _inputs;         // Input streams, in order of input plugins.
+        std::vector<PSIMergerPtr> _mergers;        // PSI mergers, one per secondary input stream.
+        uint16_t                  _owner[PID_MAX]; // Input index + 1 which owns each PID, zero if none.
+        uint64_t                  _out_time;       // Output time in PCR units.
+        uint64_t                  _out_rem;        // Remainder of the output time, in PCR units times bitrate.
+        uint64_t                  _slot_time;      // Duration of an output packet, in PCR units.
+        uint64_t                  _slot_rem;       // Remainder of the duration of an output packet.
+        uint64_t                  _max_lead;       // Maximum lead in PCR units.
+        PacketCounter             _out_packets;    // Number of output packets.
+        PacketCounter             _null_packets;   // Number of inserted null packets.
+        volatile bool             _aborted;        // The remultiplexer was aborted.
+
+        // Load the next packet to schedule from an input stream. Return false at end of stream.
+        bool loadNextPacket(size_t index);
+
+        // Update the clock of an input stream with the next received packet and compute its deadline.
+        void computeDeadline(Input& input, const TSPacket& pkt);
+    };
+}
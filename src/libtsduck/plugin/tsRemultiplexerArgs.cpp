@@ -0,0 +1,123 @@
+//----------------------------------------------------------------------------
+//
+// TSDuck - The MPEG Transport Stream Toolkit
+// Copyright (c) 2005-2020, Thierry Lelegard
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+// THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------
+
+#include "tsRemultiplexerArgs.h"
+#include "tsArgs.h"
+TSDUCK_SOURCE;
+
+#if defined(TS_NEED_STATIC_CONST_DEFINITIONS)
+constexpr size_t ts::RemultiplexerArgs::DEFAULT_INPUT_QUEUE_SIZE;
+constexpr size_t ts::RemultiplexerArgs::MIN_INPUT_QUEUE_SIZE;
+constexpr ts::MilliSecond ts::RemultiplexerArgs::DEFAULT_MAX_LEAD;
+#endif
+
+
+//----------------------------------------------------------------------------
+// Constructor.
+//----------------------------------------------------------------------------
+
+ts::RemultiplexerArgs::RemultiplexerArgs() :
+    appName(),
+    bitrate(0),
+    inputQueueSize(DEFAULT_INPUT_QUEUE_SIZE),
+    maxLead(DEFAULT_MAX_LEAD),
+    mergePSI(true),
+    inputs()
+{
+}
+
+
+//----------------------------------------------------------------------------
+// Define command line options in an Args.
+//----------------------------------------------------------------------------
+
+void ts::RemultiplexerArgs::defineArgs(Args& args) const
+{
+    args.option(u"bitrate", 'b', Args::POSITIVE, 1, 1);
+    args.help(u"bitrate",
+              u"Specify the constant bitrate of the output transport stream, in bits/second. "
+              u"Null packets are inserted when no input packet is due. This is a required parameter.");
+
+    args.option(u"input", 'i', Args::STRING, 1, Args::UNLIMITED_COUNT);
+    args.help(u"input", u"'name [options]'",
+              u"Specify an input plugin and its options, as they would be specified after -I in tsp. "
+              u"The string is split in the same way as a shell command line. "
+              u"Several --input options are allowed, one per input transport stream. "
+              u"The first input is the main one: its PSI/SI are the base of the merged PSI/SI.");
+
+    args.option(u"input-queue-size", 0, Args::POSITIVE);
+    args.help(u"input-queue-size",
+              u"Specify the size in TS packets of the queue of each input plugin. "
+              u"The default is " + UString::Decimal(DEFAULT_INPUT_QUEUE_SIZE) + u" packets.");
+
+    args.option(u"max-lead", 0, Args::UNSIGNED);
+    args.help(u"max-lead", u"milliseconds",
+              u"Specify the maximum time before its scheduled output time that a packet may be sent. "
+              u"Each input packet is scheduled according to the PCR's of its input stream. "
+              u"Sending packets too early may overflow the buffers of the receivers (T-STD model). "
+              u"The default is " + UString::Decimal(DEFAULT_MAX_LEAD) + u" ms.");
+
+    args.option(u"no-psi-merge");
+    args.help(u"no-psi-merge",
+              u"Do not merge the PSI/SI of the input streams. "
+              u"By default, the PAT, CAT, SDT, NIT and BAT of all inputs are merged. "
+              u"With this option, only the PSI/SI of the first input is kept.");
+}
+
+
+//----------------------------------------------------------------------------
+// Load arguments from command line.
+//----------------------------------------------------------------------------
+
+bool ts::RemultiplexerArgs::loadArgs(DuckContext& duck, Args& args)
+{
+    appName = args.appName();
+    bitrate = args.intValue<BitRate>(u"bitrate");
+    inputQueueSize = std::max(MIN_INPUT_QUEUE_SIZE, args.intValue<size_t>(u"input-queue-size", DEFAULT_INPUT_QUEUE_SIZE));
+    maxLead = args.intValue<MilliSecond>(u"max-lead", DEFAULT_MAX_LEAD);
+    mergePSI = !args.present(u"no-psi-merge");
+
+    // Load all input plugin descriptions.
+    inputs.clear();
+    const size_t count = args.count(u"input");
+    for (size_t i = 0; i < count; ++i) {
+        UStringVector words;
+        args.value(u"input", u"", i).splitShellStyle(words);
+        if (words.empty()) {
+            args.error(u"empty --input specification");
+        }
+        else {
+            const UString name(words.front());
+            words.erase(words.begin());
+            inputs.push_back(PluginOptions(name, words));
+        }
+    }
+
+    return args.valid();
+}
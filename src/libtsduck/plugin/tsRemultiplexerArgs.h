@@ -0,0 +1,68 @@
+//----------------------------------------------------------------------------
+//
+// TSDuck - The MPEG Transport Stream Toolkit
+// Copyright (c) 2005-2020, Thierry Lelegard
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+// THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------
+//!
+//!  @file
+//!  Multi-input remultiplexer command-line options
+//!
+//----------------------------------------------------------------------------
+
+#pragma once
+#include "tsArgsSupplierInterface.h"
+#include "tsPluginOptions.h"
+#include "tsMPEG.h"
+
+namespace ts {
+    //!
+    //! Multi-input remultiplexer command-line options.
+    //! @ingroup plugin
+    //!
+    class TSDUCKDLL RemultiplexerArgs: public ArgsSupplierInterface
+    {
+    public:
+        UString             appName;          //!< Application name, for help messages.
+        BitRate             bitrate;          //!< Constant output bitrate.
+        size_t              inputQueueSize;   //!< Size in packets of the queue of each input plugin.
+        MilliSecond         maxLead;          //!< Maximum delay before its deadline that a packet may be sent.
+        bool                mergePSI;         //!< Merge the PSI/SI of all inputs.
+        PluginOptionsVector inputs;           //!< Input plugins descriptions.
+
+        static constexpr size_t      DEFAULT_INPUT_QUEUE_SIZE = 1000;  //!< Default queue size in packets of each input plugin.
+        static constexpr size_t      MIN_INPUT_QUEUE_SIZE = 16;        //!< Minimum queue size in packets of each input plugin.
+        static constexpr MilliSecond DEFAULT_MAX_LEAD = 20;            //!< Default maximum delay before its deadline that a packet may be sent.
+
+        //!
+        //! Constructor.
+        //!
+        RemultiplexerArgs();
+
+        // Implementation of ArgsSupplierInterface.
+        virtual void defineArgs(Args& args) const override;
+        virtual bool loadArgs(DuckContext& duck, Args& args) override;
+    };
+}
@@ -0,0 +1,281 @@
+//----------------------------------------------------------------------------
+//
+// TSDuck - The MPEG Transport Stream Toolkit
+// Copyright (c) 2005-2020, Thierry Lelegard
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+// THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------
+
+#include "tsSharedSignalization.h"
+#include "tsGuard.h"
+TSDUCK_SOURCE;
+
+#if defined(TS_NEED_STATIC_CONST_DEFINITIONS)
+constexpr size_t ts::SharedSignalization::DEFAULT_MAX_TABLES;
+#endif
+
+
+//----------------------------------------------------------------------------
+// Constructors and destructors.
+//----------------------------------------------------------------------------
+
+ts::SharedSignalization::SharedSignalization(size_t max_tables) :
+    _mutex(),
+    _duck(),
+    _demux(_duck),
+    _max_tables(std::max<size_t>(max_tables, 1)),
+    _log(),
+    _subscribers(),
+    _tid_refs(),
+    _sid_refs(),
+    _next_id(0),
+    _next_seq(0),
+    _packets(0)
+{
+    _demux.setBinaryTableHandler(this);
+}
+
+ts::SharedSignalization::~SharedSignalization()
+{
+}
+
+ts::SharedSignalization::Subscriber::Subscriber(DuckContext& duck_, SignalizationHandlerInterface* handler_, TableHandlerInterface* bin_handler_, uint64_t seq) :
+    duck(duck_),
+    handler(handler_),
+    bin_handler(bin_handler_),
+    idle_demux(duck_),
+    tids(),
+    service_ids(),
+    next_seq(seq)
+{
+}
+
+
+//----------------------------------------------------------------------------
+// Check if a table is filtered by a subscriber.
+//----------------------------------------------------------------------------
+
+bool ts::SharedSignalization::Subscriber::isFiltered(const BinaryTable& table) const
+{
+    const TID tid = table.tableId();
+    return tids.find(tid) != tids.end() || (tid == TID_PMT && service_ids.find(table.tableIdExtension()) != service_ids.end());
+}
+
+
+//----------------------------------------------------------------------------
+// Subscribe / unsubscribe.
+//----------------------------------------------------------------------------
+
+int ts::SharedSignalization::subscribe(DuckContext& duck, SignalizationHandlerInterface* handler, TableHandlerInterface* bin_handler)
+{
+    Guard lock(_mutex);
+    const int id = _next_id++;
+    _subscribers[id] = new Subscriber(duck, handler, bin_handler, _next_seq);
+    return id;
+}
+
+void ts::SharedSignalization::unsubscribe(int id)
+{
+    Guard lock(_mutex);
+    const auto it = _subscribers.find(id);
+    if (it != _subscribers.end()) {
+        // Release all filters of this subscriber.
+        for (auto tid = it->second->tids.begin(); tid != it->second->tids.end(); ++tid) {
+            if (--_tid_refs[*tid] == 0) {
+                _tid_refs.erase(*tid);
+                _demux.removeTableId(*tid);
+            }
+        }
+        for (auto sid = it->second->service_ids.begin(); sid != it->second->service_ids.end(); ++sid) {
+            if (--_sid_refs[*sid] == 0) {
+                _sid_refs.erase(*sid);
+                _demux.removeServiceId(*sid);
+            }
+        }
+        _subscribers.erase(it);
+        trimLog();
+    }
+}
+
+
+//----------------------------------------------------------------------------
+// Add / remove filters for a subscriber.
+//----------------------------------------------------------------------------
+
+bool ts::SharedSignalization::addTableId(int id, TID tid)
+{
+    Guard lock(_mutex);
+    const auto it = _subscribers.find(id);
+    if (it == _subscribers.end() || it->second->tids.find(tid) != it->second->tids.end()) {
+        return it != _subscribers.end();
+    }
+    else if (_tid_refs[tid] == 0 && !_demux.addTableId(tid)) {
+        // Unsupported table id.
+        _tid_refs.erase(tid);
+        return false;
+    }
+    else {
+        _tid_refs[tid]++;
+        it->second->tids.insert(tid);
+        return true;
+    }
+}
+
+void ts::SharedSignalization::removeTableId(int id, TID tid)
+{
+    Guard lock(_mutex);
+    const auto it = _subscribers.find(id);
+    if (it != _subscribers.end() && it->second->tids.erase(tid) > 0 && --_tid_refs[tid] == 0) {
+        _tid_refs.erase(tid);
+        _demux.removeTableId(tid);
+    }
+}
+
+void ts::SharedSignalization::addServiceId(int id, uint16_t sid)
+{
+    Guard lock(_mutex);
+    const auto it = _subscribers.find(id);
+    if (it != _subscribers.end() && it->second->service_ids.insert(sid).second && _sid_refs[sid]++ == 0) {
+        _demux.addServiceId(sid);
+    }
+}
+
+
+//----------------------------------------------------------------------------
+// Feed the shared demux with a window of contiguous TS packets.
+//----------------------------------------------------------------------------
+
+void ts::SharedSignalization::feedPackets(const TSPacket* pkt, size_t count)
+{
+    // One single lock for the complete window of packets.
+    Guard lock(_mutex);
+    for (size_t i = 0; i < count; ++i) {
+        _demux.feedPacket(pkt[i]);
+        _packets++;
+    }
+}
+
+ts::PacketCounter ts::SharedSignalization::packetCount() const
+{
+    Guard lock(_mutex);
+    return _packets;
+}
+
+
+//----------------------------------------------------------------------------
+// Invoked by the shared demux, under protection of the mutex.
+//----------------------------------------------------------------------------
+
+void ts::SharedSignalization::handleTable(SectionDemux&, const BinaryTable& table)
+{
+    // The table is published at the index of the current packet (not yet counted).
+    // The sections are copied, not shared, because they will be used in other threads.
+    Entry entry;
+    entry.seq = _next_seq++;
+    entry.position = _packets;
+    entry.nit_pid = _demux.hasPAT() && _demux.lastPAT().nit_pid != PID_NULL ? _demux.lastPAT().nit_pid : PID(PID_NIT);
+    entry.table = new BinaryTable(table, ShareMode::COPY);
+    _log.push_back(entry);
+
+    // Drop oldest tables when the log is full, even if not delivered to all subscribers.
+    while (_log.size() > _max_tables) {
+        _log.pop_front();
+    }
+}
+
+
+//----------------------------------------------------------------------------
+// Remove entries which are already delivered to all subscribers.
+//----------------------------------------------------------------------------
+
+void ts::SharedSignalization::trimLog()
+{
+    uint64_t min_seq = _next_seq;
+    for (auto it = _subscribers.begin(); it != _subscribers.end(); ++it) {
+        min_seq = std::min(min_seq, it->second->next_seq);
+    }
+    while (!_log.empty() && _log.front().seq < min_seq) {
+        _log.pop_front();
+    }
+}
+
+
+//----------------------------------------------------------------------------
+// Deliver the pending tables to a subscriber.
+//----------------------------------------------------------------------------
+
+size_t ts::SharedSignalization::deliver(int id, PacketCounter position)
+{
+    SubscriberPtr sub;
+    std::vector<Entry> tables;
+
+    // Collect the tables to deliver under protection of the mutex.
+    {
+        Guard lock(_mutex);
+        const auto it = _subscribers.find(id);
+        if (it == _subscribers.end() || _log.empty() || _log.front().position > position) {
+            // Fast path, nothing to deliver.
+            return 0;
+        }
+        sub = it->second;
+        auto entry = _log.begin();
+        while (entry != _log.end() && entry->seq < sub->next_seq) {
+            ++entry;
+        }
+        for (; entry != _log.end() && entry->position <= position; ++entry) {
+            if (sub->isFiltered(*entry->table)) {
+                tables.push_back(*entry);
+            }
+            sub->next_seq = entry->seq + 1;
+        }
+        trimLog();
+    }
+
+    // Invoke the handlers outside the mutex. The local safe pointer keeps the subscriber alive.
+    for (auto it = tables.begin(); it != tables.end(); ++it) {
+        if (sub->bin_handler != nullptr) {
+            sub->bin_handler->handleTable(sub->idle_demux, *it->table);
+        }
+        if (sub->handler != nullptr) {
+            SignalizationDemux::DispatchTable(sub->duck, *sub->handler, *it->table, it->nit_pid);
+        }
+    }
+    return tables.size();
+}
+
+
+//----------------------------------------------------------------------------
+// Reset the shared demux.
+//----------------------------------------------------------------------------
+
+void ts::SharedSignalization::reset()
+{
+    Guard lock(_mutex);
+    _demux.reset();
+    _log.clear();
+    _subscribers.clear();
+    _tid_refs.clear();
+    _sid_refs.clear();
+    _packets = 0;
+}
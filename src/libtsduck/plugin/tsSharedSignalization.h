@@ -0,0 +1,211 @@
+//----------------------------------------------------------------------------
+//
+// TSDuck - The MPEG Transport Stream Toolkit
+// Copyright (c) 2005-2020, Thierry Lelegard
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+// THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------
+//!
+//!  @file
+//!  Signalization demux which is shared by all plugins of a TS processor.
+//!
+//----------------------------------------------------------------------------
+
+#pragma once
+#include "tsSignalizationDemux.h"
+#include "tsDuckContext.h"
+#include "tsBinaryTable.h"
+#include "tsTSPacket.h"
+#include "tsSafePtr.h"
+#include "tsMutex.h"
+
+namespace ts {
+    //!
+    //! Signalization demux which is shared by all plugins of a TS processor.
+    //! @ingroup plugin
+    //!
+    //! Many plugins need the same basic signalization tables (PAT, PMT, SDT, NIT, TDT, etc.)
+    //! When each plugin runs its own demux, the same PSI/SI sections are reassembled and
+    //! deserialized once per plugin. A SharedSignalization instance is fed once per packet
+    //! window by the input thread and publishes each demuxed table, in binary form, to all
+    //! subscribed plugins.
+    //!
+    //! The published tables are immutable and shared between all subscribers. Each subscriber
+    //! retrieves them from its own thread using deliver(), in the context of its own processPacket().
+    //! The tables are then delivered exactly when the subscriber processes the packet which
+    //! completed the table, as if the subscriber had its own demux.
+    //!
+    //! Important: the tables are demuxed from the @e input transport stream, before any
+    //! modification by the plugins of the chain. A plugin which must see the tables after
+    //! modification by previous plugins shall use its own demux.
+    //!
+    //! The ATSC STT, which is not a long table, is not supported.
+    //!
+    class TSDUCKDLL SharedSignalization: private TableHandlerInterface
+    {
+        TS_NOCOPY(SharedSignalization);
+    public:
+        //!
+        //! Constructor.
+        //! @param [in] max_tables Maximum number of tables which are kept in the publication log.
+        //! A subscriber which does not retrieve its tables before they are dropped from the log
+        //! (a suspended plugin for instance) will miss them.
+        //!
+        explicit SharedSignalization(size_t max_tables = DEFAULT_MAX_TABLES);
+
+        //!
+        //! Destructor.
+        //!
+        virtual ~SharedSignalization() override;
+
+        //!
+        //! Default maximum number of tables in the publication log.
+        //!
+        static constexpr size_t DEFAULT_MAX_TABLES = 1000;
+
+        //!
+        //! Safe pointer to a shared table (thread-safe). Shared tables must never be modified.
+        //!
+        typedef SafePtr<BinaryTable, Mutex> TablePtr;
+
+        //!
+        //! Subscribe to the shared signalization.
+        //! Only the tables which are demuxed after the subscription are delivered.
+        //! @param [in,out] duck TSDuck execution context of the subscriber. It is used to deserialize
+        //! the tables which are delivered to @a handler. The reference is kept in this object.
+        //! @param [in] handler The object to invoke with deserialized tables. Can be null.
+        //! @param [in] bin_handler The object to invoke with binary tables. Can be null.
+        //! The SectionDemux which is passed to this handler is an idle demux which must not be used.
+        //! @return A subscription identifier.
+        //!
+        int subscribe(DuckContext& duck, SignalizationHandlerInterface* handler, TableHandlerInterface* bin_handler = nullptr);
+
+        //!
+        //! Cancel a subscription.
+        //! @param [in] id A subscription identifier, as returned by subscribe().
+        //!
+        void unsubscribe(int id);
+
+        //!
+        //! Add a signalization table id to filter for a subscriber.
+        //! @param [in] id A subscription identifier, as returned by subscribe().
+        //! @param [in] tid The table id to add. If TID_PMT is specified, all PMT's are delivered.
+        //! @return True if the table id is filtered, false if this table id is not supported.
+        //!
+        bool addTableId(int id, TID tid);
+
+        //!
+        //! Remove a signalization table id to filter for a subscriber.
+        //! @param [in] id A subscription identifier, as returned by subscribe().
+        //! @param [in] tid The table id to remove.
+        //!
+        void removeTableId(int id, TID tid);
+
+        //!
+        //! Add a service id to filter its PMT for a subscriber.
+        //! @param [in] id A subscription identifier, as returned by subscribe().
+        //! @param [in] sid The service id to add.
+        //!
+        void addServiceId(int id, uint16_t sid);
+
+        //!
+        //! Feed the shared demux with a window of contiguous TS packets.
+        //! This method is typically invoked by the input thread of the TS processor.
+        //! @param [in] pkt Address of the first packet.
+        //! @param [in] count Number of packets.
+        //!
+        void feedPackets(const TSPacket* pkt, size_t count);
+
+        //!
+        //! Get the number of packets which were fed into the shared demux.
+        //! @return The number of packets which were fed into the shared demux.
+        //!
+        PacketCounter packetCount() const;
+
+        //!
+        //! Deliver the pending tables to a subscriber.
+        //! All tables which were completed up to and including the packet at @a position are
+        //! passed to the handlers of the subscriber. The handlers are invoked in the context of
+        //! the calling thread, outside any internal lock.
+        //! @param [in] id A subscription identifier, as returned by subscribe().
+        //! @param [in] position Index of the current packet in the stream (the first packet
+        //! which was fed has index zero). In a plugin, this is typically tsp->totalPacketsInThread().
+        //! @return The number of delivered tables.
+        //!
+        size_t deliver(int id, PacketCounter position);
+
+        //!
+        //! Reset the shared demux, forget all published tables and all subscriptions.
+        //!
+        void reset();
+
+    private:
+        // A published table.
+        struct Entry
+        {
+            uint64_t      seq;       // Sequence number of the table.
+            PacketCounter position;  // Index of the packet which completed the table.
+            PID           nit_pid;   // NIT PID at the time the table was demuxed.
+            TablePtr      table;     // Shared binary table.
+            Entry() : seq(0), position(0), nit_pid(PID_NIT), table() {}
+        };
+
+        // Description of a subscriber.
+        class Subscriber
+        {
+            TS_NOBUILD_NOCOPY(Subscriber);
+        public:
+            Subscriber(DuckContext& duck, SignalizationHandlerInterface* handler, TableHandlerInterface* bin_handler, uint64_t seq);
+            DuckContext&                   duck;
+            SignalizationHandlerInterface* handler;
+            TableHandlerInterface*         bin_handler;
+            SectionDemux                   idle_demux;   // Placeholder for bin_handler->handleTable().
+            std::set<TID>                  tids;         // Filtered table ids.
+            std::set<uint16_t>             service_ids;  // Services for which the PMT is filtered.
+            uint64_t                       next_seq;     // Sequence number of next table to deliver.
+
+            // Check if a table is filtered by this subscriber.
+            bool isFiltered(const BinaryTable& table) const;
+        };
+        typedef SafePtr<Subscriber, Mutex> SubscriberPtr;
+
+        mutable Mutex                _mutex;
+        DuckContext                  _duck;          // Execution context of the shared demux.
+        SignalizationDemux           _demux;         // Unique demux, shared by all subscribers.
+        const size_t                 _max_tables;    // Maximum number of tables in log.
+        std::deque<Entry>            _log;           // Publication log.
+        std::map<int, SubscriberPtr> _subscribers;   // All subscribers, indexed by subscription id.
+        std::map<TID, size_t>        _tid_refs;      // Number of subscribers for each table id.
+        std::map<uint16_t, size_t>   _sid_refs;      // Number of subscribers for each service id.
+        int                          _next_id;       // Next subscription id.
+        uint64_t                     _next_seq;      // Sequence number of next published table.
+        PacketCounter                _packets;       // Number of fed packets.
+
+        // Remove entries which are already delivered to all subscribers.
+        void trimLog();
+
+        // Implementation of TableHandlerInterface, invoked by the shared demux.
+        virtual void handleTable(SectionDemux&, const BinaryTable&) override;
+    };
+}
@@ -41,6 +41,7 @@ ts::TSP::TSP(int max_severity) :
     _tsp_bitrate(0),
     _tsp_timeout(Infinite),
     _tsp_aborting(false),
+    _tsp_signalization(nullptr),
     _total_packets(0),
     _plugin_packets(0)
 {
@@ -41,6 +41,7 @@ namespace ts {
 
     class Plugin;
     class Object;
+    class SharedSignalization;
 
     //!
     //! TSP callback for plugins.
@@ -135,6 +136,14 @@ namespace ts {
         //!
         bool realtime() const { return _use_realtime; }
 
+        //!
+        //! Get the signalization demux which is shared by all plugins of the TS processor.
+        //! The shared signalization is optional and a plugin shall fall back to its own demux
+        //! when it is not available. See the class SharedSignalization.
+        //! @return Address of the shared signalization demux or null if there is none.
+        //!
+        SharedSignalization* sharedSignalization() const { return _tsp_signalization; }
+
         //!
         //! Set a timeout for the reception of packets by the current plugin.
         //! For input plugins, this is the timeout for the availability of free space in input buffer.
@@ -206,10 +215,11 @@ namespace ts {
         virtual ~TSP();
 
     protected:
-        bool          _use_realtime;  //!< The plugin should use realtime defaults.
-        BitRate       _tsp_bitrate;   //!< TSP input bitrate.
-        MilliSecond   _tsp_timeout;   //!< Timeout when waiting for packets (infinite by default).
-        volatile bool _tsp_aborting;  //!< TSP is currently aborting.
+        bool                 _use_realtime;       //!< The plugin should use realtime defaults.
+        BitRate              _tsp_bitrate;        //!< TSP input bitrate.
+        MilliSecond          _tsp_timeout;        //!< Timeout when waiting for packets (infinite by default).
+        volatile bool        _tsp_aborting;       //!< TSP is currently aborting.
+        SharedSignalization* _tsp_signalization;  //!< Shared signalization demux (can be null).
 
         //!
         //! Constructor for subclasses.
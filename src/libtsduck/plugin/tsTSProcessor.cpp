@@ -32,6 +32,7 @@
 #include "tstspOutputExecutor.h"
 #include "tstspProcessorExecutor.h"
 #include "tstspControlServer.h"
+#include "tsSharedSignalization.h"
 #include "tsMonotonic.h"
 #include "tsGuard.h"
 TSDUCK_SOURCE;
@@ -52,7 +53,8 @@ ts::TSProcessor::TSProcessor(Report& report) :
     _monitor(nullptr),
     _control(nullptr),
     _packet_buffer(nullptr),
-    _metadata_buffer(nullptr)
+    _metadata_buffer(nullptr),
+    _signalization(nullptr)
 {
 }
 
@@ -90,6 +92,12 @@ void ts::TSProcessor::cleanupInternal()
     _input = nullptr;
     _output = nullptr;
 
+    // Delete the shared signalization after all executors which reference it.
+    if (_signalization != nullptr) {
+        delete _signalization;
+        _signalization = nullptr;
+    }
+
     if (_packet_buffer != nullptr) {
         delete _packet_buffer;
         _packet_buffer = nullptr;
@@ -179,11 +187,19 @@ bool ts::TSProcessor::start(const TSProcessorArgs& args)
             return false;
         }
 
+        // Create the optional shared signalization demux.
+        if (_args.shared_signalization) {
+            _signalization = new SharedSignalization;
+            CheckNonNull(_signalization);
+        }
+
         // Initialize all executors.
         tsp::PluginExecutor* proc = _input;
         do {
             // Set realtime defaults.
             proc->setRealTimeForAll(realtime);
+            // Plugins may subscribe to the shared signalization in start().
+            proc->setSharedSignalization(_signalization);
             // Decode command line parameters for the plugin.
             if (!proc->plugin()->getOptions()) {
                 cleanupInternal();
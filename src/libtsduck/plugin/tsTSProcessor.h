@@ -43,6 +43,7 @@ namespace ts {
 
     // Forward class declaration for private part.
     //! @cond nodoxygen
+    class SharedSignalization;
     namespace tsp {
         class InputExecutor;
         class OutputExecutor;
@@ -114,6 +115,7 @@ namespace ts {
         tsp::ControlServer*   _control;          // TSP control command server thread.
         PacketBuffer*         _packet_buffer;    // Global TS packet buffer.
         PacketMetadataBuffer* _metadata_buffer;  // Global packet metabata buffer.
+        SharedSignalization*  _signalization;    // Optional signalization demux, shared by all plugins.
 
         // Deallocate and cleanup internal resources.
         void cleanupInternal();
@@ -72,6 +72,7 @@ ts::TSProcessorArgs::TSProcessorArgs() :
     control_reuse(false),
     control_sources(),
     control_timeout(DEF_CONTROL_TIMEOUT),
+    shared_signalization(false),
     duck_args(),
     input(),
     plugins(),
@@ -210,6 +211,16 @@ void ts::TSProcessorArgs::defineArgs(Args& args) const
               u"are enforced. The explicit values 'no', 'false', 'off' are used to enforce "
               u"the offline defaults and the explicit values 'yes', 'true', 'on' are used "
               u"to enforce the real-time defaults.");
+
+    args.option(u"shared-signalization");
+    args.help(u"shared-signalization",
+              u"Demux the signalization tables (PAT, PMT, NIT, SDT, TDT, etc.) only once, "
+              u"in the input thread, and share the demuxed tables with all plugins which "
+              u"support it. This reduces the CPU load when many plugins use the same tables. "
+              u"Note that the shared tables are extracted from the input transport stream, "
+              u"before any modification by the plugins. Plugins which need the modified "
+              u"tables always use their own demux. The plugins history, nitscan and time "
+              u"use the shared tables.");
 }
 
 
@@ -235,6 +246,7 @@ bool ts::TSProcessorArgs::loadArgs(DuckContext& duck, Args& args)
     control_port = args.intValue<uint16_t>(u"control-port", 0);
     control_timeout = args.intValue<MilliSecond>(u"control-timeout", DEF_CONTROL_TIMEOUT);
     control_reuse = args.present(u"control-reuse-port");
+    shared_signalization = args.present(u"shared-signalization");
 
     // Convert MB in MiB for buffer size for compatibility with original versions.
     ts_buffer_size = size_t((uint64_t(ts_buffer_size) * 1024 * 1024) / 1000000);
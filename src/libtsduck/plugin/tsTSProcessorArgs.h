@@ -67,6 +67,7 @@ namespace ts {
         bool            control_reuse;    //!< Set the 'reuse port' socket option on the control TCP server port.
         IPAddressVector control_sources;  //!< Remote IP addresses which are allowed to send control commands.
         MilliSecond     control_timeout;  //!< Reception timeout in milliseconds for control commands.
+        bool            shared_signalization; //!< Demux the signalization once for all plugins, see SharedSignalization.
         DuckContext::SavedArgs duck_args; //!< Default TSDuck context options for all plugins. Each plugin can override them in its context.
         PluginOptions          input;     //!< Input plugin description.
         PluginOptionsVector    plugins;   //!< Packet processor plugins descriptions.
@@ -43,6 +43,9 @@ const int ts::hls::OutputPlugin::REFERENCE = 0;
 #define DEFAULT_OUT_DURATION      10  // Default segment target duration for output streams.
 #define DEFAULT_OUT_LIVE_DURATION  5  // Default segment target duration for output live streams.
 #define DEFAULT_OUT_NUM_WIDTH      6  // Default size of number field in output segment files.
+#define DEFAULT_PART_DURATION   1000  // Default partial segment target duration in milliseconds (low-latency).
+#define DEFAULT_MEMORY_SEGMENTS    4  // Default number of segments in memory (low-latency).
+#define LOW_LATENCY_VERSION        6  // Playlist version in low-latency mode.
 
 
 //----------------------------------------------------------------------------
@@ -73,7 +76,19 @@ ts::hls::OutputPlugin::OutputPlugin(TSP* tsp_) :
     _pcrAnalyzer(1, 4),  // Minimum required: 1 PID, 4 PCR
     _previousBitrate(0),
     _ccFixer(NoPID, tsp),
-    _close_labels()
+    _close_labels(),
+    _lowLatency(false),
+    _partDuration(DEFAULT_PART_DURATION),
+    _ring(*tsp, DEFAULT_MEMORY_SEGMENTS),
+    _segmentName(),
+    _segmentPackets(0),
+    _partPackets(),
+    _partNumber(0),
+    _partIndependent(false),
+    _partLastCut(0),
+    _partLastCutIndependent(false),
+    _segmentParts(),
+    _liveSegmentParts()
 {
     option(u"", 0, STRING, 1, 1);
     help(u"",
@@ -116,6 +131,28 @@ ts::hls::OutputPlugin::OutputPlugin(TSP* tsp_) :
          u"are automatically deleted. By default, the output stream is considered as VoD "
          u"and all created media segments are preserved.");
 
+    option(u"low-latency");
+    help(u"low-latency",
+         u"Generate low-latency HLS (LL-HLS). Each media segment is split into partial segments "
+         u"which are announced in the playlist (#EXT-X-PART) as soon as they are complete, with "
+         u"a preload hint (#EXT-X-PRELOAD-HINT) for the next one. Partial segments are cut at the "
+         u"start of PES packets on the video PID and are marked as independent when they start on "
+         u"a random access point.\n\n"
+         u"In low-latency mode, the media segments are built in memory and all files (segments, "
+         u"partial segments, playlist) are written to disk by a background thread. "
+         u"See also options --partial-duration and --memory-segments.");
+
+    option(u"memory-segments", 0, POSITIVE);
+    help(u"memory-segments",
+         u"With --low-latency, specify the number of most recent media segments which are kept in memory. "
+         u"This is also the maximum number of completed segments which can wait to be written to disk. "
+         u"The default is " TS_STRINGIFY(DEFAULT_MEMORY_SEGMENTS) u" segments.");
+
+    option(u"partial-duration", 0, POSITIVE);
+    help(u"partial-duration", u"milliseconds",
+         u"With --low-latency, specify the target duration in milliseconds of partial segments. "
+         u"The default is " TS_STRINGIFY(DEFAULT_PART_DURATION) u" milliseconds.");
+
     option(u"playlist", 'p', STRING);
     help(u"playlist", u"filename",
          u"Specify the name of the playlist file. "
@@ -154,11 +191,18 @@ bool ts::hls::OutputPlugin::getOptions()
     _fixedSegmentSize = intValue<PacketCounter>(u"fixed-segment-size") / PKT_SIZE;
     _initialMediaSeq = intValue<size_t>(u"start-media-sequence", 0);
     getIntValues(_close_labels, u"label-close");
+    _lowLatency = present(u"low-latency");
+    _partDuration = intValue<MilliSecond>(u"partial-duration", DEFAULT_PART_DURATION);
+    _ring.setMaxSegments(intValue<size_t>(u"memory-segments", DEFAULT_MEMORY_SEGMENTS));
 
     if (_fixedSegmentSize > 0 && _close_labels.any()) {
         tsp->error(u"options --fixed-segment-size and --label-close are incompatible");
         return false;
     }
+    if (_lowLatency && _partDuration >= _targetDuration * MilliSecPerSec) {
+        tsp->error(u"the partial segment duration must be lower than the segment duration");
+        return false;
+    }
 
     return true;
 }
@@ -210,17 +254,37 @@ bool ts::hls::OutputPlugin::start()
 
     // Initialize the segment and playlist files.
     _liveSegmentFiles.clear();
+    _liveSegmentParts.clear();
     _segClosePending = false;
     if (_segmentFile.isOpen()) {
         _segmentFile.close(*tsp);
     }
     if (!_playlistFile.empty()) {
-        _playlist.reset(hls::MEDIA_PLAYLIST, _playlistFile);
+        if (_lowLatency) {
+            _playlist.reset(hls::MEDIA_PLAYLIST, _playlistFile, LOW_LATENCY_VERSION);
+            _playlist.setPartTargetDuration(_partDuration, *tsp);
+        }
+        else {
+            _playlist.reset(hls::MEDIA_PLAYLIST, _playlistFile);
+        }
         _playlist.setTargetDuration(_targetDuration, *tsp);
         _playlist.setPlaylistType(_liveDepth == 0 ? u"VOD" : u"EVENT", *tsp);
         _playlist.setMediaSequence(_initialMediaSeq, *tsp);
     }
 
+    // In low-latency mode, all files are asynchronously written by the segment ring.
+    _segmentName.clear();
+    _segmentPackets = 0;
+    _partPackets.clear();
+    _partNumber = 0;
+    _partIndependent = false;
+    _partLastCut = 0;
+    _partLastCutIndependent = false;
+    _segmentParts.clear();
+    if (_lowLatency && !_ring.isOpen() && !_ring.open()) {
+        return false;
+    }
+
     // Create the first segment file.
     return createNextSegment();
 }
@@ -232,8 +296,14 @@ bool ts::hls::OutputPlugin::start()
 
 bool ts::hls::OutputPlugin::stop()
 {
-    // Simply close the current segmetn (and generate the corresponding playlist).
-    return closeCurrentSegment(true);
+    // Simply close the current segment (and generate the corresponding playlist).
+    bool ok = closeCurrentSegment(true);
+
+    // In low-latency mode, wait for the completion of all file operations.
+    if (_ring.isOpen()) {
+        ok = _ring.close() && ok;
+    }
+    return ok;
 }
 
 
@@ -251,9 +321,15 @@ bool ts::hls::OutputPlugin::createNextSegment()
     // Generate a new segment file name.
     const UString fileName(UString::Format(u"%s%0*d%s", {_segmentTemplateHead, _segmentNumWidth, _segmentNextFile, _segmentTemplateTail}));
 
-    // Create the segment file.
+    // Create the segment file. In low-latency mode, the segment is built in memory.
     tsp->verbose(u"creating media segment %s", {fileName});
-    if (!_segmentFile.open(fileName, TSFile::WRITE | TSFile::SHARED, *tsp)) {
+    if (_lowLatency) {
+        _segmentName = fileName;
+        _segmentPackets = 0;
+        _partNumber = 0;
+        _segmentParts.clear();
+    }
+    else if (!_segmentFile.open(fileName, TSFile::WRITE | TSFile::SHARED, *tsp)) {
         return false;
     }
 
@@ -279,23 +355,32 @@ bool ts::hls::OutputPlugin::createNextSegment()
 bool ts::hls::OutputPlugin::closeCurrentSegment(bool endOfStream)
 {
     // If no segment file is open, there is nothing to do.
-    if (!_segmentFile.isOpen()) {
+    if (_lowLatency ? _segmentName.empty() : !_segmentFile.isOpen()) {
         return true;
     }
 
     // Get the segment file name and size (to be inserted in the playlist).
-    const UString segName(_segmentFile.getFileName());
-    const PacketCounter segPackets = _segmentFile.writePacketsCount();
-
-    // Close the TS file.
-    if (!_segmentFile.close(*tsp)) {
+    const UString segName(_lowLatency ? _segmentName : _segmentFile.getFileName());
+    const PacketCounter segPackets = segmentPackets();
+
+    // Close the TS file. In low-latency mode, flush the last partial segment in the ring.
+    if (_lowLatency) {
+        const bool ok = closeCurrentPart(true) && _ring.closeSegment();
+        _segmentName.clear();
+        if (!ok) {
+            return false;
+        }
+    }
+    else if (!_segmentFile.close(*tsp)) {
         return false;
     }
 
     // On live streams, we need to maintain a list of active segments.
     if (_liveDepth > 0) {
         _liveSegmentFiles.push_back(segName);
+        _liveSegmentParts.push_back(_segmentParts);
     }
+    _segmentParts.clear();
 
     // Create or regenerate the playlist file.
     if (!_playlistFile.empty()) {
@@ -334,7 +419,14 @@ bool ts::hls::OutputPlugin::closeCurrentSegment(bool endOfStream)
         }
 
         // Write the playlist file.
-        if (!_playlist.saveFile(UString(), *tsp)) {
+        if (_lowLatency) {
+            _playlist.setPreloadHint(UString(), *tsp);
+            const UString text(_playlist.textContent(*tsp));
+            if (text.empty() || !_ring.saveText(_playlistFile, text)) {
+                return false;
+            }
+        }
+        else if (!_playlist.saveFile(UString(), *tsp)) {
             return false;
         }
 
@@ -352,11 +444,24 @@ bool ts::hls::OutputPlugin::closeCurrentSegment(bool endOfStream)
         // Remove name of the file to delete from the list of active segment.
         const UString name(_liveSegmentFiles.front());
         _liveSegmentFiles.pop_front();
+        UStringList parts;
+        if (!_liveSegmentParts.empty()) {
+            parts.swap(_liveSegmentParts.front());
+            _liveSegmentParts.pop_front();
+        }
 
-        // Delete the segment file.
-        tsp->verbose(u"deleting obsolete segment file %s", {name});
-        if (DeleteFile(name) != SYS_SUCCESS) {
-            tsp->verbose(u"error deleting obsolete segment file %s", {name});
+        // Delete the segment file. In low-latency mode, the deletion is queued after the pending writes.
+        if (_lowLatency) {
+            _ring.deleteFile(name);
+            for (auto it = parts.begin(); it != parts.end(); ++it) {
+                _ring.deleteFile(*it);
+            }
+        }
+        else {
+            tsp->verbose(u"deleting obsolete segment file %s", {name});
+            if (DeleteFile(name) != SYS_SUCCESS) {
+                tsp->verbose(u"error deleting obsolete segment file %s", {name});
+            }
         }
 
         // WARNING: several improvements are possible here.
@@ -456,8 +561,12 @@ bool ts::hls::OutputPlugin::writePackets(const TSPacket* pkt, size_t packetCount
             p = &tmp;
         }
 
-        // Write the packet in the segment file.
-        if (!_segmentFile.writePackets(p, nullptr, 1, *tsp)) {
+        // Write the packet in the segment file or the current partial segment.
+        if (_lowLatency) {
+            _partPackets.push_back(*p);
+            _segmentPackets++;
+        }
+        else if (!_segmentFile.writePackets(p, nullptr, 1, *tsp)) {
             return false;
         }
     }
@@ -465,6 +574,79 @@ bool ts::hls::OutputPlugin::writePackets(const TSPacket* pkt, size_t packetCount
 }
 
 
+//----------------------------------------------------------------------------
+// Number of packets in the current segment.
+//----------------------------------------------------------------------------
+
+ts::PacketCounter ts::hls::OutputPlugin::segmentPackets() const
+{
+    return _lowLatency ? _segmentPackets : _segmentFile.writePacketsCount();
+}
+
+
+//----------------------------------------------------------------------------
+// Build the file name of a partial segment (low-latency).
+//----------------------------------------------------------------------------
+
+ts::UString ts::hls::OutputPlugin::partName(const UString& segName, size_t partNumber) const
+{
+    return UString::Format(u"%s-%d%s", {PathPrefix(segName), partNumber, PathSuffix(segName)});
+}
+
+
+//----------------------------------------------------------------------------
+// Close the current partial segment and update the playlist (low-latency).
+//----------------------------------------------------------------------------
+
+bool ts::hls::OutputPlugin::closeCurrentPart(bool endOfSegment, size_t packetCount)
+{
+    if (_partPackets.empty() || packetCount == 0) {
+        return true;
+    }
+
+    // Packets after packetCount are kept for the next partial segment.
+    TSPacketVector next;
+    if (packetCount < _partPackets.size()) {
+        next.assign(_partPackets.begin() + packetCount, _partPackets.end());
+        _partPackets.resize(packetCount);
+    }
+
+    // Describe the partial segment. The duration is computed from the segment bitrate.
+    hls::MediaPart part;
+    part.uri = partName(_segmentName, _partNumber++);
+    part.independent = _partIndependent;
+    const BitRate bitrate = _pcrAnalyzer.bitrateIsValid() ? _pcrAnalyzer.bitrate188() : _previousBitrate;
+    part.duration = bitrate > 0 ? PacketInterval(bitrate, _partPackets.size()) : _partDuration;
+    _segmentParts.push_back(part.uri);
+
+    // Give the packets to the segment ring, they are asynchronously written.
+    tsp->debug(u"closing partial segment %s, %d packets", {part.uri, _partPackets.size()});
+    const bool added = _ring.addPart(_segmentName, part.uri, _partPackets);
+
+    // The next partial segment starts with the remaining packets, if any.
+    // When the cut was made on the last video PES start, the next part starts on it.
+    _partPackets.swap(next);
+    _partIndependent = !_partPackets.empty() && _partLastCut == packetCount && _partLastCutIndependent;
+    _partLastCut = 0;
+    if (!added) {
+        return false;
+    }
+
+    // Announce the partial segment in the playlist.
+    if (!_playlistFile.empty()) {
+        _playlist.addPart(part, *tsp);
+        if (!endOfSegment) {
+            _playlist.setPreloadHint(partName(_segmentName, _partNumber), *tsp);
+            const UString text(_playlist.textContent(*tsp));
+            if (text.empty() || !_ring.saveText(_playlistFile, text)) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+
 //----------------------------------------------------------------------------
 // Output method
 //----------------------------------------------------------------------------
@@ -483,10 +665,11 @@ bool ts::hls::OutputPlugin::send(const TSPacket* pkt, const TSPacketMetadata* pk
         _pcrAnalyzer.feedPacket(pkt[i]);
 
         // Check if we should close the current segment and create a new one.
+        const PacketCounter segPackets = segmentPackets();
         bool renew = false;
         if (_fixedSegmentSize > 0) {
             // Each segment shall have a fixed size.
-            renew = _segmentFile.writePacketsCount() >= _fixedSegmentSize;
+            renew = segPackets >= _fixedSegmentSize;
         }
         else if (!_segClosePending) {
             if (pkt_data[i].hasAnyLabel(_close_labels)) {
@@ -495,16 +678,43 @@ bool ts::hls::OutputPlugin::send(const TSPacket* pkt, const TSPacketMetadata* pk
             }
             else if (_pcrAnalyzer.bitrateIsValid()) {
                 // The segment file shall be closed when the estimated duration exceeds the target duration.
-                _segClosePending = PacketInterval(_pcrAnalyzer.bitrate188(), _segmentFile.writePacketsCount()) >= _targetDuration * MilliSecPerSec;
+                _segClosePending = PacketInterval(_pcrAnalyzer.bitrate188(), segPackets) >= _targetDuration * MilliSecPerSec;
             }
         }
 
         // We do close only when we start a new PES packet on the video PID.
-        renew = renew || (_segClosePending && (_videoPID == PID_NULL || (pkt[i].getPID() == _videoPID && pkt[i].getPUSI())));
+        const bool cutPoint = _videoPID == PID_NULL || (pkt[i].getPID() == _videoPID && pkt[i].getPUSI());
+        renew = renew || (_segClosePending && cutPoint);
+
+        // In low-latency mode, a partial segment never exceeds the advertised part target duration.
+        // When the current partial segment would exceed it with this packet, it is cut before
+        // this packet if this is a cut point, otherwise at the last video PES start in the part.
+        // Without cut point in the part (very long PES), the part is cut before this packet.
+        size_t partCut = 0;
+        if (_lowLatency && !renew && !_partPackets.empty()) {
+            const BitRate bitrate = _pcrAnalyzer.bitrateIsValid() ? _pcrAnalyzer.bitrate188() : _previousBitrate;
+            if (bitrate > 0 && PacketInterval(bitrate, _partPackets.size() + 1) > _partDuration) {
+                partCut = cutPoint || _partLastCut == 0 ? _partPackets.size() : _partLastCut;
+            }
+        }
 
         // Close current segment and recreate a new one when necessary.
+        ok = (!renew || createNextSegment()) && (partCut == 0 || closeCurrentPart(false, partCut));
+
+        // A new partial segment is independent when it starts on a random access point.
+        const bool randomAccess = _videoPID == PID_NULL || (cutPoint && pkt[i].getRandomAccessIndicator());
+        if (renew || (partCut > 0 && _partPackets.empty())) {
+            _partIndependent = randomAccess;
+        }
+
+        // Remember the last cut point inside the current partial segment.
+        if (_lowLatency && cutPoint && !_partPackets.empty()) {
+            _partLastCut = _partPackets.size();
+            _partLastCutIndependent = randomAccess;
+        }
+
         // Finally write the packet.
-        ok = (!renew || createNextSegment()) && writePackets(pkt + i, 1);
+        ok = ok && writePackets(pkt + i, 1);
     }
     return ok;
 }
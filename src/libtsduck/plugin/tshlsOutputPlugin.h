@@ -39,6 +39,7 @@
 #include "tsPCRAnalyzer.h"
 #include "tsContinuityAnalyzer.h"
 #include "tshlsPlayList.h"
+#include "tshlsSegmentRing.h"
 
 namespace ts {
     namespace hls {
@@ -51,6 +52,10 @@ namespace ts {
         //! playlists. To setup a complete HLS server, it is necessary to setup an
         //! external HTTP server such as Apache which simply serves these files.
         //!
+        //! In low-latency mode, media segments are built in memory as a sequence of
+        //! partial segments and all files are asynchronously written by a background
+        //! thread (see ts::hls::SegmentRing).
+        //!
         class TSDUCKDLL OutputPlugin: public ts::OutputPlugin, private TableHandlerInterface
         {
             TS_NOBUILD_NOCOPY(OutputPlugin);
@@ -97,6 +102,18 @@ namespace ts {
             BitRate            _previousBitrate;       // Bitrate of previous segment.
             ContinuityAnalyzer _ccFixer;               // To fix continuity counters in PAT and PMT PID's.
             TSPacketMetadata::LabelSet _close_labels;  // Close segment on packets with any of these labels.
+            bool               _lowLatency;            // Generate low-latency HLS with partial segments.
+            MilliSecond        _partDuration;          // Target duration of partial segments.
+            SegmentRing        _ring;                  // In-memory segments with asynchronous write (low-latency).
+            UString            _segmentName;           // Name of current segment (low-latency).
+            PacketCounter      _segmentPackets;        // Number of packets in current segment (low-latency).
+            TSPacketVector     _partPackets;           // Packets of current partial segment (low-latency).
+            size_t             _partNumber;            // Index of current partial segment in segment (low-latency).
+            bool               _partIndependent;       // Current partial segment starts on a random access point.
+            size_t             _partLastCut;           // Index in _partPackets of the last video PES start, zero if none.
+            bool               _partLastCutIndependent;// The packet at _partLastCut is a random access point.
+            UStringList        _segmentParts;          // File names of partial segments in current segment.
+            std::list<UStringList> _liveSegmentParts;  // File names of partial segments, for each segment in _liveSegmentFiles.
 
             // Create the next segment file (also close the previous one if necessary).
             bool createNextSegment();
@@ -109,6 +126,16 @@ namespace ts {
 
             // Write packets into the current segment file, adjust CC in PAT and PMT PID.
             bool writePackets(const TSPacket*, size_t);
+
+            // Number of packets in the current segment.
+            PacketCounter segmentPackets() const;
+
+            // Build the file name of a partial segment (low-latency).
+            UString partName(const UString& segName, size_t partNumber) const;
+
+            // Close the current partial segment and update the playlist (low-latency).
+            // Only the first packetCount packets are output, the next ones start the next partial segment.
+            bool closeCurrentPart(bool endOfSegment, size_t packetCount = NPOS);
         };
     }
 }
@@ -172,6 +172,7 @@
 #include "tsDCCSCT.h"
 #include "tsDCCT.h"
 #include "tsDebugPlugin.h"
+#include "tsDecodedStringCache.h"
 #include "tsDeferredAssociationTagsDescriptor.h"
 #include "tsDektecControl.h"
 #include "tsDektecDeviceInfo.h"
@@ -241,6 +242,7 @@
 #include "tsECMRepetitionRateDescriptor.h"
 #include "tsEDID.h"
 #include "tsEIT.h"
+#include "tsEITGenerator.h"
 #include "tsEITProcessor.h"
 #include "tsEmergencyInformationDescriptor.h"
 #include "tsEMMGClient.h"
@@ -259,6 +261,8 @@
 #include "tsExternalApplicationAuthorizationDescriptor.h"
 #include "tsExternalESIdDescriptor.h"
 #include "tsFatal.h"
+#include "tsFileBatch.h"
+#include "tsFileBatchHandlerInterface.h"
 #include "tsFileInputPlugin.h"
 #include "tsFileNameRate.h"
 #include "tsFileOutputPlugin.h"
@@ -288,9 +292,11 @@
 #include "tshls.h"
 #include "tshlsInputPlugin.h"
 #include "tshlsMediaPlayList.h"
+#include "tshlsMediaPart.h"
 #include "tshlsMediaSegment.h"
 #include "tshlsOutputPlugin.h"
 #include "tshlsPlayList.h"
+#include "tshlsSegmentRing.h"
 #include "tshlsTagAttributes.h"
 #include "tsHybridInformationDescriptor.h"
 #include "tsIBPDescriptor.h"
@@ -390,6 +396,7 @@
 #include "tsPacketDecapsulation.h"
 #include "tsPacketEncapsulation.h"
 #include "tsPacketizer.h"
+#include "tsPacketPacer.h"
 #include "tsPagerArgs.h"
 #include "tsParentalRatingDescriptor.h"
 #include "tsPartialReceptionDescriptor.h"
@@ -405,6 +412,7 @@
 #include "tsPESHandlerInterface.h"
 #include "tsPESPacket.h"
 #include "tsPIDOperator.h"
+#include "tsPIDRoutingTable.h"
 #include "tsPlatform.h"
 #include "tsPlugin.h"
 #include "tsPluginEventContext.h"
@@ -432,6 +440,8 @@
 #include "tsReferenceDescriptor.h"
 #include "tsRegistrationDescriptor.h"
 #include "tsRegistry.h"
+#include "tsRemultiplexer.h"
+#include "tsRemultiplexerArgs.h"
 #include "tsReport.h"
 #include "tsReportBuffer.h"
 #include "tsReportFile.h"
@@ -454,6 +464,7 @@
 #include "tsSectionDemux.h"
 #include "tsSectionFile.h"
 #include "tsSectionFileArgs.h"
+#include "tsSectionFileIndex.h"
 #include "tsSectionHandlerInterface.h"
 #include "tsSectionProviderInterface.h"
 #include "tsSelectionInformationTable.h"
@@ -473,6 +484,7 @@
 #include "tsSHA256.h"
 #include "tsSHA512.h"
 #include "tsSharedLibrary.h"
+#include "tsSharedSignalization.h"
 #include "tsSHDeliverySystemDescriptor.h"
 #include "tsShortEventDescriptor.h"
 #include "tsShortNodeInformationDescriptor.h"
@@ -510,6 +522,7 @@
 #include "tsSSUURIDescriptor.h"
 #include "tsStandaloneTableDemux.h"
 #include "tsStandards.h"
+#include "tsStartCodeScanner.h"
 #include "tsStaticInstance.h"
 #include "tsSTDDescriptor.h"
 #include "tsStereoscopicProgramInfoDescriptor.h"
@@ -602,10 +615,13 @@
 #include "tsTSFile.h"
 #include "tsTSFileInputBuffered.h"
 #include "tsTSFileOutputResync.h"
+#include "tsTSFileSeekIndex.h"
 #include "tsTSForkPipe.h"
 #include "tsTSInformationDescriptor.h"
+#include "tsTSOutputThread.h"
 #include "tsTSP.h"
 #include "tsTSPacket.h"
+#include "tsTSPacketDeduplicator.h"
 #include "tsTSPacketFormat.h"
 #include "tsTSPacketMetadata.h"
 #include "tsTSPacketQueue.h"
@@ -35,6 +35,7 @@
 #include "tsPluginRepository.h"
 #include "tsBinaryTable.h"
 #include "tsSectionDemux.h"
+#include "tsSharedSignalization.h"
 #include "tsNames.h"
 #include "tsVariable.h"
 #include "tsTime.h"
@@ -87,6 +88,8 @@ namespace ts {
         PacketCounter _last_tdt_pkt;      // Packet# of last TDT
         bool          _last_tdt_reported; // Last TDT already reported
         SectionDemux  _demux;             // Section filter
+        SharedSignalization* _shared;     // Shared signalization demux, when used instead of _demux.
+        int           _shared_id;         // Subscription id in _shared.
         PIDContext    _cpids[PID_MAX];    // Description of each PID
 
         // Invoked by the demux when a complete table is available.
@@ -122,6 +125,8 @@ ts::HistoryPlugin::HistoryPlugin(TSP* tsp_) :
     _last_tdt_pkt(0),
     _last_tdt_reported(false),
     _demux(duck, this),
+    _shared(nullptr),
+    _shared_id(0),
     _cpids()
 {
     option(u"cas", 'c');
@@ -218,8 +223,18 @@ bool ts::HistoryPlugin::start()
         p->last_tid = TID_NULL;
     }
 
-    // Reinitialize the demux
+    // Reinitialize the demux. The shared signalization of tsp, if there is one, provides
+    // all tables except EIT's and ECM's. It is used when they are not reported.
     _demux.reset();
+    _shared = _report_eit || _report_cas ? nullptr : tsp->sharedSignalization();
+    if (_shared != nullptr) {
+        _shared_id = _shared->subscribe(duck, nullptr, this);
+        const TID tids[] = {TID_PAT, TID_CAT, TID_TSDT, TID_PMT, TID_NIT_ACT, TID_NIT_OTH, TID_SDT_ACT, TID_SDT_OTH, TID_BAT, TID_TDT, TID_TOT};
+        for (auto tid : tids) {
+            _shared->addTableId(_shared_id, tid);
+        }
+        return true;
+    }
     _demux.addPID (PID_PAT);
     _demux.addPID (PID_CAT);
     _demux.addPID (PID_TSDT);
@@ -242,6 +257,11 @@ bool ts::HistoryPlugin::start()
 
 bool ts::HistoryPlugin::stop()
 {
+    if (_shared != nullptr) {
+        _shared->unsubscribe(_shared_id);
+        _shared = nullptr;
+    }
+
     // Report last packet of each PID
     for (PIDContext* p = _cpids; p < _cpids + PID_MAX; ++p) {
         if (p->pkt_count > 0) {
@@ -509,8 +529,13 @@ ts::ProcessorPlugin::Status ts::HistoryPlugin::processPacket(TSPacket& pkt, TSPa
     cpid->last_pkt = _current_pkt;
     cpid->pkt_count++;
 
-    // Filter interesting sections
-    _demux.feedPacket(pkt);
+    // Filter interesting sections, or get them from the shared signalization.
+    if (_shared != nullptr) {
+        _shared->deliver(_shared_id, tsp->totalPacketsInThread());
+    }
+    else {
+        _demux.feedPacket(pkt);
+    }
 
     // Count TS packets
     _current_pkt++;
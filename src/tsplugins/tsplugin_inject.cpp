@@ -34,6 +34,7 @@
 
 #include "tsPluginRepository.h"
 #include "tsCyclingPacketizer.h"
+#include "tsEITGenerator.h"
 #include "tsFileNameRate.h"
 #include "tsSectionFileArgs.h"
 #include "tsSysUtils.h"
@@ -84,6 +85,8 @@ namespace ts {
         PacketCounter         _cycle_count;       // Number of insertion cycles
         CyclingPacketizer     _pzer;              // Packetizer for table
         CyclingPacketizer::StuffingPolicy _stuffing_policy;
+        bool                  _incremental_eit;   // Regenerate EIT's from an event store
+        EITGenerator          _eit_gen;           // EIT generator with --incremental-eit
 
         // Reload files, reset packetizer. Return true on success, false on error.
         bool reloadFiles();
@@ -91,6 +94,9 @@ namespace ts {
         // Process bitrates and compute inter-packet distance.
         bool processBitRates();
 
+        // Set the bitrate of the injected PID in the packetizer.
+        void setPacketizerBitRate(BitRate bitrate);
+
         // Replace current packet with one from the packetizer.
         void replacePacket(TSPacket& pkt);
     };
@@ -129,7 +135,9 @@ ts::InjectPlugin::InjectPlugin (TSP* tsp_) :
     _eval_interval(0),
     _cycle_count(0),
     _pzer(duck, PID_NULL, CyclingPacketizer::NEVER, 0, tsp),
-    _stuffing_policy(CyclingPacketizer::NEVER)
+    _stuffing_policy(CyclingPacketizer::NEVER),
+    _incremental_eit(false),
+    _eit_gen(duck, PID_NULL)
 {
     duck.defineArgsForCharset(*this);
     _sections_opt.defineArgs(*this);
@@ -163,6 +171,16 @@ ts::InjectPlugin::InjectPlugin (TSP* tsp_) :
          u"Force recomputation of CRC32 in long sections. Ignore CRC32 values "
          u"in input file.");
 
+    option(u"incremental-eit");
+    help(u"incremental-eit",
+         u"The input files contain EIT sections. Their events are loaded in an event store "
+         u"and the EIT p/f and EIT schedule are generated from this store, according to "
+         u"ETSI TS 101 211, using the current system time. The repetition rates of the "
+         u"input files are ignored and the sections are repeated at the minimum rates "
+         u"from ETSI TS 101 211. With --poll-files, only the EIT sections of the events "
+         u"which were added, modified or removed in the files are regenerated. "
+         u"This option requires --replace, --bitrate or --inter-packet.");
+
     option(u"inter-packet", 'i', UINT32);
     help(u"inter-packet",
          u"Specifies the packet interval for the new PID, that is to say the "
@@ -239,6 +257,7 @@ bool ts::InjectPlugin::start()
     _pid_bitrate = intValue<BitRate>(u"bitrate", 0);
     _pid_inter_pkt = intValue<PacketCounter>(u"inter-packet", 0);
     _eval_interval = intValue<PacketCounter>(u"evaluate-interval", DEF_EVALUATE_INTERVAL);
+    _incremental_eit = present(u"incremental-eit");
 
     if (present(u"xml")) {
         _intype = SectionFile::XML;
@@ -268,6 +287,10 @@ bool ts::InjectPlugin::start()
         tsp->error(u"--terminate and --joint-termination are mutually exclusive");
         return false;
     }
+    if (_incremental_eit && _repeat_count > 0) {
+        tsp->error(u"--incremental-eit and --repeat are mutually exclusive");
+        return false;
+    }
 
     // Get list of input section files.
     if (!_infiles.getArgs(*this)) {
@@ -290,10 +313,14 @@ bool ts::InjectPlugin::start()
     // At most one option --replace, --bitrate, --inter-packet must be specified.
     // If none of them are specified, we need a repetition rate for all files.
     const int opt_count = _replace + (_pid_bitrate != 0) + (_pid_inter_pkt != 0);
-    _use_files_bitrate = opt_count == 0 && !_undefined_rates;
+    _use_files_bitrate = opt_count == 0 && !_undefined_rates && !_incremental_eit;
     if (opt_count > 1) {
         tsp->error(u"specify at most one of --replace, --bitrate, --inter-packet");
     }
+    if (opt_count == 0 && _incremental_eit) {
+        tsp->error(u"--incremental-eit requires one of --replace, --bitrate, --inter-packet");
+        return false;
+    }
     if (opt_count == 0 && _undefined_rates) {
         tsp->error(u"all files must have a repetition rate when none of --replace, --bitrate, --inter-packet is used");
     }
@@ -333,6 +360,7 @@ bool ts::InjectPlugin::reloadFiles()
     uint64_t bits_per_1000s = 0;  // Total bits in 1000 seconds.
     SectionFile file(duck);
     file.setCRCValidation(_crc_op);
+    SectionPtrVector eit_sections;
 
     for (FileNameRateList::iterator it = _infiles.begin(); it != _infiles.end(); ++it) {
         if (_poll_files && !FileExists(it->file_name)) {
@@ -348,7 +376,12 @@ bool ts::InjectPlugin::reloadFiles()
         else {
             // File successfully loaded.
             it->retry_count = 0;  // no longer needed to retry
-            _pzer.addSections(file.sections(), it->repetition);
+            if (_incremental_eit) {
+                eit_sections.insert(eit_sections.end(), file.sections().begin(), file.sections().end());
+            }
+            else {
+                _pzer.addSections(file.sections(), it->repetition);
+            }
             tsp->verbose(u"loaded %d sections from %s, repetition rate: %s",
                          {file.sections().size(),
                           it->file_name,
@@ -365,14 +398,21 @@ bool ts::InjectPlugin::reloadFiles()
         }
     }
 
+    // Update the event store. Only the modified events are regenerated.
+    if (_incremental_eit) {
+        _eit_gen.setPID(_inject_pid);
+        _eit_gen.replaceEvents(eit_sections);
+        tsp->verbose(u"%d events in EIT generator", {_eit_gen.eventCount()});
+    }
+
     // Compute target bitrate based on repetition rates (if we need it).
     if (_use_files_bitrate) {
         _files_bitrate = BitRate(bits_per_1000s / 1000);
-        _pzer.setBitRate(_files_bitrate);
+        setPacketizerBitRate(_files_bitrate);
         tsp->verbose(u"target bitrate from repetition rates: %'d b/s", {_files_bitrate});
     }
     else {
-        _pzer.setBitRate(_pid_bitrate);  // non-zero only if --bitrate is specified
+        setPacketizerBitRate(_pid_bitrate);  // non-zero only if --bitrate is specified
     }
 
     return success;
@@ -401,7 +441,7 @@ bool ts::InjectPlugin::processBitRates()
         _pid_inter_pkt = ts_bitrate / _pid_bitrate;
         tsp->verbose(u"transport bitrate: %'d b/s, packet interval: %'d", {ts_bitrate, _pid_inter_pkt});
     }
-    else if (!_use_files_bitrate && _specific_rates && _pid_inter_pkt != 0) {
+    else if (!_use_files_bitrate && (_specific_rates || _incremental_eit) && _pid_inter_pkt != 0) {
         // The PID bitrate must be set in the packetizer in order to apply
         // the potential section-specific repetition rates. If --bitrate
         // was specified, this is already done. If --inter-packet was
@@ -412,7 +452,7 @@ bool ts::InjectPlugin::processBitRates()
             tsp->warning(u"input bitrate unknown or too low, section-specific repetition rates will be ignored");
         }
         else {
-            _pzer.setBitRate(_pid_bitrate);
+            setPacketizerBitRate(_pid_bitrate);
             tsp->verbose(u"transport bitrate: %'d b/s, new PID bitrate: %'d b/s", {ts_bitrate, _pid_bitrate});
         }
     }
@@ -421,15 +461,36 @@ bool ts::InjectPlugin::processBitRates()
 }
 
 
+//----------------------------------------------------------------------------
+// Set the bitrate of the injected PID in the packetizer.
+//----------------------------------------------------------------------------
+
+void ts::InjectPlugin::setPacketizerBitRate(BitRate bitrate)
+{
+    if (_incremental_eit) {
+        _eit_gen.setBitRate(bitrate);
+    }
+    else {
+        _pzer.setBitRate(bitrate);
+    }
+}
+
+
 //----------------------------------------------------------------------------
 // Replace current packet with one from the packetizer.
 //----------------------------------------------------------------------------
 
 void ts::InjectPlugin::replacePacket(TSPacket& pkt)
 {
-    _pzer.getNextPacket(pkt);
-    if (_pzer.atCycleBoundary()) {
-        _cycle_count++;
+    if (_incremental_eit) {
+        // No cycle in the generated EIT's, --repeat is not allowed.
+        _eit_gen.getNextPacket(pkt);
+    }
+    else {
+        _pzer.getNextPacket(pkt);
+        if (_pzer.atCycleBoundary()) {
+            _cycle_count++;
+        }
     }
 }
 
@@ -453,14 +514,14 @@ ts::ProcessorPlugin::Status ts::InjectPlugin::processPacket(TSPacket& pkt, TSPac
     if (pid == _inject_pid) {
         _pid_packet_count++;
     }
-    if (_replace && _specific_rates && _pid_packet_count == _eval_interval && _packet_count > 0) {
+    if (_replace && (_specific_rates || _incremental_eit) && _pid_packet_count == _eval_interval && _packet_count > 0) {
         const BitRate ts_bitrate = tsp->bitrate();
         _pid_bitrate = BitRate((PacketCounter(ts_bitrate) * _pid_packet_count) / _packet_count);
         if (_pid_bitrate == 0) {
             tsp->warning(u"input bitrate unknown or too low, section-specific repetition rates will be ignored");
         }
         else {
-            _pzer.setBitRate(_pid_bitrate);
+            setPacketizerBitRate(_pid_bitrate);
             tsp->debug(u"transport bitrate: %'d b/s, new PID bitrate: %'d b/s", {ts_bitrate, _pid_bitrate});
         }
         _pid_packet_count = 0;
@@ -469,7 +530,8 @@ ts::ProcessorPlugin::Status ts::InjectPlugin::processPacket(TSPacket& pkt, TSPac
 
     // Poll files when necessary.
     // Do that only at section boundary in the output PID to avoid truncated sections.
-    if (_poll_files && _pzer.atSectionBoundary() && Time::CurrentUTC() >= _poll_file_next) {
+    const bool at_boundary = _incremental_eit ? _eit_gen.packetizer().atSectionBoundary() : _pzer.atSectionBoundary();
+    if (_poll_files && at_boundary && Time::CurrentUTC() >= _poll_file_next) {
         if (_infiles.scanFiles(FILE_RETRY, *tsp) > 0) {
             // Some files have changed. Reset packetizer and reload files.
             reloadFiles();
@@ -35,12 +35,16 @@
 #include "tsPluginRepository.h"
 #include "tsTSForkPipe.h"
 #include "tsTSPacketQueue.h"
+#include "tsTSPacketDeduplicator.h"
 #include "tsPSIMerger.h"
+#include "tsPIDRoutingTable.h"
 #include "tsThread.h"
+#include <deque>
 TSDUCK_SOURCE;
 
 #define DEFAULT_MAX_QUEUED_PACKETS  1000            // Default size in packet of the inter-thread queue.
 #define SERVER_THREAD_STACK_SIZE    (128 * 1024)    // Size in byte of the thread stack.
+#define DEDUP_MAX_ADVANCE           1               // Max advance of an inserted packet over the main stream, in merged packets.
 
 
 //----------------------------------------------------------------------------
@@ -63,26 +67,12 @@ namespace ts {
         // - Main stream: the TS which is processed by tsp, including this plugin.
         // - Merged stream: the additional TS which is read by this plugin through a pipe.
 
-        // Each PID with PCR's in the merged stream is described by a structure like this.
-        class PIDContext
-        {
-        public:
-            uint64_t      last_pcr;  // Last PCR value in this PID, after adjustment in main stream.
-            PacketCounter pcr_pkt;   // Index of the packet with the last PCR in the main stream.
-
-            // Constructor:
-            PIDContext(uint64_t pcr = 0, PacketCounter pkt = 0) : last_pcr(pcr), pcr_pkt(pkt) {}
-        };
-
-        // Map of PID contexts, indexed by PID.
-        typedef std::map<PID,PIDContext> PIDContextMap;
-
         // Plugin private data.
         bool              _merge_psi;         // Merge PSI/SI information.
         bool              _pcr_restamp;       // Restamp PCR from the merged stream.
         bool              _ignore_conflicts;  // Ignore PID conflicts.
         bool              _terminate;         // Terminate processing after last merged packet.
-        PIDSet            _allowed_pids;      // List of PID's to merge.
+        bool              _deduplicate;       // Remove packets which are present in the two streams.
         bool              _abort;             // Error, give up asap.
         bool              _got_eof;           // Got end of merged stream.
         PacketCounter     _pkt_count;         // Packet counter in the main stream.
@@ -90,14 +80,37 @@ namespace ts {
         TSPacketQueue     _queue;             // TS packet queur from merge to main.
         PIDSet            _main_pids;         // Set of detected PID's in main stream.
         PIDSet            _merge_pids;        // Set of detected PID's in merged stream that we pass in main stream.
-        PIDContextMap     _pcr_pids;          // Description of PID's with PCR's from the merged stream.
+        PIDRoutingTable   _routing;           // Precompiled drop/pass and PCR restamping of the merged stream.
         PSIMerger         _psi_merger;        // Used to merge PSI/SI from both streams.
         TSPacketFormat    _format;            // Packet format on the pipe
         TSPacketMetadata::LabelSet _setLabels;    // Labels to set on output packets.
         TSPacketMetadata::LabelSet _resetLabels;  // Labels to reset on output packets.
 
+        // With deduplication, the new packets from the merged stream are kept in a look-ahead
+        // buffer until they are inserted in a free slot or received from the main stream.
+        struct LookAheadPacket
+        {
+            TSPacket      pkt;       // Packet from the merged stream.
+            uint64_t      hash;      // Fingerprint of the packet.
+            PacketCounter index;     // Packet index in the merged stream.
+            PacketCounter received;  // Main stream packet index when the packet was received.
+            LookAheadPacket(const TSPacket& p, uint64_t h, PacketCounter i, PacketCounter r) : pkt(p), hash(h), index(i), received(r) {}
+        };
+        typedef std::deque<LookAheadPacket> LookAheadQueue;
+
+        TSPacketDeduplicator _dedup;          // Duplicate packets detection, main stream is input 0, merged stream is input 1.
+        std::map<PID, LookAheadQueue> _lookahead;  // Look-ahead packets per PID, in order of arrival.
+        size_t            _lookahead_count;   // Total number of packets in _lookahead.
+        PacketCounter     _merge_count;       // Packet counter in the merged stream, with deduplication.
+        PacketCounter     _merge_position;    // Index in the merged stream of the last packet output in the main stream.
+        PIDSet            _out_pids;          // PID's which were already output, with deduplication.
+        uint8_t           _out_cc[PID_MAX];   // Last output CC per PID, with deduplication.
+        PacketCounter     _recovered;         // Number of packets from merged stream inserted in main stream.
+        PacketCounter     _late_dropped;      // Number of packets from merged stream dropped, a later CC was already output.
+        PacketCounter     _stale_dropped;     // Number of packets from merged stream dropped, older than the window.
+
         // Process a --drop or --pass option.
-        bool processDropPassOption(const UChar* option, bool allowed);
+        bool processDropPassOption(const UChar* option, bool drop);
 
         // There is one thread which receives packet from the created process and passes
         // them to the main plugin thread. The following method is the thread main code.
@@ -105,6 +118,15 @@ namespace ts {
 
         // Process one packet coming from the merged stream.
         Status processMergePacket(TSPacket&, TSPacketMetadata&);
+
+        // With deduplication, move all packets from the merged queue into the look-ahead buffer, dropping duplicates.
+        void drainMergedQueue();
+
+        // With deduplication, remove a packet from the main stream from the look-ahead buffer. Return true if found.
+        bool removeLookAhead(const TSPacket& pkt);
+
+        // With deduplication, get the next look-ahead packet which can be inserted in a free slot.
+        bool getLookAheadPacket(TSPacket& pkt);
     };
 }
 
@@ -122,7 +144,7 @@ ts::MergePlugin::MergePlugin(TSP* tsp_) :
     _pcr_restamp(false),
     _ignore_conflicts(false),
     _terminate(false),
-    _allowed_pids(),
+    _deduplicate(false),
     _abort(false),
     _got_eof(false),
     _pkt_count(0),
@@ -130,16 +152,43 @@ ts::MergePlugin::MergePlugin(TSP* tsp_) :
     _queue(),
     _main_pids(),
     _merge_pids(),
-    _pcr_pids(),
+    _routing(),
     _psi_merger(duck, PSIMerger::NONE, *tsp),
     _format(TSPacketFormat::AUTODETECT),
     _setLabels(),
-    _resetLabels()
+    _resetLabels(),
+    _dedup(),
+    _lookahead(),
+    _lookahead_count(0),
+    _merge_count(0),
+    _merge_position(0),
+    _out_pids(),
+    _out_cc(),
+    _recovered(0),
+    _late_dropped(0),
+    _stale_dropped(0)
 {
     option(u"", 0, STRING, 1, 1);
     help(u"",
          u"Specifies the command line to execute in the created process.");
 
+    option(u"deduplicate", 0, POSITIVE, 0, 1, 0, 0, true);
+    help(u"deduplicate", u"[window]",
+         u"Remove packets which are present in the two streams. This is used when the main and "
+         u"merged streams are redundant copies of the same TS, with independent losses. Packets "
+         u"from any stream which were already seen in any stream are replaced with null packets "
+         u"and the main stream is completed with the packets which are missing from it. Each "
+         u"packet is identified by its PID, continuity counter and a fingerprint of its content. "
+         u"A packet from the merged stream is inserted in a free slot of the main stream only "
+         u"when it is the next one in its PID, according to the continuity counters. It is dropped "
+         u"when a later packet of the same PID was already output. "
+         u"The optional value is the number of most recent distinct packets to remember, it must "
+         u"be larger than the maximum delay between the two streams. Packets from the merged "
+         u"stream which are not inserted within that number of packets are dropped. The default "
+         u"is " + UString::Decimal(TSPacketDeduplicator::DEFAULT_WINDOW) + u" packets. "
+         u"This option implies --transparent and --no-pcr-restamp. Loss statistics of the two "
+         u"streams are reported at the end of processing.");
+
     option(u"drop", 'd', STRING, 0, UNLIMITED_COUNT);
     help(u"drop", u"pid[-pid]",
          u"Drop the specified PID or range of PID's from the merged stream. By "
@@ -235,11 +284,12 @@ bool ts::MergePlugin::start()
     // Get command line arguments
     UString command(value());
     const bool nowait = present(u"no-wait");
-    const bool transparent = present(u"transparent");
+    _deduplicate = present(u"deduplicate");
+    const bool transparent = _deduplicate || present(u"transparent");
     const size_t max_queue = intValue<size_t>(u"max-queue", DEFAULT_MAX_QUEUED_PACKETS);
     _format = enumValue<TSPacketFormat>(u"format", TSPacketFormat::AUTODETECT);
     _merge_psi = !transparent && !present(u"no-psi-merge");
-    _pcr_restamp = !present(u"no-pcr-restamp");
+    _pcr_restamp = !_deduplicate && !present(u"no-pcr-restamp");
     _ignore_conflicts = transparent || present(u"ignore-conflicts");
     _terminate = present(u"terminate");
     tsp->useJointTermination(present(u"joint-termination"));
@@ -252,19 +302,29 @@ bool ts::MergePlugin::start()
     }
 
     // By default, drop all base PSI/SI (PID 0x00 to 0x1F).
-    _allowed_pids.set();
+    _routing.reset();
     if (!transparent) {
-        for (PID pid = 0x00; pid <= PID_DVB_LAST; ++pid) {
-            _allowed_pids.reset(pid);
-        }
+        _routing.setFlags(0x00, PID_DVB_LAST, PIDRoutingTable::DROP);
     }
-    if (!processDropPassOption(u"drop", false) || !processDropPassOption(u"pass", true)) {
+    if (!processDropPassOption(u"drop", true) || !processDropPassOption(u"pass", false)) {
         return false;
     }
+    if (_pcr_restamp) {
+        _routing.setFlags(0, PID_MAX - 1, PIDRoutingTable::PCR_RESTAMP);
+    }
 
     // Resize the inter-thread packet queue.
     _queue.reset(max_queue);
 
+    // Reset the duplicate packets detection, the main stream is input 0, the merged stream is input 1.
+    _dedup.reset(intValue<size_t>(u"deduplicate", TSPacketDeduplicator::DEFAULT_WINDOW), 2);
+    _lookahead.clear();
+    _lookahead_count = 0;
+    _merge_count = 0;
+    _merge_position = 0;
+    _out_pids.reset();
+    _recovered = _late_dropped = _stale_dropped = 0;
+
     // Configure the PSI merger.
     if (_merge_psi) {
         _psi_merger.reset(PSIMerger::MERGE_PAT |
@@ -275,16 +335,15 @@ bool ts::MergePlugin::start()
                           PSIMerger::NULL_UNMERGED);
 
         // Let the PSI Merger manage the packets from the merged PID's.
-        _allowed_pids.set(PID_PAT);
-        _allowed_pids.set(PID_CAT);
-        _allowed_pids.set(PID_SDT);
-        _allowed_pids.set(PID_EIT);
+        _routing.setFlags(PID_PAT, PIDRoutingTable::DROP, false);
+        _routing.setFlags(PID_CAT, PIDRoutingTable::DROP, false);
+        _routing.setFlags(PID_SDT, PIDRoutingTable::DROP, false);
+        _routing.setFlags(PID_EIT, PIDRoutingTable::DROP, false);
     }
 
     // Other states.
     _main_pids.reset();
     _merge_pids.reset();
-    _pcr_pids.clear();
     _pkt_count = 0;
     _got_eof = false;
     _abort = false;
@@ -311,7 +370,7 @@ bool ts::MergePlugin::start()
 // Process a --drop or --pass option.
 //----------------------------------------------------------------------------
 
-bool ts::MergePlugin::processDropPassOption(const UChar* option, bool allowed)
+bool ts::MergePlugin::processDropPassOption(const UChar* option, bool drop)
 {
     const size_t max = count(option);
     bool status = true;
@@ -333,9 +392,7 @@ bool ts::MergePlugin::processDropPassOption(const UChar* option, bool allowed)
             status = false;
         }
         else {
-            while (pid1 <= pid2) {
-                _allowed_pids.set(pid1++, allowed);
-            }
+            _routing.setFlags(pid1, num == 2 ? pid2 : pid1, PIDRoutingTable::DROP, drop);
         }
     }
     return status;
@@ -356,6 +413,17 @@ bool ts::MergePlugin::stop()
 
     // Wait for actual thread termination.
     Thread::waitForTermination();
+
+    // Report statistics of duplicate packets detection.
+    if (_deduplicate) {
+        _dedup.flush();
+        const UChar* const names[] = {u"main", u"merged"};
+        for (size_t i = 0; i < 2; ++i) {
+            const TSPacketDeduplicator::InputStatistics& stats(_dedup.statistics(i));
+            tsp->info(u"%s stream: %'d packets, %'d duplicates removed, %'d lost", {names[i], stats.packets, stats.duplicates, stats.lost});
+        }
+        tsp->info(u"merged stream: %'d packets inserted, %'d dropped after a later packet, %'d dropped outside window", {_recovered, _late_dropped, _stale_dropped});
+    }
     return true;
 }
 
@@ -397,9 +465,14 @@ void ts::MergePlugin::main()
 
         assert(read_size % PKT_SIZE == 0);
 
-        // Pass the read packets to the inter-thread queue.
+        // Apply the PID filters in bulk on the window of read packets, before passing them
+        // to the plugin thread. Dropped packets are replaced with null packets.
         // The read size was returned in bytes, we must give a number of packets.
-        _queue.releaseWriteBuffer(read_size / PKT_SIZE);
+        const size_t count = read_size / PKT_SIZE;
+        _routing.apply(buffer, count);
+
+        // Pass the read packets to the inter-thread queue.
+        _queue.releaseWriteBuffer(count);
     }
 
     tsp->debug(u"receiver thread completed");
@@ -412,6 +485,22 @@ void ts::MergePlugin::main()
 
 ts::ProcessorPlugin::Status ts::MergePlugin::processPacket(TSPacket& pkt, TSPacketMetadata& pkt_data)
 {
+    // With deduplication, a packet which was already output becomes a free slot for the merged stream.
+    // When the main stream brings a packet which is still waiting in the look-ahead buffer, the packet
+    // from the main stream is kept at its place. The merged queue is drained at each packet so that
+    // duplicate packets from the merged stream never accumulate.
+    if (_deduplicate) {
+        if (!_dedup.feedPacket(pkt, 0) && !removeLookAhead(pkt)) {
+            pkt = NullPacket;
+        }
+        drainMergedQueue();
+        const PID main_pid = pkt.getPID();
+        if (main_pid != PID_NULL) {
+            _out_pids.set(main_pid);
+            _out_cc[main_pid] = pkt.getCC();
+        }
+    }
+
     const PID pid = pkt.getPID();
 
     // Merge PSI/SI.
@@ -453,9 +542,10 @@ ts::ProcessorPlugin::Status ts::MergePlugin::processMergePacket(TSPacket& pkt, T
     BitRate merge_bitrate = 0;
 
     // Replace current null packet in main stream with next packet from merged stream.
-    if (!_queue.getPacket(pkt, merge_bitrate)) {
+    const bool got_packet = _deduplicate ? getLookAheadPacket(pkt) : _queue.getPacket(pkt, merge_bitrate);
+    if (!got_packet) {
         // No packet available, keep original null packet.
-        if (!_got_eof && _queue.eof()) {
+        if (!_got_eof && _queue.eof() && _lookahead_count == 0) {
             // Report end of input stream once.
             _got_eof = true;
             tsp->verbose(u"end of merged stream");
@@ -471,17 +561,17 @@ ts::ProcessorPlugin::Status ts::MergePlugin::processMergePacket(TSPacket& pkt, T
         return TSP_OK;
     }
 
+    // Selected PID's from merged stream were already replaced with null packets in the receiver thread.
+    const PID pid = pkt.getPID();
+    if (pid == PID_NULL) {
+        return TSP_NULL;
+    }
+
     // Merge PSI/SI.
     if (_merge_psi) {
         _psi_merger.feedMergedPacket(pkt);
     }
 
-    // Drop selected PID's from merged stream. Replace them with a null packet.
-    const PID pid = pkt.getPID();
-    if (!_allowed_pids.test(pid)) {
-        return TSP_NULL;
-    }
-
     // Check PID conflicts.
     if (!_ignore_conflicts) {
         if (pid != PID_NULL && !_merge_pids.test(pid)) {
@@ -499,44 +589,19 @@ ts::ProcessorPlugin::Status ts::MergePlugin::processMergePacket(TSPacket& pkt, T
     }
 
     // Adjust PCR's in packets from the merge streams.
-    if (_pcr_restamp && pkt.hasPCR()) {
-
-        // In each PID with PCR's in the merge stream, we keep the first PCR
-        // value unchanged. Then, we need to adjust all subsequent PCR's.
-        // PCR's are system clock values. They must be synchronized with the
-        // transport stream rate. So, the difference between two PCR's shall
-        // be the transmission time in PCR units.
-        //
-        // We can compute new precise PCR values when the bitrate is fixed.
-        // However, with a variable bitrate, our computed values will be inaccurate.
-        //
-        // Also note that we do not modify DTS and PTS. First, we can't access
-        // PTS and DTS in scrambled streams (unlike PCR's). Second, we MUST NOT
-        // change them because they indicate at which time the frame shall be
-        // _processed_, not _transmitted_.
-
-        const uint64_t pcr = pkt.getPCR();
-        const BitRate main_bitrate = tsp->bitrate();
-
-        // Check if we know this PID.
-        PIDContextMap::iterator ctx(_pcr_pids.find(pid));
-        if (ctx == _pcr_pids.end()) {
-            // First time we see a PCR in this PID, create the context.
-            // Save the initial PCR value bu do not modify it.
-            _pcr_pids.insert(std::make_pair(pid, PIDContext(pcr, _pkt_count)));
-        }
-        else if (main_bitrate > 0) {
-            // We have seen PCR's in this PID.
-            // Compute the transmission time since last PCR in PCR units.
-            // We base the result on the main stream bitrate and the number of packets.
-            assert(_pkt_count > ctx->second.pcr_pkt);
-            ctx->second.last_pcr += ((_pkt_count - ctx->second.pcr_pkt) * 8 * PKT_SIZE * SYSTEM_CLOCK_FREQ) / uint64_t(main_bitrate);
-            ctx->second.pcr_pkt = _pkt_count;
-            // Update the PCR in the packet.
-            pkt.setPCR(ctx->second.last_pcr);
+    // In each PID with PCR's in the merge stream, we keep the first PCR value unchanged.
+    // Then, we need to adjust all subsequent PCR's, based on the position in the main stream.
+    //
+    // Also note that we do not modify DTS and PTS. First, we can't access
+    // PTS and DTS in scrambled streams (unlike PCR's). Second, we MUST NOT
+    // change them because they indicate at which time the frame shall be
+    // _processed_, not _transmitted_.
+    if (_pcr_restamp) {
+        const uint64_t pcr = pkt.hasPCR() ? pkt.getPCR() : 0;
+        if (_routing.restampPCR(pkt, _pkt_count, tsp->bitrate())) {
             // In debug mode, report the displacement of the PCR.
             // This may go back and forth around zero but should never diverge.
-            const SubSecond moved = ctx->second.last_pcr - pcr;
+            const SubSecond moved = pkt.getPCR() - pcr;
             tsp->debug(u"adjusted PCR by %'d (%'d ms) in PID 0x%X (%d)", {moved, (moved * MilliSecPerSec) / SYSTEM_CLOCK_FREQ, pid, pid});
         }
     }
@@ -547,3 +612,131 @@ ts::ProcessorPlugin::Status ts::MergePlugin::processMergePacket(TSPacket& pkt, T
 
     return TSP_OK;
 }
+
+
+//----------------------------------------------------------------------------
+// With deduplication, move packets from the merged queue into the look-ahead
+// buffer. Duplicate packets are dropped. The look-ahead buffer is limited to
+// half the deduplication window so that the packets of the main stream which
+// were recently output remain in the window. When the look-ahead buffer is
+// full, the merged stream is ahead of the main stream and is no longer read.
+//----------------------------------------------------------------------------
+
+void ts::MergePlugin::drainMergedQueue()
+{
+    const size_t max_count = std::max<size_t>(1, _dedup.window() / 2);
+    TSPacket pkt;
+    BitRate merge_bitrate = 0;
+
+    while (_lookahead_count < max_count && _queue.getPacket(pkt, merge_bitrate)) {
+        const PID pid = pkt.getPID();
+        if (pid == PID_NULL) {
+            // Null packets are never merged.
+        }
+        else if (_dedup.feedPacket(pkt, 1)) {
+            _lookahead[pid].push_back(LookAheadPacket(pkt, TSPacketDeduplicator::Fingerprint(pkt), _merge_count, _pkt_count));
+            _lookahead_count++;
+        }
+        else {
+            // Already output from the main stream, the main stream is at least at this position.
+            _merge_position = std::max(_merge_position, _merge_count);
+        }
+        _merge_count++;
+    }
+}
+
+
+//----------------------------------------------------------------------------
+// With deduplication, remove a packet from the main stream from the
+// look-ahead buffer. Return true if found. The preceding packets of the same
+// PID in the look-ahead buffer can no longer be inserted and are dropped.
+//----------------------------------------------------------------------------
+
+bool ts::MergePlugin::removeLookAhead(const TSPacket& pkt)
+{
+    const auto it = _lookahead.find(pkt.getPID());
+    if (it != _lookahead.end()) {
+        const uint64_t hash = TSPacketDeduplicator::Fingerprint(pkt);
+        LookAheadQueue& queue(it->second);
+        for (auto la = queue.begin(); la != queue.end(); ++la) {
+            if (la->hash == hash) {
+                const size_t late = la - queue.begin();
+                _merge_position = std::max(_merge_position, la->index);
+                queue.erase(queue.begin(), la + 1);
+                _lookahead_count -= late + 1;
+                _late_dropped += late;
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+
+//----------------------------------------------------------------------------
+// With deduplication, get the next look-ahead packet which can be inserted
+// in a free slot. A packet is inserted only when it is the next one in its
+// PID, according to the continuity counter, and when the main stream has
+// reached its position in the merged stream. The first eligible packet in
+// the order of the merged stream is returned.
+//
+// The position of the main stream in the merged stream is the index of the
+// last merged packet which was output, either by the main stream or as an
+// inserted packet. This prevents pulling the merged stream in advance into
+// the stuffing of the main stream. It also removes the ambiguity of the
+// 4-bit continuity counter: a packet which is not the next one in its PID
+// is dropped only when the main stream has passed its position. Otherwise,
+// it waits for the missing packets from the main stream. Packets which are
+// older than the deduplication window are dropped.
+//----------------------------------------------------------------------------
+
+bool ts::MergePlugin::getLookAheadPacket(TSPacket& pkt)
+{
+    const size_t window = _dedup.window();
+    auto next = _lookahead.end();
+
+    for (auto it = _lookahead.begin(); it != _lookahead.end(); ) {
+        const PID pid = it->first;
+        LookAheadQueue& queue(it->second);
+        while (!queue.empty()) {
+            const LookAheadPacket& first(queue.front());
+            // The next packet in the PID has the next CC. A packet without payload may repeat the last CC.
+            const uint8_t distance = _out_pids.test(pid) ? uint8_t((first.pkt.getCC() - _out_cc[pid]) & CC_MASK) : 1;
+            const bool in_order = distance == 1 || (distance == 0 && !first.pkt.hasPayload());
+            if (first.received + window < _pkt_count) {
+                _stale_dropped++;
+            }
+            else if (!in_order && first.index <= _merge_position) {
+                _late_dropped++;
+            }
+            else {
+                if (in_order && first.index <= _merge_position + DEDUP_MAX_ADVANCE && (next == _lookahead.end() || first.index < next->second.front().index)) {
+                    next = it;
+                }
+                break;
+            }
+            queue.pop_front();
+            _lookahead_count--;
+        }
+        if (queue.empty()) {
+            it = _lookahead.erase(it);
+        }
+        else {
+            ++it;
+        }
+    }
+
+    if (next == _lookahead.end()) {
+        return false;
+    }
+    else {
+        pkt = next->second.front().pkt;
+        _merge_position = std::max(_merge_position, next->second.front().index);
+        next->second.pop_front();
+        _lookahead_count--;
+        _recovered++;
+        _out_pids.set(pkt.getPID());
+        _out_cc[pkt.getPID()] = pkt.getCC();
+        return true;
+    }
+}
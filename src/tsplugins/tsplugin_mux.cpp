@@ -34,10 +34,12 @@
 
 #include "tsPluginRepository.h"
 #include "tsTSFile.h"
-#include "tsContinuityAnalyzer.h"
+#include "tsPIDRoutingTable.h"
 #include "tsMemory.h"
 TSDUCK_SOURCE;
 
+#define FILE_WINDOW_PACKETS 128  // Number of packets which are read and prepared at a time in the input file.
+
 
 //----------------------------------------------------------------------------
 // Plugin definition
@@ -78,7 +80,13 @@ namespace ts {
         TSPacketFormat             _file_format;  // Input file format
         TSPacketMetadata::LabelSet _setLabels;    // Labels to set on output packets.
         TSPacketMetadata::LabelSet _resetLabels;  // Labels to reset on output packets.
-        ContinuityAnalyzer         _cc_fixer;     // To fix continuity counters in mux'ed PID's
+        PIDRoutingTable            _routing;      // Precompiled PID remapping and continuity counters rewriting.
+        TSPacketVector             _window;       // Window of packets from the input file, already rewritten.
+        size_t                     _window_next;  // Index of next packet to insert in _window.
+        size_t                     _window_count; // Number of packets in _window.
+
+        // Get the next packet to insert from the input file. Return false at end of file.
+        bool getNextPacket(TSPacket& pkt);
     };
 }
 
@@ -114,7 +122,10 @@ ts::MuxPlugin::MuxPlugin(TSP* tsp_) :
     _file_format(TSPacketFormat::AUTODETECT),
     _setLabels(),
     _resetLabels(),
-    _cc_fixer(AllPIDs, tsp)
+    _routing(),
+    _window(FILE_WINDOW_PACKETS),
+    _window_next(0),
+    _window_count(0)
 {
     option(u"", 0, STRING, 1, 1);
     help(u"", u"Input transport stream file.");
@@ -268,10 +279,15 @@ bool ts::MuxPlugin::start()
         _pts_range_ok = false;
     }
 
-    // Configure the continuity counter fixing.
+    // Compile the rewriting of inserted packets.
+    _routing.reset();
+    if (_force_pid) {
+        _routing.setRemapAll(_force_pid_value);
+    }
     if (_update_cc) {
-        _cc_fixer.setGenerator(true);
+        _routing.setFlags(0, PID_MAX - 1, PIDRoutingTable::CC_REWRITE);
     }
+    _window_next = _window_count = 0;
 
     return _file.openRead(value(u""),
                           intValue<size_t>(u"repeat", 0),
@@ -373,8 +389,8 @@ ts::ProcessorPlugin::Status ts::MuxPlugin::processPacket(TSPacket& pkt, TSPacket
         return TSP_OK;
     }
 
-    // Now, it is time to insert a new packet, read it. Directly overwrite the memory area of current stuffing pkt
-    if (_file.readPackets(&pkt, nullptr, 1, *tsp) == 0) {
+    // Now, it is time to insert a new packet. Directly overwrite the memory area of current stuffing pkt
+    if (!getNextPacket(pkt)) {
         // File read error, error message already reported
         // If processing terminated, either exit or transparently pass packets
         if (tsp->useJointTermination()) {
@@ -397,18 +413,12 @@ ts::ProcessorPlugin::Status ts::MuxPlugin::processPacket(TSPacket& pkt, TSPacket
         _pts_range_ok = false; // reset _pts_range_ok signal if inter_time is specified
     }
 
-    // Get PID of new packet. Perform checks.
-    if (_force_pid) {
-        pkt.setPID(_force_pid_value);
-    }
+    // Get PID of new packet, already remapped. Perform checks.
     pid = pkt.getPID();
     if (_check_pid_conflict && _ts_pids.test(pid)) {
         tsp->error(u"PID %d (0x%X) already exists in TS, specify --pid with another value, aborting", {pid, pid});
         return TSP_END;
     }
-    if (_update_cc) {
-        _cc_fixer.feedPacket(pkt);
-    }
 
     // Next insertion point
     _pid_next_pkt += _inter_pkt;
@@ -419,3 +429,24 @@ ts::ProcessorPlugin::Status ts::MuxPlugin::processPacket(TSPacket& pkt, TSPacket
 
     return TSP_OK;
 }
+
+
+//----------------------------------------------------------------------------
+// Get the next packet to insert from the input file.
+//----------------------------------------------------------------------------
+
+bool ts::MuxPlugin::getNextPacket(TSPacket& pkt)
+{
+    // Read and prepare a new window of packets when the previous one is exhausted.
+    // The PID remapping and continuity counters are applied in bulk on the window.
+    if (_window_next >= _window_count) {
+        _window_next = 0;
+        _window_count = _file.readPackets(_window.data(), nullptr, _window.size(), *tsp);
+        _routing.apply(_window.data(), _window_count);
+    }
+    if (_window_next >= _window_count) {
+        return false;
+    }
+    pkt = _window[_window_next++];
+    return true;
+}
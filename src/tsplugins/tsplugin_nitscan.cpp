@@ -34,6 +34,7 @@
 
 #include "tsPluginRepository.h"
 #include "tsSectionDemux.h"
+#include "tsSharedSignalization.h"
 #include "tsBinaryTable.h"
 #include "tsSysUtils.h"
 #include "tsChannelFile.h"
@@ -74,6 +75,8 @@ namespace ts {
         PID           _nit_pid;         // PID for the NIT (default: read PAT)
         size_t        _nit_count;       // Number of analyzed NIT's
         SectionDemux  _demux;           // Section demux
+        SharedSignalization* _shared;   // Shared signalization demux, when used instead of _demux.
+        int           _shared_id;       // Subscription id in _shared.
         ChannelFile   _channels;        // Channel database
         UString       _channel_file;    // Name of channel configuration file.
         bool          _save_channel_file;     // Save a fresh new version of channel configuration file.
@@ -113,6 +116,8 @@ ts::NITScanPlugin::NITScanPlugin(TSP* tsp_) :
     _nit_pid(PID_NULL),
     _nit_count(0),
     _demux(duck, this),
+    _shared(nullptr),
+    _shared_id(0),
     _channels(),
     _channel_file(),
     _save_channel_file(false),
@@ -242,6 +247,18 @@ bool ts::NITScanPlugin::start()
     _demux.reset();
     _demux.addPID(_nit_pid != PID_NULL ? _nit_pid : PID(PID_PAT));
 
+    // When the NIT PID is not specified, use the shared signalization of tsp if there is one.
+    // The shared demux follows the NIT PID from the PAT, exactly like this plugin.
+    _shared = _nit_pid == PID_NULL ? tsp->sharedSignalization() : nullptr;
+    if (_shared != nullptr) {
+        _shared_id = _shared->subscribe(duck, nullptr, this);
+        _shared->addTableId(_shared_id, TID_PAT);
+        _shared->addTableId(_shared_id, TID_NIT_ACT);
+        if (_all_nits || _nit_other) {
+            _shared->addTableId(_shared_id, TID_NIT_OTH);
+        }
+    }
+
     // Initialize other states
     _nit_count = 0;
 
@@ -268,6 +285,12 @@ bool ts::NITScanPlugin::start()
 
 bool ts::NITScanPlugin::stop()
 {
+    // Release the shared signalization.
+    if (_shared != nullptr) {
+        _shared->unsubscribe(_shared_id);
+        _shared = nullptr;
+    }
+
     // Close output file
     if (!_output_name.empty()) {
         _output_stream.close();
@@ -417,8 +440,13 @@ void ts::NITScanPlugin::processNIT(const NIT& nit)
 
 ts::ProcessorPlugin::Status ts::NITScanPlugin::processPacket(TSPacket& pkt, TSPacketMetadata& pkt_data)
 {
-    // Filter interesting sections
-    _demux.feedPacket(pkt);
+    // Filter interesting sections, or get them from the shared signalization.
+    if (_shared != nullptr) {
+        _shared->deliver(_shared_id, tsp->totalPacketsInThread());
+    }
+    else {
+        _demux.feedPacket(pkt);
+    }
 
     // Exit after NIT analysis if required
     return _terminate && _nit_count > 0 ? TSP_END : TSP_OK;
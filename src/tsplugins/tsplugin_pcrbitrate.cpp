@@ -56,9 +56,12 @@ namespace ts {
         virtual Status processPacket(TSPacket&, TSPacketMetadata&) override;
 
     private:
-        PCRAnalyzer _pcr_analyzer; // PCR analysis context
-        BitRate     _bitrate;      // Last remembered bitrate (keep it signed)
-        UString     _pcr_name;     // Time stamp type name
+        PCRAnalyzer   _pcr_analyzer; // PCR analysis context
+        BitRate       _bitrate;      // Last remembered bitrate (keep it signed)
+        UString       _pcr_name;     // Time stamp type name
+        bool          _sliding;      // Use the sliding window evaluation, never reset the analysis
+        size_t        _min_pcr;      // Number of PCR between two evaluations in sliding window mode
+        PacketCounter _next_eval;    // PCR count of next evaluation in sliding window mode
 
         // PCR analysis is done permanently. Typically, the analysis of a
         // constant stream will produce different results quite often. But
@@ -83,7 +86,10 @@ ts::PCRBitratePlugin::PCRBitratePlugin(TSP* tsp_) :
     ProcessorPlugin(tsp_, u"Permanently recompute bitrate based on PCR analysis", u"[options]"),
     _pcr_analyzer(),
     _bitrate(0),
-    _pcr_name()
+    _pcr_name(),
+    _sliding(false),
+    _min_pcr(0),
+    _next_eval(0)
 {
     option(u"dts", 'd');
     help(u"dts",
@@ -102,6 +108,13 @@ ts::PCRBitratePlugin::PCRBitratePlugin(TSP* tsp_) :
          u"Stop analysis when that number of PCR are read from the required "
          u"minimum number of PID (default: " TS_STRINGIFY(DEF_MIN_PCR_CNT) u").");
 
+    option(u"sliding-window", 's');
+    help(u"sliding-window",
+         u"Permanently evaluate the bitrate using a least-squares regression over a sliding "
+         u"window of the last " + UString::Decimal(PCRAnalyzer::WINDOW_PCR_COUNT) + u" PCR's in each PID. "
+         u"A new evaluation is made every --min-pcr PCR's. By default, the bitrates between "
+         u"consecutive PCR's are averaged and the analysis is restarted after each evaluation.");
+
     option(u"min-pid", 0, POSITIVE);
     help(u"min-pid",
          u"Minimum number of PID to get PCR from (default: " TS_STRINGIFY(DEF_MIN_PID) u").");
@@ -117,6 +130,9 @@ bool ts::PCRBitratePlugin::start()
     _pcr_analyzer.setIgnoreErrors(present(u"ignore-errors"));
     const size_t min_pcr = intValue<size_t>(u"min-pcr", DEF_MIN_PCR_CNT);
     const size_t min_pid = intValue<size_t>(u"min-pid", DEF_MIN_PID);
+    _sliding = present(u"sliding-window");
+    _min_pcr = min_pcr;
+    _next_eval = 0;
     if (present(u"dts")) {
         _pcr_analyzer.resetAndUseDTS (min_pid, min_pcr);
         _pcr_name = u"DTS";
@@ -149,13 +165,21 @@ ts::ProcessorPlugin::Status ts::PCRBitratePlugin::processPacket(TSPacket& pkt, T
 {
     // Feed the packet into the PCR analyzer.
 
-    if (_pcr_analyzer.feedPacket(pkt)) {
-        // A new bitrate is available, get it and restart analysis
-        BitRate new_bitrate = _pcr_analyzer.bitrate188();
-        _pcr_analyzer.reset();
+    if (_pcr_analyzer.feedPacket(pkt) && (!_sliding || _pcr_analyzer.pcrCount() >= _next_eval)) {
+        BitRate new_bitrate = 0;
+        if (_sliding) {
+            // A new evaluation on the sliding window, keep the analysis running.
+            new_bitrate = _pcr_analyzer.windowedBitrate188();
+            _next_eval = _pcr_analyzer.pcrCount() + _min_pcr;
+        }
+        else {
+            // A new bitrate is available, get it and restart analysis
+            new_bitrate = _pcr_analyzer.bitrate188();
+            _pcr_analyzer.reset();
+        }
 
         // If the new bitrate is too close to the previous recorded one, no need to signal it.
-        if (new_bitrate != _bitrate && (new_bitrate / ::abs(int32_t(new_bitrate) - int32_t(_bitrate))) < REPORT_THRESHOLD) {
+        if (new_bitrate > 0 && new_bitrate != _bitrate && (new_bitrate / ::abs(int32_t(new_bitrate) - int32_t(_bitrate))) < REPORT_THRESHOLD) {
             // New bitrate is significantly different, signal it.
             tsp->verbose(u"new bitrate from %s analysis: %'d b/s", {_pcr_name, new_bitrate});
             _bitrate = new_bitrate;
@@ -83,6 +83,7 @@ namespace ts {
         bool lastDump(std::ostream&);
 
         // Hooks
+        virtual bool needPESPayload(PESDemux&, PID) override;
         virtual void handlePESPacket (PESDemux&, const PESPacket&) override;
         virtual void handleVideoStartCode (PESDemux&, const PESPacket&, uint8_t, size_t, size_t) override;
         virtual void handleNewVideoAttributes (PESDemux&, const PESPacket&, const VideoAttributes&) override;
@@ -359,6 +360,18 @@ bool ts::PESPlugin::lastDump(std::ostream& out)
 }
 
 
+//----------------------------------------------------------------------------
+// Invoked by the demux to check if the PES payload is needed.
+//----------------------------------------------------------------------------
+
+bool ts::PESPlugin::needPESPayload(PESDemux&, PID)
+{
+    // Only the TS packet indexes can be reported without the complete PES packet.
+    return _trace_packets || _dump_start_code || _dump_nal_units || _dump_avc_sei ||
+        _video_attributes || _audio_attributes || _min_payload >= 0 || _max_payload >= 0;
+}
+
+
 //----------------------------------------------------------------------------
 // Invoked by the demux when a complete PES packet is available.
 //----------------------------------------------------------------------------
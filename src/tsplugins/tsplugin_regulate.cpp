@@ -35,6 +35,7 @@
 #include "tsPluginRepository.h"
 #include "tsBitRateRegulator.h"
 #include "tsPCRRegulator.h"
+#include "tsPacketPacer.h"
 TSDUCK_SOURCE;
 
 #define DEF_PACKET_BURST 16
@@ -57,8 +58,12 @@ namespace ts {
 
     private:
         bool             _pcr_synchronous;
+        bool             _precise;
+        PacketCounter    _burst;
+        PacketCounter    _burst_count;
         BitRateRegulator _bitrate_regulator;
         PCRRegulator     _pcr_regulator;
+        PacketPacer      _pacer;
     };
 }
 
@@ -72,8 +77,12 @@ TS_REGISTER_PROCESSOR_PLUGIN(u"regulate", ts::RegulatePlugin);
 ts::RegulatePlugin::RegulatePlugin(TSP* tsp_) :
     ProcessorPlugin(tsp_, u"Regulate the TS packets flow based on PCR or bitrate", u"[options]"),
     _pcr_synchronous(false),
+    _precise(false),
+    _burst(0),
+    _burst_count(0),
     _bitrate_regulator(tsp, Severity::Verbose),
-    _pcr_regulator(tsp, Severity::Verbose)
+    _pcr_regulator(tsp, Severity::Verbose),
+    _pacer(tsp, Severity::Verbose)
 {
     option(u"bitrate", 'b', POSITIVE);
     help(u"bitrate",
@@ -97,6 +106,19 @@ ts::RegulatePlugin::RegulatePlugin(TSP* tsp_) :
          u"With --pcr-synchronous, specify the reference PID for PCR's. By default, "
          u"use the first PID containing PCR's.");
 
+    option(u"precise");
+    help(u"precise",
+         u"Use a precise pacing of packets. The departure time of each group of --packet-burst packets "
+         u"is computed from the bitrate or from the PCR's (with --pcr-synchronous). The plugin sleeps "
+         u"until shortly before each departure time using absolute deadlines and then actively polls "
+         u"the clock. This avoids the bursts which result from the limited precision of the system "
+         u"timers, at the expense of some CPU load. Option --wait-min is ignored.");
+
+    option(u"spin-time", 0, UINT32);
+    help(u"spin-time",
+         u"With --precise, specify the duration in microseconds of the final active polling of the "
+         u"clock before each departure. The default is " + UString::Decimal(PacketPacer::DEFAULT_SPIN_NS / NanoSecPerMicroSec) + u" microseconds.");
+
     option(u"wait-min", 'w', POSITIVE);
     help(u"wait-min",
          u"With --pcr-synchronous, specify the minimum wait time in milli-seconds. "
@@ -116,6 +138,7 @@ bool ts::RegulatePlugin::start()
     const bool has_pid = present(u"pid-pcr");
     const PID pid = intValue<PID>(u"pid-pcr", PID_NULL);
     const PacketCounter burst = intValue<PacketCounter>(u"packet-burst", DEF_PACKET_BURST);
+    const NanoSecond spin = intValue<NanoSecond>(u"spin-time", PacketPacer::DEFAULT_SPIN_NS / NanoSecPerMicroSec) * NanoSecPerMicroSec;
     const MilliSecond wait_min = intValue<MilliSecond>(u"wait-min", PCRRegulator::DEFAULT_MIN_WAIT_NS / NanoSecPerMilliSec);
 
     if (has_bitrate && _pcr_synchronous) {
@@ -127,8 +150,18 @@ bool ts::RegulatePlugin::start()
         return false;
     }
 
+    _precise = present(u"precise");
+    _burst = burst;
+    _burst_count = 0;
+
     // Initialize the appropriate regulator.
-    if (_pcr_synchronous) {
+    if (_precise) {
+        _pacer.setFixedBitRate(bitrate);
+        _pacer.setReferencePID(pid);
+        _pacer.setSpinTime(spin);
+        _pacer.reset();
+    }
+    else if (_pcr_synchronous) {
         _pcr_regulator.reset();
         _pcr_regulator.setBurstPacketCount(burst);
         _pcr_regulator.setReferencePID(pid);
@@ -152,7 +185,17 @@ ts::ProcessorPlugin::Status ts::RegulatePlugin::processPacket(TSPacket& pkt, TSP
     bool flush = false;
     bool bitrate_changed = false;
 
-    if (_pcr_synchronous) {
+    if (_precise) {
+        // Without --pcr-synchronous, do not pass the packet to ignore PCR's.
+        const Monotonic due(_pacer.departure(_pcr_synchronous ? &pkt : nullptr, 1, tsp->bitrate()));
+        // Wait for the departure time of the last packet in the burst, then release the burst.
+        if (++_burst_count >= _burst) {
+            _burst_count = 0;
+            _pacer.wait(due);
+            flush = true;
+        }
+    }
+    else if (_pcr_synchronous) {
         flush = _pcr_regulator.regulate(pkt);
     }
     else {
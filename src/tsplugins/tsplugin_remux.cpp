@@ -0,0 +1,142 @@
+//----------------------------------------------------------------------------
+//
+// TSDuck - The MPEG Transport Stream Toolkit
+// Copyright (c) 2005-2020, Thierry Lelegard
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+// THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------
+//
+//  Transport stream processor shared library:
+//  Remultiplex several input transport streams into one constant bitrate TS.
+//
+//----------------------------------------------------------------------------
+
+#include "tsPluginRepository.h"
+#include "tsRemultiplexer.h"
+TSDUCK_SOURCE;
+
+
+//----------------------------------------------------------------------------
+// Plugin definition
+//----------------------------------------------------------------------------
+
+namespace ts {
+    class RemuxInput: public InputPlugin
+    {
+        TS_NOBUILD_NOCOPY(RemuxInput);
+    public:
+        // Implementation of plugin API
+        RemuxInput(TSP*);
+        virtual bool getOptions() override;
+        virtual bool start() override;
+        virtual bool stop() override;
+        virtual bool abortInput() override;
+        virtual BitRate getBitrate() override;
+        virtual size_t receive(TSPacket*, TSPacketMetadata*, size_t) override;
+
+    private:
+        RemultiplexerArgs _args;   // Remultiplexer options.
+        Remultiplexer     _remux;  // Remultiplexer engine.
+    };
+}
+
+TS_REGISTER_INPUT_PLUGIN(u"remux", ts::RemuxInput);
+
+
+//----------------------------------------------------------------------------
+// Constructor
+//----------------------------------------------------------------------------
+
+ts::RemuxInput::RemuxInput(TSP* tsp_) :
+    InputPlugin(tsp_, u"Remultiplex several input transport streams into one constant bitrate TS", u"[options]"),
+    _args(),
+    _remux(duck, *tsp)
+{
+    _args.defineArgs(*this);
+}
+
+
+//----------------------------------------------------------------------------
+// Get command line options
+//----------------------------------------------------------------------------
+
+bool ts::RemuxInput::getOptions()
+{
+    return _args.loadArgs(duck, *this);
+}
+
+
+//----------------------------------------------------------------------------
+// Start / stop methods
+//----------------------------------------------------------------------------
+
+bool ts::RemuxInput::start()
+{
+    return _remux.start(_args);
+}
+
+bool ts::RemuxInput::stop()
+{
+    // Report the statistics of each input before stopping.
+    for (size_t i = 0; i < _args.inputs.size(); ++i) {
+        const Remultiplexer::InputStatistics& stat(_remux.inputStatistics(i));
+        tsp->verbose(u"input %d: %'d packets received, %'d sent, %'d dropped, %'d late (max %'d us)",
+                     {i, stat.received, stat.sent, stat.dropped, stat.late, (stat.max_late * MicroSecPerSec) / SYSTEM_CLOCK_FREQ});
+    }
+    tsp->verbose(u"output: %'d packets, %'d inserted null packets", {_remux.outputPackets(), _remux.nullPackets()});
+    _remux.stop();
+    return true;
+}
+
+
+//----------------------------------------------------------------------------
+// Abort the input operation currently in progress.
+//----------------------------------------------------------------------------
+
+bool ts::RemuxInput::abortInput()
+{
+    // Wake up receive() if it is waiting for packets from the input streams.
+    _remux.abort();
+    return true;
+}
+
+
+//----------------------------------------------------------------------------
+// The output bitrate is constant.
+//----------------------------------------------------------------------------
+
+ts::BitRate ts::RemuxInput::getBitrate()
+{
+    return _args.bitrate;
+}
+
+
+//----------------------------------------------------------------------------
+// Input method
+//----------------------------------------------------------------------------
+
+size_t ts::RemuxInput::receive(TSPacket* buffer, TSPacketMetadata* pkt_data, size_t max_packets)
+{
+    return _remux.getPackets(buffer, max_packets);
+}
@@ -43,6 +43,7 @@
 #include "tsBetterSystemRandomGenerator.h"
 #include "tsCADescriptor.h"
 #include "tsScramblingDescriptor.h"
+#include "tsSafePtr.h"
 TSDUCK_SOURCE;
 
 #define DEFAULT_ECM_BITRATE 30000
@@ -90,11 +91,19 @@ TSDUCK_SOURCE;
 // is negative, we immediately perform an ECM transition and we recompute the
 // time for the next CW transition. If delay_start is positive, we immediately
 // perform a CW transition and we recompute the time for the next ECM transition.
+//
+// Multiple services:
+// Several services can be scrambled by the same plugin instance. Each service
+// is described by a ScrambledService object with its own crypto-periods, control
+// words, ECM PID and scrambling engine. All services share the same ECMG connection
+// and channel, each service using its own ECM stream in that channel. ECM requests
+// from all services are asynchronously pipelined on the connection. Each packet
+// is processed once: the owner service of its PID is found using a PID-indexed
+// table and the transition points of all services are summarized in the next
+// packet index where something needs to be done.
 
 namespace ts {
-    class ScramblerPlugin:
-        public ProcessorPlugin,
-        private SignalizationHandlerInterface
+    class ScramblerPlugin: public ProcessorPlugin
     {
         TS_NOBUILD_NOCOPY(ScramblerPlugin);
     public:
@@ -106,8 +115,10 @@ namespace ts {
         virtual Status processPacket(TSPacket&, TSPacketMetadata&) override;
 
     private:
+        class ScrambledService;
+
         // Description of a crypto-period.
-        // Each CryptoPeriod object points to its ScramblerPlugin parent object.
+        // Each CryptoPeriod object points to its ScrambledService parent object.
         // In case of error in a CryptoPeriod object, the _abort volatile flag
         // is set in ScramblerPlugin.
         class CryptoPeriod: private ECMGClientHandlerInterface
@@ -120,7 +131,7 @@ namespace ts {
             // Initialize first crypto period.
             // Generate two randow CW and corresponding ECM.
             // ECM generation may complete asynchronously.
-            void initCycle(ScramblerPlugin*, uint16_t cp_number);
+            void initCycle(ScrambledService*, uint16_t cp_number);
 
             // Initialize crypto period following specified one.
             // ECM generation may complete asynchronously.
@@ -136,13 +147,13 @@ namespace ts {
             bool initScramblerKey() const;
 
         private:
-            ScramblerPlugin* _plugin;         // Reference to scrambler plugin
-            uint16_t         _cp_number;      // Crypto-period number
-            volatile bool    _ecm_ok;         // _ecm field is valid
-            TSPacketVector   _ecm;            // Packetized ECM
-            size_t           _ecm_pkt_index;  // Next ECM packet to insert in TS
-            ByteBlock        _cw_current;
-            ByteBlock        _cw_next;
+            ScrambledService* _service;        // Reference to scrambled service
+            uint16_t          _cp_number;      // Crypto-period number
+            volatile bool     _ecm_ok;         // _ecm field is valid
+            TSPacketVector    _ecm;            // Packetized ECM
+            size_t            _ecm_pkt_index;  // Next ECM packet to insert in TS
+            ByteBlock         _cw_current;
+            ByteBlock         _cw_next;
 
             // Generate the ECM for a crypto-period.
             // With --synchronous, the ECM is directly generated. Otherwise,
@@ -153,8 +164,101 @@ namespace ts {
             virtual void handleECM(const ecmgscs::ECMResponse&) override;
         };
 
+        // Description of one scrambled service (or of the explicit list of PID's).
+        class ScrambledService: private SignalizationHandlerInterface
+        {
+            TS_NOBUILD_NOCOPY(ScrambledService);
+        public:
+            // Constructor. The first service uses the scrambling engine of the plugin,
+            // the other ones use a copy of it.
+            ScrambledService(ScramblerPlugin* plugin, size_t index, const UString& service, PID ecm_pid);
+
+            // Start and stop the service. Open the ECM stream when there are ECM's.
+            bool start();
+            void stop();
+
+            // Filter sections to discover the service.
+            void feedPacket(const TSPacket& pkt) { _service.feedPacket(pkt); }
+
+            // Service characteristics.
+            bool nonExistent() const { return _service.nonExistentService(); }
+            bool hasPMT() const { return _service.hasPMT(); }
+            PID pmtPID() const { return _service.hasPMTPID() ? _service.getPMTPID() : PID(PID_NULL); }
+            bool ready() const { return _scrambled_pids.any(); }
+            PID ecmPID() const { return _ecm_pid; }
+            const PIDSet& scrambledPIDs() const { return _scrambled_pids; }
+            PacketCounter scrambledCount() const { return _scrambled_count; }
+
+            // Packet index of next CW or ECM transition, next ECM insertion.
+            PacketCounter nextTransition() const;
+            PacketCounter nextECMInsertion() const;
+
+            // Perform CW and ECM transitions when time to do so. Return false on error.
+            bool transitions();
+
+            // Replace a null packet with an ECM packet. Return false on error.
+            bool insertECM(TSPacket& pkt);
+
+            // Replace a PMT packet with a modified one. Return false if not a modified PMT packet.
+            bool updatePMT(TSPacket& pkt);
+
+            // Scramble a packet from one of the PID's of the service.
+            Status scramble(TSPacket& pkt);
+
+        private:
+            friend class CryptoPeriod;
+
+            ScramblerPlugin*  _plugin;              // Parent plugin
+            const size_t      _index;               // Index in plugin list of services
+            ServiceDiscovery  _service;             // Service description
+            uint16_t          _stream_id;           // ECM_stream_id in ECMG channel
+            uint16_t          _ecm_id;              // ECM_id of this service
+            ecmgscs::StreamStatus _stream_status;   // Initial response to ECMG stream_setup
+            PID               _user_ecm_pid;        // User-specified ECM PID
+            PID               _ecm_pid;             // PID for ECM
+            uint8_t           _ecm_cc;              // Continuity counter in ECM PID.
+            bool              _update_pmt;          // Update PMT.
+            bool              _degraded_mode;       // In degraded mode (see comments above)
+            PacketCounter     _scrambled_count;     // Summary of scrambled packets
+            PacketCounter     _partial_clear;       // How many clear packets to keep clear
+            PacketCounter     _pkt_insert_ecm;      // Insertion point for next ECM packet.
+            PacketCounter     _pkt_change_cw;       // Transition point for next CW change
+            PacketCounter     _pkt_change_ecm;      // Transition point for next ECM change
+            PIDSet            _scrambled_pids;      // List of pids to scramble
+            PIDSet            _conflict_pids;       // List of pids to scramble with scrambled input packets
+            CryptoPeriod      _cp[2];               // Previous/current or current/next crypto-periods
+            size_t            _current_cw;          // Index to current CW (current crypto period)
+            size_t            _current_ecm;         // Index to current ECM (ECM being broadcast)
+            TSScrambling      _own_scrambling;      // Scrambling engine of this service, when not the first one
+            TSScrambling&     _scrambling;          // Actual scrambling engine of this service
+            CyclingPacketizer _pzer_pmt;            // Packetizer for modified PMT
+
+            // Return current/next CryptoPeriod for CW or ECM
+            CryptoPeriod& currentCW()  { return _cp[_current_cw]; }
+            CryptoPeriod& nextCW()     { return _cp[(_current_cw + 1) & 0x01]; }
+            CryptoPeriod& currentECM() { return _cp[_current_ecm]; }
+            CryptoPeriod& nextECM()    { return _cp[(_current_ecm + 1) & 0x01]; }
+
+            // Perform CW and ECM transition
+            bool changeCW();
+            void changeECM();
+
+            // Check if we are in degraded mode or if we enter degraded mode
+            bool inDegradedMode();
+
+            // Try to exit from degraded mode
+            bool tryExitDegradedMode();
+
+            // Invoked when the PMT of the service is available.
+            virtual void handlePMT(const PMT&, PID) override;
+        };
+
+        typedef SafePtr<ScrambledService> ScrambledServicePtr;
+        typedef std::vector<ScrambledServicePtr> ScrambledServiceVector;
+
         // ScramblerPlugin parameters, remain constant after start()
-        ServiceDiscovery  _service;             // Service description
+        UStringVector     _service_names;       // Services to scramble
+        std::vector<PID>  _ecm_pids;            // User-specified ECM PID's, one per service
         bool              _use_service;         // Scramble a service (ie. not a specific list of PID's).
         bool              _component_level;     // Insert CA_descriptors at component level
         bool              _scramble_audio;      // Scramble all audio components
@@ -162,58 +266,39 @@ namespace ts {
         bool              _scramble_subtitles;  // Scramble all subtitles components
         bool              _synchronous_ecmg;    // Synchronous ECM generation
         bool              _ignore_scrambled;    // Ignore packets which are already scrambled
-        bool              _update_pmt;          // Update PMT.
         bool              _need_cp;             // Need to manage crypto-periods (ie. not one single fixed CW).
         bool              _need_ecm;            // Need to manage ECM insertion (ie. not fixed CW's).
         MilliSecond       _delay_start;         // Delay between CP start and ECM start (can be negative)
         ByteBlock         _ca_desc_private;     // Private data to insert in CA_descriptor
         BitRate           _ecm_bitrate;         // ECM PID's bitrate
-        PID               _ecm_pid;             // PID for ECM
         PacketCounter     _partial_scrambling;  // Do not scramble all packets if > 1
+        PIDSet            _fixed_pids;          // Explicit list of PID's to scramble
         ECMGClientArgs    _ecmg_args;           // Parameters for ECMG client
         tlv::Logger       _logger;              // Message logger for ECMG <=> SCS protocol
         ecmgscs::ChannelStatus _channel_status; // Initial response to ECMG channel_setup
-        ecmgscs::StreamStatus  _stream_status;  // Initial response to ECMG stream_setup
+        ecmgscs::StreamStatus  _stream_status;  // Initial response to ECMG stream_setup (first stream)
 
         // ScramblerPlugin state
         volatile bool     _abort;               // Error (service not found, etc)
-        bool              _degraded_mode;       // In degraded mode (see comments above)
+        bool              _all_ready;           // All services know their PID's to scramble
         PacketCounter     _packet_count;        // Complete TS packet counter
-        PacketCounter     _scrambled_count;     // Summary of scrambled packets
-        PacketCounter     _partial_clear;       // How many clear packets to keep clear
-        PacketCounter     _pkt_insert_ecm;      // Insertion point for next ECM packet.
-        PacketCounter     _pkt_change_cw;       // Transition point for next CW change
-        PacketCounter     _pkt_change_ecm;      // Transition point for next ECM change
+        PacketCounter     _next_transition;     // Next CW or ECM transition in any service
+        PacketCounter     _next_ecm_insert;     // Next ECM insertion in any service
         BitRate           _ts_bitrate;          // Saved TS bitrate
         ECMGClient        _ecmg;                // Connection with the ECMG
-        uint8_t           _ecm_cc;              // Continuity counter in ECM PID.
-        PIDSet            _scrambled_pids;      // List of pids to scramble
-        PIDSet            _conflict_pids;       // List of pids to scramble with scrambled input packets
         PIDSet            _input_pids;          // List of input pids
-        CryptoPeriod      _cp[2];               // Previous/current or current/next crypto-periods
-        size_t            _current_cw;          // Index to current CW (current crypto period)
-        size_t            _current_ecm;         // Index to current ECM (ECM being broadcast)
-        TSScrambling      _scrambling;          // Scrambler
-        CyclingPacketizer _pzer_pmt;            // Packetizer for modified PMT
-
-        // Return current/next CryptoPeriod for CW or ECM
-        CryptoPeriod& currentCW()  { return _cp[_current_cw]; }
-        CryptoPeriod& nextCW()     { return _cp[(_current_cw + 1) & 0x01]; }
-        CryptoPeriod& currentECM() { return _cp[_current_ecm]; }
-        CryptoPeriod& nextECM()    { return _cp[(_current_ecm + 1) & 0x01]; }
-
-        // Perform CW and ECM transition
-        bool changeCW();
-        void changeECM();
-
-        // Check if we are in degraded mode or if we enter degraded mode
-        bool inDegradedMode();
-
-        // Try to exit from degraded mode
-        bool tryExitDegradedMode();
-
-        // Invoked when the PMT of the service is available.
-        virtual void handlePMT(const PMT&, PID) override;
+        PIDSet            _pmt_pids;            // PMT PID's of all services
+        PIDSet            _allocated_ecm_pids;  // ECM PID's of all services
+        TSScrambling      _scrambling;          // Scrambler, used by first service, copied in other services
+        ScrambledServiceVector _services;       // Scrambled services
+        std::vector<size_t> _pid_owner;         // Index of service owning a scrambled PID, NPOS if none
+        std::vector<size_t> _pmt_owner;         // Index of service owning a modified PMT PID, NPOS if none
+
+        // Recompute the next transition and next ECM insertion points in all services.
+        void updateSchedule();
+
+        // Recompute the list of PMT PID's and the readiness of services after signalization changes.
+        void updateServices();
     };
 }
 
@@ -225,8 +310,9 @@ TS_REGISTER_PROCESSOR_PLUGIN(u"scrambler", ts::ScramblerPlugin);
 //----------------------------------------------------------------------------
 
 ts::ScramblerPlugin::ScramblerPlugin(TSP* tsp_) :
-    ProcessorPlugin(tsp_, u"DVB scrambler", u"[options] [service]"),
-    _service(duck, this),
+    ProcessorPlugin(tsp_, u"DVB scrambler", u"[options] [service ...]"),
+    _service_names(),
+    _ecm_pids(),
     _use_service(false),
     _component_level(false),
     _scramble_audio(false),
@@ -234,44 +320,38 @@ ts::ScramblerPlugin::ScramblerPlugin(TSP* tsp_) :
     _scramble_subtitles(false),
     _synchronous_ecmg(false),
     _ignore_scrambled(false),
-    _update_pmt(false),
     _need_cp(false),
     _need_ecm(false),
     _delay_start(0),
     _ca_desc_private(),
     _ecm_bitrate(0),
-    _ecm_pid(PID_NULL),
     _partial_scrambling(0),
+    _fixed_pids(),
     _ecmg_args(),
     _logger(Severity::Debug, tsp_),
     _channel_status(),
     _stream_status(),
     _abort(false),
-    _degraded_mode(false),
+    _all_ready(false),
     _packet_count(0),
-    _scrambled_count(0),
-    _partial_clear(0),
-    _pkt_insert_ecm(0),
-    _pkt_change_cw(0),
-    _pkt_change_ecm(0),
+    _next_transition(0),
+    _next_ecm_insert(0),
     _ts_bitrate(0),
     _ecmg(ASYNC_HANDLER_EXTRA_STACK_SIZE),
-    _ecm_cc(0),
-    _scrambled_pids(),
-    _conflict_pids(),
     _input_pids(),
-    _cp(),
-    _current_cw(0),
-    _current_ecm(0),
+    _pmt_pids(),
+    _allocated_ecm_pids(),
     _scrambling(*tsp),
-    _pzer_pmt(duck)
+    _services(),
+    _pid_owner(),
+    _pmt_owner()
 {
     // We need to define character sets to specify service names.
     duck.defineArgsForCharset(*this);
 
-    option(u"", 0, STRING, 0, 1);
+    option(u"", 0, STRING, 0, UNLIMITED_COUNT);
     help(u"",
-         u"Specifies the optional service to scramble. If no service is specified, a "
+         u"Specifies the optional services to scramble. If no service is specified, a "
          u"list of PID's to scramble must be provided using --pid options. When PID's "
          u"are provided, fixed control words must be specified as well.\n\n"
          u"If no fixed CW is specified, a random CW is generated for each crypto-period "
@@ -280,7 +360,13 @@ ts::ScramblerPlugin::ScramblerPlugin(TSP* tsp_) :
          u"If the argument is an integer value (either decimal or hexadecimal), it is "
          u"interpreted as a service id. Otherwise, it is interpreted as a service name, "
          u"as specified in the SDT. The name is not case sensitive and blanks are "
-         u"ignored. If the input TS does not contain an SDT, use service ids only.");
+         u"ignored. If the input TS does not contain an SDT, use service ids only.\n\n"
+         u"Several services can be specified. Each service is scrambled with its own "
+         u"control words and ECM's. All services share the same connection and channel "
+         u"with the ECMG. Each service uses its own ECM stream in that channel: the "
+         u"ECM_stream_id and ECM_id of the Nth service (starting at zero) are the values "
+         u"of --ecm-stream-id and --ecm-id plus N. When --output-cw-file is specified, "
+         u"only the control words of the first service are saved.");
 
     option(u"bitrate-ecm", 'b', POSITIVE);
     help(u"bitrate-ecm",
@@ -300,12 +386,12 @@ ts::ScramblerPlugin::ScramblerPlugin(TSP* tsp_) :
 
     option(u"no-audio");
     help(u"no-audio",
-         u"Do not scramble audio components in the selected service. By default, "
+         u"Do not scramble audio components in the selected services. By default, "
          u"all audio components are scrambled.");
 
     option(u"no-video");
     help(u"no-video",
-         u"Do not scramble video components in the selected service. By default, "
+         u"Do not scramble video components in the selected services. By default, "
          u"all video components are scrambled.");
 
     option(u"partial-scrambling", 0, POSITIVE);
@@ -320,12 +406,13 @@ ts::ScramblerPlugin::ScramblerPlugin(TSP* tsp_) :
          u"Scramble packets with these PID values. Several -p or --pid options may be "
          u"specified. By default, scramble the specified service.");
 
-    option(u"pid-ecm", 0, PIDVAL);
+    option(u"pid-ecm", 0, PIDVAL, 0, UNLIMITED_COUNT);
     help(u"pid-ecm",
          u"Specifies the new ECM PID for the service. By defaut, use the first "
          u"unused PID immediately following the PMT PID. Using the default, there "
          u"is a risk to later discover that this PID is already used. In that case, "
-         u"specify --pid-ecm with a notoriously unused PID value.");
+         u"specify --pid-ecm with a notoriously unused PID value. When several services "
+         u"are scrambled, this option can be specified once per service, in the same order.");
 
     option(u"private-data", 0, STRING);
     help(u"private-data",
@@ -334,7 +421,7 @@ ts::ScramblerPlugin::ScramblerPlugin(TSP* tsp_) :
 
     option(u"subtitles");
     help(u"subtitles",
-         u"Scramble subtitles components in the selected service. By default, the "
+         u"Scramble subtitles components in the selected services. By default, the "
          u"subtitles components are not scrambled.");
 
     option(u"synchronous");
@@ -358,8 +445,9 @@ bool ts::ScramblerPlugin::getOptions()
     // Plugin parameters.
     duck.loadArgs(*this);
     _use_service = present(u"");
-    _service.set(value(u""));
-    getIntValues(_scrambled_pids, u"pid");
+    getValues(_service_names, u"");
+    getIntValues(_fixed_pids, u"pid");
+    getIntValues(_ecm_pids, u"pid-ecm");
     _synchronous_ecmg = present(u"synchronous") || !tsp->realtime();
     _component_level = present(u"component-level");
     _scramble_audio = !present(u"no-audio");
@@ -367,7 +455,6 @@ bool ts::ScramblerPlugin::getOptions()
     _scramble_subtitles = present(u"subtitles");
     _partial_scrambling = intValue<PacketCounter>(u"partial-scrambling", 1);
     _ignore_scrambled = present(u"ignore-scrambled");
-    _ecm_pid = intValue<PID>(u"pid-ecm", PID_NULL);
     _ecm_bitrate = intValue<BitRate>(u"bitrate-ecm", DEFAULT_ECM_BITRATE);
 
     // Decode hexa data.
@@ -387,17 +474,23 @@ bool ts::ScramblerPlugin::getOptions()
     _logger.setSeverity(ecmgscs::Tags::ECM_response, _ecmg_args.log_data);
 
     // Scramble either a service or a list of PID's, not a mixture of them.
-    if ((_use_service + _scrambled_pids.any()) != 1) {
+    if ((_use_service + _fixed_pids.any()) != 1) {
         tsp->error(u"specify either a service or a list of PID's");
         return false;
     }
 
     // To scramble a fixed list of PID's, we need fixed control words, otherwise the random CW's are lost.
-    if (_scrambled_pids.any() && !_scrambling.hasFixedCW()) {
+    if (_fixed_pids.any() && !_scrambling.hasFixedCW()) {
         tsp->error(u"specify control words to scramble an explicit list of PID's");
         return false;
     }
 
+    // ECM PID's are specified per service.
+    if (_ecm_pids.size() > std::max<size_t>(1, _service_names.size())) {
+        tsp->error(u"too many --pid-ecm options, at most one per service");
+        return false;
+    }
+
     // Do we need to manage crypto-periods and ECM insertion?
     _need_cp = _scrambling.fixedCWCount() != 1;
     _need_ecm = _use_service && !_scrambling.hasFixedCW();
@@ -415,25 +508,23 @@ bool ts::ScramblerPlugin::getOptions()
 bool ts::ScramblerPlugin::start()
 {
     // Reset states
-    _conflict_pids.reset();
     _packet_count = 0;
-    _scrambled_count = 0;
-    _ecm_cc = 0;
     _abort = false;
-    _degraded_mode = false;
+    _all_ready = false;
     _ts_bitrate = 0;
-    _pkt_insert_ecm = 0;
-    _pkt_change_cw = 0;
-    _pkt_change_ecm = 0;
-    _partial_clear = 0;
-    _update_pmt = false;
+    _next_transition = 0;
+    _next_ecm_insert = 0;
     _delay_start = 0;
-    _current_cw = 0;
-    _current_ecm = 0;
+    _pmt_pids.reset();
+    _allocated_ecm_pids.reset();
+    _pid_owner.assign(PID_MAX, NPOS);
+    _pmt_owner.assign(PID_MAX, NPOS);
 
-    // Initialize the scrambling engine.
-    if (!_scrambling.start()) {
-        return false;
+    // Initialize the list of used pids. Preset reserved PIDs.
+    _input_pids.reset();
+    _input_pids.set(PID_NULL);
+    for (PID pid = 0; pid <= 0x001F; ++pid) {
+        _input_pids.set(pid);
     }
 
     // Initialize ECMG.
@@ -460,28 +551,30 @@ bool ts::ScramblerPlugin::start()
                 return false;
             }
             tsp->debug(u"crypto-period duration: %'d ms, delay start: %'d ms", {_ecmg_args.cp_duration, _delay_start});
-
-            // Create first and second crypto-periods
-            _cp[0].initCycle(this, 0);
-            if (!_cp[0].initScramblerKey()) {
-                return false;
-            }
-            _cp[1].initNext(_cp[0]);
         }
     }
 
-    // The PMT will be modified, initialize the PMT packetizer.
-    // Note that even without ECMG we may need to add a scrambling_descriptor in the PMT.
-    _pzer_pmt.reset();
-    _pzer_pmt.setStuffingPolicy(CyclingPacketizer::ALWAYS);
+    // Create the scrambled services. Without service, one single context for the explicit list of PID's.
+    _services.clear();
+    const size_t count = std::max<size_t>(1, _service_names.size());
+    for (size_t i = 0; i < count; ++i) {
+        _services.push_back(ScrambledServicePtr(new ScrambledService(this,
+                                                                     i,
+                                                                     i < _service_names.size() ? _service_names[i] : UString(),
+                                                                     i < _ecm_pids.size() ? _ecm_pids[i] : PID(PID_NULL))));
+    }
 
-    // Initialize the list of used pids. Preset reserved PIDs.
-    _input_pids.reset();
-    _input_pids.set(PID_NULL);
-    for (PID pid = 0; pid <= 0x001F; ++pid) {
-        _input_pids.set(pid);
+    // Start all services: open ECM streams and start generating the first ECM's.
+    for (size_t i = 0; i < _services.size(); ++i) {
+        if (!_services[i]->start()) {
+            return false;
+        }
     }
 
+    // With an explicit list of PID's, we already know what to scramble.
+    updateServices();
+    updateSchedule();
+
     return !_abort;
 }
 
@@ -497,26 +590,290 @@ bool ts::ScramblerPlugin::stop()
         _ecmg.disconnect();
     }
 
-    // Terminate the scrambling engine.
-    _scrambling.stop();
+    // Terminate the scrambling engines.
+    for (size_t i = 0; i < _services.size(); ++i) {
+        _services[i]->stop();
+        tsp->debug(u"service %d: scrambled %'d packets in %'d PID's", {i, _services[i]->scrambledCount(), _services[i]->scrambledPIDs().count()});
+    }
+    _services.clear();
+    return true;
+}
+
+
+//----------------------------------------------------------------------------
+// Recompute the list of PMT PID's and the readiness of services.
+//----------------------------------------------------------------------------
+
+void ts::ScramblerPlugin::updateServices()
+{
+    _all_ready = true;
+    _pmt_pids.reset();
+    for (size_t i = 0; i < _services.size(); ++i) {
+        const ScrambledService& srv(*_services[i]);
+        _all_ready = _all_ready && srv.ready();
+        if (srv.pmtPID() != PID_NULL) {
+            _pmt_pids.set(srv.pmtPID());
+        }
+    }
+}
+
+
+//----------------------------------------------------------------------------
+// Recompute the next transition and ECM insertion points in all services.
+//----------------------------------------------------------------------------
+
+void ts::ScramblerPlugin::updateSchedule()
+{
+    _next_transition = std::numeric_limits<PacketCounter>::max();
+    _next_ecm_insert = std::numeric_limits<PacketCounter>::max();
+    for (size_t i = 0; i < _services.size(); ++i) {
+        _next_transition = std::min(_next_transition, _services[i]->nextTransition());
+        _next_ecm_insert = std::min(_next_ecm_insert, _services[i]->nextECMInsertion());
+    }
+}
+
+
+//----------------------------------------------------------------------------
+// Packet processing method
+//----------------------------------------------------------------------------
+
+ts::ProcessorPlugin::Status ts::ScramblerPlugin::processPacket(TSPacket& pkt, TSPacketMetadata& pkt_data)
+{
+    // Count packets
+    _packet_count++;
+
+    // Track all input PIDs
+    const PID pid = pkt.getPID();
+    _input_pids.set(pid);
+
+    // Maintain bitrate, keep previous one if unknown
+    const BitRate br = tsp->bitrate();
+    if (br != 0) {
+        _ts_bitrate = br;
+    }
+
+    // Filter interesting sections to discover the services.
+    // Once all PMT's are known, only the signalization PID's need to be filtered.
+    if (_use_service && (!_all_ready || pid <= PID_DVB_LAST || pid >= PID_PSIP_TS_E || _pmt_pids.test(pid))) {
+        for (size_t i = 0; i < _services.size(); ++i) {
+            _services[i]->feedPacket(pkt);
+            // If the service is definitely unknown, give up.
+            if (_services[i]->nonExistent()) {
+                return TSP_END;
+            }
+        }
+        updateServices();
+        updateSchedule();
+    }
+
+    // If a fatal error occured during PMT analysis, give up.
+    if (_abort) {
+        return TSP_END;
+    }
+
+    // Abort if an allocated PID for ECM is already present in TS.
+    if (_allocated_ecm_pids.test(pid)) {
+        tsp->error(u"ECM PID allocation conflict, used 0x%X, now found as input PID, try another --pid-ecm", {pid});
+        return TSP_END;
+    }
+
+    // As long as we do not know which PID's to scramble, nullify all packets.
+    // Let predefined PID pass however since we do not need to modify the PAT, SDT, etc.
+    // The only modified PSI/SI are the PMT's of the services, not in this PID range.
+    if (!_all_ready) {
+        return pid <= PID_DVB_LAST ? TSP_OK : TSP_NULL;
+    }
+
+    // Packetize modified PMT when needed.
+    const size_t pmt_owner = _pmt_owner[pid];
+    if (pmt_owner != NPOS && _services[pmt_owner]->updatePMT(pkt)) {
+        return TSP_OK;
+    }
+
+    // Is it time to apply the next control word or to start broadcasting the next ECM in some service?
+    if (_packet_count >= _next_transition) {
+        for (size_t i = 0; i < _services.size(); ++i) {
+            if (!_services[i]->transitions()) {
+                return TSP_END;
+            }
+        }
+        updateSchedule();
+    }
+
+    // Insert an ECM packet (replace a null packet) when time to do so.
+    // Select the service which is the most late in its ECM insertion.
+    if (pid == PID_NULL && _packet_count >= _next_ecm_insert) {
+        ScrambledService* srv = nullptr;
+        for (size_t i = 0; i < _services.size(); ++i) {
+            if (srv == nullptr || _services[i]->nextECMInsertion() < srv->nextECMInsertion()) {
+                srv = _services[i].pointer();
+            }
+        }
+        assert(srv != nullptr);
+        // Note that return false means unrecoverable error here.
+        const bool ok = srv->insertECM(pkt);
+        updateSchedule();
+        return ok ? TSP_OK : TSP_END;
+    }
+
+    // If the packet has no payload or its PID is not to be scrambled, there is nothing to do.
+    const size_t owner = _pid_owner[pid];
+    if (owner == NPOS || !pkt.hasPayload()) {
+        return TSP_OK;
+    }
+
+    // Scramble the packet payload, using the scrambling engine of its service.
+    return _services[owner]->scramble(pkt);
+}
+
+
+//----------------------------------------------------------------------------
+// ScrambledService constructor.
+//----------------------------------------------------------------------------
+
+ts::ScramblerPlugin::ScrambledService::ScrambledService(ScramblerPlugin* plugin, size_t index, const UString& service, PID ecm_pid) :
+    _plugin(plugin),
+    _index(index),
+    _service(plugin->duck, this),
+    _stream_id(uint16_t(plugin->_ecmg_args.ecm_stream_id + index)),
+    _ecm_id(uint16_t(plugin->_ecmg_args.ecm_id + index)),
+    _stream_status(),
+    _user_ecm_pid(ecm_pid),
+    _ecm_pid(ecm_pid),
+    _ecm_cc(0),
+    _update_pmt(false),
+    _degraded_mode(false),
+    _scrambled_count(0),
+    _partial_clear(0),
+    _pkt_insert_ecm(0),
+    _pkt_change_cw(0),
+    _pkt_change_ecm(0),
+    _scrambled_pids(),
+    _conflict_pids(),
+    _cp(),
+    _current_cw(0),
+    _current_ecm(0),
+    _own_scrambling(plugin->_scrambling),
+    _scrambling(index == 0 ? plugin->_scrambling : _own_scrambling),
+    _pzer_pmt(plugin->duck)
+{
+    if (!service.empty()) {
+        _service.set(service);
+    }
+}
+
+
+//----------------------------------------------------------------------------
+// Start the scrambled service.
+//----------------------------------------------------------------------------
+
+bool ts::ScramblerPlugin::ScrambledService::start()
+{
+    _ecm_pid = _user_ecm_pid;
+    _ecm_cc = 0;
+    _update_pmt = false;
+    _degraded_mode = false;
+    _scrambled_count = 0;
+    _partial_clear = 0;
+    _pkt_insert_ecm = 0;
+    _pkt_change_cw = 0;
+    _pkt_change_ecm = 0;
+    _current_cw = 0;
+    _current_ecm = 0;
+    _conflict_pids.reset();
+
+    // Without service, scramble the explicit list of PID's.
+    if (!_plugin->_use_service) {
+        _scrambled_pids = _plugin->_fixed_pids;
+        for (PID pid = 0; pid < PID_MAX; ++pid) {
+            if (_scrambled_pids.test(pid)) {
+                _plugin->_pid_owner[pid] = _index;
+            }
+        }
+    }
+    else {
+        _scrambled_pids.reset();
+    }
+
+    // Initialize the scrambling engine.
+    if (!_scrambling.start()) {
+        return false;
+    }
+
+    if (_plugin->_need_ecm) {
+        // The first ECM stream was opened by ECMGClient::connect(), open the other ones.
+        if (_index == 0) {
+            _stream_status = _plugin->_stream_status;
+        }
+        else if (!_plugin->_ecmg.addStream(_stream_id, _ecm_id, _plugin->_ecmg_args.cp_duration, _stream_status)) {
+            return false;
+        }
+        _stream_id = _stream_status.stream_id;
+
+        // Create first and second crypto-periods
+        _cp[0].initCycle(this, 0);
+        if (!_cp[0].initScramblerKey()) {
+            return false;
+        }
+        _cp[1].initNext(_cp[0]);
+    }
+
+    // The PMT will be modified, initialize the PMT packetizer.
+    // Note that even without ECMG we may need to add a scrambling_descriptor in the PMT.
+    _pzer_pmt.reset();
+    _pzer_pmt.setStuffingPolicy(CyclingPacketizer::ALWAYS);
 
-    tsp->debug(u"scrambled %'d packets in %'d PID's", {_scrambled_count, _scrambled_pids.count()});
     return true;
 }
 
 
+//----------------------------------------------------------------------------
+// Stop the scrambled service.
+//----------------------------------------------------------------------------
+
+void ts::ScramblerPlugin::ScrambledService::stop()
+{
+    _scrambling.stop();
+}
+
+
+//----------------------------------------------------------------------------
+// Next transition points.
+//----------------------------------------------------------------------------
+
+ts::PacketCounter ts::ScramblerPlugin::ScrambledService::nextTransition() const
+{
+    PacketCounter next = std::numeric_limits<PacketCounter>::max();
+    if (ready()) {
+        if (_plugin->_need_cp) {
+            next = std::min(next, _pkt_change_cw);
+        }
+        if (_plugin->_need_ecm) {
+            next = std::min(next, _pkt_change_ecm);
+        }
+    }
+    return next;
+}
+
+ts::PacketCounter ts::ScramblerPlugin::ScrambledService::nextECMInsertion() const
+{
+    return _plugin->_need_ecm && ready() ? _pkt_insert_ecm : std::numeric_limits<PacketCounter>::max();
+}
+
+
 //----------------------------------------------------------------------------
 //  This method processes the PMT of the service.
 //----------------------------------------------------------------------------
 
-void ts::ScramblerPlugin::handlePMT(const PMT& table, PID)
+void ts::ScramblerPlugin::ScrambledService::handlePMT(const PMT& table, PID)
 {
-    assert(_use_service);
+    assert(_plugin->_use_service);
+    Report* const report = _plugin->tsp;
 
     // We need to know the bitrate in order to schedule crypto-periods or ECM insertion.
-    if (_ts_bitrate == 0 && (_need_cp || _need_ecm)) {
-        tsp->error(u"unknown bitrate, cannot schedule crypto-periods");
-        _abort = true;
+    if (_plugin->_ts_bitrate == 0 && (_plugin->_need_cp || _plugin->_need_ecm)) {
+        report->error(u"unknown bitrate, cannot schedule crypto-periods");
+        _plugin->_abort = true;
         return;
     }
 
@@ -524,88 +881,105 @@ void ts::ScramblerPlugin::handlePMT(const PMT& table, PID)
     PMT pmt(table);
 
     // Collect all PIDS to scramble.
+    for (PID pid = 0; pid < PID_MAX; ++pid) {
+        if (_scrambled_pids.test(pid) && _plugin->_pid_owner[pid] == _index) {
+            _plugin->_pid_owner[pid] = NPOS;
+        }
+    }
     _scrambled_pids.reset();
     for (PMT::StreamMap::const_iterator it = pmt.streams.begin(); it != pmt.streams.end(); ++it) {
         const PID pid = it->first;
         const PMT::Stream& stream(it->second);
-        _input_pids.set(pid);
-        if ((_scramble_audio && stream.isAudio()) || (_scramble_video && stream.isVideo()) || (_scramble_subtitles && stream.isSubtitles())) {
+        _plugin->_input_pids.set(pid);
+        if ((_plugin->_scramble_audio && stream.isAudio()) || (_plugin->_scramble_video && stream.isVideo()) || (_plugin->_scramble_subtitles && stream.isSubtitles())) {
+            if (_plugin->_pid_owner[pid] != NPOS) {
+                report->warning(u"PID 0x%X is shared with another scrambled service, not scrambled in service 0x%X", {pid, pmt.service_id});
+                continue;
+            }
             _scrambled_pids.set(pid);
-            tsp->verbose(u"starting scrambling PID 0x%X", {pid});
+            _plugin->_pid_owner[pid] = _index;
+            report->verbose(u"starting scrambling PID 0x%X", {pid});
         }
     }
 
     // Check that we have somethng to scramble.
     if (_scrambled_pids.none()) {
-        tsp->error(u"no PID to scramble in service");
-        _abort = true;
+        report->error(u"no PID to scramble in service 0x%X", {pmt.service_id});
+        _plugin->_abort = true;
         return;
     }
 
     // Allocate a PID value for ECM if necessary
-    if (_need_ecm && _ecm_pid == PID_NULL) {
+    if (_plugin->_need_ecm && _ecm_pid == PID_NULL) {
         // Start at service PMT PID, then look for an unused one.
-        for (_ecm_pid = _service.getPMTPID() + 1; _ecm_pid < PID_NULL && _input_pids.test(_ecm_pid); _ecm_pid++) {}
+        for (_ecm_pid = _service.getPMTPID() + 1; _ecm_pid < PID_NULL && (_plugin->_input_pids.test(_ecm_pid) || _plugin->_allocated_ecm_pids.test(_ecm_pid)); _ecm_pid++) {}
         if (_ecm_pid >= PID_NULL) {
-            tsp->error(u"cannot find an unused PID for ECM, try --pid-ecm");
-            _abort = true;
+            report->error(u"cannot find an unused PID for ECM, try --pid-ecm");
+            _plugin->_abort = true;
         }
         else {
-            tsp->verbose(u"using PID %d (0x%X) for ECM", {_ecm_pid, _ecm_pid});
+            report->verbose(u"using PID %d (0x%X) for ECM", {_ecm_pid, _ecm_pid});
         }
     }
+    if (_plugin->_need_ecm && _ecm_pid < PID_NULL) {
+        _plugin->_allocated_ecm_pids.set(_ecm_pid);
+    }
 
     // Add a scrambling_descriptor in the PMT for scrambling other than DVB-CSA2.
     if (_scrambling.scramblingType() != SCRAMBLING_DVB_CSA2) {
         _update_pmt = true;
-        pmt.descs.add(duck, ScramblingDescriptor(_scrambling.scramblingType()));
+        pmt.descs.add(_plugin->duck, ScramblingDescriptor(_scrambling.scramblingType()));
     }
 
     // With ECM generation, modify the PMT
-    if (_need_ecm) {
+    if (_plugin->_need_ecm) {
         _update_pmt = true;
 
         // Create a CA_descriptor
-        CADescriptor ca_desc((_ecmg_args.super_cas_id >> 16) & 0xFFFF, _ecm_pid);
-        ca_desc.private_data = _ca_desc_private;
+        CADescriptor ca_desc((_plugin->_ecmg_args.super_cas_id >> 16) & 0xFFFF, _ecm_pid);
+        ca_desc.private_data = _plugin->_ca_desc_private;
 
         // Add the CA_descriptor at program level or component level
-        if (_component_level) {
+        if (_plugin->_component_level) {
             // Add a CA_descriptor in each scrambled component
             for (PMT::StreamMap::iterator it = pmt.streams.begin(); it != pmt.streams.end(); ++it) {
                 if (_scrambled_pids.test(it->first)) {
-                    it->second.descs.add(duck, ca_desc);
+                    it->second.descs.add(_plugin->duck, ca_desc);
                 }
             }
         }
         else {
             // Add one single CA_descriptor at program level
-            pmt.descs.add(duck, ca_desc);
+            pmt.descs.add(_plugin->duck, ca_desc);
         }
     }
 
     // Packetize the modified PMT
     if (_update_pmt) {
+        if (_pzer_pmt.getPID() < PID_MAX && _plugin->_pmt_owner[_pzer_pmt.getPID()] == _index) {
+            _plugin->_pmt_owner[_pzer_pmt.getPID()] = NPOS;
+        }
         _pzer_pmt.removeSections(TID_PMT, pmt.service_id);
         _pzer_pmt.setPID(_service.getPMTPID());
-        _pzer_pmt.addTable(duck, pmt);
+        _pzer_pmt.addTable(_plugin->duck, pmt);
+        _plugin->_pmt_owner[_service.getPMTPID()] = _index;
     }
 
     // Next crypto-period.
-    if (_need_cp) {
-        _pkt_change_cw = _packet_count + PacketDistance(_ts_bitrate, _ecmg_args.cp_duration);
+    if (_plugin->_need_cp) {
+        _pkt_change_cw = _plugin->_packet_count + PacketDistance(_plugin->_ts_bitrate, _plugin->_ecmg_args.cp_duration);
     }
 
     // Initialize ECM insertion.
-    if (_need_ecm) {
+    if (_plugin->_need_ecm) {
 
         // Insert current ECM packets as soon as possible.
-        _pkt_insert_ecm = _packet_count;
+        _pkt_insert_ecm = _plugin->_packet_count;
 
         // Next ECM may start before or after next crypto-period
-        _pkt_change_ecm = _delay_start > 0 ?
-            _pkt_change_cw + PacketDistance(_ts_bitrate, _delay_start) :
-            _pkt_change_cw - PacketDistance(_ts_bitrate, _delay_start);
+        _pkt_change_ecm = _plugin->_delay_start > 0 ?
+            _pkt_change_cw + PacketDistance(_plugin->_ts_bitrate, _plugin->_delay_start) :
+            _pkt_change_cw - PacketDistance(_plugin->_ts_bitrate, _plugin->_delay_start);
     }
 }
 
@@ -614,9 +988,9 @@ void ts::ScramblerPlugin::handlePMT(const PMT& table, PID)
 // Check if we are in degraded mode or if we enter degraded mode
 //----------------------------------------------------------------------------
 
-bool ts::ScramblerPlugin::inDegradedMode()
+bool ts::ScramblerPlugin::ScrambledService::inDegradedMode()
 {
-    if (!_need_ecm) {
+    if (!_plugin->_need_ecm) {
         // No ECM, no degraded mode.
         return false;
     }
@@ -630,7 +1004,7 @@ bool ts::ScramblerPlugin::inDegradedMode()
     }
     else {
         // Entering degraded mode
-        tsp->warning(u"Next ECM not ready, entering degraded mode");
+        _plugin->tsp->warning(u"Next ECM not ready, entering degraded mode");
         return _degraded_mode = true;
     }
 }
@@ -640,13 +1014,13 @@ bool ts::ScramblerPlugin::inDegradedMode()
 // Try to exit from degraded mode
 //----------------------------------------------------------------------------
 
-bool ts::ScramblerPlugin::tryExitDegradedMode()
+bool ts::ScramblerPlugin::ScrambledService::tryExitDegradedMode()
 {
     // If not in degraded mode, nothing to do
     if (!_degraded_mode) {
         return true;
     }
-    assert(_need_ecm);
+    assert(_plugin->_need_ecm);
 
     // We are in degraded mode. If next ECM not yet ready, stay degraded
     if (!nextECM().ecmReady()) {
@@ -654,15 +1028,15 @@ bool ts::ScramblerPlugin::tryExitDegradedMode()
     }
 
     // Next ECM is ready, at last. Exit degraded mode.
-    tsp->info(u"Next ECM ready, exiting from degraded mode");
+    _plugin->tsp->info(u"Next ECM ready, exiting from degraded mode");
     _degraded_mode = false;
 
     // Compute next CW and ECM change.
-    if (_delay_start < 0) {
+    if (_plugin->_delay_start < 0) {
         // Start broadcasting ECM before beginning of crypto-period, ie. now
         changeECM();
         // Postpone CW change
-        _pkt_change_cw = _packet_count + PacketDistance(_ts_bitrate, _delay_start);
+        _pkt_change_cw = _plugin->_packet_count + PacketDistance(_plugin->_ts_bitrate, _plugin->_delay_start);
     }
     else {
         // Change CW now.
@@ -670,7 +1044,7 @@ bool ts::ScramblerPlugin::tryExitDegradedMode()
             return false;
         }
         // Start broadcasting ECM after beginning of crypto-period
-        _pkt_change_ecm = _packet_count + PacketDistance(_ts_bitrate, _delay_start);
+        _pkt_change_ecm = _plugin->_packet_count + PacketDistance(_plugin->_ts_bitrate, _plugin->_delay_start);
     }
 
     return true;
@@ -678,10 +1052,24 @@ bool ts::ScramblerPlugin::tryExitDegradedMode()
 
 
 //----------------------------------------------------------------------------
-// Perform crypto-period transition, for CW or ECM
+// Perform crypto-period transitions, for CW or ECM
 //----------------------------------------------------------------------------
 
-bool ts::ScramblerPlugin::changeCW()
+bool ts::ScramblerPlugin::ScrambledService::transitions()
+{
+    // Is it time to apply the next control word ?
+    if (_plugin->_need_cp && _plugin->_packet_count >= _pkt_change_cw && !changeCW()) {
+        return false;
+    }
+
+    // Is it time to start broadcasting the next ECM ?
+    if (_plugin->_need_ecm && _plugin->_packet_count >= _pkt_change_ecm) {
+        changeECM();
+    }
+    return true;
+}
+
+bool ts::ScramblerPlugin::ScrambledService::changeCW()
 {
     if (_scrambling.hasFixedCW()) {
         // A list of fixed CW was loaded from a file.
@@ -690,8 +1078,8 @@ bool ts::ScramblerPlugin::changeCW()
         _current_cw = (_current_cw + 1) & 0x01;
 
         // Determine new transition point.
-        if (_need_cp) {
-            _pkt_change_cw = _packet_count + PacketDistance(_ts_bitrate, _ecmg_args.cp_duration);
+        if (_plugin->_need_cp) {
+            _pkt_change_cw = _plugin->_packet_count + PacketDistance(_plugin->_ts_bitrate, _plugin->_ecmg_args.cp_duration);
         }
 
         // Set next crypto-period key.
@@ -710,28 +1098,28 @@ bool ts::ScramblerPlugin::changeCW()
         }
 
         // Determine new transition point.
-        if (_need_cp) {
-            _pkt_change_cw = _packet_count + PacketDistance(_ts_bitrate, _ecmg_args.cp_duration);
+        if (_plugin->_need_cp) {
+            _pkt_change_cw = _plugin->_packet_count + PacketDistance(_plugin->_ts_bitrate, _plugin->_ecmg_args.cp_duration);
         }
 
         // Generate (or start generating) next ECM when using ECM(N) in cp(N)
-        if (_need_ecm && _current_ecm == _current_cw) {
+        if (_plugin->_need_ecm && _current_ecm == _current_cw) {
             nextCW().initNext(currentCW());
         }
     }
     return true;
 }
 
-void ts::ScramblerPlugin::changeECM()
+void ts::ScramblerPlugin::ScrambledService::changeECM()
 {
     // Allowed to change CW only if not in degraded mode
-    if (_need_ecm && !inDegradedMode()) {
+    if (_plugin->_need_ecm && !inDegradedMode()) {
 
         // Point to next crypto-period
         _current_ecm = (_current_ecm + 1) & 0x01;
 
         // Determine new transition point
-        _pkt_change_ecm = _packet_count + PacketDistance(_ts_bitrate, _ecmg_args.cp_duration);
+        _pkt_change_ecm = _plugin->_packet_count + PacketDistance(_plugin->_ts_bitrate, _plugin->_ecmg_args.cp_duration);
 
         // Generate (or start generating) next ECM when using ECM(N) in cp(N)
         if (_current_ecm == _current_cw) {
@@ -742,97 +1130,61 @@ void ts::ScramblerPlugin::changeECM()
 
 
 //----------------------------------------------------------------------------
-// Packet processing method
+// Replace a null packet with an ECM packet.
 //----------------------------------------------------------------------------
 
-ts::ProcessorPlugin::Status ts::ScramblerPlugin::processPacket(TSPacket& pkt, TSPacketMetadata& pkt_data)
+bool ts::ScramblerPlugin::ScrambledService::insertECM(TSPacket& pkt)
 {
-    // Count packets
-    _packet_count++;
-
-    // Track all input PIDs
-    const PID pid = pkt.getPID();
-    _input_pids.set(pid);
-
-    // Maintain bitrate, keep previous one if unknown
-    const BitRate br = tsp->bitrate();
-    if (br != 0) {
-        _ts_bitrate = br;
-    }
+    // Compute next insertion point (approximate)
+    assert(_plugin->_ecm_bitrate != 0);
+    _pkt_insert_ecm += BitRate(_plugin->_ts_bitrate / _plugin->_ecm_bitrate);
 
-    // Filter interesting sections to discover the service.
-    if (_use_service) {
-        _service.feedPacket(pkt);
+    // Try to exit from degraded mode, if we were in.
+    // Note that return false means unrecoverable error here.
+    if (!tryExitDegradedMode()) {
+        return false;
     }
 
-    // If the service is definitely unknown or a fatal error occured during PMT analysis, give up.
-    if (_abort || _service.nonExistentService()) {
-        return TSP_END;
-    }
+    // Replace current null packet with an ECM packet
+    currentECM().getNextECMPacket(pkt);
+    return true;
+}
 
-    // Abort if allocated PID for ECM is already present in TS.
-    if (_ecm_pid != PID_NULL && pid == _ecm_pid) {
-        tsp->error(u"ECM PID allocation conflict, used 0x%X, now found as input PID, try another --pid-ecm", {pid});
-        return TSP_END;
-    }
 
-    // As long as we do not know which PID's to scramble, nullify all packets.
-    // Let predefined PID pass however since we do not need to modify the PAT, SDT, etc.
-    // The only modified PSI/SI is the PMT of the service, not in this PID range.
-    if (_scrambled_pids.none()) {
-        return pid <= PID_DVB_LAST ? TSP_OK : TSP_NULL;
-    }
+//----------------------------------------------------------------------------
+// Replace a PMT packet with a modified one.
+//----------------------------------------------------------------------------
 
-    // Packetize modified PMT when needed.
-    if (_update_pmt && pid == _pzer_pmt.getPID()) {
+bool ts::ScramblerPlugin::ScrambledService::updatePMT(TSPacket& pkt)
+{
+    if (_update_pmt && pkt.getPID() == _pzer_pmt.getPID()) {
         _pzer_pmt.getNextPacket(pkt);
-        return TSP_OK;
-    }
-
-    // Is it time to apply the next control word ?
-    if (_need_cp && _packet_count >= _pkt_change_cw && !changeCW()) {
-        return TSP_END;
+        return true;
     }
-
-    // Is it time to start broadcasting the next ECM ?
-    if (_need_ecm && _packet_count >= _pkt_change_ecm) {
-        changeECM();
+    else {
+        return false;
     }
+}
 
-    // Insert an ECM packet (replace a null packet) when time to do so
-    if (_need_ecm && pid == PID_NULL && _packet_count >= _pkt_insert_ecm) {
-
-        // Compute next insertion point (approximate)
-        assert(_ecm_bitrate != 0);
-        _pkt_insert_ecm += BitRate(_ts_bitrate / _ecm_bitrate);
-
-        // Try to exit from degraded mode, if we were in.
-        // Note that return false means unrecoverable error here.
-        if (!tryExitDegradedMode()) {
-            return TSP_END;
-        }
-
-        // Replace current null packet with an ECM packet
-        currentECM().getNextECMPacket(pkt);
-        return TSP_OK;
-    }
 
-    // If the packet has no payload or its PID is not to be scrambled, there is nothing to do.
-    if (!pkt.hasPayload() || !_scrambled_pids.test(pid)) {
-        return TSP_OK;
-    }
+//----------------------------------------------------------------------------
+// Scramble a packet from one of the PID's of the service.
+//----------------------------------------------------------------------------
 
+ts::ProcessorPlugin::Status ts::ScramblerPlugin::ScrambledService::scramble(TSPacket& pkt)
+{
     // If packet is already scrambled, error or ignore (do not modify packet)
     if (pkt.isScrambled()) {
-        if (_ignore_scrambled) {
+        const PID pid = pkt.getPID();
+        if (_plugin->_ignore_scrambled) {
             if (!_conflict_pids.test(pid)) {
-                tsp->verbose(u"found input scrambled packets in PID %d (0x%X), ignored", {pid, pid});
+                _plugin->tsp->verbose(u"found input scrambled packets in PID %d (0x%X), ignored", {pid, pid});
                 _conflict_pids.set(pid);
             }
             return TSP_OK;
         }
         else {
-            tsp->error(u"packet already scrambled in PID %d (0x%X)", {pid, pid});
+            _plugin->tsp->error(u"packet already scrambled in PID %d (0x%X)", {pid, pid});
             return TSP_END;
         }
     }
@@ -845,7 +1197,7 @@ ts::ProcessorPlugin::Status ts::ScramblerPlugin::processPacket(TSPacket& pkt, TS
     }
     else {
         // Scramble this packet and reinit subsequent number of packets to keep clear
-        _partial_clear = _partial_scrambling - 1;
+        _partial_clear = _plugin->_partial_scrambling - 1;
     }
 
     // Scramble the packet payload.
@@ -863,7 +1215,7 @@ ts::ProcessorPlugin::Status ts::ScramblerPlugin::processPacket(TSPacket& pkt, TS
 //----------------------------------------------------------------------------
 
 ts::ScramblerPlugin::CryptoPeriod::CryptoPeriod() :
-    _plugin(nullptr),
+    _service(nullptr),
     _cp_number(0),
     _ecm_ok(false),
     _ecm(),
@@ -878,14 +1230,14 @@ ts::ScramblerPlugin::CryptoPeriod::CryptoPeriod() :
 // Initialize first crypto period.
 //----------------------------------------------------------------------------
 
-void ts::ScramblerPlugin::CryptoPeriod::initCycle(ScramblerPlugin* scrambler, uint16_t cp_number)
+void ts::ScramblerPlugin::CryptoPeriod::initCycle(ScrambledService* service, uint16_t cp_number)
 {
-    _plugin = scrambler;
+    _service = service;
     _cp_number = cp_number;
 
-    if (_plugin->_need_ecm) {
-        BetterSystemRandomGenerator::Instance()->readByteBlock(_cw_current, _plugin->_scrambling.cwSize());
-        BetterSystemRandomGenerator::Instance()->readByteBlock(_cw_next,_plugin->_scrambling.cwSize());
+    if (_service->_plugin->_need_ecm) {
+        BetterSystemRandomGenerator::Instance()->readByteBlock(_cw_current, _service->_scrambling.cwSize());
+        BetterSystemRandomGenerator::Instance()->readByteBlock(_cw_next, _service->_scrambling.cwSize());
         generateECM();
     }
 }
@@ -897,12 +1249,12 @@ void ts::ScramblerPlugin::CryptoPeriod::initCycle(ScramblerPlugin* scrambler, ui
 
 void ts::ScramblerPlugin::CryptoPeriod::initNext(const CryptoPeriod& previous)
 {
-    _plugin = previous._plugin;
+    _service = previous._service;
     _cp_number = previous._cp_number + 1;
 
-    if (_plugin->_need_ecm) {
+    if (_service->_plugin->_need_ecm) {
         _cw_current = previous._cw_next;
-        BetterSystemRandomGenerator::Instance()->readByteBlock(_cw_next, _plugin->_scrambling.cwSize());
+        BetterSystemRandomGenerator::Instance()->readByteBlock(_cw_next, _service->_scrambling.cwSize());
         generateECM();
     }
 }
@@ -916,8 +1268,8 @@ bool ts::ScramblerPlugin::CryptoPeriod::initScramblerKey() const
 {
     // Change the parity of the scrambled packets.
     // Set our random current control word if no fixed CW.
-    return _plugin->_scrambling.setEncryptParity(_cp_number) &&
-        (!_plugin->_need_ecm || _plugin->_scrambling.setCW(_cw_current, _cp_number));
+    return _service->_scrambling.setEncryptParity(_cp_number) &&
+        (!_service->_plugin->_need_ecm || _service->_scrambling.setCW(_cw_current, _cp_number));
 }
 
 
@@ -927,36 +1279,39 @@ bool ts::ScramblerPlugin::CryptoPeriod::initScramblerKey() const
 
 void ts::ScramblerPlugin::CryptoPeriod::generateECM()
 {
+    ScramblerPlugin* const plugin = _service->_plugin;
     _ecm_ok = false;
 
-    if (_plugin->_synchronous_ecmg) {
+    if (plugin->_synchronous_ecmg) {
         // Synchronous ECM generation
         ecmgscs::ECMResponse response;
-        if (!_plugin->_ecmg.generateECM(_cp_number,
-                                        _cw_current,
-                                        _cw_next,
-                                        _plugin->_ecmg_args.access_criteria,
-                                        uint16_t(_plugin->_ecmg_args.cp_duration / 100),
-                                        response))
+        if (!plugin->_ecmg.generateECM(_service->_stream_id,
+                                       _cp_number,
+                                       _cw_current,
+                                       _cw_next,
+                                       plugin->_ecmg_args.access_criteria,
+                                       uint16_t(plugin->_ecmg_args.cp_duration / 100),
+                                       response))
         {
             // Error, message already reported
-            _plugin->_abort = true;
+            plugin->_abort = true;
         }
         else {
             handleECM(response);
         }
     }
     else {
-        // Asynchronous ECM generation
-        if (!_plugin->_ecmg.submitECM(_cp_number,
-                                      _cw_current,
-                                      _cw_next,
-                                      _plugin->_ecmg_args.access_criteria,
-                                      uint16_t(_plugin->_ecmg_args.cp_duration / 100),
-                                      this))
+        // Asynchronous ECM generation. Requests from all services are pipelined on the ECMG connection.
+        if (!plugin->_ecmg.submitECM(_service->_stream_id,
+                                     _cp_number,
+                                     _cw_current,
+                                     _cw_next,
+                                     plugin->_ecmg_args.access_criteria,
+                                     uint16_t(plugin->_ecmg_args.cp_duration / 100),
+                                     this))
         {
             // Error, message already reported
-            _plugin->_abort = true;
+            plugin->_abort = true;
         }
     }
 }
@@ -968,24 +1323,26 @@ void ts::ScramblerPlugin::CryptoPeriod::generateECM()
 
 void ts::ScramblerPlugin::CryptoPeriod::handleECM(const ecmgscs::ECMResponse& response)
 {
-    if (_plugin->_channel_status.section_TSpkt_flag == 0) {
+    ScramblerPlugin* const plugin = _service->_plugin;
+
+    if (plugin->_channel_status.section_TSpkt_flag == 0) {
         // ECMG returns ECM in section format
         SectionPtr sp(new Section(response.ECM_datagram));
         if (!sp->isValid()) {
-            _plugin->tsp->error(u"ECMG returned an invalid ECM section (%d bytes)", {response.ECM_datagram.size()});
-            _plugin->_abort = true;
+            plugin->tsp->error(u"ECMG returned an invalid ECM section (%d bytes)", {response.ECM_datagram.size()});
+            plugin->_abort = true;
             return;
         }
         // Packetize the section
-        OneShotPacketizer pzer(_plugin->duck, _plugin->_ecm_pid, true);
+        OneShotPacketizer pzer(plugin->duck, _service->_ecm_pid, true);
         pzer.addSection(sp);
         pzer.getPackets(_ecm);
 
     }
     else if (response.ECM_datagram.size() % PKT_SIZE != 0) {
         // ECMG returns ECM in packet format, but not an integral number of packets
-        _plugin->tsp->error(u"invalid ECM size (%d bytes), not a multiple of %d", {response.ECM_datagram.size(), PKT_SIZE});
-        _plugin->_abort = true;
+        plugin->tsp->error(u"invalid ECM size (%d bytes), not a multiple of %d", {response.ECM_datagram.size(), PKT_SIZE});
+        plugin->_abort = true;
         return;
     }
     else {
@@ -994,7 +1351,7 @@ void ts::ScramblerPlugin::CryptoPeriod::handleECM(const ecmgscs::ECMResponse& re
         ::memcpy(&_ecm[0].b, response.ECM_datagram.data(), response.ECM_datagram.size());  // Flawfinder: ignore: memcpy()
     }
 
-    _plugin->tsp->debug(u"got ECM for crypto-period %d, %d packets", {_cp_number, _ecm.size()});
+    plugin->tsp->debug(u"got ECM for stream %d, crypto-period %d, %d packets", {_service->_stream_id, _cp_number, _ecm.size()});
 
     _ecm_pkt_index = 0;
 
@@ -1022,8 +1379,8 @@ void ts::ScramblerPlugin::CryptoPeriod::getNextECMPacket(TSPacket& pkt)
             _ecm_pkt_index = 0;
         }
         // Adjust PID and continuity counter in TS packet
-        pkt.setPID(_plugin->_ecm_pid);
-        pkt.setCC(_plugin->_ecm_cc);
-        _plugin->_ecm_cc = (_plugin->_ecm_cc + 1) & 0x0F;
+        pkt.setPID(_service->_ecm_pid);
+        pkt.setCC(_service->_ecm_cc);
+        _service->_ecm_cc = (_service->_ecm_cc + 1) & 0x0F;
     }
 }
@@ -37,6 +37,7 @@
 #include "tsT2MIDescriptor.h"
 #include "tsT2MIPacket.h"
 #include "tsTSFile.h"
+#include "tsTSOutputThread.h"
 #include "tsNames.h"
 TSDUCK_SOURCE;
 
@@ -64,6 +65,10 @@ namespace ts {
         // Set of identified T2-MI PID's with their PLP's (with --identify).
         typedef std::map<PID, PLPSet> IdentifiedSet;
 
+        // Per-PLP outputs, each one with its own queue and thread (with --plp-*).
+        typedef SafePtr<TSOutputThread> TSOutputThreadPtr;
+        typedef std::map<uint8_t, TSOutputThreadPtr> PLPOutputMap;
+
         // Plugin private fields.
         bool              _abort;           // Error, abort asap.
         bool              _extract;         // Extract encapsulated TS.
@@ -77,6 +82,13 @@ namespace ts {
         TSFile::OpenFlags _outfile_flags;   // Open flags for output file.
         UString           _outfile_name;    // Output file name.
         TSFile            _outfile;         // Output file for extracted stream.
+        bool              _split;           // Extract all PLP's into separate outputs.
+        UString           _plp_file;        // Template file name for per-PLP output files.
+        UString           _plp_udp;         // Base UDP destination for per-PLP outputs.
+        UString           _plp_fork;        // Template command for per-PLP forked processes.
+        size_t            _plp_queue_size;  // Size in packets of each per-PLP output queue.
+        SocketAddress     _plp_udp_addr;    // Resolved base UDP destination.
+        PLPOutputMap      _plp_outputs;     // Per-PLP outputs.
         PacketCounter     _t2mi_count;      // Number of input T2-MI packets.
         PacketCounter     _ts_count;        // Number of extracted TS packets.
         T2MIDemux         _demux;           // T2-MI demux.
@@ -87,6 +99,10 @@ namespace ts {
         virtual void handleT2MINewPID(T2MIDemux& demux, const PMT& pmt, PID pid, const T2MIDescriptor& desc) override;
         virtual void handleT2MIPacket(T2MIDemux& demux, const T2MIPacket& pkt) override;
         virtual void handleTSPacket(T2MIDemux& demux, const T2MIPacket& t2mi, const TSPacket& ts) override;
+        virtual void handleTSPackets(T2MIDemux& demux, const T2MIPacket& t2mi, const TSPacket* packets, size_t count) override;
+
+        // Create the output for a PLP (with --plp-*).
+        TSOutputThreadPtr openPLPOutput(uint8_t plp);
     };
 }
 
@@ -112,6 +128,13 @@ ts::T2MIPlugin::T2MIPlugin(TSP* tsp_) :
     _outfile_flags(TSFile::NONE),
     _outfile_name(),
     _outfile(),
+    _split(false),
+    _plp_file(),
+    _plp_udp(),
+    _plp_fork(),
+    _plp_queue_size(TSOutputThread::DEFAULT_QUEUE_SIZE),
+    _plp_udp_addr(),
+    _plp_outputs(),
     _t2mi_count(0),
     _ts_count(0),
     _demux(duck, this),
@@ -120,8 +143,8 @@ ts::T2MIPlugin::T2MIPlugin(TSP* tsp_) :
 {
     option(u"append", 'a');
     help(u"append",
-         u"With --output-file, if the file already exists, append to the end of the "
-         u"file. By default, existing files are overwritten.");
+         u"With --output-file or --plp-output-file, if the file already exists, append "
+         u"to the end of the file. By default, existing files are overwritten.");
 
     option(u"extract", 'e');
     help(u"extract",
@@ -138,8 +161,8 @@ ts::T2MIPlugin::T2MIPlugin(TSP* tsp_) :
 
     option(u"keep", 'k');
     help(u"keep",
-         u"With --output-file, keep existing file (abort if the specified file "
-         u"already exists). By default, existing files are overwritten.");
+         u"With --output-file or --plp-output-file, keep existing file (abort if the "
+         u"specified file already exists). By default, existing files are overwritten.");
 
     option(u"log", 'l');
     help(u"log", u"Log all T2-MI packets using one single summary line per packet.");
@@ -158,7 +181,38 @@ ts::T2MIPlugin::T2MIPlugin(TSP* tsp_) :
     help(u"plp",
          u"Specify the PLP (Physical Layer Pipe) to extract from the T2-MI "
          u"encapsulation. By default, use the first PLP which is found. "
-         u"Ignored if --extract is not used.");
+         u"Ignored if --extract is not used or if all PLP's are extracted "
+         u"using --plp-output-file, --plp-udp or --plp-fork.");
+
+    option(u"plp-fork", 0, STRING);
+    help(u"plp-fork", u"'command'",
+         u"Extract all PLP's in one pass. The extracted stream of each PLP is sent "
+         u"to a separate process which is created using the specified command. "
+         u"Each occurence of the string %plp% in the command is replaced by the "
+         u"PLP number. The main transport stream is passed unchanged to the next plugin.");
+
+    option(u"plp-output-file", 0, STRING);
+    help(u"plp-output-file", u"filename",
+         u"Extract all PLP's in one pass. The extracted stream of each PLP is saved "
+         u"in a separate file. The name of each file is built from the specified "
+         u"name with a '_plpN' suffix before the extension, where N is the PLP number. "
+         u"The main transport stream is passed unchanged to the next plugin.");
+
+    option(u"plp-queue-size", 0, POSITIVE);
+    help(u"plp-queue-size",
+         u"With --plp-output-file, --plp-udp or --plp-fork, specify the size in TS "
+         u"packets of the output queue of each PLP. Each PLP output runs in its own "
+         u"thread. When an output is too slow, its queue fills up and the excess "
+         u"packets of this PLP are dropped, without impact on the other PLP's. "
+         u"The default is " + UString::Decimal(TSOutputThread::DEFAULT_QUEUE_SIZE) + u" packets.");
+
+    option(u"plp-udp", 0, STRING);
+    help(u"plp-udp", u"address:port",
+         u"Extract all PLP's in one pass. The extracted stream of each PLP is sent "
+         u"to a separate UDP destination, 7 TS packets per datagram. The stream of "
+         u"PLP N is sent to the specified IP address and to the specified port plus N. "
+         u"Since a PLP id can be up to 255, the port must not be greater than 65280. "
+         u"The main transport stream is passed unchanged to the next plugin.");
 }
 
 
@@ -176,6 +230,25 @@ bool ts::T2MIPlugin::getOptions()
     _plp = intValue<uint8_t>(u"plp");
     _plp_valid = present(u"plp");
     getValue(_outfile_name, u"output-file");
+    getValue(_plp_file, u"plp-output-file");
+    getValue(_plp_udp, u"plp-udp");
+    getValue(_plp_fork, u"plp-fork");
+    _plp_queue_size = intValue<size_t>(u"plp-queue-size", TSOutputThread::DEFAULT_QUEUE_SIZE);
+    _split = !_plp_file.empty() || !_plp_udp.empty() || !_plp_fork.empty();
+
+    if (int(!_outfile_name.empty()) + int(!_plp_file.empty()) + int(!_plp_udp.empty()) + int(!_plp_fork.empty()) > 1) {
+        tsp->error(u"options --output-file, --plp-output-file, --plp-udp and --plp-fork are mutually exclusive");
+        return false;
+    }
+    if (!_plp_udp.empty() && (!_plp_udp_addr.resolve(_plp_udp, *tsp) || !_plp_udp_addr.hasAddress() || !_plp_udp_addr.hasPort())) {
+        tsp->error(u"invalid UDP destination for --plp-udp: %s", {_plp_udp});
+        return false;
+    }
+    // The PLP id is added to the port, the 16-bit port number shall not wrap for any PLP.
+    if (!_plp_udp.empty() && _plp_udp_addr.port() > 0xFFFF - 0xFF) {
+        tsp->error(u"UDP port %d too high for --plp-udp, the port plus the PLP id must not exceed 65535, use a port up to %d", {_plp_udp_addr.port(), 0xFFFF - 0xFF});
+        return false;
+    }
 
     // Output file open flags.
     _outfile_flags = TSFile::WRITE | TSFile::SHARED;
@@ -188,12 +261,12 @@ bool ts::T2MIPlugin::getOptions()
 
     // Extract is the default operation.
     // It is also implicit if an output file is specified.
-    if ((!_extract && !_log && !_identify) || !_outfile_name.empty()) {
+    if ((!_extract && !_log && !_identify) || !_outfile_name.empty() || _split) {
         _extract = true;
     }
 
     // Replace the TS if no output file is present.
-    _replace_ts = _extract && _outfile_name.empty();
+    _replace_ts = _extract && _outfile_name.empty() && !_split;
     return true;
 }
 
@@ -213,6 +286,7 @@ bool ts::T2MIPlugin::start()
     // Reset the packet output.
     _identified.clear();
     _ts_queue.clear();
+    _plp_outputs.clear();
     _t2mi_count = 0;
     _ts_count = 0;
     _abort = false;
@@ -233,6 +307,16 @@ bool ts::T2MIPlugin::stop()
         _outfile.close(*tsp);
     }
 
+    // Flush and close all per-PLP outputs.
+    for (auto it = _plp_outputs.begin(); it != _plp_outputs.end(); ++it) {
+        if (!it->second.isNull()) {
+            it->second->close(*tsp);
+            tsp->verbose(u"PLP %d: extracted %'d TS packets, %'d dropped on output overflow", {it->first, it->second->packetCount(), it->second->overflowCount()});
+            _ts_count += it->second->packetCount();
+        }
+    }
+    _plp_outputs.clear();
+
     // With --extract, display a summary.
     if (_extract) {
         tsp->verbose(u"extracted %'d TS packets from %'d T2-MI packets", {_ts_count, _t2mi_count});
@@ -313,7 +397,11 @@ void ts::T2MIPlugin::handleT2MIPacket(T2MIDemux& demux, const T2MIPacket& pkt)
     }
 
     // Select PLP when extraction is requested.
-    if (_extract && pid == _extract_pid && hasPLP) {
+    if (_extract && pid == _extract_pid && hasPLP && _split) {
+        // All PLP's are extracted.
+        _t2mi_count++;
+    }
+    else if (_extract && pid == _extract_pid && hasPLP) {
         if (!_plp_valid) {
             // The PLP was not yet specified, use this one by default.
             _plp = plp;
@@ -361,6 +449,63 @@ void ts::T2MIPlugin::handleTSPacket(T2MIDemux& demux, const T2MIPacket& t2mi, co
 }
 
 
+//----------------------------------------------------------------------------
+// Process a batch of extracted TS packets from the same T2-MI packet.
+//----------------------------------------------------------------------------
+
+void ts::T2MIPlugin::handleTSPackets(T2MIDemux& demux, const T2MIPacket& t2mi, const TSPacket* packets, size_t count)
+{
+    if (!_split) {
+        // One single PLP is extracted, process packets one by one.
+        T2MIHandlerInterface::handleTSPackets(demux, t2mi, packets, count);
+    }
+    else if (_extract && !_abort && t2mi.getSourcePID() == _extract_pid) {
+        // Route the packets to the output of their PLP, create it on first use.
+        const uint8_t plp = t2mi.plp();
+        TSOutputThreadPtr& out(_plp_outputs[plp]);
+        if (out.isNull()) {
+            out = openPLPOutput(plp);
+        }
+        // The write operation never blocks, a slow output drops its own packets.
+        _abort = out.isNull() || !out->write(packets, count);
+    }
+}
+
+
+//----------------------------------------------------------------------------
+// Create the output for a PLP.
+//----------------------------------------------------------------------------
+
+ts::T2MIPlugin::TSOutputThreadPtr ts::T2MIPlugin::openPLPOutput(uint8_t plp)
+{
+    TSOutputThreadPtr out(new TSOutputThread(_plp_queue_size));
+    bool ok = false;
+
+    if (!_plp_file.empty()) {
+        const UString name(PathPrefix(_plp_file) + UString::Format(u"_plp%d", {plp}) + PathSuffix(_plp_file));
+        tsp->verbose(u"extracting PLP %d to file %s", {plp, name});
+        ok = out->openFile(name, _outfile_flags, *tsp);
+    }
+    else if (!_plp_udp.empty()) {
+        SocketAddress dest(_plp_udp_addr);
+        dest.setPort(uint16_t(_plp_udp_addr.port() + plp));
+        tsp->verbose(u"extracting PLP %d to UDP %s", {plp, dest});
+        ok = out->openUDP(dest, UString(), 0, TSOutputThread::DEFAULT_UDP_PACKETS, *tsp);
+    }
+    else if (!_plp_fork.empty()) {
+        UString command(_plp_fork);
+        command.substitute(u"%plp%", UString::Format(u"%d", {plp}));
+        tsp->verbose(u"extracting PLP %d to command %s", {plp, command});
+        ok = out->openFork(command, false, *tsp);
+    }
+
+    if (!ok) {
+        out.clear();
+    }
+    return out;
+}
+
+
 //----------------------------------------------------------------------------
 // Packet processing method
 //----------------------------------------------------------------------------
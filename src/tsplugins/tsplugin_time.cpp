@@ -34,6 +34,7 @@
 
 #include "tsPluginRepository.h"
 #include "tsSectionDemux.h"
+#include "tsSharedSignalization.h"
 #include "tsBinaryTable.h"
 #include "tsEnumeration.h"
 #include "tsTime.h"
@@ -53,6 +54,7 @@ namespace ts {
         // Implementation of plugin API
         TimePlugin(TSP*);
         virtual bool start() override;
+        virtual bool stop() override;
         virtual Status processPacket(TSPacket&, TSPacketMetadata&) override;
 
     private:
@@ -79,6 +81,8 @@ namespace ts {
         Time              _last_time;    // Last measured time
         const Enumeration _status_names; // Names of packet status
         SectionDemux      _demux;        // Section filter
+        SharedSignalization* _shared;    // Shared signalization demux, when used instead of _demux.
+        int               _shared_id;    // Subscription id in _shared.
         TimeEventVector   _events;       // Sorted list of time events to apply
         size_t            _next_index;   // Index of next TimeEvent to apply
 
@@ -106,6 +110,8 @@ ts::TimePlugin::TimePlugin (TSP* tsp_) :
     _last_time(Time::Epoch),
     _status_names({{u"pass", TSP_OK}, {u"stop", TSP_END}, {u"drop", TSP_DROP}, {u"null", TSP_NULL}}),
     _demux(duck, this),
+    _shared(nullptr),
+    _shared_id(0),
     _events(),
     _next_index(0)
 {
@@ -189,9 +195,14 @@ bool ts::TimePlugin::start()
         }
     }
 
-    // Reinitialize the demux
+    // Reinitialize the demux, use the shared signalization of tsp if there is one.
     _demux.reset();
-    if (_use_tdt) {
+    _shared = _use_tdt ? tsp->sharedSignalization() : nullptr;
+    if (_shared != nullptr) {
+        _shared_id = _shared->subscribe(duck, nullptr, this);
+        _shared->addTableId(_shared_id, TID_TDT);
+    }
+    else if (_use_tdt) {
         _demux.addPID(PID_TDT);
     }
 
@@ -202,6 +213,20 @@ bool ts::TimePlugin::start()
 }
 
 
+//----------------------------------------------------------------------------
+// Stop method
+//----------------------------------------------------------------------------
+
+bool ts::TimePlugin::stop()
+{
+    if (_shared != nullptr) {
+        _shared->unsubscribe(_shared_id);
+        _shared = nullptr;
+    }
+    return true;
+}
+
+
 //----------------------------------------------------------------------------
 // Add time events in the list fro one option.
 // Return false if a time string is invalid
@@ -265,8 +290,13 @@ void ts::TimePlugin::handleTable(SectionDemux& demux, const BinaryTable& table)
 
 ts::ProcessorPlugin::Status ts::TimePlugin::processPacket(TSPacket& pkt, TSPacketMetadata& pkt_data)
 {
-    // Filter sections
-    _demux.feedPacket(pkt);
+    // Filter sections, or get them from the shared signalization.
+    if (_shared != nullptr) {
+        _shared->deliver(_shared_id, tsp->totalPacketsInThread());
+    }
+    else {
+        _demux.feedPacket(pkt);
+    }
 
     // Get current system time (unless TDT is used as reference)
     if (!_use_tdt) {
@@ -94,6 +94,8 @@ ts::TimeShiftPlugin::TimeShiftPlugin (TSP* tsp_) :
     help(u"memory-packets",
          u"Specify the number of packets which are cached in memory. "
          u"Having a larger memory cache improves the performances. "
+         u"When the buffer is larger than the memory cache, the cache is split into four "
+         u"blocks, the temporary file is read and written by complete blocks in a background thread. "
          u"By default, the size of the memory cache is " +
          UString::Decimal(TimeShiftBuffer::DEFAULT_MEMORY_PACKETS) + u" packets.");
 
@@ -37,6 +37,8 @@
 #include "tsTSFile.h"
 #include "tsPagerArgs.h"
 #include "tsDuckContext.h"
+#include "tsFileBatch.h"
+#include "tsjsonNumber.h"
 TSDUCK_SOURCE;
 TS_MAIN(MainCode);
 
@@ -55,6 +57,7 @@ namespace {
         ts::DuckContext       duck;      // TSDuck execution context.
         ts::BitRate           bitrate;   // Expected bitrate (188-byte packets)
         ts::UString           infile;    // Input file name
+        ts::FileBatch         batch;     // Batch processing of multiple files.
         ts::TSPacketFormat    format;    // Input file format.
         ts::TSAnalyzerOptions analysis;  // Analysis options.
         ts::PagerArgs         pager;     // Output paging options.
@@ -62,10 +65,11 @@ namespace {
 }
 
 Options::Options(int argc, char *argv[]) :
-    ts::Args(u"Analyze the structure of a transport stream", u"[options] [filename]"),
+    ts::Args(u"Analyze the structure of a transport stream", u"[options] [filename ...]"),
     duck(this),
     bitrate(0),
     infile(),
+    batch(u".txt"),
     format(ts::TSPacketFormat::AUTODETECT),
     analysis(),
     pager(true, true)
@@ -75,9 +79,13 @@ Options::Options(int argc, char *argv[]) :
     duck.defineArgsForCharset(*this);
     pager.defineArgs(*this);
     analysis.defineArgs(*this);
+    batch.defineArgs(*this);
 
-    option(u"", 0, STRING, 0, 1);
-    help(u"", u"Input transport stream file (standard input if omitted).");
+    option(u"", 0, STRING, 0, UNLIMITED_COUNT);
+    help(u"", u"Input transport stream files (standard input if omitted). "
+         u"When more than one file is specified, wildcards are allowed and "
+         u"all files are analyzed concurrently in batch mode. The standard "
+         u"input cannot be used in batch mode.");
 
     option(u"bitrate", 'b', UNSIGNED);
     help(u"bitrate",
@@ -99,8 +107,20 @@ Options::Options(int argc, char *argv[]) :
     duck.loadArgs(*this);
     pager.loadArgs(duck, *this);
     analysis.loadArgs(duck, *this);
-
-    infile = value(u"");
+    batch.loadArgs(duck, *this);
+
+    ts::UStringVector files;
+    getValues(files, u"");
+    if (files.size() > 1 || batch.batchMode()) {
+        batch.addFiles(files, *this);
+        // The standard input cannot be processed in batch mode.
+        if (batch.files.empty()) {
+            error(u"no input file in batch mode, specify input files or --file-list");
+        }
+    }
+    else {
+        infile = value(u"");
+    }
     bitrate = intValue<ts::BitRate>(u"bitrate");
     format = enumValue<ts::TSPacketFormat>(u"format", ts::TSPacketFormat::AUTODETECT);
 
@@ -108,6 +128,82 @@ Options::Options(int argc, char *argv[]) :
 }
 
 
+//----------------------------------------------------------------------------
+//  Analyze one file.
+//----------------------------------------------------------------------------
+
+namespace {
+    bool AnalyzeFile(ts::DuckContext& duck, const Options& opt, const ts::UString& fileName, std::ostream& out, ts::Report& report, ts::json::Object* summary)
+    {
+        // Configure the TS analyzer.
+        ts::TSAnalyzerReport analyzer(duck, opt.bitrate);
+        analyzer.setAnalysisOptions(opt.analysis);
+
+        // Open the TS file.
+        ts::TSFile file;
+        if (!file.openRead(fileName, 1, 0, report, opt.format)) {
+            return false;
+        }
+
+        // Analyze all packets in the file.
+        ts::TSPacket pkt;
+        uint64_t count = 0;
+        while (file.readPackets(&pkt, nullptr, 1, report) > 0) {
+            analyzer.feedPacket(pkt);
+            count++;
+        }
+        file.close(report);
+
+        // Display analysis results.
+        analyzer.report(out, opt.analysis);
+
+        // Characteristic values for the batch summary.
+        if (summary != nullptr) {
+            std::vector<uint16_t> services;
+            std::vector<ts::PID> pids;
+            analyzer.getServiceIds(services);
+            analyzer.getPIDs(pids);
+            summary->add(u"packets", ts::json::ValuePtr(new ts::json::Number(int64_t(count))));
+            summary->add(u"services", ts::json::ValuePtr(new ts::json::Number(int64_t(services.size()))));
+            summary->add(u"pids", ts::json::ValuePtr(new ts::json::Number(int64_t(pids.size()))));
+        }
+        return true;
+    }
+}
+
+
+//----------------------------------------------------------------------------
+//  Batch mode: analyze each file in a worker thread with its own context.
+//----------------------------------------------------------------------------
+
+namespace {
+    class BatchAnalyzer: public ts::FileBatchHandlerInterface
+    {
+        TS_NOBUILD_NOCOPY(BatchAnalyzer);
+    public:
+        explicit BatchAnalyzer(const Options& opt);
+        virtual bool handleBatchFile(ts::FileBatch& batch, const ts::UString& fileName, std::ostream& output, ts::json::Object& summary, ts::Report& report) override;
+    private:
+        const Options& _opt;
+        ts::DuckContext::SavedArgs _duck_args;
+    };
+}
+
+BatchAnalyzer::BatchAnalyzer(const Options& opt) :
+    _opt(opt),
+    _duck_args()
+{
+    _opt.duck.saveArgs(_duck_args);
+}
+
+bool BatchAnalyzer::handleBatchFile(ts::FileBatch& batch, const ts::UString& fileName, std::ostream& output, ts::json::Object& summary, ts::Report& report)
+{
+    ts::DuckContext duck(&report, &output);
+    duck.restoreArgs(_duck_args);
+    return AnalyzeFile(duck, _opt, fileName, output, report, &summary);
+}
+
+
 //----------------------------------------------------------------------------
 //  Program entry point
 //----------------------------------------------------------------------------
@@ -117,25 +213,12 @@ int MainCode(int argc, char *argv[])
     // Decode command line options.
     Options opt(argc, argv);
 
-    // Configure the TS analyzer.
-    ts::TSAnalyzerReport analyzer(opt.duck, opt.bitrate);
-    analyzer.setAnalysisOptions(opt.analysis);
-
-    // Open the TS file.
-    ts::TSFile file;
-    if (!file.openRead(opt.infile, 1, 0, opt, opt.format)) {
-        return EXIT_FAILURE;
-    }
-
-    // Analyze all packets in the file.
-    ts::TSPacket pkt;
-    while (file.readPackets(&pkt, nullptr, 1, opt) > 0) {
-        analyzer.feedPacket(pkt);
+    // Batch mode, all files are processed concurrently.
+    if (opt.batch.batchMode()) {
+        BatchAnalyzer handler(opt);
+        return opt.batch.run(handler, opt.pager.output(opt), opt) ? EXIT_SUCCESS : EXIT_FAILURE;
     }
-    file.close(opt);
-
-    // Display analysis results.
-    analyzer.report(opt.pager.output(opt), opt.analysis);
 
-    return EXIT_SUCCESS;
+    // Analyze one single file.
+    return AnalyzeFile(opt.duck, opt, opt.infile, opt.pager.output(opt), opt, nullptr) ? EXIT_SUCCESS : EXIT_FAILURE;
 }
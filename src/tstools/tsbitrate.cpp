@@ -196,6 +196,13 @@ int MainCode(int argc, char *argv[])
               << ts::UString::Decimal(status.bitrate_204) << " b/s (204-byte)"
               << std::endl;
 
+    if (opt.full) {
+        std::cout << "Windowed rate  : "
+                  << ts::UString::Decimal(status.windowed_bitrate_188) << " b/s (188-byte), "
+                  << ts::UString::Decimal(status.windowed_bitrate_204) << " b/s (204-byte), last "
+                  << ts::PCRAnalyzer::WINDOW_PCR_COUNT << " " << opt.pcr_name << " per PID" << std::endl;
+    }
+
     if (opt.full) {
         std::cout << std::endl
                   << "PID              TS Packets  Bitrate (188-byte)  Bitrate (204-byte)" << std::endl
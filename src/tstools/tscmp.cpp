@@ -34,6 +34,10 @@
 #include "tsMain.h"
 #include "tsMemory.h"
 #include "tsTSFileInputBuffered.h"
+#include "tsThread.h"
+#include "tsMutex.h"
+#include "tsGuard.h"
+#include "tsNullReport.h"
 #include "tsBinaryTable.h"
 #include "tsSection.h"
 #include "tsPMT.h"
@@ -42,6 +46,9 @@ TSDUCK_SOURCE;
 TS_MAIN(MainCode);
 
 #define DEFAULT_BUFFERED_PACKETS 10000
+#define MIN_WINDOW_PACKETS       16       // Initial window of packets which are compared at once.
+#define MAX_WINDOW_PACKETS       1024     // Maximum window of packets which are compared at once.
+#define CHUNK_PACKETS            65536    // Size of chunks in multi-threaded comparison.
 
 
 //----------------------------------------------------------------------------
@@ -61,6 +68,7 @@ namespace {
         uint64_t           byte_offset;
         size_t             buffered_packets;
         size_t             threshold_diff;
+        size_t             threads;
         bool               subset;
         bool               dump;
         uint32_t           dump_flags;
@@ -82,6 +90,7 @@ Options::Options(int argc, char *argv[]) :
     byte_offset(0),
     buffered_packets(0),
     threshold_diff(0),
+    threads(0),
     subset(false),
     dump(false),
     dump_flags(0),
@@ -150,6 +159,14 @@ Options::Options(int argc, char *argv[]) :
          u"file is read ahead until a matching packet is found.\n"
          u"See also --threshold-diff.");
 
+    option(u"threads", 0, POSITIVE);
+    help(u"threads",
+         u"Use the specified number of threads to search the first difference in the files. "
+         u"The files are split in chunks which are compared concurrently. "
+         u"The comparison then continues sequentially from the first difference. "
+         u"This option is used only with regular files and is ignored with --subset. "
+         u"The default is 1, a sequential comparison.");
+
     option(u"threshold-diff", 't', INTEGER, 0, 1, 0, ts::PKT_SIZE);
     help(u"threshold-diff",
          u"When used with --subset, this value specifies the maximum number of "
@@ -167,6 +184,7 @@ Options::Options(int argc, char *argv[]) :
     buffered_packets = intValue<size_t>(u"buffered-packets", DEFAULT_BUFFERED_PACKETS);
     byte_offset = intValue<uint64_t>(u"byte-offset", intValue<uint64_t>(u"packet-offset", 0) * ts::PKT_SIZE);
     threshold_diff = intValue<size_t>(u"threshold-diff", 0);
+    threads = intValue<size_t>(u"threads", 1);
     subset = present(u"subset");
     payload_only = present(u"payload-only");
     pcr_ignore = present(u"pcr-ignore");
@@ -305,6 +323,214 @@ bool Comparator::compare(const ts::TSPacket& pkt1, const ts::TSPacket& pkt2, Opt
 }
 
 
+//----------------------------------------------------------------------------
+//  Count leading identical packets in two buffers.
+//  Identical packets are always equal, whatever the comparison options are.
+//  The whole buffers are first compared using memcmp(), which is vectorized
+//  in all standard C libraries. The per-packet comparison is used only when
+//  the buffers differ, to locate the first differing packet.
+//----------------------------------------------------------------------------
+
+namespace {
+    size_t IdenticalPackets(const ts::TSPacket* pkt1, const ts::TSPacket* pkt2, size_t count)
+    {
+        if (count == 0 || ::memcmp(pkt1, pkt2, count * ts::PKT_SIZE) == 0) {
+            return count;
+        }
+        size_t same = 0;
+        while (same < count && ::memcmp(pkt1[same].b, pkt2[same].b, ts::PKT_SIZE) == 0) {
+            same++;
+        }
+        return same;
+    }
+}
+
+
+//----------------------------------------------------------------------------
+//  Multi-threaded search of the first difference in two regular files.
+//  The files are split in chunks which are compared by a pool of threads.
+//  The results of the chunks are committed in sequence, up to the first
+//  chunk containing a difference.
+//----------------------------------------------------------------------------
+
+namespace {
+    class ParallelScanner
+    {
+        TS_NOBUILD_NOCOPY(ParallelScanner);
+    public:
+        // Constructor.
+        ParallelScanner(Options& opt);
+
+        // Search the first difference. Return false if the files cannot be scanned this way.
+        bool scan();
+
+        ts::PacketCounter identical;              // Number of leading identical packets.
+        size_t            packet_size1;           // Size of packets in file 1, including header.
+        size_t            packet_size2;           // Size of packets in file 2, including header.
+        ts::PacketCounter pid_count[ts::PID_MAX]; // Number of identical packets per PID.
+
+    private:
+        // Result of the comparison of one chunk.
+        struct ChunkResult
+        {
+            ts::PacketCounter identical;  // Number of leading identical packets in the chunk.
+            bool              complete;   // All packets in the chunk are identical.
+            std::vector<std::pair<ts::PID, ts::PacketCounter>> pids;  // Number of identical packets per PID.
+
+            ChunkResult() : identical(0), complete(false), pids() {}
+        };
+
+        // A thread comparing chunks.
+        class Worker: public ts::Thread
+        {
+            TS_NOBUILD_NOCOPY(Worker);
+        public:
+            Worker(ParallelScanner& scanner) : Thread(), _scanner(scanner) {}
+        private:
+            ParallelScanner& _scanner;
+            virtual void main() override;
+        };
+        typedef ts::SafePtr<Worker, ts::NullMutex> WorkerPtr;
+
+        Options&          _opt;
+        ts::Mutex         _mutex;        // Protect all fields below.
+        ts::PacketCounter _next_chunk;   // Next chunk to compare.
+        ts::PacketCounter _next_commit;  // Next chunk to commit.
+        ts::PacketCounter _end_chunk;    // Lowest incomplete chunk (difference or end of file), no need to compare beyond.
+        bool              _done;         // First difference found.
+        std::map<ts::PacketCounter, ChunkResult> _pending;  // Compared chunks, not yet committed.
+
+        // Open a file for random access, make sure the format is known.
+        bool openFile(ts::TSFile& file, const ts::UString& name, ts::Report& report);
+
+        // Commit the result of a chunk, all chunks are committed in sequence.
+        void commit(ts::PacketCounter chunk, const ChunkResult& result);
+    };
+}
+
+ParallelScanner::ParallelScanner(Options& opt) :
+    identical(0),
+    packet_size1(0),
+    packet_size2(0),
+    pid_count(),
+    _opt(opt),
+    _mutex(),
+    _next_chunk(0),
+    _next_commit(0),
+    _end_chunk(std::numeric_limits<ts::PacketCounter>::max()),
+    _done(false),
+    _pending()
+{
+}
+
+// Open a file for random access, make sure the format is known.
+bool ParallelScanner::openFile(ts::TSFile& file, const ts::UString& name, ts::Report& report)
+{
+    ts::TSPacket pkt;
+    return file.openRead(name, _opt.byte_offset, report, _opt.format) &&
+        file.isRegularFile() &&
+        file.readPackets(&pkt, nullptr, 1, report) == 1 &&
+        file.rewind(report);
+}
+
+// Search the first difference.
+bool ParallelScanner::scan()
+{
+    // Check that both files can be accessed randomly.
+    ts::TSFile file1, file2;
+    const bool ok = openFile(file1, _opt.filename1, NULLREP) && openFile(file2, _opt.filename2, NULLREP);
+    packet_size1 = file1.packetHeaderSize() + ts::PKT_SIZE;
+    packet_size2 = file2.packetHeaderSize() + ts::PKT_SIZE;
+    file1.close(NULLREP);
+    file2.close(NULLREP);
+    if (!ok) {
+        return false;
+    }
+
+    // Start all workers and wait for their termination.
+    std::vector<WorkerPtr> workers;
+    for (size_t i = 0; i < _opt.threads; ++i) {
+        workers.push_back(new Worker(*this));
+        if (!workers.back()->start()) {
+            workers.pop_back();
+            break;
+        }
+    }
+    for (auto it = workers.begin(); it != workers.end(); ++it) {
+        (*it)->waitForTermination();
+    }
+    return !workers.empty();
+}
+
+// Commit the result of a chunk.
+void ParallelScanner::commit(ts::PacketCounter chunk, const ChunkResult& result)
+{
+    ts::Guard lock(_mutex);
+    if (!result.complete && chunk < _end_chunk) {
+        _end_chunk = chunk;
+    }
+    _pending[chunk] = result;
+    for (auto it = _pending.find(_next_commit); !_done && it != _pending.end(); it = _pending.find(_next_commit)) {
+        identical += it->second.identical;
+        for (auto pit = it->second.pids.begin(); pit != it->second.pids.end(); ++pit) {
+            pid_count[pit->first] += pit->second;
+        }
+        _done = !it->second.complete;
+        _pending.erase(it);
+        _next_commit++;
+    }
+}
+
+// Thread comparing chunks.
+void ParallelScanner::Worker::main()
+{
+    ts::TSFile file1, file2;
+    const bool ok = _scanner.openFile(file1, _scanner._opt.filename1, NULLREP) && _scanner.openFile(file2, _scanner._opt.filename2, NULLREP);
+
+    std::vector<ts::TSPacket> pkt1(MAX_WINDOW_PACKETS);
+    std::vector<ts::TSPacket> pkt2(MAX_WINDOW_PACKETS);
+    std::vector<ts::PacketCounter> count(ts::PID_MAX, 0);
+
+    for (;;) {
+        ts::PacketCounter chunk = 0;
+        {
+            ts::Guard lock(_scanner._mutex);
+            if (_scanner._done || _scanner._next_chunk >= _scanner._end_chunk) {
+                break;
+            }
+            chunk = _scanner._next_chunk++;
+        }
+
+        // Compare the chunk. Any error stops the comparison, the sequential comparison will report it.
+        ChunkResult result;
+        result.complete = ok && file1.seek(chunk * CHUNK_PACKETS, NULLREP) && file2.seek(chunk * CHUNK_PACKETS, NULLREP);
+        while (result.complete && result.identical < CHUNK_PACKETS) {
+            const size_t max = size_t(std::min<ts::PacketCounter>(MAX_WINDOW_PACKETS, CHUNK_PACKETS - result.identical));
+            const size_t read1 = file1.readPackets(&pkt1[0], nullptr, max, NULLREP);
+            const size_t read2 = file2.readPackets(&pkt2[0], nullptr, max, NULLREP);
+            const size_t same = IdenticalPackets(&pkt1[0], &pkt2[0], std::min(read1, read2));
+            for (size_t i = 0; i < same; ++i) {
+                count[pkt1[i].getPID()]++;
+            }
+            result.identical += same;
+            result.complete = same == max;
+        }
+
+        // Collect and reset the PID counters.
+        for (ts::PID pid = 0; pid < ts::PID_MAX; ++pid) {
+            if (count[pid] != 0) {
+                result.pids.push_back(std::make_pair(pid, count[pid]));
+                count[pid] = 0;
+            }
+        }
+        _scanner.commit(chunk, result);
+    }
+
+    file1.close(NULLREP);
+    file2.close(NULLREP);
+}
+
+
 //----------------------------------------------------------------------------
 //  Program entry point
 //----------------------------------------------------------------------------
@@ -315,9 +541,31 @@ int MainCode(int argc, char *argv[])
     ts::TSFileInputBuffered file1(opt.buffered_packets);
     ts::TSFileInputBuffered file2(opt.buffered_packets);
 
+    // Count packets in PIDs in each file
+    ts::PacketCounter count1[ts::PID_MAX];
+    ts::PacketCounter count2[ts::PID_MAX];
+    TS_ZERO(count1);
+    TS_ZERO(count2);
+
+    // With --threads, search the first difference using several threads.
+    // The sequential comparison starts at the first differing packet.
+    ts::PacketCounter base = 0;
+    uint64_t offset1 = opt.byte_offset;
+    uint64_t offset2 = opt.byte_offset;
+    if (opt.threads > 1 && !opt.subset) {
+        ParallelScanner scanner(opt);
+        if (scanner.scan() && scanner.identical > 0) {
+            base = scanner.identical;
+            offset1 += base * scanner.packet_size1;
+            offset2 += base * scanner.packet_size2;
+            ::memcpy(count1, scanner.pid_count, sizeof(count1));
+            ::memcpy(count2, scanner.pid_count, sizeof(count2));
+        }
+    }
+
     // Open files
-    file1.openRead(opt.filename1, 1, opt.byte_offset, opt, opt.format);
-    file2.openRead(opt.filename2, 1, opt.byte_offset, opt, opt.format);
+    file1.openRead(opt.filename1, 1, offset1, opt, opt.format);
+    file2.openRead(opt.filename2, 1, offset2, opt, opt.format);
     opt.exitOnError();
 
     // Display headers
@@ -330,12 +578,6 @@ int MainCode(int argc, char *argv[])
         std::cout << "* Comparing " << file1.getFileName() << " and " << file2.getFileName() << std::endl;
     }
 
-    // Count packets in PIDs in each file
-    ts::PacketCounter count1[ts::PID_MAX];
-    ts::PacketCounter count2[ts::PID_MAX];
-    TS_ZERO(count1);
-    TS_ZERO(count2);
-
     // Currently skipped packets in file1 when --subset
     ts::PacketCounter subset_skipped = 0;
     ts::PacketCounter total_subset_skipped = 0;
@@ -349,8 +591,36 @@ int MainCode(int argc, char *argv[])
     size_t read2 = 0;
     ts::PID pid2 = ts::PID_NULL;
 
+    // Windows of packets which are compared at once when the files are in sync.
+    std::vector<ts::TSPacket> win1(MAX_WINDOW_PACKETS);
+    std::vector<ts::TSPacket> win2(MAX_WINDOW_PACKETS);
+    size_t window = MIN_WINDOW_PACKETS;
+    const size_t max_window = std::min<size_t>(MAX_WINDOW_PACKETS, std::min(file1.getBufferSize(), file2.getBufferSize()));
+
     for (;;) {
 
+        // Fast path: skip identical packets by windows. The window grows while the files are
+        // identical and is reset after a difference. On the first differing packet, or at end
+        // of file, the files are moved back and the packet is processed one by one below.
+        if (subset_skipped == 0) {
+            const size_t max = std::min(window, max_window);
+            const size_t win_read1 = file1.read(&win1[0], max, opt);
+            const size_t win_read2 = file2.read(&win2[0], max, opt);
+            const size_t same = IdenticalPackets(&win1[0], &win2[0], std::min(win_read1, win_read2));
+            for (size_t i = 0; i < same; ++i) {
+                const ts::PID pid = win1[i].getPID();
+                count1[pid]++;
+                count2[pid]++;
+            }
+            file1.seekBackward(win_read1 - same, opt);
+            file2.seekBackward(win_read2 - same, opt);
+            if (same == max) {
+                window = std::min(2 * window, max_window);
+                continue;
+            }
+            window = MIN_WINDOW_PACKETS;
+        }
+
         // Read one packet in file1
         size_t read1 = file1.read (&pkt1, 1, opt);
         ts::PID pid1 = pkt1.getPID();
@@ -371,22 +641,22 @@ int MainCode(int argc, char *argv[])
             if (read1 != 0) {
                 // File 2 is truncated
                 if (opt.normalized) {
-                    std::cout << "truncated:file=2:packet=" << file2.readPacketsCount()
+                    std::cout << "truncated:file=2:packet=" << (base + file2.readPacketsCount())
                               << ":filename=" << file2.getFileName() << ":" << std::endl;
                 }
                 else if (!opt.quiet) {
-                    std::cout << "* Packet " << ts::UString::Decimal(file2.readPacketsCount())
+                    std::cout << "* Packet " << ts::UString::Decimal((base + file2.readPacketsCount()))
                               << ": file " << file2.getFileName() << " is truncated" << std::endl;
                 }
             }
             if (read2 != 0) {
                 // File 1 is truncated
                 if (opt.normalized) {
-                    std::cout << "truncated:file=1:packet=" << file1.readPacketsCount()
+                    std::cout << "truncated:file=1:packet=" << (base + file1.readPacketsCount())
                               << ":filename=" << file1.getFileName() << ":" << std::endl;
                 }
                 else if (!opt.quiet) {
-                    std::cout << "* Packet " << ts::UString::Decimal(file1.readPacketsCount())
+                    std::cout << "* Packet " << ts::UString::Decimal((base + file1.readPacketsCount()))
                               << ": file " << file1.getFileName() << " is truncated" << std::endl;
                 }
             }
@@ -405,12 +675,12 @@ int MainCode(int argc, char *argv[])
         // Report resynchronization after missing packets
         if (subset_skipped > 0) {
             if (opt.normalized) {
-                std::cout << "skip:packet=" << (file1.readPacketsCount() - 1 - subset_skipped)
+                std::cout << "skip:packet=" << ((base + file1.readPacketsCount()) - 1 - subset_skipped)
                           << ":skipped=" << ts::UString::Decimal(subset_skipped)
                           << ":" << std::endl;
             }
             else {
-                std::cout << "* Packet " << ts::UString::Decimal(file1.readPacketsCount() - 1 - subset_skipped)
+                std::cout << "* Packet " << ts::UString::Decimal((base + file1.readPacketsCount()) - 1 - subset_skipped)
                           << ", missing " << ts::UString::Decimal(subset_skipped)
                           << " packets in " << file2.getFileName() << std::endl;
             }
@@ -423,7 +693,7 @@ int MainCode(int argc, char *argv[])
         if (!comp.equal) {
             diff_count++;
             if (opt.normalized) {
-                std::cout << "diff:packet=" << (file1.readPacketsCount() - 1)
+                std::cout << "diff:packet=" << ((base + file1.readPacketsCount()) - 1)
                           << (opt.payload_only ? ":payload" : "")
                           << ":offset=" << comp.first_diff
                           << ":endoffset=" << comp.end_diff
@@ -438,7 +708,7 @@ int MainCode(int argc, char *argv[])
                           << ":" << std::endl;
             }
             else if (!opt.quiet) {
-                std::cout << "* Packet " << ts::UString::Decimal(file1.readPacketsCount() - 1) << " differ at offset " << comp.first_diff;
+                std::cout << "* Packet " << ts::UString::Decimal((base + file1.readPacketsCount()) - 1) << " differ at offset " << comp.first_diff;
                 if (opt.payload_only) {
                     std::cout << " in payload";
                 }
@@ -476,14 +746,14 @@ int MainCode(int argc, char *argv[])
 
     // Final report
     if (opt.normalized) {
-        std::cout << "total:packets=" << file1.readPacketsCount()
+        std::cout << "total:packets=" << (base + file1.readPacketsCount())
                   << ":diff=" << diff_count
                   << ":missing=" << total_subset_skipped
                   << ":holes=" << subset_skipped_chunks
                   << ":" << std::endl;
     }
     else if (opt.verbose()) {
-        std::cout << "* Read " << ts::UString::Decimal(file1.readPacketsCount())
+        std::cout << "* Read " << ts::UString::Decimal((base + file1.readPacketsCount()))
                   << " packets, found " << ts::UString::Decimal(diff_count) << " differences";
         if (subset_skipped_chunks > 0) {
             std::cout << ", missing " << ts::UString::Decimal(total_subset_skipped)
@@ -128,40 +128,68 @@ int MainCode(int argc, char *argv[])
         return EXIT_FAILURE;
     }
 
-    // Process all packets in the file
-    ts::TSPacket pkt;
+    // Process all packets in the file, by chunks of contiguous packets.
+    // Packet headers are extracted in bulk by the CC analyzer.
+    constexpr size_t CHUNK_PACKETS = 1024;
+    ts::TSPacketVector buffer(CHUNK_PACKETS);
+    std::vector<bool> status;
+    bool more = true;
 
-    for (;;) {
+    while (more) {
 
-        // Save position of current packet
+        // Save position of current chunk
         const std::ios::pos_type pos = opt.file.tellg();
         if (opt.fileError(u"error getting file position")) {
             break;
         }
 
-        // Read a TS packet
-        if (!pkt.read(opt.file, true, opt)) {
-            break; // end of file
+        // Read a chunk of TS packets
+        opt.file.read(reinterpret_cast<char*>(buffer.data()), std::streamsize(buffer.size() * ts::PKT_SIZE));
+        const size_t insize = size_t(opt.file.gcount());
+        size_t count = insize / ts::PKT_SIZE;
+        more = bool(opt.file);
+
+        if (!more && !opt.file.eof()) {
+            opt.error(u"%s: I/O error while reading TS packets", {opt.filename});
+        }
+        else if (insize % ts::PKT_SIZE != 0) {
+            opt.error(u"%s: truncated TS packet (%d bytes) at end of file", {opt.filename, insize % ts::PKT_SIZE});
         }
 
-        // Process packet
-        if (!fixer.feedPacket(pkt) && !opt.test) {
-            // Packet was modified, need to rewrite it.
-            // Rewind to beginning of current packet
-            opt.file.seekp(pos);
-            if (opt.fileError(u"error setting file position")) {
+        // Stop at first synchronization loss.
+        for (size_t i = 0; i < count; ++i) {
+            if (buffer[i].b[0] != ts::SYNC_BYTE) {
+                opt.error(u"%s: synchronization lost after %'d TS packets, got 0x%X instead of 0x%X at start of TS packet", {opt.filename, fixer.totalPackets() + i, buffer[i].b[0], ts::SYNC_BYTE});
+                count = i;
+                more = false;
                 break;
             }
-            // Rewrite the packet
-            pkt.write(opt.file, opt);
-            if (opt.fileError(u"error rewriting packet")) {
-                break;
+        }
+
+        // Process packets
+        if (!fixer.feedPackets(buffer.data(), count, &status) && !opt.test) {
+            // Some packets were modified, need to rewrite them.
+            // First, need to clear the eof bit on last chunk.
+            opt.file.clear();
+            bool success = true;
+            for (size_t i = 0; success && i < count; ++i) {
+                if (!status[i]) {
+                    // Rewind to beginning of modified packet
+                    opt.file.seekp(pos + std::streamoff(i * ts::PKT_SIZE));
+                    success = !opt.fileError(u"error setting file position");
+                    // Rewrite the packet
+                    if (success) {
+                        buffer[i].write(opt.file, opt);
+                        success = !opt.fileError(u"error rewriting packet");
+                    }
+                }
             }
             // Make sure the get position is ok
-            opt.file.seekg(opt.file.tellp());
-            if (opt.fileError(u"error setting file position")) {
-                break;
+            if (success) {
+                opt.file.seekg(pos + std::streamoff(count * ts::PKT_SIZE));
+                success = !opt.fileError(u"error setting file position");
             }
+            more = more && success;
         }
     }
 
@@ -171,7 +199,7 @@ int MainCode(int argc, char *argv[])
     if (opt.circular && opt.valid()) {
 
         // Create an empty packet (no payload, 184-byte adaptation field)
-        pkt = ts::NullPacket;
+        ts::TSPacket pkt(ts::NullPacket);
         pkt.b[3] = 0x20;    // adaptation field, no payload
         pkt.b[4] = 183;     // adaptation field length
         pkt.b[5] = 0x00;    // nothing in adaptation field
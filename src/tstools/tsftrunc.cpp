@@ -33,10 +33,13 @@
 
 #include "tsMain.h"
 #include "tsMPEG.h"
+#include "tsTSPacket.h"
 #include "tsSysUtils.h"
 TSDUCK_SOURCE;
 TS_MAIN(MainCode);
 
+#define NULL_TAIL_CHUNK 4096  // Number of packets to read at a time with --remove-null-tail.
+
 
 //----------------------------------------------------------------------------
 //  Command line options
@@ -50,6 +53,7 @@ namespace {
         Options(int argc, char *argv[]);
 
         bool              check_only;   // check only, do not truncate
+        bool              null_tail;    // remove null packets at end of file
         size_t            packet_size;  // packet size in bytes
         ts::PacketCounter trunc_pkt;    // first packet to truncate (0 means eof)
         ts::UStringVector files;        // file names
@@ -59,6 +63,7 @@ namespace {
 Options::Options(int argc, char *argv[]) :
     Args(u"Truncate an MPEG transport stream file", u"[options] filename ..."),
     check_only(false),
+    null_tail(false),
     packet_size(ts::PKT_SIZE),
     trunc_pkt(0),
     files()
@@ -80,6 +85,13 @@ Options::Options(int argc, char *argv[]) :
          u"packets are kept in the file. Extraneous bytes at end of file "
          u"(after last multiple of 188 bytes) are truncated.");
 
+    option(u"remove-null-tail");
+    help(u"remove-null-tail",
+         u"Also truncate all null packets at end of file, after the last non-null packet. "
+         u"This is applied after --byte or --packet, on the remaining packets. "
+         u"With packet sizes other than " + ts::UString::Decimal(ts::PKT_SIZE) + u" bytes, the TS packet "
+         u"is assumed to be at the end of each M2TS packet or at the beginning of any other packet.");
+
     option(u"size-of-packet", 's', POSITIVE);
     help(u"size-of-packet",
          u"TS packet size in bytes. The default is " + ts::UString::Decimal(ts::PKT_SIZE) +
@@ -89,8 +101,13 @@ Options::Options(int argc, char *argv[]) :
 
     getValues(files);
     check_only = present(u"noaction");
+    null_tail = present(u"remove-null-tail");
     packet_size = intValue<size_t>(u"size-of-packet", ts::PKT_SIZE);
 
+    if (null_tail && packet_size < ts::PKT_SIZE) {
+        error(u"--remove-null-tail requires packets of at least %d bytes", {ts::PKT_SIZE});
+    }
+
     if (present(u"byte") && present(u"packet")) {
         error(u"--byte and --packet are mutually exclusive");
     }
@@ -108,6 +125,57 @@ Options::Options(int argc, char *argv[]) :
 }
 
 
+//----------------------------------------------------------------------------
+//  Count the null packets at the end of the first pkt_count packets of a file.
+//----------------------------------------------------------------------------
+
+namespace {
+    bool CountNullTail(Options& opt, const ts::UString& filename, uint64_t pkt_count, uint64_t& null_count)
+    {
+        null_count = 0;
+
+        std::ifstream file(filename.toUTF8().c_str(), std::ios::binary);
+        if (!file) {
+            opt.error(u"cannot open %s", {filename});
+            return false;
+        }
+
+        // Location of the TS packet inside each packet of the file.
+        const size_t offset = opt.packet_size == ts::PKT_M2TS_SIZE ? ts::M2TS_HEADER_SIZE : 0;
+        ts::ByteBlock data(NULL_TAIL_CHUNK * opt.packet_size);
+        ts::TSPacketVector packets(NULL_TAIL_CHUNK);
+        ts::TSPacketClasses classes;
+
+        // Read chunks of packets backward, until a non-null packet is found.
+        uint64_t end = pkt_count;
+        while (end > 0) {
+            const size_t count = size_t(std::min<uint64_t>(end, NULL_TAIL_CHUNK));
+            const uint64_t first = end - count;
+            file.seekg(std::streamoff(first * opt.packet_size));
+            if (!file.read(reinterpret_cast<char*>(data.data()), std::streamsize(count * opt.packet_size))) {
+                opt.error(u"error reading %s", {filename});
+                return false;
+            }
+            const ts::TSPacket* pkt = reinterpret_cast<const ts::TSPacket*>(data.data());
+            if (opt.packet_size != ts::PKT_SIZE) {
+                for (size_t i = 0; i < count; ++i) {
+                    packets[i].copyFrom(&data[i * opt.packet_size + offset]);
+                }
+                pkt = packets.data();
+            }
+            ts::TSPacket::Classify(pkt, count, classes);
+            const size_t tail = classes.countTail(classes.null_pid);
+            null_count += tail;
+            if (tail < count) {
+                break;
+            }
+            end = first;
+        }
+        return true;
+    }
+}
+
+
 //----------------------------------------------------------------------------
 //  Program entry point
 //----------------------------------------------------------------------------
@@ -145,6 +213,17 @@ int MainCode(int argc, char *argv[])
             keep = opt.trunc_pkt * opt.packet_size;
         }
 
+        // Remove null packets at end of the kept part of the file.
+
+        uint64_t null_count = 0;
+        if (opt.null_tail) {
+            if (!CountNullTail(opt, *file, keep / opt.packet_size, null_count)) {
+                success = false;
+                continue;
+            }
+            keep -= null_count * opt.packet_size;
+        }
+
         // Display info in verbose or check mode
 
         if (opt.verbose()) {
@@ -155,6 +234,9 @@ int MainCode(int argc, char *argv[])
             if (extra > 0) {
                 std::cout << ts::UString::Format(u"%'d extra bytes, ", {extra});
             }
+            if (null_count > 0) {
+                std::cout << ts::UString::Format(u"%'d trailing null packets, ", {null_count});
+            }
             if (keep < file_size) {
                 std::cout << ts::UString::Format(u"%'d bytes to truncate, ", {file_size - keep}) << std::endl;
             }
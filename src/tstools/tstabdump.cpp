@@ -35,6 +35,7 @@
 #include "tsDuckContext.h"
 #include "tsTime.h"
 #include "tsSectionFile.h"
+#include "tsSectionFileIndex.h"
 #include "tsTablesDisplay.h"
 #include "tsUDPReceiver.h"
 #include "tsTablesLogger.h"
@@ -71,6 +72,8 @@ namespace {
         size_t            max_tables;        // Max number of tables to dump.
         size_t            max_invalid_udp;   // Max number of invalid UDP messages before giving up.
         bool              no_encapsulation;  // Raw sections in UDP messages.
+        bool              use_index;         // Select sections using an index of the binary files.
+        ts::SectionFileIndex::Filter filter; // Section selection with an index.
     };
 }
 
@@ -83,7 +86,9 @@ Options::Options(int argc, char *argv[]) :
     infiles(),
     max_tables(0),
     max_invalid_udp(16),
-    no_encapsulation(false)
+    no_encapsulation(false),
+    use_index(false),
+    filter()
 {
     duck.defineArgsForCAS(*this);
     duck.defineArgsForPDS(*this);
@@ -100,6 +105,23 @@ Options::Options(int argc, char *argv[]) :
          u"With --ip-udp, no file shall be specified. Binary sections and tables are "
          u"received over UDP/IP as sent by the utility 'tstables' or the plugin 'tables'.");
 
+    option(u"end-time", 0, STRING);
+    help(u"end-time", u"year/month/day:hour:minute:second",
+         u"Dump only the sections which were collected before the specified UTC time. "
+         u"This option requires an index of the binary file, see option --index.");
+
+    option(u"index");
+    help(u"index",
+         u"Use an index of each input binary file to select the sections to dump. "
+         u"Only the selected sections are read from the file. The index file has "
+         u"the same name as the binary file with an additional '.idx' suffix, as "
+         u"created by 'tstables --binary-index'. If the index file does not exist, "
+         u"the index is built by scanning the section headers of the binary file. "
+         u"In that case, the PID and the time of collection of the sections are unknown "
+         u"and the options --pid, --start-time and --end-time are rejected. "
+         u"This option is implicit with options --pid, --tid, --tid-ext, --start-time "
+         u"and --end-time.");
+
     option(u"max-tables", 'x', UNSIGNED);
     help(u"max-tables",
          u"Maximum number of tables to dump. Stop logging tables when this limit is "
@@ -110,6 +132,27 @@ Options::Options(int argc, char *argv[]) :
          u"With --ip-udp, receive the tables as raw binary messages in UDP packets. "
          u"By default, the tables are formatted into TLV messages.");
 
+    option(u"pid", 0, PIDVAL, 0, UNLIMITED_COUNT);
+    help(u"pid", u"pid1[-pid2]",
+         u"Dump only the sections which were collected on this PID value or range of PID values. "
+         u"Several --pid options may be specified. "
+         u"This option requires an index of the binary file, see option --index.");
+
+    option(u"start-time", 0, STRING);
+    help(u"start-time", u"year/month/day:hour:minute:second",
+         u"Dump only the sections which were collected at or after the specified UTC time. "
+         u"This option requires an index of the binary file, see option --index.");
+
+    option(u"tid", 0, UINT8, 0, UNLIMITED_COUNT);
+    help(u"tid", u"tid1[-tid2]",
+         u"Dump only the sections with this table id value or range of values. "
+         u"Several --tid options may be specified.");
+
+    option(u"tid-ext", 0, UINT16, 0, UNLIMITED_COUNT);
+    help(u"tid-ext", u"ext1[-ext2]",
+         u"Dump only the long sections with this table id extension value or range of values. "
+         u"Several --tid-ext options may be specified.");
+
     analyze(argc, argv);
 
     duck.loadArgs(*this);
@@ -120,10 +163,25 @@ Options::Options(int argc, char *argv[]) :
     getValues(infiles, u"");
     max_tables = intValue<size_t>(u"max-tables", std::numeric_limits<size_t>::max());
     no_encapsulation = present(u"no-encapsulation");
+    getIntValues(filter.pids, u"pid");
+    getIntValues(filter.tids, u"tid");
+    getIntValues(filter.tid_exts, u"tid-ext");
+    const ts::UString start(value(u"start-time"));
+    const ts::UString end(value(u"end-time"));
+    if (!start.empty() && !filter.start.decode(start)) {
+        error(u"invalid --start-time value \"%s\" (use \"year/month/day:hour:minute:second\")", {start});
+    }
+    if (!end.empty() && !filter.end.decode(end)) {
+        error(u"invalid --end-time value \"%s\" (use \"year/month/day:hour:minute:second\")", {end});
+    }
+    use_index = present(u"index") || present(u"pid") || present(u"tid") || present(u"tid-ext") || !start.empty() || !end.empty();
 
     if (!infiles.empty() && udp.receiverSpecified()) {
         error(u"specify input files or --ip-udp, but not both");
     }
+    if (use_index && infiles.empty()) {
+        error(u"section selection with an index requires input files");
+    }
 
     exitOnError();
 }
@@ -224,6 +282,24 @@ namespace {
             SetBinaryModeStdin(opt);
             ok = file.loadBinary(std::cin, opt);
         }
+        else if (opt.use_index) {
+            // Load only the selected sections, using an index file if there is one.
+            ts::SectionFileIndex index;
+            const ts::UString index_name(ts::SectionFileIndex::DefaultFileName(file_name));
+            if (ts::FileExists(index_name)) {
+                opt.verbose(u"using index file %s", {index_name});
+                ok = index.load(index_name, opt);
+            }
+            else if (opt.filter.needsCollectionInfo()) {
+                // A scanned index has no PID and no time of collection, nothing would match.
+                opt.error(u"no index file %s, options --pid, --start-time and --end-time require an index from 'tstables --binary-index'", {index_name});
+            }
+            else {
+                opt.verbose(u"no index file %s, scanning %s", {index_name, file_name});
+                ok = index.build(file_name, opt);
+            }
+            ok = ok && file.loadBinary(file_name, index, opt.filter, opt);
+        }
         else {
             ok = file.loadBinary(file_name, opt);
         }
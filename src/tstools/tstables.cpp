@@ -36,6 +36,9 @@
 #include "tsTSFile.h"
 #include "tsTablesLogger.h"
 #include "tsPagerArgs.h"
+#include "tsFileBatch.h"
+#include "tsjsonNumber.h"
+#include "tsGuard.h"
 TSDUCK_SOURCE;
 TS_MAIN(MainCode);
 
@@ -62,17 +65,19 @@ namespace {
         ts::TablesLogger   logger;   // Table logging.
         ts::PagerArgs      pager;    // Output paging options.
         ts::UString        infile;   // Input file name.
+        ts::FileBatch      batch;    // Batch processing of multiple files.
         ts::TSPacketFormat format;   // Input file format.
     };
 }
 
 Options::Options(int argc, char *argv[]) :
-    Args(u"Collect PSI/SI tables from an MPEG transport stream", u"[options] [filename]"),
+    Args(u"Collect PSI/SI tables from an MPEG transport stream", u"[options] [filename ...]"),
     duck(this),
     display(duck),
     logger(display),
     pager(true, true),
     infile(),
+    batch(u".txt"),
     format(ts::TSPacketFormat::AUTODETECT)
 {
     duck.defineArgsForCAS(*this);
@@ -82,9 +87,13 @@ Options::Options(int argc, char *argv[]) :
     pager.defineArgs(*this);
     logger.defineArgs(*this);
     display.defineArgs(*this);
+    batch.defineArgs(*this);
 
-    option(u"", 0, STRING, 0, 1);
-    help(u"", u"Input transport stream file (standard input if omitted).");
+    option(u"", 0, STRING, 0, UNLIMITED_COUNT);
+    help(u"", u"Input transport stream files (standard input if omitted). "
+         u"When more than one file is specified, wildcards are allowed and "
+         u"all files are processed concurrently in batch mode. The standard "
+         u"input cannot be used in batch mode.");
 
     option(u"format", 0, ts::TSPacketFormatEnum);
     help(u"format", u"name",
@@ -100,14 +109,110 @@ Options::Options(int argc, char *argv[]) :
     pager.loadArgs(duck, *this);
     logger.loadArgs(duck, *this);
     display.loadArgs(duck, *this);
-
-    infile = value(u"");
+    batch.loadArgs(duck, *this);
+
+    ts::UStringVector files;
+    getValues(files, u"");
+    if (files.size() > 1 || batch.batchMode()) {
+        batch.addFiles(files, *this);
+        // The standard input cannot be processed in batch mode.
+        if (batch.files.empty()) {
+            error(u"no input file in batch mode, specify input files or --file-list");
+        }
+        // In batch mode, all workers would write into the same destinations.
+        if (present(u"output-file") || present(u"text-output") || present(u"xml-output") || present(u"binary-output") || present(u"ip-udp")) {
+            error(u"table output destinations are not allowed in batch mode, use --output-directory");
+        }
+    }
+    else {
+        infile = value(u"");
+    }
     format = enumValue<ts::TSPacketFormat>(u"format", ts::TSPacketFormat::AUTODETECT);
 
     exitOnError();
 }
 
 
+//----------------------------------------------------------------------------
+//  Log the tables of one file.
+//----------------------------------------------------------------------------
+
+namespace {
+    bool LogFile(ts::TablesLogger& logger, const Options& opt, const ts::UString& fileName, ts::Report& report, ts::json::Object* summary)
+    {
+        // Open section logger.
+        if (!logger.open()) {
+            return false;
+        }
+
+        // Open the TS file.
+        ts::TSFile file;
+        if (!file.openRead(fileName, 1, 0, report, opt.format)) {
+            return false;
+        }
+
+        // Read all packets in the file and pass them to the logger
+        ts::TSPacket pkt;
+        uint64_t count = 0;
+        while (!logger.completed() && file.readPackets(&pkt, nullptr, 1, report) > 0) {
+            logger.feedPacket(pkt);
+            count++;
+        }
+        file.close(report);
+        logger.close();
+
+        // Characteristic values for the batch summary.
+        if (summary != nullptr) {
+            summary->add(u"packets", ts::json::ValuePtr(new ts::json::Number(int64_t(count))));
+        }
+        return !logger.hasErrors();
+    }
+}
+
+
+//----------------------------------------------------------------------------
+//  Batch mode: log each file in a worker thread with its own context.
+//----------------------------------------------------------------------------
+
+namespace {
+    class BatchLogger: public ts::FileBatchHandlerInterface
+    {
+        TS_NOBUILD_NOCOPY(BatchLogger);
+    public:
+        explicit BatchLogger(Options& opt);
+        virtual bool handleBatchFile(ts::FileBatch& batch, const ts::UString& fileName, std::ostream& output, ts::json::Object& summary, ts::Report& report) override;
+    private:
+        Options&  _opt;
+        ts::Mutex _mutex;  // Serialize the loading of options in each logger.
+        ts::DuckContext::SavedArgs _duck_args;
+    };
+}
+
+BatchLogger::BatchLogger(Options& opt) :
+    _opt(opt),
+    _mutex(),
+    _duck_args()
+{
+    _opt.duck.saveArgs(_duck_args);
+}
+
+bool BatchLogger::handleBatchFile(ts::FileBatch& batch, const ts::UString& fileName, std::ostream& output, ts::json::Object& summary, ts::Report& report)
+{
+    // Each file uses its own context, display and logger, the tables are displayed on the file output.
+    ts::DuckContext duck(&report, &output);
+    duck.restoreArgs(_duck_args);
+    ts::TablesDisplay display(duck);
+    ts::TablesLogger logger(display);
+    {
+        ts::Guard lock(_mutex);
+        if (!logger.loadArgs(duck, _opt) || !display.loadArgs(duck, _opt)) {
+            return false;
+        }
+    }
+    return LogFile(logger, _opt, fileName, report, &summary);
+}
+
+
 //----------------------------------------------------------------------------
 //  Program entry point
 //----------------------------------------------------------------------------
@@ -120,29 +225,19 @@ int MainCode(int argc, char *argv[])
     // Redirect display on pager process or stdout only.
     opt.duck.setOutput(&opt.pager.output(opt), false);
 
-    // Open section logger.
-    if (!opt.logger.open()) {
-        return EXIT_FAILURE;
-    }
-
-    // Open the TS file.
-    ts::TSFile file;
-    if (!file.openRead(opt.infile, 1, 0, opt, opt.format)) {
-        return EXIT_FAILURE;
+    // Batch mode, all files are processed concurrently.
+    if (opt.batch.batchMode()) {
+        BatchLogger handler(opt);
+        return opt.batch.run(handler, opt.duck.out(), opt) ? EXIT_SUCCESS : EXIT_FAILURE;
     }
 
-    // Read all packets in the file and pass them to the logger
-    ts::TSPacket pkt;
-    while (!opt.logger.completed() && file.readPackets(&pkt, nullptr, 1, opt) > 0) {
-        opt.logger.feedPacket(pkt);
-    }
-    file.close(opt);
-    opt.logger.close();
+    // Log one single file.
+    const bool success = LogFile(opt.logger, opt, opt.infile, opt, nullptr);
 
     // Report errors
     if (opt.verbose() && !opt.logger.hasErrors()) {
         opt.logger.reportDemuxErrors(std::cerr);
     }
 
-    return opt.logger.hasErrors() ? EXIT_FAILURE : EXIT_SUCCESS;
+    return success ? EXIT_SUCCESS : EXIT_FAILURE;
 }
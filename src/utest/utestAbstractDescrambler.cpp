@@ -0,0 +1,664 @@
+//----------------------------------------------------------------------------
+//
+// TSDuck - The MPEG Transport Stream Toolkit
+// Copyright (c) 2005-2020, Thierry Lelegard
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+// THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------
+//
+//  TSUnit test suite for class ts::AbstractDescrambler.
+//
+//  The descrambler is tested through a complete TS processing chain, using
+//  a fake CAS which deciphers ECM's containing their control words in clear.
+//
+//----------------------------------------------------------------------------
+
+#include "tsAbstractDescrambler.h"
+#include "tsTSProcessor.h"
+#include "tsPluginRepository.h"
+#include "tsPluginEventHandlerInterface.h"
+#include "tsOneShotPacketizer.h"
+#include "tsPAT.h"
+#include "tsPMT.h"
+#include "tsCADescriptor.h"
+#include "tsTSFile.h"
+#include "tsMonotonic.h"
+#include "tsGuard.h"
+#include "tsSysUtils.h"
+#include "tsCerrReport.h"
+#include "tsunit.h"
+TSDUCK_SOURCE;
+
+
+//----------------------------------------------------------------------------
+// The test fixture
+//----------------------------------------------------------------------------
+
+class AbstractDescramblerTest: public tsunit::Test
+{
+public:
+    AbstractDescramblerTest();
+
+    virtual void beforeTest() override;
+    virtual void afterTest() override;
+
+    void testUrgency();
+    void testCacheAndStaleCW();
+    void testCacheEviction();
+    void testWorkerPool();
+
+    TSUNIT_TEST_BEGIN(AbstractDescramblerTest);
+    TSUNIT_TEST(testUrgency);
+    TSUNIT_TEST(testCacheAndStaleCW);
+    TSUNIT_TEST(testCacheEviction);
+    TSUNIT_TEST(testWorkerPool);
+    TSUNIT_TEST_END();
+
+private:
+    ts::DuckContext    _duck;
+    ts::UString        _tempFile;
+    ts::TSPacketVector _packets;   // Input stream.
+    ts::TSPacketVector _clear;     // Expected clear packets on scrambled PID's.
+    uint8_t            _cc[ts::PID_MAX];
+
+    // Build the input stream.
+    void addPSI();
+    void addNulls(size_t count);
+    void addECM(ts::PID pid, ts::TID tid, uint8_t tag, uint8_t cw, uint8_t flags = 0);
+    void addScrambled(ts::PID pid, uint8_t cw, size_t count);
+    void addPackets(const ts::TSPacketVector& packets);
+    void addBarrier(size_t started, size_t completed);
+    void addGate();
+
+    // Run the descrambler on the input stream with additional options.
+    void run(const ts::UStringVector& options, ts::AbstractDescrambler::ECMStatistics& stats);
+};
+
+TSUNIT_REGISTER(AbstractDescramblerTest);
+
+
+//----------------------------------------------------------------------------
+// Description of the test stream.
+//----------------------------------------------------------------------------
+
+namespace {
+    // Fake CAS.
+    const uint16_t CAS_ID = 0x4AFF;
+
+    // One service with three components, each with its own ECM stream.
+    const uint16_t SERVICE_ID = 1;
+    const ts::PID PMT_PID = 0x0100;
+    const ts::PID ES_A = 0x0201;
+    const ts::PID ES_B = 0x0202;
+    const ts::PID ES_C = 0x0203;
+    const ts::PID ECM_A = 0x0301;
+    const ts::PID ECM_B = 0x0302;
+    const ts::PID ECM_C = 0x0303;
+
+    // Flags in the fake ECM's.
+    const uint8_t ECM_GATE = 0x01;  // Wait for the gate to open before returning the CW.
+    const uint8_t ECM_PAIR = 0x02;  // Wait until another ECM is deciphered at the same time.
+    const uint8_t ECM_FAIL = 0x04;  // Fail to decipher this ECM.
+
+    // Max wait time in the fake CAS, to avoid blocking the test forever.
+    const ts::MilliSecond MAX_WAIT = 5000;
+
+    // Build a control word from one byte.
+    ts::ByteBlock MakeCW(uint8_t cw)
+    {
+        return ts::ByteBlock(8, cw);
+    }
+}
+
+
+//----------------------------------------------------------------------------
+// State which is shared between the test, the fake CAS and the capture plugin.
+//----------------------------------------------------------------------------
+
+namespace {
+    // The barrier plugin waits until that number of ECM's started and completed.
+    class Barrier
+    {
+    public:
+        size_t started;
+        size_t completed;
+    };
+
+    typedef std::map<ts::PacketCounter, Barrier> BarrierMap;
+
+    class SharedState
+    {
+        TS_NOCOPY(SharedState);
+    public:
+        SharedState();
+        void reset();
+
+        // Wait until a condition becomes true, at most MAX_WAIT.
+        template <class PREDICATE>
+        bool waitFor(PREDICATE pred);
+
+        ts::Mutex                mutex;
+        std::vector<uint8_t>     order;          // Tags of ECM's, in deciphering order.
+        size_t                   active;         // Number of ECM's being deciphered.
+        size_t                   max_active;     // Max number of ECM's being simultaneously deciphered.
+        size_t                   completed;      // Number of ECM's which completed.
+        ts::PacketCounter        gate_packet;    // Open the gate when the capture plugin gets that packet index.
+        bool                     gate_open;      // The gate is open.
+        BarrierMap               barriers;       // Barrier plugin waits at these packet indexes.
+        ts::PacketCounter        received;       // Number of packets seen by the barrier plugin.
+        ts::PacketCounter        captured;       // Number of packets seen by the capture plugin.
+        ts::TSPacketVector       output;         // Output packets from scrambled PID's.
+    };
+
+    SharedState state;
+
+    SharedState::SharedState() :
+        mutex(),
+        order(),
+        active(0),
+        max_active(0),
+        completed(0),
+        gate_packet(0),
+        gate_open(false),
+        barriers(),
+        received(0),
+        captured(0),
+        output()
+    {
+    }
+
+    void SharedState::reset()
+    {
+        ts::Guard lock(mutex);
+        order.clear();
+        active = max_active = completed = 0;
+        gate_packet = received = captured = 0;
+        barriers.clear();
+        gate_open = false;
+        output.clear();
+    }
+
+    template <class PREDICATE>
+    bool SharedState::waitFor(PREDICATE pred)
+    {
+        const ts::Monotonic start(true);
+        for (;;) {
+            {
+                ts::Guard lock(mutex);
+                if (pred()) {
+                    return true;
+                }
+            }
+            if (ts::Monotonic(true) - start > MAX_WAIT * ts::NanoSecPerMilliSec) {
+                return false;
+            }
+            ts::SleepThread(2);
+        }
+    }
+}
+
+
+//----------------------------------------------------------------------------
+// Fake descrambler. The ECM payload is: tag, CW byte, flags.
+// The even and odd control words are 8 times the CW byte and its complement.
+//----------------------------------------------------------------------------
+
+namespace {
+    class TestDescrambler : public ts::AbstractDescrambler
+    {
+        TS_NOBUILD_NOCOPY(TestDescrambler);
+    public:
+        TestDescrambler(ts::TSP* t) : ts::AbstractDescrambler(t, u"Test descrambler") {}
+        static ts::ProcessorPlugin* CreateInstance(ts::TSP* t) { return new TestDescrambler(t); }
+
+    protected:
+        virtual bool checkCADescriptor(uint16_t cas_id, const ts::ByteBlock& priv) override;
+        virtual bool checkECM(const ts::Section& ecm) override;
+        virtual bool decipherECM(const ts::Section& ecm, CWData& cw_even, CWData& cw_odd) override;
+    };
+
+    bool TestDescrambler::checkCADescriptor(uint16_t cas_id, const ts::ByteBlock&)
+    {
+        return cas_id == CAS_ID;
+    }
+
+    bool TestDescrambler::checkECM(const ts::Section& ecm)
+    {
+        return ecm.payloadSize() == 3;
+    }
+
+    bool TestDescrambler::decipherECM(const ts::Section& ecm, CWData& cw_even, CWData& cw_odd)
+    {
+        const uint8_t* data = ecm.payload();
+        {
+            ts::Guard lock(state.mutex);
+            state.order.push_back(data[0]);
+            state.max_active = std::max(state.max_active, ++state.active);
+        }
+        if ((data[2] & ECM_GATE) != 0) {
+            state.waitFor([]() { return state.gate_open; });
+        }
+        if ((data[2] & ECM_PAIR) != 0) {
+            state.waitFor([]() { return state.max_active >= 2; });
+        }
+        cw_even.cw = MakeCW(data[1]);
+        cw_odd.cw = MakeCW(uint8_t(~data[1]));
+        {
+            ts::Guard lock(state.mutex);
+            state.active--;
+            state.completed++;
+        }
+        return (data[2] & ECM_FAIL) == 0;
+    }
+}
+
+
+//----------------------------------------------------------------------------
+// Barrier plugin, before the descrambler. It holds the input of the
+// descrambler until some ECM's are deciphered, so that the descrambler
+// does not stop its ECM threads before.
+//----------------------------------------------------------------------------
+
+namespace {
+    class BarrierPlugin : public ts::ProcessorPlugin
+    {
+        TS_NOBUILD_NOCOPY(BarrierPlugin);
+    public:
+        BarrierPlugin(ts::TSP* t) : ts::ProcessorPlugin(t, u"Test barrier", u"") {}
+        static ts::ProcessorPlugin* CreateInstance(ts::TSP* t) { return new BarrierPlugin(t); }
+        virtual Status processPacket(ts::TSPacket&, ts::TSPacketMetadata&) override;
+    };
+
+    BarrierPlugin::Status BarrierPlugin::processPacket(ts::TSPacket&, ts::TSPacketMetadata&)
+    {
+        Barrier barrier{0, 0};
+        {
+            ts::Guard lock(state.mutex);
+            const BarrierMap::const_iterator it(state.barriers.find(state.received++));
+            if (it != state.barriers.end()) {
+                barrier = it->second;
+            }
+        }
+        state.waitFor([barrier]() { return state.order.size() >= barrier.started && state.completed >= barrier.completed; });
+        return TSP_OK;
+    }
+}
+
+
+//----------------------------------------------------------------------------
+// Capture plugin, after the descrambler. It opens the gate when the
+// descrambler has processed a given packet.
+//----------------------------------------------------------------------------
+
+namespace {
+    class CapturePlugin : public ts::ProcessorPlugin
+    {
+        TS_NOBUILD_NOCOPY(CapturePlugin);
+    public:
+        CapturePlugin(ts::TSP* t) : ts::ProcessorPlugin(t, u"Test capture", u"") {}
+        static ts::ProcessorPlugin* CreateInstance(ts::TSP* t) { return new CapturePlugin(t); }
+        virtual Status processPacket(ts::TSPacket&, ts::TSPacketMetadata&) override;
+    };
+
+    CapturePlugin::Status CapturePlugin::processPacket(ts::TSPacket& pkt, ts::TSPacketMetadata&)
+    {
+        ts::Guard lock(state.mutex);
+        if (state.captured++ == state.gate_packet) {
+            state.gate_open = true;
+        }
+        const ts::PID pid = pkt.getPID();
+        if (pid == ES_A || pid == ES_B || pid == ES_C) {
+            state.output.push_back(pkt);
+        }
+        return TSP_OK;
+    }
+}
+
+
+//----------------------------------------------------------------------------
+// Collect the ECM statistics when the descrambler stops.
+//----------------------------------------------------------------------------
+
+namespace {
+    class StatisticsHandler : public ts::PluginEventHandlerInterface
+    {
+        TS_NOCOPY(StatisticsHandler);
+    public:
+        StatisticsHandler() : stats(), count(0) {}
+        virtual void handlePluginEvent(const ts::PluginEventContext& context) override;
+
+        ts::AbstractDescrambler::ECMStatistics stats;
+        size_t count;
+    };
+
+    void StatisticsHandler::handlePluginEvent(const ts::PluginEventContext& context)
+    {
+        const ts::AbstractDescrambler::ECMStatistics* data = dynamic_cast<const ts::AbstractDescrambler::ECMStatistics*>(context.pluginData());
+        if (data != nullptr) {
+            stats.streams = data->streams;
+            count++;
+        }
+    }
+}
+
+
+//----------------------------------------------------------------------------
+// Initialization.
+//----------------------------------------------------------------------------
+
+// Constructor.
+AbstractDescramblerTest::AbstractDescramblerTest() :
+    _duck(),
+    _tempFile(),
+    _packets(),
+    _clear(),
+    _cc()
+{
+}
+
+// Test suite initialization method.
+void AbstractDescramblerTest::beforeTest()
+{
+    ts::PluginRepository::Instance()->registerProcessor(u"utest_descrambler", TestDescrambler::CreateInstance);
+    ts::PluginRepository::Instance()->registerProcessor(u"utest_barrier", BarrierPlugin::CreateInstance);
+    ts::PluginRepository::Instance()->registerProcessor(u"utest_capture", CapturePlugin::CreateInstance);
+    _tempFile = ts::TempFile(u".ts");
+    _packets.clear();
+    _clear.clear();
+    TS_ZERO(_cc);
+    state.reset();
+}
+
+// Test suite cleanup method.
+void AbstractDescramblerTest::afterTest()
+{
+    ts::DeleteFile(_tempFile);
+}
+
+
+//----------------------------------------------------------------------------
+// Build the input stream.
+//----------------------------------------------------------------------------
+
+void AbstractDescramblerTest::addPackets(const ts::TSPacketVector& packets)
+{
+    for (auto it = packets.begin(); it != packets.end(); ++it) {
+        _packets.push_back(*it);
+        const ts::PID pid = it->getPID();
+        _packets.back().setCC(_cc[pid]);
+        _cc[pid] = (_cc[pid] + 1) & ts::CC_MASK;
+    }
+}
+
+void AbstractDescramblerTest::addPSI()
+{
+    ts::PAT pat(0, true, 1);
+    pat.pmts[SERVICE_ID] = PMT_PID;
+
+    ts::PMT pmt(0, true, SERVICE_ID, ES_A);
+    const ts::PID es[] = {ES_A, ES_B, ES_C};
+    const ts::PID ecm[] = {ECM_A, ECM_B, ECM_C};
+    for (size_t i = 0; i < 3; ++i) {
+        pmt.streams[es[i]].stream_type = ts::ST_MPEG2_VIDEO;
+        pmt.streams[es[i]].descs.add(_duck, ts::CADescriptor(CAS_ID, ecm[i]));
+    }
+
+    ts::TSPacketVector packets;
+    ts::OneShotPacketizer pzpat(_duck, ts::PID_PAT);
+    pzpat.addTable(_duck, pat);
+    pzpat.getPackets(packets);
+    addPackets(packets);
+
+    ts::OneShotPacketizer pzpmt(_duck, PMT_PID);
+    pzpmt.addTable(_duck, pmt);
+    pzpmt.getPackets(packets);
+    addPackets(packets);
+}
+
+// The next packet waits until the specified number of ECM's started and completed.
+void AbstractDescramblerTest::addBarrier(size_t started, size_t completed)
+{
+    Barrier& barrier(state.barriers[_packets.size()]);
+    barrier.started = started;
+    barrier.completed = completed;
+}
+
+// The gate opens when the next packet is output by the descrambler.
+void AbstractDescramblerTest::addGate()
+{
+    state.gate_packet = _packets.size();
+}
+
+void AbstractDescramblerTest::addNulls(size_t count)
+{
+    _packets.insert(_packets.end(), count, ts::NullPacket);
+}
+
+void AbstractDescramblerTest::addECM(ts::PID pid, ts::TID tid, uint8_t tag, uint8_t cw, uint8_t flags)
+{
+    const uint8_t payload[] = {tag, cw, flags};
+    ts::TSPacketVector packets;
+    ts::OneShotPacketizer pz(_duck, pid);
+    pz.addSection(ts::SectionPtr(new ts::Section(tid, true, payload, sizeof(payload))));
+    pz.getPackets(packets);
+    addPackets(packets);
+}
+
+void AbstractDescramblerTest::addScrambled(ts::PID pid, uint8_t cw, size_t count)
+{
+    ts::TSScrambling scrambler(CERR);
+    TSUNIT_ASSERT(scrambler.start());
+    TSUNIT_ASSERT(scrambler.setCW(MakeCW(cw), ts::SC_EVEN_KEY));
+    TSUNIT_ASSERT(scrambler.setEncryptParity(ts::SC_EVEN_KEY));
+
+    ts::TSPacketVector packets(count);
+    for (size_t i = 0; i < count; ++i) {
+        packets[i].init(pid, 0, uint8_t(i));
+    }
+    addPackets(packets);
+
+    for (size_t i = _packets.size() - count; i < _packets.size(); ++i) {
+        _clear.push_back(_packets[i]);
+        TSUNIT_ASSERT(scrambler.encrypt(_packets[i]));
+    }
+    scrambler.stop();
+}
+
+
+//----------------------------------------------------------------------------
+// Run the descrambler on the input stream.
+//----------------------------------------------------------------------------
+
+void AbstractDescramblerTest::run(const ts::UStringVector& options, ts::AbstractDescrambler::ECMStatistics& stats)
+{
+    ts::TSFile file;
+    TSUNIT_ASSERT(file.open(_tempFile, ts::TSFile::WRITE, CERR));
+    TSUNIT_ASSERT(file.writePackets(_packets.data(), nullptr, _packets.size(), CERR));
+    TSUNIT_ASSERT(file.close(CERR));
+
+    // Real-time mode for asynchronous ECM deciphering.
+    // Each packet is immediately passed to the next plugin, the barrier plugin never holds other packets.
+    ts::TSProcessorArgs opt;
+    opt.app_name = u"AbstractDescramblerTest";
+    opt.realtime = ts::Tristate::TRUE;
+    opt.max_flush_pkt = 1;
+    opt.input = {u"file", {_tempFile}};
+    ts::UStringVector args(options);
+    args.push_back(ts::UString::Decimal(SERVICE_ID));
+    opt.plugins = {
+        {u"utest_barrier", {}},
+        {u"utest_descrambler", args},
+        {u"utest_capture", {}},
+    };
+    opt.output = {u"drop"};
+
+    ts::TSProcessor tsproc(CERR);
+    StatisticsHandler handler;
+    ts::TSProcessor::Criteria crit;
+    crit.event_code = ts::AbstractDescrambler::EVENT_ECM_STATISTICS;
+    tsproc.registerEventHandler(&handler, crit);
+
+    TSUNIT_ASSERT(tsproc.start(opt));
+    tsproc.waitForTermination();
+
+    TSUNIT_EQUAL(1, handler.count);
+    stats.streams = handler.stats.streams;
+    TSUNIT_EQUAL(_packets.size(), state.captured);
+}
+
+
+//----------------------------------------------------------------------------
+// Unitary tests.
+//----------------------------------------------------------------------------
+
+// The most urgent ECM is deciphered first: an ECM stream without control
+// word comes before an older ECM from a stream which already has its CW.
+void AbstractDescramblerTest::testUrgency()
+{
+    addPSI();
+    addNulls(10);
+    addECM(ECM_A, ts::TID_ECM_80, 'a', 0x10);
+    addBarrier(1, 1);
+    addNulls(10);
+    addECM(ECM_C, ts::TID_ECM_80, 'c', 0x30, ECM_GATE);
+    addBarrier(2, 1);
+    addNulls(10);
+    addECM(ECM_A, ts::TID_ECM_81, 'A', 0x11);
+    addECM(ECM_B, ts::TID_ECM_80, 'b', 0x20);
+    addGate();
+    addNulls(10);
+    addBarrier(4, 4);
+    addNulls(10);
+
+    ts::AbstractDescrambler::ECMStatistics stats;
+    run({u"--ecm-threads", u"1"}, stats);
+
+    TSUNIT_EQUAL(4, state.order.size());
+    TSUNIT_EQUAL('a', state.order[0]);
+    TSUNIT_EQUAL('c', state.order[1]);
+    TSUNIT_EQUAL('b', state.order[2]);
+    TSUNIT_EQUAL('A', state.order[3]);
+    TSUNIT_EQUAL(1, state.max_active);
+
+    TSUNIT_EQUAL(3, stats.streams.size());
+    TSUNIT_EQUAL(2, stats.streams[ECM_A].ecm_count);
+    TSUNIT_EQUAL(2, stats.streams[ECM_A].ecm_ok);
+    TSUNIT_EQUAL(1, stats.streams[ECM_B].ecm_ok);
+    TSUNIT_EQUAL(1, stats.streams[ECM_C].ecm_ok);
+    TSUNIT_ASSERT(stats.streams[ECM_C].max_latency > 0);
+}
+
+// An ECM which was already deciphered on another PID is found in the cache.
+// The CW from an older ECM which completes later are ignored.
+void AbstractDescramblerTest::testCacheAndStaleCW()
+{
+    addPSI();
+    addNulls(10);
+    addECM(ECM_B, ts::TID_ECM_80, 'x', 0x40);
+    addBarrier(1, 1);
+    addNulls(10);
+    addECM(ECM_B, ts::TID_ECM_80, 'x', 0x40);  // same ECM again, ignored
+    addECM(ECM_A, ts::TID_ECM_80, 'y', 0x50, ECM_GATE);
+    addBarrier(2, 1);
+    addNulls(10);
+    addECM(ECM_A, ts::TID_ECM_80, 'x', 0x40);  // same table id, other content: new ECM, in cache
+    addGate();
+    addNulls(10);
+    addBarrier(2, 2);
+    addNulls(10);
+    addScrambled(ES_A, 0x40, 20);
+    addNulls(10);
+
+    ts::AbstractDescrambler::ECMStatistics stats;
+    run({}, stats);
+
+    TSUNIT_EQUAL(2, state.order.size());
+    TSUNIT_EQUAL('x', state.order[0]);
+    TSUNIT_EQUAL('y', state.order[1]);
+
+    TSUNIT_EQUAL(1, stats.streams[ECM_B].ecm_count);
+    TSUNIT_EQUAL(1, stats.streams[ECM_B].ecm_ok);
+    TSUNIT_EQUAL(0, stats.streams[ECM_B].cache_hits);
+    TSUNIT_EQUAL(2, stats.streams[ECM_A].ecm_count);
+    TSUNIT_EQUAL(1, stats.streams[ECM_A].ecm_ok);
+    TSUNIT_EQUAL(1, stats.streams[ECM_A].cache_hits);
+
+    // Packets are descrambled with the CW from the cache, not the stale one.
+    TSUNIT_EQUAL(_clear.size(), state.output.size());
+    for (size_t i = 0; i < _clear.size(); ++i) {
+        TSUNIT_ASSERT(state.output[i] == _clear[i]);
+    }
+}
+
+// With a cache of one ECM, an ECM is evicted by the next one.
+void AbstractDescramblerTest::testCacheEviction()
+{
+    addPSI();
+    addNulls(10);
+    addECM(ECM_B, ts::TID_ECM_80, 'x', 0x40);
+    addBarrier(1, 1);
+    addNulls(10);
+    addECM(ECM_C, ts::TID_ECM_80, 'y', 0x50);
+    addBarrier(2, 2);
+    addNulls(10);
+    addECM(ECM_A, ts::TID_ECM_80, 'z', 0x60, ECM_GATE);
+    addBarrier(3, 2);
+    addNulls(10);
+    addECM(ECM_A, ts::TID_ECM_80, 'x', 0x40);
+    addGate();
+    addNulls(10);
+    addBarrier(4, 4);
+    addNulls(10);
+
+    ts::AbstractDescrambler::ECMStatistics stats;
+    run({u"--ecm-cache", u"1"}, stats);
+
+    TSUNIT_EQUAL(4, state.order.size());
+    TSUNIT_EQUAL('x', state.order[3]);
+    TSUNIT_EQUAL(2, stats.streams[ECM_A].ecm_ok);
+    TSUNIT_EQUAL(0, stats.streams[ECM_A].cache_hits);
+}
+
+// Several ECM threads decipher ECM's from distinct ECM streams in parallel.
+void AbstractDescramblerTest::testWorkerPool()
+{
+    addPSI();
+    addNulls(10);
+    addECM(ECM_A, ts::TID_ECM_80, 'a', 0x10, ECM_PAIR);
+    addECM(ECM_B, ts::TID_ECM_80, 'b', 0x20, ECM_PAIR);
+    addECM(ECM_C, ts::TID_ECM_80, 'c', 0x30, ECM_FAIL);
+    addNulls(10);
+    addBarrier(3, 3);
+    addNulls(10);
+
+    ts::AbstractDescrambler::ECMStatistics stats;
+    run({u"--ecm-threads", u"2"}, stats);
+
+    TSUNIT_EQUAL(3, state.order.size());
+    TSUNIT_EQUAL(2, state.max_active);
+    TSUNIT_EQUAL(1, stats.streams[ECM_A].ecm_ok);
+    TSUNIT_EQUAL(1, stats.streams[ECM_B].ecm_ok);
+    TSUNIT_EQUAL(0, stats.streams[ECM_C].ecm_ok);
+    TSUNIT_EQUAL(1, stats.streams[ECM_C].ecm_errors);
+}
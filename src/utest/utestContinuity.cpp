@@ -49,10 +49,12 @@ public:
 
     void testAnalyze();
     void testFix();
+    void testFixBulk();
 
     TSUNIT_TEST_BEGIN(ContinuityTest);
     TSUNIT_TEST(testAnalyze);
     TSUNIT_TEST(testFix);
+    TSUNIT_TEST(testFixBulk);
     TSUNIT_TEST_END();
 };
 
@@ -236,3 +238,59 @@ void ContinuityTest::testFix()
     TSUNIT_EQUAL(2, fixer.errorCount());
     TSUNIT_EQUAL(5, fixer.fixCount());
 }
+
+void ContinuityTest::testFixBulk()
+{
+    ts::ReportBuffer<> log;
+    ts::ContinuityAnalyzer fixer(ts::AllPIDs, &log);
+    fixer.setFix(true);
+    fixer.removePID(102);
+
+    // Same scenario as testFix(), with null and non-processed packets in between.
+    static const struct {
+        ts::PID pid;
+        uint8_t cc_in;
+        uint8_t cc_out;
+        bool    status;
+    } scenario[] = {
+        {100, 5, 5, true},
+        {101, 13, 13, true},
+        {ts::PID_NULL, 9, 9, true},
+        {100, 6, 6, true},
+        {101, 14, 14, true},
+        {101, 14, 14, true},
+        {102, 7, 7, true},
+        {101, 15, 15, true},
+        {101, 0, 0, true},
+        {101, 3, 1, false},
+        {102, 1, 1, true},
+        {101, 4, 2, false},
+        {101, 4, 2, false},
+        {101, 4, 2, false},
+        {101, 5, 3, false},
+    };
+    constexpr size_t count = sizeof(scenario) / sizeof(scenario[0]);
+
+    ts::TSPacketVector packets(count, ts::NullPacket);
+    for (size_t i = 0; i < count; ++i) {
+        packets[i].setPID(scenario[i].pid);
+        packets[i].setCC(scenario[i].cc_in);
+    }
+
+    std::vector<bool> status;
+    TSUNIT_ASSERT(fixer.feedPackets(packets.data(), 5, &status));
+    TSUNIT_EQUAL(5, status.size());
+    TSUNIT_ASSERT(!fixer.feedPackets(packets.data() + 5, count - 5, &status));
+    TSUNIT_EQUAL(count - 5, status.size());
+
+    for (size_t i = 5; i < count; ++i) {
+        debug() << "ContinuityTest::testFixBulk: packet " << i << ", CC " << int(packets[i].getCC()) << ", status " << status[i - 5] << std::endl;
+        TSUNIT_EQUAL(scenario[i].cc_out, packets[i].getCC());
+        TSUNIT_EQUAL(scenario[i].status, bool(status[i - 5]));
+    }
+
+    TSUNIT_EQUAL(count, fixer.totalPackets());
+    TSUNIT_EQUAL(12, fixer.processedPackets());
+    TSUNIT_EQUAL(2, fixer.errorCount());
+    TSUNIT_EQUAL(5, fixer.fixCount());
+}
@@ -32,6 +32,9 @@
 //----------------------------------------------------------------------------
 
 #include "tsDVBCharset.h"
+#include "tsDVBCharTableSingleByte.h"
+#include "tsDecodedStringCache.h"
+#include "tsDuckContext.h"
 #include "tsByteBlock.h"
 #include "tsunit.h"
 TSDUCK_SOURCE;
@@ -48,10 +51,14 @@ public:
 
     void testRepository();
     void testDVB();
+    void testDecodeCache();
+    void testDuckDecodeCache();
 
     TSUNIT_TEST_BEGIN(DVBCharsetTest);
     TSUNIT_TEST(testRepository);
     TSUNIT_TEST(testDVB);
+    TSUNIT_TEST(testDecodeCache);
+    TSUNIT_TEST(testDuckDecodeCache);
     TSUNIT_TEST_END();
 };
 
@@ -103,3 +110,86 @@ void DVBCharsetTest::testDVB()
     TSUNIT_EQUAL(str1, ts::DVBCharset::DVB.decoded(dvb1, sizeof(dvb1)));
     TSUNIT_ASSERT(ts::ByteBlock(dvb1, sizeof(dvb1)) == ts::DVBCharset::DVB.encoded(str1.toDecomposedDiacritical()));
 }
+
+void DVBCharsetTest::testDecodeCache()
+{
+    static const uint8_t dvb1[] = {'a', 'b', 'c'};
+    static const uint8_t dvb2[] = {0x30, 0xC2, 0x65, 0xC3, 0x75};
+    static const uint8_t dvb3[] = {'x', 'y', 'z'};
+    const ts::UString str2{u'0', ts::LATIN_SMALL_LETTER_E_WITH_ACUTE, ts::LATIN_SMALL_LETTER_U_WITH_CIRCUMFLEX};
+
+    ts::DecodedStringCache cache(2);
+    ts::UString str;
+
+    TSUNIT_ASSERT(cache.decode(&ts::DVBCharset::DVB, str, dvb1, sizeof(dvb1)));
+    TSUNIT_EQUAL(u"abc", str);
+    TSUNIT_EQUAL(0, cache.hits());
+    TSUNIT_EQUAL(1, cache.misses());
+
+    TSUNIT_ASSERT(cache.decode(&ts::DVBCharset::DVB, str, dvb2, sizeof(dvb2)));
+    TSUNIT_EQUAL(str2, str);
+    TSUNIT_ASSERT(cache.decode(&ts::DVBCharset::DVB, str, dvb1, sizeof(dvb1)));
+    TSUNIT_EQUAL(u"abc", str);
+    TSUNIT_EQUAL(1, cache.hits());
+    TSUNIT_EQUAL(2, cache.misses());
+    TSUNIT_EQUAL(2, cache.size());
+
+    // Same binary string in another character set is a distinct entry.
+    TSUNIT_ASSERT(cache.decode(&ts::DVBCharTableSingleByte::DVB_ISO_8859_1, str, dvb2, sizeof(dvb2)));
+    TSUNIT_EQUAL(ts::UString({u'0', ts::LATIN_CAPITAL_LETTER_A_WITH_CIRCUMFLEX, u'e', ts::LATIN_CAPITAL_LETTER_A_WITH_TILDE, u'u'}), str);
+    TSUNIT_EQUAL(1, cache.hits());
+    TSUNIT_EQUAL(3, cache.misses());
+    TSUNIT_EQUAL(2, cache.size());
+
+    // Least recently used entry (dvb2 in DVB) was dropped, dvb1 is still here.
+    TSUNIT_ASSERT(cache.decode(&ts::DVBCharset::DVB, str, dvb1, sizeof(dvb1)));
+    TSUNIT_EQUAL(2, cache.hits());
+    TSUNIT_ASSERT(cache.decode(&ts::DVBCharset::DVB, str, dvb2, sizeof(dvb2)));
+    TSUNIT_EQUAL(str2, str);
+    TSUNIT_EQUAL(2, cache.hits());
+    TSUNIT_EQUAL(4, cache.misses());
+
+    // String with byte length.
+    static const uint8_t dvb4[] = {3, 'x', 'y', 'z', 0xFF};
+    const uint8_t* data = dvb4;
+    size_t size = sizeof(dvb4);
+    TSUNIT_ASSERT(cache.decodeWithByteLength(&ts::DVBCharset::DVB, str, data, size));
+    TSUNIT_EQUAL(u"xyz", str);
+    TSUNIT_ASSERT(data == dvb4 + 4);
+    TSUNIT_EQUAL(1, size);
+    TSUNIT_ASSERT(cache.decode(&ts::DVBCharset::DVB, str, dvb3, sizeof(dvb3)));
+    TSUNIT_EQUAL(3, cache.hits());
+
+    cache.setMaxEntries(1);
+    TSUNIT_EQUAL(1, cache.size());
+    cache.clear();
+    TSUNIT_EQUAL(0, cache.size());
+    TSUNIT_EQUAL(0, cache.hits());
+    TSUNIT_EQUAL(0, cache.misses());
+
+    // Disabled cache.
+    cache.setMaxEntries(0);
+    TSUNIT_ASSERT(cache.decode(&ts::DVBCharset::DVB, str, dvb2, sizeof(dvb2)));
+    TSUNIT_EQUAL(str2, str);
+    TSUNIT_EQUAL(0, cache.size());
+    TSUNIT_EQUAL(0, cache.misses());
+}
+
+void DVBCharsetTest::testDuckDecodeCache()
+{
+    static const uint8_t dvb[] = {'S', 'e', 'r', 'v', 'i', 'c', 'e', ' ', '1'};
+
+    ts::DuckContext duck;
+    TSUNIT_EQUAL(0, duck.decodeCache().maxEntries());
+    duck.setDecodeCacheSize(10);
+
+    for (size_t i = 0; i < 5; ++i) {
+        TSUNIT_EQUAL(u"Service 1", duck.decoded(dvb, sizeof(dvb)));
+    }
+    TSUNIT_EQUAL(1, duck.decodeCache().misses());
+    TSUNIT_EQUAL(4, duck.decodeCache().hits());
+
+    duck.reset();
+    TSUNIT_EQUAL(0, duck.decodeCache().maxEntries());
+    TSUNIT_EQUAL(0, duck.decodeCache().size());
+}
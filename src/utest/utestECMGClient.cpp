@@ -0,0 +1,292 @@
+//----------------------------------------------------------------------------
+//
+// TSDuck - The MPEG Transport Stream Toolkit
+// Copyright (c) 2005-2020, Thierry Lelegard
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+// THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------
+//
+//  TSUnit test suite for class ts::ECMGClient
+//
+//----------------------------------------------------------------------------
+
+#include "tsECMGClient.h"
+#include "tsECMGClientArgs.h"
+#include "tsECMGSCS.h"
+#include "tstlvConnection.h"
+#include "tsTCPServer.h"
+#include "tsIPUtils.h"
+#include "tsSysUtils.h"
+#include "tsCerrReport.h"
+#include "tsunit.h"
+#include "utestTSUnitThread.h"
+TSDUCK_SOURCE;
+
+
+//----------------------------------------------------------------------------
+// The test fixture
+//----------------------------------------------------------------------------
+
+class ECMGClientTest: public tsunit::Test
+{
+public:
+    virtual void beforeTest() override;
+    virtual void afterTest() override;
+
+    void testMultiStream();
+
+    TSUNIT_TEST_BEGIN(ECMGClientTest);
+    TSUNIT_TEST(testMultiStream);
+    TSUNIT_TEST_END();
+};
+
+TSUNIT_REGISTER(ECMGClientTest);
+
+
+//----------------------------------------------------------------------------
+// Initialization.
+//----------------------------------------------------------------------------
+
+// Test suite initialization method.
+void ECMGClientTest::beforeTest()
+{
+}
+
+// Test suite cleanup method.
+void ECMGClientTest::afterTest()
+{
+}
+
+
+//----------------------------------------------------------------------------
+// A minimal ECMG, serving one client session, in a separate thread.
+// The ECM datagram contains the stream id and CP number of the request.
+//----------------------------------------------------------------------------
+
+namespace {
+    class FakeECMG: public utest::TSUnitThread
+    {
+        TS_NOBUILD_NOCOPY(FakeECMG);
+    private:
+        ts::TCPServer& _server;
+    public:
+        size_t requestCount;
+
+        explicit FakeECMG(ts::TCPServer& server) :
+            utest::TSUnitThread(),
+            _server(server),
+            requestCount(0)
+        {
+        }
+
+        ~FakeECMG()
+        {
+            waitForTermination();
+        }
+
+        virtual void test() override
+        {
+            ts::tlv::Connection<ts::Mutex> conn(ts::ecmgscs::Protocol::Instance(), true, 3);
+            ts::SocketAddress client;
+            TSUNIT_ASSERT(_server.accept(conn, client, CERR));
+
+            ts::tlv::MessagePtr msg;
+            bool ok = true;
+            while (ok && conn.receive(msg, nullptr, NULLREP)) {
+                switch (msg->tag()) {
+                    case ts::ecmgscs::Tags::channel_setup: {
+                        const ts::ecmgscs::ChannelSetup* req = dynamic_cast<const ts::ecmgscs::ChannelSetup*>(msg.pointer());
+                        TSUNIT_ASSERT(req != nullptr);
+                        ts::ecmgscs::ChannelStatus resp;
+                        resp.channel_id = req->channel_id;
+                        resp.lead_CW = 1;
+                        resp.CW_per_msg = 2;
+                        resp.max_streams = 16;
+                        ok = conn.send(resp, CERR);
+                        break;
+                    }
+                    case ts::ecmgscs::Tags::stream_setup: {
+                        const ts::ecmgscs::StreamSetup* req = dynamic_cast<const ts::ecmgscs::StreamSetup*>(msg.pointer());
+                        TSUNIT_ASSERT(req != nullptr);
+                        ts::ecmgscs::StreamStatus resp;
+                        resp.channel_id = req->channel_id;
+                        resp.stream_id = req->stream_id;
+                        resp.ECM_id = req->ECM_id;
+                        ok = conn.send(resp, CERR);
+                        break;
+                    }
+                    case ts::ecmgscs::Tags::CW_provision: {
+                        const ts::ecmgscs::CWProvision* req = dynamic_cast<const ts::ecmgscs::CWProvision*>(msg.pointer());
+                        TSUNIT_ASSERT(req != nullptr);
+                        requestCount++;
+                        ts::ecmgscs::ECMResponse resp;
+                        resp.channel_id = req->channel_id;
+                        resp.stream_id = req->stream_id;
+                        resp.CP_number = req->CP_number;
+                        resp.ECM_datagram.appendUInt16(req->stream_id);
+                        resp.ECM_datagram.appendUInt16(req->CP_number);
+                        ok = conn.send(resp, CERR);
+                        break;
+                    }
+                    case ts::ecmgscs::Tags::stream_close_request: {
+                        const ts::ecmgscs::StreamCloseRequest* req = dynamic_cast<const ts::ecmgscs::StreamCloseRequest*>(msg.pointer());
+                        TSUNIT_ASSERT(req != nullptr);
+                        ts::ecmgscs::StreamCloseResponse resp;
+                        resp.channel_id = req->channel_id;
+                        resp.stream_id = req->stream_id;
+                        ok = conn.send(resp, CERR);
+                        break;
+                    }
+                    case ts::ecmgscs::Tags::channel_close:
+                        ok = false;
+                        break;
+                    default:
+                        break;
+                }
+            }
+            conn.disconnect(NULLREP);
+            conn.close(NULLREP);
+        }
+    };
+
+    // Collect asynchronous ECM responses.
+    class ECMCollector: public ts::ECMGClientHandlerInterface
+    {
+        TS_NOCOPY(ECMCollector);
+    public:
+        ECMCollector(uint16_t stream_id, uint16_t cp_number) :
+            expectedStream(stream_id),
+            expectedCP(cp_number),
+            received(false),
+            valid(false)
+        {
+        }
+
+        const uint16_t expectedStream;
+        const uint16_t expectedCP;
+        volatile bool  received;
+        volatile bool  valid;
+
+        virtual void handleECM(const ts::ecmgscs::ECMResponse& resp) override
+        {
+            valid = resp.stream_id == expectedStream &&
+                resp.CP_number == expectedCP &&
+                resp.ECM_datagram.size() == 4 &&
+                ts::GetUInt16(resp.ECM_datagram.data()) == expectedStream &&
+                ts::GetUInt16(resp.ECM_datagram.data() + 2) == expectedCP;
+            received = true;
+        }
+    };
+
+    typedef ts::SafePtr<ECMCollector> ECMCollectorPtr;
+}
+
+
+//----------------------------------------------------------------------------
+// Unitary tests.
+//----------------------------------------------------------------------------
+
+void ECMGClientTest::testMultiStream()
+{
+    TSUNIT_ASSERT(ts::IPInitialize());
+
+    const uint16_t portNumber = 12347;
+    const ts::SocketAddress serverAddress(ts::IPAddress::LocalHost, portNumber);
+    ts::TCPServer server;
+    TSUNIT_ASSERT(server.open(CERR));
+    TSUNIT_ASSERT(server.reusePort(true, CERR));
+    TSUNIT_ASSERT(server.bind(serverAddress, CERR));
+    TSUNIT_ASSERT(server.listen(5, CERR));
+
+    FakeECMG ecmg(server);
+    TSUNIT_ASSERT(ecmg.start());
+
+    ts::ECMGClientArgs args;
+    args.ecmg_address = serverAddress;
+    args.super_cas_id = 0x12345678;
+    args.cp_duration = 10000;
+    args.ecm_channel_id = 1;
+    args.ecm_stream_id = 10;
+    args.ecm_id = 20;
+
+    ts::tlv::Logger logger(ts::Severity::Debug, &NULLREP);
+    ts::ecmgscs::ChannelStatus channel_status;
+    ts::ecmgscs::StreamStatus stream_status;
+    ts::ECMGClient client;
+    TSUNIT_ASSERT(client.connect(args, channel_status, stream_status, nullptr, logger));
+    TSUNIT_ASSERT(client.isConnected());
+    TSUNIT_EQUAL(10, stream_status.stream_id);
+    TSUNIT_EQUAL(20, stream_status.ECM_id);
+
+    // Two more streams in the same channel. A duplicate stream id is rejected.
+    const size_t stream_count = 3;
+    for (uint16_t i = 1; i < stream_count; ++i) {
+        ts::ecmgscs::StreamStatus status;
+        TSUNIT_ASSERT(client.addStream(uint16_t(10 + i), uint16_t(20 + i), args.cp_duration, status));
+        TSUNIT_EQUAL(10 + i, status.stream_id);
+        TSUNIT_EQUAL(20 + i, status.ECM_id);
+    }
+    ts::ecmgscs::StreamStatus dup_status;
+    TSUNIT_ASSERT(!client.addStream(11, 30, args.cp_duration, dup_status));
+
+    // Synchronous ECM generation on the second stream.
+    const ts::ByteBlock cw1(8, 0x11);
+    const ts::ByteBlock cw2(8, 0x22);
+    ts::ecmgscs::ECMResponse response;
+    TSUNIT_ASSERT(client.generateECM(11, 5, cw1, cw2, ts::ByteBlock(), 100, response));
+    TSUNIT_EQUAL(11, response.stream_id);
+    TSUNIT_EQUAL(5, response.CP_number);
+
+    // Pipeline asynchronous requests on all streams, with the same CP numbers in all streams.
+    const uint16_t cp_count = 8;
+    std::vector<ECMCollectorPtr> collectors;
+    for (uint16_t cp = 0; cp < cp_count; ++cp) {
+        for (uint16_t i = 0; i < stream_count; ++i) {
+            collectors.push_back(ECMCollectorPtr(new ECMCollector(uint16_t(10 + i), cp)));
+            TSUNIT_ASSERT(client.submitECM(uint16_t(10 + i), cp, cw1, cw2, ts::ByteBlock(), 100, collectors.back().pointer()));
+        }
+    }
+
+    // Wait for all responses, at most 5 seconds.
+    bool all_received = false;
+    for (int loop = 0; !all_received && loop < 500; ++loop) {
+        all_received = true;
+        for (size_t i = 0; all_received && i < collectors.size(); ++i) {
+            all_received = collectors[i]->received;
+        }
+        if (!all_received) {
+            ts::SleepThread(10);
+        }
+    }
+    TSUNIT_ASSERT(all_received);
+    for (size_t i = 0; i < collectors.size(); ++i) {
+        TSUNIT_ASSERT(collectors[i]->valid);
+    }
+
+    TSUNIT_ASSERT(client.disconnect());
+    TSUNIT_ASSERT(!client.isConnected());
+    ecmg.waitForTermination();
+    TSUNIT_EQUAL(1 + stream_count * cp_count, ecmg.requestCount);
+    TSUNIT_ASSERT(server.close(CERR));
+}
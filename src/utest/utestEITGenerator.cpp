@@ -0,0 +1,481 @@
+//----------------------------------------------------------------------------
+//
+// TSDuck - The MPEG Transport Stream Toolkit
+// Copyright (c) 2005-2020, Thierry Lelegard
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+// THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------
+//
+//  TSUnit test suite for class ts::EITGenerator
+//
+//----------------------------------------------------------------------------
+
+#include "tsEITGenerator.h"
+#include "tsShortEventDescriptor.h"
+#include "tsDuckContext.h"
+#include "tsReportBuffer.h"
+#include "tsunit.h"
+TSDUCK_SOURCE;
+
+
+//----------------------------------------------------------------------------
+// The test fixture
+//----------------------------------------------------------------------------
+
+class EITGeneratorTest: public tsunit::Test
+{
+public:
+    EITGeneratorTest();
+
+    virtual void beforeTest() override;
+    virtual void afterTest() override;
+
+    void testSchedule();
+    void testIncremental();
+    void testLastTableId();
+    void testPresentFollowing();
+    void testNewDay();
+    void testReplace();
+    void testLargeStore();
+    void testDroppedEvents();
+
+    TSUNIT_TEST_BEGIN(EITGeneratorTest);
+    TSUNIT_TEST(testSchedule);
+    TSUNIT_TEST(testIncremental);
+    TSUNIT_TEST(testLastTableId);
+    TSUNIT_TEST(testPresentFollowing);
+    TSUNIT_TEST(testNewDay);
+    TSUNIT_TEST(testReplace);
+    TSUNIT_TEST(testLargeStore);
+    TSUNIT_TEST(testDroppedEvents);
+    TSUNIT_TEST_END();
+
+private:
+    ts::DuckContext _duck;
+
+    // Build EIT sections with consecutive events of one hour, starting at a given time.
+    void buildEvents(ts::SectionPtrVector& sections, uint16_t service_id, uint16_t first_event_id, const ts::Time& start, size_t count, const ts::UString& name = u"event");
+
+    // Get the sections of a given table id.
+    static void GetTable(const ts::SectionPtrVector& all, ts::TID tid, ts::SectionPtrVector& sections);
+
+    // Get the event ids in a list of EIT sections (schedule sub-tables are sparse and cannot be deserialized as one table).
+    static void GetEventIds(const ts::SectionPtrVector& sections, std::vector<uint16_t>& ids);
+
+    // Check if a list of EIT sections contains a given string.
+    static bool Contains(const ts::SectionPtrVector& sections, const std::string& str);
+};
+
+TSUNIT_REGISTER(EITGeneratorTest);
+
+
+//----------------------------------------------------------------------------
+// Initialization.
+//----------------------------------------------------------------------------
+
+// Constructor.
+EITGeneratorTest::EITGeneratorTest() :
+    _duck()
+{
+}
+
+// Test suite initialization method.
+void EITGeneratorTest::beforeTest()
+{
+}
+
+// Test suite cleanup method.
+void EITGeneratorTest::afterTest()
+{
+}
+
+
+//----------------------------------------------------------------------------
+// Test utilities.
+//----------------------------------------------------------------------------
+
+void EITGeneratorTest::buildEvents(ts::SectionPtrVector& sections, uint16_t service_id, uint16_t first_event_id, const ts::Time& start, size_t count, const ts::UString& name)
+{
+    ts::EIT eit(true, false, 0, 0, true, service_id, 10, 20);
+    for (size_t i = 0; i < count; ++i) {
+        ts::EIT::Event& ev(eit.events.newEntry());
+        ev.event_id = uint16_t(first_event_id + i);
+        ev.start_time = start + ts::MilliSecond(i) * ts::MilliSecPerHour;
+        ev.duration = 3600;
+        ev.running_status = 0;
+        ev.descs.add(_duck, ts::ShortEventDescriptor(u"eng", name, u"description"));
+    }
+    ts::BinaryTable table;
+    eit.serialize(_duck, table);
+    TSUNIT_ASSERT(table.isValid());
+    for (size_t i = 0; i < table.sectionCount(); ++i) {
+        sections.push_back(table.sectionAt(i));
+    }
+}
+
+void EITGeneratorTest::GetTable(const ts::SectionPtrVector& all, ts::TID tid, ts::SectionPtrVector& sections)
+{
+    sections.clear();
+    for (auto it = all.begin(); it != all.end(); ++it) {
+        if ((*it)->tableId() == tid) {
+            sections.push_back(*it);
+        }
+    }
+}
+
+
+void EITGeneratorTest::GetEventIds(const ts::SectionPtrVector& sections, std::vector<uint16_t>& ids)
+{
+    ids.clear();
+    for (auto it = sections.begin(); it != sections.end(); ++it) {
+        const uint8_t* data = (*it)->payload() + 6;
+        size_t size = (*it)->payloadSize() - 6;
+        while (size >= 12) {
+            ids.push_back(ts::GetUInt16(data));
+            const size_t len = std::min<size_t>(size, 12 + (ts::GetUInt16(data + 10) & 0x0FFF));
+            data += len;
+            size -= len;
+        }
+    }
+}
+
+bool EITGeneratorTest::Contains(const ts::SectionPtrVector& sections, const std::string& str)
+{
+    for (auto it = sections.begin(); it != sections.end(); ++it) {
+        const std::string content(reinterpret_cast<const char*>((*it)->content()), (*it)->size());
+        if (content.find(str) != std::string::npos) {
+            return true;
+        }
+    }
+    return false;
+}
+
+
+//----------------------------------------------------------------------------
+// Test cases
+//----------------------------------------------------------------------------
+
+void EITGeneratorTest::testSchedule()
+{
+    ts::EITGenerator gen(_duck);
+    gen.setCurrentTime(ts::Time(2020, 6, 1, 10, 30));
+
+    // Two days of hourly events, starting at midnight.
+    ts::SectionPtrVector input;
+    buildEvents(input, 1, 0, ts::Time(2020, 6, 1, 0, 0), 48);
+    gen.loadEvents(input);
+    TSUNIT_EQUAL(48, gen.eventCount());
+
+    ts::SectionPtrVector all;
+    gen.getSections(all);
+
+    // EIT p/f: present is event 10, following is event 11.
+    ts::SectionPtrVector pf;
+    GetTable(all, ts::TID_EIT_PF_ACT, pf);
+    TSUNIT_EQUAL(2, pf.size());
+    ts::BinaryTable pf_table(pf);
+    TSUNIT_ASSERT(pf_table.isValid());
+    ts::EIT pf_eit(_duck, pf_table);
+    TSUNIT_ASSERT(pf_eit.isValid());
+    TSUNIT_EQUAL(1, pf_eit.service_id);
+    TSUNIT_EQUAL(10, pf_eit.ts_id);
+    TSUNIT_EQUAL(20, pf_eit.onetw_id);
+    TSUNIT_EQUAL(2, pf_eit.events.size());
+    TSUNIT_EQUAL(10, pf_eit.events[0].event_id);
+    TSUNIT_EQUAL(11, pf_eit.events[1].event_id);
+
+    // EIT schedule: 16 segments of 3 hours in one sub-table, one section per segment.
+    ts::SectionPtrVector sched;
+    GetTable(all, ts::TID_EIT_S_ACT_MIN, sched);
+    TSUNIT_EQUAL(16, sched.size());
+    for (size_t i = 0; i < sched.size(); ++i) {
+        TSUNIT_EQUAL(i * 8, sched[i]->sectionNumber());
+        TSUNIT_EQUAL(120, sched[i]->lastSectionNumber());
+        TSUNIT_EQUAL(i * 8, sched[i]->payload()[4]);               // segment_last_section_number
+        TSUNIT_EQUAL(ts::TID_EIT_S_ACT_MIN, sched[i]->payload()[5]); // last_table_id
+    }
+    std::vector<uint16_t> ids;
+    GetEventIds(sched, ids);
+    TSUNIT_EQUAL(48, ids.size());
+    for (size_t i = 0; i < ids.size(); ++i) {
+        TSUNIT_EQUAL(i, ids[i]);
+    }
+    TSUNIT_EQUAL(all.size(), pf.size() + sched.size());
+
+    // Packets are generated on the EIT PID.
+    ts::TSPacket pkt;
+    TSUNIT_ASSERT(gen.getNextPacket(pkt));
+    TSUNIT_EQUAL(ts::PID_EIT, pkt.getPID());
+}
+
+void EITGeneratorTest::testIncremental()
+{
+    ts::EITGenerator gen(_duck);
+    gen.setCurrentTime(ts::Time(2020, 6, 1, 10, 30));
+
+    ts::SectionPtrVector input;
+    buildEvents(input, 1, 0, ts::Time(2020, 6, 1, 0, 0), 48);
+    buildEvents(input, 2, 0, ts::Time(2020, 6, 1, 0, 0), 48);
+    gen.loadEvents(input);
+
+    ts::SectionPtrVector all;
+    gen.getSections(all);
+    const size_t serialized = gen.serializedSegmentCount();
+    TSUNIT_EQUAL(32, serialized);
+    const uint8_t version1 = all[2]->version();
+    const uint8_t version2 = all[20]->version();
+    TSUNIT_EQUAL(ts::TID_EIT_S_ACT_MIN, all[2]->tableId());
+    TSUNIT_EQUAL(1, all[2]->tableIdExtension());
+    TSUNIT_EQUAL(2, all[20]->tableIdExtension());
+
+    // Reloading identical events does not change anything.
+    gen.loadEvents(input);
+    gen.regenerate();
+    TSUNIT_EQUAL(serialized, gen.serializedSegmentCount());
+
+    // Update one event in the second day of service 2: only one segment is serialized again.
+    ts::SectionPtrVector update;
+    buildEvents(update, 2, 30, ts::Time(2020, 6, 2, 6, 0), 1, u"updated");
+    gen.loadEvents(update);
+    ts::SectionPtrVector all2;
+    gen.getSections(all2);
+    TSUNIT_EQUAL(serialized + 1, gen.serializedSegmentCount());
+    TSUNIT_EQUAL(all.size(), all2.size());
+    TSUNIT_EQUAL(version1, all2[2]->version());
+    TSUNIT_EQUAL((version2 + 1) & 0x1F, all2[20]->version());
+    TSUNIT_EQUAL(48, gen.eventCount() / 2);
+
+    // The updated event is in the new schedule.
+    ts::SectionPtrVector sched;
+    for (auto it = all2.begin(); it != all2.end(); ++it) {
+        if ((*it)->tableId() == ts::TID_EIT_S_ACT_MIN && (*it)->tableIdExtension() == 2) {
+            sched.push_back(*it);
+        }
+    }
+    std::vector<uint16_t> ids;
+    GetEventIds(sched, ids);
+    TSUNIT_EQUAL(48, ids.size());
+    TSUNIT_ASSERT(Contains(sched, "updated"));
+}
+
+void EITGeneratorTest::testLastTableId()
+{
+    ts::EITGenerator gen(_duck);
+    gen.setCurrentTime(ts::Time(2020, 6, 1, 10, 30));
+
+    ts::SectionPtrVector input;
+    buildEvents(input, 1, 0, ts::Time(2020, 6, 1, 0, 0), 24);
+    gen.loadEvents(input);
+
+    // Add an event on day 5: a second sub-table is needed and last_table_id is updated everywhere.
+    ts::SectionPtrVector update;
+    buildEvents(update, 1, 100, ts::Time(2020, 6, 5, 1, 0), 1);
+    gen.loadEvents(update);
+
+    ts::SectionPtrVector all, sched1, sched2;
+    gen.getSections(all);
+    GetTable(all, ts::TID_EIT_S_ACT_MIN, sched1);
+    GetTable(all, ts::TID_EIT_S_ACT_MIN + 1, sched2);
+    TSUNIT_EQUAL(32, sched1.size());
+    TSUNIT_EQUAL(1, sched2.size());
+    TSUNIT_EQUAL(248, sched1[0]->lastSectionNumber());
+    TSUNIT_EQUAL(0, sched2[0]->lastSectionNumber());
+    TSUNIT_EQUAL(ts::TID_EIT_S_ACT_MIN + 1, sched1[0]->payload()[5]);
+    TSUNIT_EQUAL(ts::TID_EIT_S_ACT_MIN + 1, sched2[0]->payload()[5]);
+
+    // Remove it: back to one sub-table.
+    TSUNIT_EQUAL(1, gen.removeEvents(ts::ServiceIdTriplet(1, 10, 20), ts::Time(2020, 6, 3, 0, 0)));
+    gen.getSections(all);
+    GetTable(all, ts::TID_EIT_S_ACT_MIN, sched1);
+    GetTable(all, ts::TID_EIT_S_ACT_MIN + 1, sched2);
+    TSUNIT_EQUAL(8, sched1.size());
+    TSUNIT_EQUAL(0, sched2.size());
+    TSUNIT_EQUAL(ts::TID_EIT_S_ACT_MIN, sched1[0]->payload()[5]);
+}
+
+void EITGeneratorTest::testPresentFollowing()
+{
+    ts::EITGenerator gen(_duck);
+    gen.setCurrentTime(ts::Time(2020, 6, 1, 10, 30));
+
+    ts::SectionPtrVector input;
+    buildEvents(input, 1, 0, ts::Time(2020, 6, 1, 0, 0), 24);
+    gen.loadEvents(input);
+
+    ts::SectionPtrVector all, pf;
+    gen.getSections(all);
+    GetTable(all, ts::TID_EIT_PF_ACT, pf);
+    TSUNIT_EQUAL(2, pf.size());
+    const uint8_t version = pf[0]->version();
+    const size_t serialized = gen.serializedSegmentCount();
+
+    // Same event: no change.
+    gen.setCurrentTime(ts::Time(2020, 6, 1, 10, 59));
+    gen.getSections(all);
+    GetTable(all, ts::TID_EIT_PF_ACT, pf);
+    TSUNIT_EQUAL(version, pf[0]->version());
+
+    // Next event.
+    gen.setCurrentTime(ts::Time(2020, 6, 1, 11, 0));
+    gen.getSections(all);
+    GetTable(all, ts::TID_EIT_PF_ACT, pf);
+    TSUNIT_EQUAL(2, pf.size());
+    TSUNIT_EQUAL((version + 1) & 0x1F, pf[0]->version());
+    ts::EIT eit(_duck, ts::BinaryTable(pf));
+    TSUNIT_ASSERT(eit.isValid());
+    TSUNIT_EQUAL(2, eit.events.size());
+    TSUNIT_EQUAL(11, eit.events[0].event_id);
+    TSUNIT_EQUAL(12, eit.events[1].event_id);
+    TSUNIT_EQUAL(serialized, gen.serializedSegmentCount());
+
+    // After the last event, the service has no more event and no EIT p/f.
+    gen.setCurrentTime(ts::Time(2020, 6, 2, 0, 0, 1));
+    gen.getSections(all);
+    GetTable(all, ts::TID_EIT_PF_ACT, pf);
+    TSUNIT_EQUAL(0, gen.eventCount());
+    TSUNIT_EQUAL(0, pf.size());
+}
+
+void EITGeneratorTest::testNewDay()
+{
+    ts::EITGenerator gen(_duck);
+    gen.setCurrentTime(ts::Time(2020, 6, 1, 22, 30));
+
+    ts::SectionPtrVector input;
+    buildEvents(input, 1, 0, ts::Time(2020, 6, 1, 0, 0), 48);
+    gen.loadEvents(input);
+
+    ts::SectionPtrVector all, sched;
+    gen.getSections(all);
+    GetTable(all, ts::TID_EIT_S_ACT_MIN, sched);
+    TSUNIT_EQUAL(16, sched.size());
+
+    // Next day: the events of the previous day are purged, the schedule starts at the new midnight.
+    gen.setCurrentTime(ts::Time(2020, 6, 2, 0, 30));
+    gen.getSections(all);
+    TSUNIT_EQUAL(24, gen.eventCount());
+    GetTable(all, ts::TID_EIT_S_ACT_MIN, sched);
+    TSUNIT_EQUAL(8, sched.size());
+    std::vector<uint16_t> ids;
+    GetEventIds(sched, ids);
+    TSUNIT_EQUAL(24, ids.size());
+    TSUNIT_EQUAL(24, ids[0]);
+}
+
+void EITGeneratorTest::testReplace()
+{
+    ts::EITGenerator gen(_duck);
+    gen.setCurrentTime(ts::Time(2020, 6, 1, 10, 30));
+
+    ts::SectionPtrVector input;
+    buildEvents(input, 1, 0, ts::Time(2020, 6, 1, 0, 0), 24);
+    buildEvents(input, 2, 0, ts::Time(2020, 6, 1, 0, 0), 24);
+    gen.loadEvents(input);
+    TSUNIT_EQUAL(48, gen.eventCount());
+
+    // New content: service 2 is gone, service 1 has only 12 events.
+    ts::SectionPtrVector replace;
+    buildEvents(replace, 1, 0, ts::Time(2020, 6, 1, 0, 0), 12);
+    gen.replaceEvents(replace);
+    TSUNIT_EQUAL(12, gen.eventCount());
+
+    ts::SectionPtrVector all;
+    gen.getSections(all);
+    for (auto it = all.begin(); it != all.end(); ++it) {
+        TSUNIT_EQUAL(1, (*it)->tableIdExtension());
+    }
+    TSUNIT_EQUAL(all.size(), gen.packetizer().storedSectionCount());
+}
+
+void EITGeneratorTest::testLargeStore()
+{
+    const size_t services = 300;
+    const size_t days = 7;
+    const size_t updates = 100;
+
+    ts::EITGenerator gen(_duck);
+    gen.setCurrentTime(ts::Time(2020, 6, 1, 10, 30));
+
+    ts::SectionPtrVector input;
+    for (size_t srv = 1; srv <= services; ++srv) {
+        buildEvents(input, uint16_t(srv), 0, ts::Time(2020, 6, 1, 0, 0), days * 24);
+    }
+    gen.loadEvents(input);
+    gen.regenerate();
+    TSUNIT_EQUAL(services * days * 24, gen.eventCount());
+
+    // Each single event update serializes exactly one segment.
+    ts::SectionPtrVector update;
+    for (size_t i = 0; i < updates; ++i) {
+        buildEvents(update, uint16_t(1 + (i * 7) % services), uint16_t(i % (days * 24)), ts::Time(2020, 6, 1, 0, 0) + ts::MilliSecond(i % (days * 24)) * ts::MilliSecPerHour, 1, ts::UString::Format(u"update %d", {i}));
+    }
+    const size_t serialized = gen.serializedSegmentCount();
+    for (size_t i = 0; i < updates; ++i) {
+        gen.loadEvents(*update[i]);
+        gen.regenerate();
+    }
+    TSUNIT_EQUAL(serialized + updates, gen.serializedSegmentCount());
+    TSUNIT_EQUAL(services * days * 24, gen.eventCount());
+    TSUNIT_EQUAL(0, gen.droppedEventCount());
+}
+
+void EITGeneratorTest::testDroppedEvents()
+{
+    ts::ReportBuffer<> log;
+    ts::DuckContext duck(&log);
+    ts::EITGenerator gen(duck);
+    gen.setCurrentTime(ts::Time(2020, 6, 1, 0, 30));
+
+    // 250 events of 30 seconds with large descriptors in the first 3-hour segment:
+    // about 18 events per section, they cannot fit in the 8 sections of a segment.
+    const size_t count = 250;
+    const ts::UString text(100, u'x');
+    ts::EIT eit(true, false, 0, 0, true, 1, 10, 20);
+    for (size_t i = 0; i < count; ++i) {
+        ts::EIT::Event& ev(eit.events.newEntry());
+        ev.event_id = uint16_t(i);
+        ev.start_time = ts::Time(2020, 6, 1, 0, 0) + ts::MilliSecond(i) * 30 * ts::MilliSecPerSec;
+        ev.duration = 30;
+        ev.running_status = 0;
+        ev.descs.add(duck, ts::ShortEventDescriptor(u"eng", text, text));
+    }
+    ts::BinaryTable table;
+    eit.serialize(duck, table);
+    TSUNIT_ASSERT(table.isValid());
+
+    gen.loadEvents(table);
+    TSUNIT_EQUAL(count, gen.eventCount());
+
+    ts::SectionPtrVector all;
+    ts::SectionPtrVector sched;
+    gen.getSections(all);
+    GetTable(all, ts::TID_EIT_S_ACT_MIN, sched);
+    TSUNIT_EQUAL(size_t(ts::EIT::SECTIONS_PER_SEGMENT), sched.size());
+
+    std::vector<uint16_t> ids;
+    GetEventIds(sched, ids);
+    TSUNIT_ASSERT(ids.size() < count);
+    TSUNIT_EQUAL(count - ids.size(), gen.droppedEventCount());
+    TSUNIT_ASSERT(log.getMessages().contain(u"events dropped"));
+}
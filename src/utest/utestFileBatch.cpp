@@ -0,0 +1,226 @@
+//----------------------------------------------------------------------------
+//
+// TSDuck - The MPEG Transport Stream Toolkit
+// Copyright (c) 2005-2020, Thierry Lelegard
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+// THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------
+//
+//  TSUnit test suite for class ts::FileBatch.
+//
+//----------------------------------------------------------------------------
+
+#include "tsFileBatch.h"
+#include "tsReportBuffer.h"
+#include "tsSysUtils.h"
+#include "tsGuard.h"
+#include "tsjson.h"
+#include "tsjsonNumber.h"
+#include "tsunit.h"
+TSDUCK_SOURCE;
+
+
+//----------------------------------------------------------------------------
+// The test fixture
+//----------------------------------------------------------------------------
+
+class FileBatchTest: public tsunit::Test
+{
+public:
+    FileBatchTest();
+
+    virtual void beforeTest() override;
+    virtual void afterTest() override;
+
+    void testCommonOutput();
+    void testOutputDirectory();
+
+    TSUNIT_TEST_BEGIN(FileBatchTest);
+    TSUNIT_TEST(testCommonOutput);
+    TSUNIT_TEST(testOutputDirectory);
+    TSUNIT_TEST_END();
+
+private:
+    ts::UString _tempDir;
+    ts::UString reportName(const ts::UString& name) const { return _tempDir + ts::PathSeparator + name; }
+};
+
+TSUNIT_REGISTER(FileBatchTest);
+
+
+//----------------------------------------------------------------------------
+// Initialization.
+//----------------------------------------------------------------------------
+
+// Constructor.
+FileBatchTest::FileBatchTest() :
+    _tempDir()
+{
+}
+
+// Test suite initialization method.
+void FileBatchTest::beforeTest()
+{
+    if (_tempDir.empty()) {
+        _tempDir = ts::TempFile(u".batch");
+    }
+}
+
+// Test suite cleanup method.
+void FileBatchTest::afterTest()
+{
+    if (ts::IsDirectory(_tempDir)) {
+        ts::UStringVector files;
+        ts::ExpandWildcard(files, _tempDir + ts::PathSeparator + u"*");
+        for (auto it = files.begin(); it != files.end(); ++it) {
+            ts::DeleteFile(*it);
+        }
+        ts::DeleteFile(_tempDir);
+    }
+}
+
+
+//----------------------------------------------------------------------------
+// A test handler: the "processing" of a file is a short sleep, files with a
+// name starting with "bad" fail. Track the number of concurrent invocations.
+//----------------------------------------------------------------------------
+
+namespace {
+    class TestHandler: public ts::FileBatchHandlerInterface
+    {
+        TS_NOCOPY(TestHandler);
+    public:
+        TestHandler() : calls(0), active(0), max_active(0), _mutex() {}
+        size_t calls;
+        size_t active;
+        size_t max_active;
+        virtual bool handleBatchFile(ts::FileBatch& batch, const ts::UString& fileName, std::ostream& output, ts::json::Object& summary, ts::Report& report) override;
+    private:
+        ts::Mutex _mutex;
+    };
+}
+
+bool TestHandler::handleBatchFile(ts::FileBatch& batch, const ts::UString& fileName, std::ostream& output, ts::json::Object& summary, ts::Report& report)
+{
+    {
+        ts::Guard lock(_mutex);
+        calls++;
+        max_active = std::max(max_active, ++active);
+    }
+    ts::SleepThread(10);
+    {
+        ts::Guard lock(_mutex);
+        active--;
+    }
+    output << "report of " << fileName << std::endl;
+    summary.add(u"length", ts::json::ValuePtr(new ts::json::Number(int64_t(fileName.length()))));
+    if (fileName.startWith(u"bad")) {
+        report.error(u"bad file");
+        return false;
+    }
+    return true;
+}
+
+
+//----------------------------------------------------------------------------
+// Test cases
+//----------------------------------------------------------------------------
+
+void FileBatchTest::testCommonOutput()
+{
+    ts::FileBatch batch;
+    batch.jobs = 4;
+    for (int i = 0; i < 20; ++i) {
+        batch.files.push_back(ts::UString::Format(u"%s%02d.ts", {i == 7 ? u"bad" : u"file", i}));
+    }
+    TSUNIT_ASSERT(batch.batchMode());
+
+    TestHandler handler;
+    ts::ReportBuffer<> rep;
+    std::ostringstream out;
+    TSUNIT_ASSERT(!batch.run(handler, out, rep));
+
+    debug() << "FileBatchTest::testCommonOutput: max concurrent workers: " << handler.max_active << std::endl;
+    TSUNIT_EQUAL(20, handler.calls);
+    TSUNIT_EQUAL(0, handler.active);
+    TSUNIT_ASSERT(handler.max_active >= 1);
+    TSUNIT_ASSERT(handler.max_active <= 4);
+    TSUNIT_EQUAL(19, batch.successCount());
+    TSUNIT_EQUAL(1, batch.failureCount());
+    TSUNIT_EQUAL(u"Error: bad07.ts: bad file", rep.getMessages());
+
+    // Each report is complete, preceded by its header line.
+    const std::string text(out.str());
+    for (int i = 0; i < 20; ++i) {
+        const std::string name(ts::UString::Format(u"%s%02d.ts", {i == 7 ? u"bad" : u"file", i}).toUTF8());
+        TSUNIT_ASSERT(text.find("==== " + name + "\nreport of " + name + "\n") != std::string::npos);
+    }
+}
+
+void FileBatchTest::testOutputDirectory()
+{
+    ts::FileBatch batch(u".log");
+    batch.jobs = 3;
+    batch.outputDirectory = _tempDir;
+    batch.summaryFile = reportName(u"summary.json");
+    batch.files.push_back(u"dir1/foo.ts");
+    batch.files.push_back(u"dir2/foo.ts");
+    batch.files.push_back(u"bar.m2ts");
+
+    TestHandler handler;
+    ts::ReportBuffer<> rep;
+    std::ostringstream out;
+    TSUNIT_ASSERT(batch.run(handler, out, rep));
+    TSUNIT_ASSERT(rep.emptyMessages());
+    TSUNIT_ASSERT(out.str().empty());
+    TSUNIT_EQUAL(3, batch.successCount());
+    TSUNIT_EQUAL(0, batch.failureCount());
+
+    // One report per file, distinct names for identical base names.
+    ts::UStringList lines;
+    TSUNIT_ASSERT(ts::UString::Load(lines, reportName(u"foo.log")));
+    TSUNIT_EQUAL(1, lines.size());
+    TSUNIT_EQUAL(u"report of dir1/foo.ts", lines.front());
+    TSUNIT_ASSERT(ts::UString::Load(lines, reportName(u"foo-2.log")));
+    TSUNIT_EQUAL(u"report of dir2/foo.ts", lines.front());
+    TSUNIT_ASSERT(ts::UString::Load(lines, reportName(u"bar.log")));
+    TSUNIT_EQUAL(u"report of bar.m2ts", lines.front());
+
+    // Aggregated summary, in the order of the input files.
+    ts::json::ValuePtr root;
+    TSUNIT_ASSERT(ts::UString::Load(lines, batch.summaryFile));
+    TSUNIT_ASSERT(ts::json::Parse(root, lines, rep));
+    TSUNIT_ASSERT(!root.isNull());
+    TSUNIT_EQUAL(3, root->value(u"files").toInteger());
+    TSUNIT_EQUAL(3, root->value(u"success").toInteger());
+    TSUNIT_EQUAL(0, root->value(u"failure").toInteger());
+    const ts::json::Value& results(root->value(u"results"));
+    TSUNIT_EQUAL(3, results.size());
+    TSUNIT_EQUAL(u"dir1/foo.ts", results.at(0).value(u"file").toString());
+    TSUNIT_EQUAL(u"dir2/foo.ts", results.at(1).value(u"file").toString());
+    TSUNIT_EQUAL(u"bar.m2ts", results.at(2).value(u"file").toString());
+    TSUNIT_EQUAL(u"success", results.at(2).value(u"status").toString());
+    TSUNIT_EQUAL(8, results.at(2).value(u"length").toInteger());
+    TSUNIT_EQUAL(reportName(u"foo-2.log"), results.at(1).value(u"report").toString());
+}
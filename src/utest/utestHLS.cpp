@@ -32,6 +32,8 @@
 //----------------------------------------------------------------------------
 
 #include "tshlsPlayList.h"
+#include "tshlsSegmentRing.h"
+#include "tsSysUtils.h"
 #include "tsunit.h"
 TSDUCK_SOURCE;
 
@@ -52,12 +54,16 @@ public:
     void testMediaPlaylist();
     void testBuildMasterPlaylist();
     void testBuildMediaPlaylist();
+    void testBuildLowLatencyPlaylist();
+    void testSegmentRing();
 
     TSUNIT_TEST_BEGIN(HLSTest);
     TSUNIT_TEST(testMasterPlaylist);
     TSUNIT_TEST(testMediaPlaylist);
     TSUNIT_TEST(testBuildMasterPlaylist);
     TSUNIT_TEST(testBuildMediaPlaylist);
+    TSUNIT_TEST(testBuildLowLatencyPlaylist);
+    TSUNIT_TEST(testSegmentRing);
     TSUNIT_TEST_END();
 
 private:
@@ -327,3 +333,138 @@ void HLSTest::testBuildMediaPlaylist()
 
     TSUNIT_EQUAL(refContent2, pl.textContent());
 }
+
+void HLSTest::testBuildLowLatencyPlaylist()
+{
+    ts::hls::PlayList pl;
+    pl.reset(ts::hls::MEDIA_PLAYLIST, u"/c/test/path/master/test.m3u8", 6);
+
+    TSUNIT_ASSERT(pl.isValid());
+    TSUNIT_ASSERT(pl.setMediaSequence(12));
+    TSUNIT_ASSERT(pl.setTargetDuration(2));
+    TSUNIT_ASSERT(pl.setPartTargetDuration(500));
+    TSUNIT_EQUAL(500, pl.partTargetDuration());
+
+    // First complete segment, made of four partial segments.
+    for (int i = 0; i < 4; ++i) {
+        ts::hls::MediaPart part;
+        part.uri = ts::UString::Format(u"/c/test/path/segments/seg-0012-%d.ts", {i});
+        part.duration = 500;
+        part.independent = i == 0;
+        TSUNIT_ASSERT(pl.addPart(part));
+    }
+    TSUNIT_EQUAL(4, pl.pendingPartCount());
+
+    ts::hls::MediaSegment seg;
+    seg.uri = u"/c/test/path/segments/seg-0012.ts";
+    seg.duration = 2000;
+    TSUNIT_ASSERT(pl.addSegment(seg));
+    TSUNIT_EQUAL(0, pl.pendingPartCount());
+    TSUNIT_EQUAL(4, pl.segment(0).parts.size());
+
+    // Segment in progress, two partial segments.
+    for (int i = 0; i < 2; ++i) {
+        ts::hls::MediaPart part;
+        part.uri = ts::UString::Format(u"/c/test/path/segments/seg-0013-%d.ts", {i});
+        part.duration = 480;
+        part.independent = i == 0;
+        TSUNIT_ASSERT(pl.addPart(part));
+    }
+    TSUNIT_ASSERT(pl.setPreloadHint(u"/c/test/path/segments/seg-0013-2.ts"));
+    TSUNIT_EQUAL(u"../segments/seg-0013-2.ts", pl.preloadHint());
+
+    static const ts::UChar* const refContent =
+        u"#EXTM3U\n"
+        u"#EXT-X-VERSION:6\n"
+        u"#EXT-X-TARGETDURATION:2\n"
+        u"#EXT-X-MEDIA-SEQUENCE:12\n"
+        u"#EXT-X-PART-INF:PART-TARGET=0.500\n"
+        u"#EXT-X-SERVER-CONTROL:PART-HOLD-BACK=1.500\n"
+        u"#EXT-X-PART:DURATION=0.500,URI=\"../segments/seg-0012-0.ts\",INDEPENDENT=YES\n"
+        u"#EXT-X-PART:DURATION=0.500,URI=\"../segments/seg-0012-1.ts\"\n"
+        u"#EXT-X-PART:DURATION=0.500,URI=\"../segments/seg-0012-2.ts\"\n"
+        u"#EXT-X-PART:DURATION=0.500,URI=\"../segments/seg-0012-3.ts\"\n"
+        u"#EXTINF:2.000,\n"
+        u"../segments/seg-0012.ts\n"
+        u"#EXT-X-PART:DURATION=0.480,URI=\"../segments/seg-0013-0.ts\",INDEPENDENT=YES\n"
+        u"#EXT-X-PART:DURATION=0.480,URI=\"../segments/seg-0013-1.ts\"\n"
+        u"#EXT-X-PRELOAD-HINT:TYPE=PART,URI=\"../segments/seg-0013-2.ts\"\n";
+
+    const ts::UString text(pl.textContent());
+    TSUNIT_EQUAL(refContent, text);
+
+    // Reload the generated text, check that partial segments are correctly parsed.
+    ts::hls::PlayList pl2;
+    TSUNIT_ASSERT(pl2.loadText(text, true));
+    TSUNIT_EQUAL(ts::hls::MEDIA_PLAYLIST, pl2.type());
+    TSUNIT_EQUAL(500, pl2.partTargetDuration());
+    TSUNIT_EQUAL(1, pl2.segmentCount());
+    TSUNIT_EQUAL(4, pl2.segment(0).parts.size());
+    TSUNIT_ASSERT(pl2.segment(0).parts.front().independent);
+    TSUNIT_EQUAL(2, pl2.pendingPartCount());
+    TSUNIT_EQUAL(480, pl2.pendingParts().back().duration);
+    TSUNIT_EQUAL(u"../segments/seg-0013-2.ts", pl2.preloadHint());
+}
+
+void HLSTest::testSegmentRing()
+{
+    const ts::UString prefix(ts::TempFile(u""));
+    const ts::UString seg1(prefix + u"-1.ts");
+    const ts::UString seg2(prefix + u"-2.ts");
+    const ts::UString seg3(prefix + u"-3.ts");
+    const ts::UString part1(prefix + u"-1-0.ts");
+    const ts::UString part2(prefix + u"-1-1.ts");
+    const ts::UString part3(prefix + u"-2-0.ts");
+    const ts::UString text(prefix + u".m3u8");
+
+    ts::hls::SegmentRing ring(CERR, 2);
+    TSUNIT_ASSERT(!ring.isOpen());
+    TSUNIT_ASSERT(ring.open());
+    TSUNIT_ASSERT(ring.isOpen());
+
+    ts::TSPacketVector packets(10, ts::NullPacket);
+    TSUNIT_ASSERT(ring.addPart(seg1, part1, packets));
+    TSUNIT_ASSERT(packets.empty());
+    packets.resize(5, ts::NullPacket);
+    TSUNIT_ASSERT(ring.addPart(seg1, part2, packets));
+    TSUNIT_ASSERT(ring.closeSegment());
+    TSUNIT_ASSERT(ring.saveText(text, u"foo\n"));
+
+    TSUNIT_EQUAL(1, ring.segmentCount());
+    TSUNIT_ASSERT(ring.getSegment(seg1, packets));
+    TSUNIT_EQUAL(15, packets.size());
+
+    packets.resize(7, ts::NullPacket);
+    TSUNIT_ASSERT(ring.addPart(seg2, part3, packets));
+    TSUNIT_ASSERT(ring.closeSegment());
+    TSUNIT_EQUAL(2, ring.segmentCount());
+
+    // The ring contains only two segments, the first one is dropped from memory.
+    packets.resize(3, ts::NullPacket);
+    TSUNIT_ASSERT(ring.addPart(seg3, ts::UString(), packets));
+    TSUNIT_ASSERT(ring.closeSegment());
+    TSUNIT_EQUAL(2, ring.segmentCount());
+    TSUNIT_ASSERT(!ring.getSegment(seg1, packets));
+    TSUNIT_ASSERT(ring.getSegment(seg2, packets));
+    TSUNIT_EQUAL(7, packets.size());
+
+    TSUNIT_ASSERT(ring.deleteFile(part1));
+    TSUNIT_ASSERT(ring.close());
+    TSUNIT_ASSERT(!ring.isOpen());
+    TSUNIT_EQUAL(0, ring.pendingOperations());
+
+    TSUNIT_ASSERT(!ts::FileExists(part1));
+    TSUNIT_EQUAL(15 * ts::PKT_SIZE, ts::GetFileSize(seg1));
+    TSUNIT_EQUAL(5 * ts::PKT_SIZE, ts::GetFileSize(part2));
+    TSUNIT_EQUAL(7 * ts::PKT_SIZE, ts::GetFileSize(seg2));
+    TSUNIT_EQUAL(7 * ts::PKT_SIZE, ts::GetFileSize(part3));
+    TSUNIT_EQUAL(3 * ts::PKT_SIZE, ts::GetFileSize(seg3));
+    TSUNIT_EQUAL(4, ts::GetFileSize(text));
+
+    ts::DeleteFile(seg1);
+    ts::DeleteFile(seg2);
+    ts::DeleteFile(seg3);
+    ts::DeleteFile(part2);
+    ts::DeleteFile(part3);
+    ts::DeleteFile(text);
+}
@@ -0,0 +1,201 @@
+//----------------------------------------------------------------------------
+//
+// TSDuck - The MPEG Transport Stream Toolkit
+// Copyright (c) 2005-2020, Thierry Lelegard
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+// THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------
+//
+//
+//  TSUnit test suite for class ts::InputSwitcher
+//
+//----------------------------------------------------------------------------
+
+#include "tsInputSwitcher.h"
+#include "tsTSFile.h"
+#include "tsSysUtils.h"
+#include "tsCerrReport.h"
+#include "tsunit.h"
+TSDUCK_SOURCE;
+
+
+//----------------------------------------------------------------------------
+// The test fixture
+//----------------------------------------------------------------------------
+
+namespace {
+    // Number of input plugins in the tests.
+    const size_t INPUT_COUNT = 8;
+}
+
+class InputSwitcherTest: public tsunit::Test
+{
+public:
+    InputSwitcherTest();
+
+    virtual void beforeTest() override;
+    virtual void afterTest() override;
+
+    void testSequence();
+    void testFastSwitch();
+
+    TSUNIT_TEST_BEGIN(InputSwitcherTest);
+    TSUNIT_TEST(testSequence);
+    TSUNIT_TEST(testFastSwitch);
+    TSUNIT_TEST_END();
+
+private:
+    ts::UStringVector _inFiles;
+    ts::UString       _outFile;
+
+    // Create an input file with the specified PID, a PCR every 10 packets.
+    bool createFile(const ts::UString& name, ts::PID pid, size_t count);
+};
+
+TSUNIT_REGISTER(InputSwitcherTest);
+
+
+//----------------------------------------------------------------------------
+// Initialization.
+//----------------------------------------------------------------------------
+
+// Constructor.
+InputSwitcherTest::InputSwitcherTest() :
+    _inFiles(),
+    _outFile()
+{
+}
+
+// Test suite initialization method.
+void InputSwitcherTest::beforeTest()
+{
+    _inFiles.clear();
+    for (size_t i = 0; i < INPUT_COUNT; ++i) {
+        _inFiles.push_back(ts::TempFile(u".ts"));
+    }
+    _outFile = ts::TempFile(u".ts");
+}
+
+// Test suite cleanup method.
+void InputSwitcherTest::afterTest()
+{
+    for (auto it = _inFiles.begin(); it != _inFiles.end(); ++it) {
+        ts::DeleteFile(*it);
+    }
+    ts::DeleteFile(_outFile);
+}
+
+// Create an input file.
+bool InputSwitcherTest::createFile(const ts::UString& name, ts::PID pid, size_t count)
+{
+    ts::TSFile file;
+    if (!file.open(name, ts::TSFile::WRITE | ts::TSFile::SHARED, CERR)) {
+        return false;
+    }
+    ts::TSPacketVector packets(count);
+    for (size_t i = 0; i < count; ++i) {
+        packets[i].init(pid, uint8_t(i & 0x0F), uint8_t(i));
+        if (i % 10 == 0) {
+            packets[i].setPCR(uint64_t(i) * 1000, true);
+        }
+    }
+    const bool ok = file.writePackets(packets.data(), nullptr, count, CERR);
+    return file.close(CERR) && ok;
+}
+
+
+//----------------------------------------------------------------------------
+// Unitary tests.
+//----------------------------------------------------------------------------
+
+// All inputs in sequence, no packet shall be lost or modified.
+void InputSwitcherTest::testSequence()
+{
+    static const size_t count = 1000;
+    static const size_t inputs = 3;
+
+    ts::InputSwitcherArgs opt;
+    opt.appName = u"InputSwitcherTest::testSequence";
+    opt.bufferedPackets = 64;
+    opt.maxInputPackets = 16;
+    opt.maxOutputPackets = 16;
+    for (size_t i = 0; i < inputs; ++i) {
+        TSUNIT_ASSERT(createFile(_inFiles[i], ts::PID(100 + i), count));
+        opt.inputs.push_back(ts::PluginOptions(u"file", {_inFiles[i]}));
+    }
+    opt.output.set(u"file", {_outFile});
+
+    ts::InputSwitcher switcher(opt, CERR);
+    TSUNIT_ASSERT(switcher.success());
+
+    ts::TSFile file;
+    TSUNIT_ASSERT(file.openRead(_outFile, 1, 0, CERR));
+    ts::TSPacket pkt;
+    for (size_t i = 0; i < inputs; ++i) {
+        for (size_t n = 0; n < count; ++n) {
+            TSUNIT_EQUAL(1, file.readPackets(&pkt, nullptr, 1, CERR));
+            TSUNIT_EQUAL(100 + i, pkt.getPID());
+            TSUNIT_EQUAL(n & 0x0F, pkt.getCC());
+            TSUNIT_EQUAL(n % 10 == 0, pkt.hasPCR());
+        }
+    }
+    TSUNIT_EQUAL(0, file.readPackets(&pkt, nullptr, 1, CERR));
+    TSUNIT_ASSERT(file.close(CERR));
+}
+
+// All inputs read in parallel with --fast-switch, only the first one is output.
+void InputSwitcherTest::testFastSwitch()
+{
+    static const size_t count = 1000;
+
+    ts::InputSwitcherArgs opt;
+    opt.appName = u"InputSwitcherTest::testFastSwitch";
+    opt.fastSwitch = true;
+    opt.alignedSwitch = true;
+    opt.terminate = true;
+    opt.bufferedPackets = ts::InputSwitcherArgs::DEFAULT_BUFFERED_PACKETS;
+    opt.maxInputPackets = ts::InputSwitcherArgs::DEFAULT_MAX_INPUT_PACKETS;
+    opt.maxOutputPackets = ts::InputSwitcherArgs::DEFAULT_MAX_OUTPUT_PACKETS;
+    for (size_t i = 0; i < INPUT_COUNT; ++i) {
+        TSUNIT_ASSERT(createFile(_inFiles[i], ts::PID(100 + i), count));
+        opt.inputs.push_back(ts::PluginOptions(u"file", {_inFiles[i]}));
+    }
+    opt.output.set(u"file", {_outFile});
+
+    ts::InputSwitcher switcher(opt, CERR);
+    TSUNIT_ASSERT(switcher.success());
+
+    ts::TSFile file;
+    TSUNIT_ASSERT(file.openRead(_outFile, 1, 0, CERR));
+    ts::TSPacket pkt;
+    size_t n = 0;
+    while (file.readPackets(&pkt, nullptr, 1, CERR) == 1) {
+        TSUNIT_EQUAL(100, pkt.getPID());
+        TSUNIT_EQUAL(n & 0x0F, pkt.getCC());
+        n++;
+    }
+    debug() << "InputSwitcherTest::testFastSwitch: " << n << " output packets" << std::endl;
+    TSUNIT_EQUAL(count, n);
+    TSUNIT_ASSERT(file.close(CERR));
+}
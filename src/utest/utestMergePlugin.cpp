@@ -0,0 +1,381 @@
+//----------------------------------------------------------------------------
+//
+// TSDuck - The MPEG Transport Stream Toolkit
+// Copyright (c) 2005-2020, Thierry Lelegard
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+// THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------
+//
+//  TSUnit test suite for the deduplication in plugin "merge".
+//
+//  The merge plugin is loaded from the plugin repository. This test is not
+//  included in the static version of the unitary tests.
+//
+//----------------------------------------------------------------------------
+
+#include "tsTSProcessor.h"
+#include "tsPluginRepository.h"
+#include "tsTSFile.h"
+#include "tsGuard.h"
+#include "tsGuardCondition.h"
+#include "tsSysUtils.h"
+#include "tsCerrReport.h"
+#include "tsunit.h"
+TSDUCK_SOURCE;
+
+
+//----------------------------------------------------------------------------
+// The test fixture
+//----------------------------------------------------------------------------
+
+class MergePluginTest: public tsunit::Test
+{
+public:
+    MergePluginTest();
+
+    virtual void beforeTest() override;
+    virtual void afterTest() override;
+
+    void testIdentical();
+    void testRecovery();
+
+    TSUNIT_TEST_BEGIN(MergePluginTest);
+    TSUNIT_TEST(testIdentical);
+    TSUNIT_TEST(testRecovery);
+    TSUNIT_TEST_END();
+
+private:
+    ts::UString        _mainFile;
+    ts::UString        _mergedFile;
+    ts::TSPacketVector _packets;   // Original stream.
+
+    // Build the original stream: groups of one packet in each PID, followed by a null packet.
+    void buildStream(size_t groups);
+
+    // Write a copy of the original stream, without the specified packets.
+    void writeFile(const ts::UString& name, const std::set<size_t>& lost);
+
+    // Run the merge plugin with deduplication and check the output in each PID.
+    void run(const std::set<size_t>& main_lost, const std::set<size_t>& merged_lost, const std::set<size_t>& expected_lost);
+};
+
+TSUNIT_REGISTER(MergePluginTest);
+
+
+//----------------------------------------------------------------------------
+// Description of the test stream.
+//----------------------------------------------------------------------------
+
+namespace {
+    const ts::PID PIDS[] = {0x0100, 0x0101, 0x0102};
+    const size_t PID_COUNT = sizeof(PIDS) / sizeof(PIDS[0]);
+    const size_t GROUP_SIZE = PID_COUNT + 1;
+
+    // Max wait time for the merged stream, to avoid blocking the test forever.
+    const ts::MilliSecond MAX_WAIT = 5000;
+
+    // Index of a packet in the original stream.
+    size_t Index(size_t group, size_t pid_index)
+    {
+        return group * GROUP_SIZE + pid_index;
+    }
+}
+
+
+//----------------------------------------------------------------------------
+// State which is shared between the test and the plugins.
+//----------------------------------------------------------------------------
+
+namespace {
+    class SharedState
+    {
+        TS_NOCOPY(SharedState);
+    public:
+        SharedState() : mutex(), condition(), merged_eof(false), timeout(false), output() {}
+        void reset();
+
+        ts::Mutex          mutex;
+        ts::Condition      condition;   // Signaled when merged_eof is set.
+        bool               merged_eof;  // The merge plugin reached the end of the merged stream.
+        bool               timeout;     // The gate plugin did not see the end of the merged stream.
+        ts::TSPacketVector output;      // Output packets, except null packets.
+    };
+
+    SharedState state;
+
+    void SharedState::reset()
+    {
+        ts::Guard lock(mutex);
+        merged_eof = false;
+        timeout = false;
+        output.clear();
+    }
+}
+
+
+//----------------------------------------------------------------------------
+// Report of the TS processor. The receiver thread of the merge plugin logs
+// a debug message when it terminates on end of the merged stream. All other
+// messages are passed to the standard error.
+//----------------------------------------------------------------------------
+
+namespace {
+    class MergeReport : public ts::Report
+    {
+        TS_NOCOPY(MergeReport);
+    public:
+        MergeReport() : ts::Report(ts::Severity::Debug) {}
+    protected:
+        virtual void writeLog(int severity, const ts::UString& msg) override;
+    };
+
+    void MergeReport::writeLog(int severity, const ts::UString& msg)
+    {
+        if (msg == u"merge: receiver thread completed") {
+            ts::GuardCondition lock(state.mutex, state.condition);
+            state.merged_eof = true;
+            lock.signal();
+        }
+        if (severity <= CERR.maxSeverity()) {
+            CERR.log(severity, msg);
+        }
+    }
+}
+
+
+//----------------------------------------------------------------------------
+// Gate plugin, before the merge plugin. It holds the main stream until
+// the merged stream is entirely in the queue of the merge plugin. Thus,
+// the result does not depend on the relative speed of the two streams.
+//----------------------------------------------------------------------------
+
+namespace {
+    class GatePlugin : public ts::ProcessorPlugin
+    {
+        TS_NOBUILD_NOCOPY(GatePlugin);
+    public:
+        GatePlugin(ts::TSP* t) : ts::ProcessorPlugin(t, u"Test gate", u""), _open(false) {}
+        static ts::ProcessorPlugin* CreateInstance(ts::TSP* t) { return new GatePlugin(t); }
+        virtual Status processPacket(ts::TSPacket&, ts::TSPacketMetadata&) override;
+    private:
+        bool _open;
+    };
+
+    GatePlugin::Status GatePlugin::processPacket(ts::TSPacket&, ts::TSPacketMetadata&)
+    {
+        if (!_open) {
+            _open = true;
+            ts::GuardCondition lock(state.mutex, state.condition);
+            while (!state.merged_eof) {
+                if (!lock.waitCondition(MAX_WAIT)) {
+                    // The test fails on timeout, don't block the main stream forever.
+                    state.timeout = true;
+                    tsp->error(u"end of merged stream not reached after %'d ms", {MAX_WAIT});
+                    return TSP_END;
+                }
+            }
+        }
+        return TSP_OK;
+    }
+}
+
+
+//----------------------------------------------------------------------------
+// Capture plugin, after the merge plugin.
+//----------------------------------------------------------------------------
+
+namespace {
+    class CapturePlugin : public ts::ProcessorPlugin
+    {
+        TS_NOBUILD_NOCOPY(CapturePlugin);
+    public:
+        CapturePlugin(ts::TSP* t) : ts::ProcessorPlugin(t, u"Test capture", u"") {}
+        static ts::ProcessorPlugin* CreateInstance(ts::TSP* t) { return new CapturePlugin(t); }
+        virtual Status processPacket(ts::TSPacket&, ts::TSPacketMetadata&) override;
+    };
+
+    CapturePlugin::Status CapturePlugin::processPacket(ts::TSPacket& pkt, ts::TSPacketMetadata&)
+    {
+        if (pkt.getPID() != ts::PID_NULL) {
+            ts::Guard lock(state.mutex);
+            state.output.push_back(pkt);
+        }
+        return TSP_OK;
+    }
+}
+
+
+//----------------------------------------------------------------------------
+// Initialization.
+//----------------------------------------------------------------------------
+
+// Constructor.
+MergePluginTest::MergePluginTest() :
+    _mainFile(),
+    _mergedFile(),
+    _packets()
+{
+}
+
+// Test suite initialization method.
+void MergePluginTest::beforeTest()
+{
+    ts::PluginRepository::Instance()->registerProcessor(u"utest_gate", GatePlugin::CreateInstance);
+    ts::PluginRepository::Instance()->registerProcessor(u"utest_capture", CapturePlugin::CreateInstance);
+    _mainFile = ts::TempFile(u".ts");
+    _mergedFile = ts::TempFile(u".ts");
+    _packets.clear();
+    state.reset();
+}
+
+// Test suite cleanup method.
+void MergePluginTest::afterTest()
+{
+    ts::DeleteFile(_mainFile);
+    ts::DeleteFile(_mergedFile);
+}
+
+
+//----------------------------------------------------------------------------
+// Build the test streams.
+//----------------------------------------------------------------------------
+
+void MergePluginTest::buildStream(size_t groups)
+{
+    for (size_t group = 0; group < groups; ++group) {
+        for (size_t i = 0; i < PID_COUNT; ++i) {
+            // Each packet has a distinct payload.
+            ts::TSPacket pkt;
+            pkt.init(PIDS[i], uint8_t(group & ts::CC_MASK), uint8_t(i));
+            ts::PutUInt32(pkt.b + 4, uint32_t(Index(group, i)));
+            _packets.push_back(pkt);
+        }
+        _packets.push_back(ts::NullPacket);
+    }
+}
+
+void MergePluginTest::writeFile(const ts::UString& name, const std::set<size_t>& lost)
+{
+    ts::TSPacketVector packets;
+    for (size_t i = 0; i < _packets.size(); ++i) {
+        if (lost.find(i) == lost.end()) {
+            packets.push_back(_packets[i]);
+        }
+    }
+    ts::TSFile file;
+    TSUNIT_ASSERT(file.open(name, ts::TSFile::WRITE, CERR));
+    TSUNIT_ASSERT(file.writePackets(packets.data(), nullptr, packets.size(), CERR));
+    TSUNIT_ASSERT(file.close(CERR));
+}
+
+
+//----------------------------------------------------------------------------
+// Run the merge plugin.
+//----------------------------------------------------------------------------
+
+void MergePluginTest::run(const std::set<size_t>& main_lost, const std::set<size_t>& merged_lost, const std::set<size_t>& expected_lost)
+{
+    writeFile(_mainFile, main_lost);
+    writeFile(_mergedFile, merged_lost);
+
+#if defined(TS_WINDOWS)
+    const ts::UString command(ts::UString::Format(u"type \"%s\"", {_mergedFile}));
+#else
+    const ts::UString command(ts::UString::Format(u"cat \"%s\"", {_mergedFile}));
+#endif
+
+    ts::TSProcessorArgs opt;
+    opt.app_name = u"MergePluginTest";
+    opt.input = {u"file", {_mainFile}};
+    opt.plugins = {
+        {u"utest_gate", {}},
+        {u"merge", {u"--deduplicate", command}},
+        {u"utest_capture", {}},
+    };
+    opt.output = {u"drop"};
+
+    MergeReport report;
+    ts::TSProcessor tsproc(report);
+    TSUNIT_ASSERT(tsproc.start(opt));
+    tsproc.waitForTermination();
+    TSUNIT_ASSERT(!state.timeout);
+
+    // In each PID, the output packets are the original ones, in the same order, without duplicate.
+    for (size_t i = 0; i < PID_COUNT; ++i) {
+        ts::TSPacketVector expected;
+        ts::TSPacketVector output;
+        for (size_t index = 0; index < _packets.size(); ++index) {
+            if (_packets[index].getPID() == PIDS[i] && expected_lost.find(index) == expected_lost.end()) {
+                expected.push_back(_packets[index]);
+            }
+        }
+        for (auto it = state.output.begin(); it != state.output.end(); ++it) {
+            if (it->getPID() == PIDS[i]) {
+                output.push_back(*it);
+            }
+        }
+        debug() << "MergePluginTest: PID " << PIDS[i] << ", expected: " << expected.size() << ", output: " << output.size() << std::endl;
+        TSUNIT_EQUAL(expected.size(), output.size());
+        for (size_t n = 0; n < expected.size(); ++n) {
+            TSUNIT_ASSERT(output[n] == expected[n]);
+        }
+    }
+}
+
+
+//----------------------------------------------------------------------------
+// Unitary tests.
+//----------------------------------------------------------------------------
+
+// Two identical streams: the output is the main stream.
+void MergePluginTest::testIdentical()
+{
+    buildStream(60);
+    run({}, {}, {});
+    TSUNIT_EQUAL(_packets.size() - 60, state.output.size());
+}
+
+// Packets which are lost in the main stream are inserted from the merged stream
+// in a free slot before the next packet of the same PID. A lost packet without
+// free slot before the next packet of its PID is dropped.
+void MergePluginTest::testRecovery()
+{
+    buildStream(60);
+
+    const size_t no_slot = Index(10, 1);
+    const std::set<size_t> main_lost {
+        Index(5, 0),
+        no_slot,
+        Index(10, PID_COUNT),  // null packet after the lost one
+        Index(20, 0),
+        Index(40, 2),
+        Index(50, 1),
+    };
+    const std::set<size_t> merged_lost {
+        Index(30, 2),
+        Index(50, 1),
+    };
+
+    run(main_lost, merged_lost, {no_slot, Index(50, 1)});
+}
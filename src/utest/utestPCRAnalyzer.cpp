@@ -0,0 +1,172 @@
+//----------------------------------------------------------------------------
+//
+// TSDuck - The MPEG Transport Stream Toolkit
+// Copyright (c) 2005-2020, Thierry Lelegard
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+// THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------
+//
+//
+//  TSUnit test suite for class ts::PCRAnalyzer
+//
+//----------------------------------------------------------------------------
+
+#include "tsPCRAnalyzer.h"
+#include "tsunit.h"
+TSDUCK_SOURCE;
+
+
+//----------------------------------------------------------------------------
+// The test fixture
+//----------------------------------------------------------------------------
+
+class PCRAnalyzerTest: public tsunit::Test
+{
+public:
+    virtual void beforeTest() override;
+    virtual void afterTest() override;
+
+    void testConstantBitrate();
+    void testBitrateChange();
+    void testWrapAround();
+
+    TSUNIT_TEST_BEGIN(PCRAnalyzerTest);
+    TSUNIT_TEST(testConstantBitrate);
+    TSUNIT_TEST(testBitrateChange);
+    TSUNIT_TEST(testWrapAround);
+    TSUNIT_TEST_END();
+
+private:
+    // Generate packets with a PCR every 10 packets. Return the next PCR.
+    // The bitrate is defined by the number of PCR units per packet.
+    static uint64_t feed(ts::PCRAnalyzer& zer, size_t count, uint64_t pcr, uint64_t pcr_per_packet, uint8_t& cc1, uint8_t& cc2);
+};
+
+TSUNIT_REGISTER(PCRAnalyzerTest);
+
+
+//----------------------------------------------------------------------------
+// Initialization.
+//----------------------------------------------------------------------------
+
+// Test suite initialization method.
+void PCRAnalyzerTest::beforeTest()
+{
+}
+
+// Test suite cleanup method.
+void PCRAnalyzerTest::afterTest()
+{
+}
+
+// Generate packets.
+uint64_t PCRAnalyzerTest::feed(ts::PCRAnalyzer& zer, size_t count, uint64_t pcr, uint64_t pcr_per_packet, uint8_t& cc1, uint8_t& cc2)
+{
+    ts::TSPacket pkt;
+    for (size_t i = 0; i < count; ++i) {
+        if (i % 10 == 0) {
+            pkt.init(100, cc1, 0);
+            cc1 = (cc1 + 1) & 0x0F;
+            pkt.setPCR(pcr, true);
+        }
+        else {
+            pkt.init(200, cc2, 0);
+            cc2 = (cc2 + 1) & 0x0F;
+        }
+        zer.feedPacket(pkt);
+        pcr = (pcr + pcr_per_packet) % ts::PCR_SCALE;
+    }
+    return pcr;
+}
+
+
+//----------------------------------------------------------------------------
+// Unitary tests.
+//----------------------------------------------------------------------------
+
+void PCRAnalyzerTest::testConstantBitrate()
+{
+    // 4000 PCR units per packet = 10,152,000 b/s.
+    ts::PCRAnalyzer zer;
+    uint8_t cc1 = 0, cc2 = 0;
+    feed(zer, 10000, 0, 4000, cc1, cc2);
+
+    ts::PCRAnalyzer::Status status(zer);
+    debug() << "PCRAnalyzerTest::testConstantBitrate: " << status.toString() << std::endl;
+
+    TSUNIT_ASSERT(status.bitrate_valid);
+    TSUNIT_EQUAL(10000, status.packet_count);
+    TSUNIT_EQUAL(999, status.pcr_count);
+    TSUNIT_EQUAL(1, status.pcr_pids);
+    TSUNIT_EQUAL(10152000, status.bitrate_188);
+    TSUNIT_EQUAL(11016000, status.bitrate_204);
+    TSUNIT_EQUAL(10152000, status.instantaneous_bitrate_188);
+    TSUNIT_ASSERT(status.windowed_bitrate_188 >= 10151999 && status.windowed_bitrate_188 <= 10152001);
+    TSUNIT_ASSERT(status.windowed_bitrate_204 >= 11015999 && status.windowed_bitrate_204 <= 11016001);
+}
+
+void PCRAnalyzerTest::testBitrateChange()
+{
+    // Long run at 10,152,000 b/s, then switch to 20,304,000 b/s.
+    // The windowed bitrate follows the change, not the long-term average.
+    ts::PCRAnalyzer zer;
+    uint8_t cc1 = 0, cc2 = 0;
+    uint64_t pcr = feed(zer, 100000, 0, 4000, cc1, cc2);
+    pcr = feed(zer, 10 * ts::PCRAnalyzer::WINDOW_PCR_COUNT, pcr, 2000, cc1, cc2);
+
+    ts::PCRAnalyzer::Status status1(zer);
+    debug() << "PCRAnalyzerTest::testBitrateChange: " << status1.toString() << std::endl;
+    TSUNIT_ASSERT(status1.bitrate_188 < 11000000);
+    TSUNIT_ASSERT(status1.windowed_bitrate_188 >= 20303999 && status1.windowed_bitrate_188 <= 20304001);
+
+    // The instantaneous bitrate covers the last second of PCR's, it needs a full
+    // second at the new bitrate (20,000 packets are 1.48 second at 20,304,000 b/s).
+    // These 2,000 additional PCR's at the new bitrate also move the long-term
+    // average to about 11.9 Mb/s, still far below the new bitrate.
+    pcr = feed(zer, 20000, pcr, 2000, cc1, cc2);
+
+    ts::PCRAnalyzer::Status status(zer);
+    debug() << "PCRAnalyzerTest::testBitrateChange: " << status.toString() << std::endl;
+
+    TSUNIT_ASSERT(status.bitrate_valid);
+    TSUNIT_ASSERT(status.bitrate_188 < 13000000);
+    TSUNIT_ASSERT(status.windowed_bitrate_188 >= 20303999 && status.windowed_bitrate_188 <= 20304001);
+    TSUNIT_EQUAL(20304000, status.instantaneous_bitrate_188);
+}
+
+void PCRAnalyzerTest::testWrapAround()
+{
+    // Start 1000 PCR's before the PCR wrap-around.
+    ts::PCRAnalyzer zer;
+    uint8_t cc1 = 0, cc2 = 0;
+    feed(zer, 20000, ts::PCR_SCALE - 1000 * 10 * 4000, 4000, cc1, cc2);
+
+    ts::PCRAnalyzer::Status status(zer);
+    debug() << "PCRAnalyzerTest::testWrapAround: " << status.toString() << std::endl;
+
+    TSUNIT_ASSERT(status.bitrate_valid);
+    TSUNIT_EQUAL(10152000, status.bitrate_188);
+    TSUNIT_EQUAL(10152000, status.instantaneous_bitrate_188);
+    TSUNIT_ASSERT(status.windowed_bitrate_188 >= 10151999 && status.windowed_bitrate_188 <= 10152001);
+}
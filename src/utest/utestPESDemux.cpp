@@ -0,0 +1,227 @@
+//----------------------------------------------------------------------------
+//
+// TSDuck - The MPEG Transport Stream Toolkit
+// Copyright (c) 2005-2020, Thierry Lelegard
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+// THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------
+//
+//  TSUnit test suite for class ts::PESDemux
+//
+//----------------------------------------------------------------------------
+
+#include "tsPESDemux.h"
+#include "tsDuckContext.h"
+#include "tsByteBlock.h"
+#include "tsTSPacket.h"
+#include "tsMemory.h"
+#include "tsunit.h"
+TSDUCK_SOURCE;
+
+
+//----------------------------------------------------------------------------
+// The test fixture
+//----------------------------------------------------------------------------
+
+class PESDemuxTest: public tsunit::Test
+{
+public:
+    virtual void beforeTest() override;
+    virtual void afterTest() override;
+
+    void testFullPayload();
+    void testHeaderOnly();
+
+    TSUNIT_TEST_BEGIN(PESDemuxTest);
+    TSUNIT_TEST(testFullPayload);
+    TSUNIT_TEST(testHeaderOnly);
+    TSUNIT_TEST_END();
+};
+
+TSUNIT_REGISTER(PESDemuxTest);
+
+
+//----------------------------------------------------------------------------
+// Initialization.
+//----------------------------------------------------------------------------
+
+void PESDemuxTest::beforeTest()
+{
+}
+
+void PESDemuxTest::afterTest()
+{
+}
+
+
+//----------------------------------------------------------------------------
+// Test data and handler.
+//----------------------------------------------------------------------------
+
+namespace {
+
+    // Audio PES packets, bounded size, long header with PTS.
+    constexpr ts::PID AUDIO_PID = 100;
+    constexpr size_t AUDIO_PAYLOAD = 1000;
+
+    // Video PES packets, unbounded size.
+    constexpr ts::PID VIDEO_PID = 101;
+    constexpr size_t VIDEO_PAYLOAD = 20000;
+
+    // Build a PES packet.
+    void BuildPES(ts::ByteBlock& pes, uint8_t stream_id, size_t payload_size, bool bounded)
+    {
+        pes.clear();
+        pes.appendUInt24(0x000001);
+        pes.appendUInt8(stream_id);
+        pes.appendUInt16(bounded ? uint16_t(3 + 5 + payload_size) : 0);
+        pes.appendUInt8(0x80);
+        pes.appendUInt8(0x80);  // PTS only
+        pes.appendUInt8(5);     // PES_header_data_length
+        pes.appendUInt8(0x21);
+        pes.appendUInt32(0x00010001);
+        const size_t start = pes.size();
+        pes.resize(start + payload_size);
+        for (size_t i = 0; i < payload_size; ++i) {
+            pes[start + i] = uint8_t(0x10 + i % 0xE0);
+        }
+    }
+
+    // Packetize a PES packet into TS packets.
+    void Packetize(ts::TSPacketVector& packets, ts::PID pid, uint8_t& cc, const ts::ByteBlock& pes)
+    {
+        for (size_t offset = 0; offset < pes.size(); ) {
+            ts::TSPacket pkt;
+            pkt.init(pid, cc);
+            cc = (cc + 1) & ts::CC_MASK;
+            pkt.setPUSI(offset == 0);
+            const size_t size = std::min<size_t>(pes.size() - offset, ts::PKT_SIZE - 4);
+            pkt.setPayloadSize(size);
+            ::memcpy(pkt.getPayload(), pes.data() + offset, size);
+            offset += size;
+            packets.push_back(pkt);
+        }
+    }
+
+    // Build a stream with 3 audio PES packets and 4 video PES packets.
+    void BuildStream(ts::TSPacketVector& packets)
+    {
+        ts::ByteBlock audio;
+        ts::ByteBlock video;
+        BuildPES(audio, 0xC0, AUDIO_PAYLOAD, true);
+        BuildPES(video, 0xE0, VIDEO_PAYLOAD, false);
+        ts::PutUInt32(video.data() + 14, 0x000001B3); // MPEG-2 video sequence header
+        uint8_t audio_cc = 0;
+        uint8_t video_cc = 0;
+        packets.clear();
+        for (size_t i = 0; i < 4; ++i) {
+            if (i < 3) {
+                Packetize(packets, AUDIO_PID, audio_cc, audio);
+            }
+            Packetize(packets, VIDEO_PID, video_cc, video);
+        }
+    }
+
+    // A PES handler which collects PES packets characteristics.
+    class Collector: public ts::PESHandlerInterface
+    {
+    public:
+        bool   need_payload;
+        size_t video_start_codes;
+        std::vector<ts::PID> pids;
+        std::vector<size_t> sizes;
+        std::vector<size_t> header_sizes;
+        std::vector<ts::PacketCounter> last_packets;
+
+        Collector(bool payload) : need_payload(payload), video_start_codes(0), pids(), sizes(), header_sizes(), last_packets() {}
+
+        virtual bool needPESPayload(ts::PESDemux&, ts::PID) override
+        {
+            return need_payload;
+        }
+        virtual void handlePESPacket(ts::PESDemux&, const ts::PESPacket& packet) override
+        {
+            pids.push_back(packet.getSourcePID());
+            sizes.push_back(packet.size());
+            header_sizes.push_back(packet.headerSize());
+            last_packets.push_back(packet.getLastTSPacketIndex());
+        }
+        virtual void handleVideoStartCode(ts::PESDemux&, const ts::PESPacket&, uint8_t, size_t, size_t) override
+        {
+            video_start_codes++;
+        }
+    };
+}
+
+
+//----------------------------------------------------------------------------
+// Unitary tests.
+//----------------------------------------------------------------------------
+
+void PESDemuxTest::testFullPayload()
+{
+    ts::TSPacketVector packets;
+    BuildStream(packets);
+
+    ts::DuckContext duck;
+    Collector collector(true);
+    ts::PESDemux demux(duck, &collector);
+    for (auto it = packets.begin(); it != packets.end(); ++it) {
+        demux.feedPacket(*it);
+    }
+
+    // The last video PES packet is unbounded and not terminated.
+    TSUNIT_EQUAL(6, collector.pids.size());
+    for (size_t i = 0; i < collector.pids.size(); ++i) {
+        TSUNIT_EQUAL(14, collector.header_sizes[i]);
+        TSUNIT_EQUAL(14 + (collector.pids[i] == AUDIO_PID ? AUDIO_PAYLOAD : VIDEO_PAYLOAD), collector.sizes[i]);
+    }
+    TSUNIT_ASSERT(collector.video_start_codes > 0);
+}
+
+void PESDemuxTest::testHeaderOnly()
+{
+    ts::TSPacketVector packets;
+    BuildStream(packets);
+
+    ts::DuckContext duck;
+    Collector full(true);
+    Collector header(false);
+    ts::PESDemux full_demux(duck, &full);
+    ts::PESDemux header_demux(duck, &header);
+    for (auto it = packets.begin(); it != packets.end(); ++it) {
+        full_demux.feedPacket(*it);
+        header_demux.feedPacket(*it);
+    }
+
+    // Same PES packets, same location, but only the first TS payload is collected.
+    TSUNIT_EQUAL(6, header.pids.size());
+    TSUNIT_ASSERT(full.pids == header.pids);
+    TSUNIT_ASSERT(full.header_sizes == header.header_sizes);
+    TSUNIT_ASSERT(full.last_packets == header.last_packets);
+    for (size_t i = 0; i < header.sizes.size(); ++i) {
+        TSUNIT_EQUAL(ts::PKT_SIZE - 4, header.sizes[i]);
+    }
+    TSUNIT_EQUAL(0, header.video_start_codes);
+}
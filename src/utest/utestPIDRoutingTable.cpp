@@ -0,0 +1,226 @@
+//----------------------------------------------------------------------------
+//
+// TSDuck - The MPEG Transport Stream Toolkit
+// Copyright (c) 2005-2020, Thierry Lelegard
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+// THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------
+//
+//  TSUnit test suite for class ts::PIDRoutingTable
+//
+//----------------------------------------------------------------------------
+
+#include "tsPIDRoutingTable.h"
+#include "tsContinuityAnalyzer.h"
+#include "tsunit.h"
+TSDUCK_SOURCE;
+
+
+//----------------------------------------------------------------------------
+// The test fixture
+//----------------------------------------------------------------------------
+
+class PIDRoutingTableTest: public tsunit::Test
+{
+public:
+    virtual void beforeTest() override;
+    virtual void afterTest() override;
+
+    void testDropRemap();
+    void testContinuity();
+    void testPCR();
+    void testWindows();
+
+    TSUNIT_TEST_BEGIN(PIDRoutingTableTest);
+    TSUNIT_TEST(testDropRemap);
+    TSUNIT_TEST(testContinuity);
+    TSUNIT_TEST(testPCR);
+    TSUNIT_TEST(testWindows);
+    TSUNIT_TEST_END();
+};
+
+TSUNIT_REGISTER(PIDRoutingTableTest);
+
+
+//----------------------------------------------------------------------------
+// Initialization.
+//----------------------------------------------------------------------------
+
+void PIDRoutingTableTest::beforeTest()
+{
+}
+
+void PIDRoutingTableTest::afterTest()
+{
+}
+
+
+//----------------------------------------------------------------------------
+// Unitary tests.
+//----------------------------------------------------------------------------
+
+namespace {
+    // Build packets on a cycle of PID's, with a continuity counter sequence per PID.
+    void BuildPackets(ts::TSPacketVector& packets, size_t count, ts::PID first_pid, size_t pid_count)
+    {
+        packets.resize(count);
+        for (size_t i = 0; i < count; ++i) {
+            packets[i] = ts::NullPacket;
+            packets[i].setPID(ts::PID(first_pid + i % pid_count));
+            packets[i].setCC(uint8_t((i / pid_count + 3) & ts::CC_MASK));
+        }
+    }
+}
+
+void PIDRoutingTableTest::testDropRemap()
+{
+    ts::PIDRoutingTable table;
+    ts::TSPacketVector packets;
+    BuildPackets(packets, 40, 0x0E, 4);  // PID's 0x0E to 0x11
+
+    table.setFlags(0x00, 0x1F, ts::PIDRoutingTable::DROP);
+    table.setFlags(0x10, ts::PIDRoutingTable::DROP, false);
+    table.setRemap(0x10, 0x200);
+    TSUNIT_ASSERT(table.isDropped(0x0E));
+    TSUNIT_ASSERT(!table.isDropped(0x10));
+    TSUNIT_EQUAL(0x200, table.outputPID(0x10));
+    TSUNIT_EQUAL(0x0F, table.outputPID(0x0F));
+    TSUNIT_EQUAL(ts::PIDRoutingTable::REMAP, table.flags(0x10));
+
+    // 0x0E, 0x0F, 0x11 dropped, 0x10 remapped.
+    TSUNIT_EQUAL(10, table.apply(packets.data(), packets.size()));
+    for (size_t i = 0; i < packets.size(); ++i) {
+        TSUNIT_EQUAL(i % 4 == 2 ? 0x200 : ts::PID_NULL, packets[i].getPID());
+    }
+
+    table.reset();
+    BuildPackets(packets, 40, 0x0E, 4);
+    TSUNIT_EQUAL(40, table.apply(packets.data(), packets.size()));
+    TSUNIT_EQUAL(0x0E, packets[0].getPID());
+    TSUNIT_EQUAL(0x0F, packets[1].getPID());
+}
+
+void PIDRoutingTableTest::testContinuity()
+{
+    // Remap all PID's into one and regenerate continuity counters,
+    // the result must be identical to a ContinuityAnalyzer in generator mode.
+    ts::PIDRoutingTable table;
+    ts::ContinuityAnalyzer fixer(ts::AllPIDs);
+    ts::TSPacketVector packets1;
+    BuildPackets(packets1, 100, 100, 3);
+    packets1[10].setPayloadSize(0);
+    packets1[10].b[3] &= ~0x10;  // no payload, adaptation field only
+    ts::TSPacketVector packets2(packets1);
+
+    table.setRemapAll(200);
+    table.setFlags(0, ts::PID_MAX - 1, ts::PIDRoutingTable::CC_REWRITE);
+    fixer.setGenerator(true);
+
+    TSUNIT_EQUAL(37, table.apply(packets1.data(), 37));
+    TSUNIT_EQUAL(packets1.size() - 37, table.apply(packets1.data() + 37, packets1.size() - 37));
+    for (size_t i = 0; i < packets2.size(); ++i) {
+        packets2[i].setPID(200);
+        fixer.feedPacket(packets2[i]);
+    }
+    for (size_t i = 0; i < packets1.size(); ++i) {
+        TSUNIT_EQUAL(200, packets1[i].getPID());
+        TSUNIT_EQUAL(packets2[i].getCC(), packets1[i].getCC());
+    }
+    TSUNIT_EQUAL(3, packets1[0].getCC());
+    TSUNIT_EQUAL(4, packets1[1].getCC());
+    TSUNIT_EQUAL(12, packets1[9].getCC());
+    TSUNIT_EQUAL(12, packets1[10].getCC());
+    TSUNIT_EQUAL(13, packets1[11].getCC());
+}
+
+void PIDRoutingTableTest::testPCR()
+{
+    ts::PIDRoutingTable table;
+    ts::TSPacket pkt(ts::NullPacket);
+    pkt.setPID(100);
+    TSUNIT_ASSERT(pkt.setPCR(1000000, true));
+
+    // No restamping without the flag.
+    TSUNIT_ASSERT(!table.restampPCR(pkt, 10, 1000000));
+    table.setFlags(100, ts::PIDRoutingTable::PCR_RESTAMP);
+
+    // First PCR unchanged.
+    TSUNIT_ASSERT(!table.restampPCR(pkt, 10, 1000000));
+    TSUNIT_EQUAL(1000000, pkt.getPCR());
+
+    // Unknown bitrate, unchanged.
+    TSUNIT_ASSERT(!table.restampPCR(pkt, 20, 0));
+    TSUNIT_EQUAL(1000000, pkt.getPCR());
+
+    // 100 packets later at 1504000 b/s: 100 ms, 2700000 PCR units.
+    TSUNIT_ASSERT(table.restampPCR(pkt, 110, 1504000));
+    TSUNIT_EQUAL(3700000, pkt.getPCR());
+
+    // No PCR in packet.
+    ts::TSPacket pkt2(ts::NullPacket);
+    pkt2.setPID(100);
+    TSUNIT_ASSERT(!table.restampPCR(pkt2, 120, 1504000));
+
+    // State reset.
+    table.resetState();
+    TSUNIT_ASSERT(!table.restampPCR(pkt, 200, 1504000));
+    TSUNIT_EQUAL(3700000, pkt.getPCR());
+}
+
+void PIDRoutingTableTest::testWindows()
+{
+    // Apply the table on successive windows, same result as a per-packet filter.
+    constexpr size_t count = 10000;
+    ts::TSPacketVector packets;
+    BuildPackets(packets, count, 0x10, 40);
+
+    // Per-packet filtering: drop PSI/SI, pass all other PID's.
+    ts::PIDSet allowed;
+    allowed.set();
+    allowed.reset(0x10);
+    ts::TSPacketVector expected(packets);
+    size_t kept1 = 0;
+    for (size_t i = 0; i < count; ++i) {
+        if (allowed.test(expected[i].getPID())) {
+            kept1++;
+        }
+        else {
+            expected[i] = ts::NullPacket;
+        }
+    }
+
+    // Precompiled table on windows, the last one is incomplete.
+    ts::PIDRoutingTable table;
+    table.setFlags(0x10, ts::PIDRoutingTable::DROP);
+    ts::TSPacketVector work(packets);
+    size_t kept2 = 0;
+    for (size_t i = 0; i < count; i += 128) {
+        kept2 += table.apply(&work[i], std::min<size_t>(128, count - i));
+    }
+
+    TSUNIT_EQUAL(kept1, kept2);
+    for (size_t i = 0; i < count; ++i) {
+        TSUNIT_ASSERT(work[i] == expected[i]);
+    }
+}
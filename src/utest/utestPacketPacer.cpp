@@ -0,0 +1,230 @@
+//----------------------------------------------------------------------------
+//
+// TSDuck - The MPEG Transport Stream Toolkit
+// Copyright (c) 2005-2020, Thierry Lelegard
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+// THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------
+//
+//  TSUnit test suite for class ts::PacketPacer
+//
+//----------------------------------------------------------------------------
+
+#include "tsPacketPacer.h"
+#include "tsUDPSocket.h"
+#include "tsIPUtils.h"
+#include "tsunit.h"
+#include "utestTSUnitThread.h"
+TSDUCK_SOURCE;
+
+
+//----------------------------------------------------------------------------
+// The test fixture
+//----------------------------------------------------------------------------
+
+class PacketPacerTest: public tsunit::Test
+{
+public:
+    virtual void beforeTest() override;
+    virtual void afterTest() override;
+
+    void testFixedBitrate();
+    void testPCR();
+    void testLoopbackJitter();
+
+    TSUNIT_TEST_BEGIN(PacketPacerTest);
+    TSUNIT_TEST(testFixedBitrate);
+    TSUNIT_TEST(testPCR);
+    TSUNIT_TEST(testLoopbackJitter);
+    TSUNIT_TEST_END();
+
+private:
+    // Generate packets with a PCR every 10 packets in PID 100, 4000 PCR units per packet (10,152,000 b/s).
+    static void generate(ts::TSPacketVector& packets, size_t count);
+};
+
+TSUNIT_REGISTER(PacketPacerTest);
+
+
+//----------------------------------------------------------------------------
+// Initialization.
+//----------------------------------------------------------------------------
+
+// Test suite initialization method.
+void PacketPacerTest::beforeTest()
+{
+}
+
+// Test suite cleanup method.
+void PacketPacerTest::afterTest()
+{
+}
+
+// Generate packets.
+void PacketPacerTest::generate(ts::TSPacketVector& packets, size_t count)
+{
+    packets.resize(count);
+    uint8_t cc1 = 0, cc2 = 0;
+    for (size_t i = 0; i < count; ++i) {
+        if (i % 10 == 0) {
+            packets[i].init(100, cc1, 0);
+            cc1 = (cc1 + 1) & 0x0F;
+            packets[i].setPCR(4000 * i, true);
+        }
+        else {
+            packets[i].init(200, cc2, 0);
+            cc2 = (cc2 + 1) & 0x0F;
+        }
+    }
+}
+
+
+//----------------------------------------------------------------------------
+// Unitary tests.
+//----------------------------------------------------------------------------
+
+namespace {
+    const size_t DGRAM_PACKETS = 7;
+    const size_t DGRAM_COUNT = 100;
+    const ts::BitRate BITRATE = 10152000;
+}
+
+void PacketPacerTest::testFixedBitrate()
+{
+    ts::TSPacketVector packets;
+    generate(packets, DGRAM_PACKETS * DGRAM_COUNT);
+
+    ts::PacketPacer pacer;
+    pacer.setFixedBitRate(BITRATE);
+
+    const ts::Monotonic start(pacer.departure(packets.data(), DGRAM_PACKETS));
+    for (size_t i = 1; i < DGRAM_COUNT; ++i) {
+        const ts::Monotonic due(pacer.departure(&packets[i * DGRAM_PACKETS], DGRAM_PACKETS));
+        // No accumulated rounding errors.
+        TSUNIT_EQUAL(ts::NanoSecond((i * DGRAM_PACKETS * ts::PKT_SIZE_BITS * ts::NanoSecPerSec) / BITRATE), due - start);
+    }
+}
+
+void PacketPacerTest::testPCR()
+{
+    ts::TSPacketVector packets;
+    generate(packets, DGRAM_PACKETS * DGRAM_COUNT);
+
+    // The bitrate is unknown, the departure times are computed from the PCR's only.
+    ts::PacketPacer pacer;
+    const ts::Monotonic start(pacer.departure(packets.data(), DGRAM_PACKETS));
+    for (size_t i = 1; i < DGRAM_COUNT; ++i) {
+        const ts::Monotonic due(pacer.departure(&packets[i * DGRAM_PACKETS], DGRAM_PACKETS));
+        const ts::NanoSecond expected = (i * DGRAM_PACKETS * 4000 * ts::NanoSecPerMicroSec) / (ts::SYSTEM_CLOCK_FREQ / ts::MicroSecPerSec);
+        TSUNIT_ASSERT(std::abs((due - start) - expected) <= 3);
+    }
+    TSUNIT_EQUAL(100, pacer.getReferencePID());
+}
+
+// A thread which receives datagrams and records their arrival times.
+namespace {
+    const uint16_t PORT_NUMBER = 12346;
+
+    class Receiver: public utest::TSUnitThread
+    {
+        TS_NOCOPY(Receiver);
+    public:
+        std::vector<ts::Monotonic> arrivals;
+
+        Receiver() : utest::TSUnitThread(), arrivals(), _sock(true)
+        {
+            TSUNIT_ASSERT(_sock.reusePort(true, CERR));
+            TSUNIT_ASSERT(_sock.bind(ts::SocketAddress(ts::IPAddress::LocalHost, PORT_NUMBER), CERR));
+        }
+
+        ~Receiver()
+        {
+            waitForTermination();
+        }
+
+        virtual void test() override
+        {
+            // Receive datagrams until a short one.
+            ts::SocketAddress sender;
+            ts::SocketAddress destination;
+            uint8_t buffer[ts::PKT_SIZE * DGRAM_PACKETS];
+            size_t size = sizeof(buffer);
+            while (size == sizeof(buffer)) {
+                TSUNIT_ASSERT(_sock.receive(buffer, sizeof(buffer), size, sender, destination, nullptr, CERR));
+                if (size == sizeof(buffer)) {
+                    arrivals.push_back(ts::Monotonic(true));
+                }
+            }
+        }
+
+    private:
+        ts::UDPSocket _sock;
+    };
+}
+
+void PacketPacerTest::testLoopbackJitter()
+{
+    TSUNIT_ASSERT(ts::IPInitialize());
+
+    ts::TSPacketVector packets;
+    generate(packets, DGRAM_PACKETS * DGRAM_COUNT * 4);
+
+    Receiver receiver;
+    receiver.start();
+
+    ts::UDPSocket sock(true);
+    TSUNIT_ASSERT(sock.setDefaultDestination(ts::SocketAddress(ts::IPAddress::LocalHost, PORT_NUMBER), CERR));
+
+    // Send datagrams paced on PCR's.
+    ts::PacketPacer pacer;
+    for (size_t i = 0; i < DGRAM_COUNT * 4; ++i) {
+        const ts::TSPacket* pkt = &packets[i * DGRAM_PACKETS];
+        pacer.pace(pkt, DGRAM_PACKETS);
+        TSUNIT_ASSERT(sock.send(pkt, ts::PKT_SIZE * DGRAM_PACKETS, CERR));
+    }
+    const uint8_t end = 0;
+    TSUNIT_ASSERT(sock.send(&end, 1, CERR));
+    receiver.waitForTermination();
+
+    // Inter-arrival statistics.
+    const std::vector<ts::Monotonic>& arr(receiver.arrivals);
+    TSUNIT_ASSERT(arr.size() > 2);
+    const ts::NanoSecond interval = (DGRAM_PACKETS * ts::PKT_SIZE_BITS * ts::NanoSecPerSec) / BITRATE;
+    ts::NanoSecond max_jitter = 0;
+    ts::NanoSecond sum_jitter = 0;
+    for (size_t i = 2; i < arr.size(); ++i) {
+        const ts::NanoSecond jitter = std::abs((arr[i] - arr[i-1]) - interval);
+        max_jitter = std::max(max_jitter, jitter);
+        sum_jitter += jitter;
+    }
+    const ts::NanoSecond mean_interval = (arr.back() - arr[1]) / ts::NanoSecond(arr.size() - 2);
+
+    debug() << "PacketPacerTest::testLoopbackJitter: received " << arr.size() << " datagrams" << std::endl
+            << "PacketPacerTest::testLoopbackJitter: expected interval: " << interval << " ns, mean: " << mean_interval << " ns" << std::endl
+            << "PacketPacerTest::testLoopbackJitter: jitter mean: " << (sum_jitter / ts::NanoSecond(arr.size() - 2)) << " ns, max: " << max_jitter << " ns" << std::endl
+            << "PacketPacerTest::testLoopbackJitter: max lateness: " << pacer.maxLateness() << " ns" << std::endl;
+
+    // The average rate must be respected, the jitter depends on the system load and is only reported.
+    TSUNIT_ASSERT(std::abs(mean_interval - interval) < interval / 10);
+}
@@ -59,14 +59,19 @@ public:
     virtual void afterTest() override;
 
     void testPacketizer();
+    void testTemplates();
 
     TSUNIT_TEST_BEGIN(PacketizerTest);
     TSUNIT_TEST(testPacketizer);
+    TSUNIT_TEST(testTemplates);
     TSUNIT_TEST_END();
 
 private:
     // Demux one table from a list of packets
     static void DemuxTable(ts::BinaryTablePtr& binTable, const char* name, const uint8_t* packets, size_t packets_size);
+
+    // Add EIT-like sections of various sizes in a packetizer.
+    static void AddEITSections(ts::CyclingPacketizer& pzer, size_t count);
 };
 
 TSUNIT_REGISTER(PacketizerTest);
@@ -178,3 +183,53 @@ void PacketizerTest::testPacketizer()
     TSUNIT_ASSERT(pmt_count == 4);
     TSUNIT_ASSERT(sdt_count >= 15 && sdt_count <= 18);
 }
+
+// Add EIT-like sections of various sizes in a packetizer.
+void PacketizerTest::AddEITSections(ts::CyclingPacketizer& pzer, size_t count)
+{
+    uint8_t payload[4000];
+    for (size_t i = 0; i < sizeof(payload); ++i) {
+        payload[i] = uint8_t(i);
+    }
+    for (size_t i = 0; i < count; ++i) {
+        const size_t size = 20 + (i * 397) % 4000;
+        pzer.addSection(new ts::Section(ts::TID(ts::TID_EIT_S_ACT_MIN + i % 16), true, uint16_t(i), 0, true, 0, 0, payload, size));
+    }
+}
+
+void PacketizerTest::testTemplates()
+{
+    // The packets must be the same with or without templates, for all stuffing policies.
+    const ts::CyclingPacketizer::StuffingPolicy policies[] = {ts::CyclingPacketizer::ALWAYS, ts::CyclingPacketizer::AT_END, ts::CyclingPacketizer::NEVER};
+    for (size_t ip = 0; ip < 3; ++ip) {
+        ts::DuckContext duck;
+        ts::CyclingPacketizer pz1(duck, 200, policies[ip], 1000000);
+        ts::CyclingPacketizer pz2(duck, 200, policies[ip], 1000000);
+        pz2.usePacketTemplates(false);
+        TSUNIT_ASSERT(pz1.packetTemplatesUsed());
+        TSUNIT_ASSERT(!pz2.packetTemplatesUsed());
+        AddEITSections(pz1, 20);
+        AddEITSections(pz2, 20);
+
+        ts::TSPacket pkt1, pkt2;
+        for (size_t i = 0; i < 2000; ++i) {
+            if (i == 1000) {
+                // Changing the PID invalidates the templates.
+                pz1.setPID(300);
+                pz2.setPID(300);
+            }
+            if (i == 1500) {
+                // Remove some sections in the middle of a cycle.
+                pz1.removeSections(ts::TID_EIT_S_ACT_MIN + 3);
+                pz2.removeSections(ts::TID_EIT_S_ACT_MIN + 3);
+            }
+            TSUNIT_ASSERT(pz1.getNextPacket(pkt1));
+            TSUNIT_ASSERT(pz2.getNextPacket(pkt2));
+            TSUNIT_ASSERT(pkt1 == pkt2);
+            TSUNIT_EQUAL(pz2.atSectionBoundary(), pz1.atSectionBoundary());
+            TSUNIT_EQUAL(pz2.atCycleBoundary(), pz1.atCycleBoundary());
+        }
+        TSUNIT_EQUAL(pz2.sectionCount(), pz1.sectionCount());
+        TSUNIT_EQUAL(pz2.packetCount(), pz1.packetCount());
+    }
+}
@@ -0,0 +1,327 @@
+//----------------------------------------------------------------------------
+//
+// TSDuck - The MPEG Transport Stream Toolkit
+// Copyright (c) 2005-2020, Thierry Lelegard
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+// THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------
+//
+//  TSUnit test suite for class ts::Remultiplexer.
+//
+//----------------------------------------------------------------------------
+
+#include "tsRemultiplexer.h"
+#include "tsDuckContext.h"
+#include "tsPluginRepository.h"
+#include "tsTSFile.h"
+#include "tsThread.h"
+#include "tsGuardCondition.h"
+#include "tsCerrReport.h"
+#include "tsNullReport.h"
+#include "tsSysUtils.h"
+#include "tsunit.h"
+TSDUCK_SOURCE;
+
+
+//----------------------------------------------------------------------------
+// The test fixture
+//----------------------------------------------------------------------------
+
+class RemultiplexerTest: public tsunit::Test
+{
+public:
+    RemultiplexerTest();
+
+    virtual void beforeTest() override;
+    virtual void afterTest() override;
+
+    void testSchedule();
+    void testConflict();
+    void testAbort();
+
+    TSUNIT_TEST_BEGIN(RemultiplexerTest);
+    TSUNIT_TEST(testSchedule);
+    TSUNIT_TEST(testConflict);
+    TSUNIT_TEST(testAbort);
+    TSUNIT_TEST_END();
+
+private:
+    ts::UStringVector _tempFiles;
+
+    // Get the name of a temporary file, created on demand.
+    ts::UString tempFile(size_t index);
+
+    // Create a stream file: one PID, constant bitrate, a PCR every 20 packets, every null_interval packets is a null packet.
+    void createStream(size_t index, ts::PID pid, size_t count, ts::BitRate bitrate, uint64_t first_pcr, size_t null_interval);
+
+    // Build remultiplexer arguments for a list of files.
+    ts::RemultiplexerArgs remuxArgs(size_t count, ts::BitRate bitrate);
+};
+
+TSUNIT_REGISTER(RemultiplexerTest);
+
+
+//----------------------------------------------------------------------------
+// Initialization.
+//----------------------------------------------------------------------------
+
+// Constructor.
+RemultiplexerTest::RemultiplexerTest() :
+    _tempFiles()
+{
+}
+
+// Test suite initialization method.
+void RemultiplexerTest::beforeTest()
+{
+}
+
+// Test suite cleanup method.
+void RemultiplexerTest::afterTest()
+{
+    for (auto it = _tempFiles.begin(); it != _tempFiles.end(); ++it) {
+        ts::DeleteFile(*it);
+    }
+}
+
+ts::UString RemultiplexerTest::tempFile(size_t index)
+{
+    while (_tempFiles.size() <= index) {
+        _tempFiles.push_back(ts::TempFile(u".ts"));
+    }
+    return _tempFiles[index];
+}
+
+void RemultiplexerTest::createStream(size_t index, ts::PID pid, size_t count, ts::BitRate bitrate, uint64_t first_pcr, size_t null_interval)
+{
+    ts::TSPacketVector packets(count);
+    uint8_t cc = 0;
+    for (size_t i = 0; i < count; ++i) {
+        ts::TSPacket& pkt(packets[i]);
+        pkt = ts::NullPacket;
+        if (null_interval == 0 || i % null_interval != null_interval - 1) {
+            pkt.setPID(pid);
+            pkt.setCC(cc);
+            cc = (cc + 1) & ts::CC_MASK;
+            if (i % 20 == 0) {
+                pkt.setPCR((first_pcr + (uint64_t(i) * ts::PKT_SIZE_BITS * ts::SYSTEM_CLOCK_FREQ) / bitrate) % ts::PCR_SCALE, true);
+            }
+        }
+    }
+    ts::TSFile file;
+    TSUNIT_ASSERT(file.open(tempFile(index), ts::TSFile::WRITE, CERR));
+    TSUNIT_ASSERT(file.writePackets(packets.data(), nullptr, packets.size(), CERR));
+    TSUNIT_ASSERT(file.close(CERR));
+}
+
+ts::RemultiplexerArgs RemultiplexerTest::remuxArgs(size_t count, ts::BitRate bitrate)
+{
+    ts::RemultiplexerArgs args;
+    args.appName = u"RemultiplexerTest";
+    args.bitrate = bitrate;
+    args.mergePSI = false;
+    for (size_t i = 0; i < count; ++i) {
+        args.inputs.push_back(ts::PluginOptions(u"file", {tempFile(i)}));
+    }
+    return args;
+}
+
+
+//----------------------------------------------------------------------------
+// An input plugin which never sends packets, until it is aborted.
+//----------------------------------------------------------------------------
+
+namespace {
+    class BlockingInput: public ts::InputPlugin
+    {
+        TS_NOBUILD_NOCOPY(BlockingInput);
+    public:
+        BlockingInput(ts::TSP* t) : ts::InputPlugin(t, u"Test blocking input", u""), _mutex(), _cond(), _aborted(false) {}
+        static ts::InputPlugin* CreateInstance(ts::TSP* t) { return new BlockingInput(t); }
+        virtual bool abortInput() override;
+        virtual size_t receive(ts::TSPacket*, ts::TSPacketMetadata*, size_t) override;
+    private:
+        ts::Mutex     _mutex;
+        ts::Condition _cond;
+        bool          _aborted;
+    };
+
+    bool BlockingInput::abortInput()
+    {
+        ts::GuardCondition lock(_mutex, _cond);
+        _aborted = true;
+        lock.signal();
+        return true;
+    }
+
+    size_t BlockingInput::receive(ts::TSPacket*, ts::TSPacketMetadata*, size_t)
+    {
+        // Wait at most 5 seconds to avoid blocking the test forever.
+        ts::GuardCondition lock(_mutex, _cond);
+        if (!_aborted) {
+            lock.waitCondition(5000);
+        }
+        return 0;
+    }
+}
+
+
+//----------------------------------------------------------------------------
+// A thread which aborts a remultiplexer after some time.
+//----------------------------------------------------------------------------
+
+namespace {
+    class AbortThread: public ts::Thread
+    {
+        TS_NOBUILD_NOCOPY(AbortThread);
+    public:
+        AbortThread(ts::Remultiplexer& remux) : ts::Thread(), _remux(remux) {}
+        virtual ~AbortThread() override { waitForTermination(); }
+    private:
+        ts::Remultiplexer& _remux;
+        virtual void main() override;
+    };
+
+    void AbortThread::main()
+    {
+        ts::SleepThread(100);
+        _remux.abort();
+    }
+}
+
+
+//----------------------------------------------------------------------------
+// Unitary tests.
+//----------------------------------------------------------------------------
+
+void RemultiplexerTest::testSchedule()
+{
+    // Two streams at 1 Mb/s into a 4 Mb/s output. The second one contains null packets.
+    createStream(0, 100, 1000, 1000000, 0, 0);
+    createStream(1, 200, 1000, 1000000, 123456789, 10);
+
+    ts::DuckContext duck;
+    ts::Remultiplexer remux(duck, CERR);
+    TSUNIT_ASSERT(remux.start(remuxArgs(2, 4000000)));
+
+    ts::TSPacketVector output;
+    ts::TSPacket buffer[100];
+    size_t count = 0;
+    while ((count = remux.getPackets(buffer, 100)) > 0) {
+        output.insert(output.end(), buffer, buffer + count);
+    }
+
+    size_t count100 = 0;
+    size_t count200 = 0;
+    size_t pcr_index = ts::NPOS;
+    uint64_t pcr_value = 0;
+    for (size_t i = 0; i < output.size(); ++i) {
+        const ts::PID pid = output[i].getPID();
+        count100 += pid == 100;
+        count200 += pid == 200;
+        // PCR's are consistent with the output bitrate.
+        if (pid == 100 && output[i].hasPCR()) {
+            const uint64_t pcr = output[i].getPCR();
+            if (pcr_index != ts::NPOS) {
+                const uint64_t expected = ((i - pcr_index) * ts::PKT_SIZE_BITS * ts::SYSTEM_CLOCK_FREQ) / 4000000;
+                const uint64_t diff = (pcr + ts::PCR_SCALE - pcr_value) % ts::PCR_SCALE;
+                TSUNIT_ASSERT(diff + 1 >= expected && diff <= expected + 1);
+            }
+            pcr_index = i;
+            pcr_value = pcr;
+        }
+    }
+
+    debug() << "RemultiplexerTest::testSchedule: output: " << output.size()
+            << ", nulls: " << remux.nullPackets()
+            << ", late: " << remux.inputStatistics(0).late << ", " << remux.inputStatistics(1).late
+            << ", max late: " << remux.inputStatistics(0).max_late << ", " << remux.inputStatistics(1).max_late
+            << std::endl;
+
+    TSUNIT_EQUAL(1000, count100);
+    TSUNIT_EQUAL(900, count200);
+    TSUNIT_EQUAL(output.size(), remux.outputPackets());
+    TSUNIT_EQUAL(1000, remux.inputStatistics(0).received);
+    TSUNIT_EQUAL(1000, remux.inputStatistics(0).sent);
+    TSUNIT_EQUAL(1000, remux.inputStatistics(1).received);
+    TSUNIT_EQUAL(900, remux.inputStatistics(1).sent);
+
+    // The output lasts as long as the inputs (4 times more packets at 4 Mb/s), minus the maximum lead.
+    TSUNIT_ASSERT(output.size() >= 3900 && output.size() <= 4100);
+
+    // Packets are never more than one PCR interval late.
+    TSUNIT_ASSERT(remux.inputStatistics(0).max_late < (20 * ts::PKT_SIZE_BITS * ts::SYSTEM_CLOCK_FREQ) / 1000000);
+    TSUNIT_ASSERT(remux.inputStatistics(1).max_late < (20 * ts::PKT_SIZE_BITS * ts::SYSTEM_CLOCK_FREQ) / 1000000);
+
+    remux.stop();
+    TSUNIT_ASSERT(!remux.isStarted());
+}
+
+void RemultiplexerTest::testConflict()
+{
+    // The same PID in the two streams, the second one is dropped.
+    createStream(0, 100, 500, 1000000, 0, 0);
+    createStream(1, 100, 500, 1000000, 0, 0);
+
+    ts::DuckContext duck;
+    ts::Remultiplexer remux(duck, NULLREP);
+    TSUNIT_ASSERT(remux.start(remuxArgs(2, 4000000)));
+
+    ts::TSPacket buffer[100];
+    size_t count100 = 0;
+    size_t count = 0;
+    while ((count = remux.getPackets(buffer, 100)) > 0) {
+        for (size_t i = 0; i < count; ++i) {
+            count100 += buffer[i].getPID() == 100;
+        }
+    }
+
+    TSUNIT_EQUAL(500, count100);
+    TSUNIT_EQUAL(500, remux.inputStatistics(0).sent);
+    TSUNIT_EQUAL(0, remux.inputStatistics(1).sent);
+    TSUNIT_EQUAL(500, remux.inputStatistics(1).dropped);
+}
+
+void RemultiplexerTest::testAbort()
+{
+    // An input which never sends packets, getPackets() waits until the remultiplexer is aborted.
+    ts::PluginRepository::Instance()->registerInput(u"utest_blocking", BlockingInput::CreateInstance);
+    ts::RemultiplexerArgs args;
+    args.appName = u"RemultiplexerTest";
+    args.bitrate = 1000000;
+    args.mergePSI = false;
+    args.inputs.push_back(ts::PluginOptions(u"utest_blocking"));
+
+    ts::DuckContext duck;
+    ts::Remultiplexer remux(duck, CERR);
+    TSUNIT_ASSERT(remux.start(args));
+
+    AbortThread thread(remux);
+    TSUNIT_ASSERT(thread.start());
+
+    ts::TSPacket buffer[100];
+    TSUNIT_EQUAL(0, remux.getPackets(buffer, 100));
+    TSUNIT_ASSERT(thread.waitForTermination());
+    remux.stop();
+}
@@ -33,7 +33,10 @@
 
 #include "tsReportBuffer.h"
 #include "tsReportFile.h"
+#include "tsAsyncReport.h"
+#include "tsSafePtr.h"
 #include "tsSysUtils.h"
+#include "utestTSUnitThread.h"
 #include "tsunit.h"
 TSDUCK_SOURCE;
 
@@ -55,6 +58,10 @@ public:
     void testPrintf();
     void testByName();
     void testByStream();
+    void testAsyncSynchronous();
+    void testAsyncDropNewest();
+    void testAsyncDropOldest();
+    void testAsyncContention();
 
     TSUNIT_TEST_BEGIN(ReportTest);
     TSUNIT_TEST(testSeverity);
@@ -62,6 +69,10 @@ public:
     TSUNIT_TEST(testPrintf);
     TSUNIT_TEST(testByName);
     TSUNIT_TEST(testByStream);
+    TSUNIT_TEST(testAsyncSynchronous);
+    TSUNIT_TEST(testAsyncDropNewest);
+    TSUNIT_TEST(testAsyncDropOldest);
+    TSUNIT_TEST(testAsyncContention);
     TSUNIT_TEST_END();
 
 private:
@@ -325,3 +336,187 @@ void ReportTest::testByStream()
     ts::UString::Load(value, _fileName);
     TSUNIT_ASSERT(value == ref);
 }
+
+// A report handler which collects messages, optionally blocking on the first one.
+namespace {
+    class CollectHandler : public ts::ReportHandler
+    {
+        TS_NOCOPY(CollectHandler);
+    public:
+        ts::UStringVector messages;
+        std::atomic<bool> blocked;
+        std::atomic<bool> entered;
+        std::atomic<size_t> count;
+
+        explicit CollectHandler(bool block = false) : messages(), blocked(block), entered(false), count(0) {}
+
+        virtual void handleMessage(int severity, const ts::UString& msg) override
+        {
+            if (severity <= ts::Severity::Info) {
+                messages.push_back(ts::Severity::Header(severity) + msg);
+            }
+            if (severity == ts::Severity::Info) {
+                count++;
+            }
+            entered = true;
+            while (blocked) {
+                ts::SleepThread(2);
+            }
+        }
+
+        // Wait until the first message is being processed.
+        void waitEntered()
+        {
+            while (!entered) {
+                ts::SleepThread(2);
+            }
+        }
+    };
+}
+
+// Test case: asynchronous report in synchronous mode, no message lost.
+void ReportTest::testAsyncSynchronous()
+{
+    ts::AsyncReportArgs args;
+    args.sync_log = true;
+    args.log_msg_count = 4;
+    CollectHandler handler;
+    {
+        ts::AsyncReport log(ts::Severity::Info, args);
+        log.setMessageHandler(&handler);
+        TSUNIT_EQUAL(4, log.maxMessages());
+        for (int i = 0; i < 100; ++i) {
+            log.info(u"message %d", {i});
+        }
+        log.terminate();
+        TSUNIT_EQUAL(0, log.droppedMessages());
+    }
+    TSUNIT_EQUAL(100, handler.messages.size());
+    for (size_t i = 0; i < handler.messages.size(); ++i) {
+        TSUNIT_EQUAL(ts::UString::Format(u"message %d", {i}), handler.messages[i]);
+    }
+}
+
+// Test case: asynchronous report, drop new messages on overflow.
+void ReportTest::testAsyncDropNewest()
+{
+    ts::AsyncReportArgs args;
+    args.log_msg_count = 4;
+    CollectHandler handler(true);
+    {
+        ts::AsyncReport log(ts::Severity::Info, args);
+        log.setMessageHandler(&handler);
+        log.info(u"message 0");
+        handler.waitEntered();
+        for (int i = 1; i <= 6; ++i) {
+            log.info(u"message %d", {i});
+        }
+        TSUNIT_EQUAL(2, log.droppedMessages());
+        handler.blocked = false;
+        log.terminate();
+    }
+    ts::UStringVector ref;
+    ref.push_back(u"message 0");
+    ref.push_back(u"Warning: 2 log messages dropped, queue is full");
+    ref.push_back(u"message 1");
+    ref.push_back(u"message 2");
+    ref.push_back(u"message 3");
+    ref.push_back(u"message 4");
+    TSUNIT_ASSERT(handler.messages == ref);
+}
+
+// Test case: asynchronous report, drop oldest messages on overflow.
+void ReportTest::testAsyncDropOldest()
+{
+    ts::AsyncReportArgs args;
+    args.log_msg_count = 4;
+    args.drop_oldest_log = true;
+    CollectHandler handler(true);
+    {
+        ts::AsyncReport log(ts::Severity::Info, args);
+        log.setMessageHandler(&handler);
+        TSUNIT_ASSERT(log.getDropOldest());
+        log.info(u"message 0");
+        handler.waitEntered();
+        for (int i = 1; i <= 6; ++i) {
+            log.info(u"message %d", {i});
+        }
+        TSUNIT_EQUAL(2, log.droppedMessages());
+        handler.blocked = false;
+        log.terminate();
+    }
+    ts::UStringVector ref;
+    ref.push_back(u"message 0");
+    ref.push_back(u"Warning: 2 log messages dropped, queue is full");
+    ref.push_back(u"message 3");
+    ref.push_back(u"message 4");
+    ref.push_back(u"message 5");
+    ref.push_back(u"message 6");
+    TSUNIT_ASSERT(handler.messages == ref);
+}
+
+// Test case: asynchronous report with concurrent threads.
+// In synchronous mode, all messages from all threads must be logged exactly once, in order for each thread.
+namespace {
+    class LogThread : public utest::TSUnitThread
+    {
+        TS_NOBUILD_NOCOPY(LogThread);
+    public:
+        LogThread(ts::Report& report, int id, int count) : utest::TSUnitThread(), _report(report), _id(id), _count(count) {}
+        virtual ~LogThread() override { waitForTermination(); }
+        virtual void test() override
+        {
+            for (int i = 0; i < _count; ++i) {
+                _report.info(u"thread %d, message %d", {_id, i});
+            }
+        }
+    private:
+        ts::Report& _report;
+        const int _id;
+        const int _count;
+    };
+}
+
+void ReportTest::testAsyncContention()
+{
+    const int thread_count = 4;
+    const int msg_count = 2000;
+
+    ts::AsyncReportArgs args;
+    args.sync_log = true;
+    args.log_msg_count = 4;
+    CollectHandler handler;
+    {
+        ts::AsyncReport log(ts::Severity::Info, args);
+        log.setMessageHandler(&handler);
+        {
+            std::vector<ts::SafePtr<LogThread>> threads;
+            for (int i = 0; i < thread_count; ++i) {
+                threads.push_back(new LogThread(log, i, msg_count));
+            }
+            for (int i = 0; i < thread_count; ++i) {
+                threads[i]->start();
+            }
+            for (int i = 0; i < thread_count; ++i) {
+                threads[i]->waitForTermination();
+            }
+        }
+        log.terminate();
+        TSUNIT_EQUAL(0, log.droppedMessages());
+    }
+
+    // Messages from distinct threads are interleaved but each thread must be in sequence.
+    TSUNIT_EQUAL(size_t(thread_count * msg_count), handler.messages.size());
+    std::vector<int> next(thread_count, 0);
+    for (const auto& msg : handler.messages) {
+        int id = -1;
+        int index = -1;
+        TSUNIT_ASSERT(msg.scan(u"thread %d, message %d", {&id, &index}));
+        TSUNIT_ASSERT(id >= 0 && id < thread_count);
+        TSUNIT_EQUAL(next[id], index);
+        next[id]++;
+    }
+    for (int i = 0; i < thread_count; ++i) {
+        TSUNIT_EQUAL(msg_count, next[i]);
+    }
+}
@@ -0,0 +1,296 @@
+//----------------------------------------------------------------------------
+//
+// TSDuck - The MPEG Transport Stream Toolkit
+// Copyright (c) 2005-2020, Thierry Lelegard
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+// THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------
+//
+//  TSUnit test suite for class ts::SectionFileIndex
+//
+//----------------------------------------------------------------------------
+
+#include "tsSectionFileIndex.h"
+#include "tsSectionFile.h"
+#include "tsDuckContext.h"
+#include "tsSysUtils.h"
+#include "tsNullReport.h"
+#include "tsunit.h"
+TSDUCK_SOURCE;
+
+
+//----------------------------------------------------------------------------
+// The test fixture
+//----------------------------------------------------------------------------
+
+class SectionFileIndexTest: public tsunit::Test
+{
+public:
+    SectionFileIndexTest();
+
+    virtual void beforeTest() override;
+    virtual void afterTest() override;
+
+    void testBuild();
+    void testSaveLoad();
+    void testSelect();
+    void testLoadSections();
+    void testTruncated();
+
+    TSUNIT_TEST_BEGIN(SectionFileIndexTest);
+    TSUNIT_TEST(testBuild);
+    TSUNIT_TEST(testSaveLoad);
+    TSUNIT_TEST(testSelect);
+    TSUNIT_TEST(testLoadSections);
+    TSUNIT_TEST(testTruncated);
+    TSUNIT_TEST_END();
+
+private:
+    ts::UString _tempFileNameBin;
+    ts::UString _tempFileNameIdx;
+
+    // Build a binary section file with 10 long sections and 10 short sections, interleaved.
+    // Build the corresponding index with one section per second from a given time.
+    void buildFile(ts::SectionFileIndex& index, const ts::Time& start);
+};
+
+TSUNIT_REGISTER(SectionFileIndexTest);
+
+
+//----------------------------------------------------------------------------
+// Initialization.
+//----------------------------------------------------------------------------
+
+// Constructor.
+SectionFileIndexTest::SectionFileIndexTest() :
+    _tempFileNameBin(),
+    _tempFileNameIdx()
+{
+}
+
+// Test suite initialization method.
+void SectionFileIndexTest::beforeTest()
+{
+    if (_tempFileNameBin.empty() || _tempFileNameIdx.empty()) {
+        _tempFileNameBin = ts::TempFile(u".tmp.bin");
+        _tempFileNameIdx = ts::SectionFileIndex::DefaultFileName(_tempFileNameBin);
+    }
+    ts::DeleteFile(_tempFileNameBin);
+    ts::DeleteFile(_tempFileNameIdx);
+}
+
+// Test suite cleanup method.
+void SectionFileIndexTest::afterTest()
+{
+    ts::DeleteFile(_tempFileNameBin);
+    ts::DeleteFile(_tempFileNameIdx);
+}
+
+
+//----------------------------------------------------------------------------
+// Test utilities.
+//----------------------------------------------------------------------------
+
+void SectionFileIndexTest::buildFile(ts::SectionFileIndex& index, const ts::Time& start)
+{
+    index.clear();
+    std::ofstream strm(_tempFileNameBin.toUTF8().c_str(), std::ios::out | std::ios::binary);
+    TSUNIT_ASSERT(strm.is_open());
+
+    uint64_t offset = 0;
+    for (size_t i = 0; i < 20; ++i) {
+        const uint8_t payload[] = {uint8_t(i), 0x01, 0x02, 0x03};
+        ts::SectionPtr sp;
+        if (i % 2 == 0) {
+            // Long section, table id 0x42, tid ext 100 + i/2, version i/2, section number i/4.
+            sp = new ts::Section(0x42, true, uint16_t(100 + i / 2), uint8_t(i / 2), true, uint8_t(i / 4), uint8_t(i / 4), payload, sizeof(payload), 200);
+        }
+        else {
+            // Short section, table id 0x70.
+            sp = new ts::Section(0x70, false, payload, sizeof(payload), 300);
+        }
+        ts::Section& sect(*sp);
+        TSUNIT_ASSERT(sect.isValid());
+        sect.setFirstTSPacketIndex(1000 + i);
+        TSUNIT_ASSERT(bool(sect.write(strm)));
+        index.add(ts::SectionFileIndex::Entry(sect, offset, start + ts::MilliSecond(i) * ts::MilliSecPerSec));
+        offset += sect.size();
+    }
+    strm.close();
+}
+
+
+//----------------------------------------------------------------------------
+// Test cases
+//----------------------------------------------------------------------------
+
+void SectionFileIndexTest::testBuild()
+{
+    ts::SectionFileIndex ref;
+    buildFile(ref, ts::Time(2020, 5, 1, 12, 0, 0));
+    TSUNIT_EQUAL(20, ref.size());
+
+    // Rebuild the index from the binary file: same content, except PID, packet index and time.
+    ts::SectionFileIndex index;
+    TSUNIT_ASSERT(index.build(_tempFileNameBin, CERR));
+    TSUNIT_EQUAL(20, index.size());
+    for (size_t i = 0; i < index.size(); ++i) {
+        const ts::SectionFileIndex::Entry& e1(ref.entries()[i]);
+        const ts::SectionFileIndex::Entry& e2(index.entries()[i]);
+        TSUNIT_EQUAL(e1.offset, e2.offset);
+        TSUNIT_EQUAL(e1.size, e2.size);
+        TSUNIT_EQUAL(e1.tid, e2.tid);
+        TSUNIT_EQUAL(e1.long_section, e2.long_section);
+        TSUNIT_EQUAL(e1.tid_ext, e2.tid_ext);
+        TSUNIT_EQUAL(e1.version, e2.version);
+        TSUNIT_EQUAL(e1.section_number, e2.section_number);
+        TSUNIT_EQUAL(ts::PID_NULL, e2.pid);
+        TSUNIT_ASSERT(e2.timestamp == ts::Time::Epoch);
+    }
+    TSUNIT_EQUAL(0x42, index.entries()[4].tid);
+    TSUNIT_EQUAL(102, index.entries()[4].tid_ext);
+    TSUNIT_EQUAL(2, index.entries()[4].version);
+    TSUNIT_EQUAL(1, index.entries()[4].section_number);
+}
+
+void SectionFileIndexTest::testSaveLoad()
+{
+    ts::SectionFileIndex ref;
+    buildFile(ref, ts::Time(2020, 5, 1, 12, 0, 0));
+    TSUNIT_ASSERT(ref.save(_tempFileNameIdx, CERR));
+    TSUNIT_EQUAL(ts::SectionFileIndex::HEADER_SIZE + 20 * ts::SectionFileIndex::RECORD_SIZE, ts::GetFileSize(_tempFileNameIdx));
+
+    ts::SectionFileIndex index;
+    TSUNIT_ASSERT(index.load(_tempFileNameIdx, CERR));
+    TSUNIT_EQUAL(20, index.size());
+    for (size_t i = 0; i < index.size(); ++i) {
+        const ts::SectionFileIndex::Entry& e1(ref.entries()[i]);
+        const ts::SectionFileIndex::Entry& e2(index.entries()[i]);
+        TSUNIT_EQUAL(e1.offset, e2.offset);
+        TSUNIT_EQUAL(e1.size, e2.size);
+        TSUNIT_EQUAL(e1.pid, e2.pid);
+        TSUNIT_EQUAL(e1.tid, e2.tid);
+        TSUNIT_EQUAL(e1.long_section, e2.long_section);
+        TSUNIT_EQUAL(e1.tid_ext, e2.tid_ext);
+        TSUNIT_EQUAL(e1.version, e2.version);
+        TSUNIT_EQUAL(e1.section_number, e2.section_number);
+        TSUNIT_EQUAL(e1.packet, e2.packet);
+        TSUNIT_ASSERT(e1.timestamp == e2.timestamp);
+    }
+}
+
+void SectionFileIndexTest::testSelect()
+{
+    const ts::Time start(2020, 5, 1, 12, 0, 0);
+    ts::SectionFileIndex index;
+    buildFile(index, start);
+
+    ts::SectionFileIndex::EntryVector entries;
+    ts::SectionFileIndex::Filter filter;
+
+    // No criteria: all sections.
+    index.select(filter, entries);
+    TSUNIT_EQUAL(20, entries.size());
+    TSUNIT_ASSERT(!filter.needsCollectionInfo());
+
+    // Time range: sections 5 to 9.
+    filter.start = start + 5 * ts::MilliSecPerSec;
+    filter.end = start + 10 * ts::MilliSecPerSec;
+    TSUNIT_ASSERT(filter.needsCollectionInfo());
+    index.select(filter, entries);
+    TSUNIT_EQUAL(5, entries.size());
+    TSUNIT_EQUAL(1005, entries[0].packet);
+    TSUNIT_EQUAL(1009, entries[4].packet);
+
+    // Time range and table id: sections 6 and 8.
+    filter.tids.insert(0x42);
+    index.select(filter, entries);
+    TSUNIT_EQUAL(2, entries.size());
+    TSUNIT_EQUAL(1006, entries[0].packet);
+    TSUNIT_EQUAL(1008, entries[1].packet);
+
+    // Table id extension, without time range.
+    filter.start = ts::Time::Epoch;
+    filter.end = ts::Time::Apocalypse;
+    filter.tid_exts.insert(107);
+    TSUNIT_ASSERT(!filter.needsCollectionInfo());
+    index.select(filter, entries);
+    TSUNIT_EQUAL(1, entries.size());
+    TSUNIT_EQUAL(1014, entries[0].packet);
+
+    // PID of short sections.
+    filter = ts::SectionFileIndex::Filter();
+    filter.pids.set(300);
+    TSUNIT_ASSERT(filter.needsCollectionInfo());
+    index.select(filter, entries);
+    TSUNIT_EQUAL(10, entries.size());
+    for (size_t i = 0; i < entries.size(); ++i) {
+        TSUNIT_EQUAL(0x70, entries[i].tid);
+    }
+}
+
+void SectionFileIndexTest::testLoadSections()
+{
+    ts::DuckContext duck;
+    ts::SectionFileIndex index;
+    buildFile(index, ts::Time(2020, 5, 1, 12, 0, 0));
+
+    ts::SectionFileIndex::Filter filter;
+    filter.tid_exts.insert(103);
+    filter.tid_exts.insert(105);
+
+    ts::SectionFile file(duck);
+    TSUNIT_ASSERT(file.loadBinary(_tempFileNameBin, index, filter, CERR));
+    TSUNIT_EQUAL(2, file.sections().size());
+    TSUNIT_EQUAL(0x42, file.sections()[0]->tableId());
+    TSUNIT_EQUAL(103, file.sections()[0]->tableIdExtension());
+    TSUNIT_EQUAL(3, file.sections()[0]->version());
+    TSUNIT_EQUAL(200, file.sections()[0]->sourcePID());
+    TSUNIT_EQUAL(1006, file.sections()[0]->getFirstTSPacketIndex());
+    TSUNIT_EQUAL(105, file.sections()[1]->tableIdExtension());
+    TSUNIT_EQUAL(10, file.sections()[1]->payload()[0]);
+}
+
+void SectionFileIndexTest::testTruncated()
+{
+    ts::SectionFileIndex ref;
+    buildFile(ref, ts::Time(2020, 5, 1, 12, 0, 0));
+
+    // Index of an interrupted capture: last record is incomplete.
+    std::ofstream strm(_tempFileNameIdx.toUTF8().c_str(), std::ios::out | std::ios::binary);
+    TSUNIT_ASSERT(ts::SectionFileIndex::WriteHeader(strm));
+    for (size_t i = 0; i < 3; ++i) {
+        TSUNIT_ASSERT(ts::SectionFileIndex::WriteEntry(strm, ref.entries()[i]));
+    }
+    strm.write("\x00\x00\x00", 3);
+    strm.close();
+
+    ts::SectionFileIndex index;
+    TSUNIT_ASSERT(index.load(_tempFileNameIdx, NULLREP));
+    TSUNIT_EQUAL(3, index.size());
+
+    // Not an index file.
+    TSUNIT_ASSERT(!index.load(_tempFileNameBin, NULLREP));
+    TSUNIT_EQUAL(0, index.size());
+}
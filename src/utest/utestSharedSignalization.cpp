@@ -0,0 +1,258 @@
+//----------------------------------------------------------------------------
+//
+// TSDuck - The MPEG Transport Stream Toolkit
+// Copyright (c) 2005-2020, Thierry Lelegard
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+// THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------
+//
+//  TSUnit test suite for class ts::SharedSignalization
+//
+//----------------------------------------------------------------------------
+
+#include "tsSharedSignalization.h"
+#include "tsOneShotPacketizer.h"
+#include "tsDuckContext.h"
+#include "tsunit.h"
+TSDUCK_SOURCE;
+
+
+//----------------------------------------------------------------------------
+// The test fixture
+//----------------------------------------------------------------------------
+
+class SharedSignalizationTest: public tsunit::Test
+{
+public:
+    virtual void beforeTest() override;
+    virtual void afterTest() override;
+
+    void testDelivery();
+    void testLateSubscriber();
+    void testMaxTables();
+
+    TSUNIT_TEST_BEGIN(SharedSignalizationTest);
+    TSUNIT_TEST(testDelivery);
+    TSUNIT_TEST(testLateSubscriber);
+    TSUNIT_TEST(testMaxTables);
+    TSUNIT_TEST_END();
+
+private:
+    // Build a stream: PAT, 10 null packets, PMT of service 1 on PID 100, TDT.
+    static void BuildStream(ts::TSPacketVector& packets);
+
+    // Build a one-packet TDT. The second is also used as continuity counter.
+    static ts::TSPacket BuildTDT(int second);
+};
+
+TSUNIT_REGISTER(SharedSignalizationTest);
+
+
+//----------------------------------------------------------------------------
+// Initialization.
+//----------------------------------------------------------------------------
+
+// Test suite initialization method.
+void SharedSignalizationTest::beforeTest()
+{
+}
+
+// Test suite cleanup method.
+void SharedSignalizationTest::afterTest()
+{
+}
+
+
+//----------------------------------------------------------------------------
+// Test utilities.
+//----------------------------------------------------------------------------
+
+namespace {
+    // Record the deserialized tables and the packet index at which they were received.
+    class SigRecorder: public ts::SignalizationHandlerInterface
+    {
+    public:
+        ts::PacketCounter position;
+        std::vector<std::pair<ts::TID, ts::PacketCounter>> tables;
+        SigRecorder() : position(0), tables() {}
+        virtual void handlePAT(const ts::PAT&, ts::PID) override { tables.push_back(std::make_pair(ts::TID_PAT, position)); }
+        virtual void handlePMT(const ts::PMT&, ts::PID) override { tables.push_back(std::make_pair(ts::TID_PMT, position)); }
+        virtual void handleTDT(const ts::TDT&, ts::PID) override { tables.push_back(std::make_pair(ts::TID_TDT, position)); }
+    };
+
+    // Record the binary tables and the packet index at which they were received.
+    class BinRecorder: public ts::TableHandlerInterface
+    {
+    public:
+        ts::PacketCounter position;
+        std::vector<std::pair<ts::TID, ts::PacketCounter>> tables;
+        BinRecorder() : position(0), tables() {}
+        virtual void handleTable(ts::SectionDemux&, const ts::BinaryTable& table) override { tables.push_back(std::make_pair(table.tableId(), position)); }
+    };
+}
+
+void SharedSignalizationTest::BuildStream(ts::TSPacketVector& packets)
+{
+    ts::DuckContext duck;
+    ts::TSPacketVector pkts;
+
+    ts::PAT pat(0, true, 1);
+    pat.pmts[1] = 100;
+    ts::OneShotPacketizer pzpat(duck, ts::PID_PAT);
+    pzpat.addTable(duck, pat);
+    pzpat.getPackets(packets);
+
+    for (size_t i = 0; i < 10; ++i) {
+        packets.push_back(ts::NullPacket);
+    }
+
+    ts::PMT pmt(0, true, 1, 101);
+    ts::OneShotPacketizer pzpmt(duck, 100);
+    pzpmt.addTable(duck, pmt);
+    pzpmt.getPackets(pkts);
+    packets.insert(packets.end(), pkts.begin(), pkts.end());
+
+    packets.push_back(BuildTDT(0));
+}
+
+ts::TSPacket SharedSignalizationTest::BuildTDT(int second)
+{
+    ts::DuckContext duck;
+    ts::TSPacketVector pkts;
+    ts::TDT tdt(ts::Time(2020, 1, 2, 3, 4, second));
+    ts::OneShotPacketizer pztdt(duck, ts::PID_TDT);
+    pztdt.addTable(duck, tdt);
+    pztdt.getPackets(pkts);
+    TSUNIT_EQUAL(1, pkts.size());
+    // Successive TDT packets must have distinct continuity counters.
+    pkts[0].setCC(uint8_t(second % 16));
+    return pkts[0];
+}
+
+
+//----------------------------------------------------------------------------
+// Unitary tests.
+//----------------------------------------------------------------------------
+
+void SharedSignalizationTest::testDelivery()
+{
+    ts::TSPacketVector packets;
+    BuildStream(packets);
+    TSUNIT_EQUAL(13, packets.size());
+
+    ts::DuckContext duck;
+    ts::SharedSignalization shared;
+    SigRecorder sig;
+    BinRecorder bin;
+
+    const int id1 = shared.subscribe(duck, &sig);
+    TSUNIT_ASSERT(shared.addTableId(id1, ts::TID_PAT));
+    shared.addServiceId(id1, 1);
+
+    const int id2 = shared.subscribe(duck, nullptr, &bin);
+    TSUNIT_ASSERT(shared.addTableId(id2, ts::TID_TDT));
+    TSUNIT_ASSERT(id1 != id2);
+
+    // The input thread feeds all packets at once.
+    shared.feedPackets(&packets[0], packets.size());
+    TSUNIT_EQUAL(13, shared.packetCount());
+
+    // The subscribers get their tables at the same packets as with their own demux.
+    for (size_t i = 0; i < packets.size(); ++i) {
+        sig.position = bin.position = i;
+        shared.deliver(id1, i);
+        shared.deliver(id2, i);
+    }
+
+    TSUNIT_EQUAL(2, sig.tables.size());
+    TSUNIT_EQUAL(ts::TID_PAT, sig.tables[0].first);
+    TSUNIT_EQUAL(0, sig.tables[0].second);
+    TSUNIT_EQUAL(ts::TID_PMT, sig.tables[1].first);
+    TSUNIT_EQUAL(11, sig.tables[1].second);
+
+    TSUNIT_EQUAL(1, bin.tables.size());
+    TSUNIT_EQUAL(ts::TID_TDT, bin.tables[0].first);
+    TSUNIT_EQUAL(12, bin.tables[0].second);
+
+    // Nothing more to deliver.
+    TSUNIT_EQUAL(0, shared.deliver(id1, 100));
+    TSUNIT_EQUAL(0, shared.deliver(id2, 100));
+    shared.unsubscribe(id1);
+    shared.unsubscribe(id2);
+}
+
+void SharedSignalizationTest::testLateSubscriber()
+{
+    ts::TSPacketVector packets;
+    BuildStream(packets);
+
+    ts::DuckContext duck;
+    ts::SharedSignalization shared;
+    SigRecorder early;
+    SigRecorder late;
+
+    const int id1 = shared.subscribe(duck, &early);
+    shared.addTableId(id1, ts::TID_PAT);
+    shared.addTableId(id1, ts::TID_TDT);
+
+    // Feed the PAT only.
+    shared.feedPackets(&packets[0], 1);
+
+    const int id2 = shared.subscribe(duck, &late);
+    shared.addTableId(id2, ts::TID_PAT);
+    shared.addTableId(id2, ts::TID_TDT);
+
+    // Feed the rest of the stream.
+    shared.feedPackets(&packets[1], packets.size() - 1);
+
+    // The late subscriber does not get the PAT which was demuxed before its subscription.
+    TSUNIT_EQUAL(2, shared.deliver(id1, packets.size()));
+    TSUNIT_EQUAL(1, shared.deliver(id2, packets.size()));
+    TSUNIT_EQUAL(ts::TID_TDT, late.tables[0].first);
+
+    // The subscriber can remove a filter.
+    shared.removeTableId(id2, ts::TID_TDT);
+    const ts::TSPacket tdt(BuildTDT(1));
+    shared.feedPackets(&tdt, 1);
+    TSUNIT_EQUAL(1, shared.deliver(id1, packets.size() + 1));
+    TSUNIT_EQUAL(0, shared.deliver(id2, packets.size() + 1));
+}
+
+void SharedSignalizationTest::testMaxTables()
+{
+    ts::DuckContext duck;
+    ts::SharedSignalization shared(2);
+    SigRecorder sig;
+
+    const int id = shared.subscribe(duck, &sig);
+    shared.addTableId(id, ts::TID_TDT);
+
+    // A subscriber which does not retrieve its tables loses the oldest ones.
+    for (int i = 0; i < 5; ++i) {
+        const ts::TSPacket tdt(BuildTDT(i));
+        shared.feedPackets(&tdt, 1);
+    }
+    TSUNIT_EQUAL(2, shared.deliver(id, 5));
+    TSUNIT_EQUAL(2, sig.tables.size());
+}
@@ -0,0 +1,317 @@
+//----------------------------------------------------------------------------
+//
+// TSDuck - The MPEG Transport Stream Toolkit
+// Copyright (c) 2005-2020, Thierry Lelegard
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+// THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------
+//
+//  TSUnit test suite for class ts::StartCodeScanner
+//
+//----------------------------------------------------------------------------
+
+#include "tsStartCodeScanner.h"
+#include "tsAVCParser.h"
+#include "tsByteBlock.h"
+#include "tsMemory.h"
+#include "tsunit.h"
+TSDUCK_SOURCE;
+
+
+//----------------------------------------------------------------------------
+// The test fixture
+//----------------------------------------------------------------------------
+
+class StartCodeScannerTest: public tsunit::Test
+{
+public:
+    virtual void beforeTest() override;
+    virtual void afterTest() override;
+
+    void testDelimiters();
+    void testNALUnits();
+    void testVideoUnits();
+    void testEmulationPrevention();
+    void testLargePayload();
+
+    TSUNIT_TEST_BEGIN(StartCodeScannerTest);
+    TSUNIT_TEST(testDelimiters);
+    TSUNIT_TEST(testNALUnits);
+    TSUNIT_TEST(testVideoUnits);
+    TSUNIT_TEST(testEmulationPrevention);
+    TSUNIT_TEST(testLargePayload);
+    TSUNIT_TEST_END();
+};
+
+TSUNIT_REGISTER(StartCodeScannerTest);
+
+
+//----------------------------------------------------------------------------
+// Initialization.
+//----------------------------------------------------------------------------
+
+void StartCodeScannerTest::beforeTest()
+{
+}
+
+void StartCodeScannerTest::afterTest()
+{
+}
+
+
+//----------------------------------------------------------------------------
+// Test data and reference implementations.
+//----------------------------------------------------------------------------
+
+namespace {
+
+    const uint8_t StartCodePrefix[] = {0x00, 0x00, 0x01};
+    const uint8_t Zero3[] = {0x00, 0x00, 0x00};
+
+    // Build a pseudo-random AVC-like payload: NAL units with start codes, emulation
+    // prevention sequences, some 00 00 00 trailing zeroes and random bytes.
+    void BuildPayload(ts::ByteBlock& data, size_t nalunit_count, size_t nalunit_size, uint32_t seed)
+    {
+        data.clear();
+        uint32_t rnd = seed;
+        for (size_t n = 0; n < nalunit_count; ++n) {
+            if (n % 5 == 4) {
+                data.append(Zero3, sizeof(Zero3));
+            }
+            data.append(StartCodePrefix, sizeof(StartCodePrefix));
+            for (size_t i = 0; i < nalunit_size; ++i) {
+                rnd = rnd * 1103515245 + 12345;
+                const uint8_t b = uint8_t(rnd >> 16);
+                if (b < 4) {
+                    // Insert some 00 00 xx sequences (xx <= 3).
+                    data.appendUInt8(0x00);
+                    data.appendUInt8(0x00);
+                    data.appendUInt8(b == 2 ? 0x03 : b);
+                }
+                else {
+                    data.appendUInt8(b);
+                }
+            }
+        }
+    }
+
+    // Reference implementation of 00 00 xx search.
+    void ReferenceScan(const ts::ByteBlock& data, std::vector<size_t>& delimiters, std::vector<size_t>& epb)
+    {
+        delimiters.clear();
+        epb.clear();
+        for (size_t i = 0; i + 2 < data.size(); ++i) {
+            if (data[i] == 0x00 && data[i+1] == 0x00) {
+                if (data[i+2] <= 0x01) {
+                    delimiters.push_back(i);
+                }
+                else if (data[i+2] == 0x03) {
+                    epb.push_back(i + 2);
+                }
+            }
+        }
+    }
+
+    // Previous implementation of NAL units location in PESDemux.
+    void ReferenceNALUnits(const uint8_t* pdata, size_t psize, ts::StartCodeScanner::UnitVector& units)
+    {
+        units.clear();
+        for (size_t offset = 0; offset < psize; ) {
+            const uint8_t* p1 = reinterpret_cast<const uint8_t*>(ts::LocatePattern(pdata + offset, psize - offset, StartCodePrefix, sizeof(StartCodePrefix)));
+            if (p1 == nullptr) {
+                break;
+            }
+            offset = p1 - pdata + sizeof(StartCodePrefix);
+            const uint8_t* p2 = reinterpret_cast<const uint8_t*>(ts::LocatePattern(pdata + offset, psize - offset, StartCodePrefix, sizeof(StartCodePrefix)));
+            const uint8_t* p3 = reinterpret_cast<const uint8_t*>(ts::LocatePattern(pdata + offset, psize - offset, Zero3, sizeof(Zero3)));
+            size_t size = 0;
+            if (p2 == nullptr && p3 == nullptr) {
+                size = psize - offset;
+            }
+            else if (p2 == nullptr || (p3 != nullptr && p3 < p2)) {
+                size = p3 - pdata - offset;
+            }
+            else {
+                size = p2 - pdata - offset;
+            }
+            units.push_back(ts::StartCodeScanner::Unit(offset, size));
+            offset += size;
+        }
+    }
+
+    // Previous implementation of MPEG-2 video units location in PESDemux.
+    void ReferenceVideoUnits(const uint8_t* pdata, size_t psize, ts::StartCodeScanner::UnitVector& units)
+    {
+        units.clear();
+        for (size_t offset = 0; offset < psize; ) {
+            const void* pnext = ts::LocatePattern(pdata + offset + 1, psize - offset - 1, StartCodePrefix, sizeof(StartCodePrefix));
+            const size_t next = pnext == nullptr ? psize : reinterpret_cast<const uint8_t*>(pnext) - pdata;
+            units.push_back(ts::StartCodeScanner::Unit(offset, next - offset));
+            offset = next;
+        }
+    }
+
+    // Compare two lists of units.
+    bool SameUnits(const ts::StartCodeScanner::UnitVector& u1, const ts::StartCodeScanner::UnitVector& u2)
+    {
+        if (u1.size() != u2.size()) {
+            return false;
+        }
+        for (size_t i = 0; i < u1.size(); ++i) {
+            if (u1[i].offset != u2[i].offset || u1[i].size != u2[i].size) {
+                return false;
+            }
+        }
+        return true;
+    }
+}
+
+
+//----------------------------------------------------------------------------
+// Unitary tests.
+//----------------------------------------------------------------------------
+
+void StartCodeScannerTest::testDelimiters()
+{
+    ts::StartCodeScanner scanner;
+    ts::ByteBlock data;
+    std::vector<size_t> delimiters;
+    std::vector<size_t> epb;
+
+    // Various sizes and alignments around the vectorized width.
+    for (size_t size = 1; size < 40; ++size) {
+        BuildPayload(data, 3, size, uint32_t(size));
+        for (size_t start = 0; start < 4 && start < data.size(); ++start) {
+            const ts::ByteBlock area(data.data() + start, data.size() - start);
+            scanner.scan(area.data(), area.size());
+            ReferenceScan(area, delimiters, epb);
+            TSUNIT_ASSERT(delimiters == scanner.delimiters());
+            TSUNIT_ASSERT(epb == scanner.emulationPreventionBytes());
+        }
+    }
+
+    // Consecutive zeroes.
+    const ts::ByteBlock zeroes(40, 0x00);
+    scanner.scan(zeroes.data(), zeroes.size());
+    TSUNIT_EQUAL(38, scanner.delimiters().size());
+    TSUNIT_ASSERT(scanner.emulationPreventionBytes().empty());
+
+    scanner.scan(nullptr, 0);
+    TSUNIT_ASSERT(scanner.delimiters().empty());
+}
+
+void StartCodeScannerTest::testNALUnits()
+{
+    ts::StartCodeScanner scanner;
+    ts::StartCodeScanner::UnitVector units;
+    ts::StartCodeScanner::UnitVector ref;
+    ts::ByteBlock data;
+
+    static const uint8_t sample[] = {
+        0x00, 0x00, 0x01, 0x09, 0x10,                    // 3: AUD, size 2
+        0x00, 0x00, 0x00, 0x01, 0x67, 0x64, 0x00, 0x28,  // 9: SPS, size 4
+        0x00, 0x00, 0x01, 0x68, 0xEE, 0x00, 0x00, 0x03,  // 16: PPS, size 7
+        0x00, 0xAB, 0x00,
+        0x00, 0x00,
+    };
+    scanner.scan(sample, sizeof(sample));
+    scanner.getNALUnits(units);
+    TSUNIT_EQUAL(3, units.size());
+    TSUNIT_EQUAL(3, units[0].offset);
+    TSUNIT_EQUAL(2, units[0].size);
+    TSUNIT_EQUAL(9, units[1].offset);
+    TSUNIT_EQUAL(4, units[1].size);
+    TSUNIT_EQUAL(16, units[2].offset);
+    TSUNIT_EQUAL(7, units[2].size);
+    TSUNIT_EQUAL(1, scanner.emulationPreventionBytes().size());
+    TSUNIT_EQUAL(20, scanner.emulationPreventionBytes()[0]);
+
+    for (size_t size = 0; size < 100; size += 7) {
+        BuildPayload(data, 10, size, uint32_t(size + 1000));
+        scanner.scan(data.data(), data.size());
+        scanner.getNALUnits(units);
+        ReferenceNALUnits(data.data(), data.size(), ref);
+        TSUNIT_ASSERT(SameUnits(ref, units));
+    }
+}
+
+void StartCodeScannerTest::testVideoUnits()
+{
+    ts::StartCodeScanner scanner;
+    ts::StartCodeScanner::UnitVector units;
+    ts::StartCodeScanner::UnitVector ref;
+    ts::ByteBlock data;
+
+    for (size_t size = 0; size < 100; size += 7) {
+        BuildPayload(data, 10, size, uint32_t(size + 2000));
+        scanner.scan(data.data(), data.size());
+        scanner.getVideoUnits(units);
+        ReferenceVideoUnits(data.data(), data.size(), ref);
+        TSUNIT_ASSERT(SameUnits(ref, units));
+    }
+}
+
+void StartCodeScannerTest::testEmulationPrevention()
+{
+    static const uint8_t data[] = {0x00, 0x00, 0x03, 0x00, 0x00, 0x03, 0x01, 0x00, 0x03, 0x00, 0x00, 0x00, 0x03};
+    const uint8_t* const end = data + sizeof(data);
+
+    TSUNIT_ASSERT(ts::StartCodeScanner::NextEmulationPrevention(data, data, end) == data + 2);
+    TSUNIT_ASSERT(ts::StartCodeScanner::NextEmulationPrevention(data, data + 2, end) == data + 2);
+    TSUNIT_ASSERT(ts::StartCodeScanner::NextEmulationPrevention(data, data + 3, end) == data + 5);
+    TSUNIT_ASSERT(ts::StartCodeScanner::NextEmulationPrevention(data, data + 6, end) == data + 12);
+    TSUNIT_ASSERT(ts::StartCodeScanner::NextEmulationPrevention(data, data + 13, end) == nullptr);
+    TSUNIT_ASSERT(ts::StartCodeScanner::NextEmulationPrevention(data + 1, data + 1, end) == data + 5);
+
+    // The AVC parser skips the 03 bytes.
+    ts::AVCParser parser(data, sizeof(data));
+    uint8_t b = 0xFF;
+    static const uint8_t expected[] = {0x00, 0x00, 0x00, 0x00, 0x01, 0x00, 0x03, 0x00, 0x00, 0x00};
+    for (size_t i = 0; i < sizeof(expected); ++i) {
+        TSUNIT_ASSERT(parser.readBits(b, 8));
+        TSUNIT_EQUAL(expected[i], b);
+    }
+    TSUNIT_ASSERT(parser.endOfStream());
+}
+
+void StartCodeScannerTest::testLargePayload()
+{
+    // Typical video PES packet, about 60 kB, 30 NAL units.
+    ts::ByteBlock data;
+    BuildPayload(data, 30, 2000, 12345);
+
+    ts::StartCodeScanner scanner;
+    ts::StartCodeScanner::UnitVector units;
+    ts::StartCodeScanner::UnitVector ref;
+
+    ReferenceNALUnits(data.data(), data.size(), ref);
+    TSUNIT_ASSERT(!ref.empty());
+
+    // The same scanner is reused on the same payload.
+    for (size_t i = 0; i < 2; ++i) {
+        scanner.scan(data.data(), data.size());
+        scanner.getNALUnits(units);
+        TSUNIT_ASSERT(SameUnits(ref, units));
+    }
+}
@@ -32,9 +32,11 @@
 //----------------------------------------------------------------------------
 
 #include "tsTSFile.h"
+#include "tsTSFileInputBuffered.h"
 #include "tsTSPacket.h"
 #include "tsTSPacketMetadata.h"
 #include "tsCerrReport.h"
+#include "tsNullReport.h"
 #include "tsSysUtils.h"
 #include "tsunit.h"
 TSDUCK_SOURCE;
@@ -55,11 +57,13 @@ public:
     void testTS();
     void testM2TS();
     void testDuck();
+    void testBufferedSeek();
 
     TSUNIT_TEST_BEGIN(TSFileTest);
     TSUNIT_TEST(testTS);
     TSUNIT_TEST(testM2TS);
     TSUNIT_TEST(testDuck);
+    TSUNIT_TEST(testBufferedSeek);
     TSUNIT_TEST_END();
 
 private:
@@ -272,3 +276,44 @@ void TSFileTest::testDuck()
     TSUNIT_EQUAL(0, file.readPackets(&packet, &mdata, 1, CERR));
     TSUNIT_ASSERT(file.close(CERR));
 }
+
+void TSFileTest::testBufferedSeek()
+{
+    ts::TSFile file;
+    ts::TSPacketVector packets(100);
+
+    TSUNIT_ASSERT(file.open(_tempFileName, ts::TSFile::WRITE, CERR));
+    for (size_t i = 0; i < packets.size(); ++i) {
+        packets[i] = ts::NullPacket;
+        packets[i].setPID(ts::PID(100 + i));
+    }
+    TSUNIT_ASSERT(file.writePackets(packets.data(), nullptr, packets.size(), CERR));
+    TSUNIT_ASSERT(file.close(CERR));
+
+    ts::TSFileInputBuffered input(16);
+    ts::TSPacketVector inpackets(20);
+    TSUNIT_ASSERT(input.openRead(_tempFileName, 1, 0, CERR));
+
+    // Read part of the buffer, move back and read again across the valid content of the buffer.
+    TSUNIT_EQUAL(10, input.read(&inpackets[0], 10, CERR));
+    TSUNIT_EQUAL(109, inpackets[9].getPID());
+    TSUNIT_ASSERT(input.seekBackward(4, CERR));
+    TSUNIT_EQUAL(6, input.readPacketsCount());
+    TSUNIT_EQUAL(8, input.read(&inpackets[0], 8, CERR));
+    for (size_t i = 0; i < 8; ++i) {
+        TSUNIT_EQUAL(106 + i, inpackets[i].getPID());
+    }
+    TSUNIT_EQUAL(14, input.readPacketsCount());
+
+    // Same thing after the buffer wrapped around.
+    TSUNIT_EQUAL(20, input.read(&inpackets[0], 20, CERR));
+    TSUNIT_EQUAL(133, inpackets[19].getPID());
+    TSUNIT_ASSERT(input.seekBackward(16, CERR));
+    TSUNIT_ASSERT(!input.seekBackward(1, NULLREP));
+    TSUNIT_EQUAL(20, input.read(&inpackets[0], 20, CERR));
+    for (size_t i = 0; i < 20; ++i) {
+        TSUNIT_EQUAL(118 + i, inpackets[i].getPID());
+    }
+    TSUNIT_EQUAL(38, input.readPacketsCount());
+    TSUNIT_ASSERT(input.close(CERR));
+}
@@ -0,0 +1,377 @@
+//----------------------------------------------------------------------------
+//
+// TSDuck - The MPEG Transport Stream Toolkit
+// Copyright (c) 2005-2020, Thierry Lelegard
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+// THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------
+//
+//  TSUnit test suite for class ts::TSFileSeekIndex.
+//
+//----------------------------------------------------------------------------
+
+#include "tsTSFileSeekIndex.h"
+#include "tsTSFile.h"
+#include "tsTSProcessor.h"
+#include "tsPluginRepository.h"
+#include "tsSysUtils.h"
+#include "tsNullReport.h"
+#include "tsunit.h"
+TSDUCK_SOURCE;
+
+
+//----------------------------------------------------------------------------
+// The test fixture
+//----------------------------------------------------------------------------
+
+class TSFileSeekIndexTest: public tsunit::Test
+{
+public:
+    TSFileSeekIndexTest();
+
+    virtual void beforeTest() override;
+    virtual void afterTest() override;
+
+    void testSeek();
+    void testSaveLoad();
+    void testNoPCR();
+    void testFilePlugin();
+
+    TSUNIT_TEST_BEGIN(TSFileSeekIndexTest);
+    TSUNIT_TEST(testSeek);
+    TSUNIT_TEST(testSaveLoad);
+    TSUNIT_TEST(testNoPCR);
+    TSUNIT_TEST(testFilePlugin);
+    TSUNIT_TEST_END();
+
+private:
+    // A PCR in the test file, as found by a full sequential read.
+    struct PCRRef
+    {
+        ts::PacketCounter packet;
+        uint64_t time;
+    };
+
+    ts::UString _tempFileNameTS;
+    ts::UString _tempFileNameIdx;
+
+    // Build a 3-hour file and return the reference PCR's, as found by a full sequential read.
+    void buildFile(std::vector<PCRRef>& pcrs);
+
+    // Expected result of a seek: first reference PCR at or after a time.
+    static ts::PacketCounter Expected(const std::vector<PCRRef>& pcrs, uint64_t time);
+
+    // Run the file input plugin with options, return the first input packet.
+    void runFilePlugin(const ts::UStringVector& options, ts::TSPacket& first);
+};
+
+TSUNIT_REGISTER(TSFileSeekIndexTest);
+
+
+//----------------------------------------------------------------------------
+// Initialization.
+//----------------------------------------------------------------------------
+
+// Constructor.
+TSFileSeekIndexTest::TSFileSeekIndexTest() :
+    _tempFileNameTS(),
+    _tempFileNameIdx()
+{
+}
+
+// Test suite initialization method.
+void TSFileSeekIndexTest::beforeTest()
+{
+    if (_tempFileNameTS.empty() || _tempFileNameIdx.empty()) {
+        _tempFileNameTS = ts::TempFile(u".tmp.ts");
+        _tempFileNameIdx = ts::TSFileSeekIndex::DefaultFileName(_tempFileNameTS);
+    }
+    ts::DeleteFile(_tempFileNameTS);
+    ts::DeleteFile(_tempFileNameIdx);
+}
+
+// Test suite cleanup method.
+void TSFileSeekIndexTest::afterTest()
+{
+    ts::DeleteFile(_tempFileNameTS);
+    ts::DeleteFile(_tempFileNameIdx);
+}
+
+
+//----------------------------------------------------------------------------
+// Build a test file: 3 hours, one PCR every 250 ms with some jitter on PID 100.
+// The PCR wraps up after 30 minutes. Each period contains a few packets without
+// PCR and one packet with an unrelated PCR on PID 200. The file starts with
+// packets without PCR.
+//----------------------------------------------------------------------------
+
+#define PERIOD_MS    250
+#define PERIOD_COUNT (3 * 3600 * (1000 / PERIOD_MS))
+#define PCR_PER_MS   (ts::SYSTEM_CLOCK_FREQ / ts::MilliSecPerSec)
+
+void TSFileSeekIndexTest::buildFile(std::vector<PCRRef>& pcrs)
+{
+    pcrs.clear();
+
+    ts::TSFile file;
+    TSUNIT_ASSERT(file.open(_tempFileNameTS, ts::TSFile::WRITE, NULLREP, ts::TSPacketFormat::TS));
+
+    std::vector<ts::TSPacket> pkts;
+    ts::PacketCounter index = 0;
+    const uint64_t first = ts::PCR_SCALE - 30 * 60 * 1000 * PCR_PER_MS;
+
+    for (int i = 0; i < 10; ++i) {
+        pkts.push_back(ts::NullPacket);
+    }
+    for (uint64_t period = 0; period < PERIOD_COUNT; ++period) {
+        const uint64_t time = period * PERIOD_MS * PCR_PER_MS + (period % 7) * 1000;
+
+        pkts.push_back(ts::NullPacket);
+        pkts.back().init(100, uint8_t(period));
+        pkts.back().setPCR((first + time) % ts::PCR_SCALE, true);
+        pcrs.push_back({index + pkts.size() - 1, time});
+
+        pkts.push_back(ts::NullPacket);
+        pkts.back().init(200, uint8_t(period));
+        pkts.back().setPCR((period * 12345) % ts::PCR_SCALE, true);
+
+        for (uint64_t i = 0; i < period % 5; ++i) {
+            pkts.push_back(ts::NullPacket);
+        }
+
+        if (pkts.size() > 10000) {
+            TSUNIT_ASSERT(file.writePackets(&pkts[0], nullptr, pkts.size(), NULLREP));
+            index += pkts.size();
+            pkts.clear();
+        }
+    }
+    TSUNIT_ASSERT(file.writePackets(&pkts[0], nullptr, pkts.size(), NULLREP));
+    TSUNIT_ASSERT(file.close(NULLREP));
+}
+
+ts::PacketCounter TSFileSeekIndexTest::Expected(const std::vector<PCRRef>& pcrs, uint64_t time)
+{
+    for (auto it = pcrs.begin(); it != pcrs.end(); ++it) {
+        if (it->time >= time) {
+            return it->packet;
+        }
+    }
+    return ts::PacketCounter(-1);
+}
+
+
+//----------------------------------------------------------------------------
+// Test cases
+//----------------------------------------------------------------------------
+
+void TSFileSeekIndexTest::testSeek()
+{
+    std::vector<PCRRef> pcrs;
+    buildFile(pcrs);
+    TSUNIT_EQUAL(PERIOD_COUNT, pcrs.size());
+
+    ts::TSFile file;
+    TSUNIT_ASSERT(file.open(_tempFileNameTS, ts::TSFile::READ, NULLREP));
+
+    // Try a small interval and the default one.
+    const ts::PacketCounter intervals[] = {1000, ts::TSFileSeekIndex::DEFAULT_INTERVAL};
+    for (size_t n = 0; n < 2; ++n) {
+        ts::TSFileSeekIndex index(intervals[n]);
+        TSUNIT_ASSERT(index.build(file, NULLREP));
+        TSUNIT_EQUAL(100, index.pcrPID());
+        TSUNIT_ASSERT(index.size() > 1);
+        TSUNIT_EQUAL(10, index.entry(0).packet);
+        TSUNIT_EQUAL(0, index.entry(0).time);
+
+        const uint64_t last = pcrs.back().time;
+        const uint64_t times[] = {
+            0, 1, PCR_PER_MS * 1000, pcrs[1000].time, pcrs[1000].time + 1, pcrs[1000].time - 1,
+            3600 * 1000 * PCR_PER_MS, (2 * 3600 + 17) * 1000 * PCR_PER_MS + 17 * PCR_PER_MS,
+            30 * 60 * 1000 * PCR_PER_MS,  // around PCR wrap
+            index.entry(index.size() - 1).time, index.entry(index.size() / 2).time + 1,
+            last - 1, last
+        };
+        for (size_t i = 0; i < sizeof(times) / sizeof(times[0]); ++i) {
+            ts::PacketCounter packet = 0;
+            TSUNIT_ASSERT(index.findPacket(file, times[i], packet, NULLREP));
+            TSUNIT_EQUAL(Expected(pcrs, times[i]), packet);
+
+            // Check that the packet at the returned position is the expected one.
+            ts::TSPacket pkt;
+            TSUNIT_ASSERT(file.seek(packet, NULLREP));
+            TSUNIT_EQUAL(1, file.readPackets(&pkt, nullptr, 1, NULLREP));
+            TSUNIT_EQUAL(100, pkt.getPID());
+            TSUNIT_ASSERT(pkt.hasPCR());
+        }
+
+        // After the last PCR.
+        ts::PacketCounter packet = 0;
+        TSUNIT_ASSERT(!index.findPacket(file, last + 1, packet, NULLREP));
+    }
+    TSUNIT_ASSERT(file.close(NULLREP));
+}
+
+void TSFileSeekIndexTest::testSaveLoad()
+{
+    std::vector<PCRRef> pcrs;
+    buildFile(pcrs);
+
+    ts::TSFile file;
+    TSUNIT_ASSERT(file.open(_tempFileNameTS, ts::TSFile::READ, NULLREP));
+
+    ts::TSFileSeekIndex index1;
+    TSUNIT_ASSERT(index1.build(file, NULLREP));
+    TSUNIT_ASSERT(index1.save(_tempFileNameIdx, NULLREP));
+
+    ts::TSFileSeekIndex index2;
+    TSUNIT_ASSERT(index2.load(_tempFileNameIdx, file, NULLREP));
+    TSUNIT_EQUAL(index1.size(), index2.size());
+    TSUNIT_EQUAL(index1.pcrPID(), index2.pcrPID());
+    for (size_t i = 0; i < index1.size(); ++i) {
+        TSUNIT_EQUAL(index1.entry(i).packet, index2.entry(i).packet);
+        TSUNIT_EQUAL(index1.entry(i).pcr, index2.entry(i).pcr);
+        TSUNIT_EQUAL(index1.entry(i).time, index2.entry(i).time);
+    }
+
+    const uint64_t time = 5000 * 1000 * PCR_PER_MS + 3;
+    ts::PacketCounter packet = 0;
+    TSUNIT_ASSERT(index2.findPacket(file, time, packet, NULLREP));
+    TSUNIT_EQUAL(Expected(pcrs, time), packet);
+    TSUNIT_ASSERT(file.close(NULLREP));
+
+    // Modify the file, the index is now obsolete.
+    TSUNIT_ASSERT(file.open(_tempFileNameTS, ts::TSFile::APPEND, NULLREP, ts::TSPacketFormat::TS));
+    TSUNIT_ASSERT(file.writePackets(&ts::NullPacket, nullptr, 1, NULLREP));
+    TSUNIT_ASSERT(file.close(NULLREP));
+    TSUNIT_ASSERT(file.open(_tempFileNameTS, ts::TSFile::READ, NULLREP));
+    TSUNIT_ASSERT(!index2.load(_tempFileNameIdx, file, NULLREP));
+    TSUNIT_ASSERT(!index2.isValid());
+    TSUNIT_ASSERT(file.close(NULLREP));
+}
+
+void TSFileSeekIndexTest::testNoPCR()
+{
+    ts::TSFile file;
+    TSUNIT_ASSERT(file.open(_tempFileNameTS, ts::TSFile::WRITE, NULLREP, ts::TSPacketFormat::TS));
+    for (int i = 0; i < 100; ++i) {
+        TSUNIT_ASSERT(file.writePackets(&ts::NullPacket, nullptr, 1, NULLREP));
+    }
+    TSUNIT_ASSERT(file.close(NULLREP));
+
+    ts::TSFileSeekIndex index(10);
+    TSUNIT_ASSERT(file.open(_tempFileNameTS, ts::TSFile::READ, NULLREP));
+    TSUNIT_ASSERT(!index.build(file, NULLREP));
+    TSUNIT_ASSERT(!index.isValid());
+    ts::PacketCounter packet = 0;
+    TSUNIT_ASSERT(!index.findPacket(file, 0, packet, NULLREP));
+    TSUNIT_ASSERT(file.close(NULLREP));
+}
+
+//----------------------------------------------------------------------------
+// Capture the first packet from the file input plugin.
+//----------------------------------------------------------------------------
+
+namespace {
+    class FirstPacketPlugin : public ts::ProcessorPlugin
+    {
+        TS_NOBUILD_NOCOPY(FirstPacketPlugin);
+    public:
+        FirstPacketPlugin(ts::TSP* t) : ts::ProcessorPlugin(t, u"Test first packet", u"") {}
+        static ts::ProcessorPlugin* CreateInstance(ts::TSP* t) { return new FirstPacketPlugin(t); }
+        virtual Status processPacket(ts::TSPacket&, ts::TSPacketMetadata&) override;
+
+        static ts::TSPacket first;
+        static size_t count;
+    };
+
+    ts::TSPacket FirstPacketPlugin::first;
+    size_t FirstPacketPlugin::count = 0;
+
+    FirstPacketPlugin::Status FirstPacketPlugin::processPacket(ts::TSPacket& pkt, ts::TSPacketMetadata&)
+    {
+        if (count++ == 0) {
+            first = pkt;
+        }
+        return TSP_END;
+    }
+}
+
+void TSFileSeekIndexTest::runFilePlugin(const ts::UStringVector& options, ts::TSPacket& first)
+{
+    ts::PluginRepository::Instance()->registerProcessor(u"utest_first", FirstPacketPlugin::CreateInstance);
+    FirstPacketPlugin::count = 0;
+
+    ts::TSProcessorArgs opt;
+    opt.app_name = u"TSFileSeekIndexTest";
+    ts::UStringVector args(options);
+    args.push_back(_tempFileNameTS);
+    opt.input = {u"file", args};
+    opt.plugins = {{u"utest_first", {}}};
+    opt.output = {u"drop"};
+
+    ts::TSProcessor tsproc(NULLREP);
+    TSUNIT_ASSERT(tsproc.start(opt));
+    tsproc.waitForTermination();
+    TSUNIT_ASSERT(FirstPacketPlugin::count > 0);
+    first = FirstPacketPlugin::first;
+}
+
+void TSFileSeekIndexTest::testFilePlugin()
+{
+    std::vector<PCRRef> pcrs;
+    buildFile(pcrs);
+    const ts::MilliSecond start = (2 * 3600 + 17) * 1000 + 17;
+    const ts::PacketCounter expected = Expected(pcrs, uint64_t(start) * PCR_PER_MS);
+
+    // The packet at the expected position, its PCR is unique in the file.
+    ts::TSFile file;
+    ts::TSPacket ref;
+    TSUNIT_ASSERT(file.open(_tempFileNameTS, ts::TSFile::READ, NULLREP));
+    TSUNIT_ASSERT(file.seek(expected, NULLREP));
+    TSUNIT_EQUAL(1, file.readPackets(&ref, nullptr, 1, NULLREP));
+    TSUNIT_ASSERT(file.close(NULLREP));
+    TSUNIT_ASSERT(ref.hasPCR());
+
+    const ts::UString start_string(ts::UString::Decimal(start, 0, true, ts::UString()));
+    ts::TSPacket pkt;
+
+    // Index in memory only.
+    runFilePlugin({u"--start-time", start_string}, pkt);
+    TSUNIT_ASSERT(pkt == ref);
+    TSUNIT_ASSERT(!ts::FileExists(_tempFileNameIdx));
+
+    // The index file is created, then reused.
+    runFilePlugin({u"--start-time", start_string, u"--seek-index"}, pkt);
+    TSUNIT_ASSERT(pkt == ref);
+    TSUNIT_ASSERT(ts::FileExists(_tempFileNameIdx));
+    runFilePlugin({u"--start-time", start_string, u"--seek-index"}, pkt);
+    TSUNIT_ASSERT(pkt == ref);
+
+    // The index file cannot be written, a directory has the same name. The index in memory is used.
+    TSUNIT_EQUAL(ts::SYS_SUCCESS, ts::DeleteFile(_tempFileNameIdx));
+    TSUNIT_EQUAL(ts::SYS_SUCCESS, ts::CreateDirectory(_tempFileNameIdx));
+    runFilePlugin({u"--start-time", start_string, u"--seek-index"}, pkt);
+    TSUNIT_ASSERT(pkt == ref);
+    TSUNIT_ASSERT(ts::IsDirectory(_tempFileNameIdx));
+}
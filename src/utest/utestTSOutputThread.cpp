@@ -0,0 +1,184 @@
+//----------------------------------------------------------------------------
+//
+// TSDuck - The MPEG Transport Stream Toolkit
+// Copyright (c) 2005-2020, Thierry Lelegard
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+// THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------
+//
+//  TSUnit test suite for class ts::TSOutputThread.
+//
+//----------------------------------------------------------------------------
+
+#include "tsTSOutputThread.h"
+#include "tsTSPacketQueue.h"
+#include "tsTSFile.h"
+#include "tsCerrReport.h"
+#include "tsSysUtils.h"
+#include "tsunit.h"
+TSDUCK_SOURCE;
+
+
+//----------------------------------------------------------------------------
+// The test fixture
+//----------------------------------------------------------------------------
+
+class TSOutputThreadTest: public tsunit::Test
+{
+public:
+    TSOutputThreadTest();
+
+    virtual void beforeTest() override;
+    virtual void afterTest() override;
+
+    void testPutPackets();
+    void testFile();
+
+    TSUNIT_TEST_BEGIN(TSOutputThreadTest);
+    TSUNIT_TEST(testPutPackets);
+    TSUNIT_TEST(testFile);
+    TSUNIT_TEST_END();
+
+private:
+    ts::UString _tempFileName;
+};
+
+TSUNIT_REGISTER(TSOutputThreadTest);
+
+
+//----------------------------------------------------------------------------
+// Initialization.
+//----------------------------------------------------------------------------
+
+// Constructor.
+TSOutputThreadTest::TSOutputThreadTest() :
+    _tempFileName()
+{
+}
+
+// Test suite initialization method.
+void TSOutputThreadTest::beforeTest()
+{
+    if (_tempFileName.empty()) {
+        _tempFileName = ts::TempFile(u".ts");
+    }
+    ts::DeleteFile(_tempFileName);
+}
+
+// Test suite cleanup method.
+void TSOutputThreadTest::afterTest()
+{
+    ts::DeleteFile(_tempFileName);
+}
+
+
+//----------------------------------------------------------------------------
+// Unitary tests.
+//----------------------------------------------------------------------------
+
+namespace {
+    // Build a vector of null packets with distinct PID's.
+    void BuildPackets(ts::TSPacketVector& packets, ts::PID first_pid)
+    {
+        for (size_t i = 0; i < packets.size(); ++i) {
+            packets[i] = ts::NullPacket;
+            packets[i].setPID(ts::PID(first_pid + i));
+        }
+    }
+}
+
+void TSOutputThreadTest::testPutPackets()
+{
+    ts::TSPacketQueue queue(10);
+    ts::TSPacketVector packets(10);
+    ts::TSPacket pkt;
+    ts::BitRate bitrate = 0;
+    BuildPackets(packets, 100);
+
+    // Partial enqueue when the buffer is full, never blocks.
+    TSUNIT_EQUAL(7, queue.putPackets(packets.data(), 7));
+    TSUNIT_EQUAL(3, queue.putPackets(packets.data() + 7, 3));
+    TSUNIT_EQUAL(0, queue.putPackets(packets.data(), 5));
+
+    // Free 5 packets, then enqueue over the end of the circular buffer.
+    for (ts::PID pid = 100; pid < 105; ++pid) {
+        TSUNIT_ASSERT(queue.getPacket(pkt, bitrate));
+        TSUNIT_EQUAL(pid, pkt.getPID());
+    }
+    BuildPackets(packets, 200);
+    TSUNIT_EQUAL(5, queue.putPackets(packets.data(), 8));
+
+    // Check the order of all packets.
+    for (ts::PID pid = 105; pid < 110; ++pid) {
+        TSUNIT_ASSERT(queue.getPacket(pkt, bitrate));
+        TSUNIT_EQUAL(pid, pkt.getPID());
+    }
+    for (ts::PID pid = 200; pid < 205; ++pid) {
+        TSUNIT_ASSERT(queue.getPacket(pkt, bitrate));
+        TSUNIT_EQUAL(pid, pkt.getPID());
+    }
+    TSUNIT_ASSERT(!queue.getPacket(pkt, bitrate));
+
+    // Nothing is enqueued after a stop from the reader.
+    queue.stop();
+    TSUNIT_EQUAL(0, queue.putPackets(packets.data(), 1));
+}
+
+void TSOutputThreadTest::testFile()
+{
+    ts::TSOutputThread out(50);
+    ts::TSPacketVector packets(20);
+    ts::PacketCounter written = 0;
+
+    TSUNIT_ASSERT(!out.isOpen());
+    TSUNIT_ASSERT(!out.write(packets.data(), packets.size()));
+    TSUNIT_ASSERT(out.openFile(_tempFileName, ts::TSFile::WRITE, CERR));
+    TSUNIT_ASSERT(out.isOpen());
+
+    // Write without blocking, some packets may be dropped if the output thread is late.
+    for (size_t i = 0; i < 100; ++i) {
+        BuildPackets(packets, ts::PID(20 * i));
+        TSUNIT_ASSERT(out.write(packets.data(), packets.size()));
+    }
+    written = out.packetCount();
+    TSUNIT_EQUAL(2000, written + out.overflowCount());
+    TSUNIT_ASSERT(written >= 50);
+
+    TSUNIT_ASSERT(out.close(CERR));
+    TSUNIT_ASSERT(!out.isOpen());
+    TSUNIT_EQUAL(written * ts::PKT_SIZE, ts::GetFileSize(_tempFileName));
+    debug() << "TSOutputThreadTest::testFile: written: " << written << ", dropped: " << out.overflowCount() << std::endl;
+
+    // All written packets are in order.
+    ts::TSFile file;
+    ts::TSPacket pkt;
+    ts::PID previous = 0;
+    TSUNIT_ASSERT(file.openRead(_tempFileName, 0, CERR));
+    for (ts::PacketCounter i = 0; i < written; ++i) {
+        TSUNIT_EQUAL(1, file.readPackets(&pkt, nullptr, 1, CERR));
+        TSUNIT_ASSERT(i == 0 || pkt.getPID() > previous);
+        previous = pkt.getPID();
+    }
+    TSUNIT_ASSERT(file.close(CERR));
+}
@@ -55,6 +55,10 @@ public:
     void testSetPayloadSize();
     void testFlags();
     void testPrivateData();
+    void testExtractHeaders();
+    void testExtractHeadersReuse();
+    void testClassify();
+    void testClassifyReuse();
 
     TSUNIT_TEST_BEGIN(TSPacketTest);
     TSUNIT_TEST(testPacket);
@@ -64,6 +68,10 @@ public:
     TSUNIT_TEST(testSetPayloadSize);
     TSUNIT_TEST(testFlags);
     TSUNIT_TEST(testPrivateData);
+    TSUNIT_TEST(testExtractHeaders);
+    TSUNIT_TEST(testExtractHeadersReuse);
+    TSUNIT_TEST(testClassify);
+    TSUNIT_TEST(testClassifyReuse);
     TSUNIT_TEST_END();
 };
 
@@ -495,3 +503,193 @@ void TSPacketTest::testPrivateData()
     pkt.getPrivateData(data);
     TSUNIT_ASSERT(data.empty());
 }
+
+namespace {
+    // Build a set of packets with various header fields.
+    void BuildPackets(ts::TSPacketVector& packets, size_t count)
+    {
+        packets.resize(count);
+        for (size_t i = 0; i < count; ++i) {
+            ts::TSPacket& pkt(packets[i]);
+            pkt.init(ts::PID((i * 0x0123) & 0x1FFF), uint8_t(i & 0x0F), uint8_t(i));
+            pkt.setTEI(i % 7 == 0);
+            pkt.setPUSI(i % 3 == 0);
+            pkt.setPriority(i % 5 == 0);
+            pkt.setScrambling(uint8_t(i % 4));
+            if (i % 4 == 1) {
+                pkt.b[3] |= 0x20; // adaptation field
+            }
+            if (i % 6 == 2) {
+                pkt.b[3] &= ~0x10; // no payload
+            }
+        }
+    }
+}
+
+void TSPacketTest::testExtractHeaders()
+{
+    // Test various sizes around the vectorized width, with bad sync bytes.
+    for (size_t count = 0; count < 40; ++count) {
+        ts::TSPacketVector packets;
+        BuildPackets(packets, count);
+        for (size_t i = 5; i < count; i += 11) {
+            packets[i].b[0] = 0x48;
+        }
+
+        ts::TSPacketHeaders headers;
+        ts::TSPacket::ExtractHeaders(packets.data(), count, headers);
+        TSUNIT_EQUAL(count, headers.size());
+        TSUNIT_EQUAL(count, headers.cc.size());
+        TSUNIT_EQUAL(count, headers.flags.size());
+
+        for (size_t i = 0; i < count; ++i) {
+            const ts::TSPacket& pkt(packets[i]);
+            TSUNIT_EQUAL(pkt.getPID(), headers.pid[i]);
+            TSUNIT_EQUAL(pkt.getCC(), headers.cc[i]);
+            TSUNIT_EQUAL(pkt.hasValidSync(), headers.hasValidSync(i));
+            TSUNIT_EQUAL(pkt.getTEI(), headers.getTEI(i));
+            TSUNIT_EQUAL(pkt.getPUSI(), headers.getPUSI(i));
+            TSUNIT_EQUAL(pkt.getPriority(), headers.getPriority(i));
+            TSUNIT_EQUAL(pkt.getScrambling(), headers.getScrambling(i));
+            TSUNIT_EQUAL(pkt.hasAF(), headers.hasAF(i));
+            TSUNIT_EQUAL(pkt.hasPayload(), headers.hasPayload(i));
+        }
+    }
+}
+
+void TSPacketTest::testExtractHeadersReuse()
+{
+    // The same headers structure is reused with decreasing numbers of packets.
+    constexpr size_t count = 100000;
+    ts::TSPacketVector packets;
+    BuildPackets(packets, count);
+
+    ts::TSPacketHeaders headers;
+    for (size_t size = count; size > 0; size /= 10) {
+        const ts::TSPacket* first = packets.data() + (count - size);
+        uint64_t sum1 = 0;
+        for (size_t i = 0; i < size; ++i) {
+            sum1 += first[i].getPID() + first[i].getCC() + first[i].getPUSI() + first[i].hasPayload();
+        }
+        uint64_t sum2 = 0;
+        ts::TSPacket::ExtractHeaders(first, size, headers);
+        TSUNIT_EQUAL(size, headers.size());
+        for (size_t i = 0; i < size; ++i) {
+            sum2 += headers.pid[i] + headers.cc[i] + headers.getPUSI(i) + headers.hasPayload(i);
+        }
+        TSUNIT_EQUAL(sum1, sum2);
+    }
+}
+
+namespace {
+    // Build a set of packets with null packets, stuffing payloads and adaptation fields of all sizes.
+    void BuildStuffingPackets(ts::TSPacketVector& packets, size_t count)
+    {
+        packets.resize(count);
+        for (size_t i = 0; i < count; ++i) {
+            ts::TSPacket& pkt(packets[i]);
+            if (i % 5 == 0) {
+                pkt = ts::NullPacket;
+                continue;
+            }
+            pkt.init(ts::PID(100 + i % 3), uint8_t(i & 0x0F), 0xFF);
+            if (i % 3 != 0) {
+                // Adaptation field of variable size, the payload can be shorter than one vector.
+                pkt.b[3] |= 0x20;
+                pkt.b[4] = uint8_t(i % 184);
+                pkt.b[5] = 0x00;
+            }
+            if (i % 11 == 4) {
+                pkt.b[3] &= ~0x10; // no payload
+            }
+            if (i % 4 == 3) {
+                // One non-stuffing byte, somewhere in the packet.
+                pkt.b[ts::PKT_SIZE - 1 - (i * 7) % 100] = 0x12;
+            }
+        }
+    }
+
+    // Reference stuffing detection, using the per-packet accessors.
+    bool IsStuffing(const ts::TSPacket& pkt)
+    {
+        const uint8_t* const pl = pkt.getPayload();
+        const size_t size = pkt.hasPayload() ? pkt.getPayloadSize() : 0;
+        for (size_t i = 0; i < size; ++i) {
+            if (pl[i] != 0xFF) {
+                return false;
+            }
+        }
+        return size > 0;
+    }
+}
+
+void TSPacketTest::testClassify()
+{
+    // Test various sizes around the bitmap word size.
+    for (size_t count = 0; count < 400; count += 13) {
+        ts::TSPacketVector packets;
+        BuildStuffingPackets(packets, count);
+
+        ts::TSPacketClasses classes;
+        ts::TSPacket::Classify(packets.data(), count, classes);
+        TSUNIT_EQUAL(count, classes.size());
+        TSUNIT_EQUAL((count + 63) / 64, classes.null_pid.size());
+
+        size_t null_count = 0;
+        size_t stuffing_count = 0;
+        size_t af_only_count = 0;
+        for (size_t i = 0; i < count; ++i) {
+            const ts::TSPacket& pkt(packets[i]);
+            const bool null_pid = pkt.getPID() == ts::PID_NULL;
+            const bool stuffing = IsStuffing(pkt);
+            const bool af_only = pkt.hasAF() && !pkt.hasPayload();
+            TSUNIT_EQUAL(null_pid, classes.isNull(i));
+            TSUNIT_EQUAL(stuffing, classes.isStuffing(i));
+            TSUNIT_EQUAL(af_only, classes.isAFOnly(i));
+            null_count += null_pid;
+            stuffing_count += stuffing;
+            af_only_count += af_only;
+        }
+        TSUNIT_EQUAL(null_count, ts::TSPacketClasses::Count(classes.null_pid));
+        TSUNIT_EQUAL(stuffing_count, ts::TSPacketClasses::Count(classes.stuffing));
+        TSUNIT_EQUAL(af_only_count, ts::TSPacketClasses::Count(classes.af_only));
+    }
+
+    // Null packets at end of window, across bitmap words.
+    ts::TSPacketVector packets(200, ts::NullPacket);
+    packets[10].setPID(100);
+    ts::TSPacketClasses classes;
+    ts::TSPacket::Classify(packets.data(), packets.size(), classes);
+    TSUNIT_EQUAL(189, classes.countTail(classes.null_pid));
+    TSUNIT_EQUAL(199, ts::TSPacketClasses::Count(classes.null_pid));
+    TSUNIT_EQUAL(200, classes.countTail(classes.stuffing));
+    TSUNIT_EQUAL(0, classes.countTail(classes.af_only));
+
+    ts::TSPacket::Classify(packets.data() + 11, 128, classes);
+    TSUNIT_EQUAL(128, classes.countTail(classes.null_pid));
+
+    ts::TSPacket::Classify(packets.data(), 0, classes);
+    TSUNIT_EQUAL(0, classes.countTail(classes.null_pid));
+}
+
+void TSPacketTest::testClassifyReuse()
+{
+    // The same classes structure is reused with decreasing numbers of packets.
+    constexpr size_t count = 100000;
+    ts::TSPacketVector packets;
+    BuildStuffingPackets(packets, count);
+
+    ts::TSPacketClasses classes;
+    for (size_t size = count; size > 0; size /= 10) {
+        const ts::TSPacket* first = packets.data() + (count - size);
+        size_t null_count = 0;
+        size_t stuffing_count = 0;
+        for (size_t i = 0; i < size; ++i) {
+            null_count += first[i].getPID() == ts::PID_NULL;
+            stuffing_count += IsStuffing(first[i]);
+        }
+        ts::TSPacket::Classify(first, size, classes);
+        TSUNIT_EQUAL(null_count, ts::TSPacketClasses::Count(classes.null_pid));
+        TSUNIT_EQUAL(stuffing_count, ts::TSPacketClasses::Count(classes.stuffing));
+    }
+}
@@ -0,0 +1,265 @@
+//----------------------------------------------------------------------------
+//
+// TSDuck - The MPEG Transport Stream Toolkit
+// Copyright (c) 2005-2020, Thierry Lelegard
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+// THE POSSIBILITY OF SUCH DAMAGE.
+//
+//----------------------------------------------------------------------------
+//
+//  TSUnit test suite for class ts::TSPacketDeduplicator.
+//
+//----------------------------------------------------------------------------
+
+#include "tsTSPacketDeduplicator.h"
+#include "tsunit.h"
+TSDUCK_SOURCE;
+
+
+//----------------------------------------------------------------------------
+// The test fixture
+//----------------------------------------------------------------------------
+
+class TSPacketDeduplicatorTest: public tsunit::Test
+{
+public:
+    virtual void beforeTest() override;
+    virtual void afterTest() override;
+
+    void testFingerprint();
+    void testWindow();
+    void testRedundantInputs();
+    void testReferenceModel();
+    void testIdenticalInputs();
+
+    TSUNIT_TEST_BEGIN(TSPacketDeduplicatorTest);
+    TSUNIT_TEST(testFingerprint);
+    TSUNIT_TEST(testWindow);
+    TSUNIT_TEST(testRedundantInputs);
+    TSUNIT_TEST(testReferenceModel);
+    TSUNIT_TEST(testIdenticalInputs);
+    TSUNIT_TEST_END();
+
+private:
+    // Build a distinct packet for a sequence number.
+    static ts::TSPacket MakePacket(uint32_t seq);
+};
+
+TSUNIT_REGISTER(TSPacketDeduplicatorTest);
+
+
+//----------------------------------------------------------------------------
+// Initialization.
+//----------------------------------------------------------------------------
+
+// Test suite initialization method.
+void TSPacketDeduplicatorTest::beforeTest()
+{
+}
+
+// Test suite cleanup method.
+void TSPacketDeduplicatorTest::afterTest()
+{
+}
+
+// Build a distinct packet for a sequence number.
+ts::TSPacket TSPacketDeduplicatorTest::MakePacket(uint32_t seq)
+{
+    ts::TSPacket pkt;
+    pkt.init(ts::PID(100 + seq % 20), uint8_t(seq % 16));
+    ts::PutUInt32(pkt.b + 4, seq);
+    return pkt;
+}
+
+
+//----------------------------------------------------------------------------
+// Test cases
+//----------------------------------------------------------------------------
+
+void TSPacketDeduplicatorTest::testFingerprint()
+{
+    ts::TSPacket pkt1(MakePacket(12));
+    ts::TSPacket pkt2(MakePacket(12));
+    TSUNIT_EQUAL(ts::TSPacketDeduplicator::Fingerprint(pkt1), ts::TSPacketDeduplicator::Fingerprint(pkt2));
+
+    // Any byte in the packet changes the fingerprint.
+    pkt2.b[ts::PKT_SIZE - 1] ^= 0x01;
+    TSUNIT_ASSERT(ts::TSPacketDeduplicator::Fingerprint(pkt1) != ts::TSPacketDeduplicator::Fingerprint(pkt2));
+    pkt2 = pkt1;
+    pkt2.setCC(3);
+    TSUNIT_ASSERT(ts::TSPacketDeduplicator::Fingerprint(pkt1) != ts::TSPacketDeduplicator::Fingerprint(pkt2));
+
+    // The PCR is ignored in packets with payload, as in TSPacket::isDuplicate().
+    TSUNIT_ASSERT(pkt1.setPCR(1000, true));
+    pkt2 = pkt1;
+    TSUNIT_ASSERT(pkt2.setPCR(2000));
+    TSUNIT_ASSERT(pkt1.isDuplicate(pkt2));
+    TSUNIT_EQUAL(ts::TSPacketDeduplicator::Fingerprint(pkt1), ts::TSPacketDeduplicator::Fingerprint(pkt2));
+
+    // But not in packets without payload.
+    TSUNIT_ASSERT(pkt1.setPayloadSize(0));
+    pkt1.b[3] &= ~0x10;
+    TSUNIT_ASSERT(!pkt1.hasPayload());
+    pkt2 = pkt1;
+    TSUNIT_ASSERT(pkt2.setPCR(3000));
+    TSUNIT_ASSERT(ts::TSPacketDeduplicator::Fingerprint(pkt1) != ts::TSPacketDeduplicator::Fingerprint(pkt2));
+}
+
+void TSPacketDeduplicatorTest::testWindow()
+{
+    ts::TSPacketDeduplicator dedup(10);
+    TSUNIT_EQUAL(10, dedup.window());
+    TSUNIT_EQUAL(1, dedup.inputCount());
+
+    // Null packets are never duplicates.
+    TSUNIT_ASSERT(dedup.feedPacket(ts::NullPacket));
+    TSUNIT_ASSERT(dedup.feedPacket(ts::NullPacket));
+    TSUNIT_EQUAL(0, dedup.size());
+
+    for (uint32_t i = 0; i < 10; ++i) {
+        TSUNIT_ASSERT(dedup.feedPacket(MakePacket(i)));
+    }
+    TSUNIT_EQUAL(10, dedup.size());
+    for (uint32_t i = 0; i < 10; ++i) {
+        TSUNIT_ASSERT(!dedup.feedPacket(MakePacket(i)));
+    }
+
+    // Packet 10 evicts packet 0 from the window.
+    TSUNIT_ASSERT(dedup.feedPacket(MakePacket(10)));
+    TSUNIT_EQUAL(10, dedup.size());
+    TSUNIT_ASSERT(!dedup.feedPacket(MakePacket(1)));
+    TSUNIT_ASSERT(dedup.feedPacket(MakePacket(0)));
+
+    const ts::TSPacketDeduplicator::InputStatistics& stats(dedup.statistics(0));
+    TSUNIT_EQUAL(25, stats.packets);
+    TSUNIT_EQUAL(14, stats.unique);
+    TSUNIT_EQUAL(11, stats.duplicates);
+    TSUNIT_EQUAL(0, stats.lost);
+
+    dedup.flush();
+    TSUNIT_EQUAL(0, dedup.size());
+    TSUNIT_ASSERT(dedup.feedPacket(MakePacket(5)));
+    TSUNIT_EQUAL(0, dedup.statistics(0).lost);
+}
+
+void TSPacketDeduplicatorTest::testRedundantInputs()
+{
+    // Two redundant inputs: input 1 is late by 20 packets and misses packets 50, 150, 250, etc.
+    // Input 0 misses packets 500 to 509.
+    ts::TSPacketDeduplicator dedup(100, 2);
+    std::vector<uint32_t> output;
+
+    for (uint32_t i = 0; i < 1020; ++i) {
+        if (i < 1000 && (i < 500 || i >= 510)) {
+            const ts::TSPacket pkt(MakePacket(i));
+            if (dedup.feedPacket(pkt, 0)) {
+                output.push_back(ts::GetUInt32(pkt.b + 4));
+            }
+        }
+        if (i >= 20 && (i - 20) % 100 != 50) {
+            const ts::TSPacket pkt(MakePacket(i - 20));
+            if (dedup.feedPacket(pkt, 1)) {
+                output.push_back(ts::GetUInt32(pkt.b + 4));
+            }
+        }
+    }
+    dedup.flush();
+
+    // All packets are output exactly once.
+    TSUNIT_EQUAL(1000, output.size());
+    std::sort(output.begin(), output.end());
+    for (uint32_t i = 0; i < output.size(); ++i) {
+        TSUNIT_EQUAL(i, output[i]);
+    }
+
+    const ts::TSPacketDeduplicator::InputStatistics& stats0(dedup.statistics(0));
+    TSUNIT_EQUAL(990, stats0.packets);
+    TSUNIT_EQUAL(990, stats0.unique);
+    TSUNIT_EQUAL(0, stats0.duplicates);
+    TSUNIT_EQUAL(10, stats0.lost);
+
+    const ts::TSPacketDeduplicator::InputStatistics& stats1(dedup.statistics(1));
+    TSUNIT_EQUAL(990, stats1.packets);
+    TSUNIT_EQUAL(10, stats1.unique);
+    TSUNIT_EQUAL(980, stats1.duplicates);
+    TSUNIT_EQUAL(10, stats1.lost);
+}
+
+void TSPacketDeduplicatorTest::testReferenceModel()
+{
+    // Compare with a straightforward model on a long random sequence,
+    // with a window much smaller than the set of distinct packets.
+    const size_t window = 1000;
+    ts::TSPacketDeduplicator dedup(window);
+    std::deque<uint32_t> fifo;
+    std::set<uint32_t> seen;
+    uint32_t rand = 12345;
+    size_t duplicates = 0;
+
+    for (size_t i = 0; i < 200000; ++i) {
+        rand = rand * 1103515245 + 12345;
+        const uint32_t seq = (rand >> 8) % 3000;
+        const bool expected = seen.count(seq) == 0;
+        if (expected) {
+            if (fifo.size() == window) {
+                seen.erase(fifo.front());
+                fifo.pop_front();
+            }
+            fifo.push_back(seq);
+            seen.insert(seq);
+        }
+        else {
+            duplicates++;
+        }
+        if (dedup.feedPacket(MakePacket(seq)) != expected) {
+            TSUNIT_FAIL("unexpected result at packet " + std::to_string(i));
+        }
+    }
+    TSUNIT_EQUAL(window, dedup.size());
+    TSUNIT_EQUAL(duplicates, dedup.statistics(0).duplicates);
+    TSUNIT_ASSERT(duplicates > 0);
+}
+
+void TSPacketDeduplicatorTest::testIdenticalInputs()
+{
+    // Two identical inputs, each packet from the second one is a duplicate.
+    const uint32_t count = 100000;
+    ts::TSPacketDeduplicator dedup(ts::TSPacketDeduplicator::DEFAULT_WINDOW, 2);
+    std::vector<ts::TSPacket> packets(1000);
+    for (uint32_t i = 0; i < packets.size(); ++i) {
+        packets[i] = MakePacket(i);
+    }
+
+    size_t unique = 0;
+    for (uint32_t i = 0; i < count; ++i) {
+        // Change the content of the packets at each round.
+        ts::TSPacket& pkt(packets[i % packets.size()]);
+        ts::PutUInt32(pkt.b + 4, i);
+        unique += dedup.feedPacket(pkt, 0);
+        unique += dedup.feedPacket(pkt, 1);
+    }
+
+    TSUNIT_EQUAL(count, unique);
+    TSUNIT_EQUAL(count, dedup.statistics(1).duplicates);
+    TSUNIT_EQUAL(0, dedup.statistics(0).duplicates);
+}
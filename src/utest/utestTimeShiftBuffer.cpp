@@ -50,11 +50,15 @@ public:
     void testMinimum();
     void testMemory();
     void testFile();
+    void testFileBlocks();
+    void testFileWrap();
 
     TSUNIT_TEST_BEGIN(TimeShiftBufferTest);
     TSUNIT_TEST(testMinimum);
     TSUNIT_TEST(testMemory);
     TSUNIT_TEST(testFile);
+    TSUNIT_TEST(testFileBlocks);
+    TSUNIT_TEST(testFileWrap);
     TSUNIT_TEST_END();
 
 private:
@@ -167,3 +171,54 @@ void TimeShiftBufferTest::testFile()
 {
     testCommon(20, 4);
 }
+
+void TimeShiftBufferTest::testFileBlocks()
+{
+    // File sizes which are not a multiple of the I/O block size.
+    testCommon(37, 16);
+    testCommon(85, 20);
+}
+
+namespace {
+    // Build a distinct packet for each index.
+    ts::TSPacket MakePacket(size_t index)
+    {
+        ts::TSPacket pkt;
+        pkt.init(ts::PID(100 + index % 7), uint8_t(index), uint8_t(index >> 4));
+        ts::PutUInt32(pkt.getPayload(), uint32_t(index));
+        return pkt;
+    }
+}
+
+void TimeShiftBufferTest::testFileWrap()
+{
+    // A few I/O blocks of 16 packets in a file which is not a multiple of the block size.
+    // The file wraps several times, each packet is checked across all block boundaries.
+    const size_t memory = 64;
+    const size_t total = 7 * (memory / 4) + 5;
+    const size_t count = 3 * total + 11;
+
+    ts::TimeShiftBuffer buf(total);
+    TSUNIT_ASSERT(buf.setMemoryPackets(memory));
+    TSUNIT_ASSERT(buf.open(CERR));
+    TSUNIT_ASSERT(!buf.memoryResident());
+
+    ts::TSPacket pkt;
+    ts::TSPacketMetadata mdata;
+
+    for (size_t i = 0; i < count; i++) {
+        pkt = MakePacket(i);
+        mdata.reset();
+        TSUNIT_ASSERT(buf.shift(pkt, mdata, CERR));
+        if (i < total) {
+            TSUNIT_ASSERT(mdata.getInputStuffing());
+            TSUNIT_EQUAL(ts::PID_NULL, pkt.getPID());
+        }
+        else {
+            TSUNIT_ASSERT(!mdata.getInputStuffing());
+            TSUNIT_ASSERT(pkt == MakePacket(i - total));
+        }
+    }
+
+    TSUNIT_ASSERT(buf.close(CERR));
+}
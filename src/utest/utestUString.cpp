@@ -52,6 +52,9 @@ public:
 
     void testIsSpace();
     void testUTF();
+    void testUTFFastPath();
+    void testUTFAppend();
+    void testUTFLargeText();
     void testDiacritical();
     void testSurrogate();
     void testWidth();
@@ -106,6 +109,9 @@ public:
     TSUNIT_TEST_BEGIN(UStringTest);
     TSUNIT_TEST(testIsSpace);
     TSUNIT_TEST(testUTF);
+    TSUNIT_TEST(testUTFFastPath);
+    TSUNIT_TEST(testUTFAppend);
+    TSUNIT_TEST(testUTFLargeText);
     TSUNIT_TEST(testDiacritical);
     TSUNIT_TEST(testSurrogate);
     TSUNIT_TEST(testWidth);
@@ -319,6 +325,105 @@ void UStringTest::testUTF()
     TSUNIT_EQUAL(s1, s4);
 }
 
+void UStringTest::testUTFFastPath()
+{
+    // Long runs of ASCII characters use the block conversion, move one or two
+    // non-ASCII characters at all positions to check the transitions.
+    static const char ascii[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZ abcdefghijklmnopqrstuvwxyz 0123456789";
+    const size_t len = sizeof(ascii) - 1;
+
+    for (size_t pos = 0; pos < len; ++pos) {
+
+        // One non-ASCII character (e acute) at position pos.
+        std::string utf8(ascii);
+        ts::UString utf16(ts::UString::FromUTF8(ascii));
+        TSUNIT_EQUAL(len, utf16.size());
+        TSUNIT_ASSERT(utf16.toUTF8() == utf8);
+
+        utf8.replace(pos, 1, "\xC3\xA9");
+        utf16[pos] = ts::LATIN_SMALL_LETTER_E_WITH_ACUTE;
+        TSUNIT_EQUAL(utf16, ts::UString::FromUTF8(utf8));
+        TSUNIT_ASSERT(utf16.toUTF8() == utf8);
+
+        // Add a surrogate pair (MATH_A1, MATH_A2) 17 characters later.
+        const size_t pos2 = pos + 17;
+        if (pos2 < len) {
+            utf8.replace(pos2 + 1, 1, "\xF0\xAD\x94\xB8");
+            utf16.replace(pos2, 1, {MATH_A1, MATH_A2});
+            TSUNIT_EQUAL(utf16, ts::UString::FromUTF8(utf8));
+            TSUNIT_ASSERT(utf16.toUTF8() == utf8);
+        }
+    }
+
+    // Conversion in a limited output buffer shall stop at the exact end of the buffer.
+    const ts::UString in(ts::UString::FromUTF8(ascii));
+    for (size_t size = 0; size < 40; ++size) {
+        char out[40];
+        const ts::UChar* inStart = in.data();
+        char* outStart = out;
+        ts::UString::ConvertUTF16ToUTF8(inStart, inStart + in.size(), outStart, out + size);
+        TSUNIT_EQUAL(size, size_t(outStart - out));
+        TSUNIT_EQUAL(size, size_t(inStart - in.data()));
+        TSUNIT_ASSERT(::memcmp(out, ascii, size) == 0);
+
+        ts::UChar out16[40];
+        const char* inStart8 = ascii;
+        ts::UChar* outStart16 = out16;
+        ts::UString::ConvertUTF8ToUTF16(inStart8, ascii + len, outStart16, out16 + size);
+        TSUNIT_EQUAL(size, size_t(outStart16 - out16));
+        TSUNIT_EQUAL(size, size_t(inStart8 - ascii));
+        TSUNIT_ASSERT(in.substr(0, size) == ts::UString(out16, size));
+    }
+}
+
+void UStringTest::testUTFAppend()
+{
+    std::string utf8("abc");
+    ts::UString(u"def").appendUTF8(utf8);
+    TSUNIT_ASSERT(utf8 == "abcdef");
+    ts::UString({u'x', ts::LATIN_SMALL_LETTER_E_WITH_ACUTE, MATH_A1, MATH_A2}).appendUTF8(utf8);
+    TSUNIT_ASSERT(utf8 == "abcdefx\xC3\xA9\xF0\xAD\x94\xB8");
+    ts::UString().appendUTF8(utf8);
+    TSUNIT_ASSERT(utf8 == "abcdefx\xC3\xA9\xF0\xAD\x94\xB8");
+
+    ts::UString str(u"abc");
+    str.appendFromUTF8("def");
+    TSUNIT_EQUAL(u"abcdef", str);
+    str.appendFromUTF8(std::string("x\xC3\xA9\xF0\xAD\x94\xB8"));
+    TSUNIT_EQUAL(ts::UString({u'a', u'b', u'c', u'd', u'e', u'f', u'x', ts::LATIN_SMALL_LETTER_E_WITH_ACUTE, MATH_A1, MATH_A2}), str);
+    str.appendFromUTF8(nullptr);
+    TSUNIT_EQUAL(10, str.size());
+    str.appendFromUTF8("abcdef", 3);
+    TSUNIT_EQUAL(13, str.size());
+    TSUNIT_ASSERT(str.endWith(u"abc"));
+
+    str.assignFromUTF8("xyz");
+    TSUNIT_EQUAL(u"xyz", str);
+}
+
+void UStringTest::testUTFLargeText()
+{
+    // Typical EPG text: mostly ASCII with a few accented characters.
+    // The conversions reuse the output strings from one iteration to the next.
+    ts::UString text;
+    for (size_t i = 0; i < 10000; ++i) {
+        text.append(u"Le journal de 20 heures. Pr");
+        text.push_back(ts::LATIN_SMALL_LETTER_E_WITH_ACUTE);
+        text.append(u"sentation des informations nationales et internationales.\n");
+    }
+    const std::string utf8(text.toUTF8());
+    TSUNIT_EQUAL(text.size() + 10000, utf8.size());
+
+    std::string out8("previous content");
+    ts::UString out16(u"previous content");
+    for (size_t i = 0; i < 3; ++i) {
+        text.toUTF8(out8);
+        out16.assignFromUTF8(utf8);
+        TSUNIT_ASSERT(out8 == utf8);
+        TSUNIT_EQUAL(text, out16);
+    }
+}
+
 void UStringTest::testDiacritical()
 {
     TSUNIT_ASSERT(!ts::IsCombiningDiacritical(ts::UChar('a')));